@@ -5,6 +5,11 @@
 #include "cheats.h"
 #include "cic.h"
 #include "reboot.h"
+#include "utils/trace.h"
+
+#define SP_DMA_IMEM                 (0x1000)
+#define SP_DMA_ALIGNMENT            (8)
+#define IPL3_DMEM_OFFSET            (16 * sizeof(uint32_t))
 
 /**
  * Selects the base IO address for the configured boot device.
@@ -20,11 +25,19 @@ static io32_t *boot_get_device_base (boot_params_t *params) {
     return device_base_address;
 }
 
+static uint8_t ipl3[IPL3_LENGTH] __attribute__((aligned(16)));
+
+/**
+ * Reads the IPL3 of the boot device and detects its CIC type.
+ *
+ * The IPL3 is kept in RDRAM, so it can be copied into SP DMEM later without reading the boot device again.
+ *
+ * @param params Boot parameters whose `device_type` determines the boot device.
+ * @returns The detected CIC type.
+ */
 static cic_type_t boot_detect_cic (boot_params_t *params) {
     io32_t *base = boot_get_device_base(params);
 
-    uint8_t ipl3[IPL3_LENGTH] __attribute__((aligned(8)));
-
     data_cache_hit_writeback_invalidate(ipl3, sizeof(ipl3));
     dma_read_raw_async(ipl3, (uint32_t) (&base[16]), sizeof(ipl3));
     dma_wait();
@@ -32,6 +45,27 @@ static cic_type_t boot_detect_cic (boot_params_t *params) {
     return cic_detect(ipl3);
 }
 
+/**
+ * Queues an SP DMA transfer from RDRAM into SP memory.
+ *
+ * The SP DMA unit holds one pending transfer besides the active one, so only a full queue is waited for.
+ *
+ * @param sp_address Destination offset in SP memory, IMEM starts at `SP_DMA_IMEM`.
+ * @param source Source buffer in RDRAM, aligned to 8 bytes.
+ * @param length Number of bytes to transfer, rounded up to a multiple of 8.
+ */
+static void boot_sp_dma_write (uint32_t sp_address, void *source, size_t length) {
+    length = ((length + (SP_DMA_ALIGNMENT - 1)) & ~(SP_DMA_ALIGNMENT - 1));
+
+    data_cache_hit_writeback(source, length);
+
+    while (cpu_io_read(&SP->SR) & SP_SR_DMA_FULL);
+
+    cpu_io_write(&SP->PADDR, sp_address);
+    cpu_io_write(&SP->MADDR, PhysicalAddr(source));
+    cpu_io_write(&SP->RD_LEN, length - 1);
+}
+
 /**
  * Prepare system hardware, load reboot code and IPL3, install cheats, and transfer control to the reboot routine using the provided boot parameters.
  *
@@ -40,7 +74,10 @@ static cic_type_t boot_detect_cic (boot_params_t *params) {
  * @param params Boot configuration and state. Fields read include device_type, tv_type, detect_cic_seed, and cheat_list. On return this function may modify params->tv_type (when passthrough normalization is applied) and params->cic_seed (when detect_cic_seed is true).
  */
 void boot (boot_params_t *params) {
+    // NOTE: Boot phases are only logged, the boot history is stored before the menu hands over control
+    trace_phase_begin("CIC detection");
     cic_type_t cic_type = boot_detect_cic(params);
+    trace_phase_end();
 
     if (params->detect_cic_seed) {
         params->cic_seed = cic_get_seed(cic_type);
@@ -63,7 +100,9 @@ void boot (boot_params_t *params) {
         }
     }
 
+    trace_phase_begin("RSP halt wait");
     while (!(cpu_io_read(&SP->SR) & SP_SR_HALT));
+    trace_phase_end();
 
     cpu_io_write(&SP->SR,
         SP_SR_CLR_SIG7 |
@@ -83,8 +122,6 @@ void boot (boot_params_t *params) {
     cpu_io_write(&SP->SEMAPHORE, 0);
     cpu_io_write(&SP->PC, 0);
 
-    while (cpu_io_read(&SP->DMA_BUSY));
-
     cpu_io_write(&PI->SR, PI_SR_CLR_INTR | PI_SR_RESET);
     while ((cpu_io_read(&VI->CURR_LINE) & ~(VI_CURR_LINE_FIELD)) != 0);
     cpu_io_write(&VI->V_INTR, 0x3FF);
@@ -93,15 +130,12 @@ void boot (boot_params_t *params) {
     cpu_io_write(&AI->MADDR, 0);
     cpu_io_write(&AI->LEN, 0);
 
-    while (cpu_io_read(&SP->SR) & SP_SR_DMA_BUSY);
+    trace_phase_begin("SP memory DMA");
 
-    uint32_t *reboot_src = &reboot_start;
-    io32_t *reboot_dst = SP_MEM->IMEM;
-    size_t reboot_instructions = (size_t) (&reboot_size) / sizeof(uint32_t);
+    // NOTE: Any RSP DMA started before the halt has to finish before new transfers are queued
+    while (cpu_io_read(&SP->SR) & SP_SR_DMA_BUSY);
 
-    for (unsigned int i = 0; i < reboot_instructions; i++) {
-        cpu_io_write(&reboot_dst[i], reboot_src[i]);
-    }
+    boot_sp_dma_write(SP_DMA_IMEM, &reboot_start, (size_t) (&reboot_size));
 
     cpu_io_write(&PI->DOM[0].LAT, 0xFF);
     cpu_io_write(&PI->DOM[0].PWD, 0xFF);
@@ -120,12 +154,12 @@ void boot (boot_params_t *params) {
         while (cpu_io_read(&DPC->SR) & DPC_SR_PIPE_BUSY);
     }
 
-    io32_t *ipl3_src = base;
-    io32_t *ipl3_dst = SP_MEM->DMEM;
+    // NOTE: The IPL3 read during the CIC detection is reused, the PI timing changes above don't affect its contents
+    boot_sp_dma_write(IPL3_DMEM_OFFSET, ipl3, sizeof(ipl3));
 
-    for (int i = 16; i < 1024; i++) {
-        cpu_io_write(&ipl3_dst[i], io_read((uint32_t) (&ipl3_src[i])));
-    }
+    while (cpu_io_read(&SP->SR) & SP_SR_DMA_BUSY);
+
+    trace_phase_end();
 
     bool cheats_installed = cheats_install(cic_type, params->cheat_list);
 
@@ -199,6 +199,87 @@ static void cheats_update_cache (volatile void *start, volatile void *end) {
     inst_cache_hit_invalidate(start, (end - start));
 }
 
+/** @brief Cheat engine code generator state structure */
+typedef struct {
+    io32_t *p; /**< Next instruction */
+    bool base_valid; /**< K0 holds the address base */
+    uint16_t base; /**< Address base held in K0 */
+    bool value_valid; /**< K1 holds the value */
+    uint16_t value; /**< Value held in K1 */
+} cheats_codegen_t;
+
+/**
+ * @brief Forget the register contents, used where the code paths merge.
+ *
+ * @param gen Pointer to the code generator state.
+ */
+static void cheats_codegen_invalidate (cheats_codegen_t *gen) {
+    gen->base_valid = false;
+    gen->value_valid = false;
+}
+
+/**
+ * @brief Emit a store of a constant value.
+ *
+ * The address base and the value are only loaded when the registers don't hold them already,
+ * stores of zero use the zero register.
+ *
+ * @param gen Pointer to the code generator state.
+ * @param c Pointer to the write cheat.
+ */
+static void cheats_codegen_write (cheats_codegen_t *gen, cheat_t *c) {
+    int value_reg = REG_K1;
+
+    if (!gen->base_valid || (gen->base != A_BASE(c->address))) {
+        *gen->p++ = I_LUI(REG_K0, A_BASE(c->address));
+        gen->base_valid = true;
+        gen->base = A_BASE(c->address);
+    }
+
+    if (c->value == 0) {
+        value_reg = REG_ZERO;
+    } else if (!gen->value_valid || (gen->value != c->value)) {
+        *gen->p++ = I_ORI(REG_K1, REG_ZERO, c->value);
+        gen->value_valid = true;
+        gen->value = c->value;
+    }
+
+    *gen->p++ = IS_WIDTH_16(c->type) ? I_SH(value_reg, A_OFFSET(c->address), REG_K0)
+                                     : I_SB(value_reg, A_OFFSET(c->address), REG_K0);
+}
+
+/**
+ * @brief Emit a store executed only when the condition is met.
+ *
+ * @param gen Pointer to the code generator state.
+ * @param condition Pointer to the conditional cheat.
+ * @param c Pointer to the write cheat.
+ */
+static void cheats_codegen_conditional_write (cheats_codegen_t *gen, cheat_t *condition, cheat_t *c) {
+    uint16_t compare = condition->value & (IS_WIDTH_16(condition->type) ? 0xFFFF : 0xFF);
+    int compare_reg = REG_K1;
+
+    *gen->p++ = I_LUI(REG_K0, A_BASE(condition->address));
+    *gen->p++ = IS_WIDTH_16(condition->type) ? I_LHU(REG_K0, A_OFFSET(condition->address), REG_K0)
+                                             : I_LBU(REG_K0, A_OFFSET(condition->address), REG_K0);
+    if (compare == 0) {
+        compare_reg = REG_ZERO;
+    } else {
+        *gen->p++ = I_ORI(REG_K1, REG_ZERO, compare);
+    }
+
+    io32_t *branch = gen->p++;
+
+    // NOTE: K0 holds the loaded value, the write starts with the base load which is safe to execute in the delay slot
+    cheats_codegen_invalidate(gen);
+    cheats_codegen_write(gen, c);
+
+    int16_t skip = (int16_t) (gen->p - (branch + 1));
+    *branch = IS_CONDITION_NOT_EQUAL(condition->type) ? I_BEQ(REG_K0, compare_reg, skip) : I_BNE(REG_K0, compare_reg, skip);
+
+    cheats_codegen_invalidate(gen);
+}
+
 /**
  * @brief Install the cheat engine.
  * 
@@ -271,6 +352,9 @@ bool cheats_install (cic_type_t cic_type, uint32_t *cheat_list) {
 
     cheat_entry_t cheat;
 
+    cheats_codegen_t gen = { .p = engine_p };
+    cheats_codegen_invalidate(&gen);
+
     while (cheats_get_next(&cheat_list, &cheat)) {
         cheat_t *c = &cheat.main;
 
@@ -320,10 +404,7 @@ bool cheats_install (cic_type_t cic_type, uint32_t *cheat_list) {
                     c = &cheat.sub;
 
                     for (int i = 0; i < count; i++) {
-                        *engine_p++ = I_LUI(REG_K0, A_BASE(c->address));
-                        *engine_p++ = I_ORI(REG_K1, REG_ZERO, c->value);
-                        *engine_p++ = IS_WIDTH_16(c->type) ? I_SH(REG_K1, A_OFFSET(c->address), REG_K0)
-                                                        : I_SB(REG_K1, A_OFFSET(c->address), REG_K0);
+                        cheats_codegen_write(&gen, c);
 
                         c->address += step;
                         c->value += increment;
@@ -337,13 +418,9 @@ bool cheats_install (cic_type_t cic_type, uint32_t *cheat_list) {
                         continue;
                     }
 
-                    *engine_p++ = I_LUI(REG_K0, A_BASE(c->address));
-                    *engine_p++ = IS_WIDTH_16(c->type) ? I_LHU(REG_K0, A_OFFSET(c->address), REG_K0)
-                                                    : I_LBU(REG_K0, A_OFFSET(c->address), REG_K0);
-                    *engine_p++ = I_ORI(REG_K1, REG_ZERO, c->value & (IS_WIDTH_16(c->type) ? 0xFFFF : 0xFF));
-                    *engine_p++ = IS_CONDITION_NOT_EQUAL(c->type) ? I_BEQ(REG_K0, REG_K1, 3) : I_BNE(REG_K0, REG_K1, 3);
+                    cheats_codegen_conditional_write(&gen, c, &cheat.sub);
 
-                    c = &cheat.sub;
+                    continue;
                 }
 
                 if (IS_TYPE_WRITE(c->type)) {
@@ -351,10 +428,7 @@ bool cheats_install (cic_type_t cic_type, uint32_t *cheat_list) {
                         continue;
                     }
 
-                    *engine_p++ = I_LUI(REG_K0, A_BASE(c->address));
-                    *engine_p++ = I_ORI(REG_K1, REG_ZERO, c->value);
-                    *engine_p++ = IS_WIDTH_16(c->type) ? I_SH(REG_K1, A_OFFSET(c->address), REG_K0)
-                                                    : I_SB(REG_K1, A_OFFSET(c->address), REG_K0);
+                    cheats_codegen_write(&gen, c);
 
                     continue;
                 }
@@ -362,6 +436,8 @@ bool cheats_install (cic_type_t cic_type, uint32_t *cheat_list) {
         }
     }
 
+    engine_p = gen.p;
+
     *engine_p++ = I_J(RELOCATED_EXCEPTION_HANDLER_ADDRESS);
     *engine_p++ = I_NOP();
 
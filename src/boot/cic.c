@@ -4,8 +4,64 @@
  * @ingroup boot
  */
 
+#include <stdbool.h>
+
 #include "cic.h"
 
+#define CIC_FINGERPRINT_CACHE_SIZE  (8)
+
+/** @brief Detected IPL3 fingerprint structure. */
+typedef struct {
+    bool valid;         /**< Entry contains a detection result */
+    uint32_t crc;       /**< CRC32 of the IPL3 */
+    cic_type_t type;    /**< Detected CIC type */
+} cic_fingerprint_t;
+
+/** @brief Known IPL3 checksum structure. */
+typedef struct {
+    uint8_t seed;       /**< Seed used to calculate the checksum */
+    uint64_t checksum;  /**< Expected checksum */
+    cic_type_t type;    /**< CIC type */
+} cic_checksum_t;
+
+// NOTE: Entries using the same seed must be kept next to each other
+static const cic_checksum_t cic_checksums[] = {
+    { 0x3F, 0x45CC73EE317AULL, CIC_6101 },  // 6101
+    { 0x3F, 0x44160EC5D9AFULL, CIC_7102 },  // 7102
+    { 0x3F, 0xA536C0F1D859ULL, CIC_x102 },  // 6102 / 7101
+    { 0x78, 0x586FD4709867ULL, CIC_x103 },  // 6103 / 7103
+    { 0x85, 0x2BBAD4E6EB74ULL, CIC_x106 },  // 6106 / 7106
+    { 0x91, 0x8618A45BC2D3ULL, CIC_x105 },  // 6105 / 7105
+    { 0xDD, 0x6EE8D9E84970ULL, CIC_8401 },  // NDXJ0
+    { 0xDD, 0x6C216495C8B9ULL, CIC_8301 },  // NDDJ0
+    { 0xDD, 0xE27F43BA93ACULL, CIC_8302 },  // NDDJ1
+    { 0xDD, 0x32B294E2AB90ULL, CIC_8303 },  // NDDJ2
+    { 0xDD, 0x083C6C77E0B1ULL, CIC_5167 },  // 64DD Cartridge conversion
+    { 0xDE, 0x05BA2EF0A5F1ULL, CIC_8501 },  // NDDE0
+};
+#define CIC_CHECKSUMS_COUNT     (sizeof(cic_checksums) / sizeof(cic_checksums[0]))
+
+/** @brief Known IPL3 fingerprint structure. */
+typedef struct {
+    uint32_t crc;       /**< CRC32 of the IPL3 */
+    cic_type_t type;    /**< CIC type */
+} cic_known_fingerprint_t;
+
+static const cic_known_fingerprint_t cic_fingerprints[] = {
+    { 0x90BB6CB5, CIC_x102 },   // 6102 / 7101
+    { 0x6170A4A1, CIC_6101 },   // 6101
+    { 0x009E9EA3, CIC_7102 },   // 7102
+    { 0x0B050EE0, CIC_x103 },   // 6103 / 7103
+    { 0x98BC2C86, CIC_x105 },   // 6105 / 7105
+    { 0xACC8580A, CIC_x106 },   // 6106 / 7106
+};
+#define CIC_FINGERPRINTS_COUNT  (sizeof(cic_fingerprints) / sizeof(cic_fingerprints[0]))
+
+static uint32_t crc_table[256];
+static bool crc_table_ready = false;
+static cic_fingerprint_t fingerprint_cache[CIC_FINGERPRINT_CACHE_SIZE];
+static int fingerprint_cache_next = 0;
+
 /**
  * @brief Get a 32-bit value from a byte array at the specified index.
  * 
@@ -160,38 +216,108 @@ static uint64_t cic_calculate_ipl3_checksum (uint8_t *ipl3, uint8_t seed) {
 }
 
 /**
- * @brief Detect the CIC type based on the IPL3 data.
+ * @brief Calculate the CRC32 fingerprint of the IPL3.
  * 
  * @param ipl3 Pointer to the IPL3 data.
- * @return cic_type_t The detected CIC type.
+ * @return uint32_t The calculated CRC32.
  */
-cic_type_t cic_detect (uint8_t *ipl3) {
-    switch (cic_calculate_ipl3_checksum(ipl3, 0x3F)) {
-        case 0x45CC73EE317AULL: return CIC_6101;        // 6101
-        case 0x44160EC5D9AFULL: return CIC_7102;        // 7102
-        case 0xA536C0F1D859ULL: return CIC_x102;        // 6102 / 7101
+static uint32_t cic_calculate_ipl3_fingerprint (uint8_t *ipl3) {
+    if (!crc_table_ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+            }
+            crc_table[i] = crc;
+        }
+        crc_table_ready = true;
+    }
+
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (int i = 0; i < IPL3_LENGTH; i++) {
+        crc = crc_table[(crc ^ ipl3[i]) & 0xFF] ^ (crc >> 8);
     }
-    switch (cic_calculate_ipl3_checksum(ipl3, 0x78)) {
-        case 0x586FD4709867ULL: return CIC_x103;        // 6103 / 7103
+
+    return ~crc;
+}
+
+/**
+ * @brief Check if the IPL3 checksum matches the one expected for the CIC type.
+ * 
+ * @param ipl3 Pointer to the IPL3 data.
+ * @param type The expected CIC type.
+ * @return true if the checksum matches, false otherwise.
+ */
+static bool cic_verify (uint8_t *ipl3, cic_type_t type) {
+    uint64_t checksum = cic_calculate_ipl3_checksum(ipl3, cic_get_seed(type));
+
+    for (int i = 0; i < CIC_CHECKSUMS_COUNT; i++) {
+        if ((cic_checksums[i].type == type) && (cic_checksums[i].checksum == checksum)) {
+            return true;
+        }
     }
-    switch (cic_calculate_ipl3_checksum(ipl3, 0x85)) {
-        case 0x2BBAD4E6EB74ULL: return CIC_x106;        // 6106 / 7106
+
+    return false;
+}
+
+/**
+ * @brief Detect the CIC type by trying the checksum of every known seed.
+ * 
+ * @param ipl3 Pointer to the IPL3 data.
+ * @return cic_type_t The detected CIC type.
+ */
+static cic_type_t cic_detect_by_checksum (uint8_t *ipl3) {
+    for (int i = 0; i < CIC_CHECKSUMS_COUNT; i++) {
+        if ((i > 0) && (cic_checksums[i].seed == cic_checksums[i - 1].seed)) {
+            continue;
+        }
+
+        uint64_t checksum = cic_calculate_ipl3_checksum(ipl3, cic_checksums[i].seed);
+
+        for (int j = i; (j < CIC_CHECKSUMS_COUNT) && (cic_checksums[j].seed == cic_checksums[i].seed); j++) {
+            if (cic_checksums[j].checksum == checksum) {
+                return cic_checksums[j].type;
+            }
+        }
     }
-    switch (cic_calculate_ipl3_checksum(ipl3, 0x91)) {
-        case 0x8618A45BC2D3ULL: return CIC_x105;        // 6105 / 7105
+
+    return CIC_UNKNOWN;
+}
+
+/**
+ * @brief Detect the CIC type based on the IPL3 data.
+ * 
+ * @param ipl3 Pointer to the IPL3 data.
+ * @return cic_type_t The detected CIC type.
+ */
+cic_type_t cic_detect (uint8_t *ipl3) {
+    uint32_t crc = cic_calculate_ipl3_fingerprint(ipl3);
+
+    for (int i = 0; i < CIC_FINGERPRINT_CACHE_SIZE; i++) {
+        if (fingerprint_cache[i].valid && (fingerprint_cache[i].crc == crc)) {
+            return fingerprint_cache[i].type;
+        }
     }
-    switch (cic_calculate_ipl3_checksum(ipl3, 0xDD)) {
-        case 0x6EE8D9E84970ULL: return CIC_8401;        // NDXJ0
-        case 0x6C216495C8B9ULL: return CIC_8301;        // NDDJ0
-        case 0xE27F43BA93ACULL: return CIC_8302;        // NDDJ1
-        case 0x32B294E2AB90ULL: return CIC_8303;        // NDDJ2
-        case 0x083C6C77E0B1ULL: return CIC_5167;        // 64DD Cartridge conversion
+
+    cic_type_t type = CIC_UNKNOWN;
+
+    // NOTE: A known fingerprint only selects the seed to try, the checksum still has to match
+    for (int i = 0; i < CIC_FINGERPRINTS_COUNT; i++) {
+        if ((cic_fingerprints[i].crc == crc) && cic_verify(ipl3, cic_fingerprints[i].type)) {
+            type = cic_fingerprints[i].type;
+            break;
+        }
     }
-    switch (cic_calculate_ipl3_checksum(ipl3, 0xDE)) {
-        case 0x05BA2EF0A5F1ULL: return CIC_8501;        // NDDE0
+
+    if (type == CIC_UNKNOWN) {
+        type = cic_detect_by_checksum(ipl3);
     }
 
-    return CIC_UNKNOWN;
+    fingerprint_cache[fingerprint_cache_next] = (cic_fingerprint_t) { .valid = true, .crc = crc, .type = type };
+    fingerprint_cache_next = ((fingerprint_cache_next + 1) % CIC_FINGERPRINT_CACHE_SIZE);
+
+    return type;
 }
 
 /**
@@ -7,8 +7,10 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <fatfs/ff.h>
+#include <libcart/cart.h>
 #include <libdragon.h>
 
 #include "utils/fs.h"
@@ -49,6 +51,11 @@ static flashcart_err_t d64_init (void) {
         return FLASHCART_ERR_OUTDATED;
     }
 
+    // NOTE: Every supported firmware can swap the ROM on load
+    if (d64_ll_enable_byteswap_on_load(false)) {
+        return FLASHCART_ERR_INT;
+    }
+
     if (d64_ll_enable_save_writeback(false)) {
         return FLASHCART_ERR_INT;
     }
@@ -98,6 +105,7 @@ static bool d64_has_feature (flashcart_features_t feature) {
         case FLASHCART_FEATURE_AUTO_REGION: return true;
         case FLASHCART_FEATURE_SAVE_WRITEBACK: return true;
         case FLASHCART_FEATURE_ROM_REBOOT_FAST: return true;
+        case FLASHCART_FEATURE_BYTESWAP_ON_LOAD: return true;
         default: return false;
     }
 }
@@ -128,52 +136,68 @@ static flashcart_firmware_version_t d64_get_firmware_version (void) {
 }
 
 /**
- * @brief Load a ROM into the 64drive.
+ * @brief Load a byte swapped ROM with the cart swapping the loaded sectors.
+ * 
+ * The byte swap also applies to the single sectors FatFs reads, so the FAT chain is
+ * walked before the swap is enabled and the sectors are then read directly into the SDRAM.
  * 
  * @param rom_path Path to the ROM file.
  * @param progress Progress callback function.
  * @return flashcart_err_t Error code.
  */
-static flashcart_err_t d64_load_rom (char *rom_path, flashcart_progress_callback_t *progress) {
-    FIL fil;
-    UINT br;
+static flashcart_err_t d64_load_rom_byteswapped (char *rom_path, flashcart_progress_callback_t *progress) {
+    fatfs_extent_t *extents;
+    uint32_t count;
+    FILINFO info;
 
-    if (f_open(&fil, strip_fs_prefix(rom_path), FA_READ) != FR_OK) {
+    if (f_stat(strip_fs_prefix(rom_path), &info) != FR_OK) {
         return FLASHCART_ERR_LOAD;
     }
 
-    fatfs_fix_file_size(&fil);
-
-    size_t rom_size = f_size(&fil);
+    if (info.fsize > MiB(64)) {
+        return FLASHCART_ERR_LOAD;
+    }
 
-    if (rom_size > MiB(64)) {
-        f_close(&fil);
+    if (fatfs_get_file_extents(rom_path, &extents, &count, info.fsize / FS_SECTOR_SIZE)) {
         return FLASHCART_ERR_LOAD;
     }
 
-    size_t sdram_size = MiB(64);
+    fatfs_load_begin(FLASHCART_LOAD_CHUNK_SIZE);
 
-    size_t chunk_size = KiB(128);
-    for (unsigned int offset = 0; offset < sdram_size; offset += chunk_size) {
-        size_t block_size = MIN(sdram_size - offset, chunk_size);
-        if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
-            f_close(&fil);
-            return FLASHCART_ERR_LOAD;
-        }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
+    flashcart_err_t err = FLASHCART_ERR_INT;
+
+    if (!d64_ll_enable_byteswap_on_load(true)) {
+        err = fatfs_load_extents(extents, count, (void *) (ROM_ADDRESS), info.fsize, FLASHCART_LOAD_CHUNK_SIZE, progress);
+
+        if (d64_ll_enable_byteswap_on_load(false)) {
+            err = FLASHCART_ERR_INT;
         }
     }
-    if (f_tell(&fil) != rom_size) {
-        f_close(&fil);
-        return FLASHCART_ERR_LOAD;
-    }
 
-    if (f_close(&fil) != FR_OK) {
-        return FLASHCART_ERR_LOAD;
+    fatfs_load_end();
+
+    free(extents);
+
+    return err;
+}
+
+/**
+ * @brief Load a ROM into the 64drive.
+ * 
+ * @param rom_path Path to the ROM file.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+static flashcart_err_t d64_load_rom (char *rom_path, flashcart_progress_callback_t *progress) {
+    // NOTE: The rare ROMs ending with a partial sector are swapped in software, the cart can't swap a partial read
+    if (cart_card_byteswap && ((file_get_size(rom_path) % FS_SECTOR_SIZE) == 0)) {
+        cart_card_byteswap = false;
+        flashcart_err_t err = d64_load_rom_byteswapped(rom_path, progress);
+        cart_card_byteswap = true;
+        return err;
     }
 
-    return FLASHCART_OK;
+    return fatfs_load_file(rom_path, (void *) (ROM_ADDRESS), MiB(64), FLASHCART_LOAD_CHUNK_SIZE, progress);
 }
 
 /**
@@ -335,7 +359,7 @@ static flashcart_err_t d64_set_save_type (flashcart_save_type_t save_type) {
 static flashcart_err_t d64_set_save_writeback (char *save_path) {
     uint32_t sectors[SAVE_WRITEBACK_MAX_SECTORS] __attribute__((aligned(8)));
 
-    if (fatfs_get_file_sectors(save_path, sectors, ADDRESS_TYPE_MEM, SAVE_WRITEBACK_MAX_SECTORS)) {
+    if (fatfs_get_save_sectors(save_path, sectors, SAVE_WRITEBACK_MAX_SECTORS)) {
         return FLASHCART_ERR_LOAD;
     }
 
@@ -131,6 +131,19 @@ bool d64_ll_enable_cartrom_writes (bool enabled) {
     return d64_ll_ci_cmd(enabled ? CMD_ID_ENABLE_CARTROM_WRITES : CMD_ID_DISABLE_CARTROM_WRITES);
 }
 
+/**
+ * @brief Enable or disable the 16-bit byte swap of the data loaded from the SD card to the SDRAM.
+ * 
+ * @param enabled Flag indicating whether to enable the byte swap.
+ * @return true if a timeout occurred, false otherwise.
+ */
+bool d64_ll_enable_byteswap_on_load (bool enabled) {
+    if (d64_ll_ci_wait()) {
+        return true;
+    }
+    return d64_ll_ci_cmd(enabled ? CMD_ID_ENABLE_BYTESWAP_ON_LOAD : CMD_ID_DISABLE_BYTESWAP_ON_LOAD);
+}
+
 /**
  * @brief Enable or disable extended mode on the 64drive.
  * 
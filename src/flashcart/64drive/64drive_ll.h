@@ -129,6 +129,14 @@ bool d64_ll_enable_save_writeback(bool enabled);
  */
 bool d64_ll_enable_cartrom_writes(bool enabled);
 
+/**
+ * @brief Enable or disable the byte swap of the data loaded from the SD card.
+ * 
+ * @param enabled True to enable, false to disable.
+ * @return true if successful, false otherwise.
+ */
+bool d64_ll_enable_byteswap_on_load(bool enabled);
+
 /**
  * @brief Enable or disable extended mode.
  * 
@@ -1,6 +1,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <fatfs/ff.h>
 #include <libdragon.h>
@@ -24,6 +26,22 @@ typedef enum {
 /* ED64 ROM location base address  */
 #define ROM_ADDRESS  (0xB0000000)
 
+#define STATE_PATH          "/menu/cache/ed64_state.data"
+#define STATE_MAGIC         (0x45445631) // "EDV1"
+#define STATE_PATH_LENGTH   (256)
+
+/** @brief Save writeback state, kept on the SD card until the next RESET. */
+typedef struct {
+    uint32_t magic; /**< State magic */
+    flashcart_save_type_t save_type; /**< Save type of the running ROM */
+    bool writeback; /**< The save memory is written back to the save file on RESET */
+    bool reboot_rom; /**< The running ROM is booted again on RESET */
+    char save_path[STATE_PATH_LENGTH]; /**< Path to the save file */
+} ed64_vseries_state_t;
+
+static flashcart_save_type_t current_save_type = FLASHCART_SAVE_TYPE_NONE;
+static bool reboot_rom_pending = false;
+
 static flashcart_firmware_version_t ed64_vseries_get_firmware_version (void) {
     flashcart_firmware_version_t version_info;
     // FIXME: get version from ll
@@ -36,7 +54,170 @@ static flashcart_firmware_version_t ed64_vseries_get_firmware_version (void) {
     return version_info;
 }
 
+static size_t ed64_vseries_save_size (flashcart_save_type_t save_type) {
+    switch (save_type) {
+        case FLASHCART_SAVE_TYPE_EEPROM_4KBIT: return 512;
+        case FLASHCART_SAVE_TYPE_EEPROM_16KBIT: return KiB(2);
+        case FLASHCART_SAVE_TYPE_SRAM_256KBIT: return KiB(32);
+        case FLASHCART_SAVE_TYPE_SRAM_1MBIT:
+        case FLASHCART_SAVE_TYPE_FLASHRAM_1MBIT:
+        case FLASHCART_SAVE_TYPE_FLASHRAM_PKST2: return KiB(128);
+        default: return 0;
+    }
+}
+
+static bool ed64_vseries_is_eeprom (flashcart_save_type_t save_type) {
+    return (save_type == FLASHCART_SAVE_TYPE_EEPROM_4KBIT) || (save_type == FLASHCART_SAVE_TYPE_EEPROM_16KBIT);
+}
+
+static bool ed64_vseries_state_read (ed64_vseries_state_t *state) {
+    FIL fil;
+    UINT br;
+
+    if (f_open(&fil, STATE_PATH, FA_READ) != FR_OK) {
+        return true;
+    }
+
+    bool error = ((f_read(&fil, state, sizeof(ed64_vseries_state_t), &br) != FR_OK) || (br != sizeof(ed64_vseries_state_t)));
+
+    f_close(&fil);
+
+    return error || (state->magic != STATE_MAGIC) || (state->save_type >= __FLASHCART_SAVE_TYPE_END);
+}
+
+static bool ed64_vseries_state_write (ed64_vseries_state_t *state) {
+    FIL fil;
+    UINT bw;
+
+    if (f_open(&fil, STATE_PATH, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return true;
+    }
+
+    bool error = ((f_write(&fil, state, sizeof(ed64_vseries_state_t), &bw) != FR_OK) || (bw != sizeof(ed64_vseries_state_t)));
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Configure the save memory of the cart, without touching the writeback state.
+ * 
+ * @param save_type The save type.
+ * @return flashcart_err_t Error code.
+ */
+static flashcart_err_t ed64_vseries_apply_save_type (flashcart_save_type_t save_type) {
+    ed64_vseries_save_type_t type;
+
+    switch (save_type) {
+        case FLASHCART_SAVE_TYPE_NONE:
+            type = ED64_SAVE_TYPE_NONE;
+            break;
+        case FLASHCART_SAVE_TYPE_EEPROM_4KBIT:
+            type = ED64_SAVE_TYPE_EEPROM_4KBIT;
+            break;
+        case FLASHCART_SAVE_TYPE_EEPROM_16KBIT:
+            type = ED64_SAVE_TYPE_EEPROM_16KBIT;
+            break;
+        case FLASHCART_SAVE_TYPE_SRAM_256KBIT:
+            type = ED64_SAVE_TYPE_SRAM_256KBIT;
+            break;
+        case FLASHCART_SAVE_TYPE_SRAM_1MBIT:
+            type = ED64_SAVE_TYPE_SRAM_1MBIT;
+            break;
+        case FLASHCART_SAVE_TYPE_FLASHRAM_1MBIT:
+        case FLASHCART_SAVE_TYPE_FLASHRAM_PKST2:
+            type = ED64_SAVE_TYPE_FLASHRAM_1MBIT;
+            break;
+        default:
+            return FLASHCART_ERR_ARGS;
+    }
+
+    ed64_vseries_ll_set_save_type(type);
+
+    current_save_type = save_type;
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Copy the save memory back to the save file of the ROM that ran before RESET.
+ * 
+ * The cart has no save writeback in hardware, the contents of the save memory survive the RESET
+ * but not a power cycle, so the save is only written back after a warm reset.
+ * 
+ * @param state Pointer to the stored writeback state.
+ * @return flashcart_err_t Error code.
+ */
+static flashcart_err_t ed64_vseries_writeback_save (ed64_vseries_state_t *state) {
+    FIL fil;
+    UINT bw;
+
+    size_t save_size = ed64_vseries_save_size(state->save_type);
+    uint8_t *buffer = malloc(save_size);
+
+    if (buffer == NULL) {
+        return FLASHCART_ERR_INT;
+    }
+
+    if (ed64_vseries_apply_save_type(state->save_type) != FLASHCART_OK) {
+        free(buffer);
+        return FLASHCART_ERR_INT;
+    }
+
+    if (ed64_vseries_is_eeprom(state->save_type)) {
+        eeprom_read_bytes(buffer, 0, save_size);
+    } else {
+        ed64_vseries_ll_read_sram(buffer, 0, save_size);
+    }
+
+    flashcart_err_t err = FLASHCART_OK;
+
+    if (f_open(&fil, strip_fs_prefix(state->save_path), FA_WRITE | FA_OPEN_EXISTING) != FR_OK) {
+        err = FLASHCART_ERR_LOAD;
+    } else {
+        if ((f_write(&fil, buffer, save_size, &bw) != FR_OK) || (bw != save_size)) {
+            err = FLASHCART_ERR_LOAD;
+        }
+        if (f_close(&fil) != FR_OK) {
+            err = FLASHCART_ERR_LOAD;
+        }
+    }
+
+    free(buffer);
+
+    return err;
+}
+
 static flashcart_err_t ed64_vseries_init (void) {
+    ed64_vseries_state_t state;
+
+    ed64_vseries_ll_init();
+
+    current_save_type = FLASHCART_SAVE_TYPE_NONE;
+    reboot_rom_pending = false;
+
+    if (ed64_vseries_state_read(&state)) {
+        return FLASHCART_OK;
+    }
+
+    if (sys_reset_type() != RESET_WARM) {
+        f_unlink(STATE_PATH);
+        return FLASHCART_OK;
+    }
+
+    if (state.writeback && (ed64_vseries_writeback_save(&state) != FLASHCART_OK)) {
+        debugf("ED64: Couldn't write the save back to %s\n", state.save_path);
+    }
+
+    // NOTE: The state is kept while the same ROM keeps running, the save is written back again on the next RESET
+    reboot_rom_pending = state.reboot_rom;
+    if (!reboot_rom_pending) {
+        f_unlink(STATE_PATH);
+    }
+
     return FLASHCART_OK;
 }
 
@@ -55,41 +236,43 @@ static bool ed64_vseries_has_feature (flashcart_features_t feature) {
         case FLASHCART_FEATURE_RTC: return is_model_v3 ? true : false;
         case FLASHCART_FEATURE_USB: return is_model_v3 ? true : false;
         case FLASHCART_FEATURE_AUTO_CIC: return is_model_v3 ? true : false;
+        case FLASHCART_FEATURE_SAVE_WRITEBACK: return true;
+        case FLASHCART_FEATURE_ROM_REBOOT_FAST: return true;
         default: return false;
     }
 }
 
 static flashcart_err_t ed64_vseries_load_rom (char *rom_path, flashcart_progress_callback_t *progress) {
+    return fatfs_load_file_direct(rom_path, (void *) (ROM_ADDRESS), MiB(64), FLASHCART_LOAD_CHUNK_SIZE, progress);
+}
+
+static flashcart_err_t ed64_vseries_load_file (char *file_path, uint32_t rom_offset, uint32_t file_offset) {
     FIL fil;
     UINT br;
 
-    if (f_open(&fil, strip_fs_prefix(rom_path), FA_READ) != FR_OK) {
+    if (f_open(&fil, strip_fs_prefix(file_path), FA_READ) != FR_OK) {
         return FLASHCART_ERR_LOAD;
     }
 
     fatfs_fix_file_size(&fil);
 
-    size_t rom_size = f_size(&fil);
+    size_t file_size = f_size(&fil) - file_offset;
 
-    if (rom_size > MiB(64)) {
+    if (file_size > (MiB(64) - rom_offset)) {
         f_close(&fil);
-        return FLASHCART_ERR_LOAD;
+        return FLASHCART_ERR_ARGS;
     }
 
-    size_t sdram_size = rom_size; // (MiB(64) - KiB(128));
+    if (f_lseek(&fil, file_offset) != FR_OK) {
+        f_close(&fil);
+        return FLASHCART_ERR_LOAD;
+    }
 
-    size_t chunk_size = KiB(128);
-    for (unsigned int offset = 0; offset < sdram_size; offset += chunk_size) {
-        size_t block_size = MIN(sdram_size - offset, chunk_size);
-        if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
-            f_close(&fil);
-            return FLASHCART_ERR_LOAD;
-        }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
-        }
+    if (f_read(&fil, (void *) (ROM_ADDRESS + rom_offset), file_size, &br) != FR_OK) {
+        f_close(&fil);
+        return FLASHCART_ERR_LOAD;
     }
-    if (f_tell(&fil) != sdram_size) {
+    if (br != file_size) {
         f_close(&fil);
         return FLASHCART_ERR_LOAD;
     }
@@ -101,54 +284,100 @@ static flashcart_err_t ed64_vseries_load_rom (char *rom_path, flashcart_progress
     return FLASHCART_OK;
 }
 
-static flashcart_err_t ed64_vseries_load_file (char *file_path, uint32_t rom_offset, uint32_t file_offset) {
+static flashcart_err_t ed64_vseries_load_save (char *save_path) {
     FIL fil;
     UINT br;
 
-    if (f_open(&fil, strip_fs_prefix(file_path), FA_READ) != FR_OK) {
-        return FLASHCART_ERR_LOAD;
-    }
-
-    fatfs_fix_file_size(&fil);
-
-    size_t file_size = f_size(&fil) - file_offset;
+    size_t save_size = ed64_vseries_save_size(current_save_type);
+    uint8_t *buffer = malloc(save_size);
 
-    if (file_size > (MiB(64) - rom_offset)) {
-        f_close(&fil);
-        return FLASHCART_ERR_ARGS;
+    if (buffer == NULL) {
+        return FLASHCART_ERR_INT;
     }
 
-    if (f_lseek(&fil, file_offset) != FR_OK) {
-        f_close(&fil);
+    if (f_open(&fil, strip_fs_prefix(save_path), FA_READ) != FR_OK) {
+        free(buffer);
         return FLASHCART_ERR_LOAD;
     }
 
-    if (f_read(&fil, (void *) (ROM_ADDRESS + rom_offset), file_size, &br) != FR_OK) {
-        f_close(&fil);
-        return FLASHCART_ERR_LOAD;
-    }
-    if (br != file_size) {
+    if ((f_read(&fil, buffer, save_size, &br) != FR_OK) || (br != save_size)) {
         f_close(&fil);
+        free(buffer);
         return FLASHCART_ERR_LOAD;
     }
 
     if (f_close(&fil) != FR_OK) {
+        free(buffer);
         return FLASHCART_ERR_LOAD;
     }
 
+    if (ed64_vseries_is_eeprom(current_save_type)) {
+        eeprom_write_bytes(buffer, 0, save_size);
+    } else {
+        ed64_vseries_ll_write_sram(buffer, 0, save_size);
+    }
+
+    free(buffer);
+
     return FLASHCART_OK;
 }
 
-static flashcart_err_t ed64_vseries_load_save (char *save_path) {
-    // FIXME: the savetype will be none.
+static flashcart_err_t ed64_vseries_set_save_type (flashcart_save_type_t save_type) {
+    // NOTE: The save type is only set while loading a ROM, the writeback state of the previous ROM doesn't apply to it anymore
+    f_unlink(STATE_PATH);
+
+    return ed64_vseries_apply_save_type(save_type);
+}
+
+static flashcart_err_t ed64_vseries_set_save_writeback (char *save_path) {
+    if (strlen(save_path) >= STATE_PATH_LENGTH) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    ed64_vseries_state_t state = {
+        .magic = STATE_MAGIC,
+        .save_type = current_save_type,
+        .writeback = true,
+        .reboot_rom = false,
+    };
+    strcpy(state.save_path, save_path);
+
+    if (ed64_vseries_state_write(&state)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
     return FLASHCART_OK;
 }
 
-static flashcart_err_t ed64_vseries_set_save_type (flashcart_save_type_t save_type) {
-    // FIXME: the savetype will be none.
+static flashcart_err_t ed64_vseries_set_next_boot_mode (flashcart_reboot_mode_t boot_mode) {
+    ed64_vseries_state_t state;
+
+    if (ed64_vseries_state_read(&state)) {
+        state = (ed64_vseries_state_t) {
+            .magic = STATE_MAGIC,
+            .save_type = FLASHCART_SAVE_TYPE_NONE,
+            .writeback = false,
+        };
+    }
+
+    state.reboot_rom = (boot_mode == FLASHCART_REBOOT_MODE_ROM);
+
+    if (!state.writeback && !state.reboot_rom) {
+        f_unlink(STATE_PATH);
+        return FLASHCART_OK;
+    }
+
+    if (ed64_vseries_state_write(&state)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
     return FLASHCART_OK;
 }
 
+static bool ed64_vseries_reboot_rom_pending (void) {
+    return reboot_rom_pending;
+}
+
 static flashcart_t flashcart_ed64_vseries = {
     .init = ed64_vseries_init,
     .deinit = ed64_vseries_deinit,
@@ -160,8 +389,9 @@ static flashcart_t flashcart_ed64_vseries = {
     .load_64dd_ipl = NULL,
     .load_64dd_disk = NULL,
     .set_save_type = ed64_vseries_set_save_type,
-    .set_save_writeback = NULL,
-    .set_next_boot_mode = NULL,
+    .set_save_writeback = ed64_vseries_set_save_writeback,
+    .set_next_boot_mode = ed64_vseries_set_next_boot_mode,
+    .reboot_rom_pending = ed64_vseries_reboot_rom_pending,
 };
 
 
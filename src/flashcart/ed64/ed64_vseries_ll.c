@@ -0,0 +1,153 @@
+/**
+ * @file ed64_vseries_ll.c
+ * @brief Low-level functions for the ED64 V-series
+ * @ingroup flashcart
+ */
+
+#include <libdragon.h>
+
+#include "../flashcart_utils.h"
+#include "ed64_vseries_ll.h"
+
+#define REGS_KEY_VALUE          (0x1234)
+
+#define SAV_EEP_ON              (1 << 0)
+#define SAV_SRM_ON              (1 << 1)
+#define SAV_EEP_SIZE            (1 << 2)
+#define SAV_SRM_SIZE            (1 << 3)
+
+#define PI_BSD_DOM2_LAT         (0x04600024)
+#define PI_BSD_DOM2_PWD         (0x04600028)
+#define PI_BSD_DOM2_PGS         (0x0460002C)
+#define PI_BSD_DOM2_RLS         (0x04600030)
+
+/**
+ * @brief Register IDs for the ED64 V-series.
+ */
+typedef enum {
+    REG_CFG         = 0,
+    REG_STATUS      = 1,
+    REG_DMA_LENGTH  = 2,
+    REG_DMA_ADDRESS = 3,
+    REG_MSG         = 4,
+    REG_DMA_CFG     = 5,
+    REG_SPI         = 6,
+    REG_SPI_CFG     = 7,
+    REG_KEY         = 8,
+    REG_SAV_CFG     = 9,
+    REG_SEC         = 10,
+    REG_VER         = 11,
+} ed64_vseries_reg_id_t;
+
+/** @brief PI domain 2 timings saved while the save memory is accessed. */
+static uint32_t saved_timings[4];
+
+
+static uint32_t ed64_vseries_ll_reg_read (ed64_vseries_reg_id_t reg) {
+    return io_read(ED64_VSERIES_REGS_BASE + (reg * sizeof(uint32_t)));
+}
+
+static void ed64_vseries_ll_reg_write (ed64_vseries_reg_id_t reg, uint32_t value) {
+    io_write(ED64_VSERIES_REGS_BASE + (reg * sizeof(uint32_t)), value);
+}
+
+/**
+ * @brief Switch the PI domain 2 to the timings of the cart save memory.
+ */
+static void ed64_vseries_ll_sram_timings_begin (void) {
+    saved_timings[0] = io_read(PI_BSD_DOM2_LAT);
+    saved_timings[1] = io_read(PI_BSD_DOM2_PWD);
+    saved_timings[2] = io_read(PI_BSD_DOM2_PGS);
+    saved_timings[3] = io_read(PI_BSD_DOM2_RLS);
+
+    io_write(PI_BSD_DOM2_LAT, 0x05);
+    io_write(PI_BSD_DOM2_PWD, 0x0C);
+    io_write(PI_BSD_DOM2_PGS, 0x0D);
+    io_write(PI_BSD_DOM2_RLS, 0x02);
+}
+
+/**
+ * @brief Restore the PI domain 2 timings.
+ */
+static void ed64_vseries_ll_sram_timings_end (void) {
+    io_write(PI_BSD_DOM2_LAT, saved_timings[0]);
+    io_write(PI_BSD_DOM2_PWD, saved_timings[1]);
+    io_write(PI_BSD_DOM2_PGS, saved_timings[2]);
+    io_write(PI_BSD_DOM2_RLS, saved_timings[3]);
+}
+
+
+/**
+ * @brief Unlock the cart registers.
+ */
+void ed64_vseries_ll_init (void) {
+    ed64_vseries_ll_reg_write(REG_KEY, REGS_KEY_VALUE);
+}
+
+/**
+ * @brief Get the FPGA firmware version.
+ *
+ * @return uint16_t Firmware version register value.
+ */
+uint16_t ed64_vseries_ll_get_version (void) {
+    return (uint16_t) (ed64_vseries_ll_reg_read(REG_VER));
+}
+
+/**
+ * @brief Set the save type emulated by the cart.
+ *
+ * @param save_type The save type.
+ */
+void ed64_vseries_ll_set_save_type (ed64_vseries_save_type_t save_type) {
+    uint32_t config = 0;
+
+    switch (save_type) {
+        case ED64_SAVE_TYPE_EEPROM_4KBIT:
+            config = SAV_EEP_ON;
+            break;
+        case ED64_SAVE_TYPE_EEPROM_16KBIT:
+            config = (SAV_EEP_ON | SAV_EEP_SIZE);
+            break;
+        case ED64_SAVE_TYPE_SRAM_256KBIT:
+            config = SAV_SRM_ON;
+            break;
+        case ED64_SAVE_TYPE_SRAM_1MBIT:
+            config = (SAV_SRM_ON | SAV_SRM_SIZE);
+            break;
+        case ED64_SAVE_TYPE_FLASHRAM_1MBIT:
+            // NOTE: FlashRAM is emulated on top of the 1Mbit save memory, with the SRAM interface disabled
+            config = SAV_SRM_SIZE;
+            break;
+        default:
+            config = 0;
+            break;
+    }
+
+    ed64_vseries_ll_reg_write(REG_SAV_CFG, config);
+}
+
+/**
+ * @brief Write data to the SRAM or FlashRAM save memory.
+ *
+ * @param src Source buffer.
+ * @param offset Offset in the save memory.
+ * @param length Length of the data.
+ */
+void ed64_vseries_ll_write_sram (void *src, uint32_t offset, size_t length) {
+    ed64_vseries_ll_sram_timings_begin();
+    pi_dma_write_data(src, (void *) (ED64_VSERIES_SAVE_BASE + offset), length);
+    ed64_vseries_ll_sram_timings_end();
+}
+
+/**
+ * @brief Read data from the SRAM or FlashRAM save memory.
+ *
+ * @param dst Destination buffer.
+ * @param offset Offset in the save memory.
+ * @param length Length of the data.
+ */
+void ed64_vseries_ll_read_sram (void *dst, uint32_t offset, size_t length) {
+    ed64_vseries_ll_sram_timings_begin();
+    pi_dma_read_data((void *) (ED64_VSERIES_SAVE_BASE + offset), dst, length);
+    ed64_vseries_ll_sram_timings_end();
+}
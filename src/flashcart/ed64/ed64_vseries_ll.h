@@ -7,6 +7,67 @@
 #ifndef FLASHCART_ED64_VSERIES_LL_H__
 #define FLASHCART_ED64_VSERIES_LL_H__
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @addtogroup ed64_vseries_ll
+ * @{
+ */
+
+/** @brief Registers Base Address. */
+#define ED64_VSERIES_REGS_BASE      (0x08040000UL)
+
+/** @brief Save memory Base Address. */
+#define ED64_VSERIES_SAVE_BASE      (0x08000000UL)
+
+/** @brief Save Type Enumeration. */
+typedef enum {
+    ED64_SAVE_TYPE_NONE, /**< No save */
+    ED64_SAVE_TYPE_EEPROM_4KBIT, /**< EEPROM 4Kbit */
+    ED64_SAVE_TYPE_EEPROM_16KBIT, /**< EEPROM 16Kbit */
+    ED64_SAVE_TYPE_SRAM_256KBIT, /**< SRAM 256Kbit */
+    ED64_SAVE_TYPE_SRAM_1MBIT, /**< SRAM 1Mbit */
+    ED64_SAVE_TYPE_FLASHRAM_1MBIT, /**< FlashRAM 1Mbit */
+} ed64_vseries_save_type_t;
+
+/**
+ * @brief Unlock the cart registers.
+ */
+void ed64_vseries_ll_init(void);
+
+/**
+ * @brief Get the FPGA firmware version.
+ *
+ * @return uint16_t Firmware version register value.
+ */
+uint16_t ed64_vseries_ll_get_version(void);
+
+/**
+ * @brief Set the save type emulated by the cart.
+ *
+ * @param save_type The save type.
+ */
+void ed64_vseries_ll_set_save_type(ed64_vseries_save_type_t save_type);
+
+/**
+ * @brief Write data to the SRAM or FlashRAM save memory.
+ *
+ * @param src Source buffer, aligned to 8 bytes.
+ * @param offset Offset in the save memory.
+ * @param length Length of the data.
+ */
+void ed64_vseries_ll_write_sram(void *src, uint32_t offset, size_t length);
+
+/**
+ * @brief Read data from the SRAM or FlashRAM save memory.
+ *
+ * @param dst Destination buffer, aligned to 8 bytes.
+ * @param offset Offset in the save memory.
+ * @param length Length of the data.
+ */
+void ed64_vseries_ll_read_sram(void *dst, uint32_t offset, size_t length);
 
 /** @} */ /* ed64_vseries_ll */
 
@@ -64,45 +64,7 @@ static bool ed64_xseries_has_feature (flashcart_features_t feature) {
 }
 
 static flashcart_err_t ed64_xseries_load_rom (char *rom_path, flashcart_progress_callback_t *progress) {
-    FIL fil;
-    UINT br;
-
-    if (f_open(&fil, strip_fs_prefix(rom_path), FA_READ) != FR_OK) {
-        return FLASHCART_ERR_LOAD;
-    }
-
-    fatfs_fix_file_size(&fil);
-
-    size_t rom_size = f_size(&fil);
-
-    if (rom_size > MiB(64)) {
-        f_close(&fil);
-        return FLASHCART_ERR_LOAD;
-    }
-
-    size_t sdram_size = rom_size; // (MiB(64) - KiB(128));
-
-    size_t chunk_size = KiB(128);
-    for (unsigned int offset = 0; offset < sdram_size; offset += chunk_size) {
-        size_t block_size = MIN(sdram_size - offset, chunk_size);
-        if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
-            f_close(&fil);
-            return FLASHCART_ERR_LOAD;
-        }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
-        }
-    }
-    if (f_tell(&fil) != sdram_size) {
-        f_close(&fil);
-        return FLASHCART_ERR_LOAD;
-    }
-
-    if (f_close(&fil) != FR_OK) {
-        return FLASHCART_ERR_LOAD;
-    }
-
-    return FLASHCART_OK;
+    return fatfs_load_file_direct(rom_path, (void *) (ROM_ADDRESS), MiB(64), FLASHCART_LOAD_CHUNK_SIZE, progress);
 }
 
 static flashcart_err_t ed64_xseries_load_file (char *file_path, uint32_t rom_offset, uint32_t file_offset) {
@@ -5,11 +5,16 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fatfs/ff.h>
 #include <libcart/cart.h>
 #include <libdragon.h>
 #include <usb.h>
 
 #include "utils/fs.h"
+#include "utils/hash.h"
+#include "utils/trace.h"
 #include "utils/utils.h"
 #include "flashcart.h"
 #include "flashcart_utils.h"
@@ -17,6 +22,9 @@
 #include "ed64/ed64_xseries.h"
 #include "64drive/64drive.h"
 #include "sc64/sc64.h"
+#ifdef FEATURE_SIMULATION_FLASHCART_ENABLED
+#include "sim/sim.h"
+#endif
 
 /** @brief Save sizes for different flashcart save types. */
 static const size_t SAVE_SIZE[__FLASHCART_SAVE_TYPE_END] = {
@@ -108,8 +116,36 @@ static flashcart_t *flashcart = &((flashcart_t) {
     .set_save_type = dummy_set_save_type,
     .set_save_writeback = NULL,
     .set_next_boot_mode = NULL,
+    .reboot_rom_pending = NULL,
 });
 
+#define RESIDENCY_MAGIC             (0x52455331) // "RES1"
+#define RESIDENCY_ROM_ADDRESS       (0x10000000)
+#define RESIDENCY_MAX_ROM_SIZE      (MiB(64) - KiB(128))
+#define RESIDENCY_PATH_LENGTH       (256)
+#define RESIDENCY_SAMPLES           (32)
+#define RESIDENCY_SAMPLE_SIZE       (512)
+
+#define CONVERT_BLOCK_SIZE          (KiB(16))
+#define ROM_ACCESS_BLOCK_SIZE       (KiB(4))
+
+/** @brief ROM residency record, describes the ROM image left in the cart SDRAM by the last load. */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t timestamp;
+    uint32_t hash;
+    flashcart_byte_order_t byte_order;
+    char path[RESIDENCY_PATH_LENGTH];
+} flashcart_residency_t;
+
+static char *residency_cache_path = NULL;
+static flashcart_rom_extent_t rom_extent;
+static bool rom_extent_valid = false;
+static flashcart_rom_verify_t *rom_verify = NULL;
+static flashcart_rom_verify_t *rom_stream_verify = NULL;
+static bool rom_written = false;
+
 #ifdef NDEBUG
     // HACK: libdragon mocks every debug function if NDEBUG flag is enabled.
     //       Code below reverts that and point to real function instead.
@@ -117,6 +153,178 @@ static flashcart_t *flashcart = &((flashcart_t) {
     bool debug_init_sdfs (const char *prefix, int npart);
 #endif
 
+/**
+ * @brief Get the ROM file size and FAT modification timestamp.
+ * 
+ * @param rom_path Path to the ROM file.
+ * @param size Pointer to store the file size.
+ * @param timestamp Pointer to store the file timestamp.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool rom_file_stat (char *rom_path, uint32_t *size, uint32_t *timestamp) {
+    FILINFO info;
+
+    if (f_stat(strip_fs_prefix(rom_path), &info) != FR_OK) {
+        return true;
+    }
+
+    *size = info.fsize;
+    *timestamp = ((info.fdate << 16) | info.ftime);
+
+    return false;
+}
+
+/**
+ * @brief Calculate a hash of evenly spaced samples of the ROM image currently stored in the cart SDRAM.
+ * 
+ * @param rom_size Size of the ROM image.
+ * @return uint32_t FNV-1a hash of the sampled data.
+ */
+static uint32_t residency_sample_hash (uint32_t rom_size) {
+    uint8_t buffer[RESIDENCY_SAMPLE_SIZE] __attribute__((aligned(8)));
+    uint32_t hash = FNV1A32_INIT;
+    uint32_t stride = (rom_size / RESIDENCY_SAMPLES) & ~(RESIDENCY_SAMPLE_SIZE - 1);
+
+    for (int i = 0; i < RESIDENCY_SAMPLES; i++) {
+        uint32_t offset = (i * stride);
+        size_t length = MIN(rom_size - offset, RESIDENCY_SAMPLE_SIZE);
+        pi_dma_read_data((void *) (RESIDENCY_ROM_ADDRESS + offset), buffer, length);
+        hash = fnv1a32(hash, buffer, length);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Fill the residency record with the ROM file attributes.
+ * 
+ * @param rom_path Path to the ROM file.
+ * @param byte_order Byte order of the ROM file.
+ * @param residency Pointer to the residency record.
+ * @return true if the ROM can't be cached, false otherwise.
+ */
+static bool residency_describe (char *rom_path, flashcart_byte_order_t byte_order, flashcart_residency_t *residency) {
+    uint32_t file_size;
+    uint32_t timestamp;
+
+    if ((residency_cache_path == NULL) || (cart_type == CART_NULL)) {
+        return true;
+    }
+
+    if ((strlen(rom_path) >= RESIDENCY_PATH_LENGTH) || rom_file_stat(rom_path, &file_size, &timestamp)) {
+        return true;
+    }
+
+    uint32_t rom_size = ALIGN(file_size, FS_SECTOR_SIZE);
+
+    if ((rom_size == 0) || (rom_size > RESIDENCY_MAX_ROM_SIZE)) {
+        return true;
+    }
+
+    memset(residency, 0, sizeof(flashcart_residency_t));
+    residency->magic = RESIDENCY_MAGIC;
+    residency->size = rom_size;
+    residency->timestamp = timestamp;
+    residency->byte_order = byte_order;
+    strcpy(residency->path, rom_path);
+
+    return false;
+}
+
+/**
+ * @brief Read the stored residency record.
+ * 
+ * @param stored Pointer to store the residency record.
+ * @return true if there is no valid record, false otherwise.
+ */
+static bool residency_read (flashcart_residency_t *stored) {
+    FIL fil;
+    UINT br;
+
+    if ((residency_cache_path == NULL) || (cart_type == CART_NULL)) {
+        return true;
+    }
+
+    if (f_open(&fil, strip_fs_prefix(residency_cache_path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    bool error = ((f_read(&fil, stored, sizeof(flashcart_residency_t), &br) != FR_OK) || (br != sizeof(flashcart_residency_t)));
+
+    f_close(&fil);
+
+    return error || (stored->magic != RESIDENCY_MAGIC);
+}
+
+/**
+ * @brief Check if the ROM described by the residency record is still stored in the cart SDRAM.
+ * 
+ * @param residency Pointer to the residency record.
+ * @return true if the ROM is resident, false otherwise.
+ */
+static bool residency_check (flashcart_residency_t *residency) {
+    flashcart_residency_t stored;
+
+    if (residency_read(&stored)) {
+        return false;
+    }
+
+    if ((stored.magic != residency->magic) ||
+        (stored.size != residency->size) ||
+        (stored.timestamp != residency->timestamp) ||
+        (stored.byte_order != residency->byte_order) ||
+        (strncmp(stored.path, residency->path, RESIDENCY_PATH_LENGTH) != 0)) {
+        return false;
+    }
+
+    return (residency_sample_hash(residency->size) == stored.hash);
+}
+
+/**
+ * @brief Store the residency record after the ROM was loaded.
+ * 
+ * @param residency Pointer to the residency record.
+ */
+static void residency_store (flashcart_residency_t *residency) {
+    FIL fil;
+    UINT bw;
+
+    residency->hash = residency_sample_hash(residency->size);
+    rom_written = false;
+
+    if (f_open(&fil, strip_fs_prefix(residency_cache_path), FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return;
+    }
+
+    f_write(&fil, residency, sizeof(flashcart_residency_t), &bw);
+
+    f_close(&fil);
+}
+
+/**
+ * @brief Invalidate the residency record, must be called before anything else writes to the cart SDRAM.
+ */
+static void residency_invalidate (void) {
+    if ((residency_cache_path != NULL) && (cart_type != CART_NULL)) {
+        f_unlink(strip_fs_prefix(residency_cache_path));
+    }
+}
+
+/**
+ * @brief Invalidate the residency record only if the resident ROM overlaps the area about to be written.
+ * 
+ * @param offset Offset in the ROM space where the write starts.
+ */
+static void residency_invalidate_from (uint32_t offset) {
+    flashcart_residency_t stored;
+
+    if (!residency_read(&stored) && (offset >= stored.size)) {
+        return;
+    }
+
+    residency_invalidate();
+}
+
 /**
  * @brief Convert a flashcart error code to a human-readable message.
  * 
@@ -133,6 +341,7 @@ char *flashcart_convert_error_message (flashcart_err_t err) {
         case FLASHCART_ERR_LOAD: return "Error during loading data into flashcart";
         case FLASHCART_ERR_INT: return "Internal flashcart error";
         case FLASHCART_ERR_FUNCTION_NOT_SUPPORTED: return "Flashcart doesn't support this function";
+        case FLASHCART_ERR_VERIFY: return "Loaded data doesn't match the expected checksum";
         default: return "Unknown flashcart error";
     }
 }
@@ -176,7 +385,15 @@ flashcart_err_t flashcart_init (const char **storage_prefix) {
             break;
 
         default:        // Probably emulator
+#ifdef FEATURE_SIMULATION_FLASHCART_ENABLED
+            // NOTE: Files are read from the emulated SD card when there's one, from the menu filesystem otherwise
+            if (!sd_card_initialized) {
+                *storage_prefix = "rom:/";
+            }
+            flashcart = sim_get_flashcart();
+#else
             *storage_prefix = "rom:/";
+#endif
             debug_init_isviewer();
             break;
     }
@@ -229,25 +446,204 @@ flashcart_firmware_version_t flashcart_get_firmware_version (void) {
     return flashcart->get_firmware_version();
 }
 
+/**
+ * @brief Convert the little endian ROM image loaded with a 16-bit byte swap to the native byte order.
+ * 
+ * Remaining halfword swap is done on the CPU with 64-bit operations while the PI
+ * transfers the next block, so the conversion runs at nearly the PI DMA speed.
+ * 
+ * @param rom_size Size of the ROM image.
+ */
+static void convert_little_endian_rom (uint32_t rom_size) {
+    static uint64_t buffers[2][CONVERT_BLOCK_SIZE / sizeof(uint64_t)] __attribute__((aligned(16)));
+    uint32_t blocks = ((rom_size + CONVERT_BLOCK_SIZE - 1) / CONVERT_BLOCK_SIZE);
+
+    data_cache_hit_writeback_invalidate(buffers[0], CONVERT_BLOCK_SIZE);
+    dma_read_async(buffers[0], RESIDENCY_ROM_ADDRESS, MIN(rom_size, CONVERT_BLOCK_SIZE));
+    dma_wait();
+
+    for (uint32_t block = 0; block < blocks; block++) {
+        uint64_t *current = buffers[block & 1];
+        uint64_t *next = buffers[(block + 1) & 1];
+        uint32_t offset = (block * CONVERT_BLOCK_SIZE);
+        uint32_t length = MIN(rom_size - offset, CONVERT_BLOCK_SIZE);
+
+        if ((block + 1) < blocks) {
+            uint32_t next_offset = (offset + CONVERT_BLOCK_SIZE);
+            data_cache_hit_writeback_invalidate(next, CONVERT_BLOCK_SIZE);
+            dma_read_async(next, RESIDENCY_ROM_ADDRESS + next_offset, MIN(rom_size - next_offset, CONVERT_BLOCK_SIZE));
+        }
+
+        for (uint32_t i = 0; i < (length / sizeof(uint64_t)); i++) {
+            uint64_t value = current[i];
+            current[i] = (((value & 0x0000FFFF0000FFFFULL) << 16) | ((value >> 16) & 0x0000FFFF0000FFFFULL));
+        }
+
+        data_cache_hit_writeback(current, length);
+        dma_write_raw_async(current, RESIDENCY_ROM_ADDRESS + offset, length);
+    }
+
+    dma_wait();
+}
+
 /**
  * @brief Load a ROM into the flashcart.
  * 
  * @param rom_path Path to the ROM file.
- * @param byte_swap Flag indicating whether to byte swap the ROM.
+ * @param byte_order Byte order of the ROM file.
  * @param progress Progress callback function.
  * @return flashcart_err_t Error code.
  */
-flashcart_err_t flashcart_load_rom (char *rom_path, bool byte_swap, flashcart_progress_callback_t *progress) {
+flashcart_err_t flashcart_load_rom (char *rom_path, flashcart_byte_order_t byte_order, flashcart_progress_callback_t *progress) {
     flashcart_err_t err;
+    uint32_t file_size = 0;
+    uint32_t timestamp;
+    flashcart_rom_verify_t *verify = rom_verify;
+
+    rom_verify = NULL;
 
     if (rom_path == NULL) {
         return FLASHCART_ERR_ARGS;
     }
 
-    cart_card_byteswap = byte_swap;
+    if (byte_order == FLASHCART_BYTE_ORDER_LITTLE_ENDIAN) {
+        if (cart_type == CART_NULL) {
+            return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
+        }
+        if (rom_file_stat(rom_path, &file_size, &timestamp)) {
+            return FLASHCART_ERR_LOAD;
+        }
+        if (ALIGN(file_size, FS_SECTOR_SIZE) > RESIDENCY_MAX_ROM_SIZE) {
+            return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
+        }
+    }
+
+    flashcart_residency_t residency;
+    bool cacheable = !residency_describe(rom_path, byte_order, &residency);
+
+    if (cacheable && residency_check(&residency)) {
+        debugf("Flashcart: ROM is already resident in the cart SDRAM, skipping load\n");
+        rom_extent_valid = false;
+        *fatfs_get_load_stats() = (flashcart_load_stats_t) { 0 };
+        if (progress) {
+            progress(1.0f);
+        }
+        return FLASHCART_OK;
+    }
+
+    residency_invalidate();
+
+    if (rom_extent_valid) {
+        fatfs_set_load_data_size(rom_extent.data_size, rom_extent.fill);
+        rom_extent_valid = false;
+    }
+
+    // NOTE: Little endian ROMs are loaded with the 16-bit swap too, leaving only a halfword swap to do
+    cart_card_byteswap = (byte_order != FLASHCART_BYTE_ORDER_BIG_ENDIAN);
+    if (byte_order != FLASHCART_BYTE_ORDER_LITTLE_ENDIAN) {
+        fatfs_set_load_verify(verify);
+    }
+
+    trace_phase_begin("ROM transfer");
     err = flashcart->load_rom(rom_path, progress);
+    trace_phase_end();
     cart_card_byteswap = false;
 
+    fatfs_set_load_data_size(SIZE_MAX, 0);
+    fatfs_set_load_verify(NULL);
+
+    if ((err == FLASHCART_OK) && verify && verify->done && (verify->computed != verify->expected)) {
+        debugf("Flashcart: ROM checksum mismatch, expected 0x%016llX, computed 0x%016llX\n", verify->expected, verify->computed);
+        err = FLASHCART_ERR_VERIFY;
+    }
+
+    if ((err == FLASHCART_OK) && (byte_order == FLASHCART_BYTE_ORDER_LITTLE_ENDIAN)) {
+        trace_phase_begin("Byte order conversion");
+        convert_little_endian_rom(ALIGN(file_size, FS_SECTOR_SIZE));
+        trace_phase_end();
+    }
+
+    if ((err == FLASHCART_OK) && cacheable) {
+        residency_store(&residency);
+    }
+
+    return err;
+}
+
+/**
+ * @brief Start loading a ROM into the flashcart from data streamed by the caller.
+ * 
+ * @param rom_size Size of the ROM image.
+ * @param byte_order Byte order of the streamed data.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_load_rom_stream_begin (uint32_t rom_size, flashcart_byte_order_t byte_order, flashcart_progress_callback_t *progress) {
+    rom_stream_verify = rom_verify;
+    rom_verify = NULL;
+    rom_extent_valid = false;
+
+    if (rom_size == 0) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    // NOTE: Streamed data is written by the CPU through the PI, so only the memory mapped cart SDRAM can hold it
+    if ((cart_type == CART_NULL) || (rom_size > RESIDENCY_MAX_ROM_SIZE)) {
+        return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
+    }
+
+    residency_invalidate();
+
+    fatfs_set_load_verify(rom_stream_verify);
+
+    trace_phase_begin("ROM transfer");
+    stream_load_begin((void *) (RESIDENCY_ROM_ADDRESS), rom_size, byte_order, progress);
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Append data to the ROM streamed into the flashcart.
+ * 
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_load_rom_stream_write (const void *data, size_t length) {
+    return stream_load_write(data, length);
+}
+
+/**
+ * @brief Append data read from a file to the ROM streamed into the flashcart.
+ * 
+ * @param fil Pointer to the file object, positioned at the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_load_rom_stream_read (FIL *fil, size_t length) {
+    return stream_load_read(fil, length);
+}
+
+/**
+ * @brief Finish loading the ROM streamed into the flashcart.
+ * 
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_load_rom_stream_end (void) {
+    flashcart_rom_verify_t *verify = rom_stream_verify;
+
+    rom_stream_verify = NULL;
+
+    flashcart_err_t err = stream_load_end();
+    trace_phase_end();
+
+    fatfs_set_load_verify(NULL);
+
+    if ((err == FLASHCART_OK) && verify && verify->done && (verify->computed != verify->expected)) {
+        debugf("Flashcart: ROM checksum mismatch, expected 0x%016llX, computed 0x%016llX\n", verify->expected, verify->computed);
+        err = FLASHCART_ERR_VERIFY;
+    }
+
     return err;
 }
 
@@ -264,9 +660,100 @@ flashcart_err_t flashcart_load_file (char *file_path, uint32_t rom_offset, uint3
         return FLASHCART_ERR_ARGS;
     }
 
+    // NOTE: Emulators stay resident while only the game payload placed after them is replaced
+    residency_invalidate_from(rom_offset);
+
     return flashcart->load_file(file_path, rom_offset, file_offset);
 }
 
+static flashcart_err_t rom_access_check (uint32_t offset, size_t length) {
+    // NOTE: Only the memory mapped cart SDRAM can be accessed by the CPU
+    if (cart_type == CART_NULL) {
+        return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
+    }
+    if ((offset > RESIDENCY_MAX_ROM_SIZE) || (length > (RESIDENCY_MAX_ROM_SIZE - offset))) {
+        return FLASHCART_ERR_ARGS;
+    }
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Read data from the ROM loaded into the flashcart.
+ * 
+ * @param offset ROM offset.
+ * @param buffer Pointer to the destination buffer.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_rom_read (uint32_t offset, void *buffer, size_t length) {
+    static uint8_t block[ROM_ACCESS_BLOCK_SIZE] __attribute__((aligned(16)));
+    flashcart_err_t err;
+    uint8_t *data = buffer;
+
+    if ((err = rom_access_check(offset, length)) != FLASHCART_OK) {
+        return err;
+    }
+
+    while (length > 0) {
+        uint32_t start = (offset & ~7);
+        uint32_t head = (offset - start);
+        size_t chunk = MIN(length, ROM_ACCESS_BLOCK_SIZE - head);
+
+        pi_dma_read_data((void *) (RESIDENCY_ROM_ADDRESS + start), block, ALIGN(head + chunk, 8));
+        memcpy(data, &block[head], chunk);
+
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Write data to the ROM loaded into the flashcart.
+ * 
+ * @param offset ROM offset.
+ * @param buffer Pointer to the source data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_rom_write (uint32_t offset, const void *buffer, size_t length) {
+    static uint8_t block[ROM_ACCESS_BLOCK_SIZE] __attribute__((aligned(16)));
+    flashcart_err_t err;
+    const uint8_t *data = buffer;
+
+    if ((err = rom_access_check(offset, length)) != FLASHCART_OK) {
+        return err;
+    }
+
+    // NOTE: The SDRAM doesn't hold the plain ROM file anymore
+    if (!rom_written) {
+        residency_invalidate();
+        rom_written = true;
+    }
+
+    while (length > 0) {
+        uint32_t start = (offset & ~7);
+        uint32_t head = (offset - start);
+        size_t chunk = MIN(length, ROM_ACCESS_BLOCK_SIZE - head);
+        size_t block_length = ALIGN(head + chunk, 8);
+
+        // NOTE: The PI transfers whole aligned blocks, partially written blocks are read back first
+        if ((head != 0) || (block_length != chunk)) {
+            pi_dma_read_data((void *) (RESIDENCY_ROM_ADDRESS + start), block, block_length);
+        }
+        memcpy(&block[head], data, chunk);
+        pi_dma_write_data(block, (void *) (RESIDENCY_ROM_ADDRESS + start), block_length);
+
+        offset += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+
+    return FLASHCART_OK;
+}
+
 /**
  * @brief Load a save file into the flashcart.
  * 
@@ -290,10 +777,10 @@ flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save
     }
 
     if (!file_exists(save_path)) {
-        if (file_allocate(save_path, SAVE_SIZE[save_type])) {
-            return FLASHCART_ERR_LOAD;
-        }
-        if (file_fill(save_path, 0xFF)) {
+        trace_phase_begin("Save allocation");
+        bool allocate_failed = file_allocate_filled(save_path, SAVE_SIZE[save_type], 0xFF);
+        trace_phase_end();
+        if (allocate_failed) {
             return FLASHCART_ERR_LOAD;
         }
     }
@@ -302,7 +789,10 @@ flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save
         return FLASHCART_ERR_LOAD;
     }
 
-    if ((err = flashcart->load_save(save_path)) != FLASHCART_OK) {
+    trace_phase_begin("Save transfer");
+    err = flashcart->load_save(save_path);
+    trace_phase_end();
+    if (err != FLASHCART_OK) {
         return err;
     }
 
@@ -310,7 +800,11 @@ flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save
         return FLASHCART_OK;
     }
 
-    return flashcart->set_save_writeback(save_path);
+    trace_phase_begin("Save writeback setup");
+    err = flashcart->set_save_writeback(save_path);
+    trace_phase_end();
+
+    return err;
 }
 
 /**
@@ -329,26 +823,37 @@ flashcart_err_t flashcart_load_64dd_ipl (char *ipl_path, flashcart_progress_call
         return FLASHCART_ERR_ARGS;
     }
 
+    residency_invalidate();
+
     return flashcart->load_64dd_ipl(ipl_path, progress);
 }
 
 /**
- * @brief Load a 64DD disk into the flashcart.
+ * @brief Load a set of 64DD disks into the flashcart.
  * 
- * @param disk_path Path to the disk file.
- * @param disk_parameters Pointer to the disk parameters.
+ * @param disk_paths Array of paths to the disk files.
+ * @param disk_parameters Array of disk parameters structures.
+ * @param disk_count Number of disks.
  * @return flashcart_err_t Error code.
  */
-flashcart_err_t flashcart_load_64dd_disk (char *disk_path, flashcart_disk_parameters_t *disk_parameters) {
+flashcart_err_t flashcart_load_64dd_disk (char *disk_paths[], flashcart_disk_parameters_t *disk_parameters, int disk_count) {
     if (!flashcart->load_64dd_disk) {
         return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
     }
 
-    if ((disk_path == NULL) || (disk_parameters == NULL)) {
+    if ((disk_paths == NULL) || (disk_parameters == NULL) || (disk_count <= 0) || (disk_count > FLASHCART_64DD_MAX_DISKS)) {
         return FLASHCART_ERR_ARGS;
     }
 
-    return flashcart->load_64dd_disk(disk_path, disk_parameters);
+    for (int i = 0; i < disk_count; i++) {
+        if (disk_paths[i] == NULL) {
+            return FLASHCART_ERR_ARGS;
+        }
+    }
+
+    residency_invalidate();
+
+    return flashcart->load_64dd_disk(disk_paths, disk_parameters, disk_count);
 }
 
 flashcart_err_t flashcart_set_next_boot_mode (flashcart_reboot_mode_t boot_mode) {
@@ -358,3 +863,155 @@ flashcart_err_t flashcart_set_next_boot_mode (flashcart_reboot_mode_t boot_mode)
 
     return flashcart->set_next_boot_mode(boot_mode);
 }
+
+bool flashcart_reboot_rom_pending (void) {
+    flashcart_residency_t stored;
+
+    if (!flashcart->reboot_rom_pending || !flashcart->reboot_rom_pending()) {
+        return false;
+    }
+
+    if (residency_read(&stored)) {
+        return false;
+    }
+
+    return (residency_sample_hash(stored.size) == stored.hash);
+}
+
+/**
+ * @brief Get the statistics of the last ROM streaming load.
+ * 
+ * @return flashcart_load_stats_t* Pointer to the load statistics.
+ */
+flashcart_load_stats_t *flashcart_get_load_stats (void) {
+    return fatfs_get_load_stats();
+}
+
+/**
+ * @brief Set the location of the ROM residency record.
+ * 
+ * @param cache_location Path to the residency record file.
+ */
+void flashcart_residency_init (char *cache_location) {
+    if (residency_cache_path) {
+        free(residency_cache_path);
+    }
+    residency_cache_path = strdup(cache_location);
+}
+
+/**
+ * @brief Set the location of the save writeback sector list cache.
+ * 
+ * @param cache_location Path to the cache file.
+ */
+void flashcart_save_sectors_cache_init (char *cache_location) {
+    fatfs_set_sector_cache(cache_location);
+}
+
+/**
+ * @brief Use a previously detected ROM data extent for the next ROM load.
+ * 
+ * @param rom_path Path to the ROM file.
+ * @param extent Pointer to the ROM data extent.
+ * @return true if the extent doesn't match the ROM file, false otherwise.
+ */
+bool flashcart_set_rom_extent (char *rom_path, flashcart_rom_extent_t *extent) {
+    uint32_t file_size;
+    uint32_t timestamp;
+
+    rom_extent_valid = false;
+
+    if ((rom_path == NULL) || (extent == NULL) || (extent->data_size >= extent->file_size)) {
+        return true;
+    }
+
+    if (rom_file_stat(rom_path, &file_size, &timestamp) || (file_size != extent->file_size) || (timestamp != extent->timestamp)) {
+        return true;
+    }
+
+    rom_extent = *extent;
+    rom_extent_valid = true;
+
+    return false;
+}
+
+/**
+ * @brief Detect where the meaningful data of the last loaded ROM ends.
+ * 
+ * Scans the ROM image stored in the cart SDRAM backwards until a byte different
+ * from the trailing filler value is found.
+ * 
+ * @param rom_path Path to the ROM file.
+ * @param extent Pointer to store the ROM data extent.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_get_rom_extent (char *rom_path, flashcart_rom_extent_t *extent) {
+    uint8_t buffer[KiB(4)] __attribute__((aligned(8)));
+
+    if (cart_type == CART_NULL) {
+        return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
+    }
+
+    if ((rom_path == NULL) || (extent == NULL)) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    if (rom_file_stat(rom_path, &extent->file_size, &extent->timestamp)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    uint32_t rom_size = ALIGN(extent->file_size, FS_SECTOR_SIZE);
+
+    if (rom_size > RESIDENCY_MAX_ROM_SIZE) {
+        return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
+    }
+
+    extent->data_size = extent->file_size;
+    extent->fill = 0xFF;
+
+    if (extent->file_size == 0) {
+        return FLASHCART_OK;
+    }
+
+    // NOTE: Last byte of the file decides the filler value, anything else than 0x00 or 0xFF is treated as data
+    uint32_t last = (extent->file_size - 1);
+    pi_dma_read_data((void *) (RESIDENCY_ROM_ADDRESS + (last & ~(sizeof(uint64_t) - 1))), buffer, sizeof(uint64_t));
+    uint8_t fill = buffer[last & (sizeof(uint64_t) - 1)];
+
+    if ((fill != 0x00) && (fill != 0xFF)) {
+        return FLASHCART_OK;
+    }
+
+    uint32_t end = extent->file_size;
+
+    while (end > 0) {
+        uint32_t start = (end > sizeof(buffer)) ? ALIGN(end - sizeof(buffer), sizeof(uint64_t)) : 0;
+        uint32_t length = ALIGN(end - start, 2);
+
+        pi_dma_read_data((void *) (RESIDENCY_ROM_ADDRESS + start), buffer, length);
+
+        for (uint32_t i = (end - start); i > 0; i--) {
+            if (buffer[i - 1] != fill) {
+                extent->data_size = ALIGN(start + i, FS_SECTOR_SIZE);
+                extent->fill = fill;
+                return FLASHCART_OK;
+            }
+        }
+
+        end = start;
+    }
+
+    extent->data_size = 0;
+    extent->fill = fill;
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Verify the checksum of the data during the next ROM load.
+ * 
+ * @param verify Pointer to the verification structure.
+ */
+void flashcart_set_rom_verify (flashcart_rom_verify_t *verify) {
+    rom_verify = verify;
+}
@@ -8,8 +8,11 @@
 #define FLASHCART_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include <fatfs/ff.h>
+
 /** @brief Flashcart error enumeration */
 typedef enum {
     FLASHCART_OK, /**< No error */
@@ -20,6 +23,7 @@ typedef enum {
     FLASHCART_ERR_LOAD, /**< Load error */
     FLASHCART_ERR_INT, /**< Internal error */
     FLASHCART_ERR_FUNCTION_NOT_SUPPORTED, /**< Function not supported error */
+    FLASHCART_ERR_VERIFY, /**< Loaded data verification error */
 } flashcart_err_t;
 
 /** @brief List of optional supported flashcart features */
@@ -32,7 +36,8 @@ typedef enum {
     FLASHCART_FEATURE_DIAGNOSTIC_DATA, /**< Diagnostic data support */
     FLASHCART_FEATURE_BIOS_UPDATE_FROM_MENU, /**< BIOS update from menu support */
     FLASHCART_FEATURE_SAVE_WRITEBACK, /**< Save writeback support */
-    FLASHCART_FEATURE_ROM_REBOOT_FAST /**< Fast ROM reboot support */
+    FLASHCART_FEATURE_ROM_REBOOT_FAST, /**< Fast ROM reboot support */
+    FLASHCART_FEATURE_BYTESWAP_ON_LOAD /**< Hardware byte swap of the loaded byte swapped ROMs */
 } flashcart_features_t;
 
 /** @brief Flashcart save type enumeration */
@@ -64,6 +69,16 @@ typedef struct {
     uint8_t defect_tracks[16][12]; /**< Defect tracks */
 } flashcart_disk_parameters_t;
 
+/** @brief Flashcart ROM byte order enumeration. */
+typedef enum {
+    FLASHCART_BYTE_ORDER_BIG_ENDIAN, /**< Native byte order (.z64) */
+    FLASHCART_BYTE_ORDER_BYTE_SWAPPED, /**< 16-bit byte swapped byte order (.v64) */
+    FLASHCART_BYTE_ORDER_LITTLE_ENDIAN, /**< 32-bit little endian byte order (.n64) */
+} flashcart_byte_order_t;
+
+/** @brief Maximum number of 64DD disks loaded at once. */
+#define FLASHCART_64DD_MAX_DISKS    (4)
+
 /** @brief Flashcart Firmware version Structure. */
 typedef struct {
     uint16_t major; /**< Major version */
@@ -74,6 +89,42 @@ typedef struct {
 /** @brief Flashcart progress callback type */
 typedef void flashcart_progress_callback_t (float progress);
 
+/** @brief Flashcart ROM data extent Structure. */
+typedef struct {
+    uint32_t file_size; /**< Size of the ROM file */
+    uint32_t timestamp; /**< FAT modification date and time of the ROM file */
+    uint32_t data_size; /**< Size of the meaningful data, the rest of the file is filler */
+    uint8_t fill; /**< Value of the trailing filler bytes */
+} flashcart_rom_extent_t;
+
+/** @brief Flashcart ROM streaming load statistics Structure. */
+typedef struct {
+    uint32_t bytes; /**< Number of bytes transferred */
+    uint32_t chunks; /**< Number of chunks transferred */
+    uint32_t chunk_size; /**< Chunk size used by the flashcart backend */
+    uint64_t total_us; /**< Total load time in microseconds */
+    uint64_t stall_us; /**< Time spent with the transfer stalled by progress updates in microseconds */
+    uint32_t chunk_min_us; /**< Shortest chunk transfer time in microseconds */
+    uint32_t chunk_max_us; /**< Longest chunk transfer time in microseconds */
+} flashcart_load_stats_t;
+
+/** @brief Flashcart ROM checksum type enumeration */
+typedef enum {
+    FLASHCART_CHECKSUM_NONE, /**< Checksum verification disabled */
+    FLASHCART_CHECKSUM_6102, /**< CIC-6101, CIC-6102, CIC-7101 and CIC-7102 checksum */
+    FLASHCART_CHECKSUM_6103, /**< CIC-6103 and CIC-7103 checksum */
+    FLASHCART_CHECKSUM_6105, /**< CIC-6105 and CIC-7105 checksum */
+    FLASHCART_CHECKSUM_6106, /**< CIC-6106 and CIC-7106 checksum */
+} flashcart_checksum_type_t;
+
+/** @brief Flashcart ROM verification Structure. */
+typedef struct {
+    flashcart_checksum_type_t type; /**< Checksum algorithm matching the ROM CIC */
+    uint64_t expected; /**< Expected checksum, usually the check code from the ROM header */
+    uint64_t computed; /**< Checksum computed during the load */
+    bool done; /**< Checksum was computed during the load */
+} flashcart_rom_verify_t;
+
 /** @brief Flashcart Structure */
 typedef struct {
     /** @brief The flashcart initialization function */
@@ -93,13 +144,15 @@ typedef struct {
     /** @brief The flashcart disk bios load function */
     flashcart_err_t (*load_64dd_ipl) (char *ipl_path, flashcart_progress_callback_t *progress);
     /** @brief The flashcart disk load function */
-    flashcart_err_t (*load_64dd_disk) (char *disk_path, flashcart_disk_parameters_t *disk_parameters);
+    flashcart_err_t (*load_64dd_disk) (char *disk_paths[], flashcart_disk_parameters_t *disk_parameters, int disk_count);
     /** @brief The flashcart set save type function */
     flashcart_err_t (*set_save_type) (flashcart_save_type_t save_type);
     /** @brief The flashcart set save writeback function */
     flashcart_err_t (*set_save_writeback) (char *save_path);
     /** @brief The flashcart set boot mode function */
     flashcart_err_t (*set_next_boot_mode) (flashcart_reboot_mode_t boot_mode);
+    /** @brief The flashcart software reboot check function, for carts without the reboot mode in hardware (optional) */
+    bool (*reboot_rom_pending) (void);
 } flashcart_t;
 
 /**
@@ -144,11 +197,51 @@ flashcart_firmware_version_t flashcart_get_firmware_version (void);
  * @brief Load a ROM onto the flashcart.
  * 
  * @param rom_path The path to the ROM file.
- * @param byte_swap Whether to byte swap the ROM.
+ * @param byte_order Byte order of the ROM file, converted to the native order during load.
+ * @param progress Callback function for progress updates.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_load_rom (char *rom_path, flashcart_byte_order_t byte_order, flashcart_progress_callback_t *progress);
+
+/**
+ * @brief Start loading a ROM onto the flashcart from data streamed by the caller.
+ * 
+ * The data is written straight into the cart SDRAM, no file is read or written on the SD card.
+ * Only ROMs fitting in the memory mapped cart SDRAM can be streamed.
+ * 
+ * @param rom_size Size of the ROM image.
+ * @param byte_order Byte order of the streamed data, converted to the native order during load.
  * @param progress Callback function for progress updates.
  * @return flashcart_err_t Error code.
  */
-flashcart_err_t flashcart_load_rom (char *rom_path, bool byte_swap, flashcart_progress_callback_t *progress);
+flashcart_err_t flashcart_load_rom_stream_begin (uint32_t rom_size, flashcart_byte_order_t byte_order, flashcart_progress_callback_t *progress);
+
+/**
+ * @brief Append data to the ROM streamed onto the flashcart.
+ * 
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_load_rom_stream_write (const void *data, size_t length);
+
+/**
+ * @brief Append data read from a file to the ROM streamed onto the flashcart.
+ * 
+ * The file is read directly into the cart SDRAM, same as during a regular ROM load.
+ * 
+ * @param fil Pointer to the file object, positioned at the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_load_rom_stream_read (FIL *fil, size_t length);
+
+/**
+ * @brief Finish loading the ROM streamed onto the flashcart.
+ * 
+ * @return flashcart_err_t Error code, the whole ROM image must have been streamed.
+ */
+flashcart_err_t flashcart_load_rom_stream_end (void);
 
 /**
  * @brief Load a file onto the flashcart.
@@ -160,6 +253,28 @@ flashcart_err_t flashcart_load_rom (char *rom_path, bool byte_swap, flashcart_pr
  */
 flashcart_err_t flashcart_load_file (char *file_path, uint32_t rom_offset, uint32_t file_offset);
 
+/**
+ * @brief Read data from the ROM loaded onto the flashcart.
+ * 
+ * @param offset The ROM offset.
+ * @param buffer Pointer to the destination buffer.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_rom_read (uint32_t offset, void *buffer, size_t length);
+
+/**
+ * @brief Modify the ROM loaded onto the flashcart, used to patch it in place.
+ * 
+ * Any offset and length can be written, the ROM residency record is invalidated.
+ * 
+ * @param offset The ROM offset.
+ * @param buffer Pointer to the source data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_rom_write (uint32_t offset, const void *buffer, size_t length);
+
 /**
  * @brief Load a save file onto the flashcart.
  * 
@@ -179,13 +294,84 @@ flashcart_err_t flashcart_load_save (char *save_path, flashcart_save_type_t save
 flashcart_err_t flashcart_load_64dd_ipl (char *ipl_path, flashcart_progress_callback_t *progress);
 
 /**
- * @brief Load a 64DD disk onto the flashcart.
+ * @brief Load a set of 64DD disks onto the flashcart.
  * 
- * @param disk_path The path to the disk file.
- * @param disk_parameters Pointer to the disk parameters structure.
+ * First disk is inserted on boot, remaining disks can be swapped in with the flashcart disk swap function.
+ * 
+ * @param disk_paths Array of paths to the disk files.
+ * @param disk_parameters Array of disk parameters structures.
+ * @param disk_count Number of disks, up to FLASHCART_64DD_MAX_DISKS.
  * @return flashcart_err_t Error code.
  */
-flashcart_err_t flashcart_load_64dd_disk (char *disk_path, flashcart_disk_parameters_t *disk_parameters);
+flashcart_err_t flashcart_load_64dd_disk (char *disk_paths[], flashcart_disk_parameters_t *disk_parameters, int disk_count);
 flashcart_err_t flashcart_set_next_boot_mode (flashcart_reboot_mode_t boot_mode);
 
+/**
+ * @brief Check if the menu must boot the ROM left in the cart SDRAM again.
+ * 
+ * Used by the carts emulating the ROM reboot mode in software, the ROM is only
+ * rebooted when the residency record confirms it is still stored in the cart SDRAM.
+ * 
+ * @return true if the ROM must be booted, false otherwise.
+ */
+bool flashcart_reboot_rom_pending (void);
+
+/**
+ * @brief Get the statistics of the last ROM streaming load.
+ * 
+ * @return flashcart_load_stats_t* Pointer to the load statistics.
+ */
+flashcart_load_stats_t *flashcart_get_load_stats (void);
+
+/**
+ * @brief Set the location of the ROM residency record.
+ * 
+ * The record describes the ROM left in the cart SDRAM by the last load,
+ * relaunching the same ROM skips the transfer if the SDRAM contents still match.
+ * 
+ * @param cache_location Path to the residency record file.
+ */
+void flashcart_residency_init (char *cache_location);
+
+/**
+ * @brief Set the location of the save writeback sector list cache.
+ * 
+ * The save file sector list is reused while the file keeps its first cluster and size,
+ * instead of walking the FAT chain on every boot.
+ * 
+ * @param cache_location Path to the cache file.
+ */
+void flashcart_save_sectors_cache_init (char *cache_location);
+
+/**
+ * @brief Use a previously detected ROM data extent for the next ROM load.
+ * 
+ * The extent is rejected if it doesn't match the ROM file anymore.
+ * 
+ * @param rom_path Path to the ROM file.
+ * @param extent Pointer to the ROM data extent.
+ * @return true if the extent doesn't match the ROM file, false otherwise.
+ */
+bool flashcart_set_rom_extent (char *rom_path, flashcart_rom_extent_t *extent);
+
+/**
+ * @brief Detect where the meaningful data of the last loaded ROM ends.
+ * 
+ * @param rom_path Path to the ROM file.
+ * @param extent Pointer to store the ROM data extent.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t flashcart_get_rom_extent (char *rom_path, flashcart_rom_extent_t *extent);
+
+/**
+ * @brief Verify the checksum of the data during the next ROM load.
+ * 
+ * The header checksum is computed from the data as it is loaded and
+ * the load fails with FLASHCART_ERR_VERIFY when it doesn't match the expected value.
+ * Little endian ROMs and ROMs that are already resident are not verified.
+ * 
+ * @param verify Pointer to the verification structure, it must stay valid until the load ends.
+ */
+void flashcart_set_rom_verify (flashcart_rom_verify_t *verify);
+
 #endif /* FLASHCART_H__ */
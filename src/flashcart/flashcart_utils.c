@@ -4,10 +4,17 @@
  * @ingroup flashcart
  */
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libcart/cart.h>
 #include <libdragon.h>
 
 #include "flashcart_utils.h"
 #include "utils/fs.h"
+#include "utils/hash.h"
+#include "utils/trace_events.h"
 #include "utils/utils.h"
 
 /**
@@ -53,18 +60,58 @@ void fatfs_fix_file_size (FIL *fil) {
 }
 
 /**
- * @brief Get the file sectors in the FAT filesystem.
+ * @brief Append a cluster to the list of extents, merging it with the last run if contiguous.
+ * 
+ * @param extents Pointer to the array of extents.
+ * @param count Pointer to the number of extents.
+ * @param capacity Pointer to the capacity of the array.
+ * @param sector First sector of the cluster run.
+ * @param sectors Number of sectors in the cluster run.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool extents_append (fatfs_extent_t **extents, uint32_t *count, uint32_t *capacity, uint32_t sector, uint32_t sectors) {
+    if (*count > 0) {
+        fatfs_extent_t *last = &(*extents)[*count - 1];
+        if ((last->sector + last->count) == sector) {
+            last->count += sectors;
+            return false;
+        }
+    }
+
+    if (*count == *capacity) {
+        uint32_t new_capacity = (*capacity > 0) ? (*capacity * 2) : 16;
+        fatfs_extent_t *new_extents = realloc(*extents, new_capacity * sizeof(fatfs_extent_t));
+        if (new_extents == NULL) {
+            return true;
+        }
+        *extents = new_extents;
+        *capacity = new_capacity;
+    }
+
+    (*extents)[(*count)++] = (fatfs_extent_t) { .sector = sector, .count = sectors };
+
+    return false;
+}
+
+/**
+ * @brief Get the contiguous sector runs of a file in the FAT filesystem.
+ * 
+ * The FAT chain is walked only once, consecutive clusters are merged into a single run.
  * 
  * @param path Path to the file.
- * @param address Pointer to store the address of the file sectors.
- * @param type The type of address (memory or PI).
+ * @param extents Pointer to store the allocated array of extents, must be freed by the caller.
+ * @param count Pointer to store the number of extents.
  * @param max_sectors Maximum number of sectors.
  * @return true if an error occurred, false otherwise.
  */
-bool fatfs_get_file_sectors (char *path, uint32_t *address, address_type_t type, uint32_t max_sectors) {
+bool fatfs_get_file_extents (char *path, fatfs_extent_t **extents, uint32_t *count, uint32_t max_sectors) {
     FATFS *fs;
     FIL fil;
     bool error = false;
+    uint32_t capacity = 0;
+
+    *extents = NULL;
+    *count = 0;
 
     if (f_open(&fil, strip_fs_prefix(path), FA_READ) != FR_OK) {
         return true;
@@ -76,7 +123,50 @@ bool fatfs_get_file_sectors (char *path, uint32_t *address, address_type_t type,
 
     uint32_t sector_count = MIN(f_size(&fil) / FS_SECTOR_SIZE, max_sectors);
 
-    for (uint32_t file_sector = 0; file_sector < sector_count; file_sector += fs->csize) {
+#if FF_USE_FASTSEEK
+    // NOTE: Let FatFs build the cluster link map, it contains ready to use runs of contiguous clusters
+    DWORD map_size = 64;
+    DWORD *map = NULL;
+    FRESULT result;
+
+    while (true) {
+        DWORD *new_map = realloc(map, map_size * sizeof(DWORD));
+        if (new_map == NULL) {
+            result = FR_NOT_ENOUGH_CORE;
+            break;
+        }
+        map = new_map;
+        map[0] = map_size;
+        fil.cltbl = map;
+        result = f_lseek(&fil, CREATE_LINKMAP);
+        if ((result != FR_NOT_ENOUGH_CORE) || (map[0] <= map_size)) {
+            break;
+        }
+        map_size = map[0];
+    }
+
+    bool mapped = (result == FR_OK);
+
+    if (mapped) {
+        uint32_t file_sector = 0;
+        for (DWORD *run = &map[1]; (run[0] != 0) && (file_sector < sector_count); run += 2) {
+            uint32_t run_sectors = MIN(run[0] * fs->csize, sector_count - file_sector);
+            uint32_t run_sector = (fs->database + ((LBA_t) (fs->csize) * (run[1] - 2)));
+            if ((run[1] < 2) || ((run[1] + run[0]) > fs->n_fatent) || extents_append(extents, count, &capacity, run_sector, run_sectors)) {
+                error = true;
+                break;
+            }
+            file_sector += run_sectors;
+        }
+    }
+
+    fil.cltbl = NULL;
+    free(map);
+#else
+    bool mapped = false;
+#endif
+
+    for (uint32_t file_sector = 0; !mapped && (file_sector < sector_count); file_sector += fs->csize) {
         if ((f_lseek(&fil, (file_sector * FS_SECTOR_SIZE) + (FS_SECTOR_SIZE / 2))) != FR_OK) {
             error = true;
             break;
@@ -90,14 +180,65 @@ bool fatfs_get_file_sectors (char *path, uint32_t *address, address_type_t type,
         }
 
         uint32_t cluster_sector = (fs->database + ((LBA_t) (fs->csize) * (cluster - 2)));
+        uint32_t cluster_sectors = MIN(fs->csize, sector_count - file_sector);
 
-        for (uint32_t i = 0; i < fs->csize; i++) {
-            uint32_t sector = (cluster_sector + i);
+        if (extents_append(extents, count, &capacity, cluster_sector, cluster_sectors)) {
+            error = true;
+            break;
+        }
+    }
 
-            if ((file_sector + i) >= sector_count) {
-                break;
-            }
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
 
+    if (error) {
+        free(*extents);
+        *extents = NULL;
+        *count = 0;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Get the number of fragments of a file in the FAT filesystem.
+ * 
+ * @param path Path to the file.
+ * @return int32_t Number of contiguous sector runs, 1 for a contiguous file, -1 if an error occurred.
+ */
+int32_t fatfs_get_file_fragments (char *path) {
+    fatfs_extent_t *extents;
+    uint32_t count;
+
+    if (fatfs_get_file_extents(path, &extents, &count, UINT32_MAX)) {
+        return -1;
+    }
+
+    free(extents);
+
+    return (int32_t) (MAX(count, 1));
+}
+
+/**
+ * @brief Get the file sectors in the FAT filesystem.
+ * 
+ * @param path Path to the file.
+ * @param address Pointer to store the address of the file sectors.
+ * @param type The type of address (memory or PI).
+ * @param max_sectors Maximum number of sectors.
+ * @return true if an error occurred, false otherwise.
+ */
+bool fatfs_get_file_sectors (char *path, uint32_t *address, address_type_t type, uint32_t max_sectors) {
+    fatfs_extent_t *extents;
+    uint32_t count;
+
+    if (fatfs_get_file_extents(path, &extents, &count, max_sectors)) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t sector = extents[i].sector; sector < (extents[i].sector + extents[i].count); sector++) {
             switch (type) {
                 case ADDRESS_TYPE_MEM:
                     *address = sector;
@@ -112,9 +253,731 @@ bool fatfs_get_file_sectors (char *path, uint32_t *address, address_type_t type,
         }
     }
 
+    free(extents);
+
+    return false;
+}
+
+#define SECTOR_CACHE_MAGIC      (0x53454332) // "SEC2"
+#define SECTOR_CACHE_SLOTS      (8)
+
+/** @brief Cached save file sector list, valid while the file keeps its first cluster, size and timestamp. */
+typedef struct {
+    uint32_t magic; /**< Entry magic */
+    uint32_t path_hash; /**< Hash of the file path */
+    uint32_t first_cluster; /**< First cluster of the file */
+    uint32_t size; /**< Size of the file */
+    uint32_t timestamp; /**< FAT timestamp of the file */
+    uint32_t sector_count; /**< Number of valid sectors */
+    uint32_t sectors[SAVE_WRITEBACK_MAX_SECTORS]; /**< Sector list */
+} sector_cache_entry_t;
+
+static char *sector_cache_path = NULL;
+
+/**
+ * @brief Set the location of the save sector list cache.
+ * 
+ * @param cache_location Path to the cache file, NULL to disable the cache.
+ */
+void fatfs_set_sector_cache (char *cache_location) {
+    free(sector_cache_path);
+    sector_cache_path = (cache_location != NULL) ? strdup(cache_location) : NULL;
+}
+
+/**
+ * @brief Get the sectors of a save file, using the sector list cache.
+ * 
+ * The cache holds one entry per slot selected by the path hash, an entry is
+ * only used while the file keeps the same first cluster, size and timestamp.
+ * A save recreated elsewhere with the same size can get the same first cluster but
+ * a different cluster chain, the timestamp tells them apart without walking the FAT.
+ * 
+ * @param path Path to the file.
+ * @param sectors Pointer to store the sector list.
+ * @param max_sectors Maximum number of sectors, up to SAVE_WRITEBACK_MAX_SECTORS.
+ * @return true if an error occurred, false otherwise.
+ */
+bool fatfs_get_save_sectors (char *path, uint32_t *sectors, uint32_t max_sectors) {
+    FIL fil;
+    FILINFO info;
+    UINT bytes;
+    sector_cache_entry_t entry;
+
+    if (max_sectors > SAVE_WRITEBACK_MAX_SECTORS) {
+        return true;
+    }
+
+    if (f_stat(strip_fs_prefix(path), &info) != FR_OK) {
+        return true;
+    }
+    uint32_t timestamp = ((info.fdate << 16) | info.ftime);
+
+    if (f_open(&fil, strip_fs_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+    uint32_t first_cluster = fil.obj.sclust;
+    uint32_t size = f_size(&fil);
+    f_close(&fil);
+
+    uint32_t path_hash = fnv1a32_string(strip_fs_prefix(path));
+    uint32_t sector_count = MIN(ALIGN(size, FS_SECTOR_SIZE) / FS_SECTOR_SIZE, max_sectors);
+    FSIZE_t slot_offset = hash_slot_offset(path_hash, SECTOR_CACHE_SLOTS, sizeof(sector_cache_entry_t));
+
+    if ((sector_cache_path != NULL) && (f_open(&fil, strip_fs_prefix(sector_cache_path), FA_READ) == FR_OK)) {
+        bool hit = (
+            (f_lseek(&fil, slot_offset) == FR_OK) &&
+            (f_read(&fil, &entry, sizeof(entry), &bytes) == FR_OK) &&
+            (bytes == sizeof(entry)) &&
+            (entry.magic == SECTOR_CACHE_MAGIC) &&
+            (entry.path_hash == path_hash) &&
+            (entry.first_cluster == first_cluster) &&
+            (entry.size == size) &&
+            (entry.timestamp == timestamp) &&
+            (entry.sector_count == sector_count)
+        );
+        f_close(&fil);
+        if (hit) {
+            memcpy(sectors, entry.sectors, sector_count * sizeof(uint32_t));
+            return false;
+        }
+    }
+
+    if (fatfs_get_file_sectors(path, sectors, ADDRESS_TYPE_MEM, max_sectors)) {
+        return true;
+    }
+
+    if ((sector_cache_path != NULL) && (f_open(&fil, strip_fs_prefix(sector_cache_path), FA_WRITE | FA_OPEN_ALWAYS) == FR_OK)) {
+        entry = (sector_cache_entry_t) {
+            .magic = SECTOR_CACHE_MAGIC,
+            .path_hash = path_hash,
+            .first_cluster = first_cluster,
+            .size = size,
+            .timestamp = timestamp,
+            .sector_count = sector_count,
+        };
+        memcpy(entry.sectors, sectors, sector_count * sizeof(uint32_t));
+        // NOTE: Seeking past the end of the file extends it, the skipped slots hold no valid magic
+        if (f_lseek(&fil, slot_offset) == FR_OK) {
+            f_write(&fil, &entry, sizeof(entry), &bytes);
+        }
+        f_close(&fil);
+    }
+
+    return false;
+}
+
+#define PROGRESS_INTERVAL_MS    (100)
+
+#define FILL_BUFFER_SIZE        (KiB(8))
+
+#define CHECKSUM_START          (0x1000)
+#define CHECKSUM_LENGTH         (MiB(1))
+#define CHECKSUM_6105_TABLE     (0x750)
+#define CHECKSUM_BUFFER_SIZE    (KiB(8))
+
+/** @brief ROM header checksum state structure. */
+typedef struct {
+    flashcart_rom_verify_t *verify;
+    size_t offset;
+    uint32_t t1, t2, t3, t4, t5, t6;
+    uint32_t table[64];
+} load_checksum_t;
+
+static load_checksum_t load_checksum;
+static flashcart_load_stats_t load_stats;
+static size_t load_data_size = SIZE_MAX;
+static uint8_t load_fill;
+static uint64_t load_start_us;
+static uint64_t progress_last_update_ms;
+
+#define STREAM_BUFFER_SIZE      (KiB(32))
+
+/** @brief Memory streaming loader state structure. */
+static struct {
+    uint64_t buffers[2][STREAM_BUFFER_SIZE / sizeof(uint64_t)] __attribute__((aligned(16)));
+    void *address;
+    size_t size;
+    size_t offset;
+    size_t filled;
+    int current;
+    flashcart_byte_order_t byte_order;
+    flashcart_progress_callback_t *progress;
+} load_stream;
+
+/**
+ * @brief Reset the load statistics and start timing a new streaming load.
+ * 
+ * @param chunk_size Chunk size used by the flashcart backend.
+ */
+void fatfs_load_begin (size_t chunk_size) {
+    load_stats = (flashcart_load_stats_t) {
+        .chunk_size = chunk_size,
+        .chunk_min_us = UINT32_MAX,
+    };
+    load_start_us = get_ticks_us();
+    progress_last_update_ms = get_ticks_ms();
+}
+
+/**
+ * @brief Finish timing the current streaming load.
+ */
+void fatfs_load_end (void) {
+    load_stats.total_us = (get_ticks_us() - load_start_us);
+    if (load_stats.chunks == 0) {
+        load_stats.chunk_min_us = 0;
+    }
+    debugf(
+        "Flashcart: Loaded %lu bytes in %llu us, stalled for %llu us, chunk time %lu - %lu us\n",
+        load_stats.bytes, load_stats.total_us, load_stats.stall_us, load_stats.chunk_min_us, load_stats.chunk_max_us
+    );
+}
+
+/**
+ * @brief Report load progress, rate limited to a fixed interval.
+ * 
+ * @param progress Progress callback function.
+ * @param fraction Loaded fraction of the data.
+ * @param force Report progress regardless of the time since the last update.
+ */
+static void load_progress_report (flashcart_progress_callback_t *progress, float fraction, bool force) {
+    if (!progress) {
+        return;
+    }
+
+    uint64_t now = get_ticks_ms();
+
+    if (force || ((now - progress_last_update_ms) >= PROGRESS_INTERVAL_MS)) {
+        uint64_t stall_start_us = get_ticks_us();
+        progress(fraction);
+        load_stats.stall_us += (get_ticks_us() - stall_start_us);
+        progress_last_update_ms = get_ticks_ms();
+    }
+}
+
+/**
+ * @brief Report streaming load progress, rate limited to a fixed interval.
+ * 
+ * Every progress update renders a whole frame while the SD transfer is stalled,
+ * time spent on it is accounted in the load statistics.
+ * 
+ * @param fil Pointer to the file object.
+ * @param progress Progress callback function.
+ * @param force Report progress regardless of the time since the last update.
+ */
+void fatfs_load_progress (FIL *fil, flashcart_progress_callback_t *progress, bool force) {
+    load_progress_report(progress, f_tell(fil) / (float) (f_size(fil)), force);
+}
+
+/**
+ * @brief Feed the loaded data into the ROM header checksum.
+ * 
+ * @param address Address of the ROM start.
+ * @param end Offset up to which the data is already loaded.
+ */
+static void checksum_feed (void *address, size_t end) {
+    static uint32_t buffer[CHECKSUM_BUFFER_SIZE / sizeof(uint32_t)] __attribute__((aligned(16)));
+    load_checksum_t *c = &load_checksum;
+
+    if ((c->verify == NULL) || c->verify->done) {
+        return;
+    }
+
+    if ((c->verify->type == FLASHCART_CHECKSUM_6105) && (c->offset == CHECKSUM_START) && (end >= CHECKSUM_START)) {
+        pi_dma_read_data(address + CHECKSUM_6105_TABLE, c->table, sizeof(c->table));
+    }
+
+    end = MIN(end, CHECKSUM_START + CHECKSUM_LENGTH);
+
+    while (c->offset < end) {
+        size_t length = MIN(end - c->offset, sizeof(buffer));
+
+        pi_dma_read_data(address + c->offset, buffer, length);
+
+        for (size_t i = 0; i < (length / sizeof(uint32_t)); i++) {
+            uint32_t d = buffer[i];
+            if ((c->t6 + d) < c->t6) {
+                c->t4 += 1;
+            }
+            c->t6 += d;
+            c->t3 ^= d;
+            uint32_t r = (d << (d & 0x1F)) | (d >> ((32 - (d & 0x1F)) & 0x1F));
+            c->t5 += r;
+            if (c->t2 > d) {
+                c->t2 ^= r;
+            } else {
+                c->t2 ^= c->t6 ^ d;
+            }
+            if (c->verify->type == FLASHCART_CHECKSUM_6105) {
+                c->t1 += c->table[((c->offset + (i * sizeof(uint32_t))) & 0xFF) / sizeof(uint32_t)] ^ d;
+            } else {
+                c->t1 += c->t5 ^ d;
+            }
+        }
+
+        c->offset += length;
+    }
+
+    if (c->offset < (CHECKSUM_START + CHECKSUM_LENGTH)) {
+        return;
+    }
+
+    uint32_t crc1, crc2;
+
+    switch (c->verify->type) {
+        case FLASHCART_CHECKSUM_6103:
+            crc1 = (c->t6 ^ c->t4) + c->t3;
+            crc2 = (c->t5 ^ c->t2) + c->t1;
+            break;
+        case FLASHCART_CHECKSUM_6106:
+            crc1 = (c->t6 * c->t4) + c->t3;
+            crc2 = (c->t5 * c->t2) + c->t1;
+            break;
+        default:
+            crc1 = c->t6 ^ c->t4 ^ c->t3;
+            crc2 = c->t5 ^ c->t2 ^ c->t1;
+            break;
+    }
+
+    c->verify->computed = (((uint64_t) (crc1)) << 32) | crc2;
+    c->verify->done = true;
+}
+
+/**
+ * @brief Fill the space past the meaningful data instead of loading the filler from the file.
+ * 
+ * @param address Destination address.
+ * @param data_size Size of the loaded data.
+ * @param size Size of the whole image.
+ */
+static void load_fill_tail (void *address, size_t data_size, size_t size) {
+    static uint8_t fill_buffer[FILL_BUFFER_SIZE] __attribute__((aligned(8)));
+
+    memset(fill_buffer, load_fill, sizeof(fill_buffer));
+
+    for (size_t offset = data_size; offset < size; offset += FILL_BUFFER_SIZE) {
+        pi_dma_write_data(fill_buffer, address + offset, MIN(size - offset, FILL_BUFFER_SIZE));
+    }
+}
+
+/**
+ * @brief Stream data from an opened file directly into the cart address space.
+ * 
+ * @param fil Pointer to the file object.
+ * @param address Destination address.
+ * @param size Number of bytes to transfer.
+ * @param chunk_size Number of bytes transferred per one f_read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_chunked (FIL *fil, void *address, size_t size, size_t chunk_size, flashcart_progress_callback_t *progress) {
+    size_t data_size = MIN(size, load_data_size);
+
+    for (size_t offset = 0; offset < data_size; offset += chunk_size) {
+        size_t block_size = MIN(data_size - offset, chunk_size);
+        UINT br;
+
+        uint64_t chunk_start_us = get_ticks_us();
+        trace_event_begin("flashcart", "SD read");
+        if (f_read(fil, address + offset, block_size, &br) != FR_OK) {
+            trace_event_end("flashcart", "SD read");
+            return FLASHCART_ERR_LOAD;
+        }
+        trace_event_end("flashcart", "SD read");
+        uint32_t chunk_us = (uint32_t) (get_ticks_us() - chunk_start_us);
+
+        load_stats.bytes += br;
+        load_stats.chunks += 1;
+        load_stats.chunk_min_us = MIN(load_stats.chunk_min_us, chunk_us);
+        load_stats.chunk_max_us = MAX(load_stats.chunk_max_us, chunk_us);
+
+        // NOTE: Only the checksummed megabyte is read back into RDRAM, right after each chunk is loaded
+        checksum_feed(address, offset + br);
+
+        fatfs_load_progress(fil, progress, ((offset + block_size) >= size));
+
+        if (br != block_size) {
+            return FLASHCART_OK;
+        }
+    }
+
+    if (data_size < size) {
+        load_fill_tail(address, data_size, size);
+
+        if (f_lseek(fil, f_tell(fil) + (size - data_size)) != FR_OK) {
+            return FLASHCART_ERR_LOAD;
+        }
+
+        checksum_feed(address, size);
+
+        fatfs_load_progress(fil, progress, true);
+    }
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Open a file and stream its whole contents directly into the cart address space.
+ * 
+ * @param path Path to the file.
+ * @param address Destination address.
+ * @param max_size Maximum allowed file size.
+ * @param chunk_size Number of bytes transferred per one f_read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_file (char *path, void *address, size_t max_size, size_t chunk_size, flashcart_progress_callback_t *progress) {
+    FIL fil;
+
+    if (f_open(&fil, strip_fs_prefix(path), FA_READ) != FR_OK) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    fatfs_fix_file_size(&fil);
+
+    size_t file_size = f_size(&fil);
+
+    if (file_size > max_size) {
+        f_close(&fil);
+        return FLASHCART_ERR_LOAD;
+    }
+
+    fatfs_load_begin(chunk_size);
+
+    flashcart_err_t err = fatfs_load_chunked(&fil, address, file_size, chunk_size, progress);
+
+    fatfs_load_end();
+
+    if ((err == FLASHCART_OK) && (f_tell(&fil) != file_size)) {
+        err = FLASHCART_ERR_LOAD;
+    }
+
     if (f_close(&fil) != FR_OK) {
-        error = true;
+        return FLASHCART_ERR_LOAD;
     }
 
-    return error;
+    return err;
+}
+
+/**
+ * @brief Load the sectors of a file straight into the cart address space, without going through FatFs.
+ * 
+ * Progress reporting, checksum verification and the data extent are handled the same as in the FatFs loader.
+ * 
+ * @param extents Sector runs of the file, from fatfs_get_file_extents.
+ * @param count Number of sector runs.
+ * @param address Destination address in the cart address space.
+ * @param size Size of the file, a multiple of the sector size.
+ * @param chunk_size Number of bytes transferred per one sector read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_extents (fatfs_extent_t *extents, uint32_t count, void *address, size_t size, size_t chunk_size, flashcart_progress_callback_t *progress) {
+    uint32_t data_sectors = (MIN(size, load_data_size) / FS_SECTOR_SIZE);
+    uint32_t chunk_sectors = (chunk_size / FS_SECTOR_SIZE);
+    uint32_t loaded = 0;
+
+    for (uint32_t i = 0; (i < count) && (loaded < data_sectors); i++) {
+        for (uint32_t offset = 0; (offset < extents[i].count) && (loaded < data_sectors); offset += chunk_sectors) {
+            uint32_t length = MIN(MIN(extents[i].count - offset, chunk_sectors), data_sectors - loaded);
+
+            uint64_t chunk_start_us = get_ticks_us();
+            trace_event_begin("flashcart", "SD read");
+            int result = cart_card_rd_cart(PhysicalAddr(address) + (loaded * FS_SECTOR_SIZE), extents[i].sector + offset, length);
+            trace_event_end("flashcart", "SD read");
+            if (result) {
+                return FLASHCART_ERR_LOAD;
+            }
+            uint32_t chunk_us = (uint32_t) (get_ticks_us() - chunk_start_us);
+
+            loaded += length;
+
+            load_stats.bytes += (length * FS_SECTOR_SIZE);
+            load_stats.chunks += 1;
+            load_stats.chunk_min_us = MIN(load_stats.chunk_min_us, chunk_us);
+            load_stats.chunk_max_us = MAX(load_stats.chunk_max_us, chunk_us);
+
+            checksum_feed(address, loaded * FS_SECTOR_SIZE);
+
+            load_progress_report(progress, (loaded * FS_SECTOR_SIZE) / (float) (size), false);
+        }
+    }
+
+    if (loaded < data_sectors) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    if ((data_sectors * FS_SECTOR_SIZE) < size) {
+        load_fill_tail(address, data_sectors * FS_SECTOR_SIZE, size);
+        checksum_feed(address, size);
+    }
+
+    load_progress_report(progress, 1.0f, true);
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Open a file and load its sectors straight into the cart address space.
+ * 
+ * The FAT chain is walked once before the transfer, files ending with a partial sector are loaded with fatfs_load_file.
+ * 
+ * @param path Path to the file.
+ * @param address Destination address in the cart address space.
+ * @param max_size Maximum allowed file size.
+ * @param chunk_size Number of bytes transferred per one sector read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_file_direct (char *path, void *address, size_t max_size, size_t chunk_size, flashcart_progress_callback_t *progress) {
+    fatfs_extent_t *extents;
+    uint32_t count;
+
+    int64_t file_size = file_get_size(path);
+
+    if ((file_size < 0) || (file_size > max_size)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    if ((file_size % FS_SECTOR_SIZE) != 0) {
+        return fatfs_load_file(path, address, max_size, chunk_size, progress);
+    }
+
+    if (fatfs_get_file_extents(path, &extents, &count, file_size / FS_SECTOR_SIZE)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    fatfs_load_begin(chunk_size);
+
+    flashcart_err_t err = fatfs_load_extents(extents, count, address, file_size, chunk_size, progress);
+
+    fatfs_load_end();
+
+    free(extents);
+
+    return err;
+}
+
+/**
+ * @brief Convert a block of the ROM image to the native byte order.
+ * 
+ * @param buffer Pointer to the block, aligned to 8 bytes.
+ * @param length Length of the block, rounded up to 8 bytes.
+ * @param byte_order Byte order of the block.
+ */
+static void stream_convert_byte_order (uint64_t *buffer, size_t length, flashcart_byte_order_t byte_order) {
+    if (byte_order == FLASHCART_BYTE_ORDER_BIG_ENDIAN) {
+        return;
+    }
+
+    for (size_t i = 0; i < (length / sizeof(uint64_t)); i++) {
+        uint64_t value = buffer[i];
+        value = (((value & 0x00FF00FF00FF00FFULL) << 8) | ((value >> 8) & 0x00FF00FF00FF00FFULL));
+        if (byte_order == FLASHCART_BYTE_ORDER_LITTLE_ENDIAN) {
+            value = (((value & 0x0000FFFF0000FFFFULL) << 16) | ((value >> 16) & 0x0000FFFF0000FFFFULL));
+        }
+        buffer[i] = value;
+    }
+}
+
+/**
+ * @brief Convert the filled staging buffer and start its transfer, the other buffer is filled meanwhile.
+ */
+static void stream_flush (void) {
+    uint64_t *buffer = load_stream.buffers[load_stream.current];
+    size_t length = ALIGN(load_stream.filled, sizeof(uint64_t));
+
+    memset(((uint8_t *) (buffer)) + load_stream.filled, 0, length - load_stream.filled);
+
+    stream_convert_byte_order(buffer, length, load_stream.byte_order);
+
+    data_cache_hit_writeback(buffer, length);
+
+    uint64_t chunk_start_us = get_ticks_us();
+    trace_event_begin("flashcart", "PI DMA wait");
+    dma_wait();
+    trace_event_end("flashcart", "PI DMA wait");
+    uint32_t chunk_us = (uint32_t) (get_ticks_us() - chunk_start_us);
+
+    // NOTE: Only the data already transferred is read back, the checksum is done after the first megabyte anyway
+    checksum_feed(load_stream.address, load_stream.offset);
+
+    dma_write_raw_async(buffer, (uint32_t) (load_stream.address + load_stream.offset), length);
+
+    load_stats.bytes += load_stream.filled;
+    load_stats.chunks += 1;
+    load_stats.chunk_min_us = MIN(load_stats.chunk_min_us, chunk_us);
+    load_stats.chunk_max_us = MAX(load_stats.chunk_max_us, chunk_us);
+
+    load_stream.offset += load_stream.filled;
+    load_stream.filled = 0;
+    load_stream.current ^= 1;
+
+    load_progress_report(load_stream.progress, load_stream.offset / (float) (load_stream.size), false);
+}
+
+/**
+ * @brief Start streaming a ROM image from memory into the cart address space.
+ * 
+ * @param address Destination address.
+ * @param size Size of the ROM image.
+ * @param byte_order Byte order of the streamed data, converted to the native order on the fly.
+ * @param progress Progress callback function.
+ */
+void stream_load_begin (void *address, size_t size, flashcart_byte_order_t byte_order, flashcart_progress_callback_t *progress) {
+    load_stream.address = address;
+    load_stream.size = size;
+    load_stream.offset = 0;
+    load_stream.filled = 0;
+    load_stream.current = 0;
+    load_stream.byte_order = byte_order;
+    load_stream.progress = progress;
+
+    fatfs_load_begin(STREAM_BUFFER_SIZE);
+}
+
+/**
+ * @brief Append data to the streamed ROM image.
+ * 
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t stream_load_write (const void *data, size_t length) {
+    if ((load_stream.offset + load_stream.filled + length) > load_stream.size) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    const uint8_t *source = data;
+
+    while (length > 0) {
+        size_t n = MIN(length, STREAM_BUFFER_SIZE - load_stream.filled);
+
+        memcpy(((uint8_t *) (load_stream.buffers[load_stream.current])) + load_stream.filled, source, n);
+
+        load_stream.filled += n;
+        source += n;
+        length -= n;
+
+        if (load_stream.filled == STREAM_BUFFER_SIZE) {
+            stream_flush();
+        }
+    }
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Append data read from a file straight into the streamed ROM image.
+ * 
+ * The data doesn't pass through the staging buffers, the file is read directly into the cart address space.
+ * 
+ * @param fil Pointer to the file object, positioned at the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t stream_load_read (FIL *fil, size_t length) {
+    UINT br;
+
+    if (load_stream.filled > 0) {
+        stream_flush();
+    }
+
+    if (((load_stream.offset + length) > load_stream.size) || ((load_stream.offset & 1) != 0)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    dma_wait();
+
+    uint64_t chunk_start_us = get_ticks_us();
+    trace_event_begin("flashcart", "SD read");
+    if ((f_read(fil, load_stream.address + load_stream.offset, length, &br) != FR_OK) || (br != length)) {
+        trace_event_end("flashcart", "SD read");
+        return FLASHCART_ERR_LOAD;
+    }
+    trace_event_end("flashcart", "SD read");
+    uint32_t chunk_us = (uint32_t) (get_ticks_us() - chunk_start_us);
+
+    load_stats.bytes += br;
+    load_stats.chunks += 1;
+    load_stats.chunk_min_us = MIN(load_stats.chunk_min_us, chunk_us);
+    load_stats.chunk_max_us = MAX(load_stats.chunk_max_us, chunk_us);
+
+    load_stream.offset += length;
+
+    checksum_feed(load_stream.address, load_stream.offset);
+
+    load_progress_report(load_stream.progress, load_stream.offset / (float) (load_stream.size), false);
+
+    return FLASHCART_OK;
+}
+
+/**
+ * @brief Finish streaming the ROM image.
+ * 
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t stream_load_end (void) {
+    if (load_stream.filled > 0) {
+        stream_flush();
+    }
+
+    dma_wait();
+
+    checksum_feed(load_stream.address, load_stream.offset);
+
+    load_progress_report(load_stream.progress, 1.0f, true);
+
+    fatfs_load_end();
+
+    return (load_stream.offset == load_stream.size) ? FLASHCART_OK : FLASHCART_ERR_LOAD;
+}
+
+/**
+ * @brief Limit the streaming loads to the meaningful data, the rest is filled on the cart side.
+ * 
+ * @param data_size Number of bytes read from the file, SIZE_MAX to disable the limit.
+ * @param fill Value used to fill the remaining space.
+ */
+void fatfs_set_load_data_size (size_t data_size, uint8_t fill) {
+    load_data_size = (data_size == SIZE_MAX) ? SIZE_MAX : ALIGN(data_size, FS_SECTOR_SIZE);
+    load_fill = fill;
+}
+
+/**
+ * @brief Compute the ROM header checksum during the streaming loads.
+ * 
+ * @param verify Pointer to the verification structure, NULL to disable.
+ */
+void fatfs_set_load_verify (flashcart_rom_verify_t *verify) {
+    uint32_t seed;
+
+    load_checksum = (load_checksum_t) { .verify = NULL };
+
+    if ((verify == NULL) || (verify->type == FLASHCART_CHECKSUM_NONE)) {
+        return;
+    }
+
+    switch (verify->type) {
+        case FLASHCART_CHECKSUM_6103: seed = 0xA3886759; break;
+        case FLASHCART_CHECKSUM_6105: seed = 0xDF26F436; break;
+        case FLASHCART_CHECKSUM_6106: seed = 0x1FEA617A; break;
+        default: seed = 0xF8CA4DDC; break;
+    }
+
+    verify->done = false;
+    verify->computed = 0;
+
+    load_checksum.verify = verify;
+    load_checksum.offset = CHECKSUM_START;
+    load_checksum.t1 = load_checksum.t2 = load_checksum.t3 = seed;
+    load_checksum.t4 = load_checksum.t5 = load_checksum.t6 = seed;
+}
+
+/**
+ * @brief Get the statistics of the last streaming load.
+ * 
+ * @return flashcart_load_stats_t* Pointer to the load statistics.
+ */
+flashcart_load_stats_t *fatfs_get_load_stats (void) {
+    return &load_stats;
 }
@@ -13,8 +13,13 @@
 
 #include <fatfs/ff.h>
 
+#include "flashcart.h"
+
 #define SAVE_WRITEBACK_MAX_SECTORS  (256)
 
+/** @brief Default chunk size used by the ROM streaming loader. */
+#define FLASHCART_LOAD_CHUNK_SIZE   (KiB(128))
+
 /**
  * @brief Address types for DMA operations.
  */
@@ -23,6 +28,12 @@ typedef enum {
     ADDRESS_TYPE_PI,  /**< Peripheral Interface address type. */
 } address_type_t;
 
+/** @brief Contiguous run of file sectors Structure. */
+typedef struct {
+    uint32_t sector; /**< First sector of the run */
+    uint32_t count; /**< Number of sectors in the run */
+} fatfs_extent_t;
+
 /**
  * @brief Perform a DMA read operation from the PI (Peripheral Interface).
  * 
@@ -55,8 +66,178 @@ void fatfs_fix_file_size (FIL *fil);
  * @param address Pointer to store the address of the file sectors.
  * @param address_type The type of address (memory or PI).
  * @param max_sectors Maximum number of sectors.
- * @return true if successful, false otherwise.
+ * @return true if an error occurred, false otherwise.
  */
 bool fatfs_get_file_sectors (char *path, uint32_t *address, address_type_t address_type, uint32_t max_sectors);
 
+/**
+ * @brief Set the location of the save sector list cache.
+ * 
+ * @param cache_location Path to the cache file, NULL to disable the cache.
+ */
+void fatfs_set_sector_cache (char *cache_location);
+
+/**
+ * @brief Get the sectors of a save file, reusing the cached list while the file keeps its first cluster and size.
+ * 
+ * @param path Path to the file.
+ * @param sectors Pointer to store the sector list.
+ * @param max_sectors Maximum number of sectors, up to SAVE_WRITEBACK_MAX_SECTORS.
+ * @return true if an error occurred, false otherwise.
+ */
+bool fatfs_get_save_sectors (char *path, uint32_t *sectors, uint32_t max_sectors);
+
+/**
+ * @brief Get the contiguous sector runs of a file in the FAT filesystem.
+ * 
+ * @param path Path to the file.
+ * @param extents Pointer to store the allocated array of extents, must be freed by the caller.
+ * @param count Pointer to store the number of extents.
+ * @param max_sectors Maximum number of sectors.
+ * @return true if an error occurred, false otherwise.
+ */
+bool fatfs_get_file_extents (char *path, fatfs_extent_t **extents, uint32_t *count, uint32_t max_sectors);
+
+/**
+ * @brief Get the number of fragments of a file in the FAT filesystem.
+ * 
+ * @param path Path to the file.
+ * @return int32_t Number of contiguous sector runs, 1 for a contiguous file, -1 if an error occurred.
+ */
+int32_t fatfs_get_file_fragments (char *path);
+
+/**
+ * @brief Reset the load statistics and start timing a new streaming load.
+ * 
+ * @param chunk_size Chunk size used by the flashcart backend.
+ */
+void fatfs_load_begin (size_t chunk_size);
+
+/**
+ * @brief Finish timing the current streaming load.
+ */
+void fatfs_load_end (void);
+
+/**
+ * @brief Report streaming load progress, rate limited to a fixed interval.
+ * 
+ * @param fil Pointer to the file object.
+ * @param progress Progress callback function.
+ * @param force Report progress regardless of the time since the last update.
+ */
+void fatfs_load_progress (FIL *fil, flashcart_progress_callback_t *progress, bool force);
+
+/**
+ * @brief Stream data from an opened file directly into the cart address space.
+ * 
+ * @param fil Pointer to the file object.
+ * @param address Destination address.
+ * @param size Number of bytes to transfer.
+ * @param chunk_size Number of bytes transferred per one f_read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_chunked (FIL *fil, void *address, size_t size, size_t chunk_size, flashcart_progress_callback_t *progress);
+
+/**
+ * @brief Open a file and stream its whole contents directly into the cart address space.
+ * 
+ * @param path Path to the file.
+ * @param address Destination address.
+ * @param max_size Maximum allowed file size.
+ * @param chunk_size Number of bytes transferred per one f_read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_file (char *path, void *address, size_t max_size, size_t chunk_size, flashcart_progress_callback_t *progress);
+
+/**
+ * @brief Load the sectors of a file straight into the cart address space, without going through FatFs.
+ * 
+ * Nothing is read through FatFs during the transfer, the caller can reconfigure the cart in the meantime.
+ * 
+ * @param extents Sector runs of the file, from fatfs_get_file_extents.
+ * @param count Number of sector runs.
+ * @param address Destination address in the cart address space.
+ * @param size Size of the file, a multiple of the sector size.
+ * @param chunk_size Number of bytes transferred per one sector read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_extents (fatfs_extent_t *extents, uint32_t count, void *address, size_t size, size_t chunk_size, flashcart_progress_callback_t *progress);
+
+/**
+ * @brief Open a file and load its sectors straight into the cart address space.
+ * 
+ * The FAT chain is walked once before the transfer, files ending with a partial sector are loaded with fatfs_load_file.
+ * 
+ * @param path Path to the file.
+ * @param address Destination address in the cart address space.
+ * @param max_size Maximum allowed file size.
+ * @param chunk_size Number of bytes transferred per one sector read call.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t fatfs_load_file_direct (char *path, void *address, size_t max_size, size_t chunk_size, flashcart_progress_callback_t *progress);
+
+/**
+ * @brief Start streaming a ROM image from memory into the cart address space.
+ * 
+ * Data is staged in two buffers, one is transferred by the PI while the other is filled.
+ * Byte order conversion, checksum verification and progress reporting are shared with the file loader.
+ * 
+ * @param address Destination address.
+ * @param size Size of the ROM image.
+ * @param byte_order Byte order of the streamed data, converted to the native order on the fly.
+ * @param progress Progress callback function.
+ */
+void stream_load_begin (void *address, size_t size, flashcart_byte_order_t byte_order, flashcart_progress_callback_t *progress);
+
+/**
+ * @brief Append data to the streamed ROM image.
+ * 
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t stream_load_write (const void *data, size_t length);
+
+/**
+ * @brief Append data read from a file straight into the streamed ROM image.
+ * 
+ * @param fil Pointer to the file object, positioned at the data.
+ * @param length Length of the data.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t stream_load_read (FIL *fil, size_t length);
+
+/**
+ * @brief Finish streaming the ROM image.
+ * 
+ * @return flashcart_err_t Error code, the whole image must have been written.
+ */
+flashcart_err_t stream_load_end (void);
+
+/**
+ * @brief Limit the streaming loads to the meaningful data, the rest is filled on the cart side.
+ * 
+ * @param data_size Number of bytes read from the file, SIZE_MAX to disable the limit.
+ * @param fill Value used to fill the remaining space.
+ */
+void fatfs_set_load_data_size (size_t data_size, uint8_t fill);
+
+/**
+ * @brief Compute the ROM header checksum during the streaming loads.
+ * 
+ * @param verify Pointer to the verification structure, NULL to disable.
+ */
+void fatfs_set_load_verify (flashcart_rom_verify_t *verify);
+
+/**
+ * @brief Get the statistics of the last streaming load.
+ * 
+ * @return flashcart_load_stats_t* Pointer to the load statistics.
+ */
+flashcart_load_stats_t *fatfs_get_load_stats (void);
+
 #endif /* FLASHCART_UTILS_H__ */
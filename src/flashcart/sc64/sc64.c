@@ -7,11 +7,14 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <fatfs/ff.h>
 #include <libdragon.h>
 
 #include "utils/fs.h"
+#include "utils/trace.h"
 #include "utils/utils.h"
 
 #include "../flashcart_utils.h"
@@ -41,9 +44,14 @@
 #define DISK_TYPES                  (7)
 #define DISK_SYSTEM_LBA_COUNT       (24)
 
+#define DISK_THB_TABLE_SIZE         (DISK_TRACKS * DISK_HEADS * DISK_BLOCKS * sizeof(uint32_t))
+#define DISK_SECTOR_TABLE_SIZE      (DISK_MAX_SECTORS * sizeof(uint32_t))
+
 #define THB_UNMAPPED                (0xFFFFFFFF)
 #define THB_WRITABLE_FLAG           (1 << 31)
 
+#define FLASH_VERIFY_CHUNK_SIZE     (KiB(4))
+
 static const struct {
     uint8_t head;
     uint8_t sector_length;
@@ -80,9 +88,34 @@ static const uint8_t vzone_to_pzone[DISK_TYPES][DISK_ZONES] = {
 
 static const uint8_t rom_zones[DISK_TYPES] = { 5, 7, 9, 11, 13, 15, 16 };
 
+/**
+ * @brief Check if the flash memory already contains the provided data.
+ * 
+ * @param address Flash address to compare against.
+ * @param data Pointer to the data.
+ * @param size Size of the data.
+ * @return true if the flash contents match, false otherwise.
+ */
+static bool flash_contents_match (void *address, uint8_t *data, size_t size) {
+    uint8_t buffer[FLASH_VERIFY_CHUNK_SIZE] __attribute__((aligned(8)));
+
+    for (size_t offset = 0; offset < size; offset += FLASH_VERIFY_CHUNK_SIZE) {
+        size_t length = MIN(size - offset, FLASH_VERIFY_CHUNK_SIZE);
+        pi_dma_read_data(address + offset, buffer, length);
+        if (memcmp(buffer, data + offset, length) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /**
  * @brief Load data to flash memory.
  * 
+ * Blocks are read from the SD card into a staging buffer while the previous block
+ * is still being programmed. Blocks already matching the flash contents are skipped.
+ * 
  * @param fil Pointer to the file object.
  * @param address Address to load data to.
  * @param size Size of the data to load.
@@ -91,7 +124,9 @@ static const uint8_t rom_zones[DISK_TYPES] = { 5, 7, 9, 11, 13, 15, 16 };
  * @return flashcart_err_t Error code.
  */
 static flashcart_err_t load_to_flash (FIL *fil, void *address, size_t size, UINT *br, flashcart_progress_callback_t *progress) {
+    flashcart_err_t err = FLASHCART_OK;
     size_t erase_block_size;
+    uint8_t *buffer;
     UINT bp;
 
     *br = 0;
@@ -100,26 +135,50 @@ static flashcart_err_t load_to_flash (FIL *fil, void *address, size_t size, UINT
         return FLASHCART_ERR_INT;
     }
 
+    if ((buffer = memalign(8, erase_block_size)) == NULL) {
+        return FLASHCART_ERR_INT;
+    }
+
     while (size > 0) {
         size_t program_size = MIN(size, erase_block_size);
-        if (sc64_ll_flash_erase_block(address) != SC64_OK) {
-            return FLASHCART_ERR_INT;
-        }
-        if (f_read(fil, address, program_size, &bp) != FR_OK) {
-            return FLASHCART_ERR_LOAD;
+
+        // NOTE: Previous block is still being programmed at this point
+        if (f_read(fil, buffer, program_size, &bp) != FR_OK) {
+            err = FLASHCART_ERR_LOAD;
+            break;
         }
         if (sc64_ll_flash_wait_busy() != SC64_OK) {
-            return FLASHCART_ERR_INT;
+            err = FLASHCART_ERR_INT;
+            break;
         }
-        if (progress) {
-            progress(f_tell(fil) / (float) (f_size(fil)));
+
+        size_t write_size = ALIGN(bp, 2);
+
+        if ((write_size > 0) && !flash_contents_match(address, buffer, write_size)) {
+            if (sc64_ll_flash_erase_block(address) != SC64_OK) {
+                err = FLASHCART_ERR_INT;
+                break;
+            }
+            pi_dma_write_data(buffer, address, write_size);
         }
+
+        fatfs_load_progress(fil, progress, (f_tell(fil) == f_size(fil)));
         address += program_size;
         size -= program_size;
         *br += bp;
+
+        if (bp != program_size) {
+            break;
+        }
     }
 
-    return FLASHCART_OK;
+    if (sc64_ll_flash_wait_busy() != SC64_OK) {
+        err = FLASHCART_ERR_INT;
+    }
+
+    free(buffer);
+
+    return err;
 }
 
 /**
@@ -158,7 +217,7 @@ static bool disk_system_lba_is_bad (uint16_t lba, flashcart_disk_parameters_t *d
 /**
  * @brief Set the THB mapping for a disk.
  * 
- * @param offset Offset for the THB mapping.
+ * @param thb_table Pointer to the THB table.
  * @param track Track number.
  * @param head Head number.
  * @param block Block number.
@@ -166,21 +225,38 @@ static bool disk_system_lba_is_bad (uint16_t lba, flashcart_disk_parameters_t *d
  * @param writable Writable flag.
  * @param file_offset File offset.
  */
-static void disk_set_thb_mapping (uint32_t offset, uint16_t track, uint8_t head, uint8_t block, bool valid, bool writable, int file_offset) {
+static void disk_set_thb_mapping (uint32_t *thb_table, uint16_t track, uint8_t head, uint8_t block, bool valid, bool writable, int file_offset) {
     uint32_t index = (track << 2) | (head << 1) | (block);
     uint32_t mapping = valid ? ((writable ? THB_WRITABLE_FLAG : 0) | (file_offset & ~(THB_WRITABLE_FLAG))) : THB_UNMAPPED;
 
-    io_write(ROM_ADDRESS + offset + (index * sizeof(uint32_t)), mapping);
+    thb_table[index] = mapping;
 }
 
 /**
- * @brief Load the THB table for a disk.
+ * @brief Build the THB table for a disk.
+ * 
+ * The last built table is kept in memory, remounting a disk with the same type
+ * and defect information reuses it.
  * 
  * @param disk_parameters Pointer to the disk parameters.
- * @param thb_table_offset Pointer to store the THB table offset.
- * @param current_offset Pointer to the current offset.
+ * @return uint32_t* Pointer to the THB table, NULL if out of memory.
  */
-static void disk_load_thb_table (flashcart_disk_parameters_t *disk_parameters, uint32_t *thb_table_offset, uint32_t *current_offset) {
+static uint32_t *disk_build_thb_table (flashcart_disk_parameters_t *disk_parameters) {
+    static uint32_t *thb_table = NULL;
+    static flashcart_disk_parameters_t thb_table_parameters;
+
+    if (thb_table && (thb_table_parameters.disk_type == disk_parameters->disk_type) &&
+        (memcmp(thb_table_parameters.bad_system_area_lbas, disk_parameters->bad_system_area_lbas, sizeof(disk_parameters->bad_system_area_lbas)) == 0) &&
+        (memcmp(thb_table_parameters.defect_tracks, disk_parameters->defect_tracks, sizeof(disk_parameters->defect_tracks)) == 0)) {
+        return thb_table;
+    }
+
+    if (!thb_table && ((thb_table = memalign(8, DISK_THB_TABLE_SIZE)) == NULL)) {
+        return NULL;
+    }
+
+    memset(thb_table, 0xFF, DISK_THB_TABLE_SIZE);
+
     int file_offset = 0;
 
     uint16_t lba = 0;
@@ -202,15 +278,15 @@ static void disk_load_thb_table (flashcart_disk_parameters_t *disk_parameters, u
             uint16_t track = track_offset + zone_track;
 
             if (disk_zone_track_is_bad(pzone, zone_track, disk_parameters)) {
-                disk_set_thb_mapping(*current_offset, track, head, 0, false, false, 0);
-                disk_set_thb_mapping(*current_offset, track, head, 1, false, false, 0);
+                disk_set_thb_mapping(thb_table, track, head, 0, false, false, 0);
+                disk_set_thb_mapping(thb_table, track, head, 1, false, false, 0);
                 continue;
             }
 
             for (uint8_t block = 0; block < DISK_BLOCKS; block += 1) {
                 bool valid = !(disk_system_lba_is_bad(lba, disk_parameters));
                 bool writable = (vzone >= rom_zones[disk_parameters->disk_type]);
-                disk_set_thb_mapping(*current_offset, track, head, (starting_block ^ block), valid, writable, file_offset);
+                disk_set_thb_mapping(thb_table, track, head, (starting_block ^ block), valid, writable, file_offset);
                 file_offset += (sector_length * DISK_SECTORS_PER_BLOCK);
                 lba += 1;
             }
@@ -219,8 +295,32 @@ static void disk_load_thb_table (flashcart_disk_parameters_t *disk_parameters, u
         }
     }
 
+    thb_table_parameters = *disk_parameters;
+
+    return thb_table;
+}
+
+/**
+ * @brief Load the THB table for a disk.
+ * 
+ * @param disk_parameters Pointer to the disk parameters.
+ * @param thb_table_offset Pointer to store the THB table offset.
+ * @param current_offset Pointer to the current offset.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool disk_load_thb_table (flashcart_disk_parameters_t *disk_parameters, uint32_t *thb_table_offset, uint32_t *current_offset) {
+    uint32_t *thb_table = disk_build_thb_table(disk_parameters);
+
+    if (thb_table == NULL) {
+        return true;
+    }
+
+    pi_dma_write_data(thb_table, (void *) (ROM_ADDRESS + *current_offset), DISK_THB_TABLE_SIZE);
+
     *thb_table_offset = *current_offset;
-    *current_offset += (DISK_TRACKS * DISK_HEADS * DISK_BLOCKS * sizeof(uint32_t));
+    *current_offset += DISK_THB_TABLE_SIZE;
+
+    return false;
 }
 
 /**
@@ -232,12 +332,25 @@ static void disk_load_thb_table (flashcart_disk_parameters_t *disk_parameters, u
  * @return true if an error occurred, false otherwise.
  */
 static bool disk_load_sector_table (char *path, uint32_t *sector_table_offset, uint32_t *current_offset) {
-    if (fatfs_get_file_sectors(path, (uint32_t *) (ROM_ADDRESS + *current_offset), ADDRESS_TYPE_PI, DISK_MAX_SECTORS)) {
+    uint32_t *sector_table = memalign(8, DISK_SECTOR_TABLE_SIZE);
+
+    if (sector_table == NULL) {
         return true;
     }
 
+    memset(sector_table, 0, DISK_SECTOR_TABLE_SIZE);
+
+    if (fatfs_get_file_sectors(path, sector_table, ADDRESS_TYPE_MEM, DISK_MAX_SECTORS)) {
+        free(sector_table);
+        return true;
+    }
+
+    pi_dma_write_data(sector_table, (void *) (ROM_ADDRESS + *current_offset), DISK_SECTOR_TABLE_SIZE);
+
+    free(sector_table);
+
     *sector_table_offset = *current_offset;
-    *current_offset += (DISK_MAX_SECTORS * sizeof(uint32_t));
+    *current_offset += DISK_SECTOR_TABLE_SIZE;
 
     return false;
 }
@@ -377,16 +490,18 @@ static flashcart_err_t sc64_load_rom (char *rom_path, flashcart_progress_callbac
     size_t shadow_size = shadow_enabled ? MIN(rom_size - sdram_size, KiB(128)) : 0;
     size_t extended_size = extended_enabled ? rom_size - MiB(64) : 0;
 
-    size_t chunk_size = KiB(128);
-    for (unsigned int offset = 0; offset < sdram_size; offset += chunk_size) {
-        size_t block_size = MIN(sdram_size - offset, chunk_size);
-        if (f_read(&fil, (void *) (ROM_ADDRESS + offset), block_size, &br) != FR_OK) {
-            f_close(&fil);
-            return FLASHCART_ERR_LOAD;
-        }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
-        }
+    // NOTE: SD to SDRAM transfers are executed by the cart without CPU intervention and RDP renders
+    //       the progress frame asynchronously after it's submitted, so the only remaining stall
+    //       is the CPU time spent building a frame. Frames are therefore produced at a fixed rate
+    //       instead of after every chunk, keeping the SD card busy for almost all of the load time.
+    trace_phase_begin("SDRAM transfer");
+    fatfs_load_begin(FLASHCART_LOAD_CHUNK_SIZE);
+    flashcart_err_t load_err = fatfs_load_chunked(&fil, (void *) (ROM_ADDRESS), sdram_size, FLASHCART_LOAD_CHUNK_SIZE, progress);
+    fatfs_load_end();
+    trace_phase_end();
+    if (load_err != FLASHCART_OK) {
+        f_close(&fil);
+        return load_err;
     }
     if (f_tell(&fil) != sdram_size) {
         f_close(&fil);
@@ -399,7 +514,9 @@ static flashcart_err_t sc64_load_rom (char *rom_path, flashcart_progress_callbac
     }
 
     if (shadow_enabled) {
+        trace_phase_begin("Shadow flash programming");
         flashcart_err_t err = load_to_flash(&fil, (void *) (SHADOW_ADDRESS), shadow_size, &br, progress);
+        trace_phase_end();
         if (err != FLASHCART_OK) {
             f_close(&fil);
             return err;
@@ -416,7 +533,9 @@ static flashcart_err_t sc64_load_rom (char *rom_path, flashcart_progress_callbac
     }
 
     if (extended_enabled) {
+        trace_phase_begin("Extended flash programming");
         flashcart_err_t err = load_to_flash(&fil, (void *) (EXTENDED_ADDRESS), extended_size, &br, progress);
+        trace_phase_end();
         if (err != FLASHCART_OK) {
             f_close(&fil);
             return err;
@@ -532,54 +651,20 @@ static flashcart_err_t sc64_load_save (char *save_path) {
 }
 
 static flashcart_err_t sc64_load_64dd_ipl (char *ipl_path, flashcart_progress_callback_t *progress) {
-    FIL fil;
-    UINT br;
-
-    if (f_open(&fil, strip_fs_prefix(ipl_path), FA_READ) != FR_OK) {
-        return FLASHCART_ERR_LOAD;
-    }
-
-    fatfs_fix_file_size(&fil);
-
-    size_t ipl_size = f_size(&fil);
-
-    if (ipl_size > MiB(4)) {
-        f_close(&fil);
-        return FLASHCART_ERR_LOAD;
-    }
-
-    size_t chunk_size = KiB(128);
-    for (unsigned int offset = 0; offset < ipl_size; offset += chunk_size) {
-        size_t block_size = MIN(ipl_size - offset, chunk_size);
-        if (f_read(&fil, (void *) (IPL_ADDRESS + offset), block_size, &br) != FR_OK) {
-            f_close(&fil);
-            return FLASHCART_ERR_LOAD;
-        }
-        if (progress) {
-            progress(f_tell(&fil) / (float) (f_size(&fil)));
-        }
-    }
-    if (f_tell(&fil) != ipl_size) {
-        f_close(&fil);
-        return FLASHCART_ERR_LOAD;
-    }
-
-    if (f_close(&fil) != FR_OK) {
-        return FLASHCART_ERR_LOAD;
-    }
-
-    return FLASHCART_OK;
+    return fatfs_load_file(ipl_path, (void *) (IPL_ADDRESS), MiB(4), FLASHCART_LOAD_CHUNK_SIZE, progress);
 }
 
-static flashcart_err_t sc64_load_64dd_disk (char *disk_path, flashcart_disk_parameters_t *disk_parameters) {
+static flashcart_err_t sc64_load_64dd_disk (char *disk_paths[], flashcart_disk_parameters_t *disk_parameters, int disk_count) {
     sc64_disk_mapping_t mapping;
     uint32_t mapping_offset = DISK_MAPPING_ROM_OFFSET;
     sc64_drive_type_t drive_type = (disk_parameters->development_drive ? DRIVE_TYPE_DEVELOPMENT : DRIVE_TYPE_RETAIL);
 
-    // TODO: Support loading multiple disks
-    for (mapping.count = 0; mapping.count < 1; mapping.count++) {
-        disk_load_thb_table(disk_parameters++, &mapping.disks[mapping.count].thb_table, &mapping_offset);
-        if (disk_load_sector_table(disk_path++, &mapping.disks[mapping.count].sector_table, &mapping_offset)) {
+    // NOTE: Tables for every disk in the set are prepared upfront, firmware disk swap only switches between them
+    for (mapping.count = 0; mapping.count < MIN(disk_count, FLASHCART_64DD_MAX_DISKS); mapping.count++) {
+        if (disk_load_thb_table(&disk_parameters[mapping.count], &mapping.disks[mapping.count].thb_table, &mapping_offset)) {
+            return FLASHCART_ERR_LOAD;
+        }
+        if (disk_load_sector_table(disk_paths[mapping.count], &mapping.disks[mapping.count].sector_table, &mapping_offset)) {
             return FLASHCART_ERR_LOAD;
         }
     }
@@ -654,7 +739,7 @@ static flashcart_err_t sc64_set_save_type (flashcart_save_type_t save_type) {
 static flashcart_err_t sc64_set_save_writeback (char *save_path) {
     uint32_t sectors[SAVE_WRITEBACK_MAX_SECTORS] __attribute__((aligned(8)));
 
-    if (fatfs_get_file_sectors(save_path, sectors, ADDRESS_TYPE_MEM, SAVE_WRITEBACK_MAX_SECTORS)) {
+    if (fatfs_get_save_sectors(save_path, sectors, SAVE_WRITEBACK_MAX_SECTORS)) {
         return FLASHCART_ERR_LOAD;
     }
 
@@ -0,0 +1,281 @@
+/**
+ * @file sim.c
+ * @brief Simulated flashcart functions implementation
+ * @ingroup flashcart
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdragon.h>
+#include <mini.c/src/mini.h>
+
+#include "utils/utils.h"
+
+#include "../flashcart_utils.h"
+#include "sim.h"
+
+// NOTE: The simulated cart has no writable SDRAM, data is read into this buffer and dropped
+#define SIM_CHUNK_SIZE          (FLASHCART_LOAD_CHUNK_SIZE)
+#define SIM_MAX_ROM_SIZE        (MiB(64))
+
+static const char *parameters_paths[] = {
+    "sd:/menu/sim.ini",
+    "rom:/sim.ini",
+};
+
+static sim_parameters_t parameters;
+static flashcart_save_type_t current_save_type;
+static void *chunk_buffer;
+
+
+/**
+ * @brief Get the modelled duration of a transfer.
+ *
+ * @param length Length of the transfer.
+ * @param kbps Bandwidth in KiB/s, 0 for an unlimited bandwidth.
+ * @param latency_us Latency of the transfer in microseconds.
+ * @return uint64_t Duration in microseconds.
+ */
+static uint64_t model_us (size_t length, uint32_t kbps, uint32_t latency_us) {
+    uint64_t us = latency_us;
+
+    if (kbps > 0) {
+        us += ((length * 1000000ULL) / (kbps * 1024ULL));
+    }
+
+    return us;
+}
+
+/**
+ * @brief Wait until the modelled duration of an operation has passed.
+ *
+ * @param start_us Start time of the operation in microseconds.
+ * @param duration_us Modelled duration in microseconds, time already spent is deducted.
+ */
+static void wait_until (uint64_t start_us, uint64_t duration_us) {
+    while ((get_ticks_us() - start_us) < duration_us);
+}
+
+static void load_parameters (void) {
+    parameters = (sim_parameters_t) {
+        .sd_read_kbps = 8192,
+        .sd_access_us = 500,
+        .pi_dma_kbps = 5120,
+        .pi_dma_latency_us = 20,
+        .flash_erase_ms = 400,
+        .flash_erase_block_size = KiB(128),
+        .usb_kbps = 0,
+    };
+
+    for (int i = 0; i < sizeof(parameters_paths) / sizeof(parameters_paths[0]); i++) {
+        FILE *f = fopen(parameters_paths[i], "r");
+        if (f == NULL) {
+            continue;
+        }
+        fclose(f);
+
+        mini_t *ini = mini_try_load(parameters_paths[i]);
+        parameters.sd_read_kbps = mini_get_int(ini, "sd", "read_kbps", parameters.sd_read_kbps);
+        parameters.sd_access_us = mini_get_int(ini, "sd", "access_us", parameters.sd_access_us);
+        parameters.pi_dma_kbps = mini_get_int(ini, "pi", "dma_kbps", parameters.pi_dma_kbps);
+        parameters.pi_dma_latency_us = mini_get_int(ini, "pi", "dma_latency_us", parameters.pi_dma_latency_us);
+        parameters.flash_erase_ms = mini_get_int(ini, "flash", "erase_ms", parameters.flash_erase_ms);
+        parameters.flash_erase_block_size = mini_get_int(ini, "flash", "erase_block_size", parameters.flash_erase_block_size);
+        parameters.usb_kbps = mini_get_int(ini, "usb", "kbps", parameters.usb_kbps);
+        mini_free(ini);
+
+        debugf("Simulated flashcart: Parameters loaded from %s\n", parameters_paths[i]);
+        break;
+    }
+
+    if (parameters.flash_erase_block_size == 0) {
+        parameters.flash_erase_block_size = KiB(128);
+    }
+}
+
+/**
+ * @brief Read a file in chunks, timing every chunk as a SD card read followed by a PI DMA transfer.
+ *
+ * @param path Path to the file.
+ * @param file_offset Offset of the data in the file.
+ * @param max_size Maximum number of bytes to transfer.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+static flashcart_err_t sim_transfer_file (char *path, uint32_t file_offset, size_t max_size, flashcart_progress_callback_t *progress) {
+    flashcart_load_stats_t *stats = fatfs_get_load_stats();
+    uint64_t transfer_start = get_ticks_us();
+
+    *stats = (flashcart_load_stats_t) { .chunk_size = SIM_CHUNK_SIZE, .chunk_min_us = UINT32_MAX };
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+
+    if ((file_size < 0) || (file_offset > file_size) || fseek(f, file_offset, SEEK_SET)) {
+        fclose(f);
+        return FLASHCART_ERR_LOAD;
+    }
+
+    size_t size = MIN((size_t) (file_size - file_offset), max_size);
+
+    wait_until(get_ticks_us(), parameters.sd_access_us);
+
+    for (size_t offset = 0; offset < size; offset += SIM_CHUNK_SIZE) {
+        size_t length = MIN(size - offset, SIM_CHUNK_SIZE);
+        uint64_t chunk_start = get_ticks_us();
+
+        if (fread(chunk_buffer, 1, length, f) != length) {
+            fclose(f);
+            return FLASHCART_ERR_LOAD;
+        }
+
+        wait_until(chunk_start, model_us(length, parameters.sd_read_kbps, 0) + model_us(length, parameters.pi_dma_kbps, parameters.pi_dma_latency_us));
+
+        uint32_t chunk_us = (uint32_t) (get_ticks_us() - chunk_start);
+        stats->bytes += length;
+        stats->chunks += 1;
+        stats->chunk_min_us = MIN(stats->chunk_min_us, chunk_us);
+        stats->chunk_max_us = MAX(stats->chunk_max_us, chunk_us);
+
+        if (progress) {
+            uint64_t stall_start = get_ticks_us();
+            progress((float) (offset + length) / size);
+            stats->stall_us += (get_ticks_us() - stall_start);
+        }
+    }
+
+    fclose(f);
+
+    if (stats->chunks == 0) {
+        stats->chunk_min_us = 0;
+    }
+    stats->total_us = (get_ticks_us() - transfer_start);
+
+    return FLASHCART_OK;
+}
+
+static flashcart_err_t sim_init (void) {
+    load_parameters();
+
+    current_save_type = FLASHCART_SAVE_TYPE_NONE;
+
+    if (chunk_buffer == NULL) {
+        chunk_buffer = malloc(SIM_CHUNK_SIZE);
+        if (chunk_buffer == NULL) {
+            return FLASHCART_ERR_INT;
+        }
+    }
+
+    debugf(
+        "Simulated flashcart: SD %lu KiB/s %lu us, PI %lu KiB/s %lu us, flash erase %lu ms / %lu B, USB %lu KiB/s\n",
+        parameters.sd_read_kbps, parameters.sd_access_us,
+        parameters.pi_dma_kbps, parameters.pi_dma_latency_us,
+        parameters.flash_erase_ms, parameters.flash_erase_block_size,
+        parameters.usb_kbps
+    );
+
+    return FLASHCART_OK;
+}
+
+static flashcart_err_t sim_deinit (void) {
+    free(chunk_buffer);
+    chunk_buffer = NULL;
+
+    return FLASHCART_OK;
+}
+
+static bool sim_has_feature (flashcart_features_t feature) {
+    switch (feature) {
+        case FLASHCART_FEATURE_USB: return (parameters.usb_kbps > 0);
+        case FLASHCART_FEATURE_SAVE_WRITEBACK: return true;
+        default: return false;
+    }
+}
+
+static flashcart_firmware_version_t sim_get_firmware_version (void) {
+    return (flashcart_firmware_version_t) { .major = 0, .minor = 0, .revision = 0 };
+}
+
+static flashcart_err_t sim_load_rom (char *rom_path, flashcart_progress_callback_t *progress) {
+    return sim_transfer_file(rom_path, 0, SIM_MAX_ROM_SIZE, progress);
+}
+
+static flashcart_err_t sim_load_file (char *file_path, uint32_t rom_offset, uint32_t file_offset) {
+    if (rom_offset >= SIM_MAX_ROM_SIZE) {
+        return FLASHCART_ERR_ARGS;
+    }
+
+    return sim_transfer_file(file_path, file_offset, SIM_MAX_ROM_SIZE - rom_offset, NULL);
+}
+
+static flashcart_err_t sim_load_save (char *save_path) {
+    FILE *f = fopen(save_path, "rb");
+    if (f == NULL) {
+        return FLASHCART_ERR_LOAD;
+    }
+    fseek(f, 0, SEEK_END);
+    long save_size = ftell(f);
+    fclose(f);
+
+    if (save_size < 0) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    // NOTE: FlashRAM saves are kept in flash memory, it must be erased before the save data is programmed
+    if ((current_save_type == FLASHCART_SAVE_TYPE_FLASHRAM_1MBIT) || (current_save_type == FLASHCART_SAVE_TYPE_FLASHRAM_PKST2)) {
+        uint32_t blocks = ((save_size + parameters.flash_erase_block_size - 1) / parameters.flash_erase_block_size);
+        wait_until(get_ticks_us(), blocks * parameters.flash_erase_ms * 1000ULL);
+    }
+
+    return sim_transfer_file(save_path, 0, save_size, NULL);
+}
+
+static flashcart_err_t sim_set_save_type (flashcart_save_type_t save_type) {
+    current_save_type = save_type;
+
+    return FLASHCART_OK;
+}
+
+static flashcart_err_t sim_set_save_writeback (char *save_path) {
+    return FLASHCART_OK;
+}
+
+static flashcart_err_t sim_set_next_boot_mode (flashcart_reboot_mode_t boot_mode) {
+    return FLASHCART_OK;
+}
+
+
+static flashcart_t flashcart_sim = {
+    .init = sim_init,
+    .deinit = sim_deinit,
+    .has_feature = sim_has_feature,
+    .get_firmware_version = sim_get_firmware_version,
+    .load_rom = sim_load_rom,
+    .load_file = sim_load_file,
+    .load_save = sim_load_save,
+    .load_64dd_ipl = NULL,
+    .load_64dd_disk = NULL,
+    .set_save_type = sim_set_save_type,
+    .set_save_writeback = sim_set_save_writeback,
+    .set_next_boot_mode = sim_set_next_boot_mode,
+};
+
+
+flashcart_t *sim_get_flashcart (void) {
+    return &flashcart_sim;
+}
+
+sim_parameters_t *sim_get_parameters (void) {
+    return &parameters;
+}
+
+void sim_usb_transfer (size_t length, uint64_t start_us) {
+    wait_until(start_us, model_us(length, parameters.usb_kbps, 0));
+}
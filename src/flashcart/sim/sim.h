@@ -0,0 +1,50 @@
+/**
+ * @file sim.h
+ * @brief Simulated flashcart support
+ * @ingroup flashcart
+ */
+
+#ifndef FLASHCART_SIM_H__
+#define FLASHCART_SIM_H__
+
+
+#include "../flashcart.h"
+
+
+/**
+ * @addtogroup sim
+ * @{
+ */
+
+/** @brief Simulated flashcart timing parameters Structure. */
+typedef struct {
+    uint32_t sd_read_kbps; /**< SD card read bandwidth in KiB/s */
+    uint32_t sd_access_us; /**< SD card latency of every file access in microseconds */
+    uint32_t pi_dma_kbps; /**< PI DMA bandwidth in KiB/s */
+    uint32_t pi_dma_latency_us; /**< PI DMA latency of every transfer in microseconds */
+    uint32_t flash_erase_ms; /**< Flash erase time of every erase block in milliseconds */
+    uint32_t flash_erase_block_size; /**< Flash erase block size in bytes */
+    uint32_t usb_kbps; /**< USB bandwidth in KiB/s */
+} sim_parameters_t;
+
+flashcart_t *sim_get_flashcart (void);
+
+/**
+ * @brief Get the timing parameters of the simulated flashcart.
+ *
+ * @return sim_parameters_t* Pointer to the parameters, changes apply to the next operations.
+ */
+sim_parameters_t *sim_get_parameters (void);
+
+/**
+ * @brief Wait for the modelled duration of a USB transfer.
+ *
+ * @param length Length of the transfer, the time already spent on the transfer is deducted.
+ * @param start_us Start time of the transfer in microseconds.
+ */
+void sim_usb_transfer (size_t length, uint64_t start_us);
+
+/** @} */ /* sim */
+
+
+#endif
@@ -1,13 +1,28 @@
 #include <libdragon.h>
 
 #include "actions.h"
+#include "utils/utils.h"
 
 
-#define ACTIONS_REPEAT_DELAY    (8)
+#define ACTIONS_REPEAT_DELAY_US             (266000)
+#define ACTIONS_REPEAT_INTERVAL_US          (30000)
+#define ACTIONS_ACCELERATION_REPEATS        (12)
+#define ACTIONS_ACCELERATION_MAX_STEPS      (8)
 
 
-static int dir_repeat_delay;
+static uint64_t dir_repeat_us;
+static int dir_repeats;
 static joypad_8way_t last_dir = JOYPAD_8WAY_NONE;
+static bool c_combo_held;
+static uint64_t input_us;
+static uint64_t sample_us;
+
+
+static void input_event (void) {
+    if (input_us == 0) {
+        input_us = sample_us;
+    }
+}
 
 
 static void actions_clear (menu_t *menu) {
@@ -16,26 +31,43 @@ static void actions_clear (menu_t *menu) {
     menu->actions.go_left = false;
     menu->actions.go_right = false;
     menu->actions.go_fast = false;
+    menu->actions.steps = 1;
 
     menu->actions.enter = false;
     menu->actions.back = false;
     menu->actions.options = false;
     menu->actions.settings = false;
     menu->actions.lz_context = false;
+    menu->actions.perf_hud = false;
+
+    input_us = 0;
 }
 
 static void actions_update_direction (menu_t *menu) {
     joypad_8way_t held_dir = JOYPAD_8WAY_NONE;
     joypad_8way_t fast_dir = JOYPAD_8WAY_NONE;
+    joypad_buttons_t held = {0};
 
     JOYPAD_PORT_FOREACH (i) {
         held_dir = joypad_get_direction(i, JOYPAD_2D_DPAD | JOYPAD_2D_STICK);
         fast_dir = joypad_get_direction(i, JOYPAD_2D_C);
-        if (held_dir != JOYPAD_8WAY_NONE || fast_dir != JOYPAD_8WAY_NONE) {
+        held = joypad_get_buttons_held(i);
+        if (held_dir != JOYPAD_8WAY_NONE || fast_dir != JOYPAD_8WAY_NONE || held.c_left || held.c_right) {
             break;
         }
     }
 
+    // NOTE: Once C-Left and C-Right are held together for the overlay combo, the C buttons move nothing until both are released
+    if (held.c_left && held.c_right) {
+        c_combo_held = true;
+    } else if (!held.c_left && !held.c_right) {
+        c_combo_held = false;
+    }
+
+    if (c_combo_held) {
+        fast_dir = JOYPAD_8WAY_NONE;
+    }
+
     if (fast_dir != JOYPAD_8WAY_NONE) {
         held_dir = fast_dir;
         menu->actions.go_fast = true;
@@ -43,10 +75,24 @@ static void actions_update_direction (menu_t *menu) {
 
     joypad_8way_t final_dir = held_dir;
 
-    if ((last_dir != held_dir) && (last_dir == JOYPAD_8WAY_NONE)) {
-        dir_repeat_delay = ACTIONS_REPEAT_DELAY;
-    } else if (dir_repeat_delay > 0) {
+    // NOTE: The repeat is timed rather than counted, so sampling the input again before a frame doesn't speed it up
+    if (held_dir == JOYPAD_8WAY_NONE) {
+        dir_repeats = 0;
+    } else if ((last_dir != held_dir) && (last_dir == JOYPAD_8WAY_NONE)) {
+        dir_repeat_us = sample_us + ACTIONS_REPEAT_DELAY_US;
+        dir_repeats = 0;
+    } else if (sample_us < dir_repeat_us) {
         final_dir = JOYPAD_8WAY_NONE;
+    } else {
+        dir_repeat_us = sample_us + ACTIONS_REPEAT_INTERVAL_US;
+        dir_repeats += 1;
+        if (menu->settings.scroll_acceleration_enabled) {
+            menu->actions.steps = MIN(1 << (dir_repeats / ACTIONS_ACCELERATION_REPEATS), ACTIONS_ACCELERATION_MAX_STEPS);
+        }
+    }
+
+    if (final_dir != JOYPAD_8WAY_NONE) {
+        input_event();
     }
 
     switch (final_dir) {
@@ -82,24 +128,25 @@ static void actions_update_direction (menu_t *menu) {
             break;
     }
 
-    if (dir_repeat_delay > 0) {
-        dir_repeat_delay -= 1;
-    }
-
     last_dir = held_dir;
 }
 
 static void actions_update_buttons (menu_t *menu) {    
     joypad_buttons_t pressed = {0};
+    joypad_buttons_t held = {0};
 
     JOYPAD_PORT_FOREACH (i) {
         pressed = joypad_get_buttons_pressed(i);
+        held = joypad_get_buttons_held(i);
         if (pressed.raw) {
             break;
         }
     }
 
-    if (pressed.a) {
+    // NOTE: The C directions are suppressed while the combo is held, so it adds no fast move or letter jump
+    if (held.c_left && held.c_right && (pressed.c_left || pressed.c_right)) {
+        menu->actions.perf_hud = true;
+    } else if (pressed.a) {
         menu->actions.enter = true;
     } else if (pressed.b) {
         menu->actions.back = true;
@@ -110,6 +157,18 @@ static void actions_update_buttons (menu_t *menu) {
     } else if (pressed.l || pressed.z) {
         menu->actions.lz_context = true;
     }
+
+    if (pressed.raw) {
+        input_event();
+    }
+}
+
+static void actions_sample (menu_t *menu) {
+    joypad_poll();
+    sample_us = get_ticks_us();
+
+    actions_update_direction(menu);
+    actions_update_buttons(menu);
 }
 
 
@@ -120,9 +179,29 @@ void actions_init (void) {
 }
 
 void actions_update (menu_t *menu) {
-    joypad_poll();
-
     actions_clear(menu);
-    actions_update_direction(menu);
-    actions_update_buttons(menu);
+    actions_sample(menu);
+}
+
+void actions_latch (menu_t *menu) {
+    actions_sample(menu);
+}
+
+uint64_t actions_get_input_time (void) {
+    return input_us;
+}
+
+bool actions_any (menu_t *menu) {
+    return (
+        menu->actions.go_up ||
+        menu->actions.go_down ||
+        menu->actions.go_left ||
+        menu->actions.go_right ||
+        menu->actions.enter ||
+        menu->actions.back ||
+        menu->actions.options ||
+        menu->actions.settings ||
+        menu->actions.lz_context ||
+        menu->actions.perf_hud
+    );
 }
@@ -7,6 +7,8 @@
 #ifndef ACTIONS_H__
 #define ACTIONS_H__
 
+#include <stdint.h>
+
 #include "menu_state.h"
 
 /**
@@ -21,4 +23,28 @@ void actions_init (void);
  */
 void actions_update (menu_t *menu);
 
+/**
+ * @brief Check if any action is active.
+ * 
+ * @param menu Pointer to the menu structure.
+ * @return true if any action is active, false otherwise.
+ */
+bool actions_any (menu_t *menu);
+
+/**
+ * @brief Sample the input again, adding the actions since the last sample to the current ones.
+ *
+ * Used right before a frame is laid out, when the actions were sampled earlier to decide whether to redraw.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+void actions_latch (menu_t *menu);
+
+/**
+ * @brief Get the time the first input of the current actions was sampled.
+ *
+ * @return uint64_t Time in microseconds, 0 if the current actions have no input.
+ */
+uint64_t actions_get_input_time (void);
+
 #endif /* ACTIONS_H__ */
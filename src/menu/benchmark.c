@@ -0,0 +1,477 @@
+/**
+ * @file benchmark.c
+ * @brief On-device benchmarks implementation
+ * @ingroup menu
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
+#include <libdragon.h>
+
+#include "benchmark.h"
+#include "file_types.h"
+#include "flashcart/flashcart.h"
+#include "flashcart/flashcart_utils.h"
+#include "mp3_player.h"
+#include "path.h"
+#include "png_decoder.h"
+#include "search_index.h"
+#include "utils/cpakfs_utils.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
+
+#define MP3_FRAMES_DEFAULT      (1000)
+#define PNG_SIZE_MAX            (640)
+#define CPAK_BANK_SIZE          KiB(32)
+#define SD_RANDOM_READS         (256)
+#define SD_RANDOM_READ_SIZE     KiB(4)
+#define PI_ROM_ADDRESS          (0x10000000)
+#define PI_CHUNK_SIZE           KiB(64)
+#define PI_SIZE_DEFAULT         (1024)
+#define PI_SIZE_MAX             (16 * 1024)
+#define SEARCH_STEP_US          (100000)
+#define ROM_MAGIC_BIG_ENDIAN    (0x80371240)
+#define ROM_MAGIC_BYTE_SWAPPED  (0x37804012)
+#define ROM_MAGIC_LITTLE_ENDIAN (0x40123780)
+
+/** @brief Benchmark definition structure. */
+typedef struct {
+    const char *name; /**< Benchmark name */
+    const char *argument; /**< Argument description */
+    bool path; /**< The argument is a path relative to the storage root */
+    benchmark_err_t (*run) (char *argument, benchmark_result_t *result); /**< Benchmark operation */
+} benchmark_t;
+
+/** @brief PNG decode benchmark state structure. */
+typedef struct {
+    bool done; /**< The decoder called back */
+    png_err_t err; /**< Decoding result */
+} png_benchmark_t;
+
+
+static bool sd_read_chunk (void *buffer, size_t offset, size_t length, void *arg) {
+    ((benchmark_result_t *) (arg))->bytes += length;
+    return false;
+}
+
+/**
+ * @brief Read a whole file sequentially.
+ *
+ * @param argument Path to the file.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_sd_read (char *argument, benchmark_result_t *result) {
+    if (file_read_stream(argument, FS_IO_BUFFER_SIZE, sd_read_chunk, result, NULL)) {
+        return BENCHMARK_ERR_IO;
+    }
+
+    result->items = 1;
+
+    return BENCHMARK_OK;
+}
+
+/**
+ * @brief Read sectors at random offsets of a file, the way the save and disk accesses do.
+ *
+ * @param argument Path to the file.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_sd_random_read (char *argument, benchmark_result_t *result) {
+    FIL fil;
+    UINT br;
+
+    if (f_open(&fil, strip_fs_prefix(argument), FA_READ) != FR_OK) {
+        return BENCHMARK_ERR_ARGUMENT;
+    }
+
+    size_t blocks = (f_size(&fil) / SD_RANDOM_READ_SIZE);
+    if (blocks == 0) {
+        f_close(&fil);
+        return BENCHMARK_ERR_ARGUMENT;
+    }
+
+    uint8_t *buffer = malloc(SD_RANDOM_READ_SIZE);
+    if (buffer == NULL) {
+        f_close(&fil);
+        return BENCHMARK_ERR_OUT_OF_MEM;
+    }
+
+    benchmark_err_t err = BENCHMARK_OK;
+    uint32_t seed = 1;
+
+    // NOTE: A fixed seed keeps the offsets the same between runs, so the results stay comparable
+    for (int i = 0; i < SD_RANDOM_READS; i++) {
+        seed = (seed * 1664525) + 1013904223;
+        FSIZE_t offset = (FSIZE_t) ((seed >> 8) % blocks) * SD_RANDOM_READ_SIZE;
+
+        if ((f_lseek(&fil, offset) != FR_OK) || (f_read(&fil, buffer, SD_RANDOM_READ_SIZE, &br) != FR_OK) || (br != SD_RANDOM_READ_SIZE)) {
+            err = BENCHMARK_ERR_IO;
+            break;
+        }
+
+        result->bytes += SD_RANDOM_READ_SIZE;
+        result->items += 1;
+    }
+
+    free(buffer);
+    f_close(&fil);
+
+    return err;
+}
+
+/**
+ * @brief Parse the PI transfer size argument.
+ *
+ * @param argument Transfer size in KiB, the default size is used when empty.
+ * @param size Pointer to store the transfer size in bytes.
+ * @return true if the argument is invalid, false otherwise.
+ */
+static bool pi_get_size (char *argument, size_t *size) {
+    int kib = (argument[0] != '\0') ? atoi(argument) : PI_SIZE_DEFAULT;
+
+    if ((kib <= 0) || (kib > PI_SIZE_MAX)) {
+        return true;
+    }
+
+    *size = ALIGN((size_t) (KiB(kib)), PI_CHUNK_SIZE);
+
+    return false;
+}
+
+/**
+ * @brief Read the start of the cart ROM area over the PI.
+ *
+ * @param argument Transfer size in KiB.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_pi_read (char *argument, benchmark_result_t *result) {
+    size_t size;
+
+    if (pi_get_size(argument, &size)) {
+        return BENCHMARK_ERR_ARGUMENT;
+    }
+
+    uint8_t *buffer = malloc(PI_CHUNK_SIZE);
+    if (buffer == NULL) {
+        return BENCHMARK_ERR_OUT_OF_MEM;
+    }
+
+    for (size_t offset = 0; offset < size; offset += PI_CHUNK_SIZE) {
+        pi_dma_read_data((void *) (PI_ROM_ADDRESS + offset), buffer, PI_CHUNK_SIZE);
+        result->bytes += PI_CHUNK_SIZE;
+        result->items += 1;
+    }
+
+    free(buffer);
+
+    return BENCHMARK_OK;
+}
+
+/**
+ * @brief Write the start of the cart ROM area over the PI, with the data it already holds.
+ *
+ * The menu ROM is left unchanged, carts with a write protected ROM area ignore the writes.
+ *
+ * @param argument Transfer size in KiB.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_pi_write (char *argument, benchmark_result_t *result) {
+    size_t size;
+
+    if (pi_get_size(argument, &size)) {
+        return BENCHMARK_ERR_ARGUMENT;
+    }
+
+    uint8_t *buffer = malloc(PI_CHUNK_SIZE);
+    if (buffer == NULL) {
+        return BENCHMARK_ERR_OUT_OF_MEM;
+    }
+
+    for (size_t offset = 0; offset < size; offset += PI_CHUNK_SIZE) {
+        void *address = (void *) (PI_ROM_ADDRESS + offset);
+        pi_dma_read_data(address, buffer, PI_CHUNK_SIZE);
+
+        uint64_t start = get_ticks_us();
+        pi_dma_write_data(buffer, address, PI_CHUNK_SIZE);
+        result->work_us += (get_ticks_us() - start);
+
+        result->bytes += PI_CHUNK_SIZE;
+        result->items += 1;
+    }
+
+    free(buffer);
+
+    return BENCHMARK_OK;
+}
+
+/**
+ * @brief Load a ROM into the cart SDRAM, overwriting the menu ROM.
+ *
+ * @param argument Path to the ROM file.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_rom_load (char *argument, benchmark_result_t *result) {
+    uint32_t magic;
+    flashcart_byte_order_t byte_order;
+
+    if (file_read_range(argument, 0, &magic, sizeof(magic))) {
+        return BENCHMARK_ERR_IO;
+    }
+
+    switch (magic) {
+        case ROM_MAGIC_BIG_ENDIAN: byte_order = FLASHCART_BYTE_ORDER_BIG_ENDIAN; break;
+        case ROM_MAGIC_BYTE_SWAPPED: byte_order = FLASHCART_BYTE_ORDER_BYTE_SWAPPED; break;
+        case ROM_MAGIC_LITTLE_ENDIAN: byte_order = FLASHCART_BYTE_ORDER_LITTLE_ENDIAN; break;
+        default: return BENCHMARK_ERR_ARGUMENT;
+    }
+
+    result->rom_overwritten = true;
+
+    if (flashcart_load_rom(argument, byte_order, NULL) != FLASHCART_OK) {
+        return BENCHMARK_ERR_IO;
+    }
+
+    result->bytes = file_get_size(argument);
+    result->items = 1;
+
+    return BENCHMARK_OK;
+}
+
+static void png_decode_callback (png_err_t err, surface_t *decoded_image, void *callback_data) {
+    png_benchmark_t *state = (png_benchmark_t *) (callback_data);
+
+    state->done = true;
+    state->err = err;
+
+    if (decoded_image != NULL) {
+        surface_free(decoded_image);
+        free(decoded_image);
+    }
+}
+
+/**
+ * @brief Decode a PNG image with the foreground priority, waiting for the decoder in a loop.
+ *
+ * @param argument Path to the PNG file.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_png_decode (char *argument, benchmark_result_t *result) {
+    png_benchmark_t state = { .done = false };
+
+    switch (png_decoder_start(argument, PNG_SIZE_MAX, PNG_SIZE_MAX, PNG_PRIORITY_FOREGROUND, png_decode_callback, &state, NULL)) {
+        case PNG_OK: break;
+        case PNG_ERR_OUT_OF_MEM: return BENCHMARK_ERR_OUT_OF_MEM;
+        case PNG_ERR_NO_FILE: return BENCHMARK_ERR_ARGUMENT;
+        default: return BENCHMARK_ERR_IO;
+    }
+
+    while (!state.done) {
+        png_decoder_poll();
+    }
+
+    if (state.err != PNG_OK) {
+        return (state.err == PNG_ERR_OUT_OF_MEM) ? BENCHMARK_ERR_OUT_OF_MEM : BENCHMARK_ERR_IO;
+    }
+
+    result->bytes = file_get_size(argument);
+    result->items = 1;
+
+    return BENCHMARK_OK;
+}
+
+/**
+ * @brief Decode the start of an MP3 file without playing it.
+ *
+ * @param argument Path to the MP3 file.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_mp3_decode (char *argument, benchmark_result_t *result) {
+    mp3player_benchmark_t mp3;
+
+    switch (mp3player_benchmark(argument, MP3_FRAMES_DEFAULT, &mp3)) {
+        case MP3PLAYER_OK: break;
+        case MP3PLAYER_ERR_OUT_OF_MEM: return BENCHMARK_ERR_OUT_OF_MEM;
+        case MP3PLAYER_ERR_INVALID_FILE: return BENCHMARK_ERR_ARGUMENT;
+        default: return BENCHMARK_ERR_IO;
+    }
+
+    result->bytes = mp3.samples * sizeof(int16_t);
+    result->items = mp3.frames;
+    result->work_us = mp3.decode_us;
+    result->media_us = (mp3.samplerate > 0) ? ((mp3.samples * 1000000) / mp3.samplerate) : 0;
+
+    return BENCHMARK_OK;
+}
+
+/**
+ * @brief Enumerate a directory the way the file browser does.
+ *
+ * @param argument Path to the directory.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_dir_enum (char *argument, benchmark_result_t *result) {
+    dir_t info;
+    int status = dir_findfirst(argument, &info);
+
+    while (status == 0) {
+        if (info.d_type != DT_DIR) {
+            file_type_get(info.d_name);
+            result->bytes += info.d_size;
+        }
+        result->items += 1;
+        status = dir_findnext(argument, &info);
+    }
+
+    if (status < -1) {
+        return BENCHMARK_ERR_IO;
+    }
+
+    return BENCHMARK_OK;
+}
+
+/**
+ * @brief Search the card-wide ROM index, the index is completed first when it's still being built.
+ *
+ * @param argument Query text.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_search (char *argument, benchmark_result_t *result) {
+    if (argument[0] == '\0') {
+        return BENCHMARK_ERR_ARGUMENT;
+    }
+
+    while (!search_index_is_complete()) {
+        search_index_step(SEARCH_STEP_US);
+    }
+
+    uint64_t start = get_ticks_us();
+
+    search_index_query(argument);
+    while (!search_index_query_is_complete()) {
+        search_index_query_continue(SEARCH_STEP_US);
+    }
+
+    result->work_us = get_ticks_us() - start;
+    result->items = search_index_query_get_results();
+
+    return BENCHMARK_OK;
+}
+
+/**
+ * @brief Read a whole Controller Pak, one bank at a time.
+ *
+ * @param argument Controller port number, 1 to 4, the first port is used when empty.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+static benchmark_err_t benchmark_cpak_read (char *argument, benchmark_result_t *result) {
+    int port = (argument[0] != '\0') ? (atoi(argument) - 1) : 0;
+
+    if ((port < JOYPAD_PORT_1) || (port > JOYPAD_PORT_4)) {
+        return BENCHMARK_ERR_ARGUMENT;
+    }
+
+    if (!has_cpak(port)) {
+        return BENCHMARK_ERR_NO_DEVICE;
+    }
+
+    int banks = cpak_probe_banks(port);
+    if (banks <= 0) {
+        return BENCHMARK_ERR_NO_DEVICE;
+    }
+
+    uint8_t *buffer = malloc(CPAK_BANK_SIZE);
+    if (buffer == NULL) {
+        return BENCHMARK_ERR_OUT_OF_MEM;
+    }
+
+    benchmark_err_t err = BENCHMARK_OK;
+
+    for (int bank = 0; bank < banks; bank++) {
+        if (cpak_read(port, bank, 0, buffer, CPAK_BANK_SIZE) != CPAK_BANK_SIZE) {
+            err = BENCHMARK_ERR_IO;
+            break;
+        }
+        result->bytes += CPAK_BANK_SIZE;
+        result->items += 1;
+    }
+
+    free(buffer);
+
+    return err;
+}
+
+static const benchmark_t benchmarks[] = {
+    { .name = "sd-read", .path = true, .argument = "file path", .run = benchmark_sd_read },
+    { .name = "sd-random-read", .path = true, .argument = "file path", .run = benchmark_sd_random_read },
+    { .name = "pi-read", .argument = "size in KiB", .run = benchmark_pi_read },
+    { .name = "pi-write", .argument = "size in KiB", .run = benchmark_pi_write },
+    { .name = "rom-load", .path = true, .argument = "ROM path", .run = benchmark_rom_load },
+    { .name = "png-decode", .path = true, .argument = "PNG path", .run = benchmark_png_decode },
+    { .name = "mp3-decode", .path = true, .argument = "MP3 path", .run = benchmark_mp3_decode },
+    { .name = "dir-enum", .path = true, .argument = "directory path", .run = benchmark_dir_enum },
+    { .name = "search", .argument = "query text", .run = benchmark_search },
+    { .name = "cpak-read", .argument = "controller port", .run = benchmark_cpak_read },
+};
+
+#define BENCHMARKS_COUNT    (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+
+const char *benchmark_get_name (int index) {
+    if ((index < 0) || (index >= BENCHMARKS_COUNT)) {
+        return NULL;
+    }
+
+    return benchmarks[index].name;
+}
+
+const char *benchmark_get_argument (int index) {
+    if ((index < 0) || (index >= BENCHMARKS_COUNT)) {
+        return NULL;
+    }
+
+    return benchmarks[index].argument;
+}
+
+benchmark_err_t benchmark_run (const char *name, const char *storage_prefix, char *argument, benchmark_result_t *result) {
+    memset(result, 0, sizeof(benchmark_result_t));
+
+    for (int i = 0; i < BENCHMARKS_COUNT; i++) {
+        if (strcmp(benchmarks[i].name, name) == 0) {
+            path_t *path = benchmarks[i].path ? path_init(storage_prefix, argument) : NULL;
+
+            uint64_t start = get_ticks_us();
+            benchmark_err_t err = benchmarks[i].run(path ? path_get(path) : argument, result);
+            result->total_us = get_ticks_us() - start;
+
+            path_free(path);
+
+            return err;
+        }
+    }
+
+    return BENCHMARK_ERR_UNKNOWN;
+}
+
+const char *benchmark_convert_error_message (benchmark_err_t err) {
+    switch (err) {
+        case BENCHMARK_OK: return "No error";
+        case BENCHMARK_ERR_UNKNOWN: return "Unknown benchmark";
+        case BENCHMARK_ERR_ARGUMENT: return "Invalid benchmark argument";
+        case BENCHMARK_ERR_OUT_OF_MEM: return "Out of memory";
+        case BENCHMARK_ERR_IO: return "I/O error";
+        case BENCHMARK_ERR_NO_DEVICE: return "Device not present";
+        default: return "Unknown error";
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file benchmark.h
+ * @brief On-device benchmarks
+ * @ingroup menu
+ *
+ * The benchmarks time the same engines the menu uses, so the results
+ * can be compared between menu builds.
+ */
+
+#ifndef BENCHMARK_H__
+#define BENCHMARK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Benchmark errors enumeration. */
+typedef enum {
+    BENCHMARK_OK,                   /**< No error */
+    BENCHMARK_ERR_UNKNOWN,          /**< No benchmark with the requested name */
+    BENCHMARK_ERR_ARGUMENT,         /**< Missing or invalid argument */
+    BENCHMARK_ERR_OUT_OF_MEM,       /**< Out of memory */
+    BENCHMARK_ERR_IO,               /**< File, device or decoder error */
+    BENCHMARK_ERR_NO_DEVICE,        /**< The benchmarked device isn't present */
+} benchmark_err_t;
+
+/** @brief Benchmark results structure. */
+typedef struct {
+    uint64_t bytes;             /**< Number of bytes processed */
+    uint32_t items;             /**< Number of items processed: entries, frames, images or banks */
+    uint64_t total_us;          /**< Total benchmark time in microseconds */
+    uint64_t work_us;           /**< Time spent in the benchmarked engine itself, 0 when it's the whole time */
+    uint64_t media_us;          /**< Duration of the decoded media, 0 when the benchmark doesn't decode media */
+    bool rom_overwritten;       /**< The cart ROM area was overwritten, the menu can't keep running from it */
+} benchmark_result_t;
+
+/**
+ * @brief Get the name of a benchmark.
+ *
+ * @param index Benchmark index.
+ * @return const char* Benchmark name, NULL if the index is out of range.
+ */
+const char *benchmark_get_name (int index);
+
+/**
+ * @brief Get the argument description of a benchmark.
+ *
+ * @param index Benchmark index.
+ * @return const char* Argument description, NULL if the index is out of range.
+ */
+const char *benchmark_get_argument (int index);
+
+/**
+ * @brief Run a benchmark.
+ *
+ * @param name Benchmark name.
+ * @param storage_prefix Storage prefix the path arguments are relative to.
+ * @param argument Benchmark argument, a path, a controller port, a transfer size or a query.
+ * @param result Pointer to store the results.
+ * @return benchmark_err_t Error code.
+ */
+benchmark_err_t benchmark_run (const char *name, const char *storage_prefix, char *argument, benchmark_result_t *result);
+
+/**
+ * @brief Get the description of a benchmark error.
+ *
+ * @param err Error code.
+ * @return const char* Error description.
+ */
+const char *benchmark_convert_error_message (benchmark_err_t err);
+
+#endif /* BENCHMARK_H__ */
@@ -0,0 +1,219 @@
+/**
+ * @file bgm.c
+ * @brief Menu background music implementation
+ * @ingroup menu
+ */
+
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <fatfs/ff.h>
+#include <libdragon.h>
+
+#include "bgm.h"
+#include "bgm_stream.h"
+#include "path.h"
+#include "sound.h"
+#include "utils/fs.h"
+
+#define BGM_ROM_FILE        "rom:/bgm.wav64"
+#define BGM_STREAM_PREFIX   "bgm:/"
+#define BGM_STREAM_FILE     "bgm:/music.wav64"
+#define BGM_HEAD_SIZE       (16 * 1024)
+#define BGM_RING_SIZE       (64 * 1024)
+#define BGM_REFILL_CHUNK    (4 * 1024)
+#define BGM_VOLUME          (0.4f)
+
+/** @brief Background music state structure. */
+static struct {
+    path_t *path; /**< Path to the music file on the SD card */
+    bool enabled; /**< The music is enabled */
+    bool paused; /**< The music is paused */
+    bool opened; /**< The music file is opened */
+    bool streamed; /**< The music file is read through the read-ahead stream */
+    FIL fil; /**< Music file on the SD card */
+    wav64_t wave; /**< Opened music */
+} bgm;
+
+static bgm_stream_t stream;
+static uint8_t stream_head[BGM_HEAD_SIZE] __attribute__((aligned(FS_SECTOR_SIZE)));
+static uint8_t stream_ring[BGM_RING_SIZE] __attribute__((aligned(FS_SECTOR_SIZE)));
+
+
+static bool file_read (void *arg, uint32_t offset, void *buffer, size_t length) {
+    UINT bytes_read;
+
+    if (f_lseek(&bgm.fil, offset) != FR_OK) {
+        return true;
+    }
+
+    if ((f_read(&bgm.fil, buffer, length, &bytes_read) != FR_OK) || (bytes_read != length)) {
+        return true;
+    }
+
+    return false;
+}
+
+static void *stream_open (char *name, int flags) {
+    if (!bgm.streamed) {
+        errno = ENOENT;
+        return NULL;
+    }
+    bgm_stream_seek(&stream, 0);
+    return &stream;
+}
+
+static int stream_fstat (void *file, struct stat *st) {
+    st->st_size = stream.size;
+    st->st_mode = S_IFREG;
+    return 0;
+}
+
+static int stream_lseek (void *file, int offset, int whence) {
+    int position = offset;
+
+    if (whence == SEEK_CUR) {
+        position += stream.position;
+    } else if (whence == SEEK_END) {
+        position += stream.size;
+    }
+
+    if (position < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    bgm_stream_seek(&stream, position);
+
+    return stream.position;
+}
+
+static int stream_read (void *file, uint8_t *buffer, int length) {
+    int result = bgm_stream_read(&stream, buffer, length);
+    if (result < 0) {
+        errno = EIO;
+    }
+    return result;
+}
+
+static int stream_close (void *file) {
+    return 0;
+}
+
+static filesystem_t stream_filesystem = {
+    .open = stream_open,
+    .fstat = stream_fstat,
+    .lseek = stream_lseek,
+    .read = stream_read,
+    .close = stream_close,
+};
+
+static bool bgm_open (void) {
+    char *wave_path = BGM_ROM_FILE;
+
+    if ((bgm.path != NULL) && file_exists(path_get(bgm.path))) {
+        if (f_open(&bgm.fil, strip_fs_prefix(path_get(bgm.path)), FA_READ) != FR_OK) {
+            return true;
+        }
+        if (bgm_stream_init(&stream, file_read, NULL, f_size(&bgm.fil), stream_head, sizeof(stream_head), stream_ring, sizeof(stream_ring))) {
+            f_close(&bgm.fil);
+            return true;
+        }
+        bgm.streamed = true;
+        wave_path = BGM_STREAM_FILE;
+    } else if (!file_exists(BGM_ROM_FILE)) {
+        return true;
+    }
+
+    wav64_open(&bgm.wave, wave_path);
+    wav64_set_loop(&bgm.wave, true);
+    bgm.opened = true;
+
+    return false;
+}
+
+static void bgm_close (void) {
+    if (bgm.opened) {
+        mixer_ch_stop(SOUND_BGM_CHANNEL);
+        wav64_close(&bgm.wave);
+        bgm.opened = false;
+    }
+    if (bgm.streamed) {
+        f_close(&bgm.fil);
+        bgm.streamed = false;
+    }
+}
+
+static void bgm_play (void) {
+    if (bgm.opened && !bgm.paused) {
+        mixer_ch_set_vol(SOUND_BGM_CHANNEL, BGM_VOLUME, BGM_VOLUME);
+        wav64_play(&bgm.wave, SOUND_BGM_CHANNEL);
+    }
+}
+
+
+void bgm_init (char *path) {
+    bgm.path = path_create(path);
+    attach_filesystem(BGM_STREAM_PREFIX, &stream_filesystem);
+}
+
+bool bgm_set_enabled (bool enabled) {
+    if (enabled == bgm.enabled) {
+        return false;
+    }
+
+    if (!enabled) {
+        bgm_close();
+        bgm.enabled = false;
+        return false;
+    }
+
+    if (bgm_open()) {
+        return true;
+    }
+
+    bgm.enabled = true;
+    bgm_play();
+
+    return false;
+}
+
+void bgm_set_paused (bool paused) {
+    if (paused == bgm.paused) {
+        return;
+    }
+
+    bgm.paused = paused;
+
+    if (!bgm.opened) {
+        return;
+    }
+
+    if (paused) {
+        mixer_ch_stop(SOUND_BGM_CHANNEL);
+    } else {
+        bgm_play();
+    }
+}
+
+void bgm_mixer_init (void) {
+    bgm_play();
+}
+
+bool bgm_poll (void) {
+    if (!bgm.streamed || bgm.paused) {
+        return false;
+    }
+
+    bgm_stream_refill(&stream, BGM_REFILL_CHUNK);
+
+    return bgm_stream_needs_refill(&stream);
+}
+
+void bgm_deinit (void) {
+    bgm_close();
+    bgm.enabled = false;
+    detach_filesystem(BGM_STREAM_PREFIX);
+    path_free(bgm.path);
+    bgm.path = NULL;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file bgm.h
+ * @brief Menu background music
+ * @ingroup menu
+ *
+ * A wav64 file is played in a loop on its own mixer channel. VADPCM
+ * compressed files are decoded by the RSP, so the music costs almost no CPU
+ * time. A file on the SD card is read ahead into a ring buffer from the main
+ * loop, the mixer never waits for the SD card.
+ */
+
+#ifndef BGM_H__
+#define BGM_H__
+
+#include <stdbool.h>
+
+/**
+ * @brief Initialize the background music, nothing is played until it's enabled.
+ *
+ * @param path Path to the music file on the SD card, rom:/bgm.wav64 is used when it doesn't exist.
+ */
+void bgm_init (char *path);
+
+/**
+ * @brief Start or stop the background music.
+ *
+ * @param enabled Play the music.
+ * @return true if the music file couldn't be opened, false otherwise.
+ */
+bool bgm_set_enabled (bool enabled);
+
+/**
+ * @brief Pause or resume the background music, such as while the music player plays a file.
+ *
+ * A resumed track starts over.
+ *
+ * @param paused Pause the music.
+ */
+void bgm_set_paused (bool paused);
+
+/**
+ * @brief Restart the playback after the mixer was initialized again.
+ */
+void bgm_mixer_init (void);
+
+/**
+ * @brief Read ahead the music file.
+ *
+ * @return true if the read-ahead has more to read, false otherwise.
+ */
+bool bgm_poll (void);
+
+/**
+ * @brief Stop the background music and release its resources.
+ */
+void bgm_deinit (void);
+
+#endif /* BGM_H__ */
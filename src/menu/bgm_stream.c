@@ -0,0 +1,128 @@
+/**
+ * @file bgm_stream.c
+ * @brief Background music read-ahead stream implementation
+ * @ingroup menu
+ */
+
+#include <string.h>
+
+#include "bgm_stream.h"
+#include "utils/utils.h"
+
+
+static bool in_window (bgm_stream_t *stream, uint32_t offset) {
+    return (offset >= stream->base) && (offset <= (stream->base + stream->fill));
+}
+
+/**
+ * @brief Move the start of the ring buffer window, dropping the data before the offset.
+ */
+static void window_move (bgm_stream_t *stream, uint32_t offset) {
+    if (offset < stream->head_length) {
+        offset = stream->head_length;
+    }
+
+    if (in_window(stream, offset)) {
+        stream->fill -= (offset - stream->base);
+    } else {
+        stream->fill = 0;
+    }
+
+    stream->base = offset;
+}
+
+
+bool bgm_stream_init (bgm_stream_t *stream, bgm_stream_read_t *read, void *arg, uint32_t size, uint8_t *head, uint32_t head_size, uint8_t *ring, uint32_t ring_size) {
+    *stream = (bgm_stream_t) {
+        .read = read,
+        .arg = arg,
+        .size = size,
+        .head = head,
+        .head_length = MIN(head_size, size),
+        .ring = ring,
+        .ring_size = ring_size,
+    };
+
+    stream->base = stream->head_length;
+
+    if (stream->read(stream->arg, 0, stream->head, stream->head_length)) {
+        stream->error = true;
+        return true;
+    }
+
+    return false;
+}
+
+bool bgm_stream_needs_refill (bgm_stream_t *stream) {
+    return !stream->error && (stream->fill < stream->ring_size) && ((stream->base + stream->fill) < stream->size);
+}
+
+uint32_t bgm_stream_refill (bgm_stream_t *stream, uint32_t max_length) {
+    if (!bgm_stream_needs_refill(stream)) {
+        return 0;
+    }
+
+    uint32_t offset = stream->base + stream->fill;
+    uint32_t index = (offset % stream->ring_size);
+
+    uint32_t length = MIN(max_length, stream->ring_size - stream->fill);
+    length = MIN(length, stream->size - offset);
+    length = MIN(length, stream->ring_size - index);
+
+    if (stream->read(stream->arg, offset, &stream->ring[index], length)) {
+        stream->error = true;
+        return 0;
+    }
+
+    stream->fill += length;
+
+    return length;
+}
+
+int bgm_stream_read (bgm_stream_t *stream, void *buffer, size_t length) {
+    if (stream->error) {
+        return -1;
+    }
+
+    uint8_t *output = buffer;
+    uint32_t remaining = MIN(length, stream->size - stream->position);
+    uint32_t total = remaining;
+
+    while (remaining > 0) {
+        uint32_t position = stream->position;
+        uint32_t copied;
+
+        if (position < stream->head_length) {
+            copied = MIN(remaining, stream->head_length - position);
+            memcpy(output, &stream->head[position], copied);
+        } else if (in_window(stream, position) && (position < (stream->base + stream->fill))) {
+            uint32_t index = (position % stream->ring_size);
+            copied = MIN(remaining, stream->base + stream->fill - position);
+            copied = MIN(copied, stream->ring_size - index);
+            memcpy(output, &stream->ring[index], copied);
+        } else {
+            // NOTE: The read-ahead fell behind, the rest is read directly and the read-ahead restarts after it
+            copied = remaining;
+            if (stream->read(stream->arg, position, output, copied)) {
+                stream->error = true;
+                return -1;
+            }
+            stream->underruns += 1;
+        }
+
+        output += copied;
+        remaining -= copied;
+        stream->position += copied;
+    }
+
+    if (stream->position >= stream->head_length) {
+        window_move(stream, stream->position);
+    }
+
+    return total;
+}
+
+void bgm_stream_seek (bgm_stream_t *stream, uint32_t offset) {
+    stream->position = MIN(offset, stream->size);
+    window_move(stream, stream->position);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file bgm_stream.h
+ * @brief Background music read-ahead stream
+ * @ingroup menu
+ *
+ * The music file is read ahead into a ring buffer by a background task, so
+ * the mixer reads the data from memory and never waits for the SD card.
+ * The head of the file is kept resident, a seek back to the start of a
+ * looping track is served from memory while the ring buffer is refilled.
+ */
+
+#ifndef BGM_STREAM_H__
+#define BGM_STREAM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief File read callback.
+ *
+ * @param arg Argument passed at initialization.
+ * @param offset Offset in the file.
+ * @param buffer Buffer to store the data.
+ * @param length Number of bytes to read.
+ * @return true if an error occurred, false otherwise.
+ */
+typedef bool bgm_stream_read_t (void *arg, uint32_t offset, void *buffer, size_t length);
+
+/** @brief Read-ahead stream structure. */
+typedef struct {
+    bgm_stream_read_t *read; /**< File read callback */
+    void *arg; /**< Callback argument */
+    uint32_t size; /**< File size */
+    uint8_t *head; /**< Resident head of the file */
+    uint32_t head_length; /**< Length of the resident head */
+    uint8_t *ring; /**< Ring buffer */
+    uint32_t ring_size; /**< Size of the ring buffer */
+    uint32_t base; /**< File offset of the first byte in the ring buffer */
+    uint32_t fill; /**< Number of bytes in the ring buffer */
+    uint32_t position; /**< Read position */
+    uint32_t underruns; /**< Number of reads the ring buffer couldn't serve */
+    bool error; /**< The file couldn't be read */
+} bgm_stream_t;
+
+/**
+ * @brief Initialize the stream and read the head of the file.
+ *
+ * @param stream Pointer to the stream.
+ * @param read File read callback.
+ * @param arg Argument passed to the callback.
+ * @param size File size.
+ * @param head Buffer for the resident head of the file.
+ * @param head_size Size of the head buffer.
+ * @param ring Ring buffer.
+ * @param ring_size Size of the ring buffer.
+ * @return true if the head couldn't be read, false otherwise.
+ */
+bool bgm_stream_init (bgm_stream_t *stream, bgm_stream_read_t *read, void *arg, uint32_t size, uint8_t *head, uint32_t head_size, uint8_t *ring, uint32_t ring_size);
+
+/**
+ * @brief Read ahead into the ring buffer.
+ *
+ * @param stream Pointer to the stream.
+ * @param max_length Maximum number of bytes to read.
+ * @return uint32_t Number of bytes read, 0 when the ring buffer is full or the end of the file is buffered.
+ */
+uint32_t bgm_stream_refill (bgm_stream_t *stream, uint32_t max_length);
+
+/**
+ * @brief Read from the stream, reading from the file directly when the data isn't buffered.
+ *
+ * @param stream Pointer to the stream.
+ * @param buffer Buffer to store the data.
+ * @param length Number of bytes to read.
+ * @return int Number of bytes read, 0 at the end of the file, -1 on error.
+ */
+int bgm_stream_read (bgm_stream_t *stream, void *buffer, size_t length);
+
+/**
+ * @brief Move the read position.
+ *
+ * @param stream Pointer to the stream.
+ * @param offset New read position, clamped to the file size.
+ */
+void bgm_stream_seek (bgm_stream_t *stream, uint32_t offset);
+
+/**
+ * @brief Check if the read-ahead has more to read.
+ *
+ * @param stream Pointer to the stream.
+ * @return true if the ring buffer has free space and the file has more data, false otherwise.
+ */
+bool bgm_stream_needs_refill (bgm_stream_t *stream);
+
+#endif /* BGM_STREAM_H__ */
@@ -9,11 +9,26 @@
 
 #include "bookkeeping.h"
 #include "utils/fs.h"
+#include "utils/utils.h"
 #include "path.h"
 
+#define JOURNAL_EXTENSION       "jnl"
+#define JOURNAL_SIZE            (KiB(32))
+#define JOURNAL_ENTRIES_MAX     (32)
+#define JOURNAL_LINE_LENGTH     (1024)
+
+#define JOURNAL_OP_HISTORY_ADD      'H'
+#define JOURNAL_OP_FAVORITE_ADD     'F'
+#define JOURNAL_OP_FAVORITE_REMOVE  'R'
+
 static char *history_path = NULL;
+static char *journal_path = NULL;
+static int journal_entries = 0;
 static bookkeeping_t init;
 
+static bool bookkeeping_insert_top(bookkeeping_item_t *list, int count, bookkeeping_item_t *new_item);
+static bool bookkeeping_remove_item(bookkeeping_item_t *list, int count, int selection);
+
 /**
  * @brief Initialize the bookkeeping system with the specified path.
  * 
@@ -22,13 +37,128 @@ static bookkeeping_t init;
 void bookkeeping_init (char *path) {
     if (history_path) {
         free(history_path);
+        free(journal_path);
     }
     history_path = strdup(path);
+
+    // NOTE: The journal is kept next to the history file, with a different extension
+    char *extension = strrchr(file_basename(history_path), '.');
+    size_t base_length = extension ? (size_t) (extension - history_path) : strlen(history_path);
+    if ((journal_path = malloc(base_length + strlen(JOURNAL_EXTENSION) + 2)) != NULL) {
+        sprintf(journal_path, "%.*s.%s", (int) (base_length), history_path, JOURNAL_EXTENSION);
+    }
+    journal_entries = 0;
+}
+
+/**
+ * @brief Append an operation to the journal.
+ *
+ * Every change made after the history file was written is recorded as a single line.
+ *
+ * @param op Journal operation.
+ * @param item Pointer to the added item, NULL for the operations without one.
+ * @param index Item index for the operations without an item.
+ * @return true if the operation couldn't be journaled, false otherwise.
+ */
+static bool bookkeeping_journal_append(char op, bookkeeping_item_t *item, int index) {
+    char line[JOURNAL_LINE_LENGTH];
+    int length;
+
+    if ((journal_path == NULL) || (journal_entries >= JOURNAL_ENTRIES_MAX)) {
+        return true;
+    }
+
+    if (item != NULL) {
+        length = snprintf(line, sizeof(line), "%c %d %s\t%s\n",
+            op,
+            item->bookkeeping_type,
+            (item->primary_path != NULL) ? path_get(item->primary_path) : "",
+            (item->secondary_path != NULL) ? path_get(item->secondary_path) : ""
+        );
+    } else {
+        length = snprintf(line, sizeof(line), "%c %d\n", op, index);
+    }
+
+    if ((length >= sizeof(line)) || file_append(journal_path, line, length)) {
+        return true;
+    }
+
+    journal_entries += 1;
+
+    return false;
+}
+
+/**
+ * @brief Apply the journaled operations on top of the items loaded from the history file.
+ *
+ * A line that wasn't fully written is ignored.
+ *
+ * @param history Pointer to the bookkeeping structure.
+ * @return Number of journaled operations.
+ */
+static int bookkeeping_journal_replay(bookkeeping_t *history) {
+    size_t length;
+    int entries = 0;
+
+    if ((journal_path == NULL) || !file_exists(journal_path)) {
+        return 0;
+    }
+
+    char *journal = malloc(JOURNAL_SIZE + 1);
+    if ((journal == NULL) || file_read_all(journal_path, journal, JOURNAL_SIZE, &length)) {
+        free(journal);
+        // NOTE: The journal is compacted long before it could grow this large, it's treated as full so it's dropped
+        return JOURNAL_ENTRIES_MAX;
+    }
+    journal[length] = '\0';
+
+    char *line = journal;
+    char *end;
+    while ((end = strchr(line, '\n')) != NULL) {
+        *end = '\0';
+
+        char op;
+        int value;
+        int offset = 0;
+        if (sscanf(line, "%c %d %n", &op, &value, &offset) >= 2) {
+            if (op == JOURNAL_OP_FAVORITE_REMOVE) {
+                if ((value >= 0) && (value < FAVORITES_COUNT)) {
+                    bookkeeping_remove_item(history->favorite_items, FAVORITES_COUNT, value);
+                }
+            } else if ((offset > 0) && ((op == JOURNAL_OP_HISTORY_ADD) || (op == JOURNAL_OP_FAVORITE_ADD))) {
+                char *secondary = strchr(&line[offset], '\t');
+                if (secondary != NULL) {
+                    *secondary++ = '\0';
+                    bookkeeping_item_t item = {
+                        .primary_path = path_create(&line[offset]),
+                        .secondary_path = path_create(secondary),
+                        .bookkeeping_type = value,
+                    };
+                    if (op == JOURNAL_OP_HISTORY_ADD) {
+                        bookkeeping_insert_top(history->history_items, HISTORY_COUNT, &item);
+                    } else {
+                        bookkeeping_insert_top(history->favorite_items, FAVORITES_COUNT, &item);
+                    }
+                    path_free(item.primary_path);
+                    path_free(item.secondary_path);
+                }
+            }
+            entries += 1;
+        }
+
+        line = end + 1;
+    }
+
+    free(journal);
+
+    return entries;
 }
 
 /**
  * @brief Load a list of bookkeeping items from an INI file.
  * 
+ * The items are kept packed at the start of the list, the lookups stop at the first empty item.
+ *
  * @param list Pointer to the list of bookkeeping items.
  * @param count Number of items in the list.
  * @param ini Pointer to the INI file structure.
@@ -36,7 +166,15 @@ void bookkeeping_init (char *path) {
  */
 void bookkeeping_ini_load_list(bookkeeping_item_t *list, uint16_t count, mini_t *ini, const char *group) {
     char buf[64];
+    bool end = false;
     for(uint16_t i = 0; i < count; i++) {
+        if(end) {
+            list[i].primary_path = path_create("");
+            list[i].secondary_path = path_create("");
+            list[i].bookkeeping_type = BOOKKEEPING_TYPE_EMPTY;
+            continue;
+        }
+
         sprintf(buf, "%d_primary_path", i);
         list[i].primary_path = path_create(mini_get_string(ini, group, buf, ""));
 
@@ -45,6 +183,8 @@ void bookkeeping_ini_load_list(bookkeeping_item_t *list, uint16_t count, mini_t
         
         sprintf(buf, "%d_type", i);
         list[i].bookkeeping_type = mini_get_int(ini, group, buf, BOOKKEEPING_TYPE_EMPTY);
+
+        end = (list[i].bookkeeping_type == BOOKKEEPING_TYPE_EMPTY);
     }
 }
 
@@ -63,6 +203,12 @@ void bookkeeping_load (bookkeeping_t *history) {
     bookkeeping_ini_load_list(history->favorite_items, FAVORITES_COUNT, bookkeeping_ini, "favorite");
 
     mini_free(bookkeeping_ini);
+
+    // NOTE: The journal is compacted here rather than when it fills up, so a ROM load never pays for the rewrite
+    journal_entries = bookkeeping_journal_replay(history);
+    if (journal_entries >= (JOURNAL_ENTRIES_MAX / 2)) {
+        bookkeeping_save(history);
+    }
 }
 
 /**
@@ -76,6 +222,11 @@ void bookkeeping_load (bookkeeping_t *history) {
 static void bookkeeping_ini_save_list(bookkeeping_item_t *list, uint16_t count, mini_t *ini, const char *group) {
     char buf[64];
     for(uint16_t i = 0; i < count; i++) {
+        // the empty items are only at the end of the list, they are implied when loading
+        if(list[i].bookkeeping_type == BOOKKEEPING_TYPE_EMPTY) {
+            break;
+        }
+
         sprintf(buf, "%d_primary_path", i);
         path_t* path = list[i].primary_path;
         mini_set_string(ini, group, buf, path != NULL ? path_get(path) : "");   
@@ -102,6 +253,11 @@ void bookkeeping_save (bookkeeping_t *history) {
 
     mini_save(bookkeeping_ini, MINI_FLAGS_SKIP_EMPTY_GROUPS);
     mini_free(bookkeeping_ini);    
+
+    if ((journal_path != NULL) && ((journal_entries > 0) || file_exists(journal_path))) {
+        remove(journal_path);
+    }
+    journal_entries = 0;
 }
 
 /**
@@ -207,11 +363,12 @@ static void bookkeeping_move_items_up(bookkeeping_item_t *list, int start, int e
  * @param list Pointer to the list of bookkeeping items.
  * @param count Number of items in the list.
  * @param new_item Pointer to the new bookkeeping item.
+ * @return true if the list changed, false if the item already was at the top.
  */
-static void bookkeeping_insert_top(bookkeeping_item_t *list, int count, bookkeeping_item_t *new_item) {
+static bool bookkeeping_insert_top(bookkeeping_item_t *list, int count, bookkeeping_item_t *new_item) {
     // if it matches the top of the list already then nothing to do
     if(bookkeeping_item_match(&list[0], new_item)) {
-        return;
+        return false;
     }
 
     // if the top isn't empty then we need to move things around
@@ -232,6 +389,27 @@ static void bookkeeping_insert_top(bookkeeping_item_t *list, int count, bookkeep
     }
     
     bookkeeping_copy_item(new_item, &list[0]);
+
+    return true;
+}
+
+/**
+ * @brief Remove a bookkeeping item, moving the following items up.
+ *
+ * @param list Pointer to the list of bookkeeping items.
+ * @param count Number of items in the list.
+ * @param selection Index of the item to remove.
+ * @return true if the list changed, false if the item was empty.
+ */
+static bool bookkeeping_remove_item(bookkeeping_item_t *list, int count, int selection) {
+    if(list[selection].bookkeeping_type == BOOKKEEPING_TYPE_EMPTY) {
+        return false;
+    }
+
+    bookkeeping_move_items_up(list, selection, count - 1);
+    bookkeeping_clear_item(&list[count - 1], false);
+
+    return true;
 }
 
 /**
@@ -249,8 +427,9 @@ void bookkeeping_history_add(bookkeeping_t *bookkeeping, path_t *primary_path, p
         .bookkeeping_type = type
     };
 
-    bookkeeping_insert_top(bookkeeping->history_items, HISTORY_COUNT, &new_item);
-    bookkeeping_save(bookkeeping);
+    if(bookkeeping_insert_top(bookkeeping->history_items, HISTORY_COUNT, &new_item) && bookkeeping_journal_append(JOURNAL_OP_HISTORY_ADD, &new_item, 0)) {
+        bookkeeping_save(bookkeeping);
+    }
 }
 
 /**
@@ -268,8 +447,9 @@ void bookkeeping_favorite_add(bookkeeping_t *bookkeeping, path_t *primary_path,
         .bookkeeping_type = type
     };
 
-    bookkeeping_insert_top(bookkeeping->favorite_items, FAVORITES_COUNT, &new_item);
-    bookkeeping_save(bookkeeping);
+    if(bookkeeping_insert_top(bookkeeping->favorite_items, FAVORITES_COUNT, &new_item) && bookkeeping_journal_append(JOURNAL_OP_FAVORITE_ADD, &new_item, 0)) {
+        bookkeeping_save(bookkeeping);
+    }
 }
 
 /**
@@ -279,9 +459,7 @@ void bookkeeping_favorite_add(bookkeeping_t *bookkeeping, path_t *primary_path,
  * @param selection Index of the item to remove.
  */
 void bookkeeping_favorite_remove(bookkeeping_t *bookkeeping, int selection) {
-    if(bookkeeping->favorite_items[selection].bookkeeping_type != BOOKKEEPING_TYPE_EMPTY) {
-        bookkeeping_move_items_up(bookkeeping->favorite_items, selection, FAVORITES_COUNT - 1);
-        bookkeeping_clear_item(&bookkeeping->favorite_items[FAVORITES_COUNT - 1], false);
+    if(bookkeeping_remove_item(bookkeeping->favorite_items, FAVORITES_COUNT, selection) && bookkeeping_journal_append(JOURNAL_OP_FAVORITE_REMOVE, NULL, selection)) {
         bookkeeping_save(bookkeeping);
     }
 }
@@ -9,8 +9,8 @@
 
 #include "path.h"
 
-#define FAVORITES_COUNT 8 /**< Maximum number of favorite items */
-#define HISTORY_COUNT 8 /**< Maximum number of history items */
+#define FAVORITES_COUNT 256 /**< Maximum number of favorite items */
+#define HISTORY_COUNT 256 /**< Maximum number of history items */
 
 /** @brief Bookkeeping item types enumeration */
 typedef enum {
@@ -5,10 +5,19 @@
  */
 
 #include <string.h>
+#include <fatfs/ff.h>
 #include <libdragon.h>
+#include <miniz.h>
+#include <miniz_zip.h>
 #include "cart_load.h"
+#include "compressed_rom.h"
+#include "file_ops.h"
+#include "file_types.h"
 #include "path.h"
+#include "rom_patch.h"
+#include "save_backup.h"
 #include "utils/fs.h"
+#include "utils/trace.h"
 #include "utils/utils.h"
 
 #ifndef DDIPL_LOCATION
@@ -18,6 +27,12 @@
 #define EMU_LOCATION            "/menu/emulators"
 #endif
 
+#define ROM_PADDING_MIN_SIZE    (MiB(1))
+#define ROM_PATCH_SPACE         (MiB(64) - KiB(128))
+
+/** @brief Patch file extensions, in the order they are looked up next to the ROM. */
+static char *patch_extensions[] = { "bps", "ups", "ips", NULL };
+
 /**
  * @brief Check if the 64DD is connected.
  * 
@@ -39,11 +54,34 @@ static bool create_saves_subdirectory (path_t *path) {
     path_t *save_folder_path = path_clone(path);
     path_pop(save_folder_path);
     path_push(save_folder_path, SAVE_DIRECTORY_NAME);
+    bool created = !directory_exists(path_get(save_folder_path));
     bool error = directory_create(path_get(save_folder_path));
+    if (created && !error) {
+        file_ops_notify_written(save_folder_path);
+    }
     path_free(save_folder_path);
     return error;
 }
 
+/**
+ * @brief Load the save file, reporting it to the browser listings when the flashcart created it.
+ *
+ * @param path Pointer to the save file path.
+ * @param save_type The flashcart save type.
+ * @return flashcart_err_t The flashcart error code.
+ */
+static flashcart_err_t load_save (path_t *path, flashcart_save_type_t save_type) {
+    bool created = (save_type != FLASHCART_SAVE_TYPE_NONE) && !file_exists(path_get(path));
+
+    flashcart_err_t err = flashcart_load_save(path_get(path), save_type);
+
+    if ((err == FLASHCART_OK) && created) {
+        file_ops_notify_written(path);
+    }
+
+    return err;
+}
+
 /**
  * @brief Convert the ROM save type to the flashcart save type.
  * 
@@ -63,6 +101,38 @@ static flashcart_save_type_t convert_save_type (rom_save_type_t save_type) {
     }
 }
 
+/**
+ * @brief Convert the ROM CIC type to the flashcart checksum type.
+ * 
+ * @param cic_type The ROM CIC type.
+ * @return flashcart_checksum_type_t The flashcart checksum type.
+ */
+static flashcart_checksum_type_t convert_checksum_type (rom_cic_type_t cic_type) {
+    switch (cic_type) {
+        case ROM_CIC_TYPE_6101:
+        case ROM_CIC_TYPE_7102:
+        case ROM_CIC_TYPE_x102: return FLASHCART_CHECKSUM_6102;
+        case ROM_CIC_TYPE_x103: return FLASHCART_CHECKSUM_6103;
+        case ROM_CIC_TYPE_x105: return FLASHCART_CHECKSUM_6105;
+        case ROM_CIC_TYPE_x106: return FLASHCART_CHECKSUM_6106;
+        default: return FLASHCART_CHECKSUM_NONE;
+    }
+}
+
+/**
+ * @brief Convert the ROM endianness to the flashcart byte order.
+ * 
+ * @param endianness The ROM endianness.
+ * @return flashcart_byte_order_t The flashcart byte order.
+ */
+static flashcart_byte_order_t convert_byte_order (rom_endianness_t endianness) {
+    switch (endianness) {
+        case ENDIANNESS_BYTE_SWAP: return FLASHCART_BYTE_ORDER_BYTE_SWAPPED;
+        case ENDIANNESS_LITTLE: return FLASHCART_BYTE_ORDER_LITTLE_ENDIAN;
+        default: return FLASHCART_BYTE_ORDER_BIG_ENDIAN;
+    }
+}
+
 /**
  * @brief Convert the cart load error code to a human-readable message.
  * 
@@ -85,10 +155,150 @@ char *cart_load_convert_error_message (cart_load_err_t err) {
         case CART_LOAD_ERR_CREATE_SAVES_SUBDIR_FAIL: return "Couldn't create saves subdirectory";
         case CART_LOAD_ERR_EXP_PAK_NOT_FOUND: return "Mandatory Expansion Pak accessory was not found";
         case CART_LOAD_ERR_FUNCTION_NOT_SUPPORTED: return "Your flashcart doesn't support required functionality";
+        case CART_LOAD_ERR_ROM_VERIFY_FAIL: return "ROM data verification failed, the file may be damaged";
+        case CART_LOAD_ERR_ROM_PATCH_FAIL: return "Couldn't apply the ROM patch";
         default: return "Unknown error [CART_LOAD]";
     }
 }
 
+/**
+ * @brief Pass the decompressed archive data to the flashcart.
+ * 
+ * @param opaque Unused.
+ * @param offset Offset of the data in the archived file.
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return size_t Number of bytes consumed, anything less than the length stops the extraction.
+ */
+static size_t archive_stream_callback (void *opaque, mz_uint64 offset, const void *data, size_t length) {
+    return (flashcart_load_rom_stream_write(data, length) == FLASHCART_OK) ? length : 0;
+}
+
+/**
+ * @brief Stream an archived ROM straight into the flashcart, the file is decompressed on the fly.
+ * 
+ * @param menu Pointer to the menu structure.
+ * @param byte_order Byte order of the ROM data.
+ * @param progress Progress callback function.
+ * @return flashcart_err_t Error code.
+ */
+static flashcart_err_t load_archived_rom (menu_t *menu, flashcart_byte_order_t byte_order, flashcart_progress_callback_t progress) {
+    mz_zip_archive_file_stat st;
+    flashcart_err_t err;
+
+    if (!menu->browser.archive || !mz_zip_reader_file_stat(&menu->browser.zip, menu->load.load_archive_id, &st)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    if (st.m_uncomp_size > UINT32_MAX) {
+        return FLASHCART_ERR_FUNCTION_NOT_SUPPORTED;
+    }
+
+    if ((err = flashcart_load_rom_stream_begin((uint32_t) (st.m_uncomp_size), byte_order, progress)) != FLASHCART_OK) {
+        return err;
+    }
+
+    bool extracted = mz_zip_reader_extract_to_callback(&menu->browser.zip, st.m_file_index, archive_stream_callback, NULL, 0);
+
+    err = flashcart_load_rom_stream_end();
+
+    if ((err == FLASHCART_OK) && !extracted) {
+        err = FLASHCART_ERR_LOAD;
+    }
+
+    return err;
+}
+
+static bool patch_read (void *arg, uint32_t offset, void *buffer, size_t length) {
+    FIL *fil = (FIL *) (arg);
+    UINT br;
+
+    if ((f_tell(fil) != offset) && (f_lseek(fil, offset) != FR_OK)) {
+        return true;
+    }
+
+    return (f_read(fil, buffer, length, &br) != FR_OK) || (br != length);
+}
+
+static bool patch_rom_read (void *arg, uint32_t offset, void *buffer, size_t length) {
+    return (flashcart_rom_read(offset, buffer, length) != FLASHCART_OK);
+}
+
+static bool patch_rom_write (void *arg, uint32_t offset, const void *buffer, size_t length) {
+    return (flashcart_rom_write(offset, buffer, length) != FLASHCART_OK);
+}
+
+/**
+ * @brief Apply the patch stored next to the ROM to the ROM already loaded into the cart SDRAM.
+ * 
+ * The patch is looked up with the ROM file name and a bps, ups or ips extension,
+ * the ROM is booted unpatched when there's none.
+ * 
+ * @param menu Pointer to the menu structure.
+ * @param byte_order Byte order of the ROM file.
+ * @param streamed The ROM was decompressed while loading.
+ * @return cart_load_err_t Error code.
+ */
+static cart_load_err_t apply_rom_patch (menu_t *menu, flashcart_byte_order_t byte_order, bool streamed) {
+    FIL fil;
+    path_t *path = path_clone(menu->load.rom_path);
+
+    bool found = false;
+    for (int i = 0; patch_extensions[i] != NULL; i++) {
+        path_ext_replace(path, patch_extensions[i]);
+        if ((found = file_exists(path_get(path)))) {
+            break;
+        }
+    }
+
+    if (!found) {
+        path_free(path);
+        return CART_LOAD_OK;
+    }
+
+    // NOTE: Patch offsets refer to the ROM file, it must be stored as it is in the cart SDRAM
+    int64_t rom_size = file_get_size(path_get(menu->load.rom_path));
+    if (streamed || (byte_order != FLASHCART_BYTE_ORDER_BIG_ENDIAN) || (rom_size < 0)) {
+        debugf("ROM patch: Only uncompressed big endian ROMs can be patched\n");
+        path_free(path);
+        return CART_LOAD_ERR_ROM_PATCH_FAIL;
+    }
+
+    if (f_open(&fil, strip_fs_prefix(path_get(path)), FA_READ) != FR_OK) {
+        path_free(path);
+        return CART_LOAD_ERR_ROM_PATCH_FAIL;
+    }
+
+    rom_patch_io_t io = {
+        .patch_read = patch_read,
+        .rom_read = patch_rom_read,
+        .rom_write = patch_rom_write,
+        .arg = &fil,
+        .patch_size = f_size(&fil),
+        .rom_size = (uint32_t) (rom_size),
+        .rom_space = ROM_PATCH_SPACE,
+    };
+    uint32_t patched_size;
+
+    trace_phase_begin("ROM patch");
+    rom_patch_err_t err = rom_patch_apply(&io, &patched_size);
+    trace_phase_end();
+
+    f_close(&fil);
+
+    if (err != ROM_PATCH_OK) {
+        debugf("ROM patch: %s: %s\n", path_get(path), rom_patch_convert_error_message(err));
+        path_free(path);
+        return CART_LOAD_ERR_ROM_PATCH_FAIL;
+    }
+
+    debugf("ROM patch: %s applied, ROM size %lu\n", path_get(path), patched_size);
+
+    path_free(path);
+
+    return CART_LOAD_OK;
+}
+
 /**
  * @brief Load an N64 ROM and its save file.
  * 
@@ -96,17 +306,71 @@ char *cart_load_convert_error_message (cart_load_err_t err) {
  * @param progress Progress callback function.
  * @return cart_load_err_t Error code.
  */
-cart_load_err_t cart_load_n64_rom_and_save (menu_t *menu, flashcart_progress_callback_t progress) {
+static cart_load_err_t load_n64_rom_and_save (menu_t *menu, flashcart_progress_callback_t progress) {
     path_t *path = path_clone(menu->load.rom_path);
 
-    bool byte_swap = (menu->load.rom_info.endianness == ENDIANNESS_BYTE_SWAP);
+    flashcart_byte_order_t byte_order = convert_byte_order(menu->load.rom_info.endianness);
     flashcart_save_type_t save_type = convert_save_type(rom_info_get_save_type(&menu->load.rom_info));
+    bool archived = (menu->load.load_archive_id != -1);
+    bool compressed = (file_type_get(path_get(path)) == ENTRY_TYPE_ROM_COMPRESSED);
+    bool streamed = (archived || compressed);
+
+    bool extent_known = streamed || !flashcart_set_rom_extent(path_get(path), &((flashcart_rom_extent_t) {
+        .file_size = menu->load.rom_info.extent.file_size,
+        .timestamp = menu->load.rom_info.extent.timestamp,
+        .data_size = menu->load.rom_info.extent.data_size,
+        .fill = menu->load.rom_info.extent.fill,
+    }));
+
+    flashcart_rom_verify_t verify = {
+        .type = FLASHCART_CHECKSUM_NONE,
+        .expected = menu->load.rom_info.check_code,
+    };
+    if (menu->settings.rom_verify_enabled) {
+        verify.type = convert_checksum_type(rom_info_get_cic_type(&menu->load.rom_info));
+        rom_info_cache_get_check_code(path, &verify.expected);
+        flashcart_set_rom_verify(&verify);
+    }
 
-    menu->flashcart_err = flashcart_load_rom(path_get(path), byte_swap, progress);
+    trace_phase_begin("ROM load");
+    if (archived) {
+        menu->flashcart_err = load_archived_rom(menu, byte_order, progress);
+    } else if (compressed) {
+        menu->flashcart_err = compressed_rom_load(path, progress);
+    } else {
+        menu->flashcart_err = flashcart_load_rom(path_get(path), byte_order, progress);
+    }
+    trace_phase_end();
+    if (streamed && (menu->flashcart_err == FLASHCART_ERR_FUNCTION_NOT_SUPPORTED)) {
+        path_free(path);
+        return CART_LOAD_ERR_FUNCTION_NOT_SUPPORTED;
+    }
+    if (menu->flashcart_err == FLASHCART_ERR_VERIFY) {
+        path_free(path);
+        return CART_LOAD_ERR_ROM_VERIFY_FAIL;
+    }
     if (menu->flashcart_err != FLASHCART_OK) {
         path_free(path);
         return CART_LOAD_ERR_ROM_LOAD_FAIL;
     }
+    if (verify.done) {
+        rom_info_cache_set_check_code(path, verify.computed);
+    }
+
+    flashcart_rom_extent_t extent;
+    if (!extent_known && (flashcart_get_rom_extent(path_get(path), &extent) == FLASHCART_OK)) {
+        if ((extent.file_size - extent.data_size) >= ROM_PADDING_MIN_SIZE) {
+            rom_config_setting_set_extent(path, &menu->load.rom_info, extent.file_size, extent.timestamp, extent.data_size, extent.fill);
+        }
+    }
+
+    if (menu->load.rom_info.settings.patches_enabled) {
+        cart_load_err_t err = apply_rom_patch(menu, byte_order, streamed);
+        if (err != CART_LOAD_OK) {
+            path_free(path);
+            return err;
+        }
+    }
 
     path_ext_replace(path, "sav");
     if (menu->settings.use_saves_folder) {
@@ -117,7 +381,18 @@ cart_load_err_t cart_load_n64_rom_and_save (menu_t *menu, flashcart_progress_cal
         path_push_subdir(path, SAVE_DIRECTORY_NAME);
     }
 
-    menu->flashcart_err = flashcart_load_save(path_get(path), save_type);
+    // NOTE: The save file holds the data written back after the last session, a failed backup doesn't stop the boot
+    if (menu->settings.save_backups_enabled && (save_type != FLASHCART_SAVE_TYPE_NONE) && file_exists(path_get(path))) {
+        trace_phase_begin("Save backup");
+        if (save_backup_update(path)) {
+            debugf("Save backup: Couldn't refresh the backup of %s\n", path_get(path));
+        }
+        trace_phase_end();
+    }
+
+    trace_phase_begin("Save load");
+    menu->flashcart_err = load_save(path, save_type);
+    trace_phase_end();
     if (menu->flashcart_err != FLASHCART_OK) {
         path_free(path);
         return CART_LOAD_ERR_SAVE_LOAD_FAIL;
@@ -141,6 +416,67 @@ cart_load_err_t cart_load_n64_rom_and_save (menu_t *menu, flashcart_progress_cal
     return CART_LOAD_OK;
 }
 
+/**
+ * @brief Load an N64 ROM and its save file.
+ * 
+ * @param menu Pointer to the menu structure.
+ * @param progress Progress callback function.
+ * @return cart_load_err_t Error code.
+ */
+cart_load_err_t cart_load_n64_rom_and_save (menu_t *menu, flashcart_progress_callback_t progress) {
+    // NOTE: The paths built during the load don't outlive it, they are kept off the heap
+    path_scratch_begin();
+    cart_load_err_t err = load_n64_rom_and_save(menu, progress);
+    path_scratch_end();
+    return err;
+}
+
+/**
+ * @brief Load an N64 ROM streamed by the caller straight into the flashcart, without a save file.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param rom_size Size of the ROM image.
+ * @param head Pointer to the start of the ROM image.
+ * @param head_length Length of the data at the start of the ROM image.
+ * @param buffer Buffer for the remaining chunks.
+ * @param chunk_size Size of the chunks and of the buffer.
+ * @param source Callback producing the remaining chunks.
+ * @param arg Callback argument.
+ * @return cart_load_err_t Error code.
+ */
+cart_load_err_t cart_load_n64_rom_stream (menu_t *menu, uint32_t rom_size, const void *head, size_t head_length, void *buffer, size_t chunk_size, fs_chunk_callback_t *source, void *arg) {
+    flashcart_byte_order_t byte_order = convert_byte_order(menu->load.rom_info.endianness);
+    flashcart_save_type_t save_type = convert_save_type(rom_info_get_save_type(&menu->load.rom_info));
+
+    trace_phase_begin("ROM load");
+    menu->flashcart_err = flashcart_load_rom_stream_begin(rom_size, byte_order, NULL);
+    if (menu->flashcart_err == FLASHCART_OK) {
+        bool error = (flashcart_load_rom_stream_write(head, head_length) != FLASHCART_OK);
+        for (size_t offset = head_length; !error && (offset < rom_size); offset += chunk_size) {
+            size_t length = MIN(rom_size - offset, chunk_size);
+            error = source(buffer, offset, length, arg) || (flashcart_load_rom_stream_write(buffer, length) != FLASHCART_OK);
+        }
+        menu->flashcart_err = flashcart_load_rom_stream_end();
+        if ((menu->flashcart_err == FLASHCART_OK) && error) {
+            menu->flashcart_err = FLASHCART_ERR_LOAD;
+        }
+    }
+    trace_phase_end();
+    if (menu->flashcart_err == FLASHCART_ERR_FUNCTION_NOT_SUPPORTED) {
+        return CART_LOAD_ERR_FUNCTION_NOT_SUPPORTED;
+    }
+    if (menu->flashcart_err != FLASHCART_OK) {
+        return CART_LOAD_ERR_ROM_LOAD_FAIL;
+    }
+
+    menu->flashcart_err = flashcart_load_save(NULL, save_type);
+    if (menu->flashcart_err != FLASHCART_OK) {
+        return CART_LOAD_ERR_SAVE_LOAD_FAIL;
+    }
+
+    return CART_LOAD_OK;
+}
+
 /**
  * @brief Load the 64DD IPL and disk.
  * 
@@ -148,7 +484,7 @@ cart_load_err_t cart_load_n64_rom_and_save (menu_t *menu, flashcart_progress_cal
  * @param progress Progress callback function.
  * @return cart_load_err_t Error code.
  */
-cart_load_err_t cart_load_64dd_ipl_and_disk (menu_t *menu, flashcart_progress_callback_t progress) {
+static cart_load_err_t load_64dd_ipl_and_disk (menu_t *menu, flashcart_progress_callback_t progress) {
     if (!flashcart_has_feature(FLASHCART_FEATURE_64DD)) {
         return CART_LOAD_ERR_FUNCTION_NOT_SUPPORTED;
     }
@@ -162,12 +498,26 @@ cart_load_err_t cart_load_64dd_ipl_and_disk (menu_t *menu, flashcart_progress_ca
     }
 
     path_t *path = path_init(menu->storage_prefix, DDIPL_LOCATION);
-    flashcart_disk_parameters_t disk_parameters;
+    flashcart_disk_parameters_t disk_parameters[FLASHCART_64DD_MAX_DISKS];
+    char *disk_paths[FLASHCART_64DD_MAX_DISKS];
+    int disk_count = 0;
+
+    disk_slot_entry_t *disks[FLASHCART_64DD_MAX_DISKS] = { &menu->load.disk_slots.primary };
+    for (int i = 0; (i < menu->load.disk_slots.slot_count) && (i < (FLASHCART_64DD_MAX_DISKS - 1)); i++) {
+        disks[i + 1] = &menu->load.disk_slots.slot[i];
+    }
 
-    disk_parameters.development_drive = (menu->load.disk_slots.primary.disk_info.region == DISK_REGION_DEVELOPMENT);
-    disk_parameters.disk_type = menu->load.disk_slots.primary.disk_info.disk_type;
-    memcpy(disk_parameters.bad_system_area_lbas, menu->load.disk_slots.primary.disk_info.bad_system_area_lbas, sizeof(disk_parameters.bad_system_area_lbas));
-    memcpy(disk_parameters.defect_tracks, menu->load.disk_slots.primary.disk_info.defect_tracks, sizeof(disk_parameters.defect_tracks));
+    for (disk_count = 0; (disk_count < FLASHCART_64DD_MAX_DISKS) && (disks[disk_count] != NULL); disk_count++) {
+        disk_info_t *disk_info = &disks[disk_count]->disk_info;
+        flashcart_disk_parameters_t *parameters = &disk_parameters[disk_count];
+
+        parameters->development_drive = (disk_info->region == DISK_REGION_DEVELOPMENT);
+        parameters->disk_type = disk_info->disk_type;
+        memcpy(parameters->bad_system_area_lbas, disk_info->bad_system_area_lbas, sizeof(parameters->bad_system_area_lbas));
+        memcpy(parameters->defect_tracks, disk_info->defect_tracks, sizeof(parameters->defect_tracks));
+
+        disk_paths[disk_count] = path_get(disks[disk_count]->disk_path);
+    }
 
     switch (menu->load.disk_slots.primary.disk_info.region) {
         case DISK_REGION_DEVELOPMENT:
@@ -194,7 +544,7 @@ cart_load_err_t cart_load_64dd_ipl_and_disk (menu_t *menu, flashcart_progress_ca
 
     path_free(path);
 
-    menu->flashcart_err = flashcart_load_64dd_disk(path_get(menu->load.disk_slots.primary.disk_path), &disk_parameters);
+    menu->flashcart_err = flashcart_load_64dd_disk(disk_paths, disk_parameters, disk_count);
     if (menu->flashcart_err != FLASHCART_OK) {
         return CART_LOAD_ERR_64DD_DISK_LOAD_FAIL;
     }
@@ -202,6 +552,21 @@ cart_load_err_t cart_load_64dd_ipl_and_disk (menu_t *menu, flashcart_progress_ca
     return CART_LOAD_OK;
 }
 
+/**
+ * @brief Load the 64DD IPL and disk.
+ * 
+ * @param menu Pointer to the menu structure.
+ * @param progress Progress callback function.
+ * @return cart_load_err_t Error code.
+ */
+cart_load_err_t cart_load_64dd_ipl_and_disk (menu_t *menu, flashcart_progress_callback_t progress) {
+    // NOTE: The paths built during the load don't outlive it, they are kept off the heap
+    path_scratch_begin();
+    cart_load_err_t err = load_64dd_ipl_and_disk(menu, progress);
+    path_scratch_end();
+    return err;
+}
+
 /**
  * @brief Load an emulator and its ROM.
  * 
@@ -210,7 +575,7 @@ cart_load_err_t cart_load_64dd_ipl_and_disk (menu_t *menu, flashcart_progress_ca
  * @param progress Progress callback function.
  * @return cart_load_err_t Error code.
  */
-cart_load_err_t cart_load_emulator (menu_t *menu, cart_load_emu_type_t emu_type, flashcart_progress_callback_t progress) {
+static cart_load_err_t load_emulator (menu_t *menu, cart_load_emu_type_t emu_type, flashcart_progress_callback_t progress) {
     path_t *path = path_init(menu->storage_prefix, EMU_LOCATION);
 
     flashcart_save_type_t save_type = FLASHCART_SAVE_TYPE_NONE;
@@ -253,7 +618,7 @@ cart_load_err_t cart_load_emulator (menu_t *menu, cart_load_emu_type_t emu_type,
         return CART_LOAD_ERR_EMU_NOT_FOUND;
     }
 
-    menu->flashcart_err = flashcart_load_rom(path_get(path), false, progress);
+    menu->flashcart_err = flashcart_load_rom(path_get(path), FLASHCART_BYTE_ORDER_BIG_ENDIAN, progress);
     if (menu->flashcart_err != FLASHCART_OK) {
         path_free(path);
         return CART_LOAD_ERR_EMU_LOAD_FAIL;
@@ -287,7 +652,7 @@ cart_load_err_t cart_load_emulator (menu_t *menu, cart_load_emu_type_t emu_type,
         path_push_subdir(path, SAVE_DIRECTORY_NAME);
     }
 
-    menu->flashcart_err = flashcart_load_save(path_get(path), save_type);
+    menu->flashcart_err = load_save(path, save_type);
     if (menu->flashcart_err != FLASHCART_OK) {
         path_free(path);
         return CART_LOAD_ERR_SAVE_LOAD_FAIL;
@@ -297,3 +662,19 @@ cart_load_err_t cart_load_emulator (menu_t *menu, cart_load_emu_type_t emu_type,
 
     return CART_LOAD_OK;
 }
+
+/**
+ * @brief Load an emulator and its ROM.
+ * 
+ * @param menu Pointer to the menu structure.
+ * @param emu_type The type of emulator to load.
+ * @param progress Progress callback function.
+ * @return cart_load_err_t Error code.
+ */
+cart_load_err_t cart_load_emulator (menu_t *menu, cart_load_emu_type_t emu_type, flashcart_progress_callback_t progress) {
+    // NOTE: The paths built during the load don't outlive it, they are kept off the heap
+    path_scratch_begin();
+    cart_load_err_t err = load_emulator(menu, emu_type, progress);
+    path_scratch_end();
+    return err;
+}
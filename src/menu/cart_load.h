@@ -11,6 +11,7 @@
 #include "flashcart/flashcart.h"
 #include "menu_state.h"
 #include "rom_info.h"
+#include "utils/fs.h"
 
 #ifndef SAVE_DIRECTORY_NAME
 #define SAVE_DIRECTORY_NAME "saves"
@@ -46,6 +47,10 @@ typedef enum {
     CART_LOAD_ERR_EXP_PAK_NOT_FOUND,
     /** @brief An unexpected response. */
     CART_LOAD_ERR_FUNCTION_NOT_SUPPORTED,
+    /** @brief The loaded ROM data doesn't match its checksum. */
+    CART_LOAD_ERR_ROM_VERIFY_FAIL,
+    /** @brief The ROM patch couldn't be applied. */
+    CART_LOAD_ERR_ROM_PATCH_FAIL,
 } cart_load_err_t;
 
 /** @brief Cart load type enumeration */
@@ -81,6 +86,24 @@ char *cart_load_convert_error_message(cart_load_err_t err);
  */
 cart_load_err_t cart_load_n64_rom_and_save(menu_t *menu, flashcart_progress_callback_t progress);
 
+/**
+ * @brief Load an N64 ROM streamed by the caller straight into the flashcart, without a save file.
+ *
+ * The ROM information must already be parsed from the start of the data into menu->load.rom_info,
+ * the save type is set from it but a save file isn't loaded.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param rom_size Size of the ROM image.
+ * @param head Pointer to the start of the ROM image, already received.
+ * @param head_length Length of the data at the start of the ROM image.
+ * @param buffer Buffer for the remaining chunks.
+ * @param chunk_size Size of the chunks and of the buffer.
+ * @param source Callback producing the remaining chunks.
+ * @param arg Callback argument.
+ * @return cart_load_err_t Error code.
+ */
+cart_load_err_t cart_load_n64_rom_stream(menu_t *menu, uint32_t rom_size, const void *head, size_t head_length, void *buffer, size_t chunk_size, fs_chunk_callback_t *source, void *arg);
+
 /**
  * @brief Load the 64DD IPL (BIOS) and disk.
  * 
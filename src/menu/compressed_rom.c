@@ -0,0 +1,176 @@
+/**
+ * @file compressed_rom.c
+ * @brief Chunked compressed ROM loading implementation
+ * @ingroup menu
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
+#include <libdragon.h>
+
+#include "compressed_rom.h"
+#include "utils/fs.h"
+#include "utils/lz4.h"
+#include "utils/utils.h"
+
+#define COMPRESSED_ROM_MAGIC        (0x4E435231) // "NCR1"
+#define COMPRESSED_ROM_CHUNK_SIZE   (KiB(64))
+#define COMPRESSED_ROM_MAX_SIZE     (MiB(64))
+#define COMPRESSED_ROM_STORED       (1U << 31)
+
+/** @brief Compressed ROM file header structure, followed by the chunk index. */
+typedef struct {
+    uint32_t magic;
+    uint32_t rom_size;
+    uint32_t chunk_size;
+    uint32_t chunk_count;
+} compressed_rom_header_t;
+
+/** @brief Compressed ROM chunk index entry structure. */
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} compressed_rom_chunk_t;
+
+/** @brief Opened compressed ROM file structure. */
+typedef struct {
+    FIL fil;
+    compressed_rom_header_t header;
+    compressed_rom_chunk_t *chunks;
+} compressed_rom_t;
+
+static uint8_t input_buffer[COMPRESSED_ROM_CHUNK_SIZE] __attribute__((aligned(16)));
+static uint8_t output_buffer[COMPRESSED_ROM_CHUNK_SIZE] __attribute__((aligned(16)));
+
+
+static void compressed_rom_close (compressed_rom_t *rom) {
+    free(rom->chunks);
+    rom->chunks = NULL;
+    f_close(&rom->fil);
+}
+
+static bool compressed_rom_open (path_t *path, compressed_rom_t *rom) {
+    UINT br;
+
+    rom->chunks = NULL;
+
+    if (f_open(&rom->fil, strip_fs_prefix(path_get(path)), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    compressed_rom_header_t *header = &rom->header;
+
+    if ((f_read(&rom->fil, header, sizeof(*header), &br) != FR_OK) || (br != sizeof(*header))) {
+        f_close(&rom->fil);
+        return true;
+    }
+
+    if (
+        (header->magic != COMPRESSED_ROM_MAGIC) ||
+        (header->rom_size == 0) ||
+        (header->rom_size > COMPRESSED_ROM_MAX_SIZE) ||
+        (header->chunk_size != COMPRESSED_ROM_CHUNK_SIZE) ||
+        (header->chunk_count != ((header->rom_size + header->chunk_size - 1) / header->chunk_size))
+    ) {
+        f_close(&rom->fil);
+        return true;
+    }
+
+    size_t index_size = header->chunk_count * sizeof(compressed_rom_chunk_t);
+
+    if ((rom->chunks = malloc(index_size)) == NULL) {
+        f_close(&rom->fil);
+        return true;
+    }
+
+    if ((f_read(&rom->fil, rom->chunks, index_size, &br) != FR_OK) || (br != index_size)) {
+        compressed_rom_close(rom);
+        return true;
+    }
+
+    return false;
+}
+
+static size_t compressed_rom_chunk_size (compressed_rom_t *rom, uint32_t index) {
+    return MIN(rom->header.chunk_size, rom->header.rom_size - (index * rom->header.chunk_size));
+}
+
+static bool compressed_rom_decompress_chunk (compressed_rom_t *rom, uint32_t index) {
+    compressed_rom_chunk_t *chunk = &rom->chunks[index];
+    size_t expected = compressed_rom_chunk_size(rom, index);
+    size_t length = (chunk->length & ~(COMPRESSED_ROM_STORED));
+    UINT br;
+
+    if ((length > sizeof(input_buffer)) || (f_lseek(&rom->fil, chunk->offset) != FR_OK)) {
+        return true;
+    }
+
+    if (chunk->length & COMPRESSED_ROM_STORED) {
+        return (length != expected) || (f_read(&rom->fil, output_buffer, length, &br) != FR_OK) || (br != length);
+    }
+
+    if ((f_read(&rom->fil, input_buffer, length, &br) != FR_OK) || (br != length)) {
+        return true;
+    }
+
+    return (lz4_decompress_block(input_buffer, length, output_buffer, sizeof(output_buffer)) != (int) (expected));
+}
+
+bool compressed_rom_read_header (path_t *path, void *buffer, size_t length) {
+    compressed_rom_t rom;
+
+    if (compressed_rom_open(path, &rom)) {
+        return true;
+    }
+
+    bool error = (length > compressed_rom_chunk_size(&rom, 0)) || compressed_rom_decompress_chunk(&rom, 0);
+
+    if (!error) {
+        memcpy(buffer, output_buffer, length);
+    }
+
+    compressed_rom_close(&rom);
+
+    return error;
+}
+
+flashcart_err_t compressed_rom_load (path_t *path, flashcart_progress_callback_t *progress) {
+    compressed_rom_t rom;
+    flashcart_err_t err;
+
+    if (compressed_rom_open(path, &rom)) {
+        return FLASHCART_ERR_LOAD;
+    }
+
+    if ((err = flashcart_load_rom_stream_begin(rom.header.rom_size, FLASHCART_BYTE_ORDER_BIG_ENDIAN, progress)) != FLASHCART_OK) {
+        compressed_rom_close(&rom);
+        return err;
+    }
+
+    for (uint32_t i = 0; (i < rom.header.chunk_count) && (err == FLASHCART_OK); i++) {
+        compressed_rom_chunk_t *chunk = &rom.chunks[i];
+        size_t expected = compressed_rom_chunk_size(&rom, i);
+
+        if (chunk->length & COMPRESSED_ROM_STORED) {
+            // NOTE: Incompressible data skips the CPU entirely, same as a regular ROM load
+            if (((chunk->length & ~(COMPRESSED_ROM_STORED)) != expected) || (f_lseek(&rom.fil, chunk->offset) != FR_OK)) {
+                err = FLASHCART_ERR_LOAD;
+            } else {
+                err = flashcart_load_rom_stream_read(&rom.fil, expected);
+            }
+        } else if (compressed_rom_decompress_chunk(&rom, i)) {
+            err = FLASHCART_ERR_LOAD;
+        } else {
+            // NOTE: The staging buffer is sent to the cart SDRAM while the next chunk is read and decompressed
+            err = flashcart_load_rom_stream_write(output_buffer, expected);
+        }
+    }
+
+    flashcart_err_t end_err = flashcart_load_rom_stream_end();
+
+    compressed_rom_close(&rom);
+
+    return (err != FLASHCART_OK) ? err : end_err;
+}
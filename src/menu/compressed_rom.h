@@ -0,0 +1,39 @@
+/**
+ * @file compressed_rom.h
+ * @brief Chunked compressed ROM loading
+ * @ingroup menu
+ */
+
+#ifndef COMPRESSED_ROM_H__
+#define COMPRESSED_ROM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "flashcart/flashcart.h"
+#include "path.h"
+
+/**
+ * @brief Read the start of the ROM image stored in a compressed ROM file.
+ *
+ * Only the first chunk is decompressed.
+ *
+ * @param path Pointer to the compressed ROM file path.
+ * @param buffer Pointer to the output buffer.
+ * @param length Number of bytes to read.
+ * @return true if an error occurred, false otherwise.
+ */
+bool compressed_rom_read_header(path_t *path, void *buffer, size_t length);
+
+/**
+ * @brief Load a compressed ROM file onto the flashcart.
+ *
+ * Compressed chunks are decompressed on the CPU, stored chunks are read straight into the cart SDRAM.
+ *
+ * @param path Pointer to the compressed ROM file path.
+ * @param progress Callback function for progress updates.
+ * @return flashcart_err_t Error code.
+ */
+flashcart_err_t compressed_rom_load(path_t *path, flashcart_progress_callback_t *progress);
+
+#endif /* COMPRESSED_ROM_H__ */
@@ -3,10 +3,23 @@
 #include <string.h>
 #include <libdragon.h> // only included for debugf
 #include <sys/stat.h>
+#include <fatfs/ff.h>
+#include "utils/fs.h"
 #include "utils/utils.h"
 
 
 #define MAX_FILE_SIZE KiB(128)
+#define CHEAT_CACHE_MAGIC (0x43484331) // "CHC1"
+#define CHEAT_CACHE_EXTENSION "bin"
+
+/** @brief Compiled cheat cache file Structure. */
+typedef struct {
+    uint32_t magic; /**< Cache file magic */
+    uint32_t timestamp; /**< FAT timestamp of the cheat text file */
+    uint32_t source_size; /**< Size of the cheat text file */
+    uint32_t codes; /**< Number of parsed cheat codes */
+    cheat_file_code_t cheat_codes[MAX_CHEAT_CODES]; /**< Parsed cheat codes */
+} cheat_cache_t;
 
 /** @brief Text file structure */
 typedef struct {
@@ -211,10 +224,111 @@ void cheat_file_open_res_debug(cheat_file_load_err_t res) {
     }
 }
 
+/**
+ * @brief Get the path of the compiled cheat cache, stored next to the cheat text file.
+ *
+ * @param path Path to the cheat text file.
+ * @return Pointer to the cache file path, must be freed by the caller.
+ */
+static char *get_cheat_cache_path(char *path) {
+    char *extension = strrchr(file_basename(path), '.');
+    size_t base_length = extension ? (size_t) (extension - path) : strlen(path);
+    char *cache_path = malloc(base_length + strlen(CHEAT_CACHE_EXTENSION) + 2);
+
+    if (cache_path) {
+        sprintf(cache_path, "%.*s.%s", (int) (base_length), path, CHEAT_CACHE_EXTENSION);
+    }
+
+    return cache_path;
+}
+
+/**
+ * @brief Get the FAT timestamp and size of the cheat text file.
+ *
+ * @param path Path to the cheat text file.
+ * @param timestamp Pointer to store the timestamp.
+ * @param size Pointer to store the size.
+ * @return true if the file couldn't be found, false otherwise.
+ */
+static bool get_cheat_file_stamp(char *path, uint32_t *timestamp, uint32_t *size) {
+    FILINFO info;
+
+    if (f_stat(strip_fs_prefix(path), &info) != FR_OK) {
+        return true;
+    }
+
+    *timestamp = ((info.fdate << 16) | info.ftime);
+    *size = (uint32_t) (info.fsize);
+
+    return false;
+}
+
+/**
+ * @brief Load the parsed cheat codes from the compiled cache.
+ *
+ * @param path Path to the cheat text file.
+ * @return true if the cache is missing or outdated, false otherwise.
+ */
+static bool load_cheat_cache(char *path) {
+    uint32_t timestamp, size;
+    if (get_cheat_file_stamp(path, &timestamp, &size)) {
+        return true;
+    }
+
+    char *cache_path = get_cheat_cache_path(path);
+    cheat_cache_t *cache = malloc(sizeof(cheat_cache_t));
+    bool error = (cache_path == NULL) || (cache == NULL) || file_read_range(cache_path, 0, cache, sizeof(cheat_cache_t));
+
+    if (!error) {
+        error = (cache->magic != CHEAT_CACHE_MAGIC) ||
+            (cache->timestamp != timestamp) ||
+            (cache->source_size != size) ||
+            (cache->codes > MAX_CHEAT_CODES);
+    }
+
+    if (!error) {
+        set_cheat_codes(cache->cheat_codes);
+        debugf("Cheat Editor: Loaded %lu cheat codes from cache.\n", cache->codes);
+    }
+
+    free(cache);
+    free(cache_path);
+
+    return error;
+}
+
+/**
+ * @brief Store the parsed cheat codes in the compiled cache.
+ *
+ * @param path Path to the cheat text file.
+ * @param codes Parsed cheat codes, as they would be read back from the text file.
+ * @param count Number of parsed cheat codes.
+ */
+static void save_cheat_cache(char *path, cheat_file_code_t *codes, int count) {
+    cheat_cache_t *cache = calloc(1, sizeof(cheat_cache_t));
+    char *cache_path = get_cheat_cache_path(path);
+
+    if (cache && cache_path && !get_cheat_file_stamp(path, &cache->timestamp, &cache->source_size)) {
+        cache->magic = CHEAT_CACHE_MAGIC;
+        cache->codes = count;
+        memcpy(cache->cheat_codes, codes, sizeof(cheat_file_code_t) * count);
+        if (file_write_all(cache_path, cache, sizeof(cheat_cache_t))) {
+            debugf("Cheat Editor: Failed to write cheat cache %s.\n", cache_path);
+        }
+    }
+
+    free(cache_path);
+    free(cache);
+}
+
 void load_cheats_from_file(char *path) {
 
     debugf("Cheat Editor: Loading cheats from path %s.\n", path);
 
+    if (!load_cheat_cache(path)) {
+        return;
+    }
+
     set_cheat_codes(NULL);
     cheat_file_load_err_t res_file_open = open_cheat_file(path);
 
@@ -261,12 +375,9 @@ void load_cheats_from_file(char *path) {
 
         deinit_cheat_file();
 
-        // --DEBUG CODE
-        uint32_t cheats[MAX_CHEAT_CODE_ARRAYLIST_SIZE];
-        size_t cheat_item_count = generate_enabled_cheats_array(get_cheat_codes(), cheats);
-        debugf("Cheat Editor: Parsed and generated %u cheat items from file.\n", cheat_item_count);
-        // --END DEBUG CODE
+        debugf("Cheat Editor: Parsed %d cheat codes from file.\n", code_count);
 
+        save_cheat_cache(path, cheat_codes, code_count);
     }
     else {
         cheat_file_open_res_debug(res_file_open);
@@ -283,9 +394,13 @@ void save_cheats_to_file(char *path) {
         return;
     }
 
+    cheat_file_code_t saved_codes[MAX_CHEAT_CODES];
+    int saved_count = 0;
+
     for (int i = 0; i < MAX_CHEAT_CODES; ++i) {
         cheat_file_code_t *code = &cheat_codes[i];
         if (code->address != 0) { //code->enabled &&
+            saved_codes[saved_count++] = *code;
             if (!code->enabled) {
                 fprintf(f, ": ");
             } 
@@ -300,4 +415,7 @@ void save_cheats_to_file(char *path) {
     fclose(f);
     debugf("Cheat Editor: Cheats saved to %s.\n", path);
 
+    // NOTE: The FAT timestamp has a two second resolution, so the cache is refreshed here instead of relying on it
+    save_cheat_cache(path, saved_codes, saved_count);
+
 }
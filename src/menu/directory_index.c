@@ -0,0 +1,373 @@
+/**
+ * @file directory_index.c
+ * @brief Persistent directory listing index implementation
+ * @ingroup menu
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
+
+#include "directory_index.h"
+#include "utils/fs.h"
+#include "utils/hash.h"
+
+#define DIRECTORY_INDEX_MAGIC       (0x42444933) // "BDI3"
+#define VOLUME_STAMP_MAGIC          (0x42445653) // "BDVS"
+#define VOLUME_STAMP_FILE           "volume.stamp"
+
+/** @brief Directory Index File Header Structure. */
+typedef struct {
+    uint32_t magic; /**< Index file magic */
+    uint32_t timestamp; /**< Directory FAT timestamp */
+    uint32_t content_hash; /**< Hash of the directory entries */
+    uint32_t filter; /**< Filter used for the listing */
+    uint32_t sort; /**< Order of the entries */
+    uint32_t entries; /**< Number of entry records */
+    uint32_t names_length; /**< Length of the name pool */
+} directory_index_header_t;
+
+/** @brief Volume Stamp File Structure. */
+typedef struct {
+    uint32_t magic; /**< Stamp file magic, cleared while the menu is running */
+    uint32_t free_clusters; /**< Number of free clusters on the volume when the menu was closed */
+} volume_stamp_t;
+
+/** @brief Directory Index Entry Record Structure. */
+typedef struct {
+    uint32_t name_offset; /**< Offset of the name in the name pool */
+    int32_t index; /**< Position of the entry in the directory */
+    int64_t size; /**< File size */
+    uint32_t type; /**< Entry type */
+    uint32_t reserved; /**< Unused */
+} directory_index_record_t;
+
+static char *directory_index_path = NULL;
+
+/**
+ * @brief Get the values an index file is validated against.
+ *
+ * The FAT timestamp of a directory is rarely updated when its contents change, so all the
+ * directory entries and their count are hashed as well. Reading the raw entries is much cheaper
+ * than building, classifying and sorting the listing the index holds.
+ *
+ * @param directory Pointer to the directory path.
+ * @param timestamp Pointer to store the directory timestamp.
+ * @param content_hash Pointer to store the hash of the directory entries.
+ * @return true if the directory can't be read, false otherwise.
+ */
+static bool get_directory_signature (path_t *directory, uint32_t *timestamp, uint32_t *content_hash) {
+    DIR dp;
+    FILINFO info;
+    char *fs_path = strip_fs_prefix(path_get(directory));
+
+    if (path_is_root(directory) || (f_stat(fs_path, &info) != FR_OK)) {
+        return true;
+    }
+
+    *timestamp = ((info.fdate << 16) | info.ftime);
+
+    if (f_opendir(&dp, fs_path) != FR_OK) {
+        return true;
+    }
+
+    uint32_t hash = FNV1A32_INIT;
+    uint32_t entries = 0;
+    bool error = false;
+
+    while (true) {
+        if (f_readdir(&dp, &info) != FR_OK) {
+            error = true;
+            break;
+        }
+        if (info.fname[0] == '\0') {
+            break;
+        }
+        uint32_t attributes[] = { (uint32_t) (info.fsize), (uint32_t) ((uint64_t) (info.fsize) >> 32), ((info.fdate << 16) | info.ftime), info.fattrib };
+        hash = fnv1a32(hash, info.fname, strlen(info.fname));
+        hash = fnv1a32(hash, attributes, sizeof(attributes));
+        entries += 1;
+    }
+
+    hash = fnv1a32(hash, &entries, sizeof(entries));
+
+    if (f_closedir(&dp) != FR_OK) {
+        error = true;
+    }
+
+    *content_hash = hash;
+
+    return error;
+}
+
+static path_t *get_index_file_path (path_t *directory) {
+    char name[16];
+
+    snprintf(name, sizeof(name), "%08lX.idx", (unsigned long) (fnv1a32_string(path_get(directory))));
+
+    path_t *path = path_create(directory_index_path);
+    path_push(path, name);
+
+    return path;
+}
+
+static path_t *get_volume_stamp_path (void) {
+    path_t *path = path_create(directory_index_path);
+    path_push(path, VOLUME_STAMP_FILE);
+    return path;
+}
+
+static bool get_free_clusters (uint32_t *free_clusters) {
+    DWORD clusters;
+    FATFS *fs;
+
+    if (f_getfree(strip_fs_prefix(directory_index_path), &clusters, &fs) != FR_OK) {
+        return true;
+    }
+
+    *free_clusters = clusters;
+
+    return false;
+}
+
+static bool volume_stamp_write (path_t *path, volume_stamp_t *stamp) {
+    FIL fil;
+    UINT bytes_written;
+
+    if (f_open(&fil, strip_fs_prefix(path_get(path)), FA_WRITE | FA_OPEN_ALWAYS) != FR_OK) {
+        return true;
+    }
+
+    bool error = (f_write(&fil, stamp, sizeof(volume_stamp_t), &bytes_written) != FR_OK) || (bytes_written != sizeof(volume_stamp_t));
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Check the volume stamp left by the last menu session and invalidate it.
+ *
+ * @return true if the SD card may have been modified off-device, false otherwise.
+ */
+static bool volume_stamp_check (void) {
+    volume_stamp_t stamp;
+    uint32_t free_clusters;
+    size_t length;
+
+    path_t *path = get_volume_stamp_path();
+
+    bool modified = (
+        file_read_all(path_get(path), &stamp, sizeof(stamp), &length) ||
+        (length != sizeof(stamp)) ||
+        (stamp.magic != VOLUME_STAMP_MAGIC) ||
+        get_free_clusters(&free_clusters) ||
+        (stamp.free_clusters != free_clusters)
+    );
+
+    // NOTE: The stamp is overwritten in place, a menu session ending without directory_index_deinit leaves no valid stamp behind
+    if (file_exists(path_get(path))) {
+        volume_stamp_write(path, &((volume_stamp_t) { 0 }));
+    }
+
+    path_free(path);
+
+    return modified;
+}
+
+static void remove_index_files (void) {
+    DIR dp;
+    FILINFO info;
+
+    path_t *path = path_create(directory_index_path);
+
+    if (f_opendir(&dp, strip_fs_prefix(path_get(path))) != FR_OK) {
+        path_free(path);
+        return;
+    }
+
+    while ((f_readdir(&dp, &info) == FR_OK) && (info.fname[0] != '\0')) {
+        if (!(info.fattrib & AM_DIR) && file_has_extensions(info.fname, (const char *[]) { "idx", NULL })) {
+            path_push(path, info.fname);
+            f_unlink(strip_fs_prefix(path_get(path)));
+            path_pop(path);
+        }
+    }
+
+    f_closedir(&dp);
+
+    path_free(path);
+}
+
+void directory_index_init (char *index_location) {
+    free(directory_index_path);
+    directory_index_path = NULL;
+
+    if (directory_create(index_location)) {
+        return;
+    }
+
+    directory_index_path = strdup(index_location);
+
+    if (volume_stamp_check()) {
+        remove_index_files();
+    }
+}
+
+void directory_index_deinit (void) {
+    uint32_t free_clusters;
+
+    if (directory_index_path == NULL) {
+        return;
+    }
+
+    path_t *path = get_volume_stamp_path();
+
+    // NOTE: The stamp file is created first, the free cluster count must already include its own cluster
+    volume_stamp_t stamp = { 0 };
+    if (!volume_stamp_write(path, &stamp) && !get_free_clusters(&free_clusters)) {
+        stamp = (volume_stamp_t) {
+            .magic = VOLUME_STAMP_MAGIC,
+            .free_clusters = free_clusters,
+        };
+        volume_stamp_write(path, &stamp);
+    }
+
+    path_free(path);
+}
+
+bool directory_index_load (path_t *directory, uint32_t filter, directory_index_listing_t *listing) {
+    FILE *f;
+    uint32_t timestamp;
+    uint32_t content_hash;
+    directory_index_header_t header;
+
+    if ((directory_index_path == NULL) || get_directory_signature(directory, &timestamp, &content_hash)) {
+        return true;
+    }
+
+    path_t *path = get_index_file_path(directory);
+    f = fopen(path_get(path), "rb");
+    path_free(path);
+
+    if (f == NULL) {
+        return true;
+    }
+
+    if (
+        (fread(&header, sizeof(header), 1, f) != 1) ||
+        (header.magic != DIRECTORY_INDEX_MAGIC) ||
+        (header.timestamp != timestamp) ||
+        (header.content_hash != content_hash) ||
+        (header.filter != filter) ||
+        (header.entries == 0)
+    ) {
+        fclose(f);
+        return true;
+    }
+
+    directory_index_record_t *records = malloc(header.entries * sizeof(directory_index_record_t));
+    listing->list = malloc(header.entries * sizeof(entry_t));
+    listing->names = malloc(header.names_length);
+
+    bool error = (records == NULL) || (listing->list == NULL) || (listing->names == NULL);
+
+    error = error || (fread(records, sizeof(directory_index_record_t), header.entries, f) != header.entries);
+    error = error || (fread(listing->names, header.names_length, 1, f) != 1);
+
+    fclose(f);
+
+    for (uint32_t i = 0; !error && (i < header.entries); i++) {
+        if (records[i].name_offset >= header.names_length) {
+            error = true;
+            break;
+        }
+        listing->list[i] = (entry_t) {
+            .name = &listing->names[records[i].name_offset],
+            .type = (entry_type_t) (records[i].type),
+            .size = records[i].size,
+            .index = records[i].index,
+        };
+    }
+
+    free(records);
+
+    if (error || (listing->names[header.names_length - 1] != '\0')) {
+        free(listing->list);
+        free(listing->names);
+        listing->list = NULL;
+        listing->names = NULL;
+        return true;
+    }
+
+    listing->entries = header.entries;
+    listing->names_length = header.names_length;
+    listing->filter = header.filter;
+    listing->sort = (browser_sort_t) (header.sort);
+
+    return false;
+}
+
+void directory_index_save (path_t *directory, directory_index_listing_t *listing) {
+    FILE *f;
+    uint32_t timestamp;
+    uint32_t content_hash;
+
+    if ((directory_index_path == NULL) || get_directory_signature(directory, &timestamp, &content_hash)) {
+        return;
+    }
+
+    directory_index_record_t *records = malloc(listing->entries * sizeof(directory_index_record_t));
+    if (records == NULL) {
+        return;
+    }
+
+    for (int32_t i = 0; i < listing->entries; i++) {
+        records[i] = (directory_index_record_t) {
+            .name_offset = (listing->list[i].name - listing->names),
+            .index = listing->list[i].index,
+            .size = listing->list[i].size,
+            .type = listing->list[i].type,
+        };
+    }
+
+    directory_index_header_t header = {
+        .magic = DIRECTORY_INDEX_MAGIC,
+        .timestamp = timestamp,
+        .content_hash = content_hash,
+        .filter = listing->filter,
+        .sort = listing->sort,
+        .entries = listing->entries,
+        .names_length = listing->names_length,
+    };
+
+    path_t *path = get_index_file_path(directory);
+
+    if ((f = fopen(path_get(path), "wb")) != NULL) {
+        bool error = (fwrite(&header, sizeof(header), 1, f) != 1);
+        error = error || (fwrite(records, sizeof(directory_index_record_t), listing->entries, f) != (size_t) (listing->entries));
+        error = error || (fwrite(listing->names, listing->names_length, 1, f) != 1);
+        if (fclose(f) || error) {
+            remove(path_get(path));
+        }
+    }
+
+    path_free(path);
+    free(records);
+}
+
+void directory_index_remove (path_t *directory) {
+    if (directory_index_path == NULL) {
+        return;
+    }
+
+    path_t *path = get_index_file_path(directory);
+    if (file_exists(path_get(path))) {
+        remove(path_get(path));
+    }
+    path_free(path);
+}
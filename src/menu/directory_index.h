@@ -0,0 +1,73 @@
+/**
+ * @file directory_index.h
+ * @brief Persistent directory listing index
+ * @ingroup menu
+ */
+
+#ifndef DIRECTORY_INDEX_H__
+#define DIRECTORY_INDEX_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "menu_state.h"
+#include "path.h"
+
+/** @brief Minimum number of entries for a directory listing to be indexed. */
+#define DIRECTORY_INDEX_MIN_ENTRIES (256)
+
+/** @brief Directory Index Listing Structure. */
+typedef struct {
+    entry_t *list; /**< Entries, names point into the name pool */
+    char *names; /**< Name pool */
+    int32_t entries; /**< Number of entries */
+    size_t names_length; /**< Length of the name pool */
+    uint32_t filter; /**< Caller defined value describing how the listing was filtered */
+    browser_sort_t sort; /**< Order of the entries */
+} directory_index_listing_t;
+
+/**
+ * @brief Initialize the directory index.
+ *
+ * All index files are removed when the SD card may have been modified off-device,
+ * detected by the free space recorded by directory_index_deinit.
+ *
+ * @param index_location Path to the directory holding the index files.
+ */
+void directory_index_init(char *index_location);
+
+/**
+ * @brief Deinitialize the directory index, recording the free space of the SD card for the next session.
+ */
+void directory_index_deinit(void);
+
+/**
+ * @brief Load the listing of a directory from its index file.
+ *
+ * The index is only used when the directory timestamp, the hash of the directory entries
+ * and the filter match the stored values.
+ *
+ * @param directory Pointer to the directory path.
+ * @param filter Filter the listing must have been created with.
+ * @param listing Pointer to the listing, the list and the name pool are allocated for the caller.
+ * @return true if the directory has no valid index, false otherwise.
+ */
+bool directory_index_load(path_t *directory, uint32_t filter, directory_index_listing_t *listing);
+
+/**
+ * @brief Store the listing of a directory in its index file.
+ *
+ * @param directory Pointer to the directory path.
+ * @param listing Pointer to the listing.
+ */
+void directory_index_save(path_t *directory, directory_index_listing_t *listing);
+
+/**
+ * @brief Remove the index file of a directory.
+ *
+ * @param directory Pointer to the directory path.
+ */
+void directory_index_remove(path_t *directory);
+
+#endif /* DIRECTORY_INDEX_H__ */
@@ -7,10 +7,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <fatfs/ff.h>
+
 #include "disk_info.h"
 #include "utils/fs.h"
+#include "utils/hash.h"
 
 #define SECTORS_PER_BLOCK                   (85)
 #define DISK_ZONES                          (16)
@@ -19,6 +23,7 @@
 #define SYSTEM_AREA_SECTOR_LENGTH           (232)
 #define SYSTEM_AREA_LBA_LENGTH              (SYSTEM_AREA_SECTOR_LENGTH * SECTORS_PER_BLOCK)
 #define SYSTEM_AREA_LBA_COUNT               (24)
+#define SYSTEM_AREA_LOADED_LBA_COUNT        (16)
 
 #define SYSTEM_DATA_LBA_COUNT               (8)
 #define DISK_ID_LBA_COUNT                   (2)
@@ -30,6 +35,9 @@
 #define REGION_ID_JAPANESE                  (0xE848D316)
 #define REGION_ID_USA                       (0x2263EE56)
 
+#define DISK_INFO_CACHE_MAGIC               (0x44494331) // "DIC1"
+#define DISK_INFO_CACHE_ENTRIES             (64)
+
 #define GET_U32(b)                          (((b)[0] << 24) | ((b)[1] << 16) | ((b)[2] << 8) | (b)[3])
 
 static const int tracks_per_zone[DISK_ZONES] = {
@@ -42,22 +50,38 @@ static const int disk_id_lbas[DISK_ID_LBA_COUNT] = {
     15, 14
 };
 
+/** @brief Disk Information Cache Entry Structure. */
+typedef struct {
+    uint32_t magic; /**< Entry magic, zero for empty entries */
+    uint32_t file_size; /**< Disk image file size */
+    uint32_t timestamp; /**< Disk image file FAT timestamp */
+    uint32_t reserved; /**< Unused, keeps the path hash aligned */
+    uint64_t path_hash; /**< FNV-1a hash of the disk image path */
+    disk_info_t disk_info; /**< Disk information parsed from the system area */
+} disk_info_cache_entry_t;
+
+static char *disk_info_cache_path = NULL;
+
 /**
- * @brief Load a system area LBA from the disk.
+ * @brief Get a pointer to a system area LBA in the loaded system area.
+ * 
+ * @param system_area Buffer containing the loaded system area.
+ * @param lba Logical block address.
+ * @return uint8_t* Pointer to the LBA data.
+ */
+static uint8_t *get_system_area_lba (uint8_t *system_area, int lba) {
+    return &system_area[SYSTEM_AREA_LBA_LENGTH * lba];
+}
+
+/**
+ * @brief Load all system area LBAs used by the disk information with a single read.
  * 
  * @param f File pointer to the disk image.
- * @param lba Logical block address to load.
- * @param buffer Buffer to store the loaded data.
+ * @param system_area Buffer to store the loaded data.
  * @return true if an error occurred, false otherwise.
  */
-static bool load_system_area_lba (FILE *f, int lba, uint8_t *buffer) {
-    if (lba >= SYSTEM_AREA_LBA_COUNT) {
-        return true;
-    }
-    if (fseek(f, SYSTEM_AREA_LBA_LENGTH * lba, SEEK_SET)) {
-        return true;
-    }
-    if (fread(buffer, SYSTEM_AREA_LBA_LENGTH, 1, f) != 1) {
+static bool load_system_area (FILE *f, uint8_t *system_area) {
+    if (fread(system_area, SYSTEM_AREA_LBA_LENGTH, SYSTEM_AREA_LOADED_LBA_COUNT, f) != SYSTEM_AREA_LOADED_LBA_COUNT) {
         return true;
     }
     return false;
@@ -146,24 +170,20 @@ static void update_bad_system_area_lbas (disk_info_t *disk_info) {
 }
 
 /**
- * @brief Load and verify the system data LBA from the disk.
+ * @brief Verify the system data LBA in the loaded system area.
  * 
- * @param f File pointer to the disk image.
+ * @param system_area Buffer containing the loaded system area.
  * @param disk_info Pointer to the disk information structure.
  * @return disk_err_t Error code.
  */
-static disk_err_t load_and_verify_system_data_lba (FILE *f, disk_info_t *disk_info) {
-    uint8_t buffer[SYSTEM_AREA_LBA_LENGTH];
+static disk_err_t verify_system_data (uint8_t *system_area, disk_info_t *disk_info) {
     int sector_length;
 
     bool valid_system_data_lba_found = false;
 
     for (int i = 0; i < SYSTEM_DATA_LBA_COUNT; i++) {
         int lba = system_data_lbas[i];
-
-        if (load_system_area_lba(f, lba, buffer)) {
-            return DISK_ERR_IO;
-        }
+        uint8_t *buffer = get_system_area_lba(system_area, lba);
 
         switch (GET_U32(&buffer[0])) {
             case REGION_ID_DEVELOPMENT:
@@ -195,23 +215,18 @@ static disk_err_t load_and_verify_system_data_lba (FILE *f, disk_info_t *disk_in
 }
 
 /**
- * @brief Load and verify the disk ID LBA from the disk.
+ * @brief Verify the disk ID LBA in the loaded system area.
  * 
- * @param f File pointer to the disk image.
+ * @param system_area Buffer containing the loaded system area.
  * @param disk_info Pointer to the disk information structure.
  * @return disk_err_t Error code.
  */
-static disk_err_t load_and_verify_disk_id_lba (FILE *f, disk_info_t *disk_info) {
-    uint8_t buffer[SYSTEM_AREA_LBA_LENGTH];
-
+static disk_err_t verify_disk_id (uint8_t *system_area, disk_info_t *disk_info) {
     bool valid_disk_id_lba_found = false;
 
     for (int i = 0; i < DISK_ID_LBA_COUNT; i++) {
         int lba = disk_id_lbas[i];
-
-        if (load_system_area_lba(f, lba, buffer)) {
-            return DISK_ERR_IO;
-        }
+        uint8_t *buffer = get_system_area_lba(system_area, lba);
 
         if (verify_system_area_lba(buffer, SYSTEM_AREA_SECTOR_LENGTH)) {
             valid_disk_id_lba_found = true;
@@ -226,37 +241,186 @@ static disk_err_t load_and_verify_disk_id_lba (FILE *f, disk_info_t *disk_info)
 }
 
 /**
- * @brief Load the disk information from the specified path.
+ * @brief Fill the cache entry key for the disk image.
+ * 
+ * @param path Pointer to the path structure.
+ * @param entry Pointer to the cache entry.
+ * @return true if the disk image can't be cached, false otherwise.
+ */
+static bool disk_info_cache_describe (path_t *path, disk_info_cache_entry_t *entry) {
+    FILINFO info;
+
+    if (disk_info_cache_path == NULL) {
+        return true;
+    }
+
+    if (f_stat(strip_fs_prefix(path_get(path)), &info) != FR_OK) {
+        return true;
+    }
+
+    memset(entry, 0, sizeof(disk_info_cache_entry_t));
+    entry->magic = DISK_INFO_CACHE_MAGIC;
+    entry->file_size = info.fsize;
+    entry->timestamp = ((info.fdate << 16) | info.ftime);
+    entry->path_hash = fnv1a64_string(path_get(path));
+
+    return false;
+}
+
+/**
+ * @brief Get the cache file offset of the entry slot.
+ * 
+ * @param entry Pointer to the cache entry.
+ * @return long Offset in the cache file.
+ */
+static long disk_info_cache_offset (disk_info_cache_entry_t *entry) {
+    return hash_slot_offset(entry->path_hash, DISK_INFO_CACHE_ENTRIES, sizeof(disk_info_cache_entry_t));
+}
+
+/**
+ * @brief Find the disk information in the cache.
+ * 
+ * @param entry Pointer to the cache entry, the disk information is filled on a hit.
+ * @return true if the disk image was not found in the cache, false otherwise.
+ */
+static bool disk_info_cache_find (disk_info_cache_entry_t *entry) {
+    FILE *f;
+    disk_info_cache_entry_t cached;
+
+    if ((f = fopen(disk_info_cache_path, "rb")) == NULL) {
+        return true;
+    }
+    setbuf(f, NULL);
+
+    bool error = (fseek(f, disk_info_cache_offset(entry), SEEK_SET) != 0) || (fread(&cached, sizeof(cached), 1, f) != 1);
+
+    fclose(f);
+
+    if (error || (cached.magic != entry->magic) || (cached.path_hash != entry->path_hash) || (cached.file_size != entry->file_size) || (cached.timestamp != entry->timestamp)) {
+        return true;
+    }
+
+    entry->disk_info = cached.disk_info;
+
+    return false;
+}
+
+/**
+ * @brief Store the disk information in the cache.
+ * 
+ * @param entry Pointer to the cache entry.
+ */
+static void disk_info_cache_store (disk_info_cache_entry_t *entry) {
+    FILE *f;
+
+    if ((f = fopen(disk_info_cache_path, "r+b")) == NULL) {
+        return;
+    }
+    setbuf(f, NULL);
+
+    if (fseek(f, disk_info_cache_offset(entry), SEEK_SET) == 0) {
+        fwrite(entry, sizeof(disk_info_cache_entry_t), 1, f);
+    }
+
+    fclose(f);
+}
+
+/**
+ * @brief Initialize the disk information cache.
+ * 
+ * @param cache_location Path to the cache file.
+ */
+void disk_info_cache_init (char *cache_location) {
+    free(disk_info_cache_path);
+    disk_info_cache_path = NULL;
+
+    size_t cache_size = (DISK_INFO_CACHE_ENTRIES * sizeof(disk_info_cache_entry_t));
+
+    if (file_get_size(cache_location) != (int64_t) (cache_size)) {
+        if (file_allocate_filled(cache_location, cache_size, 0x00)) {
+            return;
+        }
+    }
+
+    disk_info_cache_path = strdup(cache_location);
+}
+
+/**
+ * @brief Parse the disk information from the system area of the disk image.
  * 
  * @param path Pointer to the path structure.
  * @param disk_info Pointer to the disk information structure.
  * @return disk_err_t Error code.
  */
-disk_err_t disk_info_load (path_t *path, disk_info_t *disk_info) {
+static disk_err_t load_disk_info_from_file (path_t *path, disk_info_t *disk_info) {
     FILE *f;
+    uint8_t *system_area;
     disk_err_t err;
 
     for (int i = 0; i < SYSTEM_AREA_LBA_COUNT; i++) {
         disk_info->bad_system_area_lbas[i] = false;
     }
 
+    if ((system_area = malloc(SYSTEM_AREA_LBA_LENGTH * SYSTEM_AREA_LOADED_LBA_COUNT)) == NULL) {
+        return DISK_ERR_IO;
+    }
+
     if ((f = fopen(path_get(path), "rb")) == NULL) {
+        free(system_area);
         return DISK_ERR_NO_FILE;
     }
     setbuf(f, NULL);
-    if ((err = load_and_verify_system_data_lba(f, disk_info)) != DISK_OK) {
-        fclose(f);
-        return err;
-    }
-    if ((err = load_and_verify_disk_id_lba(f, disk_info)) != DISK_OK) {
+    if (load_system_area(f, system_area)) {
         fclose(f);
-        return err;
+        free(system_area);
+        return DISK_ERR_IO;
     }
     if (fclose(f)) {
+        free(system_area);
         return DISK_ERR_IO;
     }
 
+    if ((err = verify_system_data(system_area, disk_info)) == DISK_OK) {
+        err = verify_disk_id(system_area, disk_info);
+    }
+
+    free(system_area);
+
+    if (err != DISK_OK) {
+        return err;
+    }
+
     update_bad_system_area_lbas(disk_info);
 
     return DISK_OK;
 }
+
+/**
+ * @brief Load the disk information from the specified path.
+ * 
+ * @param path Pointer to the path structure.
+ * @param disk_info Pointer to the disk information structure.
+ * @return disk_err_t Error code.
+ */
+disk_err_t disk_info_load (path_t *path, disk_info_t *disk_info) {
+    disk_info_cache_entry_t cache_entry;
+    disk_err_t err;
+
+    bool cacheable = !disk_info_cache_describe(path, &cache_entry);
+
+    if (cacheable && !disk_info_cache_find(&cache_entry)) {
+        *disk_info = cache_entry.disk_info;
+        return DISK_OK;
+    }
+
+    if ((err = load_disk_info_from_file(path, disk_info)) != DISK_OK) {
+        return err;
+    }
+
+    if (cacheable) {
+        cache_entry.disk_info = *disk_info;
+        disk_info_cache_store(&cache_entry);
+    }
+
+    return DISK_OK;
+}
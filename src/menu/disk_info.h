@@ -58,6 +58,16 @@ typedef struct {
 } disk_info_t;
 
 
+/**
+ * @brief Initialize the disk information cache.
+ *
+ * Disk information parsed from the system area is kept in the cache file,
+ * keyed by the disk image path, size and timestamp.
+ *
+ * @param cache_location Path to the cache file.
+ */
+void disk_info_cache_init (char *cache_location);
+
 /**
  * @brief Loads disk information from the specified path.
  *
@@ -0,0 +1,780 @@
+/**
+ * @file file_ops.c
+ * @brief Background file operations implementation
+ * @ingroup menu
+ */
+
+#include <string.h>
+#include <sys/utime.h>
+
+#include <fatfs/ff.h>
+#include <libdragon.h>
+#include <miniz.h>
+#include <miniz_zip.h>
+
+#include "file_ops.h"
+#include "file_types.h"
+#include "flashcart/flashcart_utils.h"
+#include "search_index.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
+
+#define FILE_OPS_MAX_DEPTH          (16)
+#define FILE_OPS_CHUNK_SIZE         (KiB(32))
+#define FILE_OPS_SLICE_US           (4000)
+#define FILE_OPS_REDRAW_INTERVAL_MS (100)
+#define RELOCATE_TEMP_NAME          ("~relocate.tmp")
+#define RELOCATE_BACKUP_NAME        ("~relocate.old")
+
+/** @brief Operation stage enumeration. */
+typedef enum {
+    STAGE_IDLE, /**< No operation */
+    STAGE_START, /**< The operation was requested */
+    STAGE_WALK, /**< A directory tree is walked */
+    STAGE_COPY_FILE, /**< A file is copied */
+    STAGE_EXTRACT, /**< An archived file is extracted */
+    STAGE_DONE, /**< The operation is complete */
+} stage_t;
+
+/** @brief File operation state structure. */
+static struct {
+    stage_t stage; /**< Current stage */
+    path_t *root; /**< Entry the operation was started on */
+    path_t *target; /**< Entry created by the operation */
+    path_t *source; /**< Walked entry */
+    path_t *destination; /**< Entry matching the walked entry in the target tree */
+    bool root_directory; /**< The root entry is a directory */
+    int64_t root_size; /**< Size of the root entry */
+    DIR dirs[FILE_OPS_MAX_DEPTH]; /**< Open directories of the walk */
+    int depth; /**< Number of open directories */
+    FIL src; /**< Copied file */
+    FIL dst; /**< Created file */
+    bool src_open; /**< The copied file is open */
+    bool dst_open; /**< The created file is open */
+    bool dst_partial; /**< The created file isn't complete */
+    bool target_created; /**< The target entry exists */
+    mz_zip_archive zip; /**< Archive of the extracted file */
+    mz_zip_reader_extract_iter_state *iter; /**< Extraction state */
+    uint32_t file_index; /**< Index of the extracted file */
+    time_t mtime; /**< Modification time of the extracted file */
+    WORD fdate; /**< FAT date of the relocated file */
+    WORD ftime; /**< FAT time of the relocated file */
+    int skipped; /**< Files left fragmented for lack of contiguous space */
+    bool result_pending; /**< The result wasn't taken yet */
+    uint64_t last_redraw_ms; /**< Time of the last progress redraw */
+} op;
+
+static file_ops_status_t status;
+static file_ops_listener_t *listener;
+static void *listener_arg;
+
+static uint8_t buffer[FILE_OPS_CHUNK_SIZE] __attribute__((aligned(FS_SECTOR_SIZE)));
+
+
+static char *fs_path (path_t *path) {
+    return strip_fs_prefix(path_get(path));
+}
+
+static void notify (file_ops_change_t change, path_t *path, bool directory, int64_t size) {
+    if (listener != NULL) {
+        listener(change, path, directory, size, listener_arg);
+    }
+}
+
+static void close_files (void) {
+    if (op.src_open) {
+        f_close(&op.src);
+        op.src_open = false;
+    }
+    if (op.dst_open) {
+        f_close(&op.dst);
+        op.dst_open = false;
+    }
+    if (op.iter != NULL) {
+        mz_zip_reader_extract_iter_free(op.iter);
+        op.iter = NULL;
+    }
+}
+
+static file_ops_err_t begin (file_ops_type_t type, path_t *root, path_t *target) {
+    if (status.busy) {
+        return FILE_OPS_ERR_BUSY;
+    }
+
+    memset(&op, 0, sizeof(op));
+    op.stage = STAGE_START;
+    op.root = path_clone(root);
+    op.target = target ? path_clone(target) : NULL;
+    op.last_redraw_ms = get_ticks_ms();
+
+    status = (file_ops_status_t) {
+        .type = type,
+        .busy = true,
+        .err = FILE_OPS_OK,
+    };
+
+    return FILE_OPS_OK;
+}
+
+static void finish (file_ops_err_t err) {
+    if ((err == FILE_OPS_OK) && (op.skipped > 0)) {
+        err = FILE_OPS_ERR_NO_SPACE;
+    }
+
+    close_files();
+
+    for (int i = op.depth - 1; i >= 0; i--) {
+        f_closedir(&op.dirs[i]);
+    }
+    op.depth = 0;
+
+    if (op.dst_partial) {
+        f_unlink(fs_path(op.destination));
+        op.target_created = op.target_created && (op.target != NULL) && !path_are_match(op.destination, op.target);
+    }
+
+    if (status.type == FILE_OPS_EXTRACT) {
+        mz_zip_reader_end(&op.zip);
+    }
+
+    if ((err == FILE_OPS_OK) && (status.type == FILE_OPS_EXTRACT)) {
+        struct utimbuf mtime = { op.mtime, op.mtime };
+        utime(path_get(op.target), &mtime);
+        search_index_add(op.target);
+    }
+
+    switch (status.type) {
+        case FILE_OPS_DELETE:
+        case FILE_OPS_DELETE_RECURSIVE:
+            if (err == FILE_OPS_OK) {
+                notify(FILE_OPS_ENTRY_REMOVED, op.root, op.root_directory, op.root_size);
+            }
+            break;
+        case FILE_OPS_MOVE:
+            // NOTE: The rename can't partially fail, a failed reindex walk still leaves the entry moved
+            if (op.target_created) {
+                notify(FILE_OPS_ENTRY_REMOVED, op.root, op.root_directory, op.root_size);
+                notify(FILE_OPS_ENTRY_ADDED, op.target, op.root_directory, op.root_size);
+            }
+            break;
+        case FILE_OPS_COPY:
+        case FILE_OPS_EXTRACT:
+            if (op.target_created) {
+                notify(FILE_OPS_ENTRY_ADDED, op.target, op.root_directory, op.root_directory ? 0 : status.bytes_done);
+            }
+            break;
+        default:
+            break;
+    }
+
+    path_free(op.root);
+    path_free(op.target);
+    path_free(op.source);
+    path_free(op.destination);
+    op.root = NULL;
+    op.target = NULL;
+    op.source = NULL;
+    op.destination = NULL;
+
+    op.stage = STAGE_IDLE;
+    op.result_pending = true;
+
+    status.busy = false;
+    status.err = err;
+}
+
+static file_ops_err_t convert_fresult (FRESULT res) {
+    switch (res) {
+        case FR_OK: return FILE_OPS_OK;
+        case FR_NO_FILE:
+        case FR_NO_PATH: return FILE_OPS_ERR_NOT_FOUND;
+        case FR_EXIST: return FILE_OPS_ERR_EXISTS;
+        default: return FILE_OPS_ERR_IO;
+    }
+}
+
+static file_ops_err_t open_directory (path_t *path) {
+    if (op.depth == FILE_OPS_MAX_DEPTH) {
+        return FILE_OPS_ERR_TOO_DEEP;
+    }
+
+    if (f_opendir(&op.dirs[op.depth], fs_path(path)) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+
+    op.depth += 1;
+
+    return FILE_OPS_OK;
+}
+
+static file_ops_err_t copy_file_begin (int64_t size) {
+    if (f_open(&op.src, fs_path(op.source), FA_READ) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+    op.src_open = true;
+
+    FRESULT res = f_open(&op.dst, fs_path(op.destination), FA_WRITE | FA_CREATE_NEW);
+    if (res != FR_OK) {
+        return convert_fresult(res);
+    }
+    op.dst_open = true;
+    op.dst_partial = true;
+    op.target_created = true;
+
+#if FF_USE_EXPAND
+    // NOTE: Contiguous allocation is only an optimization, regular cluster allocation is used on failure
+    if (f_expand(&op.dst, size, 1) != FR_OK) {
+        f_lseek(&op.dst, 0);
+    }
+#endif
+
+    status.bytes_done = 0;
+    status.bytes_total = size;
+    op.stage = STAGE_COPY_FILE;
+
+    return FILE_OPS_OK;
+}
+
+/**
+ * @brief Open the relocated file and a temporary file preallocated in a single contiguous run.
+ */
+static file_ops_err_t relocate_begin (FILINFO *info) {
+#if FF_USE_EXPAND
+    op.destination = path_clone(op.source);
+    path_pop(op.destination);
+    path_push(op.destination, RELOCATE_TEMP_NAME);
+
+    if (f_open(&op.src, fs_path(op.source), FA_READ) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+    op.src_open = true;
+
+    if (f_open(&op.dst, fs_path(op.destination), FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+    op.dst_open = true;
+    op.dst_partial = true;
+
+    FRESULT res = f_expand(&op.dst, info->fsize, 1);
+    if (res != FR_OK) {
+        return (res == FR_DENIED) ? FILE_OPS_ERR_NO_SPACE : FILE_OPS_ERR_IO;
+    }
+
+    op.fdate = info->fdate;
+    op.ftime = info->ftime;
+    status.bytes_done = 0;
+    status.bytes_total = info->fsize;
+    op.stage = STAGE_COPY_FILE;
+
+    return FILE_OPS_OK;
+#else
+    return FILE_OPS_ERR_UNSUPPORTED;
+#endif
+}
+
+/**
+ * @brief Drop the temporary file of a relocation that couldn't be started, the walk goes on with the next file.
+ */
+static void relocate_skip (void) {
+    close_files();
+    f_unlink(fs_path(op.destination));
+    op.dst_partial = false;
+    path_free(op.destination);
+    op.destination = NULL;
+    op.skipped += 1;
+}
+
+/**
+ * @brief Replace the relocated file with the complete temporary copy.
+ *
+ * The original file is only removed once the copy has taken its name.
+ */
+static file_ops_err_t relocate_finish (void) {
+    path_t *backup = path_clone(op.source);
+    path_pop(backup);
+    path_push(backup, RELOCATE_BACKUP_NAME);
+
+    file_ops_err_t err = FILE_OPS_ERR_IO;
+
+    if (f_rename(fs_path(op.source), fs_path(backup)) == FR_OK) {
+        if (f_rename(fs_path(op.destination), fs_path(op.source)) == FR_OK) {
+            f_unlink(fs_path(backup));
+            err = FILE_OPS_OK;
+        } else {
+            f_rename(fs_path(backup), fs_path(op.source));
+        }
+    }
+
+    path_free(backup);
+
+    if (err != FILE_OPS_OK) {
+        op.dst_partial = true;
+        return err;
+    }
+
+#if FF_USE_CHMOD
+    FILINFO info = { .fdate = op.fdate, .ftime = op.ftime };
+    f_utime(fs_path(op.source), &info);
+#endif
+
+    path_free(op.destination);
+    op.destination = NULL;
+    status.files += 1;
+
+    if (op.depth == 0) {
+        op.stage = STAGE_DONE;
+        return FILE_OPS_OK;
+    }
+
+    path_pop(op.source);
+    op.stage = STAGE_WALK;
+
+    return FILE_OPS_OK;
+}
+
+static file_ops_err_t start_step (void) {
+    FILINFO info;
+    FRESULT res;
+
+    if (f_stat(fs_path(op.root), &info) != FR_OK) {
+        return FILE_OPS_ERR_NOT_FOUND;
+    }
+
+    op.root_directory = (info.fattrib & AM_DIR);
+    op.root_size = op.root_directory ? 0 : info.fsize;
+    if (op.source == NULL) {
+        op.source = path_clone(op.root);
+    }
+
+    switch (status.type) {
+        case FILE_OPS_DELETE:
+            res = f_unlink(fs_path(op.root));
+            if (res == FR_DENIED) {
+                return op.root_directory ? FILE_OPS_ERR_NOT_EMPTY : FILE_OPS_ERR_IO;
+            }
+            if (res != FR_OK) {
+                return convert_fresult(res);
+            }
+            if (!op.root_directory) {
+                search_index_remove(op.root);
+                status.files += 1;
+            }
+            op.stage = STAGE_DONE;
+            return FILE_OPS_OK;
+
+        case FILE_OPS_DELETE_RECURSIVE:
+            if (!op.root_directory) {
+                op.stage = STAGE_START;
+                status.type = FILE_OPS_DELETE;
+                return start_step();
+            }
+            op.stage = STAGE_WALK;
+            return open_directory(op.source);
+
+        case FILE_OPS_COPY:
+            op.destination = path_clone(op.target);
+            if (!op.root_directory) {
+                return copy_file_begin(info.fsize);
+            }
+            if ((res = f_mkdir(fs_path(op.destination))) != FR_OK) {
+                return convert_fresult(res);
+            }
+            op.target_created = true;
+            op.stage = STAGE_WALK;
+            return open_directory(op.source);
+
+        case FILE_OPS_MOVE:
+            if ((res = f_rename(fs_path(op.root), fs_path(op.target))) != FR_OK) {
+                return convert_fresult(res);
+            }
+            op.target_created = true;
+            if (!op.root_directory) {
+                search_index_remove(op.root);
+                search_index_add(op.target);
+                status.files += 1;
+                op.stage = STAGE_DONE;
+                return FILE_OPS_OK;
+            }
+            // NOTE: The moved tree is walked at its new location, the old paths are only used to update the search index
+            path_free(op.source);
+            op.source = path_clone(op.target);
+            op.destination = path_clone(op.root);
+            op.stage = STAGE_WALK;
+            return open_directory(op.source);
+
+        case FILE_OPS_RELOCATE:
+            if (op.root_directory) {
+                op.stage = STAGE_WALK;
+                return open_directory(op.source);
+            }
+            if (fatfs_get_file_fragments(path_get(op.source)) <= 1) {
+                op.stage = STAGE_DONE;
+                return FILE_OPS_OK;
+            }
+            return relocate_begin(&info);
+
+        default:
+            return FILE_OPS_ERR_INVALID;
+    }
+}
+
+static file_ops_err_t walk_step (void) {
+    FILINFO info;
+
+    if (f_readdir(&op.dirs[op.depth - 1], &info) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+
+    if (info.fname[0] == '\0') {
+        f_closedir(&op.dirs[op.depth - 1]);
+        op.depth -= 1;
+
+        if ((status.type == FILE_OPS_DELETE_RECURSIVE) && (f_unlink(fs_path(op.source)) != FR_OK)) {
+            return FILE_OPS_ERR_IO;
+        }
+
+        if (op.depth == 0) {
+            op.stage = STAGE_DONE;
+            return FILE_OPS_OK;
+        }
+
+        path_pop(op.source);
+        if (op.destination != NULL) {
+            path_pop(op.destination);
+        }
+
+        return FILE_OPS_OK;
+    }
+
+    path_push(op.source, info.fname);
+    if (op.destination != NULL) {
+        path_push(op.destination, info.fname);
+    }
+
+    if (info.fattrib & AM_DIR) {
+        if ((status.type == FILE_OPS_COPY) && (f_mkdir(fs_path(op.destination)) != FR_OK)) {
+            return FILE_OPS_ERR_IO;
+        }
+        return open_directory(op.source);
+    }
+
+    switch (status.type) {
+        case FILE_OPS_DELETE_RECURSIVE:
+            if (f_unlink(fs_path(op.source)) != FR_OK) {
+                return FILE_OPS_ERR_IO;
+            }
+            search_index_remove(op.source);
+            break;
+
+        case FILE_OPS_MOVE:
+            search_index_remove(op.destination);
+            search_index_add(op.source);
+            break;
+
+        case FILE_OPS_COPY:
+            return copy_file_begin(info.fsize);
+
+        case FILE_OPS_RELOCATE:
+            if (file_ops_can_relocate(info.fname) && (fatfs_get_file_fragments(path_get(op.source)) > 1)) {
+                file_ops_err_t err = relocate_begin(&info);
+                if (err != FILE_OPS_ERR_NO_SPACE) {
+                    return err;
+                }
+                relocate_skip();
+            }
+            path_pop(op.source);
+            return FILE_OPS_OK;
+
+        default:
+            break;
+    }
+
+    status.files += 1;
+
+    path_pop(op.source);
+    if (op.destination != NULL) {
+        path_pop(op.destination);
+    }
+
+    return FILE_OPS_OK;
+}
+
+static file_ops_err_t copy_step (void) {
+    UINT br;
+    UINT bw;
+
+    if (f_read(&op.src, buffer, FILE_OPS_CHUNK_SIZE, &br) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+
+    if (br > 0) {
+        if ((f_write(&op.dst, buffer, br, &bw) != FR_OK) || (bw != br)) {
+            return FILE_OPS_ERR_IO;
+        }
+        status.bytes_done += br;
+        return FILE_OPS_OK;
+    }
+
+    f_close(&op.src);
+    op.src_open = false;
+
+    op.dst_open = false;
+    if (f_close(&op.dst) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+    op.dst_partial = false;
+
+    if (status.type == FILE_OPS_RELOCATE) {
+        return relocate_finish();
+    }
+
+    search_index_add(op.destination);
+    status.files += 1;
+
+    if (op.depth == 0) {
+        op.stage = STAGE_DONE;
+        return FILE_OPS_OK;
+    }
+
+    path_pop(op.source);
+    path_pop(op.destination);
+    op.stage = STAGE_WALK;
+
+    return FILE_OPS_OK;
+}
+
+static file_ops_err_t extract_step (void) {
+    UINT bw;
+
+    size_t length = mz_zip_reader_extract_iter_read(op.iter, buffer, FILE_OPS_CHUNK_SIZE);
+
+    if (length > 0) {
+        if ((f_write(&op.dst, buffer, length, &bw) != FR_OK) || (bw != length)) {
+            return FILE_OPS_ERR_IO;
+        }
+        status.bytes_done += length;
+        return FILE_OPS_OK;
+    }
+
+    bool failed = !mz_zip_reader_extract_iter_free(op.iter);
+    op.iter = NULL;
+
+    if (failed || (status.bytes_done != status.bytes_total)) {
+        return FILE_OPS_ERR_ARCHIVE;
+    }
+
+    op.dst_open = false;
+    if (f_close(&op.dst) != FR_OK) {
+        return FILE_OPS_ERR_IO;
+    }
+    op.dst_partial = false;
+
+    status.files += 1;
+    op.stage = STAGE_DONE;
+
+    return FILE_OPS_OK;
+}
+
+
+void file_ops_set_listener (file_ops_listener_t *callback, void *arg) {
+    listener = callback;
+    listener_arg = arg;
+}
+
+void file_ops_notify_written (path_t *path) {
+    FILINFO info;
+
+    if (f_stat(fs_path(path), &info) != FR_OK) {
+        return;
+    }
+
+    bool directory = (info.fattrib & AM_DIR);
+
+    if (!directory) {
+        search_index_add(path);
+    }
+
+    notify(FILE_OPS_ENTRY_ADDED, path, directory, directory ? 0 : info.fsize);
+}
+
+void file_ops_notify_removed (path_t *path) {
+    notify(FILE_OPS_ENTRY_REMOVED, path, false, 0);
+}
+
+file_ops_err_t file_ops_delete (path_t *path, bool recursive) {
+    return begin(recursive ? FILE_OPS_DELETE_RECURSIVE : FILE_OPS_DELETE, path, NULL);
+}
+
+file_ops_err_t file_ops_copy (path_t *source, path_t *directory, bool move) {
+    if (status.busy) {
+        return FILE_OPS_ERR_BUSY;
+    }
+
+    char *source_path = path_get(source);
+    char *directory_path = path_get(directory);
+    size_t source_length = strlen(source_path);
+
+    // NOTE: A directory can't be copied or moved into its own tree
+    if ((strncmp(directory_path, source_path, source_length) == 0) && ((directory_path[source_length] == '\0') || (directory_path[source_length] == '/'))) {
+        return FILE_OPS_ERR_INVALID;
+    }
+
+    path_t *target = path_clone_push(directory, path_last_get(source));
+
+    file_ops_err_t err = FILE_OPS_OK;
+
+    if (file_exists(path_get(target)) || directory_exists(path_get(target))) {
+        err = FILE_OPS_ERR_EXISTS;
+    } else {
+        err = begin(move ? FILE_OPS_MOVE : FILE_OPS_COPY, source, target);
+    }
+
+    path_free(target);
+
+    return err;
+}
+
+bool file_ops_can_relocate (const char *name) {
+    switch (file_type_get(name)) {
+        case ENTRY_TYPE_ROM:
+        case ENTRY_TYPE_ROM_COMPRESSED:
+        case ENTRY_TYPE_DISK:
+        case ENTRY_TYPE_SAVE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+file_ops_err_t file_ops_relocate (path_t *path) {
+    return begin(FILE_OPS_RELOCATE, path, NULL);
+}
+
+file_ops_err_t file_ops_extract (path_t *archive, uint32_t file_index, path_t *destination, time_t mtime) {
+    file_ops_err_t err = begin(FILE_OPS_EXTRACT, archive, destination);
+    if (err != FILE_OPS_OK) {
+        return err;
+    }
+
+    mz_zip_archive_file_stat info;
+
+    mz_zip_zero_struct(&op.zip);
+    if (!mz_zip_reader_init_file(&op.zip, path_get(archive), 0)) {
+        op.stage = STAGE_DONE;
+        finish(FILE_OPS_ERR_ARCHIVE);
+        return FILE_OPS_ERR_ARCHIVE;
+    }
+
+    op.file_index = file_index;
+    op.mtime = mtime;
+    op.destination = path_clone(destination);
+
+    if (!mz_zip_reader_file_stat(&op.zip, file_index, &info) || ((op.iter = mz_zip_reader_extract_iter_new(&op.zip, file_index, 0)) == NULL)) {
+        finish(FILE_OPS_ERR_ARCHIVE);
+        return FILE_OPS_ERR_ARCHIVE;
+    }
+
+    FRESULT res = f_open(&op.dst, fs_path(destination), FA_WRITE | FA_CREATE_NEW);
+    if (res != FR_OK) {
+        err = convert_fresult(res);
+        finish(err);
+        return err;
+    }
+    op.dst_open = true;
+    op.dst_partial = true;
+    op.target_created = true;
+
+#if FF_USE_EXPAND
+    if (f_expand(&op.dst, info.m_uncomp_size, 1) != FR_OK) {
+        f_lseek(&op.dst, 0);
+    }
+#endif
+
+    status.bytes_total = info.m_uncomp_size;
+    op.stage = STAGE_EXTRACT;
+
+    return FILE_OPS_OK;
+}
+
+bool file_ops_poll (void) {
+    if (op.stage == STAGE_IDLE) {
+        return false;
+    }
+
+    uint64_t start_us = get_ticks_us();
+    file_ops_err_t err = FILE_OPS_OK;
+
+    do {
+        switch (op.stage) {
+            case STAGE_START: err = start_step(); break;
+            case STAGE_WALK: err = walk_step(); break;
+            case STAGE_COPY_FILE: err = copy_step(); break;
+            case STAGE_EXTRACT: err = extract_step(); break;
+            default: break;
+        }
+    } while ((err == FILE_OPS_OK) && (op.stage != STAGE_DONE) && ((get_ticks_us() - start_us) < FILE_OPS_SLICE_US));
+
+    if ((err != FILE_OPS_OK) || (op.stage == STAGE_DONE)) {
+        finish(err);
+        return true;
+    }
+
+    uint64_t now_ms = get_ticks_ms();
+    if ((now_ms - op.last_redraw_ms) >= FILE_OPS_REDRAW_INTERVAL_MS) {
+        op.last_redraw_ms = now_ms;
+        return true;
+    }
+
+    return false;
+}
+
+void file_ops_cancel (void) {
+    if (op.stage != STAGE_IDLE) {
+        finish(FILE_OPS_ERR_CANCELLED);
+    }
+}
+
+file_ops_status_t *file_ops_get_status (void) {
+    return &status;
+}
+
+bool file_ops_take_result (file_ops_err_t *err) {
+    if (!op.result_pending) {
+        return false;
+    }
+
+    op.result_pending = false;
+    *err = status.err;
+
+    return true;
+}
+
+const char *file_ops_get_type_name (file_ops_type_t type) {
+    switch (type) {
+        case FILE_OPS_DELETE:
+        case FILE_OPS_DELETE_RECURSIVE: return "Deleting";
+        case FILE_OPS_COPY: return "Copying";
+        case FILE_OPS_MOVE: return "Moving";
+        case FILE_OPS_EXTRACT: return "Extracting";
+        case FILE_OPS_RELOCATE: return "Relocating";
+        default: return "Idle";
+    }
+}
+
+char *file_ops_convert_error_message (file_ops_err_t err) {
+    switch (err) {
+        case FILE_OPS_OK: return "No error";
+        case FILE_OPS_ERR_BUSY: return "Another file operation is running";
+        case FILE_OPS_ERR_NOT_FOUND: return "The selected entry doesn't exist";
+        case FILE_OPS_ERR_EXISTS: return "An entry with the same name already exists";
+        case FILE_OPS_ERR_NOT_EMPTY: return "Directory is not empty";
+        case FILE_OPS_ERR_INVALID: return "Can't copy or move a directory into itself";
+        case FILE_OPS_ERR_TOO_DEEP: return "Directory tree is nested too deep";
+        case FILE_OPS_ERR_ARCHIVE: return "Couldn't read the archived file";
+        case FILE_OPS_ERR_NO_SPACE: return "Not enough contiguous free space on the SD card";
+        case FILE_OPS_ERR_UNSUPPORTED: return "Not supported by the file system";
+        case FILE_OPS_ERR_IO: return "File system error";
+        case FILE_OPS_ERR_CANCELLED: return "File operation was cancelled";
+        default: return "Unknown error";
+    }
+}
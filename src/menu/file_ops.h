@@ -0,0 +1,195 @@
+/**
+ * @file file_ops.h
+ * @brief Background file operations
+ * @ingroup menu
+ *
+ * Deleting, copying, moving and extracting run in small slices polled from
+ * the main loop, so the menu stays responsive while large files or directory
+ * trees are processed. Only one operation runs at a time. The search index
+ * is updated for every file, the listener is told about the top level entry
+ * that was added or removed, so the directory listings are patched in place.
+ */
+
+#ifndef FILE_OPS_H__
+#define FILE_OPS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "path.h"
+
+/** @brief File operation type enumeration. */
+typedef enum {
+    FILE_OPS_NONE, /**< No operation */
+    FILE_OPS_DELETE, /**< Delete a file or an empty directory */
+    FILE_OPS_DELETE_RECURSIVE, /**< Delete a file or a directory with its contents */
+    FILE_OPS_COPY, /**< Copy a file or a directory tree */
+    FILE_OPS_MOVE, /**< Move a file or a directory */
+    FILE_OPS_EXTRACT, /**< Extract a file from a ZIP archive */
+    FILE_OPS_RELOCATE, /**< Rewrite fragmented files into contiguous space */
+} file_ops_type_t;
+
+/** @brief File operation error enumeration. */
+typedef enum {
+    FILE_OPS_OK, /**< No error */
+    FILE_OPS_ERR_BUSY, /**< Another operation is running */
+    FILE_OPS_ERR_NOT_FOUND, /**< The source doesn't exist */
+    FILE_OPS_ERR_EXISTS, /**< The destination already exists */
+    FILE_OPS_ERR_NOT_EMPTY, /**< The directory isn't empty */
+    FILE_OPS_ERR_INVALID, /**< The destination is inside the source */
+    FILE_OPS_ERR_TOO_DEEP, /**< The directory tree is nested too deep */
+    FILE_OPS_ERR_ARCHIVE, /**< The archived file couldn't be read */
+    FILE_OPS_ERR_NO_SPACE, /**< No contiguous free space is large enough */
+    FILE_OPS_ERR_UNSUPPORTED, /**< The operation isn't supported by the file system build */
+    FILE_OPS_ERR_IO, /**< The file system reported an error */
+    FILE_OPS_ERR_CANCELLED, /**< The operation was cancelled */
+} file_ops_err_t;
+
+/** @brief Listing change enumeration. */
+typedef enum {
+    FILE_OPS_ENTRY_ADDED, /**< An entry was created */
+    FILE_OPS_ENTRY_REMOVED, /**< An entry was removed */
+} file_ops_change_t;
+
+/**
+ * @brief Listing change listener, called once per top level entry added or removed.
+ *
+ * @param change Type of the change.
+ * @param path Pointer to the path of the entry.
+ * @param directory The entry is a directory.
+ * @param size Size of the entry in bytes, 0 for directories.
+ * @param arg Argument passed when the listener was set.
+ */
+typedef void file_ops_listener_t (file_ops_change_t change, path_t *path, bool directory, int64_t size, void *arg);
+
+/** @brief File operation status structure. */
+typedef struct {
+    file_ops_type_t type; /**< Type of the running or last operation */
+    bool busy; /**< The operation is running */
+    file_ops_err_t err; /**< Result of the last finished operation */
+    int files; /**< Number of files processed */
+    uint64_t bytes_done; /**< Bytes copied or extracted */
+    uint64_t bytes_total; /**< Size of the file being copied or extracted */
+} file_ops_status_t;
+
+/**
+ * @brief Set the listing change listener.
+ *
+ * @param listener Listener, NULL to remove it.
+ * @param arg Argument passed to the listener.
+ */
+void file_ops_set_listener (file_ops_listener_t *listener, void *arg);
+
+/**
+ * @brief Report an entry created or overwritten outside the file operations.
+ *
+ * The search index and the listener are updated the same way as for an entry copied by a file operation,
+ * so the cached directory listings and index files don't keep missing it.
+ *
+ * @param path Pointer to the path of the entry.
+ */
+void file_ops_notify_written (path_t *path);
+
+/**
+ * @brief Report a file removed outside the file operations.
+ *
+ * @param path Pointer to the path of the removed file.
+ */
+void file_ops_notify_removed (path_t *path);
+
+/**
+ * @brief Start deleting an entry.
+ *
+ * @param path Pointer to the path of the entry.
+ * @param recursive Delete the contents of a directory too.
+ * @return file_ops_err_t Error code, the result of the operation is reported in the status.
+ */
+file_ops_err_t file_ops_delete (path_t *path, bool recursive);
+
+/**
+ * @brief Start copying or moving an entry into a directory, keeping its name.
+ *
+ * @param source Pointer to the path of the entry.
+ * @param directory Pointer to the path of the destination directory.
+ * @param move Move the entry instead of copying it.
+ * @return file_ops_err_t Error code, the result of the operation is reported in the status.
+ */
+file_ops_err_t file_ops_copy (path_t *source, path_t *directory, bool move);
+
+/**
+ * @brief Start extracting a file from a ZIP archive.
+ *
+ * @param archive Pointer to the path of the archive.
+ * @param file_index Index of the file in the archive.
+ * @param destination Pointer to the path of the extracted file.
+ * @param mtime Modification time set on the extracted file.
+ * @return file_ops_err_t Error code, the result of the operation is reported in the status.
+ */
+file_ops_err_t file_ops_extract (path_t *archive, uint32_t file_index, path_t *destination, time_t mtime);
+
+/**
+ * @brief Check if a file type is worth keeping contiguous.
+ *
+ * ROMs, 64DD disks and saves are transferred straight from their sectors when they're contiguous.
+ *
+ * @param name Name of the file.
+ * @return true if the file can be relocated, false otherwise.
+ */
+bool file_ops_can_relocate (const char *name);
+
+/**
+ * @brief Start relocating a fragmented file into contiguous free space.
+ *
+ * The file is copied into a contiguous preallocated temporary file, which then replaces it.
+ * For a directory, every fragmented ROM, disk and save file in its tree is relocated.
+ *
+ * @param path Pointer to the path of the file or the directory.
+ * @return file_ops_err_t Error code, the result of the operation is reported in the status.
+ */
+file_ops_err_t file_ops_relocate (path_t *path);
+
+/**
+ * @brief Continue the running operation for a short slice of time.
+ *
+ * @return true if the progress changed enough to be redrawn, false otherwise.
+ */
+bool file_ops_poll (void);
+
+/**
+ * @brief Stop the running operation, the partially copied or extracted file is removed.
+ */
+void file_ops_cancel (void);
+
+/**
+ * @brief Get the file operation status.
+ *
+ * @return file_ops_status_t* Pointer to the status.
+ */
+file_ops_status_t *file_ops_get_status (void);
+
+/**
+ * @brief Take the result of the last finished operation, so it's reported only once.
+ *
+ * @param err Pointer to store the result.
+ * @return true if an operation finished since the last call, false otherwise.
+ */
+bool file_ops_take_result (file_ops_err_t *err);
+
+/**
+ * @brief Get the progress label of a file operation type.
+ *
+ * @param type The file operation type.
+ * @return const char* The label, such as "Copying".
+ */
+const char *file_ops_get_type_name (file_ops_type_t type);
+
+/**
+ * @brief Convert a file operation error code to a human-readable error message.
+ *
+ * @param err The file operation error code.
+ * @return char* The human-readable error message.
+ */
+char *file_ops_convert_error_message (file_ops_err_t err);
+
+#endif /* FILE_OPS_H__ */
@@ -0,0 +1,84 @@
+/**
+ * @file file_types.c
+ * @brief File type classification implementation
+ * @ingroup menu
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file_types.h"
+
+#define EXTENSION_LENGTH_MAX    (12)
+
+/** @brief File Extension Structure. */
+typedef struct {
+    const char *extension; /**< Lowercase extension without the dot */
+    entry_type_t type; /**< Entry type of the files with this extension */
+} file_extension_t;
+
+// NOTE: Must stay sorted by extension, it's searched with bsearch
+// TODO: "eep", "sra", "srm", "fla" could be used if transfered from different flashcarts.
+static const file_extension_t file_extensions[] = {
+    { "aps", ENTRY_TYPE_ROM_PATCH },
+    { "bps", ENTRY_TYPE_ROM_PATCH },
+    { "cheats", ENTRY_TYPE_ROM_CHEAT },
+    { "chf", ENTRY_TYPE_EMULATOR },
+    { "cht", ENTRY_TYPE_ROM_CHEAT },
+    { "datel", ENTRY_TYPE_ROM_CHEAT },
+    { "gameshark", ENTRY_TYPE_ROM_CHEAT },
+    { "gb", ENTRY_TYPE_EMULATOR },
+    { "gbc", ENTRY_TYPE_EMULATOR },
+    { "gg", ENTRY_TYPE_EMULATOR },
+    { "ini", ENTRY_TYPE_TEXT },
+    { "ips", ENTRY_TYPE_ROM_PATCH },
+    { "mp3", ENTRY_TYPE_MUSIC },
+    { "n64", ENTRY_TYPE_ROM },
+    { "ndd", ENTRY_TYPE_DISK },
+    { "nes", ENTRY_TYPE_EMULATOR },
+    { "png", ENTRY_TYPE_IMAGE },
+    { "rom", ENTRY_TYPE_ROM },
+    { "sav", ENTRY_TYPE_SAVE },
+    { "sfc", ENTRY_TYPE_EMULATOR },
+    { "sg", ENTRY_TYPE_EMULATOR },
+    { "smc", ENTRY_TYPE_EMULATOR },
+    { "sms", ENTRY_TYPE_EMULATOR },
+    { "txt", ENTRY_TYPE_TEXT },
+    { "ups", ENTRY_TYPE_ROM_PATCH },
+    { "v64", ENTRY_TYPE_ROM },
+    { "xdelta", ENTRY_TYPE_ROM_PATCH },
+    { "yaml", ENTRY_TYPE_TEXT },
+    { "yml", ENTRY_TYPE_TEXT },
+    { "z64", ENTRY_TYPE_ROM },
+    { "z64c", ENTRY_TYPE_ROM_COMPRESSED },
+    { "zip", ENTRY_TYPE_ARCHIVE },
+};
+#define FILE_EXTENSIONS_COUNT   (sizeof(file_extensions) / sizeof(file_extensions[0]))
+
+static int compare_extension (const void *key, const void *element) {
+    return strcmp((const char *) (key), ((const file_extension_t *) (element))->extension);
+}
+
+entry_type_t file_type_get (const char *name) {
+    char extension[EXTENSION_LENGTH_MAX + 1];
+
+    const char *dot = strrchr(name, '.');
+
+    if (dot == NULL) {
+        return ENTRY_TYPE_OTHER;
+    }
+
+    size_t length = 0;
+    for (const char *c = dot + 1; *c != '\0'; c++) {
+        if (length == EXTENSION_LENGTH_MAX) {
+            return ENTRY_TYPE_OTHER;
+        }
+        extension[length++] = tolower((unsigned char) (*c));
+    }
+    extension[length] = '\0';
+
+    const file_extension_t *match = bsearch(extension, file_extensions, FILE_EXTENSIONS_COUNT, sizeof(file_extension_t), compare_extension);
+
+    return match ? match->type : ENTRY_TYPE_OTHER;
+}
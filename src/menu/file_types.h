@@ -0,0 +1,23 @@
+/**
+ * @file file_types.h
+ * @brief File type classification
+ * @ingroup menu
+ */
+
+#ifndef FILE_TYPES_H__
+#define FILE_TYPES_H__
+
+#include "menu_state.h"
+
+/**
+ * @brief Get the browser entry type of a file from its extension.
+ *
+ * The extension is looked up in a single sorted table, so the cost doesn't
+ * depend on the number of supported formats.
+ *
+ * @param name File name or path.
+ * @return entry_type_t Entry type, ENTRY_TYPE_OTHER for unknown extensions.
+ */
+entry_type_t file_type_get(const char *name);
+
+#endif /* FILE_TYPES_H__ */
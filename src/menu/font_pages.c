@@ -0,0 +1,242 @@
+/**
+ * @file font_pages.c
+ * @brief Glyph page cache implementation
+ * @ingroup menu
+ */
+
+#include <string.h>
+
+#include "font_pages.h"
+
+
+/**
+ * @brief Decode a UTF-8 character.
+ *
+ * @param text The text.
+ * @param length The length left in the text.
+ * @param codepoint Pointer to store the code point, U+FFFD for a malformed sequence.
+ * @return size_t Length of the character in bytes, at least 1.
+ */
+static size_t utf8_decode (const uint8_t *text, size_t length, uint32_t *codepoint) {
+    uint8_t lead = text[0];
+    size_t bytes;
+
+    if (lead < 0x80) {
+        *codepoint = lead;
+        return 1;
+    } else if ((lead & 0xE0) == 0xC0) {
+        *codepoint = (lead & 0x1F);
+        bytes = 2;
+    } else if ((lead & 0xF0) == 0xE0) {
+        *codepoint = (lead & 0x0F);
+        bytes = 3;
+    } else if ((lead & 0xF8) == 0xF0) {
+        *codepoint = (lead & 0x07);
+        bytes = 4;
+    } else {
+        *codepoint = 0xFFFD;
+        return 1;
+    }
+
+    if (bytes > length) {
+        *codepoint = 0xFFFD;
+        return 1;
+    }
+
+    for (size_t i = 1; i < bytes; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            *codepoint = 0xFFFD;
+            return 1;
+        }
+        *codepoint = (*codepoint << 6) | (text[i] & 0x3F);
+    }
+
+    return bytes;
+}
+
+static void slot_unload (font_pages_t *fp, font_pages_slot_t *slot) {
+    if (slot->page >= 0) {
+        fp->unload(slot->font, slot - fp->slots, fp->arg);
+    }
+    slot->page = -1;
+    slot->font = NULL;
+    slot->last_used = 0;
+}
+
+static size_t put_font_escape (char *output, size_t output_length, size_t output_size, uint8_t font) {
+    static const char hex[] = "0123456789ABCDEF";
+
+    if ((output_length + 3) > output_size) {
+        return 0;
+    }
+
+    output[output_length] = '$';
+    output[output_length + 1] = hex[font >> 4];
+    output[output_length + 2] = hex[font & 0x0F];
+
+    return 3;
+}
+
+
+void font_pages_init (font_pages_t *fp, font_pages_load_t *load, font_pages_unload_t *unload, void *arg) {
+    memset(fp, 0, sizeof(font_pages_t));
+
+    for (int i = 0; i < FONT_PAGES_SLOTS; i++) {
+        fp->slots[i].page = -1;
+    }
+
+    fp->load = load;
+    fp->unload = unload;
+    fp->arg = arg;
+}
+
+void font_pages_clear (font_pages_t *fp) {
+    for (int i = 0; i < FONT_PAGES_SLOTS; i++) {
+        slot_unload(fp, &fp->slots[i]);
+    }
+}
+
+void font_pages_set_available (font_pages_t *fp, uint32_t page) {
+    if (page < FONT_PAGES_COUNT) {
+        fp->available[page / 8] |= (1 << (page % 8));
+    }
+}
+
+bool font_pages_is_available (font_pages_t *fp, uint32_t page) {
+    if (page >= FONT_PAGES_COUNT) {
+        return false;
+    }
+    return (fp->available[page / 8] & (1 << (page % 8)));
+}
+
+void font_pages_begin_text (font_pages_t *fp) {
+    fp->clock += 1;
+}
+
+int font_pages_get_slot (font_pages_t *fp, uint32_t codepoint) {
+    uint32_t page = (codepoint >> FONT_PAGES_SHIFT);
+
+    if (!font_pages_is_available(fp, page)) {
+        return FONT_PAGES_RESIDENT;
+    }
+
+    font_pages_slot_t *victim = NULL;
+
+    for (int i = 0; i < FONT_PAGES_SLOTS; i++) {
+        font_pages_slot_t *slot = &fp->slots[i];
+        if (slot->page == (int32_t) (page)) {
+            slot->last_used = fp->clock;
+            fp->hits += 1;
+            return i;
+        }
+        if ((victim != NULL) && (victim->page < 0)) {
+            continue;
+        }
+        if (slot->page < 0) {
+            victim = slot;
+        } else if ((slot->last_used != fp->clock) && ((victim == NULL) || (slot->last_used < victim->last_used))) {
+            victim = slot;
+        }
+    }
+
+    // NOTE: Every slot holds a page the current text already uses, the characters fall back to the resident font
+    if (victim == NULL) {
+        return FONT_PAGES_RESIDENT;
+    }
+
+    if (victim->page >= 0) {
+        fp->evictions += 1;
+    }
+    slot_unload(fp, victim);
+
+    int index = (victim - fp->slots);
+    void *font = fp->load(page, index, fp->arg);
+
+    if (font == NULL) {
+        fp->available[page / 8] &= ~(1 << (page % 8));
+        return FONT_PAGES_RESIDENT;
+    }
+
+    victim->page = page;
+    victim->font = font;
+    victim->last_used = fp->clock;
+    fp->loads += 1;
+
+    return index;
+}
+
+size_t font_pages_next_run (font_pages_t *fp, const char *text, size_t length, int *slot) {
+    const uint8_t *bytes = (const uint8_t *) (text);
+    size_t position = 0;
+    int run_slot = FONT_PAGES_RESIDENT;
+
+    while (position < length) {
+        uint32_t codepoint;
+        size_t size;
+        int character_slot = FONT_PAGES_RESIDENT;
+
+        if (bytes[position] < 0x80) {
+            size = 1;
+        } else {
+            size = utf8_decode(&bytes[position], length - position, &codepoint);
+            character_slot = font_pages_get_slot(fp, codepoint);
+        }
+
+        if (position == 0) {
+            run_slot = character_slot;
+        } else if (character_slot != run_slot) {
+            break;
+        }
+
+        position += size;
+    }
+
+    *slot = run_slot;
+
+    return position;
+}
+
+size_t font_pages_rewrite (font_pages_t *fp, const char *text, size_t length, char *output, size_t output_size, uint8_t resident_font, uint8_t first_page_font) {
+    size_t output_length = 0;
+    bool paged = false;
+    int slot = FONT_PAGES_RESIDENT;
+    int last_slot = FONT_PAGES_RESIDENT;
+    size_t run;
+
+    while ((run = font_pages_next_run(fp, text, length, &slot)) > 0) {
+        uint8_t font = (slot == FONT_PAGES_RESIDENT) ? resident_font : (first_page_font + slot);
+
+        if ((slot != FONT_PAGES_RESIDENT) || paged) {
+            size_t escape = put_font_escape(output, output_length, output_size, font);
+            if (escape == 0) {
+                return 0;
+            }
+            output_length += escape;
+            paged = true;
+        }
+
+        if ((output_length + run) > output_size) {
+            return 0;
+        }
+        memcpy(&output[output_length], text, run);
+        output_length += run;
+
+        text += run;
+        length -= run;
+        last_slot = slot;
+    }
+
+    if (!paged) {
+        return 0;
+    }
+
+    if (last_slot != FONT_PAGES_RESIDENT) {
+        size_t escape = put_font_escape(output, output_length, output_size, resident_font);
+        if (escape == 0) {
+            return 0;
+        }
+        output_length += escape;
+    }
+
+    return output_length;
+}
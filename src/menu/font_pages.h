@@ -0,0 +1,146 @@
+/**
+ * @file font_pages.h
+ * @brief Glyph page cache
+ * @ingroup menu
+ *
+ * Large fonts are split into a small resident font with the common glyphs
+ * and optional pages of 256 code points each, loaded only when a text draws
+ * one of their glyphs. The loaded pages are kept in a small number of slots,
+ * the least recently used page is unloaded to make room for a new one.
+ * The text is split into runs of characters drawn with the same font, the
+ * characters of the pages that aren't available are drawn with the resident font.
+ */
+
+#ifndef FONT_PAGES_H__
+#define FONT_PAGES_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Number of code point bits covered by a page. */
+#define FONT_PAGES_SHIFT    (8)
+/** @brief Number of pages covering the whole Unicode range. */
+#define FONT_PAGES_COUNT    (0x110000 >> FONT_PAGES_SHIFT)
+/** @brief Number of pages loaded at the same time. */
+#define FONT_PAGES_SLOTS    (8)
+/** @brief Slot index of the characters drawn with the resident font. */
+#define FONT_PAGES_RESIDENT (-1)
+
+/**
+ * @brief Page load callback.
+ *
+ * @param page Index of the page, the first code point of the page shifted right by FONT_PAGES_SHIFT.
+ * @param slot Slot the page is loaded into.
+ * @param arg Argument passed at initialization.
+ * @return void* The loaded page, NULL if it couldn't be loaded.
+ */
+typedef void *font_pages_load_t (uint32_t page, int slot, void *arg);
+
+/**
+ * @brief Page unload callback.
+ *
+ * @param font The loaded page.
+ * @param slot Slot the page was loaded into.
+ * @param arg Argument passed at initialization.
+ */
+typedef void font_pages_unload_t (void *font, int slot, void *arg);
+
+/** @brief Page slot structure. */
+typedef struct {
+    int32_t page; /**< Index of the loaded page, -1 when the slot is empty */
+    void *font; /**< The loaded page */
+    uint32_t last_used; /**< Clock value of the last text that used the page */
+} font_pages_slot_t;
+
+/** @brief Glyph page cache structure. */
+typedef struct {
+    uint8_t available[FONT_PAGES_COUNT / 8]; /**< Bitmap of the pages that can be loaded */
+    font_pages_slot_t slots[FONT_PAGES_SLOTS]; /**< Loaded pages */
+    uint32_t clock; /**< Text counter, used to find the least recently used page */
+    font_pages_load_t *load; /**< Page load callback */
+    font_pages_unload_t *unload; /**< Page unload callback */
+    void *arg; /**< Callbacks argument */
+    uint32_t hits; /**< Number of lookups of an already loaded page */
+    uint32_t loads; /**< Number of pages loaded */
+    uint32_t evictions; /**< Number of pages unloaded to make room for another page */
+} font_pages_t;
+
+/**
+ * @brief Initialize the glyph page cache, no page is available.
+ *
+ * @param fp Pointer to the cache.
+ * @param load Page load callback.
+ * @param unload Page unload callback.
+ * @param arg Argument passed to the callbacks.
+ */
+void font_pages_init (font_pages_t *fp, font_pages_load_t *load, font_pages_unload_t *unload, void *arg);
+
+/**
+ * @brief Unload all pages.
+ *
+ * @param fp Pointer to the cache.
+ */
+void font_pages_clear (font_pages_t *fp);
+
+/**
+ * @brief Mark a page as available.
+ *
+ * @param fp Pointer to the cache.
+ * @param page Index of the page.
+ */
+void font_pages_set_available (font_pages_t *fp, uint32_t page);
+
+/**
+ * @brief Check if a page is available.
+ *
+ * @param fp Pointer to the cache.
+ * @param page Index of the page.
+ * @return true if the page can be loaded, false otherwise.
+ */
+bool font_pages_is_available (font_pages_t *fp, uint32_t page);
+
+/**
+ * @brief Start a new text, the pages used by the text are kept loaded until the next text starts.
+ *
+ * @param fp Pointer to the cache.
+ */
+void font_pages_begin_text (font_pages_t *fp);
+
+/**
+ * @brief Get the slot of the page of a code point, loading the page if needed.
+ *
+ * @param fp Pointer to the cache.
+ * @param codepoint The code point.
+ * @return int Slot index, FONT_PAGES_RESIDENT when the code point is drawn with the resident font.
+ */
+int font_pages_get_slot (font_pages_t *fp, uint32_t codepoint);
+
+/**
+ * @brief Get the next run of characters drawn with the same font.
+ *
+ * @param fp Pointer to the cache.
+ * @param text The text.
+ * @param length The text length in bytes.
+ * @param slot Pointer to store the slot index of the run.
+ * @return size_t Length of the run in bytes, 0 at the end of the text.
+ */
+size_t font_pages_next_run (font_pages_t *fp, const char *text, size_t length, int *slot);
+
+/**
+ * @brief Rewrite a text with the font change escape codes of the runs drawn with a page.
+ *
+ * Each run is prefixed by "$xx", xx being the font ID in hexadecimal, the text ends with the resident font selected.
+ *
+ * @param fp Pointer to the cache.
+ * @param text The text.
+ * @param length The text length in bytes.
+ * @param output Buffer to store the rewritten text.
+ * @param output_size Size of the buffer.
+ * @param resident_font Font ID of the resident font.
+ * @param first_page_font Font ID of the first slot, the slots use consecutive IDs.
+ * @return size_t Length of the rewritten text, 0 if the text doesn't use any page or doesn't fit in the buffer.
+ */
+size_t font_pages_rewrite (font_pages_t *fp, const char *text, size_t length, char *output, size_t output_size, uint8_t resident_font, uint8_t first_page_font);
+
+#endif /* FONT_PAGES_H__ */
@@ -1,8 +1,32 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <libdragon.h>
 
+#include "font_pages.h"
 #include "fonts.h"
+#include "path.h"
 #include "utils/fs.h"
 
+#define TEXT_BUFFER_SIZE    (4096)
+
+
+static font_pages_t font_pages;
+static path_t *font_pages_directory = NULL;
+static uint32_t font_generation = 0;
+static char text_buffer[TEXT_BUFFER_SIZE];
+
+
+static void font_styles_set (rdpq_font_t *font) {
+    rdpq_font_style(font, STL_DEFAULT, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0xFF, 0xFF, 0xFF) }));
+    rdpq_font_style(font, STL_GREEN, &((rdpq_fontstyle_t) { .color = RGBA32(0x70, 0xFF, 0x70, 0xFF) }));
+    rdpq_font_style(font, STL_BLUE, &((rdpq_fontstyle_t) { .color = RGBA32(0x70, 0xBC, 0xFF, 0xFF) }));
+    rdpq_font_style(font, STL_YELLOW, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0xFF, 0x70, 0xFF) }));
+    rdpq_font_style(font, STL_ORANGE, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0x99, 0x00, 0xFF) }));
+    rdpq_font_style(font, STL_RED, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0x40, 0x40, 0xFF) }));
+    rdpq_font_style(font, STL_GRAY, &((rdpq_fontstyle_t) { .color = RGBA32(0xA0, 0xA0, 0xA0, 0xFF) }));
+}
 
 static void load_default_font (char *custom_font_path) {
     char *font_path = "rom:/Firple-Bold.font64";
@@ -13,18 +37,123 @@ static void load_default_font (char *custom_font_path) {
 
     rdpq_font_t *default_font = rdpq_font_load(font_path);
 
-    rdpq_font_style(default_font, STL_DEFAULT, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0xFF, 0xFF, 0xFF) }));
-    rdpq_font_style(default_font, STL_GREEN, &((rdpq_fontstyle_t) { .color = RGBA32(0x70, 0xFF, 0x70, 0xFF) }));
-    rdpq_font_style(default_font, STL_BLUE, &((rdpq_fontstyle_t) { .color = RGBA32(0x70, 0xBC, 0xFF, 0xFF) }));
-    rdpq_font_style(default_font, STL_YELLOW, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0xFF, 0x70, 0xFF) }));
-    rdpq_font_style(default_font, STL_ORANGE, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0x99, 0x00, 0xFF) }));
-    rdpq_font_style(default_font, STL_RED, &((rdpq_fontstyle_t) { .color = RGBA32(0xFF, 0x40, 0x40, 0xFF) }));
-    rdpq_font_style(default_font, STL_GRAY, &((rdpq_fontstyle_t) { .color = RGBA32(0xA0, 0xA0, 0xA0, 0xFF) }));
+    font_styles_set(default_font);
 
     rdpq_text_register_font(FNT_DEFAULT, default_font);
 }
 
+static void font_free (void *arg) {
+    rdpq_font_free((rdpq_font_t *) (arg));
+}
+
+static void *font_page_load (uint32_t page, int slot, void *arg) {
+    char name[16];
+    sprintf(name, "%04lX.font64", (page << FONT_PAGES_SHIFT));
+
+    path_t *path = path_clone_push(font_pages_directory, name);
+
+    rdpq_font_t *font = NULL;
+
+    if (file_exists(path_get(path))) {
+        font = rdpq_font_load(path_get(path));
+    }
+
+    path_free(path);
+
+    if (font == NULL) {
+        return NULL;
+    }
+
+    font_styles_set(font);
+
+    rdpq_text_register_font(FNT_PAGES + slot, font);
+
+    return font;
+}
+
+static void font_page_unload (void *font, int slot, void *arg) {
+    rdpq_text_unregister_font(FNT_PAGES + slot);
+
+    // NOTE: The RDP might still draw the glyphs queued in the current frame
+    rdpq_call_deferred(font_free, font);
+
+    font_generation += 1;
+}
+
+/**
+ * @brief Find the available glyph pages, named after their first code point, such as "4E00.font64".
+ */
+static void font_pages_scan (char *directory) {
+    dir_t info;
+
+    font_pages_init(&font_pages, font_page_load, font_page_unload, NULL);
+
+    if (!directory || !directory_exists(directory)) {
+        return;
+    }
+
+    font_pages_directory = path_create(directory);
+
+    int result = dir_findfirst(directory, &info);
+
+    while (result == 0) {
+        char *extension = NULL;
+        uint32_t codepoint = strtoul(info.d_name, &extension, 16);
+
+        if (
+            (info.d_type != DT_DIR) &&
+            (extension != info.d_name) &&
+            (strcasecmp(extension, ".font64") == 0) &&
+            ((codepoint & ((1 << FONT_PAGES_SHIFT) - 1)) == 0)
+        ) {
+            font_pages_set_available(&font_pages, codepoint >> FONT_PAGES_SHIFT);
+        }
+
+        result = dir_findnext(directory, &info);
+    }
+}
+
 
-void fonts_init (char *custom_font_path) {
+void fonts_init (char *custom_font_path, char *font_pages_path) {
     load_default_font(custom_font_path);
+    font_pages_scan(font_pages_path);
+}
+
+const char *fonts_prepare_text (const char *text, int *length) {
+    font_pages_begin_text(&font_pages);
+
+    size_t rewritten = font_pages_rewrite(&font_pages, text, *length, text_buffer, sizeof(text_buffer), FNT_DEFAULT, FNT_PAGES);
+
+    if (rewritten == 0) {
+        return text;
+    }
+
+    *length = rewritten;
+
+    return text_buffer;
+}
+
+void fonts_paragraph_builder_begin (void) {
+    font_pages_begin_text(&font_pages);
+}
+
+void fonts_paragraph_builder_span (const char *text, int length) {
+    int slot;
+    size_t run;
+
+    while ((run = font_pages_next_run(&font_pages, text, length, &slot)) > 0) {
+        if (slot != FONT_PAGES_RESIDENT) {
+            rdpq_paragraph_builder_font(FNT_PAGES + slot);
+        }
+        rdpq_paragraph_builder_span(text, run);
+        if (slot != FONT_PAGES_RESIDENT) {
+            rdpq_paragraph_builder_font(FNT_DEFAULT);
+        }
+        text += run;
+        length -= run;
+    }
+}
+
+uint32_t fonts_get_generation (void) {
+    return font_generation;
 }
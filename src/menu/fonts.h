@@ -2,11 +2,18 @@
  * @file fonts.h
  * @brief Menu fonts
  * @ingroup menu 
+ *
+ * The glyphs missing from the default font can be loaded on demand from
+ * glyph pages, each page is a font with the glyphs of 256 code points.
+ * The texts must be passed through fonts_prepare_text, or laid out with
+ * fonts_paragraph_builder_span, so their characters are drawn with the pages.
  */
 
 #ifndef FONTS_H__
 #define FONTS_H__
 
+#include <stdint.h>
+
 /**
  * @brief Font type enumeration.
  * 
@@ -15,6 +22,7 @@
  */
 typedef enum {
     FNT_DEFAULT = 1, /**< Default font type */
+    FNT_PAGES = 2, /**< First font type of the loaded glyph pages */
 } menu_font_type_t;
 
 /**
@@ -40,7 +48,41 @@ typedef enum {
  * custom fonts from the specified path.
  * 
  * @param custom_font_path Path to the custom font file.
+ * @param font_pages_path Path to the directory with the glyph pages.
+ */
+void fonts_init(char *custom_font_path, char *font_pages_path);
+
+/**
+ * @brief Prepare a text drawn with the default font, selecting the glyph pages of its characters.
+ *
+ * @param text The text.
+ * @param length Pointer to the text length, updated with the length of the prepared text.
+ * @return const char* The prepared text, valid until the next call, or the text itself when it doesn't use any page.
+ */
+const char *fonts_prepare_text(const char *text, int *length);
+
+/**
+ * @brief Start a paragraph laid out with fonts_paragraph_builder_span.
+ *
+ * The glyph pages used by the spans are kept loaded until the next text is prepared.
+ */
+void fonts_paragraph_builder_begin(void);
+
+/**
+ * @brief Add a span to the paragraph being built, selecting the glyph pages of its characters.
+ *
+ * @param text The text.
+ * @param length The text length.
+ */
+void fonts_paragraph_builder_span(const char *text, int length);
+
+/**
+ * @brief Get the glyph pages generation, incremented when a page is unloaded.
+ *
+ * Renderings recorded with another generation might use the glyphs of an unloaded page.
+ *
+ * @return uint32_t The generation.
  */
-void fonts_init(char *custom_font_path);
+uint32_t fonts_get_generation(void);
 
 #endif /* FONTS_H__ */
@@ -0,0 +1,123 @@
+/**
+ * @file memory_budget.c
+ * @brief Heap budget of the menu caches implementation
+ * @ingroup menu
+ */
+
+#include <libdragon.h>
+
+#include "memory_budget.h"
+#include "utils/utils.h"
+
+#define HEAP_RESERVE            (KiB(512))
+#define HEAP_RESERVE_EXPANDED   (MiB(1))
+
+/** @brief Cache quota structure. */
+typedef struct {
+    size_t quota; /**< Quota without an Expansion Pak */
+    size_t quota_expanded; /**< Quota with an Expansion Pak */
+} memory_quota_t;
+
+/** @brief Registered cache structure. */
+typedef struct {
+    memory_usage_callback_t *usage; /**< Usage callback */
+    memory_shrink_callback_t *shrink; /**< Shrink callback */
+} memory_cache_entry_t;
+
+static const memory_quota_t quotas[MEMORY_CACHE_COUNT] = {
+    [MEMORY_CACHE_BOXART] = { .quota = KiB(256), .quota_expanded = MiB(1) },
+    [MEMORY_CACHE_DIRECTORY] = { .quota = KiB(64), .quota_expanded = KiB(512) },
+};
+
+static memory_cache_entry_t caches[MEMORY_CACHE_COUNT];
+
+
+static size_t heap_free (void) {
+    heap_stats_t stats;
+    sys_get_heap_stats(&stats);
+    return (stats.used < stats.total) ? (stats.total - stats.used) : 0;
+}
+
+static size_t heap_reserve (void) {
+    return is_memory_expanded() ? HEAP_RESERVE_EXPANDED : HEAP_RESERVE;
+}
+
+static size_t cache_usage (memory_cache_t cache) {
+    return (caches[cache].usage != NULL) ? caches[cache].usage() : 0;
+}
+
+/**
+ * @brief Pick the cache to shrink next.
+ *
+ * @param skip Mask of the caches left out, since they have nothing more to release.
+ * @return int Cache identifier, -1 if no cache can shrink.
+ */
+static int pick_cache (uint32_t skip) {
+    int picked = -1;
+    size_t picked_excess = 0;
+    size_t picked_usage = 0;
+
+    for (int i = 0; i < MEMORY_CACHE_COUNT; i++) {
+        if ((caches[i].shrink == NULL) || (skip & (1 << i))) {
+            continue;
+        }
+
+        size_t usage = cache_usage(i);
+        size_t quota = memory_budget_get_quota(i);
+        size_t excess = (usage > quota) ? (usage - quota) : 0;
+
+        if ((usage > 0) && ((picked < 0) || (excess > picked_excess) || ((excess == picked_excess) && (usage > picked_usage)))) {
+            picked = i;
+            picked_excess = excess;
+            picked_usage = usage;
+        }
+    }
+
+    return picked;
+}
+
+
+void memory_budget_register (memory_cache_t cache, memory_usage_callback_t *usage, memory_shrink_callback_t *shrink) {
+    caches[cache].usage = usage;
+    caches[cache].shrink = shrink;
+}
+
+size_t memory_budget_get_quota (memory_cache_t cache) {
+    return is_memory_expanded() ? quotas[cache].quota_expanded : quotas[cache].quota;
+}
+
+bool memory_budget_over_quota (memory_cache_t cache, size_t size) {
+    if ((cache_usage(cache) + size) > memory_budget_get_quota(cache)) {
+        return true;
+    }
+
+    return (heap_free() < (size + heap_reserve()));
+}
+
+bool memory_budget_reserve (size_t size) {
+    uint32_t skip = 0;
+
+    while (heap_free() < (size + heap_reserve())) {
+        int cache = pick_cache(skip);
+
+        if (cache < 0) {
+            return true;
+        }
+
+        if (!caches[cache].shrink()) {
+            skip |= (1 << cache);
+        }
+    }
+
+    return false;
+}
+
+size_t memory_budget_get_usage (void) {
+    size_t usage = 0;
+
+    for (int i = 0; i < MEMORY_CACHE_COUNT; i++) {
+        usage += cache_usage(i);
+    }
+
+    return usage;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file memory_budget.h
+ * @brief Heap budget of the menu caches
+ * @ingroup menu
+ *
+ * Every cache gets a quota depending on the installed memory, and the caches
+ * are asked to shrink before the hot paths allocate, so allocations don't fail
+ * on consoles without an Expansion Pak.
+ */
+
+#ifndef MEMORY_BUDGET_H__
+#define MEMORY_BUDGET_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Budgeted caches enumeration. */
+typedef enum {
+    MEMORY_CACHE_BOXART,        /**< Recently shown boxart images */
+    MEMORY_CACHE_DIRECTORY,     /**< Recently browsed directory listings */
+    MEMORY_CACHE_COUNT          /**< List end marker */
+} memory_cache_t;
+
+/**
+ * @brief Cache usage callback.
+ *
+ * @return size_t Heap memory used by the cache in bytes.
+ */
+typedef size_t memory_usage_callback_t (void);
+
+/**
+ * @brief Cache shrink callback, releases the least valuable item of the cache.
+ *
+ * @return true if an item was released, false if the cache is empty.
+ */
+typedef bool memory_shrink_callback_t (void);
+
+/**
+ * @brief Register the callbacks of a cache, registering again replaces them.
+ *
+ * @param cache Cache identifier.
+ * @param usage Usage callback.
+ * @param shrink Shrink callback.
+ */
+void memory_budget_register (memory_cache_t cache, memory_usage_callback_t *usage, memory_shrink_callback_t *shrink);
+
+/**
+ * @brief Get the quota of a cache for the installed memory.
+ *
+ * @param cache Cache identifier.
+ * @return size_t Quota in bytes.
+ */
+size_t memory_budget_get_quota (memory_cache_t cache);
+
+/**
+ * @brief Check if a cache can't keep more data.
+ *
+ * @param cache Cache identifier.
+ * @param size Size of the data to keep in bytes.
+ * @return true if the data would exceed the cache quota or leave the heap too low, false otherwise.
+ */
+bool memory_budget_over_quota (memory_cache_t cache, size_t size);
+
+/**
+ * @brief Shrink the caches until an allocation fits on the heap, keeping the heap reserve free.
+ *
+ * The caches over their quota shrink first, then the largest ones.
+ *
+ * @param size Size of the upcoming allocation in bytes.
+ * @return true if the caches couldn't release enough memory, false otherwise.
+ */
+bool memory_budget_reserve (size_t size);
+
+/**
+ * @brief Get the heap memory used by all registered caches.
+ *
+ * @return size_t Used memory in bytes.
+ */
+size_t memory_budget_get_usage (void);
+
+#endif /* MEMORY_BUDGET_H__ */
@@ -11,7 +11,10 @@
 #include <libdragon.h>
 
 #include "actions.h"
+#include "bgm.h"
 #include "boot/boot.h"
+#include "directory_index.h"
+#include "file_ops.h"
 #include "flashcart/flashcart.h"
 #include "fonts.h"
 #include "hdmi.h"
@@ -19,21 +22,40 @@
 #include "menu.h"
 #include "mp3_player.h"
 #include "png_decoder.h"
+#include "scheduler.h"
+#include "search_index.h"
 #include "settings.h"
 #include "sound.h"
+#include "telemetry.h"
 #include "usb_comm.h"
 #include "utils/fs.h"
+#include "utils/trace.h"
+#include "utils/trace_events.h"
 #include "views/views.h"
 
 #define MENU_DIRECTORY              "/menu"
 #define MENU_SETTINGS_FILE          "config.ini"
 #define MENU_CUSTOM_FONT_FILE       "custom.font64"
+#define MENU_FONT_PAGES_DIRECTORY   "font_pages"
+#define MENU_BGM_FILE               "bgm.wav64"
 #define MENU_ROM_LOAD_HISTORY_FILE  "history.ini"
+#define MENU_ROM_SETTINGS_FILE      "rom_settings.data"
+#define MENU_ROM_DATABASE_FILE      "rom_database.db"
+#define DFS_ROM_DATABASE_FILE       "rom:/rom_database.db"
 
 #define MENU_CACHE_DIRECTORY        "cache"
 #define BACKGROUND_CACHE_FILE       "background.data"
+#define ROM_RESIDENCY_CACHE_FILE    "rom_residency.data"
+#define SAVE_SECTORS_CACHE_FILE     "save_sectors.data"
+#define BOOT_TRACE_CACHE_FILE       "boot_trace.data"
+#define STARTUP_PROFILE_CACHE_FILE  "startup_profile.data"
+#define ROM_INFO_CACHE_FILE         "rom_info.data"
+#define DISK_INFO_CACHE_FILE        "disk_info.data"
+#define DIRECTORY_INDEX_DIRECTORY   "directories"
+#define SEARCH_INDEX_FILE           "search_index.data"
 
 #define FPS_LIMIT                   (30.0f)
+#define FRAME_INTERVAL_US           ((uint64_t) (1000000.0f / FPS_LIMIT))
 
 static menu_t *menu;
 
@@ -46,6 +68,163 @@ extern int __boot_tvtype;
 
 static bool interlaced = true;
 
+static bool ui_initialized = false;
+
+/**
+ * @brief Check if the current mode draws anything but a blank frame.
+ *
+ * @param menu Pointer to the menu structure.
+ * @return true if the UI stack is needed, false otherwise.
+ */
+static bool menu_ui_needed (menu_t *menu) {
+#ifdef FEATURE_AUTOLOAD_ROM_ENABLED
+    // NOTE: Autoloading without the progress bar hands over to the game without drawing the UI at all
+    if (menu->settings.rom_autoload_enabled && !menu->settings.loading_progress_bar_enabled && (menu->mode == MENU_MODE_LOAD_ROM)) {
+        return false;
+    }
+#endif
+    return (menu->mode != MENU_MODE_NONE) && (menu->mode != MENU_MODE_STARTUP) && (menu->mode != MENU_MODE_BOOT);
+}
+
+static int mp3_task (void *arg) {
+    mp3player_poll();
+    return SCHEDULER_TASK_IDLE;
+}
+
+static int bgm_task (void *arg) {
+    return bgm_poll() ? SCHEDULER_TASK_PENDING : SCHEDULER_TASK_IDLE;
+}
+
+static int sound_task (void *arg) {
+    sound_poll();
+    return SCHEDULER_TASK_IDLE;
+}
+
+static int png_decoder_task (void *arg) {
+    png_decoder_poll();
+    return (png_decoder_get_jobs() > 0) ? SCHEDULER_TASK_PENDING : SCHEDULER_TASK_IDLE;
+}
+
+static int background_task (void *arg) {
+    return ui_components_background_poll() ? SCHEDULER_TASK_REDRAW : SCHEDULER_TASK_IDLE;
+}
+
+static int usb_comm_task (void *arg) {
+    usb_comm_poll((menu_t *) (arg));
+    return SCHEDULER_TASK_IDLE;
+}
+
+static int file_ops_task (void *arg) {
+    int status = file_ops_poll() ? SCHEDULER_TASK_REDRAW : SCHEDULER_TASK_IDLE;
+    return file_ops_get_status()->busy ? (status | SCHEDULER_TASK_PENDING) : status;
+}
+
+static int telemetry_task (void *arg) {
+    telemetry_poll();
+    return SCHEDULER_TASK_IDLE;
+}
+
+/**
+ * @brief Register the background tasks polled from the main loop.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void menu_tasks_init (menu_t *menu) {
+    scheduler_init(FRAME_INTERVAL_US);
+    // NOTE: The audio buffers are refilled first, so a busy frame never causes an audible dropout
+    scheduler_register("MP3 refill", SCHEDULER_PRIORITY_AUDIO, 0, mp3_task, NULL);
+    scheduler_register("Sound", SCHEDULER_PRIORITY_AUDIO, 0, sound_task, NULL);
+    scheduler_register("BGM read-ahead", SCHEDULER_PRIORITY_HIGH, 2000, bgm_task, NULL);
+    scheduler_register("USB", SCHEDULER_PRIORITY_HIGH, 4000, usb_comm_task, menu);
+    scheduler_register("PNG decoder", SCHEDULER_PRIORITY_NORMAL, 8000, png_decoder_task, NULL);
+    scheduler_register("Background", SCHEDULER_PRIORITY_NORMAL, 4000, background_task, NULL);
+    scheduler_register("File operations", SCHEDULER_PRIORITY_LOW, 16000, file_ops_task, NULL);
+    scheduler_register("Telemetry", SCHEDULER_PRIORITY_LOW, 1000, telemetry_task, NULL);
+}
+
+/**
+ * @brief Begin a startup profile phase, nothing is recorded once the startup is over.
+ *
+ * @param name Phase name.
+ */
+static void startup_phase_begin (const char *name) {
+    if (trace_startup_active()) {
+        trace_phase_begin(name);
+    }
+}
+
+/**
+ * @brief End the current startup profile phase.
+ */
+static void startup_phase_end (void) {
+    if (trace_startup_active()) {
+        trace_phase_end();
+    }
+}
+
+/**
+ * @brief Initialize the UI stack on its first use.
+ *
+ * Fonts, sound effects, the background and the browser indexes are only needed once something is drawn.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void menu_ui_init (menu_t *menu) {
+    if (ui_initialized || !menu_ui_needed(menu)) {
+        return;
+    }
+
+    ui_initialized = true;
+
+    startup_phase_begin("UI init");
+
+    sound_init_sfx();
+    sound_use_sfx(menu->settings.soundfx_enabled);
+
+    path_t *path = path_init(menu->storage_prefix, MENU_DIRECTORY);
+
+    startup_phase_begin("Background music");
+    path_push(path, MENU_BGM_FILE);
+    bgm_init(path_get(path));
+    path_pop(path);
+    if (menu->settings.bgm_enabled && bgm_set_enabled(true)) {
+        debugf("Background music file not found\n");
+    }
+    startup_phase_end();
+
+    startup_phase_begin("Fonts");
+    path_t *font_pages_path = path_clone_push(path, MENU_FONT_PAGES_DIRECTORY);
+    path_push(path, MENU_CUSTOM_FONT_FILE);
+    fonts_init(path_get(path), path_get(font_pages_path));
+    path_pop(path);
+    path_free(font_pages_path);
+    startup_phase_end();
+
+    path_push(path, MENU_CACHE_DIRECTORY);
+
+    startup_phase_begin("Background");
+    path_push(path, BACKGROUND_CACHE_FILE);
+    ui_components_background_init(path_get(path));
+    path_pop(path);
+    startup_phase_end();
+
+    startup_phase_begin("Indexes");
+    if (menu->settings.directory_index_enabled) {
+        path_push(path, DIRECTORY_INDEX_DIRECTORY);
+        directory_index_init(path_get(path));
+        path_pop(path);
+    }
+
+    path_push(path, SEARCH_INDEX_FILE);
+    search_index_init(path_get(path), menu->storage_prefix);
+    path_pop(path);
+    startup_phase_end();
+
+    path_free(path);
+
+    startup_phase_end();
+}
+
 /**
  * @brief Initialize the menu system.
  * 
@@ -60,11 +239,14 @@ static void menu_init (boot_params_t *boot_params) {
     menu->mode = MENU_MODE_NONE;
     menu->next_mode = MENU_MODE_STARTUP;
 
+    startup_phase_begin("Flashcart init");
     menu->flashcart_err = flashcart_init(&menu->storage_prefix);
     if (menu->flashcart_err != FLASHCART_OK) {
         menu->next_mode = MENU_MODE_FAULT;
     }
+    startup_phase_end();
 
+    startup_phase_begin("System init");
     joypad_init();
     timer_init();
     rtc_init();
@@ -74,25 +256,44 @@ static void menu_init (boot_params_t *boot_params) {
 
     actions_init();
     sound_init_default();
-    sound_init_sfx();
+
+    menu_tasks_init(menu);
 
     hdmi_clear_game_id();
+    startup_phase_end();
 
     path_t *path = path_init(menu->storage_prefix, MENU_DIRECTORY);
 
     directory_create(path_get(path));
 
+    startup_phase_begin("Settings load");
     path_push(path, MENU_SETTINGS_FILE);
     settings_init(path_get(path));
     settings_load(&menu->settings);
     path_pop(path);
+    startup_phase_end();
 
+    startup_phase_begin("History load");
     path_push(path, MENU_ROM_LOAD_HISTORY_FILE);
     bookkeeping_init(path_get(path));
     bookkeeping_load(&menu->bookkeeping);
     menu->load.load_history_id = -1;
     menu->load.load_favorite_id = -1;
+    menu->load.load_archive_id = -1;
+    path_pop(path);
+    startup_phase_end();
+
+    startup_phase_begin("ROM database");
+    path_push(path, MENU_ROM_DATABASE_FILE);
+    rom_info_database_init(file_exists(path_get(path)) ? path_get(path) : DFS_ROM_DATABASE_FILE);
     path_pop(path);
+    startup_phase_end();
+
+    if (menu->settings.rom_settings_store_enabled) {
+        path_push(path, MENU_ROM_SETTINGS_FILE);
+        rom_settings_store_init(path_get(path));
+        path_pop(path);
+    }
   
     if (menu->settings.pal60_compatibility_mode) { // hardware VI mods that dont really understand the output
         tv_type = get_tv_type();
@@ -112,28 +313,51 @@ static void menu_init (boot_params_t *boot_params) {
         .pal60 = menu->settings.pal60_enabled, // this may be overridden by the PAL60 compatibility mode.
     };
 
-    display_init(resolution, DEPTH_16_BPP, 2, GAMMA_NONE, interlaced ? FILTERS_DISABLED : FILTERS_RESAMPLE);
+    startup_phase_begin("Display init");
+    // NOTE: The third buffer costs 600 KiB, it lets the RDP start the next frame while two frames wait for the VI
+    int buffers = (menu->settings.triple_buffering_enabled && is_memory_expanded()) ? 3 : 2;
+    display_init(resolution, DEPTH_16_BPP, buffers, GAMMA_NONE, interlaced ? FILTERS_DISABLED : FILTERS_RESAMPLE);
     display_set_fps_limit(FPS_LIMIT);
+    startup_phase_end();
 
-    path_push(path, MENU_CUSTOM_FONT_FILE);
-    fonts_init(path_get(path));
-    path_pop(path);
-
+    startup_phase_begin("Cache init");
     path_push(path, MENU_CACHE_DIRECTORY);
     directory_create(path_get(path));
 
-    path_push(path, BACKGROUND_CACHE_FILE);
-    ui_components_background_init(path_get(path));
+    path_push(path, ROM_RESIDENCY_CACHE_FILE);
+    flashcart_residency_init(path_get(path));
+    path_pop(path);
 
-    path_free(path);
+    path_push(path, SAVE_SECTORS_CACHE_FILE);
+    flashcart_save_sectors_cache_init(path_get(path));
+    path_pop(path);
 
-    sound_use_sfx(menu->settings.soundfx_enabled);
+    path_push(path, BOOT_TRACE_CACHE_FILE);
+    trace_init(path_get(path));
+    path_pop(path);
+
+    path_push(path, STARTUP_PROFILE_CACHE_FILE);
+    trace_startup_init(path_get(path));
+    path_pop(path);
+
+    path_push(path, ROM_INFO_CACHE_FILE);
+    rom_info_cache_init(path_get(path));
+    path_pop(path);
 
+    path_push(path, DISK_INFO_CACHE_FILE);
+    disk_info_cache_init(path_get(path));
+    path_pop(path);
+
+    path_free(path);
+    startup_phase_end();
+
+    startup_phase_begin("Default directory");
     menu->browser.directory = path_init(menu->storage_prefix, menu->settings.default_directory);
     if (!directory_exists(path_get(menu->browser.directory))) {
         path_free(menu->browser.directory);
         menu->browser.directory = path_init(menu->storage_prefix, "/");
     }
+    startup_phase_end();
 
     debugf("N64FlashcartMenu debugging...\n");
 }
@@ -144,21 +368,32 @@ static void menu_init (boot_params_t *boot_params) {
  * @param menu Pointer to the menu structure.
  */
 static void menu_deinit (menu_t *menu) {
+    // NOTE: The listings and their index files are still patched, the partially copied file is removed
+    file_ops_cancel();
+
     hdmi_send_game_id(menu->boot_params);
 
+    trace_save();
+
+    search_index_save();
+
+    directory_index_deinit();
+
     ui_components_background_free();
 
     path_free(menu->load.disk_slots.primary.disk_path);
-    path_free(menu->load.rom_path);
-    for (int i = 0; i < menu->browser.entries; i++) {
-        free(menu->browser.list[i].name);
+    for (int i = 0; i < menu->load.disk_slots.slot_count; i++) {
+        path_free(menu->load.disk_slots.slot[i].disk_path);
     }
+    path_free(menu->load.rom_path);
     free(menu->browser.list);
+    free(menu->browser.names);
     path_free(menu->browser.directory);
     free(menu);
 
     display_close();
 
+    bgm_deinit();
     sound_deinit();
 
     rdpq_close();
@@ -177,11 +412,12 @@ typedef const struct {
     menu_mode_t id; /**< View ID */
     void (*init) (menu_t *menu); /**< Initialization function */
     void (*show) (menu_t *menu, surface_t *display); /**< Display function */
+    bool (*idle) (menu_t *menu); /**< Idle function, called instead of the display function while there's no input, returns true when the view must be redrawn (optional) */
 } view_t;
 
 static view_t menu_views[] = {
     { MENU_MODE_STARTUP, view_startup_init, view_startup_display },
-    { MENU_MODE_BROWSER, view_browser_init, view_browser_display },
+    { MENU_MODE_BROWSER, view_browser_init, view_browser_display, view_browser_idle },
     { MENU_MODE_FILE_INFO, view_file_info_init, view_file_info_display },
     { MENU_MODE_SYSTEM_INFO, view_system_info_init, view_system_info_display },
     { MENU_MODE_IMAGE_VIEWER, view_image_viewer_init, view_image_viewer_display },
@@ -202,7 +438,9 @@ static view_t menu_views[] = {
     { MENU_MODE_FAVORITE, view_favorite_init, view_favorite_display },
     { MENU_MODE_HISTORY, view_history_init, view_history_display },
     { MENU_MODE_DATEL_CODE_EDITOR, view_datel_code_editor_init, view_datel_code_editor_display },
-    { MENU_MODE_EXTRACT_FILE, view_extract_file_init, view_extract_file_display }
+    { MENU_MODE_EXTRACT_FILE, view_extract_file_init, view_extract_file_display },
+    { MENU_MODE_SEARCH, view_search_init, view_search_display },
+    { MENU_MODE_BENCHMARK, view_benchmark_init, view_benchmark_display }
 };
 
 /**
@@ -226,15 +464,61 @@ static view_t *menu_get_view (menu_mode_t id) {
  * @param boot_params Pointer to the boot parameters structure.
  */
 void menu_run (boot_params_t *boot_params) {
+    trace_startup_begin();
+
     menu_init(boot_params);
 
+    bool redraw = true;
+    bool actions_ready = false;
+    uint64_t last_frame_us = 0;
+
     while (true) {
-        surface_t *display = display_try_get();
+        view_t *view = menu_get_view(menu->mode);
+        bool idle_supported = (view && view->idle);
 
-        if (display != NULL) {
+        // NOTE: Views with an idle function are only redrawn when something changed, input is still polled at the frame rate
+        if (idle_supported && !redraw && ((get_ticks_us() - last_frame_us) >= FRAME_INTERVAL_US)) {
+            last_frame_us = get_ticks_us();
+            scheduler_frame_begin();
             actions_update(menu);
+            actions_ready = true;
+            time(&menu->current_time);
+            redraw = actions_any(menu) || view->idle(menu);
+        }
+
+        surface_t *display = (!idle_supported || redraw) ? display_try_get() : NULL;
+
+        if (display != NULL) {
+            redraw = false;
+            last_frame_us = get_ticks_us();
+            scheduler_frame_begin();
+
+            // NOTE: The startup profile ends with the first frame of a view that isn't part of the startup sequence
+            bool profiled = (menu->mode != MENU_MODE_NONE);
+            bool first_frame = profiled && (menu->mode != MENU_MODE_STARTUP);
+
+            menu_ui_init(menu);
+
+            // NOTE: The input is sampled as late as possible before the view lays out the frame,
+            // the presses seen by the idle poll are kept
+            if (actions_ready) {
+                actions_latch(menu);
+            } else {
+                actions_update(menu);
+            }
+            actions_ready = false;
+
+            if (menu->actions.perf_hud) {
+                ui_components_perf_hud_toggle();
+            }
+
+            ui_components_perf_hud_frame_begin();
+            ui_components_perf_hud_input(actions_get_input_time());
 
-            view_t *view = menu_get_view(menu->mode);
+            if (profiled) {
+                startup_phase_begin(first_frame ? "First frame" : "Startup frame");
+            }
+            trace_event_begin("menu", "Frame");
             if (view && view->show) {
                 view->show(menu, display);
             } else {
@@ -242,13 +526,31 @@ void menu_run (boot_params_t *boot_params) {
                 rdpq_detach_wait();
                 display_show(display);
             }
+            trace_event_end("menu", "Frame");
+            if (profiled) {
+                startup_phase_end();
+            }
+
+            if (first_frame) {
+                trace_startup_end();
+            }
 
             if (menu->mode == MENU_MODE_BOOT) {
                 break;
             }
 
+            profiled = profiled && (menu->mode != menu->next_mode);
+            if (profiled) {
+                startup_phase_begin("View init");
+            }
+
             while (menu->mode != menu->next_mode) {
                 menu->mode = menu->next_mode;
+                redraw = true;
+
+                trace_event_instant("menu", "View change");
+
+                menu_ui_init(menu);
 
                 view_t *next_view = menu_get_view(menu->next_mode);
                 if (next_view && next_view->init) {
@@ -256,18 +558,22 @@ void menu_run (boot_params_t *boot_params) {
                 }
             }
 
+            if (profiled) {
+                startup_phase_end();
+            }
+
             time(&menu->current_time);
         }
 
-        sound_poll();
-
-        png_decoder_poll();
-
-        usb_comm_poll(menu);
+        if (scheduler_run()) {
+            redraw = true;
+        }
     }
 
     menu_deinit(menu);
 
+    telemetry_poll();
+
     while (exception_reset_time() > 0) {
         // Do nothing if reset button was pressed
     }
@@ -47,7 +47,9 @@ typedef enum {
     MENU_MODE_FAVORITE,
     MENU_MODE_HISTORY,
     MENU_MODE_DATEL_CODE_EDITOR,
-    MENU_MODE_EXTRACT_FILE
+    MENU_MODE_EXTRACT_FILE,
+    MENU_MODE_SEARCH,
+    MENU_MODE_BENCHMARK
 } menu_mode_t;
 
 /** @brief File entry type enumeration */
@@ -64,7 +66,8 @@ typedef enum {
     ENTRY_TYPE_SAVE,
     ENTRY_TYPE_TEXT,
     ENTRY_TYPE_ARCHIVE,
-    ENTRY_TYPE_ARCHIVED
+    ENTRY_TYPE_ARCHIVED,
+    ENTRY_TYPE_ROM_COMPRESSED
 } entry_type_t;
 
 /** @brief File Entry Structure */
@@ -73,8 +76,16 @@ typedef struct {
     entry_type_t type;
     int64_t size;
     int32_t index;
+    uint8_t tags; /**< ROM tags (rom_tag_t flags) from the header cache, 0 until the entry is scanned */
+    uint64_t sort_key; /**< Type rank in the top byte, followed by the case folded name prefix */
 } entry_t;
 
+/** @brief Browser sort order enumeration */
+typedef enum {
+    BROWSER_SORT_NAME,
+    BROWSER_SORT_SIZE,
+} browser_sort_t;
+
 typedef struct {
     path_t *disk_path;
     disk_info_t disk_info;
@@ -83,6 +94,7 @@ typedef struct {
 typedef struct {
     disk_slot_entry_t primary;
     disk_slot_entry_t slot[4];
+    int slot_count;
 } disk_slot_t;
 
 /** @brief Menu Structure */
@@ -106,12 +118,14 @@ typedef struct {
         bool go_left;
         bool go_right;
         bool go_fast;
+        int steps;
 
         bool enter;
         bool back;
         bool options;
         bool settings;
         bool lz_context;
+        bool perf_hud;
     } actions;
 
     struct {
@@ -121,10 +135,14 @@ typedef struct {
         mz_zip_archive zip;
         path_t *directory;
         entry_t *list;
+        char *names;
         int32_t entries;
         entry_t *entry;
         int32_t selected;
         path_t* select_file;
+        int32_t scan_position;
+        browser_sort_t sort;
+        bool loading;
     } browser;
 
     struct {
@@ -133,6 +151,7 @@ typedef struct {
         disk_slot_t disk_slots;
         int32_t load_history_id;
         int32_t load_favorite_id;
+        int32_t load_archive_id;
         bool combined_disk_rom;
     } load;
 
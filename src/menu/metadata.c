@@ -0,0 +1,205 @@
+/**
+ * @file metadata.c
+ * @brief Game metadata image resolver implementation
+ * @ingroup menu
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include <libdragon.h>
+
+#include "metadata.h"
+
+#define OLD_BOXART_DIRECTORY        "menu/boxart"
+#define METADATA_BASE_DIRECTORY     "menu/metadata"
+#define HOMEBREW_ID_SUBDIRECTORY    "homebrew"
+
+#define METADATA_CACHE_ENTRIES      (16)
+#define METADATA_KEY_LENGTH         (24)
+#define METADATA_DIRECTORY_LENGTH   (64)
+
+_Static_assert(sizeof(METADATA_BASE_DIRECTORY "/" HOMEBREW_ID_SUBDIRECTORY "/") + 20 <= METADATA_DIRECTORY_LENGTH, "Homebrew metadata directory doesn't fit");
+
+/** @brief Resolved Metadata Directory Structure. */
+typedef struct {
+    bool valid; /**< Entry holds a resolved game */
+    char key[METADATA_KEY_LENGTH]; /**< Game code, or homebrew ROM title */
+    char directory[METADATA_DIRECTORY_LENGTH]; /**< Metadata directory relative to the storage prefix, empty if none */
+    uint32_t images; /**< Mask of the images present in the directory */
+} metadata_entry_t;
+
+static const char *image_file_names[IMAGE_TYPE_END] = {
+    [IMAGE_BOXART_FRONT] = "boxart_front.png",
+    [IMAGE_BOXART_BACK] = "boxart_back.png",
+    [IMAGE_BOXART_TOP] = "boxart_top.png",
+    [IMAGE_BOXART_BOTTOM] = "boxart_bottom.png",
+    [IMAGE_BOXART_LEFT] = "boxart_left.png",
+    [IMAGE_BOXART_RIGHT] = "boxart_right.png",
+    [IMAGE_GAMEPAK_FRONT] = "gamepak_front.png",
+    [IMAGE_GAMEPAK_BACK] = "gamepak_back.png",
+};
+
+static metadata_entry_t metadata_cache[METADATA_CACHE_ENTRIES];
+static int metadata_cache_next = 0;
+
+/**
+ * @brief Check if the ROM uses a homebrew ID.
+ *
+ * @param game_code The 4-character game code.
+ * @param rom_title Title of the ROM (may be NULL).
+ * @return true if the title should be used instead of the game code.
+ */
+static bool is_homebrew (const char *game_code, const char *rom_title) {
+    return (rom_title != NULL) && (game_code[1] == 'E') && (game_code[2] == 'D');
+}
+
+/**
+ * @brief List a directory once and collect the metadata images it holds.
+ *
+ * @param path Directory to list.
+ * @param subdirectory Name of a subdirectory to look for (may be NULL).
+ * @param subdirectory_found Set to true if the subdirectory is present.
+ * @return uint32_t Mask of the images present in the directory.
+ */
+static uint32_t list_images (path_t *path, const char *subdirectory, bool *subdirectory_found) {
+    dir_t info;
+    uint32_t images = 0;
+
+    int result = dir_findfirst(path_get(path), &info);
+
+    while (result == 0) {
+        if (info.d_type == DT_DIR) {
+            if (subdirectory && (strcasecmp(info.d_name, subdirectory) == 0)) {
+                *subdirectory_found = true;
+            }
+        } else {
+            for (int i = 0; i < IMAGE_TYPE_END; i++) {
+                if (image_file_names[i] && (strcasecmp(info.d_name, image_file_names[i]) == 0)) {
+                    images |= METADATA_IMAGE_MASK(i);
+                    break;
+                }
+            }
+        }
+
+        result = dir_findnext(path_get(path), &info);
+    }
+
+    return images;
+}
+
+/**
+ * @brief Locate the metadata directory of a game.
+ *
+ * The region specific directory is preferred over the region-less directory,
+ * and the metadata directory is preferred over the old boxart directory.
+ *
+ * @param storage_prefix The storage prefix.
+ * @param game_code The 4-character game code.
+ * @param rom_title Title of the ROM (may be NULL).
+ * @param entry Pointer to the entry to fill.
+ */
+static void resolve_directory (const char *storage_prefix, const char *game_code, const char *rom_title, metadata_entry_t *entry) {
+    char game_path[METADATA_DIRECTORY_LENGTH];
+
+    entry->directory[0] = '\0';
+    entry->images = 0;
+
+    if (is_homebrew(game_code, rom_title)) {
+        snprintf(game_path, sizeof(game_path), METADATA_BASE_DIRECTORY "/" HOMEBREW_ID_SUBDIRECTORY "/%.20s", rom_title);
+        path_t *path = path_init(storage_prefix, game_path);
+        if ((entry->images = list_images(path, NULL, NULL)) != 0) {
+            snprintf(entry->directory, sizeof(entry->directory), "%s", game_path);
+        }
+        path_free(path);
+        return;
+    }
+
+    const char *base_directories[] = { METADATA_BASE_DIRECTORY, OLD_BOXART_DIRECTORY };
+    char region[2] = { game_code[3], '\0' };
+
+    for (int i = 0; i < (sizeof(base_directories) / sizeof(base_directories[0])); i++) {
+        snprintf(game_path, sizeof(game_path), "%s/%c/%c/%c", base_directories[i], game_code[0], game_code[1], game_code[2]);
+
+        path_t *path = path_init(storage_prefix, game_path);
+        bool region_found = false;
+        uint32_t images = list_images(path, region, &region_found);
+
+        if (region_found) {
+            path_push(path, region);
+            uint32_t region_images = list_images(path, NULL, NULL);
+            if (region_images != 0) {
+                images = region_images;
+                snprintf(game_path, sizeof(game_path), "%s/%c/%c/%c/%c", base_directories[i], game_code[0], game_code[1], game_code[2], game_code[3]);
+            }
+        }
+
+        path_free(path);
+
+        if (images != 0) {
+            snprintf(entry->directory, sizeof(entry->directory), "%s", game_path);
+            entry->images = images;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Find the resolved metadata directory of a game, resolving it on a cache miss.
+ *
+ * @param storage_prefix The storage prefix.
+ * @param game_code The 4-character game code.
+ * @param rom_title Title of the ROM (may be NULL).
+ * @return metadata_entry_t* Pointer to the cache entry.
+ */
+static metadata_entry_t *metadata_find (const char *storage_prefix, const char *game_code, const char *rom_title) {
+    char key[METADATA_KEY_LENGTH];
+
+    if (is_homebrew(game_code, rom_title)) {
+        snprintf(key, sizeof(key), "/%.20s", rom_title);
+    } else {
+        snprintf(key, sizeof(key), "%.4s", game_code);
+    }
+
+    for (int i = 0; i < METADATA_CACHE_ENTRIES; i++) {
+        if (metadata_cache[i].valid && (strcmp(metadata_cache[i].key, key) == 0)) {
+            return &metadata_cache[i];
+        }
+    }
+
+    metadata_entry_t *entry = &metadata_cache[metadata_cache_next];
+    metadata_cache_next = ((metadata_cache_next + 1) % METADATA_CACHE_ENTRIES);
+
+    path_scratch_begin();
+    resolve_directory(storage_prefix, game_code, rom_title, entry);
+    path_scratch_end();
+    strcpy(entry->key, key);
+    entry->valid = true;
+
+    debugf("Metadata: Resolved %s to \"%s\", images 0x%02lX\n", key, entry->directory, entry->images);
+
+    return entry;
+}
+
+uint32_t metadata_get_images (const char *storage_prefix, const char *game_code, const char *rom_title) {
+    return metadata_find(storage_prefix, game_code, rom_title)->images;
+}
+
+path_t *metadata_get_image_path (const char *storage_prefix, const char *game_code, const char *rom_title, file_image_type_t image_type) {
+    if ((image_type < 0) || (image_type >= IMAGE_TYPE_END) || (image_file_names[image_type] == NULL)) {
+        return NULL;
+    }
+
+    metadata_entry_t *entry = metadata_find(storage_prefix, game_code, rom_title);
+
+    if (!(entry->images & METADATA_IMAGE_MASK(image_type))) {
+        return NULL;
+    }
+
+    path_t *path = path_init(storage_prefix, entry->directory);
+    path_push(path, (char *) (image_file_names[image_type]));
+
+    return path;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file metadata.h
+ * @brief Game metadata image resolver
+ * @ingroup menu
+ */
+
+#ifndef METADATA_H__
+#define METADATA_H__
+
+#include <stdint.h>
+
+#include "path.h"
+#include "ui_components.h"
+
+/** @brief Bitmask value of the image type in the available images mask. */
+#define METADATA_IMAGE_MASK(type)   (1 << (type))
+
+/**
+ * @brief Get the metadata images available for a game.
+ *
+ * The game metadata directory is listed once and the result, including the absence of any image,
+ * is cached per game code (or per ROM title for homebrew ROMs) for the rest of the session.
+ *
+ * @param storage_prefix The storage prefix (e.g., SD card root).
+ * @param game_code The 4-character game code.
+ * @param rom_title Title of the ROM (may be NULL), used instead of the game code for homebrew ROMs.
+ * @return uint32_t Mask of the available images, see METADATA_IMAGE_MASK.
+ */
+uint32_t metadata_get_images(const char *storage_prefix, const char *game_code, const char *rom_title);
+
+/**
+ * @brief Get the path of a game metadata image.
+ *
+ * @param storage_prefix The storage prefix (e.g., SD card root).
+ * @param game_code The 4-character game code.
+ * @param rom_title Title of the ROM (may be NULL), used instead of the game code for homebrew ROMs.
+ * @param image_type The image type to look for.
+ * @return path_t* Path to the image, to be freed by the caller, or NULL if the image is not available.
+ */
+path_t *metadata_get_image_path(const char *storage_prefix, const char *game_code, const char *rom_title, file_image_type_t image_type);
+
+#endif /* METADATA_H__ */
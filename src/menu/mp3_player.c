@@ -20,6 +20,19 @@
 #include <minimp3/minimp3.h>
 
 #define SEEK_PREDECODE_FRAMES   (5)
+#define RING_SIZE               KiB(64)
+#define RING_GUARD_SIZE         KiB(16)
+#define RING_CHUNK_SIZE         KiB(8)
+#define RING_REFILL_BUDGET_US   (4000)
+#define DECODE_INPUT_MIN        ALIGN(MAX_FREE_FORMAT_FRAME_SIZE, FS_SECTOR_SIZE)
+#define MP3_FRAME_SAMPLES_MAX   (MINIMP3_MAX_SAMPLES_PER_FRAME / 2)
+#define MP3_HEADER_SIZE         (4)
+#define TOC_ENTRIES             (100)
+#define INDEX_ENTRIES_MAX       (4096)
+#define INDEX_STEP_INITIAL      (32)
+#define INDEX_CHUNK_SIZE        KiB(8)
+#define INDEX_BUDGET_US         (2000)
+#define DECODE_LOAD_WINDOW_US   (1000000)
 
 /** @brief MP3 File Information Structure. */
 typedef struct {
@@ -28,9 +41,11 @@ typedef struct {
     FILE *f; /**< File pointer */
     size_t file_size; /**< Size of the file */
     size_t data_start; /**< Start position of the data */
-    uint8_t buffer[16 * 1024]; /**< Buffer for reading data */
-    uint8_t *buffer_ptr; /**< Pointer to the current position in the buffer */
-    size_t buffer_left; /**< Amount of data left in the buffer */
+    uint8_t ring[RING_SIZE + RING_GUARD_SIZE] __attribute__((aligned(16))); /**< Ring buffer, the guard area mirrors its start */
+    size_t ring_read; /**< Read position in the ring buffer */
+    size_t ring_fill; /**< Amount of data available in the ring buffer */
+    bool eof; /**< The whole file has been read into the ring buffer */
+    uint32_t underruns; /**< Number of times the decoder ran out of data */
 
     mp3dec_t dec; /**< MP3 decoder */
     mp3dec_frame_info_t info; /**< MP3 frame information */
@@ -38,11 +53,32 @@ typedef struct {
     int seek_predecode_frames; /**< Number of frames to pre-decode when seeking */
     float duration; /**< Duration of the MP3 file */
     float bitrate; /**< Bitrate of the MP3 file */
-
-    waveform_t wave; /**< Waveform structure for playback */
+    int samples_per_frame; /**< Number of samples in every frame */
+    uint64_t position; /**< Number of samples decoded from the start of the file */
+
+    bool toc_valid; /**< The file has a seek table from a Xing or VBRI header */
+    uint8_t toc[TOC_ENTRIES]; /**< File position of every percent of the duration, in 1/256 of toc_bytes */
+    uint32_t toc_bytes; /**< Size of the data covered by the seek table */
+
+    FILE *index_f; /**< File pointer used to build the frame index */
+    uint32_t index[INDEX_ENTRIES_MAX]; /**< File positions of every index_step-th frame */
+    int index_entries; /**< Number of valid index entries */
+    int index_step; /**< Number of frames between index entries */
+    uint32_t index_frames; /**< Number of frames found so far */
+    size_t index_position; /**< File position of the next frame to index */
+    bool index_complete; /**< The whole file has been indexed */
+    uint8_t index_chunk[INDEX_CHUNK_SIZE]; /**< Indexing read buffer */
 } mp3player_t;
 
 static mp3player_t *p = NULL;
+static mp3player_t *next = NULL;
+static bool next_stale = false;
+static bool track_changed = false;
+static waveform_t wave;
+static uint64_t decode_us = 0;
+static uint64_t decode_window_start_us = 0;
+static int decode_load = 0;
+static bool frame_scan_enabled = true;
 
 /**
  * @brief Reset the MP3 decoder.
@@ -50,28 +86,323 @@ static mp3player_t *p = NULL;
 static void mp3player_reset_decoder (void) {
     mp3dec_init(&p->dec);
     p->seek_predecode_frames = 0;
-    p->buffer_ptr = p->buffer;
-    p->buffer_left = 0;
+    p->ring_read = 0;
+    p->ring_fill = 0;
+    p->eof = false;
 }
 
 /**
- * @brief Fill the buffer with data from the MP3 file.
+ * @brief Get the data at the read position of the ring buffer.
+ * 
+ * @param length Pointer to store the amount of data readable without wrapping around.
+ * @return uint8_t* Pointer to the data.
  */
-static void mp3player_fill_buffer (void) {
-    if (feof(p->f)) {
-        return;
+static uint8_t *mp3player_ring_peek (size_t *length) {
+    *length = MIN(p->ring_fill, (RING_SIZE + RING_GUARD_SIZE) - p->ring_read);
+    return &p->ring[p->ring_read];
+}
+
+/**
+ * @brief Drop data from the read position of the ring buffer.
+ * 
+ * @param length Amount of data to drop.
+ */
+static void mp3player_ring_consume (size_t length) {
+    p->ring_read = (p->ring_read + length) % RING_SIZE;
+    p->ring_fill -= length;
+}
+
+/**
+ * @brief Read the next chunk of the MP3 file into the ring buffer.
+ * 
+ * The write position always stays aligned to the chunk size, so a chunk never wraps around
+ * and the reads from the file stay sector aligned.
+ * 
+ * @return true if no chunk was read, false otherwise.
+ */
+static bool mp3player_ring_refill_chunk (void) {
+    if (p->eof || ((RING_SIZE - p->ring_fill) < RING_CHUNK_SIZE)) {
+        return true;
+    }
+
+    size_t write = (p->ring_read + p->ring_fill) % RING_SIZE;
+    if ((write % RING_CHUNK_SIZE) != 0) {
+        return true;
+    }
+
+    size_t length = fread(&p->ring[write], 1, RING_CHUNK_SIZE, p->f);
+
+    if (write < RING_GUARD_SIZE) {
+        memcpy(&p->ring[RING_SIZE + write], &p->ring[write], MIN(length, RING_GUARD_SIZE - write));
+    }
+
+    p->ring_fill += length;
+
+    if (length < RING_CHUNK_SIZE) {
+        p->eof = true;
+    }
+
+    return (length == 0);
+}
+
+/**
+ * @brief Fill the whole ring buffer with data from the MP3 file.
+ */
+static void mp3player_ring_fill (void) {
+    while (!mp3player_ring_refill_chunk());
+}
+
+/**
+ * @brief Restart reading the MP3 file from the specified position.
+ * 
+ * The reads start at the sector containing the position, the bytes before it are dropped from the ring buffer.
+ * 
+ * @param position File position.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool mp3player_ring_seek (long position) {
+    long aligned = (position & ~((long) (FS_SECTOR_SIZE) - 1));
+
+    if (fseek(p->f, aligned, SEEK_SET)) {
+        return true;
+    }
+
+    mp3player_reset_decoder();
+    mp3player_ring_fill();
+
+    if (ferror(p->f)) {
+        return true;
+    }
+
+    mp3player_ring_consume(MIN((size_t) (position - aligned), p->ring_fill));
+
+    return false;
+}
+
+/**
+ * @brief Get the file position of the data at the read position of the ring buffer.
+ * 
+ * @return long File position.
+ */
+static long mp3player_ring_tell (void) {
+    return ftell(p->f) - p->ring_fill;
+}
+
+/**
+ * @brief Parse an MP3 frame header.
+ * 
+ * Only Layer III headers with a regular bitrate are accepted, free format frames can't be walked without decoding.
+ * 
+ * @param header Pointer to the header bytes.
+ * @param samples Pointer to store the number of samples in the frame, may be NULL.
+ * @return size_t Frame length in bytes, 0 if the header is invalid.
+ */
+static size_t mp3player_parse_header (const uint8_t *header, int *samples) {
+    static const uint16_t bitrates[2][15] = {
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+    };
+    static const uint16_t samplerates[3] = { 44100, 48000, 32000 };
+
+    if ((header[0] != 0xFF) || ((header[1] & 0xE0) != 0xE0)) {
+        return 0;
+    }
+
+    int version = (header[1] >> 3) & 0x03;
+    int layer = (header[1] >> 1) & 0x03;
+    int bitrate_index = (header[2] >> 4) & 0x0F;
+    int samplerate_index = (header[2] >> 2) & 0x03;
+    int padding = (header[2] >> 1) & 0x01;
+
+    if ((version == 1) || (layer != 1) || (bitrate_index == 0) || (bitrate_index == 15) || (samplerate_index == 3)) {
+        return 0;
+    }
+
+    bool mpeg1 = (version == 3);
+    int samplerate = samplerates[samplerate_index] >> (mpeg1 ? 0 : (version == 2) ? 1 : 2);
+    int bitrate = bitrates[mpeg1 ? 0 : 1][bitrate_index] * 1000;
+
+    if (samples) {
+        *samples = mpeg1 ? 1152 : 576;
+    }
+
+    return ((mpeg1 ? 144 : 72) * bitrate / samplerate) + padding;
+}
+
+/**
+ * @brief Load the seek table from the Xing or VBRI header of the first frame.
+ * 
+ * The VBRI table is converted to the same percent based layout as the Xing table.
+ * 
+ * @param frame Pointer to the first frame.
+ * @param length Number of bytes available from the first frame.
+ */
+static void mp3player_load_toc (const uint8_t *frame, size_t length) {
+    bool mpeg1 = (((frame[1] >> 3) & 0x03) == 3);
+    bool mono = (((frame[3] >> 6) & 0x03) == 3);
+    size_t xing = MP3_HEADER_SIZE + (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17));
+    size_t vbri = MP3_HEADER_SIZE + 32;
+
+    p->toc_valid = false;
+
+    if (((xing + 8) <= length) && (!memcmp(&frame[xing], "Xing", 4) || !memcmp(&frame[xing], "Info", 4))) {
+        const uint8_t *tag = &frame[xing];
+        uint32_t flags = (tag[4] << 24) | (tag[5] << 16) | (tag[6] << 8) | tag[7];
+        size_t offset = 8;
+
+        if (flags & 0x01) {
+            offset += 4;
+        }
+        p->toc_bytes = (p->file_size - p->data_start);
+        if ((flags & 0x02) && ((xing + offset + 4) <= length)) {
+            p->toc_bytes = (tag[offset] << 24) | (tag[offset + 1] << 16) | (tag[offset + 2] << 8) | tag[offset + 3];
+            offset += 4;
+        }
+        if ((flags & 0x04) && ((xing + offset + TOC_ENTRIES) <= length)) {
+            memcpy(p->toc, &tag[offset], TOC_ENTRIES);
+            p->toc_valid = (p->toc_bytes > 0);
+        }
+    } else if (((vbri + 26) <= length) && !memcmp(&frame[vbri], "VBRI", 4)) {
+        const uint8_t *tag = &frame[vbri];
+        uint32_t bytes = (tag[10] << 24) | (tag[11] << 16) | (tag[12] << 8) | tag[13];
+        uint32_t frames = (tag[14] << 24) | (tag[15] << 16) | (tag[16] << 8) | tag[17];
+        int entries = (tag[18] << 8) | tag[19];
+        int scale = (tag[20] << 8) | tag[21];
+        int entry_size = (tag[22] << 8) | tag[23];
+
+        if ((bytes == 0) || (entries == 0) || (entry_size < 1) || (entry_size > 4) || ((vbri + 26 + (entries * entry_size)) > length)) {
+            return;
+        }
+
+        // NOTE: Every VBRI entry holds the size of an equal part of the duration
+        uint32_t position = 0;
+        int entry = 0;
+        for (int i = 0; i < TOC_ENTRIES; i++) {
+            int target = (i * entries) / TOC_ENTRIES;
+            while (entry < target) {
+                uint32_t entry_bytes = 0;
+                for (int j = 0; j < entry_size; j++) {
+                    entry_bytes = (entry_bytes << 8) | tag[26 + (entry * entry_size) + j];
+                }
+                position += entry_bytes * scale;
+                entry += 1;
+            }
+            p->toc[i] = (uint8_t) (MIN(((uint64_t) (position) * 256) / bytes, 255));
+        }
+
+        p->toc_bytes = bytes;
+        p->toc_valid = true;
+
+        // NOTE: The VBRI header isn't recognized by the minimp3 tag check, the duration is taken from its frame count here
+        if (frames > 0) {
+            int samples = 0;
+            mp3player_parse_header(frame, &samples);
+            p->duration = ((float) (frames) * samples) / p->info.hz;
+            p->bitrate = (bytes * 8) / p->duration;
+        }
     }
+}
 
-    if (p->buffer_left >= ALIGN(MAX_FREE_FORMAT_FRAME_SIZE, FS_SECTOR_SIZE)) {
+/**
+ * @brief Record the file position of a frame in the sparse index.
+ * 
+ * The step between the entries is doubled when the index is full, keeping the memory use constant.
+ * 
+ * @param frame Frame number.
+ * @param position File position of the frame.
+ */
+static void mp3player_index_add (uint32_t frame, size_t position) {
+    if ((frame % p->index_step) != 0) {
         return;
     }
 
-    if ((p->buffer_ptr != p->buffer) && (p->buffer_left > 0)) {
-        memmove(p->buffer, p->buffer_ptr, p->buffer_left);
-        p->buffer_ptr = p->buffer;
+    if (p->index_entries == INDEX_ENTRIES_MAX) {
+        for (int i = 0; i < (INDEX_ENTRIES_MAX / 2); i++) {
+            p->index[i] = p->index[i * 2];
+        }
+        p->index_entries = INDEX_ENTRIES_MAX / 2;
+        p->index_step *= 2;
+        if ((frame % p->index_step) != 0) {
+            return;
+        }
     }
 
-    p->buffer_left += fread(p->buffer + p->buffer_left, 1, sizeof(p->buffer) - p->buffer_left, p->f);
+    p->index[p->index_entries++] = position;
+}
+
+/**
+ * @brief Continue building the frame index.
+ * 
+ * Only the frame headers are read, the frames aren't decoded.
+ * 
+ * @param budget_us Time budget in microseconds.
+ */
+static void mp3player_index_continue (uint64_t budget_us) {
+    uint64_t start = get_ticks_us();
+
+    while (!p->index_complete && ((get_ticks_us() - start) < budget_us)) {
+        size_t length = 0;
+
+        if (fseek(p->index_f, p->index_position, SEEK_SET) == 0) {
+            length = fread(p->index_chunk, 1, INDEX_CHUNK_SIZE, p->index_f);
+        }
+
+        if (length < MP3_HEADER_SIZE) {
+            p->index_complete = true;
+            break;
+        }
+
+        size_t offset = 0;
+        while ((offset + MP3_HEADER_SIZE) <= length) {
+            size_t frame_length = mp3player_parse_header(&p->index_chunk[offset], NULL);
+            if (frame_length == 0) {
+                offset += 1;
+                continue;
+            }
+            mp3player_index_add(p->index_frames++, p->index_position + offset);
+            offset += frame_length;
+        }
+
+        p->index_position += offset;
+    }
+
+    if (p->index_complete) {
+        fclose(p->index_f);
+        p->index_f = NULL;
+        if (p->index_frames > 0) {
+            p->duration = ((float) (p->index_frames) * p->samples_per_frame) / p->info.hz;
+            p->bitrate = ((p->file_size - p->data_start) * 8) / p->duration;
+        }
+    }
+}
+
+/**
+ * @brief Skip whole frames at the read position of the ring buffer without decoding them.
+ * 
+ * @param frames Number of frames to skip.
+ * @return int Number of frames skipped.
+ */
+static int mp3player_skip_frames (int frames) {
+    int skipped = 0;
+
+    while (skipped < frames) {
+        if (p->ring_fill < MP3_HEADER_SIZE) {
+            mp3player_ring_fill();
+        }
+
+        size_t available;
+        uint8_t *data = mp3player_ring_peek(&available);
+        size_t frame_length = (available >= MP3_HEADER_SIZE) ? mp3player_parse_header(data, NULL) : 0;
+
+        if ((frame_length == 0) || (frame_length > p->ring_fill)) {
+            break;
+        }
+
+        mp3player_ring_consume(frame_length);
+        skipped += 1;
+    }
+
+    return skipped;
 }
 
 /**
@@ -85,17 +416,29 @@ static void mp3player_fill_buffer (void) {
  */
 static void mp3player_wave_read (void *ctx, samplebuffer_t *sbuf, int wpos, int wlen, bool seeking) {
     while (wlen > 0) {
-        mp3player_fill_buffer();
+        size_t available;
+        uint8_t *data = mp3player_ring_peek(&available);
+
+        // NOTE: The file is never read here, running out of data produces silence until the main loop refills the buffer.
+        if (!p->eof && (available < DECODE_INPUT_MIN)) {
+            short *buffer = (short *) (samplebuffer_append(sbuf, wlen));
+            memset(buffer, 0, wlen * sizeof(short) * p->info.channels);
+            p->underruns += 1;
+            return;
+        }
 
-        int samples = mp3dec_decode_frame(&p->dec, p->buffer_ptr, p->buffer_left, NULL, &p->info);
+        // NOTE: Room for the largest frame is reserved up front, so every frame is parsed and decoded in a single pass.
+        //       The unused part of the reservation is given back to the sample buffer right after decoding.
+        short *buffer = (short *) (samplebuffer_append(sbuf, MP3_FRAME_SAMPLES_MAX));
 
-        if (samples > 0) {
-            short *buffer = (short *) (samplebuffer_append(sbuf, samples));
+        uint64_t decode_start_us = get_ticks_us();
+        int samples = mp3dec_decode_frame(&p->dec, data, available, buffer, &p->info);
+        decode_us += (get_ticks_us() - decode_start_us);
 
-            p->buffer_ptr += p->info.frame_offset;
-            p->buffer_left -= p->info.frame_offset;
+        samplebuffer_undo(sbuf, MP3_FRAME_SAMPLES_MAX - samples);
 
-            mp3dec_decode_frame(&p->dec, p->buffer_ptr, p->buffer_left, buffer, &p->info);
+        if (samples > 0) {
+            p->position += samples;
 
             if (p->seek_predecode_frames > 0) {
                 p->seek_predecode_frames -= 1;
@@ -105,10 +448,26 @@ static void mp3player_wave_read (void *ctx, samplebuffer_t *sbuf, int wpos, int
             wlen -= samples;
         }
 
-        p->buffer_ptr += p->info.frame_bytes;
-        p->buffer_left -= p->info.frame_bytes;
+        mp3player_ring_consume(p->info.frame_bytes);
 
         if (p->info.frame_bytes == 0) {
+            // NOTE: Trailing data without a complete frame is dropped, so the end of the file is reached
+            mp3player_ring_consume(p->ring_fill);
+
+            // NOTE: A queued track in the same format continues in the same buffer, its file is already open and read ahead.
+            //       The finished track is closed later from the main loop.
+            if (
+                next && next->loaded && !next_stale &&
+                (next->info.channels == p->info.channels) && (next->info.hz == p->info.hz)
+            ) {
+                mp3player_t *finished = p;
+                p = next;
+                next = finished;
+                next_stale = true;
+                track_changed = true;
+                continue;
+            }
+
             short *buffer = (short *) (samplebuffer_append(sbuf, wlen));
 
             memset(buffer, 0, wlen * sizeof(short) * p->info.channels);
@@ -128,13 +487,39 @@ static void mp3player_calculate_duration (int samples) {
     int delay, padding;
 
     long data_size = (p->file_size - p->data_start);
-    if (mp3dec_check_vbrtag((const uint8_t *) (p->buffer_ptr), p->info.frame_bytes, &frames, &delay, &padding) > 0) {
+    size_t available;
+    const uint8_t *data = mp3player_ring_peek(&available);
+    if (mp3dec_check_vbrtag(data, p->info.frame_bytes, &frames, &delay, &padding) > 0) {
         p->duration = (frames * samples) / (float) (p->info.hz);
         p->bitrate = (data_size * 8) / p->duration;
     } else {
         p->bitrate = p->info.bitrate_kbps * 1000;
         p->duration = data_size / (p->bitrate / 8);
     }
+
+    p->samples_per_frame = samples;
+
+    mp3player_load_toc(data, available);
+}
+
+/**
+ * @brief Start building the frame index, used for seeking in files without a seek table.
+ * 
+ * @param path Path to the MP3 file.
+ */
+static void mp3player_index_start (char *path) {
+    p->index_entries = 0;
+    p->index_step = INDEX_STEP_INITIAL;
+    p->index_frames = 0;
+    p->index_position = p->data_start;
+    p->index_complete = true;
+
+    if (!frame_scan_enabled || p->toc_valid || ((p->index_f = fopen(path, "rb")) == NULL)) {
+        return;
+    }
+    setbuf(p->index_f, NULL);
+
+    p->index_complete = false;
 }
 
 /**
@@ -163,7 +548,7 @@ mp3player_err_t mp3player_init (void) {
 
     p->loaded = false;
 
-    p->wave = (waveform_t) {
+    wave = (waveform_t) {
         .name = "mp3player",
         .bits = 16,
         .channels = 2,
@@ -171,7 +556,7 @@ mp3player_err_t mp3player_init (void) {
         .len = WAVEFORM_MAX_LEN - 1,
         .loop_len = WAVEFORM_MAX_LEN - 1,
         .read = mp3player_wave_read,
-        .ctx = p,
+        .ctx = NULL,
     };
 
     return MP3PLAYER_OK;
@@ -184,6 +569,8 @@ void mp3player_deinit (void) {
     mp3player_unload();
     free(p);
     p = NULL;
+    free(next);
+    next = NULL;
 }
 
 /**
@@ -197,6 +584,8 @@ mp3player_err_t mp3player_load (char *path) {
         mp3player_unload();
     }
 
+    p->underruns = 0;
+
     if ((p->f = fopen(path, "rb")) == NULL) {
         return MP3PLAYER_ERR_IO;
     }
@@ -211,42 +600,47 @@ mp3player_err_t mp3player_load (char *path) {
 
     mp3player_reset_decoder();
 
-    while (!(feof(p->f) && p->buffer_left == 0)) {
-        mp3player_fill_buffer();
+    while (!(p->eof && p->ring_fill == 0)) {
+        mp3player_ring_fill();
 
         if (ferror(p->f)) {
             fclose(p->f);
             return MP3PLAYER_ERR_IO;
         }
 
-        size_t id3v2_skip = mp3dec_skip_id3v2((const uint8_t *) (p->buffer_ptr), p->buffer_left);
+        size_t available;
+        uint8_t *data = mp3player_ring_peek(&available);
+
+        size_t id3v2_skip = mp3dec_skip_id3v2(data, available);
         if (id3v2_skip > 0) {
-            if (fseek(p->f, (-p->buffer_left) + id3v2_skip, SEEK_CUR)) {
+            if (mp3player_ring_seek(mp3player_ring_tell() + id3v2_skip)) {
                 fclose(p->f);
                 return MP3PLAYER_ERR_IO;
             }
-            mp3player_reset_decoder();
             continue;
         }
 
-        int samples = mp3dec_decode_frame(&p->dec, p->buffer_ptr, p->buffer_left, NULL, &p->info);
+        int samples = mp3dec_decode_frame(&p->dec, data, available, NULL, &p->info);
         if (samples > 0) {
             p->loaded = true;
-            p->data_start = ftell(p->f) - p->buffer_left + p->info.frame_offset;
+            p->data_start = mp3player_ring_tell() + p->info.frame_offset;
 
-            p->buffer_ptr += p->info.frame_offset;
-            p->buffer_left -= p->info.frame_offset;
-
-            p->wave.channels = p->info.channels;
-            p->wave.frequency = p->info.hz;
+            mp3player_ring_consume(p->info.frame_offset);
 
             mp3player_calculate_duration(samples);
 
+            p->position = 0;
+
+            mp3player_index_start(path);
+
             return MP3PLAYER_OK;
         }
 
-        p->buffer_ptr += p->info.frame_bytes;
-        p->buffer_left -= p->info.frame_bytes;
+        if (p->info.frame_bytes == 0) {
+            break;
+        }
+
+        mp3player_ring_consume(p->info.frame_bytes);
     }
 
     if (fclose(p->f)) {
@@ -257,14 +651,74 @@ mp3player_err_t mp3player_load (char *path) {
 }
 
 /**
- * @brief Unload the MP3 file.
+ * @brief Close the files of the MP3 player, without stopping the playback.
+ * 
+ * @param player Pointer to the player.
+ */
+static void mp3player_close (mp3player_t *player) {
+    if (player->loaded) {
+        player->loaded = false;
+        fclose(player->f);
+        if (player->index_f) {
+            fclose(player->index_f);
+            player->index_f = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Unload the MP3 file, the queued track is dropped too.
  */
 void mp3player_unload (void) {
     mp3player_stop();
-    if (p->loaded) {
-        p->loaded = false;
-        fclose(p->f);
+    mp3player_close(p);
+    mp3player_dequeue();
+}
+
+/**
+ * @brief Queue the track to be played right after the current one.
+ * 
+ * The file is opened and read ahead now, so the tracks switch without a gap.
+ * 
+ * @param path Path to the MP3 file.
+ * @return mp3player_err_t Error code.
+ */
+mp3player_err_t mp3player_queue (char *path) {
+    if ((next == NULL) && ((next = calloc(1, sizeof(mp3player_t))) == NULL)) {
+        return MP3PLAYER_ERR_OUT_OF_MEM;
+    }
+
+    mp3player_close(next);
+    next_stale = false;
+
+    // NOTE: The loader works on the current player, it's swapped with the queued one for the duration of the load
+    mp3player_t *current = p;
+    p = next;
+    mp3player_err_t err = mp3player_load(path);
+    p = current;
+
+    return err;
+}
+
+/**
+ * @brief Drop the queued track.
+ */
+void mp3player_dequeue (void) {
+    if (next) {
+        mp3player_close(next);
     }
+    next_stale = false;
+}
+
+/**
+ * @brief Check if the player switched to the queued track since the last call.
+ * 
+ * @return true if the track changed, false otherwise.
+ */
+bool mp3player_track_changed (void) {
+    bool changed = track_changed;
+    track_changed = false;
+    return changed;
 }
 
 /**
@@ -285,6 +739,68 @@ mp3player_err_t mp3player_process (void) {
     return MP3PLAYER_OK;
 }
 
+/**
+ * @brief Refill the ring buffer ahead of the decoder.
+ * 
+ * Chunks are read until the buffer is full or the time budget runs out.
+ */
+void mp3player_poll (void) {
+    if (next_stale) {
+        mp3player_close(next);
+        next_stale = false;
+    }
+
+    uint64_t now_us = get_ticks_us();
+    if ((now_us - decode_window_start_us) >= DECODE_LOAD_WINDOW_US) {
+        decode_load = (int) ((decode_us * 100) / (now_us - decode_window_start_us));
+        decode_us = 0;
+        decode_window_start_us = now_us;
+    }
+
+    if ((p == NULL) || !p->loaded) {
+        return;
+    }
+
+    uint64_t start = get_ticks_us();
+
+    while (((get_ticks_us() - start) < RING_REFILL_BUDGET_US) && !mp3player_ring_refill_chunk());
+
+    if (!p->index_complete) {
+        mp3player_index_continue(INDEX_BUDGET_US);
+    }
+}
+
+/**
+ * @brief Enable or disable the background frame scan of the files loaded afterwards.
+ * 
+ * @param enabled Frame scan enabled flag.
+ */
+void mp3player_set_frame_scan (bool enabled) {
+    frame_scan_enabled = enabled;
+}
+
+/**
+ * @brief Get the share of the CPU time spent decoding over the last second.
+ * 
+ * @return int CPU load in percent.
+ */
+int mp3player_get_decode_load (void) {
+    return decode_load;
+}
+
+/**
+ * @brief Get the number of times the decoder ran out of data since the file was loaded.
+ * 
+ * @return uint32_t Number of underruns.
+ */
+uint32_t mp3player_get_underruns (void) {
+    if (!p->loaded) {
+        return 0;
+    }
+
+    return p->underruns;
+}
+
 /**
  * @brief Check if the MP3 player is playing.
  * 
@@ -300,7 +816,7 @@ bool mp3player_is_playing (void) {
  * @return true if finished, false otherwise.
  */
 bool mp3player_is_finished (void) {
-    return p->loaded && feof(p->f) && (p->buffer_left == 0);
+    return p->loaded && p->eof && (p->ring_fill == 0);
 }
 
 /**
@@ -314,12 +830,14 @@ mp3player_err_t mp3player_play (void) {
     }
     if (!mp3player_is_playing()) {
         if (mp3player_is_finished()) {
-            if (fseek(p->f, p->data_start, SEEK_SET)) {
+            if (mp3player_ring_seek(p->data_start)) {
                 return MP3PLAYER_ERR_IO;
             }
-            mp3player_reset_decoder();
+            p->position = 0;
         }
-        mixer_ch_play(SOUND_MP3_PLAYER_CHANNEL, &p->wave);
+        wave.channels = p->info.channels;
+        wave.frequency = p->info.hz;
+        mixer_ch_play(SOUND_MP3_PLAYER_CHANNEL, &wave);
     }
     return MP3PLAYER_OK;
 }
@@ -360,39 +878,71 @@ void mp3player_mute (bool mute) {
 /**
  * @brief Seek to a specific position in the MP3 file.
  * 
+ * The position is found in the frame index or the seek table of the file, when neither is available
+ * the average bitrate is used to estimate it.
+ * 
  * @param seconds Number of seconds to seek.
  * @return mp3player_err_t Error code.
  */
 mp3player_err_t mp3player_seek (int seconds) {
-    // NOTE: Rough approximation using average bitrate to calculate number of bytes to be skipped.
-    //       Good enough but not very accurate for variable bitrate files.
-
     if (!p->loaded) {
         return MP3PLAYER_ERR_NO_FILE;
     }
 
-    long bytes_to_move = (long) ((p->bitrate * seconds) / 8);
-    if (bytes_to_move == 0) {
+    if (seconds == 0) {
         return MP3PLAYER_OK;
     }
 
-    long position = (ftell(p->f) - p->buffer_left + bytes_to_move);
-    if (position < (long) (p->data_start)) {
-        position = p->data_start;
+    float target = (p->position / (float) (p->info.hz)) + seconds;
+    if (target <= 0.0f) {
+        if (mp3player_ring_seek(p->data_start)) {
+            return MP3PLAYER_ERR_IO;
+        }
+        p->position = 0;
+        return MP3PLAYER_OK;
     }
+    target = MIN(target, p->duration);
 
-    if (fseek(p->f, position, SEEK_SET)) {
-        return MP3PLAYER_ERR_IO;
+    uint32_t target_frame = (uint32_t) ((target * p->info.hz) / p->samples_per_frame);
+    uint32_t start_frame = (target_frame > SEEK_PREDECODE_FRAMES) ? (target_frame - SEEK_PREDECODE_FRAMES) : 0;
+
+    if ((p->index_entries > 0) && (start_frame < p->index_frames)) {
+        // NOTE: The index holds exact frame positions, the frames up to the one before the target are skipped by their headers
+        int entry = MIN(start_frame / p->index_step, p->index_entries - 1);
+        uint32_t frame = entry * p->index_step;
+
+        if (mp3player_ring_seek(p->index[entry])) {
+            return MP3PLAYER_ERR_IO;
+        }
+
+        frame += mp3player_skip_frames(start_frame - frame);
+
+        p->position = (uint64_t) (frame) * p->samples_per_frame;
+        p->seek_predecode_frames = MIN(target_frame - frame, SEEK_PREDECODE_FRAMES);
+
+        return MP3PLAYER_OK;
     }
 
-    mp3player_reset_decoder();
-    mp3player_fill_buffer();
+    long position;
 
-    if (ferror(p->f)) {
+    if (p->toc_valid) {
+        float percent = (target * 100.0f) / p->duration;
+        int entry = MIN((int) (percent), TOC_ENTRIES - 1);
+        float a = p->toc[entry];
+        float b = (entry < (TOC_ENTRIES - 1)) ? p->toc[entry + 1] : 256.0f;
+        float fraction = (a + ((b - a) * (percent - entry))) / 256.0f;
+        position = p->data_start + (long) (fraction * p->toc_bytes);
+    } else {
+        // NOTE: Rough approximation using average bitrate, only used until the frame index reaches the target.
+        position = p->data_start + (long) ((p->bitrate * target) / 8);
+    }
+
+    if (mp3player_ring_seek(position)) {
         return MP3PLAYER_ERR_IO;
     }
 
-    p->seek_predecode_frames = (position == p->data_start) ? 0 : SEEK_PREDECODE_FRAMES;
+    p->position = (uint64_t) (target * p->info.hz);
+    p->seek_predecode_frames = SEEK_PREDECODE_FRAMES;
 
     return MP3PLAYER_OK;
 }
@@ -439,19 +989,82 @@ int mp3player_get_samplerate (void) {
 /**
  * @brief Get the progress of the MP3 file playback.
  * 
- * @return float Progress as a percentage.
+ * @return float Progress as a fraction of the duration.
  */
 float mp3player_get_progress (void) {
-    // NOTE: Rough approximation using file pointer instead of processed samples.
-    //       Good enough but not very accurate for variable bitrate files.
-
-    if (!p->loaded) {
+    if (!p->loaded || (p->duration <= 0.0f)) {
         return 0.0f;
     }
 
-    long data_size = p->file_size - p->data_start;
-    long data_consumed = ftell(p->f) - p->buffer_left;
-    long data_position = (data_consumed > p->data_start) ? (data_consumed - p->data_start) : 0;
+    float progress = (p->position / (float) (p->info.hz)) / p->duration;
+
+    return MIN(progress, 1.0f);
+}
+
+/**
+ * @brief Decode the start of an MP3 file as fast as possible.
+ * 
+ * @param path Path to the MP3 file.
+ * @param max_frames Maximum number of frames to decode.
+ * @param result Pointer to store the results.
+ * @return mp3player_err_t Error code.
+ */
+mp3player_err_t mp3player_benchmark (char *path, int max_frames, mp3player_benchmark_t *result) {
+    mp3player_err_t err;
+    bool initialized = (p != NULL);
+
+    if (!initialized && ((err = mp3player_init()) != MP3PLAYER_OK)) {
+        return err;
+    }
+
+    memset(result, 0, sizeof(mp3player_benchmark_t));
+
+    short *buffer = malloc(MINIMP3_MAX_SAMPLES_PER_FRAME * sizeof(short));
+
+    if (buffer == NULL) {
+        err = MP3PLAYER_ERR_OUT_OF_MEM;
+    } else if ((err = mp3player_load(path)) == MP3PLAYER_OK) {
+        result->samplerate = p->info.hz;
+
+        while (result->frames < max_frames) {
+            if (!p->eof && (p->ring_fill < DECODE_INPUT_MIN)) {
+                uint64_t read_start_us = get_ticks_us();
+                mp3player_ring_fill();
+                result->read_us += (get_ticks_us() - read_start_us);
+
+                if (ferror(p->f)) {
+                    err = MP3PLAYER_ERR_IO;
+                    break;
+                }
+            }
+
+            size_t available;
+            uint8_t *data = mp3player_ring_peek(&available);
+
+            uint64_t decode_start_us = get_ticks_us();
+            int samples = mp3dec_decode_frame(&p->dec, data, available, buffer, &p->info);
+            result->decode_us += (get_ticks_us() - decode_start_us);
+
+            if (p->info.frame_bytes == 0) {
+                break;
+            }
+
+            mp3player_ring_consume(p->info.frame_bytes);
+
+            if (samples > 0) {
+                result->frames += 1;
+                result->samples += samples;
+            }
+        }
+
+        mp3player_unload();
+    }
+
+    free(buffer);
+
+    if (!initialized) {
+        mp3player_deinit();
+    }
 
-    return data_position / (float) (data_size);
+    return err;
 }
@@ -8,6 +8,7 @@
 #define MP3_PLAYER_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /** 
  * @brief MP3 file error enumeration.
@@ -22,6 +23,15 @@ typedef enum {
     MP3PLAYER_ERR_INVALID_FILE, /**< Invalid file error */
 } mp3player_err_t;
 
+/** @brief MP3 decode benchmark results structure. */
+typedef struct {
+    int frames; /**< Number of decoded frames */
+    uint64_t samples; /**< Number of decoded samples per channel */
+    int samplerate; /**< Sample rate of the file */
+    uint64_t decode_us; /**< Time spent decoding in microseconds */
+    uint64_t read_us; /**< Time spent reading the file in microseconds */
+} mp3player_benchmark_t;
+
 /**
  * @brief Initialize the MP3 player mixer.
  * 
@@ -62,6 +72,33 @@ mp3player_err_t mp3player_load(char *path);
  */
 void mp3player_unload(void);
 
+/**
+ * @brief Queue the next MP3 file.
+ * 
+ * This function opens the file and reads it ahead, so it starts without a gap when the current file ends.
+ * Only files with the same channel count and samplerate as the current one continue without a gap.
+ * 
+ * @param path Path to the MP3 file.
+ * @return mp3player_err_t Error code indicating the result of the queue operation.
+ */
+mp3player_err_t mp3player_queue(char *path);
+
+/**
+ * @brief Drop the queued MP3 file.
+ * 
+ * This function closes the file queued with mp3player_queue.
+ */
+void mp3player_dequeue(void);
+
+/**
+ * @brief Check if the MP3 player switched to the queued file.
+ * 
+ * This function reports the switch once, the queued file becomes the current one.
+ * 
+ * @return true if the current file changed since the last call, false otherwise.
+ */
+bool mp3player_track_changed(void);
+
 /**
  * @brief Process the MP3 player.
  * 
@@ -71,6 +108,43 @@ void mp3player_unload(void);
  */
 mp3player_err_t mp3player_process(void);
 
+/**
+ * @brief Poll the MP3 player.
+ * 
+ * This function reads the MP3 file ahead of the decoder, the file is never read from the audio callback.
+ * Called from the main loop before the audio is mixed.
+ */
+void mp3player_poll(void);
+
+/**
+ * @brief Enable or disable the background frame scan.
+ * 
+ * This function controls the scan of the frame headers of the files without a Xing or VBRI seek table.
+ * The scan gives the exact duration and average bitrate, and the frame index used for seeking.
+ * It applies to the files loaded afterwards.
+ * 
+ * @param enabled Frame scan enabled flag.
+ */
+void mp3player_set_frame_scan(bool enabled);
+
+/**
+ * @brief Get the decoder CPU load.
+ * 
+ * This function returns the share of the CPU time spent decoding MP3 frames over the last second.
+ * 
+ * @return int CPU load in percent.
+ */
+int mp3player_get_decode_load(void);
+
+/**
+ * @brief Get the number of decoder underruns.
+ * 
+ * This function returns how many times the decoder ran out of data and produced silence since the file was loaded.
+ * 
+ * @return uint32_t Number of underruns.
+ */
+uint32_t mp3player_get_underruns(void);
+
 /**
  * @brief Check if the MP3 player is playing.
  * 
@@ -169,4 +243,16 @@ int mp3player_get_samplerate(void);
  */
 float mp3player_get_progress(void);
 
+/**
+ * @brief Decode the start of an MP3 file as fast as possible, without playing it.
+ * 
+ * The currently loaded file is unloaded.
+ * 
+ * @param path Path to the MP3 file.
+ * @param max_frames Maximum number of frames to decode.
+ * @param result Pointer to store the results.
+ * @return mp3player_err_t Error code.
+ */
+mp3player_err_t mp3player_benchmark(char *path, int max_frames, mp3player_benchmark_t *result);
+
 #endif /* MP3_PLAYER_H__ */
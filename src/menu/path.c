@@ -5,6 +5,7 @@
  */
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -12,21 +13,84 @@
 
 #define PATH_CAPACITY_INITIAL   255
 #define PATH_CAPACITY_ALIGNMENT 32
+#define PATH_SCRATCH_SIZE       (16 * 1024)
+#define PATH_SCRATCH_DEPTH_MAX  (8)
+
+static uint8_t scratch[PATH_SCRATCH_SIZE] __attribute__((aligned(8)));
+static size_t scratch_used = 0;
+static size_t scratch_marks[PATH_SCRATCH_DEPTH_MAX];
+static int scratch_depth = 0;
+
+/**
+ * @brief Allocate memory from the scratch arena.
+ * 
+ * @param size Size of the allocation.
+ * @return void* Pointer to the allocation, NULL if no scope is active or the arena is full.
+ */
+static void *scratch_alloc (size_t size) {
+    size = (size + 7) & ~7;
+    if ((scratch_depth == 0) || (scratch_depth > PATH_SCRATCH_DEPTH_MAX) || ((scratch_used + size) > PATH_SCRATCH_SIZE)) {
+        return NULL;
+    }
+    void *pointer = &scratch[scratch_used];
+    scratch_used += size;
+    return pointer;
+}
 
 /**
  * @brief Resize the path buffer to accommodate the specified minimum length.
  * 
+ * A scratch buffer can't grow in place, the contents are copied to a new buffer instead.
+ * 
  * @param path Pointer to the path structure.
  * @param min_length Minimum length to accommodate.
  */
 static void path_resize (path_t *path, size_t min_length) {
-    path->capacity = min_length > PATH_CAPACITY_INITIAL ? min_length : PATH_CAPACITY_INITIAL;
-    size_t alignment = path->capacity % PATH_CAPACITY_ALIGNMENT;
+    size_t root_offset = path->root - path->buffer;
+    size_t capacity = min_length > PATH_CAPACITY_INITIAL ? min_length : PATH_CAPACITY_INITIAL;
+    size_t alignment = capacity % PATH_CAPACITY_ALIGNMENT;
     if (alignment != (PATH_CAPACITY_ALIGNMENT - 1)) {
-        path->capacity += PATH_CAPACITY_ALIGNMENT - alignment;
+        capacity += PATH_CAPACITY_ALIGNMENT - alignment;
+    }
+    if ((path->buffer == NULL) || path->scratch_buffer) {
+        char *buffer = scratch_alloc((capacity + 1) * sizeof(char));
+        bool scratch_buffer = (buffer != NULL);
+        if (!scratch_buffer) {
+            buffer = malloc((capacity + 1) * sizeof(char));
+            assert(buffer != NULL);
+        }
+        if (path->buffer != NULL) {
+            memcpy(buffer, path->buffer, path->capacity + 1);
+        }
+        path->buffer = buffer;
+        path->scratch_buffer = scratch_buffer;
+    } else {
+        path->buffer = realloc(path->buffer, (capacity + 1) * sizeof(char));
+        assert(path->buffer != NULL);
+    }
+    path->capacity = capacity;
+    path->root = path->buffer + root_offset;
+}
+
+/**
+ * @brief Begin a scratch arena scope.
+ */
+void path_scratch_begin (void) {
+    if (scratch_depth < PATH_SCRATCH_DEPTH_MAX) {
+        scratch_marks[scratch_depth] = scratch_used;
+    }
+    scratch_depth += 1;
+}
+
+/**
+ * @brief End the innermost scratch arena scope.
+ */
+void path_scratch_end (void) {
+    assert(scratch_depth > 0);
+    scratch_depth -= 1;
+    if (scratch_depth < PATH_SCRATCH_DEPTH_MAX) {
+        scratch_used = scratch_marks[scratch_depth];
     }
-    path->buffer = realloc(path->buffer, (path->capacity + 1) * sizeof(char));
-    assert(path->buffer != NULL);
 }
 
 /**
@@ -39,8 +103,14 @@ path_t *path_create (const char *string) {
     if (string == NULL) {
         string = "";
     }
-    path_t *path = calloc(1, sizeof(path_t));
-    assert(path != NULL);
+    path_t *path = scratch_alloc(sizeof(path_t));
+    if (path != NULL) {
+        memset(path, 0, sizeof(path_t));
+        path->scratch = true;
+    } else {
+        path = calloc(1, sizeof(path_t));
+        assert(path != NULL);
+    }
     path_resize(path, strlen(string));
     memset(path->buffer, 0, path->capacity + 1);
     strcpy(path->buffer, string);
@@ -91,8 +161,12 @@ path_t *path_init (const char *prefix, char *string) {
  */
 void path_free (path_t *path) {
     if (path != NULL) {
-        free(path->buffer);
-        free(path);
+        if (!path->scratch_buffer) {
+            free(path->buffer);
+        }
+        if (!path->scratch) {
+            free(path);
+        }
     }
 }
 
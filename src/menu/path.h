@@ -17,8 +17,24 @@ typedef struct {
     char *buffer;    /**< Buffer for the path */
     char *root;      /**< Root directory */
     size_t capacity; /**< Capacity of the buffer */
+    bool scratch;    /**< The structure is allocated in the scratch arena */
+    bool scratch_buffer; /**< The buffer is allocated in the scratch arena */
 } path_t;
 
+/**
+ * @brief Begin a scratch arena scope
+ * 
+ * Until the scope ends, the paths are allocated in a static arena instead of the heap,
+ * and freeing them does nothing. A path created in a scope must not be used after the scope ends.
+ * The heap is used when the arena runs out of space. Scopes can be nested.
+ */
+void path_scratch_begin(void);
+
+/**
+ * @brief End the innermost scratch arena scope, releasing the paths allocated in it
+ */
+void path_scratch_end(void);
+
 /**
  * @brief Create a new path object
  * 
@@ -5,191 +5,614 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fatfs/ff.h>
+#include <libdragon.h>
 #include <libspng/spng/spng.h>
+#include "memory_budget.h"
 #include "png_decoder.h"
 #include "utils/fs.h"
+#include "utils/utils.h"
 
-/** @brief PNG File Information Structure. */
+#define PNG_FILE_SIZE_MAX           (MiB(2))
+#define PNG_STREAM_CHUNK_SIZE       (KiB(16))
+#define PNG_BACKGROUND_BUDGET_US    (2000)
+#define PNG_FOREGROUND_BUDGET_US    (50000)
+#define PNG_JOBS_MAX                (8)
+#define PNG_DOWNSCALE_DIMENSION_MAX (8192)
+
+/** @brief PNG Decoder Job State Enumeration. */
+typedef enum {
+    JOB_FREE, /**< Slot not in use */
+    JOB_QUEUED, /**< Waiting for its turn, file not read yet */
+    JOB_ACTIVE, /**< File read and decoding started */
+} png_job_state_t;
+
+/** @brief PNG Decoder Job Structure. */
 typedef struct {
-    FILE *f; /**< File pointer */
+    png_job_state_t state; /**< Job state */
+    png_job_t id; /**< Job handle */
+    char *path; /**< Path to the PNG file */
+    int max_width; /**< Maximum image width */
+    int max_height; /**< Maximum image height */
+    png_priority_t priority; /**< Decoding priority */
+    bool dither; /**< Ordered dithering enabled flag */
+    bool downscale; /**< Oversized images are downscaled instead of rejected */
+    int scale; /**< Integer downscale factor, 1 when the image is decoded as is */
+    uint32_t *accumulator; /**< Per pixel channel sums of the output row being downscaled */
+    uint8_t *data; /**< Whole file contents, or the current chunk of a streamed file */
+    bool streamed; /**< The file is too large to be read at once and is read in chunks */
+    FIL file; /**< Streamed file, kept open for sequential reads */
+    bool file_open; /**< The streamed file is open */
+    size_t chunk_length; /**< Length of the current chunk */
+    size_t chunk_position; /**< Read position in the current chunk */
     spng_ctx *ctx; /**< SPNG context */
     struct spng_ihdr ihdr; /**< SPNG image header */
     surface_t *image; /**< Image surface */
     uint8_t *row_buffer; /**< Row buffer */
     int decoded_rows; /**< Number of decoded rows */
+    uint32_t row_time_us; /**< Running average of the row decoding time */
     png_callback_t *callback; /**< Callback function */
     void *callback_data; /**< Callback data */
-} png_decoder_t;
+} png_decoder_job_t;
+
+static png_decoder_job_t jobs[PNG_JOBS_MAX];
+static png_job_t next_job_id = 1;
 
-static png_decoder_t *decoder;
+/** @brief 4x4 Bayer matrix, scaled to the range dropped by the 8 to 5 bit truncation. */
+static const uint8_t dither_matrix[4][4] = {
+    { 0, 4, 1, 5 },
+    { 6, 2, 7, 3 },
+    { 1, 5, 0, 4 },
+    { 7, 3, 6, 2 },
+};
+
+#define RGB5551(r, g, b)    ((((r) >> 3) << 11) | (((g) >> 3) << 6) | (((b) >> 3) << 1) | 1)
 
 /**
- * @brief Deinitialize the PNG decoder.
+ * @brief Release a job slot and its resources.
  * 
+ * @param job Pointer to the job.
  * @param free_image Flag indicating whether to free the image.
  */
-static void png_decoder_deinit (bool free_image) {
-    if (decoder != NULL) {
-        fclose(decoder->f);
-        if (decoder->ctx != NULL) {
-            spng_ctx_free(decoder->ctx);
+static void job_release (png_decoder_job_t *job, bool free_image) {
+    if (job->file_open) {
+        f_close(&job->file);
+    }
+    free(job->path);
+    free(job->data);
+    if (job->ctx != NULL) {
+        spng_ctx_free(job->ctx);
+    }
+    if ((job->image != NULL) && free_image) {
+        surface_free(job->image);
+        free(job->image);
+    }
+    free(job->row_buffer);
+    free(job->accumulator);
+    memset(job, 0, sizeof(png_decoder_job_t));
+}
+
+/**
+ * @brief Find a job by its handle.
+ * 
+ * @param id Job handle.
+ * @return Pointer to the job, or NULL if the job has already finished.
+ */
+static png_decoder_job_t *job_find (png_job_t id) {
+    if (id == PNG_JOB_NONE) {
+        return NULL;
+    }
+    for (int i = 0; i < PNG_JOBS_MAX; i++) {
+        if ((jobs[i].state != JOB_FREE) && (jobs[i].id == id)) {
+            return &jobs[i];
         }
-        if ((decoder->image != NULL) && free_image) {
-            surface_free(decoder->image);
-            free(decoder->image);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Select the job to decode next.
+ * 
+ * Highest priority job wins, jobs of the same priority are decoded in submission order.
+ * A preempted job keeps its progress and continues once no higher priority job is left.
+ * 
+ * @return Pointer to the job, or NULL if the queue is empty.
+ */
+static png_decoder_job_t *job_select (void) {
+    png_decoder_job_t *selected = NULL;
+    for (int i = 0; i < PNG_JOBS_MAX; i++) {
+        png_decoder_job_t *job = &jobs[i];
+        if (job->state == JOB_FREE) {
+            continue;
         }
-        if (decoder->row_buffer != NULL) {
-            free(decoder->row_buffer);
+        if ((selected == NULL) || (job->priority > selected->priority) || ((job->priority == selected->priority) && (job->id < selected->id))) {
+            selected = job;
         }
-        free(decoder);
-        decoder = NULL;
     }
+    return selected;
 }
 
 /**
- * @brief Start decoding a PNG file.
+ * @brief Finish a job and report the result.
  * 
- * @param path Path to the PNG file.
- * @param max_width Maximum width of the image.
- * @param max_height Maximum height of the image.
- * @param callback Callback function to be called upon completion.
- * @param callback_data Data to be passed to the callback function.
+ * The slot is released before the callback is called, so the callback can start new jobs.
+ * 
+ * @param job Pointer to the job.
+ * @param err Result of the decoding process.
+ */
+static void job_finish (png_decoder_job_t *job, png_err_t err) {
+    png_callback_t *callback = job->callback;
+    void *callback_data = job->callback_data;
+    surface_t *image = (err == PNG_OK) ? job->image : NULL;
+
+    job_release(job, (err != PNG_OK));
+
+    callback(err, image, callback_data);
+}
+
+/**
+ * @brief Read callback of the streamed files, the file is read in chunks as spng consumes it.
+ *
+ * The file stays open for the whole decode, so each chunk is a sequential read
+ * rather than a new directory lookup and cluster chain walk.
+ */
+static int job_stream_read (spng_ctx *ctx, void *user, void *dest, size_t length) {
+    png_decoder_job_t *job = user;
+    uint8_t *output = dest;
+
+    while (length > 0) {
+        if (job->chunk_position >= job->chunk_length) {
+            UINT chunk;
+            if (f_read(&job->file, job->data, PNG_STREAM_CHUNK_SIZE, &chunk) != FR_OK) {
+                return SPNG_IO_ERROR;
+            }
+            if (chunk == 0) {
+                return SPNG_IO_EOF;
+            }
+            job->chunk_length = chunk;
+            job->chunk_position = 0;
+        }
+
+        size_t copied = MIN(length, job->chunk_length - job->chunk_position);
+        memcpy(output, &job->data[job->chunk_position], copied);
+        job->chunk_position += copied;
+        output += copied;
+        length -= copied;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read the file and prepare the decoding of a queued job.
+ * 
+ * @param job Pointer to the job.
  * @return png_err_t Error code.
  */
-png_err_t png_decoder_start (char *path, int max_width, int max_height, png_callback_t *callback, void *callback_data) {
-    if (decoder != NULL) {
-        return PNG_ERR_BUSY;
+static png_err_t job_activate (png_decoder_job_t *job) {
+    job->state = JOB_ACTIVE;
+
+    // NOTE: Files up to PNG_FILE_SIZE_MAX are read at once and decoded straight from memory, larger ones are streamed in chunks
+    int64_t size = file_get_size(job->path);
+    if (size < 0) {
+        return PNG_ERR_NO_FILE;
     }
 
-    decoder = calloc(1, sizeof(png_decoder_t));
-    if (decoder == NULL) {
+    job->streamed = (size > PNG_FILE_SIZE_MAX);
+
+    size_t buffer_size = job->streamed ? PNG_STREAM_CHUNK_SIZE : (size_t) (size);
+
+    if (memory_budget_reserve(buffer_size) || ((job->data = malloc(buffer_size)) == NULL)) {
         return PNG_ERR_OUT_OF_MEM;
     }
 
-    if ((decoder->f = fopen(path, "rb")) == NULL) {
-        png_decoder_deinit(false);
+    size_t length = 0;
+    if (job->streamed) {
+        if (f_open(&job->file, strip_fs_prefix(job->path), FA_READ) != FR_OK) {
+            return PNG_ERR_NO_FILE;
+        }
+        job->file_open = true;
+    } else if (file_read_all(job->path, job->data, buffer_size, &length)) {
         return PNG_ERR_NO_FILE;
     }
 
-    setbuf(decoder->f, NULL);
-
-    if ((decoder->ctx = spng_ctx_new(SPNG_CTX_IGNORE_ADLER32)) == NULL) {
-        png_decoder_deinit(false);
+    if ((job->ctx = spng_ctx_new(SPNG_CTX_IGNORE_ADLER32)) == NULL) {
         return PNG_ERR_OUT_OF_MEM;
     }
 
-    if (spng_set_crc_action(decoder->ctx, SPNG_CRC_USE, SPNG_CRC_USE) != SPNG_OK) {
-        png_decoder_deinit(false);
+    if (spng_set_crc_action(job->ctx, SPNG_CRC_USE, SPNG_CRC_USE) != SPNG_OK) {
         return PNG_ERR_INT;
     }
 
-    if (spng_set_image_limits(decoder->ctx, max_width, max_height) != SPNG_OK) {
-        png_decoder_deinit(false);
+    int limit_width = job->downscale ? PNG_DOWNSCALE_DIMENSION_MAX : job->max_width;
+    int limit_height = job->downscale ? PNG_DOWNSCALE_DIMENSION_MAX : job->max_height;
+
+    if (spng_set_image_limits(job->ctx, limit_width, limit_height) != SPNG_OK) {
         return PNG_ERR_INT;
     }
 
-    if (spng_set_png_file(decoder->ctx, decoder->f) != SPNG_OK) {
-        png_decoder_deinit(false);
+    if (job->streamed) {
+        if (spng_set_png_stream(job->ctx, job_stream_read, job) != SPNG_OK) {
+            return PNG_ERR_INT;
+        }
+    } else if (spng_set_png_buffer(job->ctx, job->data, length) != SPNG_OK) {
         return PNG_ERR_INT;
     }
 
     size_t image_size;
 
-    if (spng_decoded_image_size(decoder->ctx, SPNG_FMT_RGB8, &image_size) != SPNG_OK) {
-        png_decoder_deinit(false);
+    if (spng_decoded_image_size(job->ctx, SPNG_FMT_RGB8, &image_size) != SPNG_OK) {
         return PNG_ERR_BAD_FILE;
     }
 
-    if (spng_decode_image(decoder->ctx, NULL, image_size, SPNG_FMT_RGB8, SPNG_DECODE_PROGRESSIVE) != SPNG_OK) {
-        png_decoder_deinit(false);
+    if (spng_decode_image(job->ctx, NULL, image_size, SPNG_FMT_RGB8, SPNG_DECODE_PROGRESSIVE) != SPNG_OK) {
         return PNG_ERR_BAD_FILE;
     }
 
-    if (spng_get_ihdr(decoder->ctx, &decoder->ihdr) != SPNG_OK) {
-        png_decoder_deinit(false);
+    if (spng_get_ihdr(job->ctx, &job->ihdr) != SPNG_OK) {
         return PNG_ERR_BAD_FILE;
     }
 
-    decoder->image = calloc(1, sizeof(surface_t));
-    if (decoder->image == NULL) {
-        png_decoder_deinit(false);
+    job->image = calloc(1, sizeof(surface_t));
+    if (job->image == NULL) {
+        return PNG_ERR_OUT_OF_MEM;
+    }
+
+    job->scale = 1;
+    if (job->downscale) {
+        job->scale = MAX(
+            ((int) (job->ihdr.width) + job->max_width - 1) / job->max_width,
+            ((int) (job->ihdr.height) + job->max_height - 1) / job->max_height
+        );
+        job->scale = MAX(job->scale, 1);
+        // NOTE: Rows of interlaced images arrive out of order, they can't be averaged on the fly
+        if ((job->scale > 1) && (job->ihdr.interlace_method != 0)) {
+            return PNG_ERR_TOO_LARGE;
+        }
+    }
+
+    int width = MAX((int) (job->ihdr.width) / job->scale, 1);
+    int height = MAX((int) (job->ihdr.height) / job->scale, 1);
+
+    // NOTE: The caches make room for the image and the row buffers up front, instead of the allocations failing
+    if (memory_budget_reserve((width * height * sizeof(uint16_t)) + (job->ihdr.width * 3) + (width * 3 * sizeof(uint32_t)))) {
         return PNG_ERR_OUT_OF_MEM;
     }
 
-    *decoder->image = surface_alloc(FMT_RGBA16, decoder->ihdr.width, decoder->ihdr.height);
-    if (decoder->image->buffer == NULL) {
-        png_decoder_deinit(true);
+    if ((job->scale > 1) && ((job->accumulator = calloc(width * 3, sizeof(uint32_t))) == NULL)) {
         return PNG_ERR_OUT_OF_MEM;
     }
 
-    if ((decoder->row_buffer = malloc(decoder->ihdr.width * 3)) == NULL) {
-        png_decoder_deinit(true);
+    *job->image = surface_alloc(FMT_RGBA16, width, height);
+    if (job->image->buffer == NULL) {
         return PNG_ERR_OUT_OF_MEM;
     }
 
-    decoder->decoded_rows = 0;
+    if ((job->row_buffer = malloc(job->ihdr.width * 3)) == NULL) {
+        return PNG_ERR_OUT_OF_MEM;
+    }
 
-    decoder->callback = callback;
-    decoder->callback_data = callback_data;
+    job->decoded_rows = 0;
 
     return PNG_OK;
 }
 
 /**
- * @brief Abort the PNG decoding process.
+ * @brief Convert a decoded RGB8 row to RGBA16.
+ * 
+ * Four pixels are loaded as three words at once, the row buffer is always word aligned.
+ * 
+ * @param src Decoded RGB8 row.
+ * @param dst Destination RGBA16 row.
+ * @param width Row width in pixels.
  */
-void png_decoder_abort (void) {
-    png_decoder_deinit(true);
+static void png_decoder_convert_row (const uint8_t *src, uint16_t *dst, int width) {
+    const uint32_t *words = (const uint32_t *) (src);
+    int x = 0;
+
+    for (; (x + 4) <= width; x += 4) {
+        uint32_t w0 = *words++;
+        uint32_t w1 = *words++;
+        uint32_t w2 = *words++;
+
+        dst[x + 0] = ((w0 >> 16) & 0xF800) | ((w0 >> 13) & 0x07C0) | ((w0 >> 10) & 0x003E) | 1;
+        dst[x + 1] = ((w0 << 8) & 0xF800) | ((w1 >> 21) & 0x07C0) | ((w1 >> 18) & 0x003E) | 1;
+        dst[x + 2] = ((w1 >> 0) & 0xF800) | ((w1 << 3) & 0x07C0) | ((w2 >> 26) & 0x003E) | 1;
+        dst[x + 3] = ((w2 >> 8) & 0xF800) | ((w2 >> 5) & 0x07C0) | ((w2 >> 2) & 0x003E) | 1;
+    }
+
+    for (src += (x * 3); x < width; x++, src += 3) {
+        dst[x] = RGB5551(src[0], src[1], src[2]);
+    }
 }
 
 /**
- * @brief Get the progress of the PNG decoding process.
+ * @brief Convert a decoded RGB8 row to RGBA16 with ordered dithering.
  * 
- * @return float Progress as a percentage.
+ * @param src Decoded RGB8 row.
+ * @param dst Destination RGBA16 row.
+ * @param width Row width in pixels.
+ * @param y Row number, selects the dither matrix row.
  */
-float png_decoder_get_progress (void) {
-    if (!decoder) {
-        return 0.0f;
-    }
+static void png_decoder_convert_row_dithered (const uint8_t *src, uint16_t *dst, int width, int y) {
+    const uint8_t *matrix = dither_matrix[y & 3];
 
-    return (float) (decoder->decoded_rows) / (decoder->ihdr.height);
+    for (int x = 0; x < width; x++, src += 3) {
+        int d = matrix[x & 3];
+        int r = MIN(src[0] + d, 255);
+        int g = MIN(src[1] + d, 255);
+        int b = MIN(src[2] + d, 255);
+        dst[x] = RGB5551(r, g, b);
+    }
 }
 
 /**
- * @brief Poll the PNG decoder to process the next row.
+ * @brief Box filter a decoded RGB8 row into the downscaled image.
+ *
+ * Every output pixel is the average of a scale by scale block of source pixels,
+ * source rows and columns past the last full block are dropped.
+ *
+ * @param job Pointer to the job.
+ * @param y Source row number.
  */
-void png_decoder_poll (void) {
-    if (!decoder) {
+static void png_decoder_downscale_row (png_decoder_job_t *job, int y) {
+    int scale = job->scale;
+    int out_y = y / scale;
+    int width = job->image->width;
+
+    if (out_y >= job->image->height) {
+        return;
+    }
+
+    const uint8_t *src = job->row_buffer;
+    uint32_t *acc = job->accumulator;
+
+    for (int x = 0; x < width; x++, acc += 3) {
+        uint32_t r = 0, g = 0, b = 0;
+        for (int i = 0; i < scale; i++, src += 3) {
+            r += src[0];
+            g += src[1];
+            b += src[2];
+        }
+        acc[0] += r;
+        acc[1] += g;
+        acc[2] += b;
+    }
+
+    if ((y % scale) != (scale - 1)) {
         return;
     }
 
+    uint32_t area = scale * scale;
+    uint16_t *dst = job->image->buffer + (out_y * job->image->stride);
+    const uint8_t *matrix = dither_matrix[out_y & 3];
+
+    acc = job->accumulator;
+    for (int x = 0; x < width; x++, acc += 3) {
+        int d = job->dither ? matrix[x & 3] : 0;
+        int r = MIN((int) (acc[0] / area) + d, 255);
+        int g = MIN((int) (acc[1] / area) + d, 255);
+        int b = MIN((int) (acc[2] / area) + d, 255);
+        dst[x] = RGB5551(r, g, b);
+    }
+
+    memset(job->accumulator, 0, width * 3 * sizeof(uint32_t));
+}
+
+/**
+ * @brief Decode the next image row of a job.
+ * 
+ * @param job Pointer to the job.
+ * @return true if the job finished or failed, false otherwise.
+ */
+static bool job_decode_row (png_decoder_job_t *job) {
     enum spng_errno err;
     struct spng_row_info row_info;
 
-    if ((err = spng_get_row_info(decoder->ctx, &row_info)) != SPNG_OK) {
-        decoder->callback(PNG_ERR_BAD_FILE, NULL, decoder->callback_data);
-        png_decoder_deinit(true);
-        return;
+    if ((err = spng_get_row_info(job->ctx, &row_info)) != SPNG_OK) {
+        job_finish(job, PNG_ERR_BAD_FILE);
+        return true;
     }
 
-    err = spng_decode_row(decoder->ctx, decoder->row_buffer, decoder->ihdr.width * 3);
+    err = spng_decode_row(job->ctx, job->row_buffer, job->ihdr.width * 3);
 
     if (err == SPNG_OK || err == SPNG_EOI) {
-        decoder->decoded_rows += 1;
-        uint16_t *image_buffer = decoder->image->buffer + (row_info.row_num * decoder->image->stride);
-        for (int i = 0; i < decoder->ihdr.width * 3; i += 3) {
-            uint8_t r = decoder->row_buffer[i + 0] >> 3;
-            uint8_t g = decoder->row_buffer[i + 1] >> 3;
-            uint8_t b = decoder->row_buffer[i + 2] >> 3;
-            *image_buffer++ = (r << 11) | (g << 6) | (b << 1) | 1;
+        job->decoded_rows += 1;
+        uint16_t *image_buffer = job->image->buffer + (row_info.row_num * job->image->stride);
+        if (job->scale > 1) {
+            png_decoder_downscale_row(job, row_info.row_num);
+        } else if (job->dither) {
+            png_decoder_convert_row_dithered(job->row_buffer, image_buffer, job->ihdr.width, row_info.row_num);
+        } else {
+            png_decoder_convert_row(job->row_buffer, image_buffer, job->ihdr.width);
         }
     }
 
     if (err == SPNG_EOI) {
-        decoder->callback(PNG_OK, decoder->image, decoder->callback_data);
-        png_decoder_deinit(false);
+        job_finish(job, PNG_OK);
+        return true;
     } else if (err != SPNG_OK) {
-        decoder->callback(PNG_ERR_BAD_FILE, NULL, decoder->callback_data);
-        png_decoder_deinit(true);
+        job_finish(job, PNG_ERR_BAD_FILE);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Queue a PNG decoding job.
+ * 
+ * Only the file size is checked here, the file is read once the job gets its turn.
+ * 
+ * @param path Path to the PNG file.
+ * @param max_width Maximum width of the image.
+ * @param max_height Maximum height of the image.
+ * @param priority Decoding priority.
+ * @param callback Callback function to be called upon completion.
+ * @param callback_data Data to be passed to the callback function.
+ * @param job Pointer to the job handle, may be NULL.
+ * @return png_err_t Error code.
+ */
+png_err_t png_decoder_start (char *path, int max_width, int max_height, png_priority_t priority, png_callback_t *callback, void *callback_data, png_job_t *job) {
+    png_decoder_job_t *slot = NULL;
+
+    for (int i = 0; i < PNG_JOBS_MAX; i++) {
+        if (jobs[i].state == JOB_FREE) {
+            slot = &jobs[i];
+            break;
+        }
+    }
+
+    if (slot == NULL) {
+        return PNG_ERR_BUSY;
+    }
+
+    if (!file_exists(path)) {
+        return PNG_ERR_NO_FILE;
+    }
+
+    if ((slot->path = strdup(path)) == NULL) {
+        return PNG_ERR_OUT_OF_MEM;
+    }
+
+    slot->state = JOB_QUEUED;
+    slot->id = next_job_id++;
+    slot->max_width = max_width;
+    slot->max_height = max_height;
+    slot->priority = priority;
+    slot->callback = callback;
+    slot->callback_data = callback_data;
+
+    if (job != NULL) {
+        *job = slot->id;
+    }
+
+    return PNG_OK;
+}
+
+/**
+ * @brief Abort a PNG decoding job.
+ * 
+ * @param job Job handle.
+ */
+void png_decoder_abort (png_job_t job) {
+    png_decoder_job_t *j = job_find(job);
+    if (j != NULL) {
+        job_release(j, true);
+    }
+}
+
+/**
+ * @brief Get the progress of a PNG decoding job.
+ * 
+ * @param job Job handle.
+ * @return float Progress as a percentage.
+ */
+float png_decoder_get_progress (png_job_t job) {
+    png_decoder_job_t *j = job_find(job);
+    if ((j == NULL) || (j->state != JOB_ACTIVE) || (j->ihdr.height == 0)) {
+        return 0.0f;
+    }
+
+    return (float) (j->decoded_rows) / (j->ihdr.height);
+}
+
+/**
+ * @brief Enable or disable ordered dithering for a PNG decoding job.
+ * 
+ * @param job Job handle.
+ * @param enabled Dithering enabled flag.
+ */
+void png_decoder_set_dither (png_job_t job, bool enabled) {
+    png_decoder_job_t *j = job_find(job);
+    if (j != NULL) {
+        j->dither = enabled;
+    }
+}
+
+/**
+ * @brief Enable or disable downscaling for a PNG decoding job.
+ * 
+ * @param job Job handle.
+ * @param enabled Downscaling enabled flag.
+ */
+void png_decoder_set_downscale (png_job_t job, bool enabled) {
+    png_decoder_job_t *j = job_find(job);
+    if ((j != NULL) && (j->state == JOB_QUEUED)) {
+        j->downscale = enabled;
+    }
+}
+
+/**
+ * @brief Change the priority of a PNG decoding job.
+ * 
+ * @param job Job handle.
+ * @param priority Decoding priority.
+ */
+void png_decoder_set_priority (png_job_t job, png_priority_t priority) {
+    png_decoder_job_t *j = job_find(job);
+    if (j != NULL) {
+        j->priority = priority;
+    }
+}
+
+/**
+ * @brief Get the number of queued and active PNG decoding jobs.
+ * 
+ * @return int Number of jobs.
+ */
+int png_decoder_get_jobs (void) {
+    int count = 0;
+
+    for (int i = 0; i < PNG_JOBS_MAX; i++) {
+        if (jobs[i].state != JOB_FREE) {
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Poll the PNG decoder to process as many rows as fit in the time budget.
+ * 
+ * The budget is shared by all queued jobs and follows the priority of the job being decoded,
+ * so leftover foreground time isn't spent on background jobs.
+ * The row time is tracked as a running average, no row is started when it would likely overrun the budget.
+ * At least one row is decoded per call.
+ */
+void png_decoder_poll (void) {
+    png_decoder_job_t *job = job_select();
+    if (job == NULL) {
+        return;
+    }
+
+    uint64_t start_us = get_ticks_us();
+
+    while (true) {
+        if (job->state == JOB_QUEUED) {
+            png_err_t err = job_activate(job);
+            if (err != PNG_OK) {
+                job_finish(job, err);
+            }
+        } else {
+            uint64_t row_start_us = get_ticks_us();
+
+            if (!job_decode_row(job)) {
+                uint32_t row_us = (uint32_t) (get_ticks_us() - row_start_us);
+                job->row_time_us = (job->row_time_us == 0) ? row_us : ((job->row_time_us * 7) + row_us) / 8;
+            }
+        }
+
+        if ((job = job_select()) == NULL) {
+            return;
+        }
+
+        uint64_t budget_us = (job->priority == PNG_PRIORITY_FOREGROUND) ? PNG_FOREGROUND_BUDGET_US : PNG_BACKGROUND_BUDGET_US;
+        if (((get_ticks_us() - start_us) + job->row_time_us) > budget_us) {
+            return;
+        }
     }
 }
@@ -7,6 +7,9 @@
 #ifndef PNG_DECODER_H__
 #define PNG_DECODER_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <surface.h>
 
 /** 
@@ -17,12 +20,23 @@
 typedef enum {
     PNG_OK,               /**< No error */
     PNG_ERR_INT,          /**< Internal error */
-    PNG_ERR_BUSY,         /**< Decoder is busy */
+    PNG_ERR_BUSY,         /**< Decoder job queue is full */
     PNG_ERR_OUT_OF_MEM,   /**< Out of memory error */
     PNG_ERR_NO_FILE,      /**< No file found error */
     PNG_ERR_BAD_FILE,     /**< Bad file error */
+    PNG_ERR_TOO_LARGE,    /**< Image can't be downscaled to the maximum size */
 } png_err_t;
 
+/**
+ * @brief PNG decoder priorities
+ * 
+ * Priority decides the time spent decoding per poll call.
+ */
+typedef enum {
+    PNG_PRIORITY_BACKGROUND, /**< Decoded in short slices, keeping the frame rate intact (default) */
+    PNG_PRIORITY_FOREGROUND, /**< Decoded in long slices, for views waiting for the image */
+} png_priority_t;
+
 /**
  * @brief PNG decoder callback type.
  * 
@@ -34,40 +48,87 @@ typedef enum {
  */
 typedef void png_callback_t (png_err_t err, surface_t *decoded_image, void *callback_data);
 
+/** @brief PNG decoder job handle. */
+typedef uint32_t png_job_t;
+
+/** @brief Job handle that never refers to a job. */
+#define PNG_JOB_NONE    (0)
+
 /**
- * @brief Start the PNG decoding process.
+ * @brief Queue a PNG decoding job.
  * 
- * This function starts the PNG decoding process for the specified file.
+ * Jobs are decoded one at a time in priority order, a foreground job preempts background jobs.
+ * The callback is called exactly once for every queued job, unless the job is aborted.
  * 
  * @param path Path to the PNG file.
  * @param max_width Maximum width of the decoded image.
  * @param max_height Maximum height of the decoded image.
+ * @param priority Decoding priority.
  * @param callback Callback function to be called when decoding is complete.
  * @param callback_data User-defined data to be passed to the callback function.
+ * @param job Pointer to store the job handle, may be NULL.
  * @return png_err_t Error code indicating the result of the start operation.
  */
-png_err_t png_decoder_start (char *path, int max_width, int max_height, png_callback_t *callback, void *callback_data);
+png_err_t png_decoder_start (char *path, int max_width, int max_height, png_priority_t priority, png_callback_t *callback, void *callback_data, png_job_t *job);
+
+/**
+ * @brief Abort a PNG decoding job.
+ * 
+ * Handles of already finished jobs are ignored.
+ * 
+ * @param job Job handle.
+ */
+void png_decoder_abort (png_job_t job);
 
 /**
- * @brief Abort the PNG decoding process.
+ * @brief Get the progress of a PNG decoding job.
  * 
- * This function aborts the ongoing PNG decoding process.
+ * @param job Job handle.
+ * @return float Current progress of the decoding process (0.0 to 1.0).
  */
-void png_decoder_abort (void);
+float png_decoder_get_progress (png_job_t job);
 
 /**
- * @brief Get the progress of the PNG decoding process.
+ * @brief Enable or disable ordered dithering for a PNG decoding job.
  * 
- * This function returns the current progress of the PNG decoding process as a percentage.
+ * Dithering reduces banding on gradients at a small cost per row, it's disabled by default.
+ * 
+ * @param job Job handle.
+ * @param enabled Dithering enabled flag.
+ */
+void png_decoder_set_dither (png_job_t job, bool enabled);
+
+/**
+ * @brief Enable or disable downscaling for a PNG decoding job.
+ * 
+ * Images larger than the maximum size are shrunk by an integer factor while decoding, instead of being rejected.
+ * Only the output image is kept in memory. Interlaced images can't be downscaled.
+ * Must be called before the job starts decoding, right after png_decoder_start.
+ * 
+ * @param job Job handle.
+ * @param enabled Downscaling enabled flag.
+ */
+void png_decoder_set_downscale (png_job_t job, bool enabled);
+
+/**
+ * @brief Change the priority of a PNG decoding job.
+ * 
+ * @param job Job handle.
+ * @param priority Decoding priority.
+ */
+void png_decoder_set_priority (png_job_t job, png_priority_t priority);
+
+/**
+ * @brief Get the number of queued and active PNG decoding jobs.
  * 
- * @return float Current progress of the decoding process (0.0 to 100.0).
+ * @return int Number of jobs.
  */
-float png_decoder_get_progress (void);
+int png_decoder_get_jobs (void);
 
 /**
  * @brief Poll the PNG decoder.
  * 
- * This function polls the PNG decoder to handle any ongoing decoding tasks.
+ * This function decodes as many rows as fit in the time budget given by the priority of the queued jobs.
  */
 void png_decoder_poll (void);
 
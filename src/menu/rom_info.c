@@ -7,13 +7,19 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <libdragon.h>
+#include <fatfs/ff.h>
 #include <mini.c/src/mini.h>
 
 #include "boot/cic.h"
+#include "file_ops.h"
 #include "rom_info.h"
 #include "utils/fs.h"
+#include "utils/hash.h"
+#include "utils/utils.h"
 
 
 #define SWAP_VARS(x0, x1)       { typeof(x0) tmp = (x0); (x0) = (x1); (x1) = (tmp); }
@@ -25,6 +31,20 @@
 
 #define CLOCK_RATE_DEFAULT      (0x0000000F)
 
+// NOTE: Bump the magic when the header decoding or the tags change, the built-in database is checked by its hash
+#define ROM_INFO_CACHE_MAGIC    (0x52494334) // "RIC4"
+#define ROM_INFO_CACHE_ENTRIES  (512)
+
+#define ROM_SETTINGS_MAGIC      (0x52535331) // "RSS1"
+#define ROM_SETTINGS_ENTRIES    (1024)
+#define ROM_SETTINGS_PROBES     (8)
+
+#define ROM_CONFIG_DIRTY_CIC_TYPE   (1 << 0)
+#define ROM_CONFIG_DIRTY_SAVE_TYPE  (1 << 1)
+#define ROM_CONFIG_DIRTY_TV_TYPE    (1 << 2)
+#define ROM_CONFIG_DIRTY_CHEATS     (1 << 3)
+#define ROM_CONFIG_DIRTY_PATCHES    (1 << 4)
+
 
 /** @brief ROM File Information Structure. */
 typedef struct  __attribute__((packed)) {
@@ -593,55 +613,228 @@ static void fix_rom_header_endianness (rom_header_t *rom_header, rom_info_t *rom
     }
 }
 
-static bool compare_id (const match_t *match, rom_header_t *rom_header) {
-    int characters_to_check = (match->type == MATCH_TYPE_ID) ? 3 : 4;
+#define DATABASE_ENTRIES    ((sizeof(database) / sizeof(database[0])) - 1)
 
-    for (int i = (characters_to_check - 1); i >= 0; i--) {
-        if (match->fields.id[i] != rom_header->game_code[i]) {
-            return false;
+#define EXTERNAL_DATABASE_MAGIC     (0x4E444231) // "NDB1"
+
+/** @brief ROM Database Index Entry Structure, also used as the external database index layout. */
+typedef struct {
+    match_type_t type; /**< Match type, the index is split into sections by it */
+    uint32_t entry; /**< Position of the entry in the source list, lower positions take precedence */
+    uint64_t key; /**< Match key within the section */
+} database_index_t;
+
+_Static_assert(sizeof(database_index_t) == 16, "Unexpected database index entry size");
+
+/** @brief External ROM Database Header Structure. */
+typedef struct {
+    uint32_t magic; /**< File magic */
+    uint32_t count; /**< Number of index entries and records */
+    uint32_t content_id; /**< CRC32 of the index and records, cached ROM information is tied to it */
+    uint32_t __reserved;
+} external_database_header_t;
+
+/** @brief External ROM Database Record Structure. */
+typedef struct {
+    uint32_t save; /**< Save type */
+    uint32_t feat; /**< Supported features */
+} external_database_record_t;
+
+static database_index_t database_index[DATABASE_ENTRIES];
+static bool database_index_ready = false;
+static uint32_t database_hash = 0;
+
+static char *external_database_path = NULL;
+static database_index_t *external_database_index = NULL;
+static uint32_t external_database_entries = 0;
+static uint32_t external_database_id = 0;
+
+static uint64_t make_id_key (const char *id, int length, uint8_t version) {
+    uint64_t key = 0;
+
+    for (int i = 0; i < length; i++) {
+        key = (key << 8) | (uint8_t) (id[i]);
+    }
+
+    return ((key << 8) | version);
+}
+
+static uint64_t get_match_key (const match_t *match) {
+    switch (match->type) {
+        case MATCH_TYPE_ID: return make_id_key(match->fields.id, 3, 0);
+        case MATCH_TYPE_ID_REGION: return make_id_key(match->fields.id, 4, 0);
+        case MATCH_TYPE_ID_REGION_VERSION: return make_id_key(match->fields.id, 4, match->fields.version);
+        case MATCH_TYPE_CHECK_CODE: return match->fields.check_code;
+        case MATCH_TYPE_HOMEBREW_HEADER: return make_id_key(match->fields.id, 2, 0);
+        default: return 0;
+    }
+}
+
+static int database_index_compare (const void *a, const void *b) {
+    const database_index_t *left = (const database_index_t *) (a);
+    const database_index_t *right = (const database_index_t *) (b);
+
+    if (left->type != right->type) {
+        return (left->type < right->type) ? -1 : 1;
+    }
+    if (left->key != right->key) {
+        return (left->key < right->key) ? -1 : 1;
+    }
+    return (left->entry < right->entry) ? -1 : ((left->entry > right->entry) ? 1 : 0);
+}
+
+static void database_index_build (void) {
+    uint32_t hash = FNV1A32_INIT;
+
+    for (int i = 0; i < DATABASE_ENTRIES; i++) {
+        database_index[i].type = database[i].type;
+        database_index[i].key = get_match_key(&database[i]);
+        database_index[i].entry = i;
+        uint32_t data[] = { database[i].type, (uint32_t) (database_index[i].key), (uint32_t) (database_index[i].key >> 32), database[i].data.save, database[i].data.feat };
+        hash = fnv1a32(hash, data, sizeof(data));
+    }
+
+    // NOTE: Any change to the built-in database invalidates the cached ROM information matched with it
+    database_hash = hash;
+
+    // NOTE: Entries with equal keys stay ordered by their database position, so the first one found is the first one listed
+    qsort(database_index, DATABASE_ENTRIES, sizeof(database_index_t), database_index_compare);
+
+    database_index_ready = true;
+}
+
+static int database_index_find (database_index_t *index, int count, match_type_t type, uint64_t key) {
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int middle = low + ((high - low) / 2);
+        if ((index[middle].type < type) || ((index[middle].type == type) && (index[middle].key < key))) {
+            low = middle + 1;
+        } else {
+            high = middle;
         }
     }
 
-    if (match->type == MATCH_TYPE_ID_REGION_VERSION) {
-        if (match->fields.version != rom_header->version) {
-            return false;
+    if ((low < count) && (index[low].type == type) && (index[low].key == key)) {
+        return low;
+    }
+
+    return -1;
+}
+
+static int database_index_find_first (database_index_t *index, int count, rom_header_t *rom_header) {
+    int sections[] = {
+        database_index_find(index, count, MATCH_TYPE_ID, make_id_key(rom_header->game_code, 3, 0)),
+        database_index_find(index, count, MATCH_TYPE_ID_REGION, make_id_key(rom_header->game_code, 4, 0)),
+        database_index_find(index, count, MATCH_TYPE_ID_REGION_VERSION, make_id_key(rom_header->game_code, 4, rom_header->version)),
+        database_index_find(index, count, MATCH_TYPE_CHECK_CODE, rom_header->check_code),
+        database_index_find(index, count, MATCH_TYPE_HOMEBREW_HEADER, make_id_key(rom_header->unique_code, 2, 0)),
+    };
+
+    // NOTE: The earliest source entry matched in any section wins, same as scanning the whole list in order
+    int found = -1;
+    for (int i = 0; i < sizeof(sections) / sizeof(sections[0]); i++) {
+        if ((sections[i] >= 0) && ((found < 0) || (index[sections[i]].entry < index[found].entry))) {
+            found = sections[i];
         }
     }
 
-    return true;
+    return found;
+}
+
+static bool external_database_find (rom_header_t *rom_header, match_t *match) {
+    FILE *f;
+    external_database_record_t record;
+
+    if (external_database_index == NULL) {
+        return true;
+    }
+
+    int position = database_index_find_first(external_database_index, external_database_entries, rom_header);
+
+    if (position < 0) {
+        return true;
+    }
+
+    if ((f = fopen(external_database_path, "rb")) == NULL) {
+        return true;
+    }
+    setbuf(f, NULL);
+
+    long offset = sizeof(external_database_header_t) + (external_database_entries * sizeof(database_index_t)) + (position * sizeof(external_database_record_t));
+
+    bool error = (fseek(f, offset, SEEK_SET) != 0) || (fread(&record, sizeof(record), 1, f) != 1);
+
+    fclose(f);
+
+    if (error) {
+        return true;
+    }
+
+    *match = (match_t) {
+        .type = external_database_index[position].type,
+        .data = { .save = (rom_save_type_t) (record.save), .feat = (feat_t) (record.feat) },
+    };
+
+    return false;
+}
+
+void rom_info_database_init (char *database_location) {
+    FILE *f;
+    external_database_header_t header;
+
+    free(external_database_path);
+    external_database_path = NULL;
+    free(external_database_index);
+    external_database_index = NULL;
+    external_database_entries = 0;
+    external_database_id = 0;
+
+    if ((f = fopen(database_location, "rb")) == NULL) {
+        return;
+    }
+    setbuf(f, NULL);
+
+    if ((fread(&header, sizeof(header), 1, f) != 1) || (header.magic != EXTERNAL_DATABASE_MAGIC) || (header.count == 0)) {
+        fclose(f);
+        return;
+    }
+
+    external_database_index = malloc(header.count * sizeof(database_index_t));
+
+    if (!external_database_index || (fread(external_database_index, sizeof(database_index_t), header.count, f) != header.count)) {
+        free(external_database_index);
+        external_database_index = NULL;
+        fclose(f);
+        return;
+    }
+
+    fclose(f);
+
+    external_database_path = strdup(database_location);
+    external_database_entries = header.count;
+
+    external_database_id = header.content_id;
+
+    debugf("ROM info: loaded %lu external database entries from %s\n", external_database_entries, database_location);
 }
 
 static match_t find_rom_in_database (rom_header_t *rom_header) {
-    const match_t *match;
-
-    for (match = database; match->type != MATCH_TYPE_END; match++) {
-        switch (match->type) {
-            case MATCH_TYPE_ID:
-            case MATCH_TYPE_ID_REGION:
-            case MATCH_TYPE_ID_REGION_VERSION:
-                if (compare_id(match, rom_header)) {
-                    return *match;
-                }
-                break;
-
-            case MATCH_TYPE_CHECK_CODE:
-                if (match->fields.check_code == rom_header->check_code) {
-                    return *match;
-                }
-                break;
-
-            case MATCH_TYPE_HOMEBREW_HEADER:
-                if (strncmp(match->fields.id, rom_header->unique_code, sizeof(rom_header->unique_code)) == 0) {
-                    return *match;
-                }
-                break;
+    match_t match;
 
-            default:
-                break;
-        }
+    // NOTE: Entries from the external database take precedence over the built-in ones
+    if (!external_database_find(rom_header, &match)) {
+        return match;
     }
 
-    return *match;
+    if (!database_index_ready) {
+        database_index_build();
+    }
+
+    int position = database_index_find_first(database_index, DATABASE_ENTRIES, rom_header);
+
+    return database[(position < 0) ? DATABASE_ENTRIES : database_index[position].entry];
 }
 
 static rom_cic_type_t detect_cic_type (uint8_t *ipl3) {
@@ -760,7 +953,159 @@ static void extract_rom_info (match_t *match, rom_header_t *rom_header, rom_info
     rom_info->settings.patches_enabled = false;
 }
 
+/** @brief ROM Settings Store Record Structure. */
+typedef struct {
+    uint64_t path_hash; /**< FNV-1a hash of the ROM path */
+    uint32_t magic; /**< Record magic, zero for empty records */
+    int32_t cic_type; /**< CIC type override */
+    int32_t save_type; /**< Save type override */
+    int32_t tv_type; /**< TV type override */
+    int32_t esrb_age_rating; /**< Game age rating */
+    uint8_t cheats_enabled; /**< Cheats enabled */
+    uint8_t patches_enabled; /**< Patches enabled */
+    uint8_t extent_fill; /**< Value of the trailing filler bytes */
+    uint8_t __reserved;
+    uint32_t extent_file_size; /**< ROM file size at the time of the extent detection */
+    uint32_t extent_timestamp; /**< ROM file timestamp at the time of the extent detection */
+    uint32_t extent_data_size; /**< Size of the meaningful data, 0 if unknown */
+} rom_settings_record_t;
+
+static char *rom_settings_path = NULL;
+
+static long rom_settings_window_offset (uint64_t path_hash) {
+    return hash_slot_offset(path_hash, (ROM_SETTINGS_ENTRIES - ROM_SETTINGS_PROBES + 1), sizeof(rom_settings_record_t));
+}
+
+static bool rom_settings_read_window (uint64_t path_hash, rom_settings_record_t *window) {
+    FILE *f;
+
+    if ((f = fopen(rom_settings_path, "rb")) == NULL) {
+        return true;
+    }
+    setbuf(f, NULL);
+
+    bool error = (fseek(f, rom_settings_window_offset(path_hash), SEEK_SET) != 0) || (fread(window, sizeof(rom_settings_record_t), ROM_SETTINGS_PROBES, f) != ROM_SETTINGS_PROBES);
+
+    fclose(f);
+
+    return error;
+}
+
+static bool rom_settings_find (path_t *path, rom_settings_record_t *record) {
+    rom_settings_record_t window[ROM_SETTINGS_PROBES];
+    uint64_t path_hash = fnv1a64_string(path_get(path));
+
+    if (rom_settings_read_window(path_hash, window)) {
+        return true;
+    }
+
+    for (int i = 0; i < ROM_SETTINGS_PROBES; i++) {
+        if ((window[i].magic == ROM_SETTINGS_MAGIC) && (window[i].path_hash == path_hash)) {
+            *record = window[i];
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool rom_settings_store (path_t *path, rom_info_t *rom_info) {
+    rom_settings_record_t window[ROM_SETTINGS_PROBES];
+    uint64_t path_hash = fnv1a64_string(path_get(path));
+    int slot = -1;
+    FILE *f;
+
+    if (rom_settings_read_window(path_hash, window)) {
+        return true;
+    }
+
+    for (int i = 0; i < ROM_SETTINGS_PROBES; i++) {
+        if ((window[i].magic == ROM_SETTINGS_MAGIC) && (window[i].path_hash == path_hash)) {
+            slot = i;
+            break;
+        }
+        if ((slot < 0) && (window[i].magic != ROM_SETTINGS_MAGIC)) {
+            slot = i;
+        }
+    }
+
+    if (slot < 0) {
+        return true;
+    }
+
+    rom_settings_record_t record = {
+        .path_hash = path_hash,
+        .magic = ROM_SETTINGS_MAGIC,
+        .cic_type = rom_info->boot_override.cic ? rom_info->boot_override.cic_type : ROM_CIC_TYPE_AUTOMATIC,
+        .save_type = rom_info->boot_override.save ? rom_info->boot_override.save_type : SAVE_TYPE_AUTOMATIC,
+        .tv_type = rom_info->boot_override.tv ? rom_info->boot_override.tv_type : ROM_TV_TYPE_AUTOMATIC,
+        .esrb_age_rating = rom_info->metadata.esrb_age_rating,
+        .cheats_enabled = rom_info->settings.cheats_enabled,
+        .patches_enabled = rom_info->settings.patches_enabled,
+        .extent_fill = rom_info->extent.fill,
+        .extent_file_size = rom_info->extent.file_size,
+        .extent_timestamp = rom_info->extent.timestamp,
+        .extent_data_size = rom_info->extent.data_size,
+    };
+
+    if ((f = fopen(rom_settings_path, "r+b")) == NULL) {
+        return true;
+    }
+    setbuf(f, NULL);
+
+    bool error = (fseek(f, rom_settings_window_offset(path_hash) + (slot * sizeof(rom_settings_record_t)), SEEK_SET) != 0) || (fwrite(&record, sizeof(record), 1, f) != 1);
+
+    if (fclose(f)) {
+        error = true;
+    }
+
+    return error;
+}
+
+static void apply_rom_settings_record (rom_settings_record_t *record, rom_info_t *rom_info) {
+    rom_info->settings.cheats_enabled = record->cheats_enabled;
+    rom_info->settings.patches_enabled = record->patches_enabled;
+
+    rom_info->metadata.esrb_age_rating = record->esrb_age_rating;
+
+    rom_info->boot_override.cic_type = record->cic_type;
+    rom_info->boot_override.cic = (record->cic_type != ROM_CIC_TYPE_AUTOMATIC);
+    rom_info->boot_override.save_type = record->save_type;
+    rom_info->boot_override.save = (record->save_type != SAVE_TYPE_AUTOMATIC);
+    rom_info->boot_override.tv_type = record->tv_type;
+    rom_info->boot_override.tv = (record->tv_type != ROM_TV_TYPE_AUTOMATIC);
+
+    rom_info->extent.file_size = record->extent_file_size;
+    rom_info->extent.timestamp = record->extent_timestamp;
+    rom_info->extent.data_size = record->extent_data_size;
+    rom_info->extent.fill = record->extent_fill;
+}
+
+void rom_settings_store_init (char *store_location) {
+    free(rom_settings_path);
+    rom_settings_path = NULL;
+
+    size_t store_size = (ROM_SETTINGS_ENTRIES * sizeof(rom_settings_record_t));
+
+    if (file_get_size(store_location) != (int64_t) (store_size)) {
+        if (file_allocate_filled(store_location, store_size, 0x00)) {
+            return;
+        }
+    }
+
+    rom_settings_path = strdup(store_location);
+}
+
 static void load_rom_config_from_file (path_t *path, rom_info_t *rom_info) {
+    rom_settings_record_t record;
+
+    rom_info->settings_dirty = 0;
+
+    if (rom_settings_path && !rom_settings_find(path, &record)) {
+        apply_rom_settings_record(&record, rom_info);
+        return;
+    }
+
     path_t *rom_info_path = path_clone(path);
 
     path_ext_replace(rom_info_path, "ini");
@@ -771,6 +1116,11 @@ static void load_rom_config_from_file (path_t *path, rom_info_t *rom_info) {
     rom_info->boot_override.save = false;
     rom_info->boot_override.tv = false;
 
+    rom_info->extent.file_size = 0;
+    rom_info->extent.timestamp = 0;
+    rom_info->extent.data_size = 0;
+    rom_info->extent.fill = 0xFF;
+
     if (rom_config_ini) {
         // general
         rom_info->settings.cheats_enabled = mini_get_bool(rom_config_ini, NULL, "cheats_enabled", false);
@@ -795,13 +1145,36 @@ static void load_rom_config_from_file (path_t *path, rom_info_t *rom_info) {
             rom_info->boot_override.tv = true;
         }
 
+        // extent
+        rom_info->extent.file_size = (uint32_t) mini_get_int(rom_config_ini, "extent", "file_size", 0);
+        rom_info->extent.timestamp = (uint32_t) mini_get_int(rom_config_ini, "extent", "timestamp", 0);
+        rom_info->extent.data_size = (uint32_t) mini_get_int(rom_config_ini, "extent", "data_size", 0);
+        rom_info->extent.fill = (uint8_t) mini_get_int(rom_config_ini, "extent", "fill", 0xFF);
+
         mini_free(rom_config_ini);
     }
 
     path_free(rom_info_path);
+
+    // NOTE: Settings from the ini file are imported into the store on the first access
+    if (rom_settings_path) {
+        rom_settings_store(path, rom_info);
+    }
+}
+
+static bool set_rom_config_value (mini_t *rom_config_ini, const char *type, const char *id, int value, int default_value) {
+    int mini_err;
+
+    if (value == default_value) {
+        mini_err = mini_delete_value(rom_config_ini, type, id);
+    } else {
+        mini_err = mini_set_int(rom_config_ini, type, id, value);
+    }
+
+    return ((mini_err != MINI_OK) && (mini_err != MINI_VALUE_NOT_FOUND));
 }
 
-static rom_err_t save_rom_config_setting_to_file (path_t *path, const char *type, const char *id, int value, int default_value) {
+static rom_err_t save_rom_config_to_file (path_t *path, rom_info_t *rom_info) {
     path_t *rom_info_path = path_clone(path);
 
     path_ext_replace(rom_info_path, "ini");
@@ -813,15 +1186,26 @@ static rom_err_t save_rom_config_setting_to_file (path_t *path, const char *type
         return ROM_ERR_SAVE_IO;
     }
 
-    int mini_err;
+    uint32_t dirty = rom_info->settings_dirty;
+    bool error = false;
 
-    if (value == default_value) {
-        mini_err = mini_delete_value(rom_config_ini, type, id);
-    } else {
-        mini_err = mini_set_int(rom_config_ini, type, id, value);
+    if (dirty & ROM_CONFIG_DIRTY_CIC_TYPE) {
+        error |= set_rom_config_value(rom_config_ini, "custom_boot", "cic_type", rom_info->boot_override.cic_type, ROM_CIC_TYPE_AUTOMATIC);
+    }
+    if (dirty & ROM_CONFIG_DIRTY_SAVE_TYPE) {
+        error |= set_rom_config_value(rom_config_ini, "custom_boot", "save_type", rom_info->boot_override.save_type, SAVE_TYPE_AUTOMATIC);
+    }
+    if (dirty & ROM_CONFIG_DIRTY_TV_TYPE) {
+        error |= set_rom_config_value(rom_config_ini, "custom_boot", "tv_type", rom_info->boot_override.tv_type, ROM_TV_TYPE_AUTOMATIC);
+    }
+    if (dirty & ROM_CONFIG_DIRTY_CHEATS) {
+        error |= set_rom_config_value(rom_config_ini, NULL, "cheats_enabled", rom_info->settings.cheats_enabled, false);
+    }
+    if (dirty & ROM_CONFIG_DIRTY_PATCHES) {
+        error |= set_rom_config_value(rom_config_ini, NULL, "patches_enabled", rom_info->settings.patches_enabled, false);
     }
 
-    if ((mini_err != MINI_OK) && (mini_err != MINI_VALUE_NOT_FOUND)) {
+    if (error) {
         path_free(rom_info_path);
         mini_free(rom_config_ini);
         return ROM_ERR_SAVE_IO;
@@ -830,17 +1214,23 @@ static rom_err_t save_rom_config_setting_to_file (path_t *path, const char *type
     bool empty = mini_empty(rom_config_ini);
 
     if (!empty) {
+        bool created = !file_exists(path_get(rom_info_path));
         if (mini_save(rom_config_ini, MINI_FLAGS_NONE) != MINI_OK) {
             path_free(rom_info_path);
             mini_free(rom_config_ini);
             return ROM_ERR_SAVE_IO;
         }
+        if (created) {
+            file_ops_notify_written(rom_info_path);
+        }
     }
 
     mini_free(rom_config_ini);
 
     if (empty) {
-        if (remove(path_get(rom_info_path)) && (errno != ENOENT)) {
+        if (remove(path_get(rom_info_path)) == 0) {
+            file_ops_notify_removed(rom_info_path);
+        } else if (errno != ENOENT) {
             path_free(rom_info_path);
             return ROM_ERR_SAVE_IO;
         }
@@ -851,6 +1241,23 @@ static rom_err_t save_rom_config_setting_to_file (path_t *path, const char *type
     return ROM_OK;
 }
 
+rom_err_t rom_config_flush (path_t *path, rom_info_t *rom_info) {
+    rom_err_t err = ROM_OK;
+
+    if (rom_info->settings_dirty == 0) {
+        return ROM_OK;
+    }
+
+    if (!rom_settings_path || rom_settings_store(path, rom_info)) {
+        err = save_rom_config_to_file(path, rom_info);
+    }
+
+    if (err == ROM_OK) {
+        rom_info->settings_dirty = 0;
+    }
+
+    return err;
+}
 
 rom_cic_type_t rom_info_get_cic_type (rom_info_t *rom_info) {
     if (rom_info->boot_override.cic) {
@@ -889,7 +1296,9 @@ rom_err_t rom_config_override_cic_type (path_t *path, rom_info_t *rom_info, rom_
     rom_info->boot_override.cic = (cic_type != ROM_CIC_TYPE_AUTOMATIC);
     rom_info->boot_override.cic_type = cic_type;
 
-    return save_rom_config_setting_to_file(path, "custom_boot", "cic_type", rom_info->boot_override.cic_type, ROM_CIC_TYPE_AUTOMATIC);
+    rom_info->settings_dirty |= ROM_CONFIG_DIRTY_CIC_TYPE;
+
+    return ROM_OK;
 }
 
 rom_save_type_t rom_info_get_save_type (rom_info_t *rom_info) {
@@ -904,7 +1313,9 @@ rom_err_t rom_config_override_save_type (path_t *path, rom_info_t *rom_info, rom
     rom_info->boot_override.save = (save_type != SAVE_TYPE_AUTOMATIC);
     rom_info->boot_override.save_type = save_type;
 
-    return save_rom_config_setting_to_file(path, "custom_boot", "save_type", rom_info->boot_override.save_type, SAVE_TYPE_AUTOMATIC);
+    rom_info->settings_dirty |= ROM_CONFIG_DIRTY_SAVE_TYPE;
+
+    return ROM_OK;
 }
 
 rom_tv_type_t rom_info_get_tv_type (rom_info_t *rom_info) {
@@ -919,42 +1330,345 @@ rom_err_t rom_config_override_tv_type (path_t *path, rom_info_t *rom_info, rom_t
     rom_info->boot_override.tv = (tv_type != ROM_TV_TYPE_AUTOMATIC);
     rom_info->boot_override.tv_type = tv_type;
 
-    return save_rom_config_setting_to_file(path, "custom_boot", "tv_type", rom_info->boot_override.tv_type, ROM_TV_TYPE_AUTOMATIC);
+    rom_info->settings_dirty |= ROM_CONFIG_DIRTY_TV_TYPE;
+
+    return ROM_OK;
 }
 
 rom_err_t rom_config_setting_set_cheats (path_t *path, rom_info_t *rom_info, bool enabled) {
     rom_info->settings.cheats_enabled = enabled;
-    return save_rom_config_setting_to_file(path, NULL, "cheats_enabled", enabled, false);
+    rom_info->settings_dirty |= ROM_CONFIG_DIRTY_CHEATS;
+
+    return ROM_OK;
+}
+
+rom_err_t rom_config_setting_set_extent (path_t *path, rom_info_t *rom_info, uint32_t file_size, uint32_t timestamp, uint32_t data_size, uint8_t fill) {
+    if (rom_settings_path) {
+        rom_info->extent.file_size = file_size;
+        rom_info->extent.timestamp = timestamp;
+        rom_info->extent.data_size = data_size;
+        rom_info->extent.fill = fill;
+        if (!rom_settings_store(path, rom_info)) {
+            return ROM_OK;
+        }
+    }
+
+    path_t *rom_info_path = path_clone(path);
+
+    path_ext_replace(rom_info_path, "ini");
+
+    mini_t *rom_config_ini = mini_try_load(path_get(rom_info_path));
+
+    if (!rom_config_ini) {
+        path_free(rom_info_path);
+        return ROM_ERR_SAVE_IO;
+    }
+
+    rom_info->extent.file_size = file_size;
+    rom_info->extent.timestamp = timestamp;
+    rom_info->extent.data_size = data_size;
+    rom_info->extent.fill = fill;
+
+    mini_set_int(rom_config_ini, "extent", "file_size", (int) (file_size));
+    mini_set_int(rom_config_ini, "extent", "timestamp", (int) (timestamp));
+    mini_set_int(rom_config_ini, "extent", "data_size", (int) (data_size));
+    mini_set_int(rom_config_ini, "extent", "fill", fill);
+
+    bool created = !file_exists(path_get(rom_info_path));
+
+    if (mini_save(rom_config_ini, MINI_FLAGS_NONE) != MINI_OK) {
+        path_free(rom_info_path);
+        mini_free(rom_config_ini);
+        return ROM_ERR_SAVE_IO;
+    }
+
+    if (created) {
+        file_ops_notify_written(rom_info_path);
+    }
+
+    path_free(rom_info_path);
+    mini_free(rom_config_ini);
+
+    return ROM_OK;
 }
 
 #ifdef FEATURE_PATCHER_GUI_ENABLED
 rom_err_t rom_config_setting_set_patches (path_t *path, rom_info_t *rom_info, bool enabled) {
     rom_info->settings.patches_enabled = enabled;
-    return save_rom_config_setting_to_file(path, NULL, "patches_enabled", enabled, false);
+    rom_info->settings_dirty |= ROM_CONFIG_DIRTY_PATCHES;
+
+    return ROM_OK;
 }
 #endif
 
-rom_err_t rom_config_load (path_t *path, rom_info_t *rom_info) {
+/** @brief ROM Information Cache Entry Structure. */
+typedef struct {
+    uint32_t magic; /**< Entry magic, zero for empty entries */
+    uint32_t file_size; /**< ROM file size */
+    uint32_t timestamp; /**< ROM file FAT timestamp */
+    uint32_t database_id; /**< Identifier of the external database used for the match */
+    uint32_t builtin_database_hash; /**< Hash of the built-in database used for the match */
+    uint64_t path_hash; /**< FNV-1a hash of the ROM path */
+    uint64_t check_code; /**< Checksum computed from the ROM data during a verified load */
+    uint32_t check_code_valid; /**< Checksum was computed for this ROM file */
+    rom_info_t rom_info; /**< ROM information extracted from the header */
+} rom_info_cache_entry_t;
+
+static char *rom_info_cache_path = NULL;
+
+static bool rom_info_cache_describe (path_t *path, rom_info_cache_entry_t *entry) {
+    FILINFO info;
+
+    if (rom_info_cache_path == NULL) {
+        return true;
+    }
+
+    if (f_stat(strip_fs_prefix(path_get(path)), &info) != FR_OK) {
+        return true;
+    }
+
+    if (!database_index_ready) {
+        database_index_build();
+    }
+
+    memset(entry, 0, sizeof(rom_info_cache_entry_t));
+    entry->magic = ROM_INFO_CACHE_MAGIC;
+    entry->file_size = info.fsize;
+    entry->timestamp = ((info.fdate << 16) | info.ftime);
+    entry->path_hash = fnv1a64_string(path_get(path));
+    entry->database_id = external_database_id;
+    entry->builtin_database_hash = database_hash;
+
+    return false;
+}
+
+static long rom_info_cache_offset (rom_info_cache_entry_t *entry) {
+    return hash_slot_offset(entry->path_hash, ROM_INFO_CACHE_ENTRIES, sizeof(rom_info_cache_entry_t));
+}
+
+static bool rom_info_cache_find (rom_info_cache_entry_t *entry) {
+    FILE *f;
+    rom_info_cache_entry_t cached;
+
+    if ((f = fopen(rom_info_cache_path, "rb")) == NULL) {
+        return true;
+    }
+    setbuf(f, NULL);
+
+    bool error = (fseek(f, rom_info_cache_offset(entry), SEEK_SET) != 0) || (fread(&cached, sizeof(cached), 1, f) != 1);
+
+    fclose(f);
+
+    if (error || (cached.magic != entry->magic) || (cached.path_hash != entry->path_hash) || (cached.file_size != entry->file_size) || (cached.timestamp != entry->timestamp) || (cached.database_id != entry->database_id) || (cached.builtin_database_hash != entry->builtin_database_hash)) {
+        return true;
+    }
+
+    entry->check_code = cached.check_code;
+    entry->check_code_valid = cached.check_code_valid;
+    entry->rom_info = cached.rom_info;
+
+    return false;
+}
+
+static void rom_info_cache_store (rom_info_cache_entry_t *entry) {
     FILE *f;
+
+    if ((f = fopen(rom_info_cache_path, "r+b")) == NULL) {
+        return;
+    }
+    setbuf(f, NULL);
+
+    if (fseek(f, rom_info_cache_offset(entry), SEEK_SET) == 0) {
+        fwrite(entry, sizeof(rom_info_cache_entry_t), 1, f);
+    }
+
+    fclose(f);
+}
+
+void rom_info_cache_init (char *cache_location) {
+    free(rom_info_cache_path);
+    rom_info_cache_path = NULL;
+
+    size_t cache_size = (ROM_INFO_CACHE_ENTRIES * sizeof(rom_info_cache_entry_t));
+
+    if (file_get_size(cache_location) != (int64_t) (cache_size)) {
+        if (file_allocate_filled(cache_location, cache_size, 0x00)) {
+            return;
+        }
+    }
+
+    rom_info_cache_path = strdup(cache_location);
+}
+
+static void parse_rom_header (rom_header_t *rom_header, rom_info_t *rom_info) {
+    fix_rom_header_endianness(rom_header, rom_info);
+
+    match_t match = find_rom_in_database(rom_header);
+
+    extract_rom_info(&match, rom_header, rom_info);
+}
+
+static rom_err_t load_rom_header_info (path_t *path, rom_info_t *rom_info) {
     rom_header_t rom_header;
 
-    if ((f = fopen(path_get(path), "rb")) == NULL) {
+    if (file_read_range(path_get(path), 0, &rom_header, sizeof(rom_header))) {
+        return file_exists(path_get(path)) ? ROM_ERR_LOAD_IO : ROM_ERR_NO_FILE;
+    }
+
+    parse_rom_header(&rom_header, rom_info);
+
+    return ROM_OK;
+}
+
+rom_err_t rom_info_cache_update (path_t *path) {
+    rom_info_cache_entry_t cache_entry;
+    rom_err_t err;
+
+    if (rom_info_cache_describe(path, &cache_entry)) {
         return ROM_ERR_NO_FILE;
     }
-    setbuf(f, NULL);
-    if (fread(&rom_header, sizeof(rom_header), 1, f) != 1) {
-        fclose(f);
-        return ROM_ERR_LOAD_IO;
+
+    if (!rom_info_cache_find(&cache_entry)) {
+        return ROM_OK;
     }
-    if (fclose(f)) {
-        return ROM_ERR_LOAD_IO;
+
+    if ((err = load_rom_header_info(path, &cache_entry.rom_info)) != ROM_OK) {
+        return err;
+    }
+
+    rom_info_cache_store(&cache_entry);
+
+    return ROM_OK;
+}
+
+rom_err_t rom_info_cache_load (path_t *path, rom_info_t *rom_info) {
+    rom_info_cache_entry_t cache_entry;
+    rom_err_t err;
+
+    bool cacheable = !rom_info_cache_describe(path, &cache_entry);
+
+    if (cacheable && !rom_info_cache_find(&cache_entry)) {
+        *rom_info = cache_entry.rom_info;
+        return ROM_OK;
+    }
+
+    if ((err = load_rom_header_info(path, rom_info)) != ROM_OK) {
+        return err;
+    }
+
+    if (cacheable) {
+        cache_entry.rom_info = *rom_info;
+        rom_info_cache_store(&cache_entry);
+    }
+
+    return ROM_OK;
+}
+
+bool rom_info_cache_get_check_code (path_t *path, uint64_t *check_code) {
+    rom_info_cache_entry_t cache_entry;
+
+    if (rom_info_cache_describe(path, &cache_entry) || rom_info_cache_find(&cache_entry) || !cache_entry.check_code_valid) {
+        return true;
+    }
+
+    *check_code = cache_entry.check_code;
+
+    return false;
+}
+
+void rom_info_cache_set_check_code (path_t *path, uint64_t check_code) {
+    rom_info_cache_entry_t cache_entry;
+
+    if (rom_info_cache_describe(path, &cache_entry) || rom_info_cache_find(&cache_entry)) {
+        return;
+    }
+
+    if (cache_entry.check_code_valid && (cache_entry.check_code == check_code)) {
+        return;
+    }
+
+    cache_entry.check_code = check_code;
+    cache_entry.check_code_valid = true;
+
+    rom_info_cache_store(&cache_entry);
+}
+
+uint8_t rom_info_get_tags (rom_info_t *rom_info) {
+    uint8_t tags = ROM_TAG_SCANNED;
+
+    switch (rom_info->save_type) {
+        case SAVE_TYPE_EEPROM_4KBIT:
+        case SAVE_TYPE_EEPROM_16KBIT:
+            tags |= ROM_TAG_SAVE_EEPROM;
+            break;
+        case SAVE_TYPE_SRAM_256KBIT:
+        case SAVE_TYPE_SRAM_BANKED:
+        case SAVE_TYPE_SRAM_1MBIT:
+            tags |= ROM_TAG_SAVE_SRAM;
+            break;
+        case SAVE_TYPE_FLASHRAM_1MBIT:
+        case SAVE_TYPE_FLASHRAM_PKST2:
+            tags |= ROM_TAG_SAVE_FLASHRAM;
+            break;
+        default:
+            break;
+    }
+
+    if ((rom_info->destination_code == MARKET_JAPANESE) || (rom_info->destination_code == MARKET_JAPANESE_MULTI)) {
+        tags |= ROM_TAG_REGION_JAPAN;
+    } else if (rom_info->tv_type == ROM_TV_TYPE_PAL) {
+        tags |= ROM_TAG_REGION_PAL;
+    } else if ((rom_info->tv_type == ROM_TV_TYPE_NTSC) || (rom_info->tv_type == ROM_TV_TYPE_MPAL)) {
+        tags |= ROM_TAG_REGION_NTSC;
+    }
+
+    if ((rom_info->features.expansion_pak != EXPANSION_PAK_NONE) && (rom_info->features.expansion_pak != EXPANSION_PAK_FAULTY)) {
+        tags |= ROM_TAG_EXPANSION_PAK;
+    }
+
+    if (rom_info->features.rumble_pak) {
+        tags |= ROM_TAG_RUMBLE_PAK;
     }
 
-    fix_rom_header_endianness(&rom_header, rom_info);
+    return tags;
+}
+
+rom_err_t rom_config_load (path_t *path, rom_info_t *rom_info) {
+    rom_info_cache_entry_t cache_entry;
+    rom_err_t err;
+
+    bool cacheable = !rom_info_cache_describe(path, &cache_entry);
+
+    if (cacheable && !rom_info_cache_find(&cache_entry)) {
+        *rom_info = cache_entry.rom_info;
+        load_rom_config_from_file(path, rom_info);
+        return ROM_OK;
+    }
+
+    if ((err = load_rom_header_info(path, rom_info)) != ROM_OK) {
+        return err;
+    }
+
+    if (cacheable) {
+        cache_entry.rom_info = *rom_info;
+        rom_info_cache_store(&cache_entry);
+    }
+
+    load_rom_config_from_file(path, rom_info);
+
+    return ROM_OK;
+}
+
+rom_err_t rom_config_load_from_header (path_t *path, const void *header, size_t length, rom_info_t *rom_info) {
+    rom_header_t rom_header;
+
+    if (length < sizeof(rom_header)) {
+        return ROM_ERR_LOAD_IO;
+    }
 
-    match_t match = find_rom_in_database(&rom_header);
+    memcpy(&rom_header, header, sizeof(rom_header));
 
-    extract_rom_info(&match, &rom_header, rom_info);
+    parse_rom_header(&rom_header, rom_info);
 
     load_rom_config_from_file(path, rom_info);
 
@@ -178,8 +178,32 @@ typedef struct {
     struct {
         rom_esrb_age_rating_t esrb_age_rating; /**< The game age rating */
     } metadata;                     /**< The ROM metadata */
+
+    struct {
+        uint32_t file_size;         /**< ROM file size at the time of detection */
+        uint32_t timestamp;         /**< ROM file timestamp at the time of detection */
+        uint32_t data_size;         /**< Size of the meaningful data, 0 if unknown */
+        uint8_t fill;               /**< Value of the trailing filler bytes */
+    } extent;                       /**< The ROM data extent, used to skip loading the trailing padding */
+
+    uint32_t settings_dirty;        /**< Settings changed since the last flush */
 } rom_info_t;
 
+/** @brief ROM tags enumeration, packed into a single byte per file list entry. */
+typedef enum {
+    ROM_TAG_SCANNED = (1 << 0),             /**< The tags were read from the ROM header information */
+    ROM_TAG_SAVE_EEPROM = (1 << 1),         /**< Saves to EEPROM */
+    ROM_TAG_SAVE_SRAM = (2 << 1),           /**< Saves to SRAM */
+    ROM_TAG_SAVE_FLASHRAM = (3 << 1),       /**< Saves to FlashRAM */
+    ROM_TAG_SAVE_MASK = (3 << 1),           /**< Save type bits */
+    ROM_TAG_REGION_NTSC = (1 << 3),         /**< NTSC region */
+    ROM_TAG_REGION_PAL = (2 << 3),          /**< PAL region */
+    ROM_TAG_REGION_JAPAN = (3 << 3),        /**< Japanese region */
+    ROM_TAG_REGION_MASK = (3 << 3),         /**< Region bits */
+    ROM_TAG_EXPANSION_PAK = (1 << 5),       /**< Uses the Expansion Pak */
+    ROM_TAG_RUMBLE_PAK = (1 << 6),          /**< Supports the Rumble Pak */
+} rom_tag_t;
+
 /**
  * @brief Get the CIC seed for the ROM.
  * 
@@ -189,6 +213,79 @@ typedef struct {
  */
 bool rom_info_get_cic_seed(rom_info_t *rom_info, uint8_t *seed);
 
+/**
+ * @brief Load the index of an external ROM database.
+ *
+ * Entries of the external database take precedence over the built-in ones.
+ * Only the index is kept in memory, the records are read on demand.
+ *
+ * @param database_location Path to the database file
+ */
+void rom_info_database_init(char *database_location);
+
+/**
+ * @brief Initialize the ROM information cache.
+ *
+ * Information extracted from the ROM headers is kept in the cache file,
+ * keyed by the ROM path, size and timestamp.
+ *
+ * @param cache_location Path to the cache file
+ */
+void rom_info_cache_init(char *cache_location);
+
+/**
+ * @brief Keep the per-ROM settings in a single store file instead of the ini files next to the ROMs.
+ *
+ * Existing ini files are imported into the store the first time the ROM settings are loaded.
+ *
+ * @param store_location Path to the store file
+ */
+void rom_settings_store_init(char *store_location);
+
+/**
+ * @brief Make sure the ROM header information is present in the cache.
+ *
+ * @param path Pointer to the path structure
+ * @return rom_err_t Error code
+ */
+rom_err_t rom_info_cache_update(path_t *path);
+
+/**
+ * @brief Get the ROM header information, reading the header only when it's not in the cache.
+ *
+ * Unlike rom_config_load, the per-ROM settings are not loaded.
+ *
+ * @param path Pointer to the path structure
+ * @param rom_info Pointer to the ROM information structure
+ * @return rom_err_t Error code
+ */
+rom_err_t rom_info_cache_load(path_t *path, rom_info_t *rom_info);
+
+/**
+ * @brief Get the checksum computed from the ROM data during a previous verified load.
+ *
+ * @param path Pointer to the path structure
+ * @param check_code Pointer to the checksum, left untouched when no checksum is stored
+ * @return true if no checksum is stored for the ROM file, false otherwise
+ */
+bool rom_info_cache_get_check_code(path_t *path, uint64_t *check_code);
+
+/**
+ * @brief Store the checksum computed from the ROM data in the cache.
+ *
+ * @param path Pointer to the path structure
+ * @param check_code Checksum computed during the load
+ */
+void rom_info_cache_set_check_code(path_t *path, uint64_t check_code);
+
+/**
+ * @brief Get the tags of the ROM shown in the file list.
+ *
+ * @param rom_info Pointer to the ROM information structure
+ * @return uint8_t ROM tags (rom_tag_t flags), ROM_TAG_SCANNED is always set
+ */
+uint8_t rom_info_get_tags(rom_info_t *rom_info);
+
 /**
  * @brief Load ROM information from a file.
  * 
@@ -198,6 +295,19 @@ bool rom_info_get_cic_seed(rom_info_t *rom_info, uint8_t *seed);
  */
 rom_err_t rom_config_load(path_t *path, rom_info_t *rom_info);
 
+/**
+ * @brief Load ROM information from a header already read into memory.
+ *
+ * Used for ROMs that are not stored as plain files, the per-ROM settings are keyed on the given path.
+ * 
+ * @param path Pointer to the path structure
+ * @param header Pointer to the start of the ROM image
+ * @param length Length of the data at the start of the ROM image
+ * @param rom_info Pointer to the ROM information structure
+ * @return rom_err_t Error code
+ */
+rom_err_t rom_config_load_from_header(path_t *path, const void *header, size_t length, rom_info_t *rom_info);
+
 /**
  * @brief Get the CIC type for the ROM.
  * 
@@ -262,6 +372,30 @@ rom_err_t rom_config_override_tv_type(path_t *path, rom_info_t *rom_info, rom_tv
  */
 rom_err_t rom_config_setting_set_cheats (path_t *path, rom_info_t *rom_info, bool enabled);
 
+/**
+ * @brief Write the settings changed by the override and setting functions.
+ *
+ * Changes are only kept in the ROM information structure until this is called.
+ * 
+ * @param path Pointer to the path structure
+ * @param rom_info Pointer to the ROM information structure
+ * @return rom_err_t Error code
+ */
+rom_err_t rom_config_flush (path_t *path, rom_info_t *rom_info);
+
+/**
+ * @brief Store the detected data extent for the ROM.
+ * 
+ * @param path Pointer to the path structure
+ * @param rom_info Pointer to the ROM information structure
+ * @param file_size ROM file size
+ * @param timestamp ROM file timestamp
+ * @param data_size Size of the meaningful data
+ * @param fill Value of the trailing filler bytes
+ * @return rom_err_t Error code
+ */
+rom_err_t rom_config_setting_set_extent (path_t *path, rom_info_t *rom_info, uint32_t file_size, uint32_t timestamp, uint32_t data_size, uint8_t fill);
+
 #ifdef FEATURE_PATCHER_GUI_ENABLED
 /**
  * @brief Set the patcher setting for the ROM.
@@ -0,0 +1,581 @@
+/**
+ * @file rom_patch.c
+ * @brief ROM patch engine implementation
+ * @ingroup menu
+ */
+
+#include <string.h>
+
+#include "rom_patch.h"
+#include "utils/utils.h"
+
+#define PATCH_BUFFER_SIZE       (4096)
+#define COPY_BUFFER_SIZE        (4096)
+
+#define IPS_EOF                 (0x454F46)
+#define CHECKSUMS_SIZE          (12)
+
+#define BPS_SOURCE_READ         (0)
+#define BPS_TARGET_READ         (1)
+#define BPS_SOURCE_COPY         (2)
+#define BPS_TARGET_COPY         (3)
+
+/** @brief Patch application state. */
+typedef struct {
+    rom_patch_io_t *io; /**< Patch access structure */
+    rom_patch_err_t err; /**< First error encountered */
+    bool validate; /**< Only validate the patch, nothing is read from or written to the ROM */
+    uint32_t offset; /**< Read position in the patch */
+    uint32_t buffer_offset; /**< Patch offset of the buffered data */
+    uint32_t buffer_length; /**< Length of the buffered data */
+    uint32_t crc; /**< Checksum of the patch data read while validating */
+    uint32_t crc_end; /**< End of the checksummed patch data */
+    uint32_t size; /**< Current size of the patched ROM */
+    bool bps_shadow; /**< The BPS source data must be copied before it's overwritten */
+} patch_t;
+
+static uint8_t patch_buffer[PATCH_BUFFER_SIZE];
+static uint8_t copy_buffer[COPY_BUFFER_SIZE];
+static uint8_t data_buffer[COPY_BUFFER_SIZE];
+static const uint8_t zero_buffer[COPY_BUFFER_SIZE];
+static uint32_t crc_table[256];
+
+
+static void crc_init (void) {
+    if (crc_table[1] != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; bit++) {
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        }
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t crc_update (uint32_t crc, const uint8_t *data, size_t length) {
+    crc = ~crc;
+    while (length--) {
+        crc = crc_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void patch_error (patch_t *p, rom_patch_err_t err) {
+    if (p->err == ROM_PATCH_OK) {
+        p->err = err;
+    }
+}
+
+static bool patch_fill (patch_t *p) {
+    uint32_t length = MIN(p->io->patch_size - p->offset, PATCH_BUFFER_SIZE);
+
+    if (length == 0) {
+        patch_error(p, ROM_PATCH_ERR_FORMAT);
+        return true;
+    }
+
+    if (p->io->patch_read(p->io->arg, p->offset, patch_buffer, length)) {
+        patch_error(p, ROM_PATCH_ERR_IO);
+        return true;
+    }
+
+    p->buffer_offset = p->offset;
+    p->buffer_length = length;
+
+    // NOTE: Data is read sequentially while validating, every byte passes through here once
+    if (p->validate && (p->offset < p->crc_end)) {
+        p->crc = crc_update(p->crc, patch_buffer, MIN(length, p->crc_end - p->offset));
+    }
+
+    return false;
+}
+
+static void patch_read_bytes (patch_t *p, uint8_t *data, size_t length) {
+    while ((length > 0) && (p->err == ROM_PATCH_OK)) {
+        if (((p->offset - p->buffer_offset) >= p->buffer_length) && patch_fill(p)) {
+            return;
+        }
+        size_t available = MIN(length, p->buffer_length - (p->offset - p->buffer_offset));
+        if (data) {
+            memcpy(data, &patch_buffer[p->offset - p->buffer_offset], available);
+            data += available;
+        }
+        p->offset += available;
+        length -= available;
+    }
+}
+
+static uint8_t patch_read_byte (patch_t *p) {
+    uint8_t value = 0;
+    patch_read_bytes(p, &value, 1);
+    return value;
+}
+
+static uint32_t patch_read_be (patch_t *p, int bytes) {
+    uint32_t value = 0;
+    while (bytes--) {
+        value = ((value << 8) | patch_read_byte(p));
+    }
+    return value;
+}
+
+static uint32_t patch_read_le32 (patch_t *p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (patch_read_byte(p) << (i * 8));
+    }
+    return value;
+}
+
+/**
+ * @brief Read a variable length number used by the UPS and BPS formats.
+ */
+static uint32_t patch_read_number (patch_t *p) {
+    uint64_t value = 0;
+    uint64_t shift = 1;
+
+    for (int i = 0; (i < 5) && (p->err == ROM_PATCH_OK); i++) {
+        uint8_t byte = patch_read_byte(p);
+        value += ((byte & 0x7F) * shift);
+        if (byte & 0x80) {
+            if (value > UINT32_MAX) {
+                break;
+            }
+            return (uint32_t) (value);
+        }
+        shift <<= 7;
+        value += shift;
+    }
+
+    patch_error(p, ROM_PATCH_ERR_FORMAT);
+
+    return 0;
+}
+
+static void patch_check_magic (patch_t *p, const char *magic) {
+    uint8_t data[5];
+    size_t length = strlen(magic);
+
+    patch_read_bytes(p, data, length);
+    if ((p->err == ROM_PATCH_OK) && (memcmp(data, magic, length) != 0)) {
+        patch_error(p, ROM_PATCH_ERR_FORMAT);
+    }
+}
+
+/**
+ * @brief Read the UPS and BPS trailing checksums, the patch checksum is verified while validating.
+ */
+static void patch_check_checksums (patch_t *p, uint32_t end) {
+    if (p->offset != end) {
+        patch_error(p, ROM_PATCH_ERR_FORMAT);
+        return;
+    }
+
+    patch_read_le32(p); // NOTE: Source checksum, the source is only checked by size to avoid reading the whole ROM
+    patch_read_le32(p); // NOTE: Target checksum
+    uint32_t patch_crc = patch_read_le32(p);
+
+    if (p->validate && (p->err == ROM_PATCH_OK) && (p->crc != patch_crc)) {
+        patch_error(p, ROM_PATCH_ERR_CHECKSUM);
+    }
+}
+
+static bool rom_range_valid (patch_t *p, uint32_t offset, size_t length) {
+    if ((offset > p->io->rom_space) || (length > (p->io->rom_space - offset))) {
+        patch_error(p, ROM_PATCH_ERR_SIZE);
+        return false;
+    }
+    return true;
+}
+
+static void rom_io_read (patch_t *p, uint32_t offset, void *buffer, size_t length) {
+    if ((p->err != ROM_PATCH_OK) || p->validate || !rom_range_valid(p, offset, length)) {
+        return;
+    }
+    if (p->io->rom_read(p->io->arg, offset, buffer, length)) {
+        patch_error(p, ROM_PATCH_ERR_IO);
+    }
+}
+
+static void rom_io_write (patch_t *p, uint32_t offset, const void *buffer, size_t length) {
+    if ((p->err != ROM_PATCH_OK) || !rom_range_valid(p, offset, length) || p->validate) {
+        return;
+    }
+    if (p->io->rom_write(p->io->arg, offset, buffer, length)) {
+        patch_error(p, ROM_PATCH_ERR_IO);
+    }
+}
+
+/**
+ * @brief Grow the patched ROM, the new space is filled with zeros.
+ */
+static void rom_grow (patch_t *p, uint32_t size) {
+    while ((p->size < size) && (p->err == ROM_PATCH_OK)) {
+        uint32_t chunk = MIN(size - p->size, COPY_BUFFER_SIZE);
+        rom_io_write(p, p->size, zero_buffer, chunk);
+        p->size += chunk;
+    }
+}
+
+/**
+ * @brief Write data to the patched ROM, growing it if needed.
+ */
+static void rom_write (patch_t *p, uint32_t offset, const void *buffer, size_t length) {
+    if ((p->err != ROM_PATCH_OK) || !rom_range_valid(p, offset, length)) {
+        return;
+    }
+    rom_grow(p, offset);
+    rom_io_write(p, offset, buffer, length);
+    p->size = MAX(p->size, (uint32_t) (offset + length));
+}
+
+static void rom_fill (patch_t *p, uint32_t offset, uint8_t value, size_t length) {
+    memset(copy_buffer, value, MIN(length, COPY_BUFFER_SIZE));
+    while ((length > 0) && (p->err == ROM_PATCH_OK)) {
+        size_t chunk = MIN(length, COPY_BUFFER_SIZE);
+        rom_write(p, offset, copy_buffer, chunk);
+        offset += chunk;
+        length -= chunk;
+    }
+}
+
+/**
+ * @brief Read data from the patched ROM, data past its end reads as zeros.
+ */
+static void rom_read (patch_t *p, uint32_t offset, uint8_t *buffer, size_t length) {
+    size_t available = (offset < p->size) ? MIN(length, p->size - offset) : 0;
+    rom_io_read(p, offset, buffer, available);
+    memset(buffer + available, 0x00, length - available);
+}
+
+static void rom_resize (patch_t *p, uint32_t size) {
+    rom_grow(p, size);
+    p->size = size;
+}
+
+
+static void ips_apply (patch_t *p) {
+    patch_check_magic(p, "PATCH");
+
+    while (p->err == ROM_PATCH_OK) {
+        uint32_t offset = patch_read_be(p, 3);
+        if (offset == IPS_EOF) {
+            break;
+        }
+
+        uint32_t length = patch_read_be(p, 2);
+
+        if (length == 0) {
+            uint32_t count = patch_read_be(p, 2);
+            uint8_t value = patch_read_byte(p);
+            if (count == 0) {
+                patch_error(p, ROM_PATCH_ERR_FORMAT);
+            }
+            if (p->err == ROM_PATCH_OK) {
+                rom_fill(p, offset, value, count);
+            }
+            continue;
+        }
+
+        while ((length > 0) && (p->err == ROM_PATCH_OK)) {
+            uint32_t chunk = MIN(length, COPY_BUFFER_SIZE);
+            patch_read_bytes(p, data_buffer, chunk);
+            rom_write(p, offset, data_buffer, chunk);
+            offset += chunk;
+            length -= chunk;
+        }
+    }
+
+    // NOTE: Optional truncation extension, the output size follows the EOF marker
+    if ((p->err == ROM_PATCH_OK) && ((p->io->patch_size - p->offset) >= 3)) {
+        uint32_t size = patch_read_be(p, 3);
+        if (rom_range_valid(p, 0, size)) {
+            rom_resize(p, size);
+        }
+    }
+}
+
+static void ups_flush (patch_t *p, uint32_t offset, uint32_t length) {
+    rom_read(p, offset, copy_buffer, length);
+    for (uint32_t i = 0; i < length; i++) {
+        copy_buffer[i] ^= data_buffer[i];
+    }
+    rom_write(p, offset, copy_buffer, length);
+}
+
+static void ups_apply (patch_t *p) {
+    if (p->io->patch_size < (4 + CHECKSUMS_SIZE)) {
+        patch_error(p, ROM_PATCH_ERR_FORMAT);
+        return;
+    }
+
+    uint32_t end = (p->io->patch_size - CHECKSUMS_SIZE);
+
+    patch_check_magic(p, "UPS1");
+    uint32_t source_size = patch_read_number(p);
+    uint32_t target_size = patch_read_number(p);
+
+    if (p->err != ROM_PATCH_OK) {
+        return;
+    }
+    if (source_size != p->io->rom_size) {
+        patch_error(p, ROM_PATCH_ERR_SOURCE_MISMATCH);
+        return;
+    }
+    if (!rom_range_valid(p, 0, target_size)) {
+        return;
+    }
+
+    uint32_t output = 0;
+
+    while ((p->offset < end) && (p->err == ROM_PATCH_OK)) {
+        uint32_t skip = patch_read_number(p);
+        if (skip > (target_size - output)) {
+            patch_error(p, ROM_PATCH_ERR_FORMAT);
+            break;
+        }
+        output += skip;
+
+        // NOTE: Bytes are XOR-ed with the source until a zero byte, which leaves its own position unchanged
+        uint32_t length = 0;
+        while (p->err == ROM_PATCH_OK) {
+            uint8_t value = patch_read_byte(p);
+            if (value != 0) {
+                data_buffer[length++] = value;
+            }
+            if ((value == 0) || (length == COPY_BUFFER_SIZE)) {
+                if (length > (target_size - output)) {
+                    patch_error(p, ROM_PATCH_ERR_FORMAT);
+                    break;
+                }
+                ups_flush(p, output, length);
+                output += length;
+                length = 0;
+            }
+            if (value == 0) {
+                output = MIN(output + 1, target_size);
+                break;
+            }
+        }
+    }
+
+    patch_check_checksums(p, end);
+
+    rom_resize(p, target_size);
+}
+
+static uint32_t bps_read_offset (patch_t *p, uint32_t base, uint32_t length, uint32_t limit) {
+    uint32_t data = patch_read_number(p);
+    int64_t offset = (int64_t) (base) + ((data & 1) ? -((int64_t) (data >> 1)) : ((int64_t) (data >> 1)));
+
+    if ((offset < 0) || ((offset + length) > limit)) {
+        patch_error(p, ROM_PATCH_ERR_FORMAT);
+        return 0;
+    }
+
+    return (uint32_t) (offset);
+}
+
+static void bps_copy (patch_t *p, uint32_t source, uint32_t output, uint32_t length, uint32_t max_chunk) {
+    while ((length > 0) && (p->err == ROM_PATCH_OK)) {
+        uint32_t chunk = MIN(length, max_chunk);
+        rom_io_read(p, source, copy_buffer, chunk);
+        rom_write(p, output, copy_buffer, chunk);
+        source += chunk;
+        output += chunk;
+        length -= chunk;
+    }
+}
+
+static void bps_apply (patch_t *p) {
+    if (p->io->patch_size < (4 + CHECKSUMS_SIZE)) {
+        patch_error(p, ROM_PATCH_ERR_FORMAT);
+        return;
+    }
+
+    uint32_t end = (p->io->patch_size - CHECKSUMS_SIZE);
+
+    patch_check_magic(p, "BPS1");
+    uint32_t source_size = patch_read_number(p);
+    uint32_t target_size = patch_read_number(p);
+    uint32_t metadata_size = patch_read_number(p);
+    patch_read_bytes(p, NULL, metadata_size);
+
+    if (p->err != ROM_PATCH_OK) {
+        return;
+    }
+    if (source_size != p->io->rom_size) {
+        patch_error(p, ROM_PATCH_ERR_SOURCE_MISMATCH);
+        return;
+    }
+    if (!rom_range_valid(p, 0, target_size)) {
+        return;
+    }
+
+    // NOTE: Source copies read the ROM in place, unless some of them read data already overwritten by the target,
+    //       then the source is copied past the target in the cart SDRAM first, without a temporary file
+    uint32_t source_base = 0;
+    if (p->bps_shadow) {
+        source_base = ALIGN(MAX(source_size, target_size), 16);
+        if (!rom_range_valid(p, source_base, source_size)) {
+            return;
+        }
+        for (uint32_t offset = 0; (offset < source_size) && (p->err == ROM_PATCH_OK); offset += COPY_BUFFER_SIZE) {
+            uint32_t chunk = MIN(source_size - offset, COPY_BUFFER_SIZE);
+            rom_io_read(p, offset, copy_buffer, chunk);
+            rom_io_write(p, source_base + offset, copy_buffer, chunk);
+        }
+    }
+
+    uint32_t output = 0;
+    uint32_t source_relative = 0;
+    uint32_t target_relative = 0;
+    uint32_t dirty = UINT32_MAX;
+
+    while ((p->offset < end) && (p->err == ROM_PATCH_OK)) {
+        uint32_t data = patch_read_number(p);
+        uint32_t mode = (data & 3);
+        uint32_t length = ((data >> 2) + 1);
+
+        if (length > (target_size - output)) {
+            patch_error(p, ROM_PATCH_ERR_FORMAT);
+            break;
+        }
+
+        switch (mode) {
+            case BPS_SOURCE_READ:
+                // NOTE: The target is built in place, the source data at the output position is still intact
+                if ((output + length) > source_size) {
+                    patch_error(p, ROM_PATCH_ERR_FORMAT);
+                }
+                break;
+
+            case BPS_TARGET_READ:
+                dirty = MIN(dirty, output);
+                for (uint32_t done = 0; (done < length) && (p->err == ROM_PATCH_OK); ) {
+                    uint32_t chunk = MIN(length - done, COPY_BUFFER_SIZE);
+                    patch_read_bytes(p, data_buffer, chunk);
+                    rom_write(p, output + done, data_buffer, chunk);
+                    done += chunk;
+                }
+                break;
+
+            case BPS_SOURCE_COPY:
+                source_relative = bps_read_offset(p, source_relative, length, source_size);
+                if (source_relative != output) {
+                    if ((source_relative < output) && ((source_relative + length) > MIN(dirty, output))) {
+                        p->bps_shadow = true;
+                    }
+                    dirty = MIN(dirty, output);
+                    bps_copy(p, source_base + source_relative, output, length, COPY_BUFFER_SIZE);
+                }
+                source_relative += length;
+                break;
+
+            case BPS_TARGET_COPY:
+                target_relative = bps_read_offset(p, target_relative, 0, output);
+                if (target_relative >= output) {
+                    patch_error(p, ROM_PATCH_ERR_FORMAT);
+                    break;
+                }
+                dirty = MIN(dirty, output);
+                // NOTE: The copy can overlap its own output, only data already written is read per chunk
+                for (uint32_t done = 0; (done < length) && (p->err == ROM_PATCH_OK); ) {
+                    uint32_t chunk = MIN(MIN(length - done, COPY_BUFFER_SIZE), output - target_relative);
+                    bps_copy(p, target_relative + done, output + done, chunk, chunk);
+                    done += chunk;
+                }
+                target_relative += length;
+                break;
+        }
+
+        output += length;
+    }
+
+    if ((p->err == ROM_PATCH_OK) && (output != target_size)) {
+        patch_error(p, ROM_PATCH_ERR_FORMAT);
+    }
+
+    patch_check_checksums(p, end);
+
+    p->size = target_size;
+}
+
+
+rom_patch_type_t rom_patch_get_type (const uint8_t *header, size_t length) {
+    if ((length >= 5) && (memcmp(header, "PATCH", 5) == 0)) {
+        return ROM_PATCH_TYPE_IPS;
+    }
+    if ((length >= 4) && (memcmp(header, "UPS1", 4) == 0)) {
+        return ROM_PATCH_TYPE_UPS;
+    }
+    if ((length >= 4) && (memcmp(header, "BPS1", 4) == 0)) {
+        return ROM_PATCH_TYPE_BPS;
+    }
+    return ROM_PATCH_TYPE_UNKNOWN;
+}
+
+rom_patch_err_t rom_patch_apply (rom_patch_io_t *io, uint32_t *patched_size) {
+    uint8_t header[5];
+    void (*apply) (patch_t *p);
+
+    if (io->patch_size < sizeof(header)) {
+        return ROM_PATCH_ERR_FORMAT;
+    }
+    if (io->patch_read(io->arg, 0, header, sizeof(header))) {
+        return ROM_PATCH_ERR_IO;
+    }
+    if (io->rom_size > io->rom_space) {
+        return ROM_PATCH_ERR_SIZE;
+    }
+
+    switch (rom_patch_get_type(header, sizeof(header))) {
+        case ROM_PATCH_TYPE_IPS: apply = ips_apply; break;
+        case ROM_PATCH_TYPE_UPS: apply = ups_apply; break;
+        case ROM_PATCH_TYPE_BPS: apply = bps_apply; break;
+        default: return ROM_PATCH_ERR_UNSUPPORTED;
+    }
+
+    crc_init();
+
+    patch_t p = { .bps_shadow = false };
+
+    for (int pass = 0; pass < 2; pass++) {
+        p = (patch_t) {
+            .io = io,
+            .err = ROM_PATCH_OK,
+            .validate = (pass == 0),
+            .crc = 0,
+            .crc_end = (io->patch_size - 4),
+            .size = io->rom_size,
+            .bps_shadow = p.bps_shadow,
+        };
+
+        apply(&p);
+
+        if (p.err != ROM_PATCH_OK) {
+            return p.err;
+        }
+    }
+
+    if (patched_size) {
+        *patched_size = p.size;
+    }
+
+    return ROM_PATCH_OK;
+}
+
+char *rom_patch_convert_error_message (rom_patch_err_t err) {
+    switch (err) {
+        case ROM_PATCH_OK: return "No error";
+        case ROM_PATCH_ERR_IO: return "Couldn't access the patch or the ROM";
+        case ROM_PATCH_ERR_FORMAT: return "The patch is damaged";
+        case ROM_PATCH_ERR_UNSUPPORTED: return "Unsupported patch format";
+        case ROM_PATCH_ERR_SOURCE_MISMATCH: return "The patch is made for a different ROM";
+        case ROM_PATCH_ERR_SIZE: return "The patched ROM is too large";
+        case ROM_PATCH_ERR_CHECKSUM: return "The patch checksum doesn't match";
+        default: return "Unknown error [ROM_PATCH]";
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ * @file rom_patch.h
+ * @brief ROM patch engine
+ * @ingroup menu
+ *
+ * IPS, UPS and BPS patches are applied in place to the ROM image already
+ * stored in the cart SDRAM. The engine only accesses the patch and the ROM
+ * through the callbacks, the patch is parsed twice: the first pass validates
+ * it before anything is written, the second one applies it.
+ */
+
+#ifndef ROM_PATCH_H__
+#define ROM_PATCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief ROM patch error enumeration. */
+typedef enum {
+    ROM_PATCH_OK, /**< No error */
+    ROM_PATCH_ERR_IO, /**< Patch or ROM access failed */
+    ROM_PATCH_ERR_FORMAT, /**< The patch data is malformed */
+    ROM_PATCH_ERR_UNSUPPORTED, /**< The patch format isn't supported */
+    ROM_PATCH_ERR_SOURCE_MISMATCH, /**< The patch was made for a different ROM */
+    ROM_PATCH_ERR_SIZE, /**< The patched ROM doesn't fit the available space */
+    ROM_PATCH_ERR_CHECKSUM, /**< The patch checksum doesn't match */
+} rom_patch_err_t;
+
+/** @brief ROM patch type enumeration. */
+typedef enum {
+    ROM_PATCH_TYPE_UNKNOWN, /**< Unknown patch format */
+    ROM_PATCH_TYPE_IPS, /**< International Patching System */
+    ROM_PATCH_TYPE_UPS, /**< Universal Patching System */
+    ROM_PATCH_TYPE_BPS, /**< Beat Patching System */
+} rom_patch_type_t;
+
+/** @brief ROM patch access structure. */
+typedef struct {
+    /** @brief Read patch data, returns true on error */
+    bool (*patch_read) (void *arg, uint32_t offset, void *buffer, size_t length);
+    /** @brief Read ROM data, returns true on error */
+    bool (*rom_read) (void *arg, uint32_t offset, void *buffer, size_t length);
+    /** @brief Write ROM data, returns true on error */
+    bool (*rom_write) (void *arg, uint32_t offset, const void *buffer, size_t length);
+    /** @brief Argument passed to the callbacks */
+    void *arg;
+    /** @brief Size of the patch file */
+    uint32_t patch_size;
+    /** @brief Size of the ROM image to patch */
+    uint32_t rom_size;
+    /** @brief Size of the writable ROM space, used for the patched ROM and the BPS source copy */
+    uint32_t rom_space;
+} rom_patch_io_t;
+
+/**
+ * @brief Detect the patch format from the patch header.
+ *
+ * @param header Pointer to the first bytes of the patch.
+ * @param length Number of bytes available in the header.
+ * @return rom_patch_type_t Patch type.
+ */
+rom_patch_type_t rom_patch_get_type (const uint8_t *header, size_t length);
+
+/**
+ * @brief Apply a patch to the ROM.
+ *
+ * @param io Pointer to the patch access structure.
+ * @param patched_size Pointer to store the size of the patched ROM, can be NULL.
+ * @return rom_patch_err_t Error code, the ROM is left untouched when the patch doesn't validate.
+ */
+rom_patch_err_t rom_patch_apply (rom_patch_io_t *io, uint32_t *patched_size);
+
+/**
+ * @brief Convert a ROM patch error code to a human-readable error message.
+ *
+ * @param err The ROM patch error code.
+ * @return char* The human-readable error message.
+ */
+char *rom_patch_convert_error_message (rom_patch_err_t err);
+
+#endif /* ROM_PATCH_H__ */
@@ -0,0 +1,205 @@
+/**
+ * @file save_backup.c
+ * @brief Incremental save backups implementation
+ * @ingroup menu
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
+#include <libdragon.h>
+#include <miniz.h>
+
+#include "save_backup.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
+
+#define BACKUP_DIRECTORY        "backups"
+#define BACKUP_MAGIC            (0x53424B31) // "SBK1"
+#define BACKUP_MAX_SECTORS      (256)
+#define BACKUP_CHUNK_SECTORS    (16)
+
+/** @brief Backup manifest, the checksums of the sectors stored in every backup. */
+typedef struct {
+    uint32_t magic; /**< Manifest magic */
+    uint32_t next; /**< Backup refreshed on the next call */
+    uint32_t sizes[SAVE_BACKUP_GENERATIONS]; /**< Size of every backup, 0 when it must be fully written */
+    uint32_t checksums[SAVE_BACKUP_GENERATIONS][BACKUP_MAX_SECTORS]; /**< Checksum of every backed up sector */
+} save_backup_manifest_t;
+
+static save_backup_manifest_t manifest;
+static uint8_t buffer[BACKUP_CHUNK_SECTORS * FS_SECTOR_SIZE] __attribute__((aligned(8)));
+
+
+static void manifest_load (char *path) {
+    FIL fil;
+    UINT br;
+
+    if (f_open(&fil, strip_fs_prefix(path), FA_READ) == FR_OK) {
+        bool error = (f_read(&fil, &manifest, sizeof(manifest), &br) != FR_OK) || (br != sizeof(manifest));
+        f_close(&fil);
+        if (!error && (manifest.magic == BACKUP_MAGIC)) {
+            return;
+        }
+    }
+
+    memset(&manifest, 0, sizeof(manifest));
+    manifest.magic = BACKUP_MAGIC;
+}
+
+static bool manifest_save (char *path) {
+    FIL fil;
+    UINT bw;
+
+    if (f_open(&fil, strip_fs_prefix(path), FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return true;
+    }
+
+    bool error = (f_write(&fil, &manifest, sizeof(manifest), &bw) != FR_OK) || (bw != sizeof(manifest));
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+static bool write_run (FIL *fil, uint32_t sector, const uint8_t *data, uint32_t length) {
+    UINT bw;
+
+    if (f_lseek(fil, sector * FS_SECTOR_SIZE) != FR_OK) {
+        return true;
+    }
+
+    return (f_write(fil, data, length, &bw) != FR_OK) || (bw != length);
+}
+
+/**
+ * @brief Copy the changed sectors of the save file into the backup.
+ * 
+ * @param save Pointer to the opened save file.
+ * @param backup Pointer to the opened backup file.
+ * @param size Size of the save file.
+ * @param checksums Checksums of the sectors stored in the backup, updated with the new ones.
+ * @param full Write every sector, the stored checksums are not valid.
+ * @return int Number of written sectors, negative on error.
+ */
+static int copy_changed_sectors (FIL *save, FIL *backup, uint32_t size, uint32_t *checksums, bool full) {
+    UINT br;
+    int written = 0;
+
+    for (uint32_t offset = 0; offset < size; offset += sizeof(buffer)) {
+        uint32_t length = MIN(size - offset, sizeof(buffer));
+        uint32_t first_sector = (offset / FS_SECTOR_SIZE);
+
+        if ((f_read(save, buffer, length, &br) != FR_OK) || (br != length)) {
+            return -1;
+        }
+
+        // NOTE: Consecutive changed sectors are written with a single call
+        uint32_t run_start = 0;
+        uint32_t run_length = 0;
+
+        for (uint32_t position = 0; position < length; position += FS_SECTOR_SIZE) {
+            uint32_t sector = (first_sector + (position / FS_SECTOR_SIZE));
+            uint32_t sector_length = MIN(length - position, FS_SECTOR_SIZE);
+            uint32_t checksum = (uint32_t) (mz_crc32(MZ_CRC32_INIT, &buffer[position], sector_length));
+
+            if (full || (checksums[sector] != checksum)) {
+                if (run_length == 0) {
+                    run_start = position;
+                }
+                run_length += sector_length;
+                written += 1;
+            } else if (run_length > 0) {
+                if (write_run(backup, first_sector + (run_start / FS_SECTOR_SIZE), &buffer[run_start], run_length)) {
+                    return -1;
+                }
+                run_length = 0;
+            }
+
+            checksums[sector] = checksum;
+        }
+
+        if ((run_length > 0) && write_run(backup, first_sector + (run_start / FS_SECTOR_SIZE), &buffer[run_start], run_length)) {
+            return -1;
+        }
+    }
+
+    return written;
+}
+
+bool save_backup_update (path_t *save_path) {
+    FIL save;
+    FIL backup;
+    char name[8];
+
+    if (f_open(&save, strip_fs_prefix(path_get(save_path)), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    uint32_t size = f_size(&save);
+    if ((size == 0) || (size > (BACKUP_MAX_SECTORS * FS_SECTOR_SIZE))) {
+        f_close(&save);
+        return (size != 0);
+    }
+
+    path_t *path = path_clone(save_path);
+    path_push_subdir(path, BACKUP_DIRECTORY);
+
+    path_t *directory = path_clone(path);
+    path_pop(directory);
+    bool error = directory_create(path_get(directory));
+    path_free(directory);
+
+    path_ext_replace(path, "backup");
+    path_t *manifest_path = path_clone(path);
+
+    if (!error) {
+        manifest_load(path_get(manifest_path));
+    }
+
+    uint32_t generation = (manifest.next % SAVE_BACKUP_GENERATIONS);
+    sprintf(name, "%lu.sav", generation + 1);
+    path_ext_replace(path, name);
+
+    if (!error && (f_open(&backup, strip_fs_prefix(path_get(path)), FA_WRITE | FA_OPEN_ALWAYS) != FR_OK)) {
+        error = true;
+    }
+
+    if (!error) {
+        bool full = (manifest.sizes[generation] != size) || (f_size(&backup) != size);
+
+        int written = copy_changed_sectors(&save, &backup, size, manifest.checksums[generation], full);
+        error = (written < 0);
+
+        if (!error && (f_size(&backup) > size)) {
+            error = (f_lseek(&backup, size) != FR_OK) || (f_truncate(&backup) != FR_OK);
+        }
+
+        if (f_close(&backup) != FR_OK) {
+            error = true;
+        }
+
+        if (!error) {
+            debugf("Save backup: %s refreshed, %d of %lu sectors written\n", path_get(path), written, ALIGN(size, FS_SECTOR_SIZE) / FS_SECTOR_SIZE);
+            manifest.sizes[generation] = size;
+            manifest.next = ((generation + 1) % SAVE_BACKUP_GENERATIONS);
+        } else {
+            // NOTE: The backup contents are unknown now, it is fully written next time
+            manifest.sizes[generation] = 0;
+        }
+
+        if (manifest_save(path_get(manifest_path))) {
+            error = true;
+        }
+    }
+
+    f_close(&save);
+
+    path_free(manifest_path);
+    path_free(path);
+
+    return error;
+}
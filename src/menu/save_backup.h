@@ -0,0 +1,29 @@
+/**
+ * @file save_backup.h
+ * @brief Incremental save backups
+ * @ingroup menu
+ */
+
+#ifndef SAVE_BACKUP_H__
+#define SAVE_BACKUP_H__
+
+#include <stdbool.h>
+
+#include "path.h"
+
+/** @brief Number of rolling backups kept for every save file. */
+#define SAVE_BACKUP_GENERATIONS     (3)
+
+/**
+ * @brief Refresh the oldest backup of a save file.
+ * 
+ * Backups are kept in the backups directory next to the save file and are refreshed in turn on every call.
+ * A manifest stores a checksum of every backed up sector, so only the sectors that
+ * changed since that backup was taken are written.
+ * 
+ * @param save_path Path to the save file.
+ * @return true if the backup couldn't be refreshed, false otherwise.
+ */
+bool save_backup_update (path_t *save_path);
+
+#endif /* SAVE_BACKUP_H__ */
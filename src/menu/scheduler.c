@@ -0,0 +1,156 @@
+/**
+ * @file scheduler.c
+ * @brief Cooperative background task scheduler implementation
+ * @ingroup menu
+ */
+
+#include <libdragon.h>
+
+#include "scheduler.h"
+#include "utils/trace_events.h"
+
+/** @brief Registered task structure. */
+typedef struct {
+    const char *name; /**< Task name */
+    scheduler_priority_t priority; /**< Task priority */
+    uint32_t budget_us; /**< Time budget per frame */
+    scheduler_task_callback_t *callback; /**< Task callback */
+    void *arg; /**< Callback argument */
+    uint32_t cost_us; /**< Run time running average */
+    uint32_t used_us; /**< Time used in the current frame */
+    uint32_t last_frame; /**< Last frame the task ran in */
+    bool pending; /**< Work was queued after the last run */
+} scheduler_task_t;
+
+static scheduler_task_t tasks[SCHEDULER_MAX_TASKS];
+static int task_count;
+
+/** @brief Scheduler frame state structure. */
+static struct {
+    uint32_t interval_us; /**< Interval between the frames */
+    uint64_t deadline_us; /**< Expected start of the next frame */
+    uint32_t frame; /**< Frame counter */
+    uint32_t busy_us; /**< Time spent in the tasks during the current frame */
+} frame;
+
+static scheduler_stats_t stats;
+
+
+static void frame_start (uint64_t now_us) {
+    stats.busy_us = frame.busy_us;
+    frame.busy_us = 0;
+    frame.deadline_us = now_us + frame.interval_us;
+    frame.frame += 1;
+
+    for (int i = 0; i < task_count; i++) {
+        tasks[i].used_us = 0;
+    }
+}
+
+/**
+ * @brief Check if a task can run in the time left in the frame.
+ *
+ * A task that didn't run for a whole frame runs anyway, so a slow task isn't starved by a busy frame.
+ */
+static bool task_runnable (scheduler_task_t *task, uint64_t now_us) {
+    if (task->priority == SCHEDULER_PRIORITY_AUDIO) {
+        return true;
+    }
+
+    if (task->used_us >= task->budget_us) {
+        return false;
+    }
+
+    if ((frame.frame - task->last_frame) > 1) {
+        return true;
+    }
+
+    return ((now_us + task->cost_us) <= frame.deadline_us);
+}
+
+
+void scheduler_init (uint32_t frame_interval_us) {
+    task_count = 0;
+    frame.interval_us = frame_interval_us;
+    frame.frame = 0;
+    frame_start(get_ticks_us());
+}
+
+bool scheduler_register (const char *name, scheduler_priority_t priority, uint32_t budget_us, scheduler_task_callback_t *callback, void *arg) {
+    if (task_count >= SCHEDULER_MAX_TASKS) {
+        return true;
+    }
+
+    int index = task_count;
+    while ((index > 0) && (tasks[index - 1].priority > priority)) {
+        tasks[index] = tasks[index - 1];
+        index -= 1;
+    }
+
+    tasks[index] = (scheduler_task_t) {
+        .name = name,
+        .priority = priority,
+        .budget_us = budget_us,
+        .callback = callback,
+        .arg = arg,
+        .last_frame = frame.frame,
+    };
+
+    task_count += 1;
+    stats.tasks = task_count;
+
+    return false;
+}
+
+void scheduler_frame_begin (void) {
+    frame_start(get_ticks_us());
+}
+
+bool scheduler_run (void) {
+    bool redraw = false;
+    uint64_t now_us = get_ticks_us();
+
+    if (now_us >= frame.deadline_us) {
+        frame_start(now_us);
+    }
+
+    int queue_depth = 0;
+
+    for (int i = 0; i < task_count; i++) {
+        scheduler_task_t *task = &tasks[i];
+
+        if (!task_runnable(task, now_us)) {
+            queue_depth += task->pending ? 1 : 0;
+            continue;
+        }
+
+        trace_event_begin("scheduler", task->name);
+        int status = task->callback(task->arg);
+        trace_event_end("scheduler", task->name);
+
+        uint64_t end_us = get_ticks_us();
+        uint32_t elapsed_us = (uint32_t) (end_us - now_us);
+        now_us = end_us;
+
+        task->cost_us = (task->cost_us == 0) ? elapsed_us : (((task->cost_us * 7) + elapsed_us) / 8);
+        task->used_us += elapsed_us;
+        task->last_frame = frame.frame;
+        task->pending = (status & SCHEDULER_TASK_PENDING);
+        frame.busy_us += elapsed_us;
+
+        if ((task->priority != SCHEDULER_PRIORITY_AUDIO) && (elapsed_us > task->budget_us)) {
+            stats.overruns += 1;
+        }
+
+        queue_depth += task->pending ? 1 : 0;
+        redraw = redraw || (status & SCHEDULER_TASK_REDRAW);
+    }
+
+    stats.queue_depth = queue_depth;
+
+    return redraw;
+}
+
+scheduler_stats_t *scheduler_get_stats (void) {
+    return &stats;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file scheduler.h
+ * @brief Cooperative background task scheduler
+ * @ingroup menu
+ *
+ * The background work of the menu is split into tasks polled from the main
+ * loop. The audio tasks run first on every iteration, the other tasks run in
+ * priority order in the time left before the next frame, each within its own
+ * time budget per frame.
+ */
+
+#ifndef SCHEDULER_H__
+#define SCHEDULER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Maximum number of registered tasks. */
+#define SCHEDULER_MAX_TASKS     (16)
+
+/** @brief Task priority enumeration, lower values run first. */
+typedef enum {
+    SCHEDULER_PRIORITY_AUDIO,   /**< Audio refill, always runs first and isn't limited by the budget */
+    SCHEDULER_PRIORITY_HIGH,    /**< Latency sensitive work */
+    SCHEDULER_PRIORITY_NORMAL,  /**< Decoding and loading work */
+    SCHEDULER_PRIORITY_LOW,     /**< Work that can wait for idle frames */
+} scheduler_priority_t;
+
+/** @brief Task status bits returned by the task callback. */
+typedef enum {
+    SCHEDULER_TASK_IDLE = 0,            /**< The task has no work queued */
+    SCHEDULER_TASK_PENDING = (1 << 0),  /**< The task has more work queued */
+    SCHEDULER_TASK_REDRAW = (1 << 1),   /**< The task changed something on the screen */
+} scheduler_task_status_t;
+
+/**
+ * @brief Task callback, does a slice of the task work.
+ *
+ * @param arg Argument passed at registration.
+ * @return int Mask of the scheduler_task_status_t bits.
+ */
+typedef int scheduler_task_callback_t (void *arg);
+
+/** @brief Scheduler statistics structure. */
+typedef struct {
+    int tasks;              /**< Number of registered tasks */
+    int queue_depth;        /**< Number of tasks with work queued */
+    uint32_t overruns;      /**< Number of task runs that exceeded the task budget */
+    uint32_t busy_us;       /**< Time spent in the tasks during the last frame in microseconds */
+} scheduler_stats_t;
+
+/**
+ * @brief Initialize the scheduler.
+ *
+ * @param frame_interval_us Interval between the frames in microseconds.
+ */
+void scheduler_init (uint32_t frame_interval_us);
+
+/**
+ * @brief Register a task, tasks of the same priority run in the registration order.
+ *
+ * @param name Task name, shown in the event trace, must stay valid.
+ * @param priority Task priority.
+ * @param budget_us Time the task can use per frame in microseconds, ignored for the audio priority.
+ * @param callback Task callback.
+ * @param arg Argument passed to the callback.
+ * @return true if too many tasks are registered, false otherwise.
+ */
+bool scheduler_register (const char *name, scheduler_priority_t priority, uint32_t budget_us, scheduler_task_callback_t *callback, void *arg);
+
+/**
+ * @brief Start a new frame, the task budgets are reset and the next frame deadline is set.
+ */
+void scheduler_frame_begin (void);
+
+/**
+ * @brief Run the tasks that fit in the time left before the next frame.
+ *
+ * @return true if a task requested a redraw, false otherwise.
+ */
+bool scheduler_run (void);
+
+/**
+ * @brief Get the scheduler statistics.
+ *
+ * @return scheduler_stats_t* Pointer to the statistics.
+ */
+scheduler_stats_t *scheduler_get_stats (void);
+
+#endif /* SCHEDULER_H__ */
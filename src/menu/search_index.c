@@ -0,0 +1,664 @@
+/**
+ * @file search_index.c
+ * @brief Card-wide ROM search index implementation
+ * @ingroup menu
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
+#include <libdragon.h>
+
+#include "file_types.h"
+#include "rom_info.h"
+#include "search_index.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
+
+#define SEARCH_INDEX_MAGIC          (0x53494431) // "SID1"
+
+#define DIRECTORIES_INITIAL         (64)
+#define RECORDS_INITIAL             (512)
+#define NAMES_INITIAL               (KiB(16))
+#define RESULTS_INITIAL             (256)
+
+/** @brief Number of records matched between the budget checks. */
+#define QUERY_BUDGET_CHECK_INTERVAL (64)
+
+#define NO_TITLE                    (UINT32_MAX)
+
+#define RECORD_REMOVED              (1 << 0)
+#define RECORD_TITLE_PENDING        (1 << 1)
+
+/** @brief Search Index File Header Structure. */
+typedef struct {
+    uint32_t magic; /**< Index file magic */
+    uint32_t directories; /**< Number of directories */
+    uint32_t records; /**< Number of file records */
+    uint32_t names_length; /**< Length of the name pool */
+} search_index_header_t;
+
+/** @brief Search Index Record Structure. */
+typedef struct {
+    uint32_t directory; /**< Index of the directory holding the file */
+    uint32_t name_offset; /**< Offset of the file name in the name pool */
+    uint32_t title_offset; /**< Offset of the title in the name pool, NO_TITLE when unknown */
+    char game_code[4]; /**< Game code from the ROM header */
+    uint8_t type; /**< Entry type */
+    uint8_t flags; /**< Record flags */
+    uint16_t reserved; /**< Unused */
+} search_index_record_t;
+
+static char *index_path = NULL;
+static char *storage_prefix = NULL;
+
+static uint32_t *directories = NULL; // Offsets of the directory paths in the name pool
+static uint32_t directories_count = 0;
+static uint32_t directories_capacity = 0;
+
+static search_index_record_t *records = NULL;
+static uint32_t records_count = 0;
+static uint32_t records_capacity = 0;
+static uint32_t records_removed = 0;
+
+static char *names = NULL;
+static uint32_t names_length = 0;
+static uint32_t names_capacity = 0;
+
+static bool crawling = false;
+static DIR crawl_dir;
+static bool crawl_dir_open = false;
+static uint32_t crawl_position = 0;
+static uint32_t title_position = 0;
+static bool save_pending = false;
+static bool dirty = false;
+
+static char query_text[SEARCH_INDEX_QUERY_LENGTH + 1];
+static size_t query_length = 0;
+static uint32_t query_position = 0;
+static int32_t *results = NULL;
+static int32_t results_count = 0;
+static uint32_t results_capacity = 0;
+
+
+static bool reserve (void **buffer, uint32_t *capacity, uint32_t needed, uint32_t initial, size_t element_size) {
+    if (needed <= *capacity) {
+        return false;
+    }
+
+    uint32_t new_capacity = (*capacity > 0) ? *capacity : initial;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void *new_buffer = realloc(*buffer, new_capacity * element_size);
+    if (new_buffer == NULL) {
+        return true;
+    }
+
+    *buffer = new_buffer;
+    *capacity = new_capacity;
+
+    return false;
+}
+
+static bool names_add (const char *string, size_t length, uint32_t *offset) {
+    if (reserve((void **) (&names), &names_capacity, names_length + length + 1, NAMES_INITIAL, sizeof(char))) {
+        return true;
+    }
+
+    *offset = names_length;
+    memcpy(&names[names_length], string, length);
+    names[names_length + length] = '\0';
+    names_length += length + 1;
+
+    return false;
+}
+
+static bool is_indexed_type (entry_type_t type) {
+    return (type == ENTRY_TYPE_ROM) || (type == ENTRY_TYPE_ROM_COMPRESSED) || (type == ENTRY_TYPE_DISK) || (type == ENTRY_TYPE_EMULATOR);
+}
+
+static void query_reset (void) {
+    results_count = 0;
+    query_position = 0;
+}
+
+static bool text_contains (const char *text, size_t text_length, const char *query, size_t length) {
+    if (text_length < length) {
+        return false;
+    }
+
+    for (size_t start = 0; start <= (text_length - length); start++) {
+        if (tolower((uint8_t) (text[start])) != query[0]) {
+            continue;
+        }
+        size_t i = 1;
+        while ((i < length) && (tolower((uint8_t) (text[start + i])) == query[i])) {
+            i++;
+        }
+        if (i == length) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool record_matches (search_index_record_t *record, const char *query, size_t length) {
+    if (record->flags & RECORD_REMOVED) {
+        return false;
+    }
+
+    if (length == 0) {
+        return true;
+    }
+
+    const char *name = &names[record->name_offset];
+    if (text_contains(name, strlen(name), query, length)) {
+        return true;
+    }
+
+    if (record->title_offset != NO_TITLE) {
+        const char *title = &names[record->title_offset];
+        if (text_contains(title, strlen(title), query, length)) {
+            return true;
+        }
+    }
+
+    return text_contains(record->game_code, strnlen(record->game_code, sizeof(record->game_code)), query, length);
+}
+
+static bool results_add (int32_t record) {
+    if (reserve((void **) (&results), &results_capacity, results_count + 1, RESULTS_INITIAL, sizeof(int32_t))) {
+        return true;
+    }
+
+    results[results_count++] = record;
+
+    return false;
+}
+
+static int32_t directory_find (const char *directory) {
+    for (uint32_t i = 0; i < directories_count; i++) {
+        if (strcmp(&names[directories[i]], directory) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool directory_add (const char *directory) {
+    uint32_t offset;
+
+    if (reserve((void **) (&directories), &directories_capacity, directories_count + 1, DIRECTORIES_INITIAL, sizeof(uint32_t))) {
+        return true;
+    }
+
+    if (names_add(directory, strlen(directory), &offset)) {
+        return true;
+    }
+
+    directories[directories_count++] = offset;
+
+    return false;
+}
+
+static bool record_add (uint32_t directory, const char *name, entry_type_t type) {
+    search_index_record_t *record;
+
+    if (reserve((void **) (&records), &records_capacity, records_count + 1, RECORDS_INITIAL, sizeof(search_index_record_t))) {
+        return true;
+    }
+
+    record = &records[records_count];
+    memset(record, 0, sizeof(search_index_record_t));
+
+    if (names_add(name, strlen(name), &record->name_offset)) {
+        return true;
+    }
+
+    record->directory = directory;
+    record->title_offset = NO_TITLE;
+    record->type = type;
+    record->flags = RECORD_TITLE_PENDING;
+
+    records_count += 1;
+    dirty = true;
+
+    return false;
+}
+
+static path_t *record_get_path (search_index_record_t *record) {
+    path_t *path = path_init(storage_prefix, &names[directories[record->directory]]);
+    path_push(path, &names[record->name_offset]);
+    return path;
+}
+
+static void fetch_title (uint32_t index) {
+    search_index_record_t *record = &records[index];
+    rom_info_t rom_info;
+
+    if (!(record->flags & RECORD_TITLE_PENDING)) {
+        return;
+    }
+
+    record->flags &= ~(RECORD_TITLE_PENDING);
+
+    if (record->type != ENTRY_TYPE_ROM) {
+        return;
+    }
+
+    path_t *path = record_get_path(record);
+    rom_err_t err = rom_info_cache_load(path, &rom_info);
+    path_free(path);
+
+    if (err != ROM_OK) {
+        return;
+    }
+
+    size_t length = strnlen(rom_info.title, sizeof(rom_info.title));
+    while ((length > 0) && (rom_info.title[length - 1] == ' ')) {
+        length -= 1;
+    }
+
+    bool matched = record_matches(record, query_text, query_length);
+
+    uint32_t title_offset;
+    if ((length > 0) && !names_add(rom_info.title, length, &title_offset)) {
+        record->title_offset = title_offset;
+    }
+    memcpy(record->game_code, rom_info.game_code, sizeof(record->game_code));
+
+    dirty = true;
+
+    // NOTE: Records already matched by the current query must be matched again now that their title is known
+    if (!matched && (index < query_position) && record_matches(record, query_text, query_length)) {
+        results_add(index);
+    }
+}
+
+static bool is_hidden (uint32_t directory, FILINFO *info) {
+    if ((info->fattrib & (AM_HID | AM_SYS)) || (info->fname[0] == '.')) {
+        return true;
+    }
+
+    if ((info->fattrib & AM_DIR) && (strcmp(info->fname, "saves") == 0)) {
+        return true;
+    }
+
+    if ((directory == 0) && ((strcmp(info->fname, "menu") == 0) || (strcmp(info->fname, "System Volume Information") == 0))) {
+        return true;
+    }
+
+    return false;
+}
+
+static void crawl_next (void) {
+    FILINFO info;
+
+    if (!crawl_dir_open) {
+        if (crawl_position >= directories_count) {
+            crawling = false;
+            save_pending = true;
+            return;
+        }
+        if (f_opendir(&crawl_dir, &names[directories[crawl_position]]) != FR_OK) {
+            crawl_position += 1;
+            return;
+        }
+        crawl_dir_open = true;
+    }
+
+    if ((f_readdir(&crawl_dir, &info) != FR_OK) || (info.fname[0] == '\0')) {
+        f_closedir(&crawl_dir);
+        crawl_dir_open = false;
+        crawl_position += 1;
+        return;
+    }
+
+    if (is_hidden(crawl_position, &info)) {
+        return;
+    }
+
+    if (info.fattrib & AM_DIR) {
+        path_t *directory = path_create(&names[directories[crawl_position]]);
+        path_push(directory, info.fname);
+        directory_add(path_get(directory));
+        path_free(directory);
+    } else {
+        entry_type_t type = file_type_get(info.fname);
+        if (is_indexed_type(type)) {
+            record_add(crawl_position, info.fname, type);
+        }
+    }
+}
+
+static void index_free (void) {
+    if (crawl_dir_open) {
+        f_closedir(&crawl_dir);
+        crawl_dir_open = false;
+    }
+
+    free(directories);
+    directories = NULL;
+    directories_count = 0;
+    directories_capacity = 0;
+
+    free(records);
+    records = NULL;
+    records_count = 0;
+    records_capacity = 0;
+    records_removed = 0;
+
+    free(names);
+    names = NULL;
+    names_length = 0;
+    names_capacity = 0;
+
+    crawling = false;
+    crawl_position = 0;
+    title_position = 0;
+    save_pending = false;
+    dirty = false;
+
+    query_reset();
+}
+
+static bool index_load (void) {
+    FILE *f;
+    search_index_header_t header;
+
+    if ((f = fopen(index_path, "rb")) == NULL) {
+        return true;
+    }
+
+    if ((fread(&header, sizeof(header), 1, f) != 1) || (header.magic != SEARCH_INDEX_MAGIC) || (header.directories == 0) || (header.names_length == 0)) {
+        fclose(f);
+        return true;
+    }
+
+    bool error = (
+        reserve((void **) (&directories), &directories_capacity, header.directories, DIRECTORIES_INITIAL, sizeof(uint32_t)) ||
+        reserve((void **) (&records), &records_capacity, header.records, RECORDS_INITIAL, sizeof(search_index_record_t)) ||
+        reserve((void **) (&names), &names_capacity, header.names_length, NAMES_INITIAL, sizeof(char)) ||
+        (fread(directories, sizeof(uint32_t), header.directories, f) != header.directories) ||
+        (fread(records, sizeof(search_index_record_t), header.records, f) != header.records) ||
+        (fread(names, sizeof(char), header.names_length, f) != header.names_length)
+    );
+
+    fclose(f);
+
+    if (error || (names[header.names_length - 1] != '\0')) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < header.directories; i++) {
+        if (directories[i] >= header.names_length) {
+            return true;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.records; i++) {
+        search_index_record_t *record = &records[i];
+        if ((record->directory >= header.directories) || (record->name_offset >= header.names_length) || ((record->title_offset != NO_TITLE) && (record->title_offset >= header.names_length))) {
+            return true;
+        }
+    }
+
+    directories_count = header.directories;
+    records_count = header.records;
+    names_length = header.names_length;
+
+    return false;
+}
+
+static void index_compact (void) {
+    uint32_t kept = 0;
+    uint32_t kept_before_title_position = 0;
+
+    for (uint32_t i = 0; i < records_count; i++) {
+        if (i == title_position) {
+            kept_before_title_position = kept;
+        }
+        if (!(records[i].flags & RECORD_REMOVED)) {
+            records[kept++] = records[i];
+        }
+    }
+
+    title_position = (title_position >= records_count) ? kept : kept_before_title_position;
+    records_count = kept;
+    records_removed = 0;
+
+    query_reset();
+}
+
+void search_index_init (char *index_location, const char *prefix) {
+    index_free();
+
+    free(index_path);
+    index_path = strdup(index_location);
+
+    free(storage_prefix);
+    storage_prefix = strdup(prefix);
+
+    if (index_load()) {
+        search_index_rebuild();
+    }
+}
+
+void search_index_save (void) {
+    FILE *f;
+
+    if ((index_path == NULL) || crawling || !dirty) {
+        return;
+    }
+
+    if (records_removed > 0) {
+        index_compact();
+    }
+
+    if ((f = fopen(index_path, "wb")) == NULL) {
+        return;
+    }
+
+    search_index_header_t header = {
+        .magic = SEARCH_INDEX_MAGIC,
+        .directories = directories_count,
+        .records = records_count,
+        .names_length = names_length,
+    };
+
+    bool error = (
+        (fwrite(&header, sizeof(header), 1, f) != 1) ||
+        (fwrite(directories, sizeof(uint32_t), directories_count, f) != directories_count) ||
+        (fwrite(records, sizeof(search_index_record_t), records_count, f) != records_count) ||
+        (fwrite(names, sizeof(char), names_length, f) != names_length)
+    );
+
+    if (fclose(f) || error) {
+        remove(index_path);
+        return;
+    }
+
+    dirty = false;
+}
+
+void search_index_rebuild (void) {
+    index_free();
+
+    if (storage_prefix == NULL) {
+        return;
+    }
+
+    if (directory_add("/")) {
+        return;
+    }
+
+    crawling = true;
+}
+
+void search_index_step (uint64_t budget_us) {
+    if (storage_prefix == NULL) {
+        return;
+    }
+
+    uint64_t start = get_ticks_us();
+
+    do {
+        if (crawling) {
+            crawl_next();
+        } else if (title_position < records_count) {
+            fetch_title(title_position++);
+        } else {
+            if (save_pending) {
+                save_pending = false;
+                search_index_save();
+            }
+            return;
+        }
+    } while ((get_ticks_us() - start) < budget_us);
+}
+
+bool search_index_is_complete (void) {
+    return !crawling && (title_position >= records_count);
+}
+
+int32_t search_index_get_entries (void) {
+    return (int32_t) (records_count - records_removed);
+}
+
+void search_index_add (path_t *path) {
+    if (storage_prefix == NULL) {
+        return;
+    }
+
+    char *name = path_last_get(path);
+    entry_type_t type = file_type_get(name);
+    if (!is_indexed_type(type)) {
+        return;
+    }
+
+    // NOTE: Overwritten files would be listed twice otherwise
+    search_index_remove(path);
+
+    path_t *directory = path_clone(path);
+    path_pop(directory);
+    int32_t index = directory_find(strip_fs_prefix(path_get(directory)));
+    path_free(directory);
+
+    // NOTE: Directories that weren't reached by the crawl yet will be listed later, unknown ones are hidden
+    if ((index < 0) || (crawling && ((uint32_t) (index) >= crawl_position))) {
+        return;
+    }
+
+    record_add(index, name, type);
+}
+
+void search_index_remove (path_t *path) {
+    if (storage_prefix == NULL) {
+        return;
+    }
+
+    path_t *directory = path_clone(path);
+    path_pop(directory);
+    int32_t index = directory_find(strip_fs_prefix(path_get(directory)));
+    path_free(directory);
+
+    if (index < 0) {
+        return;
+    }
+
+    char *name = path_last_get(path);
+
+    for (uint32_t i = 0; i < records_count; i++) {
+        search_index_record_t *record = &records[i];
+        if ((record->directory == (uint32_t) (index)) && !(record->flags & RECORD_REMOVED) && (strcmp(&names[record->name_offset], name) == 0)) {
+            record->flags |= RECORD_REMOVED;
+            records_removed += 1;
+            dirty = true;
+            query_reset();
+        }
+    }
+}
+
+void search_index_query (const char *text) {
+    char lowered[SEARCH_INDEX_QUERY_LENGTH + 1];
+    size_t length = strnlen(text, SEARCH_INDEX_QUERY_LENGTH);
+
+    for (size_t i = 0; i < length; i++) {
+        lowered[i] = tolower((uint8_t) (text[i]));
+    }
+    lowered[length] = '\0';
+
+    if ((length == query_length) && (strcmp(lowered, query_text) == 0)) {
+        return;
+    }
+
+    // NOTE: A longer query only matches a subset of the previous results, so the already matched records aren't scanned again
+    if ((length > query_length) && (strncmp(lowered, query_text, query_length) == 0)) {
+        int32_t kept = 0;
+        for (int32_t i = 0; i < results_count; i++) {
+            if (record_matches(&records[results[i]], lowered, length)) {
+                results[kept++] = results[i];
+            }
+        }
+        results_count = kept;
+    } else {
+        query_reset();
+    }
+
+    memcpy(query_text, lowered, length + 1);
+    query_length = length;
+}
+
+void search_index_query_continue (uint64_t budget_us) {
+    uint64_t start = get_ticks_us();
+
+    while (query_position < records_count) {
+        if (record_matches(&records[query_position], query_text, query_length)) {
+            if (results_add(query_position)) {
+                return;
+            }
+        }
+        query_position += 1;
+        if (((query_position % QUERY_BUDGET_CHECK_INTERVAL) == 0) && ((get_ticks_us() - start) >= budget_us)) {
+            return;
+        }
+    }
+}
+
+bool search_index_query_is_complete (void) {
+    return (query_position >= records_count);
+}
+
+int32_t search_index_query_get_results (void) {
+    return results_count;
+}
+
+bool search_index_query_get_result (int32_t index, search_index_result_t *result) {
+    if ((index < 0) || (index >= results_count)) {
+        return true;
+    }
+
+    search_index_record_t *record = &records[results[index]];
+
+    result->name = &names[record->name_offset];
+    result->title = (record->title_offset != NO_TITLE) ? &names[record->title_offset] : "";
+    memcpy(result->game_code, record->game_code, sizeof(record->game_code));
+    result->game_code[sizeof(record->game_code)] = '\0';
+    result->type = (entry_type_t) (record->type);
+
+    return false;
+}
+
+path_t *search_index_query_get_path (int32_t index) {
+    if ((index < 0) || (index >= results_count)) {
+        return NULL;
+    }
+
+    return record_get_path(&records[results[index]]);
+}
@@ -0,0 +1,137 @@
+/**
+ * @file search_index.h
+ * @brief Card-wide ROM search index
+ * @ingroup menu
+ */
+
+#ifndef SEARCH_INDEX_H__
+#define SEARCH_INDEX_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "menu_state.h"
+#include "path.h"
+
+/** @brief Maximum length of a search query. */
+#define SEARCH_INDEX_QUERY_LENGTH   (32)
+
+/** @brief Search Index Result Structure. */
+typedef struct {
+    const char *name; /**< File name */
+    const char *title; /**< Title from the ROM header, empty when unknown */
+    char game_code[5]; /**< Game code from the ROM header, empty when unknown */
+    entry_type_t type; /**< Entry type */
+} search_index_result_t;
+
+/**
+ * @brief Initialize the search index.
+ *
+ * The stored index is loaded from the index file, the card is crawled again when there's no valid index.
+ *
+ * @param index_location Path to the index file.
+ * @param storage_prefix Storage prefix of the indexed card.
+ */
+void search_index_init(char *index_location, const char *storage_prefix);
+
+/**
+ * @brief Store the index in the index file if it changed since it was loaded.
+ *
+ * Nothing is stored while the card is still being crawled.
+ */
+void search_index_save(void);
+
+/**
+ * @brief Drop the index and crawl the whole card again.
+ */
+void search_index_rebuild(void);
+
+/**
+ * @brief Continue building the index.
+ *
+ * A single directory entry or ROM header read can't be interrupted, so the budget is only checked between them.
+ *
+ * @param budget_us Time budget in microseconds.
+ */
+void search_index_step(uint64_t budget_us);
+
+/**
+ * @brief Check if the whole card has been indexed.
+ *
+ * @return true if the index is complete, false otherwise.
+ */
+bool search_index_is_complete(void);
+
+/**
+ * @brief Get the number of indexed files.
+ *
+ * @return Number of indexed files.
+ */
+int32_t search_index_get_entries(void);
+
+/**
+ * @brief Add a file to the index.
+ *
+ * Files of types that aren't indexed are ignored.
+ *
+ * @param path Pointer to the file path.
+ */
+void search_index_add(path_t *path);
+
+/**
+ * @brief Remove a file from the index.
+ *
+ * @param path Pointer to the file path.
+ */
+void search_index_remove(path_t *path);
+
+/**
+ * @brief Start a query, matching the file names and the titles without regard to case.
+ *
+ * When the text extends the previous query, only the previous results are matched again.
+ *
+ * @param text Query text.
+ */
+void search_index_query(const char *text);
+
+/**
+ * @brief Continue matching the current query.
+ *
+ * @param budget_us Time budget in microseconds.
+ */
+void search_index_query_continue(uint64_t budget_us);
+
+/**
+ * @brief Check if the current query has been matched against the whole index.
+ *
+ * @return true if the query is complete, false otherwise.
+ */
+bool search_index_query_is_complete(void);
+
+/**
+ * @brief Get the number of results of the current query.
+ *
+ * @return Number of results.
+ */
+int32_t search_index_query_get_results(void);
+
+/**
+ * @brief Get a result of the current query.
+ *
+ * The strings are valid until the index is modified.
+ *
+ * @param index Index of the result.
+ * @param result Pointer to the result structure.
+ * @return true if the index is out of range, false otherwise.
+ */
+bool search_index_query_get_result(int32_t index, search_index_result_t *result);
+
+/**
+ * @brief Get the path of a result of the current query.
+ *
+ * @param index Index of the result.
+ * @return Pointer to the file path, or NULL if the index is out of range.
+ */
+path_t *search_index_query_get_path(int32_t index);
+
+#endif /* SEARCH_INDEX_H__ */
@@ -1,11 +1,101 @@
+#include <stddef.h>
+
+#include <fatfs/ff.h>
 #include <libdragon.h>
 #include <mini.c/src/mini.h>
 
 #include "settings.h"
 #include "utils/fs.h"
+#include "utils/utils.h"
+
+#define SETTINGS_SNAPSHOT_MAGIC         (0x53455431) // "SET1"
+#define SETTINGS_SNAPSHOT_EXTENSION     "bin"
+#define SETTINGS_JOURNAL_EXTENSION      "jnl"
+#define SETTINGS_FIELDS_MAX             (32)
+#define SETTINGS_STRINGS_MAX            (4)
+#define SETTINGS_STRING_LENGTH          (256)
+#define SETTINGS_JOURNAL_SIZE           (KiB(8))
+#define SETTINGS_JOURNAL_ENTRIES_MAX    (16)
+#define SETTINGS_JOURNAL_LINE_LENGTH    (SETTINGS_STRING_LENGTH + 64)
+
+
+/** @brief Settings field type enumeration. */
+typedef enum {
+    SETTINGS_FIELD_BOOL,
+    SETTINGS_FIELD_INT,
+    SETTINGS_FIELD_STRING,
+} settings_field_type_t;
+
+/** @brief Settings field description structure. */
+typedef struct {
+    const char *group; /**< Group in the ini file */
+    const char *key; /**< Key in the ini file */
+    settings_field_type_t type; /**< Field type */
+    size_t offset; /**< Offset of the field in the settings structure */
+    bool stored; /**< The field is written to the ini file */
+} settings_field_t;
+
+/**
+ * @brief Settings snapshot file structure.
+ *
+ * A fixed layout copy of the ini file contents, valid as long as the ini file timestamp and size match.
+ */
+typedef struct {
+    uint32_t magic; /**< Snapshot magic */
+    uint32_t ini_timestamp; /**< FAT timestamp of the ini file */
+    uint32_t ini_size; /**< Size of the ini file */
+    uint32_t fields; /**< Number of fields */
+    int32_t values[SETTINGS_FIELDS_MAX]; /**< Field values, the string slot for the string fields */
+    char strings[SETTINGS_STRINGS_MAX][SETTINGS_STRING_LENGTH]; /**< String field values */
+} settings_snapshot_t;
+
+#define FIELD(group, key, type, member, stored) { group, key, type, offsetof(settings_t, member), stored }
+
+static const settings_field_t fields[] = {
+    FIELD("menu", "schema_revision", SETTINGS_FIELD_INT, schema_revision, true),
+    FIELD("menu", "first_run", SETTINGS_FIELD_BOOL, first_run, true),
+    FIELD("menu", "pal60", SETTINGS_FIELD_BOOL, pal60_enabled, true), // TODO: consider changing file setting name
+    FIELD("menu", "pal60_compatibility_mode", SETTINGS_FIELD_BOOL, pal60_compatibility_mode, true),
+    FIELD("menu", "force_progressive_scan", SETTINGS_FIELD_BOOL, force_progressive_scan, true),
+    FIELD("menu", "show_protected_entries", SETTINGS_FIELD_BOOL, show_protected_entries, true),
+    FIELD("menu", "default_directory", SETTINGS_FIELD_STRING, default_directory, true),
+    FIELD("menu", "use_saves_folder", SETTINGS_FIELD_BOOL, use_saves_folder, true),
+    FIELD("menu", "show_saves_folder", SETTINGS_FIELD_BOOL, show_saves_folder, true),
+    FIELD("menu", "scroll_acceleration_enabled", SETTINGS_FIELD_BOOL, scroll_acceleration_enabled, true),
+    FIELD("menu", "soundfx_enabled", SETTINGS_FIELD_BOOL, soundfx_enabled, true),
+    FIELD("menu", "rom_settings_store_enabled", SETTINGS_FIELD_BOOL, rom_settings_store_enabled, true),
+    FIELD("menu", "rom_verify_enabled", SETTINGS_FIELD_BOOL, rom_verify_enabled, true),
+    FIELD("menu", "save_backups_enabled", SETTINGS_FIELD_BOOL, save_backups_enabled, true),
+    FIELD("menu", "directory_index_enabled", SETTINGS_FIELD_BOOL, directory_index_enabled, true),
+    FIELD("menu", "mp3_frame_scan_enabled", SETTINGS_FIELD_BOOL, mp3_frame_scan_enabled, true),
+    FIELD("menu", "triple_buffering_enabled", SETTINGS_FIELD_BOOL, triple_buffering_enabled, true),
+#ifdef FEATURE_AUTOLOAD_ROM_ENABLED
+    FIELD("menu", "autoload_rom_enabled", SETTINGS_FIELD_BOOL, rom_autoload_enabled, true),
+    FIELD("autoload", "rom_path", SETTINGS_FIELD_STRING, rom_autoload_path, true),
+    FIELD("autoload", "rom_filename", SETTINGS_FIELD_STRING, rom_autoload_filename, true),
+    FIELD("menu", "loading_progress_bar_enabled", SETTINGS_FIELD_BOOL, loading_progress_bar_enabled, true),
+#else
+    FIELD("menu", "reboot_rom_enabled", SETTINGS_FIELD_BOOL, rom_fast_reboot_enabled, true),
+#endif
+    /* Beta feature flags, they might not be in the file and they should not save until production ready! */
+    FIELD("menu", "show_browser_file_extensions", SETTINGS_FIELD_BOOL, show_browser_file_extensions, false),
+    FIELD("menu", "show_browser_rom_tags", SETTINGS_FIELD_BOOL, show_browser_rom_tags, false),
+    FIELD("menu_beta_flag", "bgm_enabled", SETTINGS_FIELD_BOOL, bgm_enabled, false),
+    FIELD("menu_beta_flag", "rumble_enabled", SETTINGS_FIELD_BOOL, rumble_enabled, false),
+};
+
+#define SETTINGS_FIELDS     (sizeof(fields) / sizeof(fields[0]))
+
+_Static_assert(SETTINGS_FIELDS <= SETTINGS_FIELDS_MAX, "Too many settings fields for the snapshot");
 
 
 static char *settings_path = NULL;
+static char *snapshot_path = NULL;
+static char *journal_path = NULL;
+
+static settings_snapshot_t saved;
+static bool saved_valid = false;
+static int journal_entries = 0;
 
 
 static settings_t init = {
@@ -18,7 +108,14 @@ static settings_t init = {
     .default_directory = "/",
     .use_saves_folder = true,
     .show_saves_folder = false,
+    .scroll_acceleration_enabled = false,
     .soundfx_enabled = false,
+    .rom_settings_store_enabled = false,
+    .rom_verify_enabled = false,
+    .save_backups_enabled = false,
+    .directory_index_enabled = false,
+    .mp3_frame_scan_enabled = true,
+    .triple_buffering_enabled = false,
 #ifdef FEATURE_AUTOLOAD_ROM_ENABLED
     .rom_autoload_enabled = false,
     .rom_autoload_path = "",
@@ -26,7 +123,7 @@ static settings_t init = {
     .loading_progress_bar_enabled = true,
 #else
     .rom_fast_reboot_enabled = false,
-#endif    
+#endif
     /* Beta feature flags (should always init to default) */
     .show_browser_file_extensions = true,
     .show_browser_rom_tags = true,
@@ -35,81 +132,424 @@ static settings_t init = {
 };
 
 
+/**
+ * @brief Get the path of a file kept next to the ini file, with a different extension.
+ *
+ * @param extension New file extension.
+ * @return char* Allocated path, NULL if the memory couldn't be allocated.
+ */
+static char *get_settings_file_path (const char *extension) {
+    char *ini_extension = strrchr(file_basename(settings_path), '.');
+    size_t base_length = ini_extension ? (size_t) (ini_extension - settings_path) : strlen(settings_path);
+    char *path = malloc(base_length + strlen(extension) + 2);
+
+    if (path) {
+        sprintf(path, "%.*s.%s", (int) (base_length), settings_path, extension);
+    }
+
+    return path;
+}
+
+/**
+ * @brief Get the FAT timestamp and size of the ini file.
+ *
+ * @param timestamp Pointer to store the timestamp.
+ * @param size Pointer to store the size.
+ * @return true if the file couldn't be found, false otherwise.
+ */
+static bool get_settings_stamp (uint32_t *timestamp, uint32_t *size) {
+    FILINFO info;
+
+    if (f_stat(strip_fs_prefix(settings_path), &info) != FR_OK) {
+        return true;
+    }
+
+    *timestamp = ((info.fdate << 16) | info.ftime);
+    *size = (uint32_t) (info.fsize);
+
+    return false;
+}
+
+static bool *field_bool (settings_t *settings, int i) {
+    return (bool *) ((uint8_t *) (settings) + fields[i].offset);
+}
+
+static int *field_int (settings_t *settings, int i) {
+    return (int *) ((uint8_t *) (settings) + fields[i].offset);
+}
+
+static char **field_string (settings_t *settings, int i) {
+    return (char **) ((uint8_t *) (settings) + fields[i].offset);
+}
+
+/**
+ * @brief Prepare an empty snapshot, assigning a string slot to every string field.
+ *
+ * @param snapshot Pointer to the snapshot.
+ */
+static void snapshot_clear (settings_snapshot_t *snapshot) {
+    int slot = 0;
+
+    memset(snapshot, 0, sizeof(settings_snapshot_t));
+
+    snapshot->magic = SETTINGS_SNAPSHOT_MAGIC;
+    snapshot->fields = SETTINGS_FIELDS;
+
+    for (int i = 0; i < SETTINGS_FIELDS; i++) {
+        if (fields[i].type == SETTINGS_FIELD_STRING) {
+            assert(slot < SETTINGS_STRINGS_MAX);
+            snapshot->values[i] = slot++;
+        }
+    }
+}
+
+static char *snapshot_string (settings_snapshot_t *snapshot, int i) {
+    return snapshot->strings[snapshot->values[i]];
+}
+
+static void snapshot_set_string (settings_snapshot_t *snapshot, int i, const char *value) {
+    strncpy(snapshot_string(snapshot, i), (value != NULL) ? value : "", SETTINGS_STRING_LENGTH - 1);
+}
+
+/**
+ * @brief Set a snapshot field from its text representation.
+ *
+ * @param snapshot Pointer to the snapshot.
+ * @param i Field index.
+ * @param value Field value text.
+ */
+static void snapshot_set (settings_snapshot_t *snapshot, int i, const char *value) {
+    switch (fields[i].type) {
+        case SETTINGS_FIELD_BOOL: snapshot->values[i] = (atoi(value) != 0); break;
+        case SETTINGS_FIELD_INT: snapshot->values[i] = atoi(value); break;
+        case SETTINGS_FIELD_STRING: snapshot_set_string(snapshot, i, value); break;
+    }
+}
+
+static bool snapshot_field_equal (settings_snapshot_t *a, settings_snapshot_t *b, int i) {
+    if (fields[i].type == SETTINGS_FIELD_STRING) {
+        return (strcmp(snapshot_string(a, i), snapshot_string(b, i)) == 0);
+    }
+    return (a->values[i] == b->values[i]);
+}
+
+static void snapshot_from_settings (settings_snapshot_t *snapshot, settings_t *settings) {
+    snapshot_clear(snapshot);
+
+    for (int i = 0; i < SETTINGS_FIELDS; i++) {
+        switch (fields[i].type) {
+            case SETTINGS_FIELD_BOOL: snapshot->values[i] = *field_bool(settings, i); break;
+            case SETTINGS_FIELD_INT: snapshot->values[i] = *field_int(settings, i); break;
+            case SETTINGS_FIELD_STRING: snapshot_set_string(snapshot, i, *field_string(settings, i)); break;
+        }
+    }
+}
+
+static void snapshot_to_settings (settings_snapshot_t *snapshot, settings_t *settings) {
+    for (int i = 0; i < SETTINGS_FIELDS; i++) {
+        switch (fields[i].type) {
+            case SETTINGS_FIELD_BOOL: *field_bool(settings, i) = (snapshot->values[i] != 0); break;
+            case SETTINGS_FIELD_INT: *field_int(settings, i) = snapshot->values[i]; break;
+            case SETTINGS_FIELD_STRING: *field_string(settings, i) = strdup(snapshot_string(snapshot, i)); break;
+        }
+    }
+}
+
+static void snapshot_from_ini (settings_snapshot_t *snapshot, mini_t *ini) {
+    settings_snapshot_t defaults;
+    snapshot_from_settings(&defaults, &init);
+
+    snapshot_clear(snapshot);
+
+    for (int i = 0; i < SETTINGS_FIELDS; i++) {
+        const settings_field_t *field = &fields[i];
+        switch (field->type) {
+            case SETTINGS_FIELD_BOOL:
+                snapshot->values[i] = mini_get_bool(ini, field->group, field->key, defaults.values[i]);
+                break;
+            case SETTINGS_FIELD_INT:
+                snapshot->values[i] = mini_get_int(ini, field->group, field->key, defaults.values[i]);
+                break;
+            case SETTINGS_FIELD_STRING:
+                snapshot_set_string(snapshot, i, mini_get_string(ini, field->group, field->key, snapshot_string(&defaults, i)));
+                break;
+        }
+    }
+}
+
+static void snapshot_to_ini (settings_snapshot_t *snapshot, mini_t *ini) {
+    for (int i = 0; i < SETTINGS_FIELDS; i++) {
+        const settings_field_t *field = &fields[i];
+        if (!field->stored) {
+            continue;
+        }
+        switch (field->type) {
+            case SETTINGS_FIELD_BOOL: mini_set_bool(ini, field->group, field->key, snapshot->values[i]); break;
+            case SETTINGS_FIELD_INT: mini_set_int(ini, field->group, field->key, snapshot->values[i]); break;
+            case SETTINGS_FIELD_STRING: mini_set_string(ini, field->group, field->key, snapshot_string(snapshot, i)); break;
+        }
+    }
+}
+
+/**
+ * @brief Store the snapshot, stamped with the current ini file timestamp and size.
+ *
+ * @param snapshot Pointer to the snapshot.
+ */
+static void snapshot_save (settings_snapshot_t *snapshot) {
+    if ((snapshot_path == NULL) || get_settings_stamp(&snapshot->ini_timestamp, &snapshot->ini_size)) {
+        return;
+    }
+
+    file_write_all(snapshot_path, snapshot, sizeof(settings_snapshot_t));
+}
+
+/**
+ * @brief Rewrite the whole ini file and the snapshot, dropping the journal.
+ *
+ * @param snapshot Pointer to the settings snapshot.
+ */
+static void settings_save_full (settings_snapshot_t *snapshot) {
+    // NOTE: The fields that aren't written to the ini file keep the values it was loaded with
+    if (saved_valid) {
+        for (int i = 0; i < SETTINGS_FIELDS; i++) {
+            if (!fields[i].stored && (fields[i].type != SETTINGS_FIELD_STRING)) {
+                snapshot->values[i] = saved.values[i];
+            }
+        }
+    }
+
+    mini_t *ini = mini_create(settings_path);
+
+    snapshot_to_ini(snapshot, ini);
+
+    mini_save(ini, MINI_FLAGS_SKIP_EMPTY_GROUPS);
+
+    mini_free(ini);
+
+    snapshot_save(snapshot);
+
+    if ((journal_path != NULL) && ((journal_entries > 0) || file_exists(journal_path))) {
+        remove(journal_path);
+    }
+    journal_entries = 0;
+
+    saved = *snapshot;
+    saved_valid = true;
+}
+
+/**
+ * @brief Replay the journaled changes on top of the loaded settings.
+ *
+ * When the ini file was modified since the journal was written, a field is only changed if it
+ * still holds the value from the outdated snapshot, the ini file edits take precedence.
+ *
+ * @param snapshot Pointer to the loaded settings.
+ * @param base Pointer to the outdated snapshot, NULL if the snapshot is current.
+ * @param present Pointer to store if a journal was found.
+ * @return int Number of applied changes.
+ */
+static int journal_replay (settings_snapshot_t *snapshot, settings_snapshot_t *base, bool *present) {
+    size_t length;
+    int applied = 0;
+
+    *present = false;
+
+    if ((journal_path == NULL) || !file_exists(journal_path)) {
+        return 0;
+    }
+
+    *present = true;
+
+    char *journal = malloc(SETTINGS_JOURNAL_SIZE + 1);
+    if ((journal == NULL) || file_read_all(journal_path, journal, SETTINGS_JOURNAL_SIZE, &length)) {
+        free(journal);
+        return 0;
+    }
+    journal[length] = '\0';
+
+    char *line = journal;
+    while (*line != '\0') {
+        char *end = strchr(line, '\n');
+        char *next = (end != NULL) ? (end + 1) : (line + strlen(line));
+        if (end != NULL) {
+            *end = '\0';
+        }
+
+        char *separator = strchr(line, '=');
+        char *dot = strchr(line, '.');
+        if ((separator != NULL) && (dot != NULL) && (dot < separator)) {
+            *dot = '\0';
+            *separator = '\0';
+            for (int i = 0; i < SETTINGS_FIELDS; i++) {
+                if (!fields[i].stored || (strcmp(fields[i].group, line) != 0) || (strcmp(fields[i].key, dot + 1) != 0)) {
+                    continue;
+                }
+                if ((base == NULL) || snapshot_field_equal(snapshot, base, i)) {
+                    snapshot_set(snapshot, i, separator + 1);
+                    // NOTE: The base follows the applied changes, so the later changes of the same field are applied too
+                    if (base != NULL) {
+                        snapshot_set(base, i, separator + 1);
+                    }
+                    applied += 1;
+                }
+                break;
+            }
+        }
+
+        line = next;
+    }
+
+    free(journal);
+
+    return applied;
+}
+
+/**
+ * @brief Append the fields changed since the last save to the journal.
+ *
+ * @param snapshot Pointer to the current settings.
+ * @return true if the changes couldn't be journaled, false otherwise.
+ */
+static bool journal_append (settings_snapshot_t *snapshot) {
+    char *buffer = malloc(SETTINGS_JOURNAL_LINE_LENGTH * SETTINGS_JOURNAL_ENTRIES_MAX);
+    size_t length = 0;
+    int changes = 0;
+
+    if (buffer == NULL) {
+        return true;
+    }
+
+    for (int i = 0; i < SETTINGS_FIELDS; i++) {
+        if (!fields[i].stored || snapshot_field_equal(snapshot, &saved, i)) {
+            continue;
+        }
+        if ((journal_entries + (++changes)) > SETTINGS_JOURNAL_ENTRIES_MAX) {
+            free(buffer);
+            return true;
+        }
+        if (fields[i].type == SETTINGS_FIELD_STRING) {
+            length += sprintf(&buffer[length], "%s.%s=%s\n", fields[i].group, fields[i].key, snapshot_string(snapshot, i));
+        } else {
+            length += sprintf(&buffer[length], "%s.%s=%d\n", fields[i].group, fields[i].key, (int) (snapshot->values[i]));
+        }
+    }
+
+    bool error = (length > 0) && file_append(journal_path, buffer, length);
+
+    free(buffer);
+
+    if (!error) {
+        journal_entries += changes;
+    }
+
+    return error;
+}
+
+
 void settings_init (char *path) {
     if (settings_path) {
         free(settings_path);
+        free(snapshot_path);
+        free(journal_path);
     }
     settings_path = strdup(path);
+    snapshot_path = get_settings_file_path(SETTINGS_SNAPSHOT_EXTENSION);
+    journal_path = get_settings_file_path(SETTINGS_JOURNAL_EXTENSION);
+    saved_valid = false;
+    journal_entries = 0;
 }
 
 void settings_load (settings_t *settings) {
+    settings_snapshot_t *snapshot = malloc(sizeof(settings_snapshot_t));
+    settings_snapshot_t *stored = malloc(sizeof(settings_snapshot_t));
+    assert((snapshot != NULL) && (stored != NULL));
+
     if (!file_exists(settings_path)) {
-        settings_save(&init);
-    }
-
-    mini_t *ini = mini_try_load(settings_path);
-
-    settings->schema_revision = mini_get_int(ini, "menu", "schema_revision", init.schema_revision);
-    settings->first_run = mini_get_bool(ini, "menu", "first_run", init.first_run);
-    settings->pal60_enabled = mini_get_bool(ini, "menu", "pal60", init.pal60_enabled); // TODO: consider changing file setting name
-    settings->pal60_compatibility_mode = mini_get_bool(ini, "menu", "pal60_compatibility_mode", init.pal60_compatibility_mode);
-    settings->force_progressive_scan = mini_get_bool(ini, "menu", "force_progressive_scan", init.force_progressive_scan);
-    settings->show_protected_entries = mini_get_bool(ini, "menu", "show_protected_entries", init.show_protected_entries);
-    settings->default_directory = strdup(mini_get_string(ini, "menu", "default_directory", init.default_directory));
-    settings->use_saves_folder = mini_get_bool(ini, "menu", "use_saves_folder", init.use_saves_folder);
-    settings->show_saves_folder = mini_get_bool(ini, "menu", "show_saves_folder", init.show_saves_folder);
-    settings->soundfx_enabled = mini_get_bool(ini, "menu", "soundfx_enabled", init.soundfx_enabled);
-    
-#ifdef FEATURE_AUTOLOAD_ROM_ENABLED
-    settings->rom_autoload_enabled = mini_get_bool(ini, "menu", "autoload_rom_enabled", init.rom_autoload_enabled);
-    settings->rom_autoload_path = strdup(mini_get_string(ini, "autoload", "rom_path", init.rom_autoload_path));
-    settings->rom_autoload_filename = strdup(mini_get_string(ini, "autoload", "rom_filename", init.rom_autoload_filename));
-    settings->loading_progress_bar_enabled = mini_get_bool(ini, "menu", "loading_progress_bar_enabled", init.loading_progress_bar_enabled);
-#else
-    settings->rom_fast_reboot_enabled = mini_get_bool(ini, "menu", "reboot_rom_enabled", init.rom_fast_reboot_enabled);
-#endif
-    /* Beta feature flags, they might not be in the file */
-    settings->show_browser_file_extensions = mini_get_bool(ini, "menu", "show_browser_file_extensions", init.show_browser_file_extensions);
-    settings->show_browser_rom_tags = mini_get_bool(ini, "menu", "show_browser_rom_tags", init.show_browser_rom_tags);
-    settings->bgm_enabled = mini_get_bool(ini, "menu_beta_flag", "bgm_enabled", init.bgm_enabled);
-    settings->rumble_enabled = mini_get_bool(ini, "menu_beta_flag", "rumble_enabled", init.rumble_enabled);
+        saved_valid = false;
+        snapshot_from_settings(snapshot, &init);
+        settings_save_full(snapshot);
+    }
 
-    mini_free(ini);
+    uint32_t timestamp = 0, size = 0;
+    bool stamp_error = get_settings_stamp(&timestamp, &size);
+
+    bool stored_valid = (snapshot_path != NULL) &&
+        !file_read_range(snapshot_path, 0, stored, sizeof(settings_snapshot_t)) &&
+        (stored->magic == SETTINGS_SNAPSHOT_MAGIC) &&
+        (stored->fields == SETTINGS_FIELDS);
+    bool current = stored_valid && !stamp_error && (stored->ini_timestamp == timestamp) && (stored->ini_size == size);
+
+    if (current) {
+        *snapshot = *stored;
+    } else {
+        mini_t *ini = mini_try_load(settings_path);
+        snapshot_from_ini(snapshot, ini);
+        mini_free(ini);
+    }
+
+    // NOTE: Without any snapshot there's nothing to tell the journaled changes and the ini file edits apart, the ini file wins
+    bool journal_present = false;
+    int applied = 0;
+    if (stored_valid) {
+        applied = journal_replay(snapshot, current ? NULL : stored, &journal_present);
+    } else {
+        journal_present = (journal_path != NULL) && file_exists(journal_path);
+    }
+
+    saved = *snapshot;
+    saved_valid = true;
+
+    if (applied > 0) {
+        settings_save_full(snapshot);
+    } else {
+        if (journal_present) {
+            remove(journal_path);
+        }
+        journal_entries = 0;
+        if (!current) {
+            snapshot_save(snapshot);
+        }
+    }
+
+    snapshot_to_settings(snapshot, settings);
+
+    free(stored);
+    free(snapshot);
 }
 
 void settings_save (settings_t *settings) {
-    mini_t *ini = mini_create(settings_path);
-
-    mini_set_int(ini, "menu", "schema_revision", settings->schema_revision);
-    mini_set_bool(ini, "menu", "first_run", settings->first_run);
-    mini_set_bool(ini, "menu", "pal60", settings->pal60_enabled);
-    mini_set_bool(ini, "menu", "pal60_compatibility_mode", settings->pal60_compatibility_mode);
-    mini_set_bool(ini, "menu", "force_progressive_scan", settings->force_progressive_scan);
-    mini_set_bool(ini, "menu", "show_protected_entries", settings->show_protected_entries);
-    mini_set_string(ini, "menu", "default_directory", settings->default_directory);
-    mini_set_bool(ini, "menu", "use_saves_folder", settings->use_saves_folder);
-    mini_set_bool(ini, "menu", "show_saves_folder", settings->show_saves_folder);
-    mini_set_bool(ini, "menu", "soundfx_enabled", settings->soundfx_enabled);
-#ifdef FEATURE_AUTOLOAD_ROM_ENABLED
-    mini_set_bool(ini, "menu", "autoload_rom_enabled", settings->rom_autoload_enabled);
-    mini_set_string(ini, "autoload", "rom_path", settings->rom_autoload_path);
-    mini_set_string(ini, "autoload", "rom_filename", settings->rom_autoload_filename);
-    mini_set_bool(ini, "menu", "loading_progress_bar_enabled", settings->loading_progress_bar_enabled);
-#else
-    mini_set_bool(ini, "menu", "reboot_rom_enabled", settings->rom_fast_reboot_enabled);
-#endif
+    settings_snapshot_t *snapshot = malloc(sizeof(settings_snapshot_t));
+    assert(snapshot != NULL);
 
-    /* Beta feature flags, they should not save until production ready! */
-    // mini_set_bool(ini, "menu", "show_browser_file_extensions", settings->show_browser_file_extensions);
-    // mini_set_bool(ini, "menu", "show_browser_rom_tags", settings->show_browser_rom_tags);
-    // mini_set_bool(ini, "menu_beta_flag", "bgm_enabled", settings->bgm_enabled);
-    // mini_set_bool(ini, "menu_beta_flag", "rumble_enabled", settings->rumble_enabled);
+    snapshot_from_settings(snapshot, settings);
 
-    mini_save(ini, MINI_FLAGS_SKIP_EMPTY_GROUPS);
+    // NOTE: Single changes are journaled, the ini file is only rewritten when the journal is full
+    if (!saved_valid || (journal_path == NULL) || journal_append(snapshot)) {
+        settings_save_full(snapshot);
+    } else {
+        for (int i = 0; i < SETTINGS_FIELDS; i++) {
+            if (fields[i].stored) {
+                if (fields[i].type == SETTINGS_FIELD_STRING) {
+                    snapshot_set_string(&saved, i, snapshot_string(snapshot, i));
+                } else {
+                    saved.values[i] = snapshot->values[i];
+                }
+            }
+        }
+    }
 
-    mini_free(ini);
+    free(snapshot);
 }
 
 void settings_reset_to_defaults() {
     remove(settings_path);
-}
\ No newline at end of file
+    if (snapshot_path) {
+        remove(snapshot_path);
+    }
+    if (journal_path) {
+        remove(journal_path);
+    }
+    saved_valid = false;
+    journal_entries = 0;
+}
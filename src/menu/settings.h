@@ -37,6 +37,9 @@ typedef struct {
     /** @brief Show saves folder in file browser */ 
     bool show_saves_folder;
 
+    /** @brief Scroll faster the longer a direction is held */
+    bool scroll_acceleration_enabled;
+
     /** @brief Hide rom file extensions */    
     bool show_browser_file_extensions;
 
@@ -52,6 +55,24 @@ typedef struct {
     /** @brief Enable rumble feedback within the menu */
     bool rumble_enabled;
 
+    /** @brief Keep the per-ROM settings in a single file in the menu directory instead of ini files next to the ROMs */
+    bool rom_settings_store_enabled;
+
+    /** @brief Verify the ROM checksum while it is loaded */
+    bool rom_verify_enabled;
+
+    /** @brief Keep rolling backups of the save file, refreshed before the ROM boots */
+    bool save_backups_enabled;
+
+    /** @brief Keep an index file of the large directory listings in the menu cache directory */
+    bool directory_index_enabled;
+
+    /** @brief Walk the frame headers of the MP3 files in the background, for the exact duration and seeking */
+    bool mp3_frame_scan_enabled;
+
+    /** @brief Allocate a third display buffer, so a slow frame doesn't stall the next one */
+    bool triple_buffering_enabled;
+
 #ifdef FEATURE_AUTOLOAD_ROM_ENABLED
     /** @brief Show progress bar when loading a ROM */
     bool loading_progress_bar_enabled;
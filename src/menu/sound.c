@@ -6,6 +6,7 @@
 
 #include <stdbool.h>
 #include <libdragon.h>
+#include "bgm.h"
 #include "mp3_player.h"
 #include "sound.h"
 
@@ -13,11 +14,36 @@
 #define NUM_BUFFERS         (4)
 #define NUM_CHANNELS        (16)
 
-static wav64_t sfx_cursor, sfx_error, sfx_enter, sfx_exit, sfx_setting;
+/** @brief Sound effect Structure. */
+typedef struct {
+    const char *path; /**< Path to the effect file */
+    wav64_t wave; /**< Opened effect */
+    bool opened; /**< The effect file has been opened */
+} sound_sfx_t;
+
+static sound_sfx_t sfx_bank[] = {
+    [SFX_CURSOR] = { .path = "rom:/cursorsound.wav64" },
+    [SFX_ERROR] = { .path = "rom:/error.wav64" },
+    [SFX_ENTER] = { .path = "rom:/enter.wav64" },
+    [SFX_EXIT] = { .path = "rom:/back.wav64" },
+    [SFX_SETTING] = { .path = "rom:/settings.wav64" },
+};
 
 static bool sound_initialized = false;
 static bool sfx_enabled = false;
 
+/**
+ * @brief Close the sound effects that have been opened.
+ */
+static void sound_close_sfx (void) {
+    for (int i = 0; i < (sizeof(sfx_bank) / sizeof(sfx_bank[0])); i++) {
+        if (sfx_bank[i].opened) {
+            wav64_close(&sfx_bank[i].wave);
+            sfx_bank[i].opened = false;
+        }
+    }
+}
+
 /**
  * @brief Reconfigure the sound system with the specified frequency.
  * 
@@ -41,6 +67,8 @@ static void sound_reconfigure (int frequency) {
         if (sfx_enabled) {
             sound_init_sfx();
         }
+
+        bgm_mixer_init();
     }
 }
 
@@ -66,11 +94,7 @@ void sound_init_sfx (void) {
     // global mixer/sample rate was reconfigured to a lower value for MP3.
     mixer_ch_set_limits(SOUND_SFX_CHANNEL, 16, DEFAULT_FREQUENCY, 0);
     mixer_ch_set_vol(SOUND_SFX_CHANNEL, 0.5f, 0.5f);
-    wav64_open(&sfx_cursor, "rom:/cursorsound.wav64");
-    wav64_open(&sfx_exit, "rom:/back.wav64");
-    wav64_open(&sfx_setting, "rom:/settings.wav64");
-    wav64_open(&sfx_enter, "rom:/enter.wav64");
-    wav64_open(&sfx_error, "rom:/error.wav64");
+    // NOTE: The effect files are opened on their first use, so disabled effects never touch the DFS
     sfx_enabled = true;
 }
 
@@ -89,27 +113,18 @@ void sound_use_sfx(bool state) {
  * @param sfx The sound effect to play.
  */
 void sound_play_effect(sound_effect_t sfx) {
-    if(sfx_enabled) {
-        switch (sfx) {
-            case SFX_CURSOR:
-                wav64_play(&sfx_cursor, SOUND_SFX_CHANNEL);
-                break;
-            case SFX_EXIT:
-                wav64_play(&sfx_exit, SOUND_SFX_CHANNEL);
-                break;
-            case SFX_SETTING:
-                wav64_play(&sfx_setting, SOUND_SFX_CHANNEL);
-                break;
-            case SFX_ENTER:
-                wav64_play(&sfx_enter, SOUND_SFX_CHANNEL);
-                break;
-            case SFX_ERROR:
-                wav64_play(&sfx_error, SOUND_SFX_CHANNEL);
-                break;
-            default:
-                break;
-        } 
+    if (!sfx_enabled || !sound_initialized || (sfx < 0) || (sfx >= (sizeof(sfx_bank) / sizeof(sfx_bank[0])))) {
+        return;
     }
+
+    sound_sfx_t *effect = &sfx_bank[sfx];
+
+    if (!effect->opened) {
+        wav64_open(&effect->wave, effect->path);
+        effect->opened = true;
+    }
+
+    wav64_play(&effect->wave, SOUND_SFX_CHANNEL);
 }
 
 /**
@@ -117,13 +132,7 @@ void sound_play_effect(sound_effect_t sfx) {
  */
 void sound_deinit (void) {
     if (sound_initialized) {
-        if (sfx_enabled) {
-            wav64_close(&sfx_cursor);
-            wav64_close(&sfx_exit);
-            wav64_close(&sfx_setting);
-            wav64_close(&sfx_enter);
-            wav64_close(&sfx_error);
-        }
+        sound_close_sfx();
         mixer_close();
         audio_close();
         sound_initialized = false;
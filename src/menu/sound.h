@@ -11,6 +11,7 @@
 
 #define SOUND_SFX_CHANNEL           (0) /**< Channel for sound effects */
 #define SOUND_MP3_PLAYER_CHANNEL    (2) /**< Channel for MP3 player sound */
+#define SOUND_BGM_CHANNEL           (4) /**< Channel for background music */
 
 
 /**
@@ -0,0 +1,191 @@
+/**
+ * @file telemetry.c
+ * @brief USB performance telemetry stream implementation
+ * @ingroup menu
+ */
+
+// NOTE: Records are packed into a buffer sent as one raw binary USB packet,
+//       every record starts with the same header and all fields are big-endian:
+//         u8 type, u8 length (including the header), u16 sequence, u32 timestamp (us)
+//       Frame:  u32 frame time (us), u32 CPU time (us), u8 RDP busy (%), u8 padding, u16 input latency (ms)
+//       Phase:  u32 duration (us), u8 depth, u8 name length, char[] name
+//       Status: u32 heap used, u32 heap total, u16 decoder jobs, u16 padding,
+//               u32 SD bytes transferred and u32 SD busy time (us) since the previous status record
+
+#include <string.h>
+
+#include <libdragon.h>
+#include <usb.h>
+
+#include "png_decoder.h"
+#include "telemetry.h"
+#include "utils/fs.h"
+#include "utils/trace.h"
+#include "utils/utils.h"
+
+#define TELEMETRY_BUFFER_SIZE       (512)
+#define TELEMETRY_HEADER_SIZE       (8)
+#define TELEMETRY_RECORD_SIZE_MAX   (TELEMETRY_HEADER_SIZE + 6 + TRACE_NAME_LENGTH)
+#define STATUS_INTERVAL_MIN_MS      (10)
+
+/** @brief Telemetry stream state Structure. */
+static struct {
+    uint32_t channels; /**< Subscribed channels */
+    uint64_t status_interval_us; /**< Interval between the status records */
+    uint64_t status_last_us; /**< Time of the last status record */
+    fs_stats_t status_last_stats; /**< File helper statistics at the last status record */
+    uint16_t sequence; /**< Sequence number of the next record, lets the host detect dropped packets */
+    uint8_t buffer[TELEMETRY_BUFFER_SIZE]; /**< Pending records */
+    size_t length; /**< Length of the pending records */
+} telemetry;
+
+
+static uint8_t *put_u8 (uint8_t *p, uint8_t value) {
+    *p++ = value;
+    return p;
+}
+
+static uint8_t *put_u16 (uint8_t *p, uint16_t value) {
+    *p++ = (uint8_t) (value >> 8);
+    *p++ = (uint8_t) (value);
+    return p;
+}
+
+static uint8_t *put_u32 (uint8_t *p, uint32_t value) {
+    *p++ = (uint8_t) (value >> 24);
+    *p++ = (uint8_t) (value >> 16);
+    *p++ = (uint8_t) (value >> 8);
+    *p++ = (uint8_t) (value);
+    return p;
+}
+
+/**
+ * @brief Send the pending records.
+ */
+static void telemetry_flush (void) {
+    if (telemetry.length > 0) {
+        usb_write(DATATYPE_RAWBINARY, telemetry.buffer, telemetry.length);
+        telemetry.length = 0;
+    }
+}
+
+/**
+ * @brief Start a new record, the pending records are sent first when the buffer is full.
+ *
+ * @param type Record type.
+ * @return uint8_t* Pointer to the record payload.
+ */
+static uint8_t *record_begin (telemetry_record_type_t type) {
+    if ((telemetry.length + TELEMETRY_RECORD_SIZE_MAX) > TELEMETRY_BUFFER_SIZE) {
+        telemetry_flush();
+    }
+
+    uint8_t *p = &telemetry.buffer[telemetry.length];
+    p = put_u8(p, type);
+    p = put_u8(p, 0);
+    p = put_u16(p, telemetry.sequence++);
+    p = put_u32(p, (uint32_t) (get_ticks_us()));
+
+    return p;
+}
+
+/**
+ * @brief Finish the record and store its length.
+ *
+ * @param end Pointer past the last written byte.
+ */
+static void record_end (uint8_t *end) {
+    uint8_t *record = &telemetry.buffer[telemetry.length];
+    size_t length = (size_t) (end - record);
+
+    record[1] = (uint8_t) (length);
+    telemetry.length += length;
+}
+
+/**
+ * @brief Record an ended trace phase.
+ *
+ * @param phase Pointer to the ended phase.
+ */
+static void telemetry_phase (const trace_phase_t *phase) {
+    size_t name_length = strnlen(phase->name, TRACE_NAME_LENGTH);
+
+    uint8_t *p = record_begin(TELEMETRY_RECORD_PHASE);
+    p = put_u32(p, phase->duration_us);
+    p = put_u8(p, phase->depth);
+    p = put_u8(p, (uint8_t) (name_length));
+    memcpy(p, phase->name, name_length);
+    record_end(p + name_length);
+}
+
+/**
+ * @brief Record the heap, decoder queue and SD counters.
+ *
+ * @param now_us Current time in microseconds.
+ */
+static void telemetry_status (uint64_t now_us) {
+    heap_stats_t heap;
+    sys_get_heap_stats(&heap);
+
+    fs_stats_t *stats = fs_get_stats();
+    uint64_t bytes = (stats->read_bytes + stats->written_bytes) - (telemetry.status_last_stats.read_bytes + telemetry.status_last_stats.written_bytes);
+    uint64_t busy_us = stats->busy_us - telemetry.status_last_stats.busy_us;
+
+    uint8_t *p = record_begin(TELEMETRY_RECORD_STATUS);
+    p = put_u32(p, (uint32_t) (heap.used));
+    p = put_u32(p, (uint32_t) (heap.total));
+    p = put_u16(p, (uint16_t) (png_decoder_get_jobs()));
+    p = put_u16(p, 0);
+    p = put_u32(p, (uint32_t) (bytes));
+    p = put_u32(p, (uint32_t) (busy_us));
+    record_end(p);
+
+    telemetry.status_last_us = now_us;
+    telemetry.status_last_stats = *stats;
+}
+
+
+void telemetry_subscribe (uint32_t channels, uint32_t status_interval_ms) {
+    telemetry_flush();
+
+    telemetry.channels = (channels & TELEMETRY_CHANNEL_ALL);
+    telemetry.status_interval_us = (uint64_t) (MAX(status_interval_ms, STATUS_INTERVAL_MIN_MS)) * 1000;
+    telemetry.status_last_us = get_ticks_us();
+    telemetry.status_last_stats = *fs_get_stats();
+
+    // NOTE: The tracer only calls back while the phase channel is subscribed, so an idle stream costs nothing
+    trace_set_phase_listener(telemetry_is_subscribed(TELEMETRY_CHANNEL_PHASE) ? telemetry_phase : NULL);
+}
+
+bool telemetry_is_subscribed (telemetry_channel_t channel) {
+    return (telemetry.channels & channel);
+}
+
+void telemetry_frame (uint32_t frame_us, uint32_t cpu_us, int rdp_busy, uint32_t input_ms) {
+    if (!telemetry_is_subscribed(TELEMETRY_CHANNEL_FRAME)) {
+        return;
+    }
+
+    uint8_t *p = record_begin(TELEMETRY_RECORD_FRAME);
+    p = put_u32(p, frame_us);
+    p = put_u32(p, cpu_us);
+    p = put_u8(p, (uint8_t) (MIN(MAX(rdp_busy, 0), 100)));
+    p = put_u8(p, 0);
+    p = put_u16(p, (uint16_t) (MIN(input_ms, UINT16_MAX)));
+    record_end(p);
+}
+
+void telemetry_poll (void) {
+    if (telemetry.channels == 0) {
+        return;
+    }
+
+    if (telemetry_is_subscribed(TELEMETRY_CHANNEL_STATUS)) {
+        uint64_t now_us = get_ticks_us();
+        if ((now_us - telemetry.status_last_us) >= telemetry.status_interval_us) {
+            telemetry_status(now_us);
+        }
+    }
+
+    telemetry_flush();
+}
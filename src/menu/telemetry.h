@@ -0,0 +1,62 @@
+/**
+ * @file telemetry.h
+ * @brief USB performance telemetry stream
+ * @ingroup menu
+ *
+ * The performance counters are streamed over USB as compact binary records,
+ * only while a host is subscribed to them.
+ */
+
+#ifndef TELEMETRY_H__
+#define TELEMETRY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Telemetry channel bits, used as the subscription mask. */
+typedef enum {
+    TELEMETRY_CHANNEL_FRAME = (1 << 0),   /**< Frame, CPU and RDP times of every frame */
+    TELEMETRY_CHANNEL_PHASE = (1 << 1),   /**< Durations of the traced load and startup phases */
+    TELEMETRY_CHANNEL_STATUS = (1 << 2),  /**< Periodic heap, decoder queue and SD throughput counters */
+    TELEMETRY_CHANNEL_ALL = (TELEMETRY_CHANNEL_FRAME | TELEMETRY_CHANNEL_PHASE | TELEMETRY_CHANNEL_STATUS),
+} telemetry_channel_t;
+
+/** @brief Telemetry record types. */
+typedef enum {
+    TELEMETRY_RECORD_FRAME = 1,   /**< Frame record */
+    TELEMETRY_RECORD_PHASE = 2,   /**< Phase record */
+    TELEMETRY_RECORD_STATUS = 3,  /**< Status record */
+} telemetry_record_type_t;
+
+/**
+ * @brief Subscribe to the telemetry channels, replacing the previous subscription.
+ *
+ * @param channels Mask of the telemetry_channel_t bits, 0 stops the stream.
+ * @param status_interval_ms Interval between the status records in milliseconds.
+ */
+void telemetry_subscribe (uint32_t channels, uint32_t status_interval_ms);
+
+/**
+ * @brief Check if a telemetry channel is subscribed.
+ *
+ * @param channel Channel bit.
+ * @return true if the channel is subscribed, false otherwise.
+ */
+bool telemetry_is_subscribed (telemetry_channel_t channel);
+
+/**
+ * @brief Record the times of the last frame.
+ *
+ * @param frame_us Frame time in microseconds.
+ * @param cpu_us CPU time spent on the frame in microseconds.
+ * @param rdp_busy RDP pipeline busy percentage.
+ * @param input_ms Input-to-display latency of the last input in milliseconds, 0 when no input was shown.
+ */
+void telemetry_frame (uint32_t frame_us, uint32_t cpu_us, int rdp_busy, uint32_t input_ms);
+
+/**
+ * @brief Send the pending records and the periodic status record.
+ */
+void telemetry_poll (void);
+
+#endif /* TELEMETRY_H__ */
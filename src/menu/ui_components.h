@@ -10,6 +10,7 @@
 #include <libdragon.h>
 #include "menu_state.h"
 #include "fonts.h"
+#include "png_decoder.h"
 
 
 /** 
@@ -43,6 +44,7 @@ typedef struct {
     uint64_t size;                      /**< File size in bytes */
     uint64_t compressed;                /**< File size in bytes while compressed */
     uint32_t crc32;                     /**< Checksum for compressed files */
+    int32_t fragments;                  /**< Number of fragments of the file on the SD card, 0 when unknown */
     bool is_controller_pak_dump;        /**< file is a controller pak dump */
     bool is_controller_pak_dump_note;   /**< file is a controller pak dump note */
 } file_info_t;
@@ -68,6 +70,35 @@ void ui_components_box_draw(int x0, int y0, int x1, int y1, color_t color);
  */
 void ui_components_border_draw(int x0, int y0, int x1, int y1);
 
+/**
+ * @brief Toggle the performance overlay.
+ */
+void ui_components_perf_hud_toggle(void);
+
+/**
+ * @brief Mark the start of a frame for the performance overlay.
+ * 
+ * Called by the menu loop before the view draws the frame.
+ */
+void ui_components_perf_hud_frame_begin(void);
+
+/**
+ * @brief Set the time of the input the frame responds to.
+ * 
+ * The latency is measured from the input to the start of the scanout of the frame.
+ * 
+ * @param input_us Time of the input in microseconds, 0 when the frame doesn't respond to any input.
+ */
+void ui_components_perf_hud_input(uint64_t input_us);
+
+/**
+ * @brief Finish the frame, detach the RDP and show the display.
+ * 
+ * The performance overlay is drawn on top of the view when it's enabled.
+ * Views call this instead of rdpq_detach_show.
+ */
+void ui_components_detach_show(void);
+
 /**
  * @brief Draw the layout component with tabs.
  */
@@ -176,6 +207,15 @@ void ui_components_background_init(char *cache_location);
  */
 void ui_components_background_free(void);
 
+/**
+ * @brief Continue loading the cached background image.
+ *
+ * The first frames are drawn with the flat background color until the image is loaded.
+ *
+ * @return true if the image was loaded by this call and the screen must be redrawn, false otherwise.
+ */
+bool ui_components_background_poll(void);
+
 /**
  * @brief Replace the background image.
  * 
@@ -194,8 +234,16 @@ void ui_components_background_draw(void);
  * @param list List of entries.
  * @param entries Number of entries.
  * @param selected Index of the selected entry.
+ * @param show_tags Show the ROM tags of the entries next to their sizes.
  */
-void ui_components_file_list_draw(entry_t *list, int entries, int selected);
+void ui_components_file_list_draw(entry_t *list, int entries, int selected, bool show_tags);
+
+/**
+ * @brief Drop the cached rendering of the file list.
+ *
+ * Must be called whenever the entries of a drawn list change in place.
+ */
+void ui_components_file_list_invalidate(void);
 
 /**
  * @brief Context menu structure.
@@ -252,6 +300,11 @@ void ui_components_context_menu_draw(component_context_menu_t *cm);
  */
 typedef struct {
     bool loading; /**< Flag to indicate if the box art is loading */
+    png_job_t job; /**< PNG decoder job handle */
+    char *cache_location; /**< Path to the decoded image cache file */
+    uint32_t source_size; /**< Size of the source PNG file */
+    uint32_t source_timestamp; /**< FAT timestamp of the source PNG file */
+    uint64_t source_hash; /**< Hash of the source PNG path */
     surface_t *image; /**< Pointer to the box art image */
 } component_boxart_t;
 
@@ -280,6 +333,14 @@ void ui_components_boxart_free(component_boxart_t *b);
  */
 void ui_components_boxart_draw(component_boxart_t *b);
 
+/**
+ * @brief Free all recently shown box art images kept in memory.
+ * 
+ * Images of freed box art components are kept for a quick reload, within a budget that depends on the Expansion Pak presence.
+ * Call this before large allocations.
+ */
+void ui_components_boxart_cache_flush(void);
+
 /**
  * @brief Draw the tabs component.
  * 
@@ -6,12 +6,39 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
 
 #include "../ui_components.h"
 #include "constants.h"
 #include "utils/fs.h"
+#include "utils/utils.h"
+
+#define CACHE_METADATA_MAGIC        (0x424B4731)
+#define CACHE_METADATA_MAGIC_DARK   (0x424B4732)
+#define BACKGROUND_LOAD_CHUNK_SIZE  (KiB(32))
+#define BACKGROUND_SAVE_CHUNK_SIZE  (KiB(32))
+#define CACHE_TEMP_EXTENSION        ".tmp"
+
+/**
+ * @brief Background image loading state enumeration.
+ */
+typedef enum {
+    LOAD_STATE_IDLE,     /**< Nothing to load. */
+    LOAD_STATE_PENDING,  /**< Cache file not opened yet. */
+    LOAD_STATE_READING,  /**< Image data being read from the cache file. */
+} background_load_state_t;
 
-#define CACHE_METADATA_MAGIC    (0x424B4731)
+/**
+ * @brief Background image saving state enumeration.
+ */
+typedef enum {
+    SAVE_STATE_IDLE,     /**< Nothing to save. */
+    SAVE_STATE_WAITING,  /**< Waiting for the RDP to finish darkening the image. */
+    SAVE_STATE_READY,    /**< Image darkened, temporary file not opened yet. */
+    SAVE_STATE_WRITING,  /**< Image data being written to the temporary file. */
+} background_save_state_t;
 
 /**
  * @brief Structure representing the background component.
@@ -20,6 +47,15 @@ typedef struct {
     char *cache_location;      /**< Path to the cache file location. */
     surface_t *image;          /**< Pointer to the loaded image surface. */
     rspq_block_t *image_display_list; /**< Display list for rendering the image. */
+    background_load_state_t load_state; /**< State of the image loading from the cache file. */
+    FIL load_fil;              /**< Cache file opened during the image loading. */
+    size_t load_offset;        /**< Number of image bytes already loaded. */
+    size_t load_size;          /**< Image buffer size in bytes. */
+    bool load_darkened;        /**< The cached image was saved already darkened. */
+    background_save_state_t save_state; /**< State of the image saving to the cache file. */
+    FIL save_fil;              /**< Temporary cache file opened during the image saving. */
+    size_t save_offset;        /**< Number of image bytes already saved. */
+    uint32_t save_generation;  /**< Incremented with every replaced image, drops the stale RDP callbacks. */
 } component_background_t;
 
 /**
@@ -35,102 +71,286 @@ typedef struct {
 static component_background_t *background = NULL;
 
 /**
- * @brief Load background image from cache file if available.
+ * @brief Stop loading the background image from the cache file.
  *
  * @param c Pointer to the background component structure.
+ * @param discard Free the partially loaded image.
  */
-static void load_from_cache(component_background_t *c) {
-    if (!c->cache_location) {
-        return;
+static void load_from_cache_stop(component_background_t *c, bool discard) {
+    if (c->load_state == LOAD_STATE_READING) {
+        f_close(&c->load_fil);
     }
 
-    FILE *f;
+    c->load_state = LOAD_STATE_IDLE;
 
-    if ((f = fopen(c->cache_location, "rb")) == NULL) {
-        return;
+    if (discard && c->image) {
+        surface_free(c->image);
+        free(c->image);
+        c->image = NULL;
     }
+}
 
+/**
+ * @brief Open the cache file and allocate the image described by its metadata.
+ *
+ * @param c Pointer to the background component structure.
+ * @return true if there's no valid cached image, false otherwise.
+ */
+static bool load_from_cache_open(component_background_t *c) {
     cache_metadata_t cache_metadata;
+    UINT br;
 
-    if (fread(&cache_metadata, sizeof(cache_metadata), 1, f) != 1) {
-        fclose(f);
-        return;
+    if (f_open(&c->load_fil, strip_fs_prefix(c->cache_location), FA_READ) != FR_OK) {
+        return true;
     }
 
-    if (cache_metadata.magic != CACHE_METADATA_MAGIC || cache_metadata.width > DISPLAY_WIDTH || cache_metadata.height > DISPLAY_HEIGHT) {
-        fclose(f);
-        return;
+    c->load_state = LOAD_STATE_READING;
+
+    if ((f_read(&c->load_fil, &cache_metadata, sizeof(cache_metadata), &br) != FR_OK) || (br != sizeof(cache_metadata))) {
+        return true;
+    }
+
+    bool magic_valid = (cache_metadata.magic == CACHE_METADATA_MAGIC) || (cache_metadata.magic == CACHE_METADATA_MAGIC_DARK);
+
+    if (!magic_valid || cache_metadata.width > DISPLAY_WIDTH || cache_metadata.height > DISPLAY_HEIGHT) {
+        return true;
     }
 
     c->image = calloc(1, sizeof(surface_t));
     *c->image = surface_alloc(FMT_RGBA16, cache_metadata.width, cache_metadata.height);
 
-    if (cache_metadata.size != (c->image->height * c->image->stride)) {
-        surface_free(c->image);
-        free(c->image);
-        c->image = NULL;
-        fclose(f);
-        return;
+    if ((c->image->buffer == NULL) || (cache_metadata.size != (c->image->height * c->image->stride))) {
+        return true;
     }
 
-    if (fread(c->image->buffer, cache_metadata.size, 1, f) != 1) {
-        surface_free(c->image);
-        free(c->image);
-        c->image = NULL;
+    c->load_offset = 0;
+    c->load_size = cache_metadata.size;
+    c->load_darkened = (cache_metadata.magic == CACHE_METADATA_MAGIC_DARK);
+
+    return false;
+}
+
+/**
+ * @brief Read the next part of the background image from the cache file.
+ *
+ * @param c Pointer to the background component structure.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool load_from_cache_step(component_background_t *c) {
+    UINT br;
+
+    size_t length = MIN(c->load_size - c->load_offset, BACKGROUND_LOAD_CHUNK_SIZE);
+
+    if ((f_read(&c->load_fil, ((uint8_t *) (c->image->buffer)) + c->load_offset, length, &br) != FR_OK) || (br != length)) {
+        return true;
     }
 
-    fclose(f);
+    c->load_offset += length;
+
+    return false;
 }
 
 /**
- * @brief Save background image to cache file.
+ * @brief Get the path of the temporary cache file, the caller frees it.
  *
  * @param c Pointer to the background component structure.
+ * @return char* Temporary cache file path.
  */
-static void save_to_cache(component_background_t *c) {
-    if (!c->cache_location || !c->image) {
-        return;
+static char *save_get_temp_location(component_background_t *c) {
+    char *location = malloc(strlen(c->cache_location) + strlen(CACHE_TEMP_EXTENSION) + 1);
+    if (location) {
+        sprintf(location, "%s%s", c->cache_location, CACHE_TEMP_EXTENSION);
+    }
+    return location;
+}
+
+/**
+ * @brief Stop saving the background image, an unfinished temporary file is removed.
+ *
+ * @param c Pointer to the background component structure.
+ */
+static void save_to_cache_stop(component_background_t *c) {
+    if (c->save_state == SAVE_STATE_WRITING) {
+        f_close(&c->save_fil);
+        char *location = save_get_temp_location(c);
+        if (location) {
+            f_unlink(strip_fs_prefix(location));
+            free(location);
+        }
     }
 
-    FILE *f;
+    c->save_state = SAVE_STATE_IDLE;
+}
 
-    if ((f = fopen(c->cache_location, "wb")) == NULL) {
-        return;
+/**
+ * @brief Mark the image as ready to save, called once the RDP finished darkening it.
+ *
+ * @param arg Save generation the callback was queued for.
+ */
+static void save_to_cache_ready(void *arg) {
+    component_background_t *c = background;
+
+    if (c && (c->save_state == SAVE_STATE_WAITING) && (c->save_generation == (uint32_t) (uintptr_t) (arg))) {
+        c->save_state = SAVE_STATE_READY;
+    }
+}
+
+/**
+ * @brief Open the temporary cache file and write the metadata.
+ *
+ * @param c Pointer to the background component structure.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool save_to_cache_open(component_background_t *c) {
+    UINT bw;
+
+    char *location = save_get_temp_location(c);
+    if (!location) {
+        return true;
+    }
+
+    FRESULT res = f_open(&c->save_fil, strip_fs_prefix(location), FA_WRITE | FA_CREATE_ALWAYS);
+    free(location);
+
+    if (res != FR_OK) {
+        return true;
     }
 
+    c->save_state = SAVE_STATE_WRITING;
+    c->save_offset = 0;
+
     cache_metadata_t cache_metadata = {
-        .magic = CACHE_METADATA_MAGIC,
+        .magic = CACHE_METADATA_MAGIC_DARK,
         .width = c->image->width,
         .height = c->image->height,
         .size = (c->image->height * c->image->stride),
     };
 
-    fwrite(&cache_metadata, sizeof(cache_metadata), 1, f);
-    fwrite(c->image->buffer, cache_metadata.size, 1, f);
+    if ((f_write(&c->save_fil, &cache_metadata, sizeof(cache_metadata), &bw) != FR_OK) || (bw != sizeof(cache_metadata))) {
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Write the next part of the background image to the temporary cache file.
+ *
+ * @param c Pointer to the background component structure.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool save_to_cache_step(component_background_t *c) {
+    UINT bw;
+
+    size_t size = (c->image->height * c->image->stride);
+    size_t length = MIN(size - c->save_offset, BACKGROUND_SAVE_CHUNK_SIZE);
+
+    if ((f_write(&c->save_fil, ((uint8_t *) (c->image->buffer)) + c->save_offset, length, &bw) != FR_OK) || (bw != length)) {
+        return true;
+    }
+
+    c->save_offset += length;
+
+    return false;
+}
+
+/**
+ * @brief Close the temporary cache file and move it over the cache file.
+ *
+ * @param c Pointer to the background component structure.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool save_to_cache_commit(component_background_t *c) {
+    c->save_state = SAVE_STATE_IDLE;
+
+    char *location = save_get_temp_location(c);
+    if (!location) {
+        f_close(&c->save_fil);
+        return true;
+    }
+
+    bool error = (f_close(&c->save_fil) != FR_OK);
+
+    // NOTE: FatFs can't rename over an existing file, a reset in between only loses the cache, never corrupts it
+    if (!error) {
+        f_unlink(strip_fs_prefix(c->cache_location));
+        error = (f_rename(strip_fs_prefix(location), strip_fs_prefix(c->cache_location)) != FR_OK);
+    }
+
+    if (error) {
+        f_unlink(strip_fs_prefix(location));
+    }
+
+    free(location);
+
+    return error;
+}
+
+/**
+ * @brief Continue saving the background image to the cache file.
+ *
+ * @param c Pointer to the background component structure.
+ */
+static void save_to_cache_poll(component_background_t *c) {
+    switch (c->save_state) {
+        case SAVE_STATE_READY:
+            if (save_to_cache_open(c)) {
+                save_to_cache_stop(c);
+            }
+            break;
+
+        case SAVE_STATE_WRITING:
+            if (save_to_cache_step(c)) {
+                save_to_cache_stop(c);
+            } else if (c->save_offset == (c->image->height * c->image->stride)) {
+                save_to_cache_commit(c);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Finish saving the background image without waiting for idle frames.
+ *
+ * @param c Pointer to the background component structure.
+ */
+static void save_to_cache_finish(component_background_t *c) {
+    if (c->save_state == SAVE_STATE_WAITING) {
+        rspq_wait();
+        c->save_state = SAVE_STATE_READY;
+    }
 
-    fclose(f);
+    while (c->save_state != SAVE_STATE_IDLE) {
+        save_to_cache_poll(c);
+    }
 }
 
 /**
  * @brief Prepare the background image for display (darken and center).
  *
  * @param c Pointer to the background component structure.
+ * @param darken Darken the image, false when it was cached already darkened.
  */
-static void prepare_background(component_background_t *c) {
+static void prepare_background(component_background_t *c, bool darken) {
     if (!c->image || c->image->width == 0 || c->image->height == 0) {
         return;
     }
 
     // Darken the image
-    rdpq_attach(c->image, NULL);
-    rdpq_mode_push();
-        rdpq_set_mode_standard();
-        rdpq_set_prim_color(BACKGROUND_OVERLAY_COLOR);
-        rdpq_mode_combiner(RDPQ_COMBINER_FLAT);
-        rdpq_mode_blender(RDPQ_BLENDER_MULTIPLY);
-        rdpq_fill_rectangle(0, 0, c->image->width, c->image->height);
-    rdpq_mode_pop();
-    rdpq_detach();
+    if (darken) {
+        rdpq_attach(c->image, NULL);
+        rdpq_mode_push();
+            rdpq_set_mode_standard();
+            rdpq_set_prim_color(BACKGROUND_OVERLAY_COLOR);
+            rdpq_mode_combiner(RDPQ_COMBINER_FLAT);
+            rdpq_mode_blender(RDPQ_BLENDER_MULTIPLY);
+            rdpq_fill_rectangle(0, 0, c->image->width, c->image->height);
+        rdpq_mode_pop();
+        rdpq_detach();
+    }
 
     uint16_t image_center_x = (c->image->width / 2);
     uint16_t image_center_y = (c->image->height / 2);
@@ -185,7 +405,7 @@ static void display_list_free(void *arg) {
 }
 
 /**
- * @brief Initialize the background component and load from cache.
+ * @brief Initialize the background component, the cached image is loaded later by the poll function.
  *
  * @param cache_location Path to the cache file location.
  */
@@ -193,9 +413,44 @@ void ui_components_background_init(char *cache_location) {
     if (!background) {
         background = calloc(1, sizeof(component_background_t));
         background->cache_location = strdup(cache_location);
-        load_from_cache(background);
-        prepare_background(background);
+        background->load_state = LOAD_STATE_PENDING;
+    }
+}
+
+/**
+ * @brief Continue loading the cached background image, one chunk per call.
+ *
+ * @return true if the image was loaded by this call, false otherwise.
+ */
+bool ui_components_background_poll(void) {
+    if (!background) {
+        return false;
     }
+
+    switch (background->load_state) {
+        case LOAD_STATE_PENDING:
+            if (load_from_cache_open(background)) {
+                load_from_cache_stop(background, true);
+            }
+            break;
+
+        case LOAD_STATE_READING:
+            if (load_from_cache_step(background)) {
+                load_from_cache_stop(background, true);
+            } else if (background->load_offset == background->load_size) {
+                load_from_cache_stop(background, false);
+                prepare_background(background, !background->load_darkened);
+                return true;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    save_to_cache_poll(background);
+
+    return false;
 }
 
 /**
@@ -203,6 +458,8 @@ void ui_components_background_init(char *cache_location) {
  */
 void ui_components_background_free(void) {
     if (background) {
+        load_from_cache_stop(background, false);
+        save_to_cache_finish(background);
         if (background->image) {
             surface_free(background->image);
             free(background->image);
@@ -223,13 +480,18 @@ void ui_components_background_free(void) {
 /**
  * @brief Replace the background image and update cache/display list.
  *
- * @param image Pointer to the new background image surface.
+ * The image is darkened in place and written to the cache file over the next poll calls.
+ *
+ * @param image Pointer to the new background image surface, the component takes its ownership.
  */
 void ui_components_background_replace_image(surface_t *image) {
     if (!background) {
         return;
     }
 
+    load_from_cache_stop(background, false);
+    save_to_cache_stop(background);
+
     if (background->image) {
         surface_free(background->image);
         free(background->image);
@@ -242,8 +504,13 @@ void ui_components_background_replace_image(surface_t *image) {
     }
 
     background->image = image;
-    save_to_cache(background);
-    prepare_background(background);
+    prepare_background(background, true);
+
+    if (background->cache_location && background->image) {
+        background->save_state = SAVE_STATE_WAITING;
+        background->save_generation += 1;
+        rdpq_call_deferred(save_to_cache_ready, (void *) (uintptr_t) (background->save_generation));
+    }
 }
 
 /**
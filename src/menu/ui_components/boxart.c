@@ -4,17 +4,306 @@
  * @ingroup ui_components
  */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <fatfs/ff.h>
 
 #include "../ui_components.h"
+#include "../memory_budget.h"
+#include "../metadata.h"
 #include "../path.h"
 #include "../png_decoder.h"
 #include "constants.h"
 #include "utils/fs.h"
+#include "utils/hash.h"
+#include "utils/utils.h"
 
 #define OLD_BOXART_DIRECTORY       "menu/boxart"
-#define METADATA_BASE_DIRECTORY    "menu/metadata"
-#define HOMEBREW_ID_SUBDIRECTORY   "homebrew"
+#define BOXART_CACHE_DIRECTORY     "menu/cache/boxart"
+#define BOXART_CACHE_MAGIC         (0x42584331)
+
+#define BOXART_LRU_ENTRIES          (32)
+
+/**
+ * @brief Structure for decoded boxart cache metadata.
+ */
+typedef struct {
+    uint32_t magic; /**< Magic number for cache validation */
+    uint32_t source_size; /**< Size of the source PNG file */
+    uint32_t source_timestamp; /**< FAT timestamp of the source PNG file */
+    uint16_t width; /**< Image width */
+    uint16_t height; /**< Image height */
+    uint64_t source_hash; /**< FNV-1a hash of the source PNG path */
+    uint32_t size; /**< Image data size */
+    uint32_t reserved; /**< Reserved, keeps the image data 8 byte aligned */
+} boxart_cache_metadata_t;
+
+/**
+ * @brief Recently shown boxart image entry.
+ */
+typedef struct {
+    surface_t *image; /**< Decoded image, NULL if the entry is unused */
+    uint64_t source_hash; /**< FNV-1a hash of the source PNG path */
+    uint32_t source_size; /**< Size of the source PNG file */
+    uint32_t source_timestamp; /**< FAT timestamp of the source PNG file */
+    uint32_t last_used; /**< LRU clock value of the last use */
+} boxart_lru_entry_t;
+
+static boxart_lru_entry_t lru[BOXART_LRU_ENTRIES];
+static uint32_t lru_clock = 0;
+static size_t lru_size = 0;
+
+/**
+ * @brief Get the size of the image data.
+ *
+ * @param image Pointer to the image surface.
+ * @return size_t Image data size in bytes.
+ */
+static size_t image_size (surface_t *image) {
+    return (image->height * image->stride);
+}
+
+/**
+ * @brief Release an LRU entry and its image.
+ *
+ * @param entry Pointer to the LRU entry.
+ */
+static void lru_release (boxart_lru_entry_t *entry) {
+    lru_size -= image_size(entry->image);
+    surface_free(entry->image);
+    free(entry->image);
+    entry->image = NULL;
+}
+
+/**
+ * @brief Evict the least recently used image.
+ *
+ * @return true if there was an image to evict, false otherwise.
+ */
+static bool lru_evict_oldest (void) {
+    boxart_lru_entry_t *oldest = NULL;
+
+    for (int i = 0; i < BOXART_LRU_ENTRIES; i++) {
+        if (lru[i].image && ((oldest == NULL) || (lru[i].last_used < oldest->last_used))) {
+            oldest = &lru[i];
+        }
+    }
+
+    if (oldest == NULL) {
+        return false;
+    }
+
+    lru_release(oldest);
+
+    return true;
+}
+
+/**
+ * @brief Get the size of the image data kept in the LRU.
+ *
+ * @return size_t Image data size in bytes.
+ */
+static size_t lru_usage (void) {
+    return lru_size;
+}
+
+/**
+ * @brief Keep the image of a component in the LRU, the image is freed if it doesn't fit.
+ *
+ * @param b Pointer to the boxart component.
+ */
+static void lru_insert (component_boxart_t *b) {
+    size_t size = image_size(b->image);
+    boxart_lru_entry_t *entry = NULL;
+
+    memory_budget_register(MEMORY_CACHE_BOXART, lru_usage, lru_evict_oldest);
+
+    while (memory_budget_over_quota(MEMORY_CACHE_BOXART, size) && lru_evict_oldest());
+
+    for (int attempt = 0; (entry == NULL) && (attempt < 2); attempt++) {
+        for (int i = 0; i < BOXART_LRU_ENTRIES; i++) {
+            if (lru[i].image == NULL) {
+                entry = &lru[i];
+                break;
+            }
+        }
+        if (entry == NULL) {
+            lru_evict_oldest();
+        }
+    }
+
+    if ((entry == NULL) || memory_budget_over_quota(MEMORY_CACHE_BOXART, size)) {
+        surface_free(b->image);
+        free(b->image);
+        b->image = NULL;
+        return;
+    }
+
+    entry->image = b->image;
+    entry->source_hash = b->source_hash;
+    entry->source_size = b->source_size;
+    entry->source_timestamp = b->source_timestamp;
+    entry->last_used = lru_clock++;
+    lru_size += size;
+
+    b->image = NULL;
+}
+
+/**
+ * @brief Take the matching image out of the LRU.
+ *
+ * @param b Pointer to the boxart component.
+ * @return true if there's no matching image, false otherwise.
+ */
+static bool lru_take (component_boxart_t *b) {
+    for (int i = 0; i < BOXART_LRU_ENTRIES; i++) {
+        boxart_lru_entry_t *entry = &lru[i];
+        if (
+            (entry->image != NULL) &&
+            (entry->source_hash == b->source_hash) &&
+            (entry->source_size == b->source_size) &&
+            (entry->source_timestamp == b->source_timestamp)
+        ) {
+            b->image = entry->image;
+            lru_size -= image_size(entry->image);
+            entry->image = NULL;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Describe the source image and locate its cache file.
+ *
+ * @param b Pointer to the boxart component.
+ * @param storage_prefix The storage prefix (e.g., SD card root).
+ * @param path Path to the source PNG file.
+ * @return true if the source file can't be described, false otherwise.
+ */
+static bool cache_describe (component_boxart_t *b, const char *storage_prefix, path_t *path) {
+    FILINFO info;
+
+    if (f_stat(strip_fs_prefix(path_get(path)), &info) != FR_OK) {
+        return true;
+    }
+
+    b->source_size = info.fsize;
+    b->source_timestamp = ((info.fdate << 16) | info.ftime);
+    b->source_hash = fnv1a64_string(path_get(path));
+
+    char file_name[24];
+    snprintf(file_name, sizeof(file_name), "%016llX.data", b->source_hash);
+
+    path_t *cache_path = path_init(storage_prefix, BOXART_CACHE_DIRECTORY);
+    path_push(cache_path, file_name);
+    b->cache_location = strdup(path_get(cache_path));
+    path_free(cache_path);
+
+    return (b->cache_location == NULL);
+}
+
+/**
+ * @brief Load the decoded image from the cache file.
+ *
+ * @param b Pointer to the boxart component.
+ * @return true if there's no valid cached image, false otherwise.
+ */
+static bool load_from_cache (component_boxart_t *b) {
+    boxart_cache_metadata_t cache_metadata;
+
+    if (file_read_range(b->cache_location, 0, &cache_metadata, sizeof(cache_metadata))) {
+        return true;
+    }
+
+    if (
+        (cache_metadata.magic != BOXART_CACHE_MAGIC) ||
+        (cache_metadata.source_size != b->source_size) ||
+        (cache_metadata.source_timestamp != b->source_timestamp) ||
+        (cache_metadata.source_hash != b->source_hash) ||
+        (cache_metadata.width > BOXART_WIDTH_MAX) ||
+        (cache_metadata.height > BOXART_HEIGHT_MAX)
+    ) {
+        return true;
+    }
+
+    surface_t *image = calloc(1, sizeof(surface_t));
+    if (image == NULL) {
+        return true;
+    }
+
+    *image = surface_alloc(FMT_RGBA16, cache_metadata.width, cache_metadata.height);
+
+    if (image->buffer == NULL) {
+        ui_components_boxart_cache_flush();
+        *image = surface_alloc(FMT_RGBA16, cache_metadata.width, cache_metadata.height);
+    }
+
+    if (
+        (image->buffer == NULL) ||
+        (cache_metadata.size != (image->height * image->stride)) ||
+        file_read_range(b->cache_location, sizeof(cache_metadata), image->buffer, cache_metadata.size)
+    ) {
+        surface_free(image);
+        free(image);
+        return true;
+    }
+
+    data_cache_hit_writeback(image->buffer, cache_metadata.size);
+
+    b->image = image;
+
+    return false;
+}
+
+/**
+ * @brief Save the decoded image to the cache file.
+ *
+ * @param b Pointer to the boxart component.
+ */
+static void save_to_cache (component_boxart_t *b) {
+    if (!b->cache_location || !b->image) {
+        return;
+    }
+
+    char *directory = strdup(b->cache_location);
+    if (directory == NULL) {
+        return;
+    }
+    *strrchr(directory, '/') = '\0';
+    bool error = directory_create(directory);
+    free(directory);
+    if (error) {
+        return;
+    }
+
+    FILE *f;
+
+    if ((f = fopen(b->cache_location, "wb")) == NULL) {
+        return;
+    }
+
+    boxart_cache_metadata_t cache_metadata = {
+        .magic = BOXART_CACHE_MAGIC,
+        .source_size = b->source_size,
+        .source_timestamp = b->source_timestamp,
+        .width = b->image->width,
+        .height = b->image->height,
+        .source_hash = b->source_hash,
+        .size = (b->image->height * b->image->stride),
+    };
+
+    bool success = (fwrite(&cache_metadata, sizeof(cache_metadata), 1, f) == 1) && (fwrite(b->image->buffer, cache_metadata.size, 1, f) == 1);
+
+    fclose(f);
+
+    if (!success) {
+        remove(b->cache_location);
+    }
+}
 
 /**
  * @brief PNG decoder callback for boxart image loading.
@@ -29,6 +318,27 @@ static void png_decoder_callback(png_err_t err, surface_t *decoded_image, void *
     component_boxart_t *b = (component_boxart_t *)(callback_data);
     b->loading = false;
     b->image = decoded_image;
+    save_to_cache(b);
+}
+
+/**
+ * @brief Load a boxart image, from the decoded image cache when possible.
+ *
+ * @param b Pointer to the boxart component.
+ * @param storage_prefix The storage prefix (e.g., SD card root).
+ * @param path Path to the source PNG file.
+ * @return true if the image can't be loaded, false otherwise.
+ */
+static bool load_image (component_boxart_t *b, const char *storage_prefix, path_t *path) {
+    free(b->cache_location);
+    b->cache_location = NULL;
+
+    if (!cache_describe(b, storage_prefix, path) && (!lru_take(b) || !load_from_cache(b))) {
+        b->loading = false;
+        return false;
+    }
+
+    return (png_decoder_start(path_get(path), BOXART_WIDTH_MAX, BOXART_HEIGHT_MAX, PNG_PRIORITY_BACKGROUND, png_decoder_callback, b, &b->job) != PNG_OK);
 }
 
 /**
@@ -42,9 +352,8 @@ static void png_decoder_callback(png_err_t err, surface_t *decoded_image, void *
  * @param current_image_view The current image view type (front, back, etc.).
  * @return Pointer to the initialized boxart component, or NULL on failure.
  */
-component_boxart_t *ui_components_boxart_init(const char *storage_prefix, const char *game_code, const char *rom_title, file_image_type_t current_image_view) {
+static component_boxart_t *boxart_create (const char *storage_prefix, const char *game_code, const char *rom_title, file_image_type_t current_image_view) {
     component_boxart_t *b;
-    char boxart_path[32];
 
     if ((b = calloc(1, sizeof(component_boxart_t))) == NULL) {
         return NULL;
@@ -52,90 +361,30 @@ component_boxart_t *ui_components_boxart_init(const char *storage_prefix, const
 
     b->loading = true;
 
-    path_t *path = path_init(storage_prefix, METADATA_BASE_DIRECTORY);
-
-    if (game_code[1] == 'E' && game_code[2] == 'D') {
-        // This is using a homebrew ROM ID, use the title for the file name instead.
-        // Create a null-terminated copy of the title for safe string operations
-        char safe_title[21];  // 20 chars + null terminator
-        memcpy(safe_title, rom_title, 20);
-        safe_title[20] = '\0';
-        
-        snprintf(boxart_path, sizeof(boxart_path), HOMEBREW_ID_SUBDIRECTORY"/%s", safe_title);
-        path_push(path, boxart_path);
-    }
-    else {
-        sprintf(boxart_path, "%c/%c/%c/%c", game_code[0], game_code[1], game_code[2], game_code[3]);
-        path_push(path, boxart_path);
+    path_t *path = metadata_get_image_path(storage_prefix, game_code, rom_title, current_image_view);
 
-        if (!directory_exists(path_get(path))) { // Allow boxart to not specify the region code.
-            path_pop(path);
-        }
+    if (path != NULL) {
+        debugf("Boxart: Using path %s\n", path_get(path));
 
-        if (!directory_exists(path_get(path))) { // Fallback to the old boxart directory if metadata directory doesn't exist.
-            
-            // TODO: As a deprecated path, eventually this should be removed.
+        if (!load_image(b, storage_prefix, path)) {
             path_free(path);
-            path = path_init(storage_prefix, OLD_BOXART_DIRECTORY);
-            path_push(path, boxart_path);
-
-            if (!directory_exists(path_get(path))) { // Allow boxart to not specify the region code.
-                path_pop(path);
-            }
-        }
-    }
-
-    debugf("Boxart: Using path %s\n", boxart_path);
-
-    if (directory_exists(path_get(path))) {
-        switch (current_image_view) {
-            case IMAGE_GAMEPAK_FRONT:
-                path_push(path, "gamepak_front.png");
-                break;
-            case IMAGE_GAMEPAK_BACK:
-                path_push(path, "gamepak_back.png");
-                break;
-            case IMAGE_BOXART_BACK:
-                path_push(path, "boxart_back.png");
-                break;
-            case IMAGE_BOXART_LEFT:
-                path_push(path, "boxart_left.png");
-                break;
-            case IMAGE_BOXART_RIGHT:
-                path_push(path, "boxart_right.png");
-                break;
-            case IMAGE_BOXART_BOTTOM:
-                path_push(path, "boxart_bottom.png");
-                break;
-            case IMAGE_BOXART_TOP:
-                path_push(path, "boxart_top.png");
-                break;
-            default:
-                path_push(path, "boxart_front.png");
-                break;
-        }
-
-        if (file_exists(path_get(path))) { 
-            if (png_decoder_start(path_get(path), BOXART_WIDTH_MAX, BOXART_HEIGHT_MAX, png_decoder_callback, b) == PNG_OK) {
-                path_free(path);
-                return b;
-            }
+            return b;
         }
+        path_free(path);
+        path = NULL;
     }
 #ifdef FEATURE_DEPRECATED_FUNCTIONALITY
-    else { // deprecated compatibility mode
+    else if (metadata_get_images(storage_prefix, game_code, rom_title) == 0) { // deprecated compatibility mode
 
         char file_name[9];
 
-        // reset the directory path used for boxart.
-        path_free(path);
         path = path_init(storage_prefix, OLD_BOXART_DIRECTORY);
 
         snprintf(file_name, sizeof(file_name), "%c%c%c%c.png", game_code[0], game_code[1], game_code[2], game_code[3]);
         path_push(path, file_name);
 
         if (file_exists(path_get(path))) {
-            if (png_decoder_start(path_get(path), BOXART_WIDTH_MAX, BOXART_HEIGHT_MAX, png_decoder_callback, b) == PNG_OK) {
+            if (!load_image(b, storage_prefix, path)) {
                 path_free(path);
                 return b;
             }
@@ -146,7 +395,7 @@ component_boxart_t *ui_components_boxart_init(const char *storage_prefix, const
         path_push(path, file_name);
 
         if (file_exists(path_get(path))) {
-            if (png_decoder_start(path_get(path), BOXART_WIDTH_MAX, BOXART_HEIGHT_MAX, png_decoder_callback, b) == PNG_OK) {
+            if (!load_image(b, storage_prefix, path)) {
                 path_free(path);
                 return b;
             }
@@ -156,7 +405,7 @@ component_boxart_t *ui_components_boxart_init(const char *storage_prefix, const
             snprintf(file_name, sizeof(file_name), "%c%c.png", game_code[1], game_code[2]);
             path_push(path, file_name);
             if (file_exists(path_get(path))) {
-                if (png_decoder_start(path_get(path), BOXART_WIDTH_MAX, BOXART_HEIGHT_MAX, png_decoder_callback, b) == PNG_OK) {
+                if (!load_image(b, storage_prefix, path)) {
                     path_free(path);
                     return b;
                 }
@@ -167,11 +416,30 @@ component_boxart_t *ui_components_boxart_init(const char *storage_prefix, const
     // TODO: return default image.
 
     path_free(path);
+    free(b->cache_location);
     free(b);
 
     return NULL;
 }
 
+/**
+ * @brief Initialize and load the boxart component for a game.
+ *
+ * Attempts to locate and load the appropriate boxart image for the given game code and ROM title.
+ *
+ * @param storage_prefix The storage prefix (e.g., SD card root).
+ * @param game_code The 4-character game code.
+ * @param rom_title Title of the ROM (may be NULL). If used, it is sanitized for filesystem safety.
+ * @param current_image_view The current image view type (front, back, etc.).
+ * @return Pointer to the initialized boxart component, or NULL on failure.
+ */
+component_boxart_t *ui_components_boxart_init(const char *storage_prefix, const char *game_code, const char *rom_title, file_image_type_t current_image_view) {
+    path_scratch_begin();
+    component_boxart_t *b = boxart_create(storage_prefix, game_code, rom_title, current_image_view);
+    path_scratch_end();
+    return b;
+}
+
 /**
  * @brief Free the boxart component and its resources.
  *
@@ -180,12 +448,15 @@ component_boxart_t *ui_components_boxart_init(const char *storage_prefix, const
 void ui_components_boxart_free(component_boxart_t *b) {
     if (b) {
         if (b->loading) {
-            png_decoder_abort();
+            png_decoder_abort(b->job);
         }
-        if (b->image) {
+        if (b->image && b->cache_location) {
+            lru_insert(b);
+        } else if (b->image) {
             surface_free(b->image);
             free(b->image);
         }
+        free(b->cache_location);
         free(b);
     }
 }
@@ -222,3 +493,10 @@ void ui_components_boxart_draw(component_boxart_t *b) {
         );
     }
 }
+
+/**
+ * @brief Free all recently shown boxart images kept in memory.
+ */
+void ui_components_boxart_cache_flush(void) {
+    while (lru_evict_oldest());
+}
@@ -5,10 +5,133 @@
  */
 
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "../ui_components.h"
 #include "../fonts.h"
 #include "constants.h"
+#include "utils/hash.h"
+
+#define TABS_BLOCKS_MAX     (8)
+#define TEXT_BLOCKS_MAX     (8)
+
+/** @brief Recorded tab backgrounds for one tab strip variant. */
+typedef struct {
+    int count; /**< Number of tabs */
+    int selected; /**< Index of the selected tab */
+    float width; /**< Width of a single tab */
+    rspq_block_t *block; /**< Recorded display list, NULL if the slot is unused */
+} tabs_block_t;
+
+/** @brief Text areas drawn by the formatted text functions. */
+typedef enum {
+    TEXT_AREA_MAIN, /**< Main content area */
+    TEXT_AREA_ACTIONS_BAR, /**< Actions bar area */
+} text_area_t;
+
+/** @brief Recorded rendering of a formatted text. */
+typedef struct {
+    text_area_t area; /**< Text area */
+    menu_font_type_t style; /**< Font style */
+    rdpq_align_t align; /**< Horizontal alignment */
+    rdpq_valign_t valign; /**< Vertical alignment */
+    uint32_t hash; /**< FNV-1a hash of the text */
+    size_t length; /**< Text length */
+    char *text; /**< Copy of the text */
+    uint32_t last_used; /**< LRU clock value of the last use */
+    uint32_t fonts_generation; /**< Glyph pages generation of the recording */
+    rspq_block_t *block; /**< Recorded display list, NULL if the slot is unused */
+} text_block_t;
+
+static rspq_block_t *layout_block = NULL;
+static rspq_block_t *layout_tabbed_block = NULL;
+static tabs_block_t tabs_blocks[TABS_BLOCKS_MAX];
+static int tabs_blocks_next = 0;
+static text_block_t text_blocks[TEXT_BLOCKS_MAX];
+static uint32_t text_blocks_clock = 0;
+
+/**
+ * @brief Callback function to free the display list.
+ *
+ * @param arg Pointer to the display list.
+ */
+static void display_list_free (void *arg) {
+    rspq_block_free((rspq_block_t *) (arg));
+}
+
+/**
+ * @brief Draw a formatted text, replaying the recorded rendering when the same text was drawn recently.
+ *
+ * Laying out a paragraph is expensive, views drawing the same text every frame only pay for it once.
+ *
+ * @param area The text area.
+ * @param parms The text parameters.
+ * @param x The x-coordinate of the text.
+ * @param y The y-coordinate of the text.
+ * @param text The formatted text.
+ * @param length The text length.
+ */
+static void text_draw_cached (text_area_t area, const rdpq_textparms_t *parms, float x, float y, const char *text, size_t length) {
+    uint32_t hash = fnv1a32(FNV1A32_INIT, text, length);
+    text_block_t *entry = NULL;
+
+    for (int i = 0; i < TEXT_BLOCKS_MAX; i++) {
+        text_block_t *e = &text_blocks[i];
+        if (
+            e->block &&
+            (e->area == area) &&
+            (e->style == parms->style_id) &&
+            (e->align == parms->align) &&
+            (e->valign == parms->valign) &&
+            (e->hash == hash) &&
+            (e->length == length) &&
+            (e->fonts_generation == fonts_get_generation()) &&
+            (memcmp(e->text, text, length) == 0)
+        ) {
+            e->last_used = text_blocks_clock++;
+            rspq_block_run(e->block);
+            return;
+        }
+        if ((entry == NULL) || (entry->block && (!e->block || (e->last_used < entry->last_used)))) {
+            entry = e;
+        }
+    }
+
+    char *copy = malloc(length);
+
+    int prepared_length = length;
+    const char *prepared = fonts_prepare_text(text, &prepared_length);
+
+    if (copy == NULL) {
+        rdpq_text_printn(parms, FNT_DEFAULT, x, y, prepared, prepared_length);
+        return;
+    }
+
+    memcpy(copy, text, length);
+
+    if (entry->block) {
+        // NOTE: The evicted block might still be used by the RSP
+        rdpq_call_deferred(display_list_free, entry->block);
+    }
+    free(entry->text);
+
+    rspq_block_begin();
+    rdpq_text_printn(parms, FNT_DEFAULT, x, y, prepared, prepared_length);
+    entry->block = rspq_block_end();
+
+    entry->area = area;
+    entry->style = parms->style_id;
+    entry->align = parms->align;
+    entry->valign = parms->valign;
+    entry->hash = hash;
+    entry->length = length;
+    entry->text = copy;
+    entry->last_used = text_blocks_clock++;
+    entry->fonts_generation = fonts_get_generation();
+
+    rspq_block_run(entry->block);
+}
 
 /**
  * @brief Draw a box with the specified color.
@@ -59,8 +182,17 @@ void ui_components_border_draw (int x0, int y0, int x1, int y1) {
 
 /**
  * @brief Draw the layout with tabs.
+ * 
+ * The layout never changes, it's recorded into a display list on the first call and replayed afterwards.
  */
 void ui_components_layout_draw_tabbed (void) {
+    if (layout_tabbed_block) {
+        rspq_block_run(layout_tabbed_block);
+        return;
+    }
+
+    rspq_block_begin();
+
     ui_components_border_draw(
         VISIBLE_AREA_X0,
         VISIBLE_AREA_Y0 + TAB_HEIGHT + BORDER_THICKNESS,
@@ -75,12 +207,24 @@ void ui_components_layout_draw_tabbed (void) {
         LAYOUT_ACTIONS_SEPARATOR_Y + BORDER_THICKNESS,
         BORDER_COLOR
     );
+
+    layout_tabbed_block = rspq_block_end();
+    rspq_block_run(layout_tabbed_block);
 }
 
 /**
  * @brief Draw the layout.
+ * 
+ * The layout never changes, it's recorded into a display list on the first call and replayed afterwards.
  */
 void ui_components_layout_draw (void) {
+    if (layout_block) {
+        rspq_block_run(layout_block);
+        return;
+    }
+
+    rspq_block_begin();
+
     ui_components_border_draw(
         VISIBLE_AREA_X0,
         VISIBLE_AREA_Y0,
@@ -94,6 +238,9 @@ void ui_components_layout_draw (void) {
         LAYOUT_ACTIONS_SEPARATOR_Y + BORDER_THICKNESS,
         BORDER_COLOR
     );
+
+    layout_block = rspq_block_end();
+    rspq_block_run(layout_block);
 }
 
 /**
@@ -226,6 +373,7 @@ void ui_components_messagebox_draw (char *fmt, ...) {
     va_end(va);
 
     int paragraph_nbytes = nbytes;
+    const char *paragraph_text = fonts_prepare_text(formatted, &paragraph_nbytes);
 
     rdpq_paragraph_t *paragraph = rdpq_paragraph_build(&(rdpq_textparms_t) {
         .width = MESSAGEBOX_MAX_WIDTH,
@@ -234,7 +382,7 @@ void ui_components_messagebox_draw (char *fmt, ...) {
         .valign = VALIGN_CENTER,
         .wrap = WRAP_WORD,
         .line_spacing = TEXT_LINE_SPACING_ADJUST,
-    }, FNT_DEFAULT, formatted, &paragraph_nbytes);
+    }, FNT_DEFAULT, paragraph_text, &paragraph_nbytes);
 
     if (formatted != buffer) {
         free(formatted);
@@ -268,7 +416,8 @@ void ui_components_main_text_draw (menu_font_type_t style, rdpq_align_t align, r
     char *formatted = vasnprintf(buffer, &nbytes, fmt, va);
     va_end(va);
 
-    rdpq_text_printn(
+    text_draw_cached(
+        TEXT_AREA_MAIN,
         &(rdpq_textparms_t) {
             .style_id = style,
             .width = VISIBLE_AREA_WIDTH - (TEXT_MARGIN_HORIZONTAL * 2),
@@ -278,7 +427,6 @@ void ui_components_main_text_draw (menu_font_type_t style, rdpq_align_t align, r
             .wrap = WRAP_WORD,
             .line_spacing = TEXT_LINE_SPACING_ADJUST,
         },
-        FNT_DEFAULT,
         VISIBLE_AREA_X0 + TEXT_MARGIN_HORIZONTAL,
         VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TEXT_OFFSET_VERTICAL,
         formatted,
@@ -308,7 +456,8 @@ void ui_components_actions_bar_text_draw (menu_font_type_t style, rdpq_align_t a
     char *formatted = vasnprintf(buffer, &nbytes, fmt, va);
     va_end(va);
 
-    rdpq_text_printn(
+    text_draw_cached(
+        TEXT_AREA_ACTIONS_BAR,
         &(rdpq_textparms_t) {
             .style_id = style,
             .width = VISIBLE_AREA_WIDTH - (TEXT_MARGIN_HORIZONTAL * 2),
@@ -318,7 +467,6 @@ void ui_components_actions_bar_text_draw (menu_font_type_t style, rdpq_align_t a
             .wrap = WRAP_ELLIPSES,
             .line_spacing = TEXT_LINE_SPACING_ADJUST,
         },
-        FNT_DEFAULT,
         VISIBLE_AREA_X0 + TEXT_MARGIN_HORIZONTAL,
         LAYOUT_ACTIONS_SEPARATOR_Y + BORDER_THICKNESS + TEXT_MARGIN_VERTICAL + TEXT_OFFSET_VERTICAL,
         formatted,
@@ -331,18 +479,17 @@ void ui_components_actions_bar_text_draw (menu_font_type_t style, rdpq_align_t a
 }
 
 /**
- * @brief Draw the tabs.
- * 
- * @param text Array of tab text.
+ * @brief Draw the tab backgrounds and borders.
+ *
  * @param count Number of tabs.
  * @param selected Index of the selected tab.
- * @param width Width of each tab.
+ * @param width Width of a single tab.
  */
-void ui_components_tabs_draw(const char **text, int count, int selected, float width ) {
+static void ui_components_tabs_background_draw (int count, int selected, float width) {
     float starting_x = VISIBLE_AREA_X0;
 
     float x = starting_x;
-    float y = OVERSCAN_HEIGHT;    
+    float y = OVERSCAN_HEIGHT;
     float height = TAB_HEIGHT;
 
     // first draw the tabs that are not selected
@@ -387,6 +534,56 @@ void ui_components_tabs_draw(const char **text, int count, int selected, float w
             TAB_ACTIVE_BORDER_COLOR
         );
     }
+}
+
+/**
+ * @brief Replay the recorded tab backgrounds, recording them first if this tab strip variant wasn't drawn yet.
+ *
+ * @param count Number of tabs.
+ * @param selected Index of the selected tab.
+ * @param width Width of a single tab.
+ */
+static void ui_components_tabs_background_run (int count, int selected, float width) {
+    for (int i = 0; i < TABS_BLOCKS_MAX; i++) {
+        tabs_block_t *entry = &tabs_blocks[i];
+        if (entry->block && (entry->count == count) && (entry->selected == selected) && (entry->width == width)) {
+            rspq_block_run(entry->block);
+            return;
+        }
+    }
+
+    tabs_block_t *entry = &tabs_blocks[tabs_blocks_next];
+    tabs_blocks_next = (tabs_blocks_next + 1) % TABS_BLOCKS_MAX;
+
+    if (entry->block) {
+        // NOTE: The evicted block might still be used by the RSP
+        rdpq_call_deferred(display_list_free, entry->block);
+    }
+
+    rspq_block_begin();
+    ui_components_tabs_background_draw(count, selected, width);
+    entry->block = rspq_block_end();
+    entry->count = count;
+    entry->selected = selected;
+    entry->width = width;
+
+    rspq_block_run(entry->block);
+}
+
+/**
+ * @brief Draw the tabs.
+ * 
+ * @param text Array of tab text.
+ * @param count Number of tabs.
+ * @param selected Index of the selected tab.
+ * @param width Width of each tab.
+ */
+void ui_components_tabs_draw(const char **text, int count, int selected, float width ) {
+    float starting_x = VISIBLE_AREA_X0;
+
+    float x = starting_x;
+
+    ui_components_tabs_background_run(count, selected, width);
 
     // write the text on the tabs
     rdpq_textparms_t tab_textparms = {
@@ -262,6 +262,11 @@
  * @brief Maximum width for a file list entry (pixels).
  */
 #define FILE_LIST_MAX_WIDTH             (480)
+/**
+ * @def FILE_LIST_TAGGED_MAX_WIDTH
+ * @brief Maximum width for a file list entry when the ROM tags are shown (pixels).
+ */
+#define FILE_LIST_TAGGED_MAX_WIDTH      (360)
 /**
  * @def FILE_LIST_HIGHLIGHT_WIDTH
  * @brief Width of the file list highlight (pixels).
@@ -323,6 +328,36 @@
  */
 #define DIALOG_BG_COLOR                 RGBA32(0x00, 0x00, 0x00, 0xFF)
 
+/**
+ * @def PERF_HUD_WIDTH
+ * @brief The width of the performance overlay.
+ */
+#define PERF_HUD_WIDTH                  (208)
+
+/**
+ * @def PERF_HUD_HEIGHT
+ * @brief The height of the performance overlay.
+ */
+#define PERF_HUD_HEIGHT                 (172)
+
+/**
+ * @def PERF_HUD_X
+ * @brief The x-coordinate of the performance overlay.
+ */
+#define PERF_HUD_X                      (VISIBLE_AREA_X1 - PERF_HUD_WIDTH)
+
+/**
+ * @def PERF_HUD_Y
+ * @brief The y-coordinate of the performance overlay.
+ */
+#define PERF_HUD_Y                      (VISIBLE_AREA_Y0)
+
+/**
+ * @def PERF_HUD_BG_COLOR
+ * @brief Background color for the performance overlay (RGBA8888).
+ */
+#define PERF_HUD_BG_COLOR               RGBA32(0x00, 0x00, 0x00, 0xFF)
+
 /**
  * @def BOXART_LOADING_COLOR
  * @brief Color used while boxart is loading (RGBA8888).
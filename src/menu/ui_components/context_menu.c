@@ -128,10 +128,11 @@ void ui_components_context_menu_draw(component_context_menu_t *cm) {
         FNT_DEFAULT,
         NULL
     );
+    fonts_paragraph_builder_begin();
 
     for (int i = 0; i < cm->row_count; i++) {
         const char *text = cm->list[i].text;
-        rdpq_paragraph_builder_span(text, strlen(text));
+        fonts_paragraph_builder_span(text, strlen(text));
         if (cm->list[i + 1].text != NULL) {
             rdpq_paragraph_builder_newline();
         }
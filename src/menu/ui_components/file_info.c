@@ -4,6 +4,7 @@
  * @ingroup ui_components
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "../ui_components.h"
@@ -88,6 +89,10 @@ void ui_components_file_info_draw(char* filename, file_info_t *info) {
     const char *file_type = format_file_type(filename, info);
     const char *file_mode = info->directory ? "Directory" : "File";
     const char *file_access = info->encrypted ? "(Encrypted)" : info->writeable ? "" : "(Read only)";
+    char file_fragments[32] = "";
+    if (info->fragments > 0) {
+        snprintf(file_fragments, sizeof(file_fragments), " Fragments: %ld\n", info->fragments);
+    }
     if (info->compressed > 0) {
         ui_components_main_text_draw(
             STL_DEFAULT,
@@ -121,12 +126,14 @@ void ui_components_file_info_draw(char* filename, file_info_t *info) {
             " Size: %d bytes\n"
             " Attributes: %s %s\n"
             "%s"
-            " Modified: %s",
+            " Modified: %s"
+            "%s",
             info->size,
             file_mode,
             file_access,
             file_type,
-            ctime(&info->mtime)
+            ctime(&info->mtime),
+            file_fragments
         );
     }
 }
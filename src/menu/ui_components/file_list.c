@@ -8,6 +8,7 @@
 
 #include "../ui_components.h"
 #include "../fonts.h"
+#include "../rom_info.h"
 #include "constants.h"
 
 /**
@@ -46,14 +47,238 @@ static int format_file_size(char *buffer, int64_t size) {
     }
 }
 
+/**
+ * @brief Format the ROM tags of an entry.
+ *
+ * @param buffer Buffer to store the formatted string, at least 24 characters long.
+ * @param tags ROM tags (rom_tag_t flags).
+ * @return Number of characters written to the buffer.
+ */
+static int format_rom_tags(char *buffer, uint8_t tags) {
+    int length = 0;
+
+    switch (tags & ROM_TAG_SAVE_MASK) {
+        case ROM_TAG_SAVE_EEPROM: length += sprintf(&buffer[length], "EEP "); break;
+        case ROM_TAG_SAVE_SRAM: length += sprintf(&buffer[length], "SRAM "); break;
+        case ROM_TAG_SAVE_FLASHRAM: length += sprintf(&buffer[length], "FLASH "); break;
+        default: break;
+    }
+
+    switch (tags & ROM_TAG_REGION_MASK) {
+        case ROM_TAG_REGION_NTSC: length += sprintf(&buffer[length], "NTSC "); break;
+        case ROM_TAG_REGION_PAL: length += sprintf(&buffer[length], "PAL "); break;
+        case ROM_TAG_REGION_JAPAN: length += sprintf(&buffer[length], "JPN "); break;
+        default: break;
+    }
+
+    if (tags & ROM_TAG_EXPANSION_PAK) {
+        length += sprintf(&buffer[length], "XP ");
+    }
+
+    if (tags & ROM_TAG_RUMBLE_PAK) {
+        length += sprintf(&buffer[length], "RP ");
+    }
+
+    return length;
+}
+
+/**
+ * @brief Cached rendering of the visible part of the file list.
+ */
+static struct {
+    bool valid; /**< The cached rendering matches the list */
+    entry_t *list; /**< List the rendering was built from */
+    int entries; /**< Number of entries in the list */
+    int starting_position; /**< Index of the first visible entry */
+    bool show_tags; /**< The ROM tags are shown */
+    int highlight_height; /**< Height of a single line */
+    uint32_t fonts_generation; /**< Glyph pages generation of the rendering */
+    rspq_block_t *display_list; /**< Recorded rendering of the names and the sizes */
+} file_list_cache;
+
+/**
+ * @brief Free the recorded rendering once the RSP is done with it.
+ *
+ * @param arg Pointer to the display list (rspq_block_t *).
+ */
+static void display_list_free(void *arg) {
+    rspq_block_free((rspq_block_t *) (arg));
+}
+
+/**
+ * @brief Build the name and size layouts of the visible entries and record their rendering.
+ *
+ * @param list Pointer to the list of file entries.
+ * @param entries Number of entries in the list.
+ * @param starting_position Index of the first visible entry.
+ * @param show_tags Show the ROM tags of the entries.
+ */
+static void file_list_cache_build(entry_t *list, int entries, int starting_position, bool show_tags) {
+    rdpq_paragraph_t *file_list_layout;
+    rdpq_paragraph_t *names_layout;
+    rdpq_paragraph_t *sizes_layout;
+
+    size_t name_lengths[LIST_ENTRIES];
+    size_t total_length = 1;
+
+    for (int i = 0; i < LIST_ENTRIES; i++) {
+        int entry_index = starting_position + i;
+
+        if (entry_index >= entries) {
+            name_lengths[i] = 0;
+        } else {
+            size_t length = strlen(list[entry_index].name);
+            name_lengths[i] = length;
+            total_length += length;
+        }
+    }
+
+    file_list_layout = malloc(sizeof(rdpq_paragraph_t) + (sizeof(rdpq_paragraph_char_t) * total_length));
+    memset(file_list_layout, 0, sizeof(rdpq_paragraph_t));
+    file_list_layout->capacity = total_length;
+
+    rdpq_paragraph_builder_begin(
+        &(rdpq_textparms_t) {
+            .width = (show_tags ? FILE_LIST_TAGGED_MAX_WIDTH : FILE_LIST_MAX_WIDTH) - (TEXT_MARGIN_HORIZONTAL * 2),
+            .height = LAYOUT_ACTIONS_SEPARATOR_Y - VISIBLE_AREA_Y0  - (TEXT_MARGIN_VERTICAL * 2),
+            .wrap = WRAP_ELLIPSES,
+            .line_spacing = TEXT_LINE_SPACING_ADJUST,
+        },
+        FNT_DEFAULT,
+        file_list_layout
+    );
+    fonts_paragraph_builder_begin();
+
+    for (int i = 0; i < LIST_ENTRIES; i++) {
+        int entry_index = starting_position + i;
+
+        entry_t *entry = &list[entry_index];
+
+        menu_font_style_t style;
+
+        switch (entry->type) {
+            case ENTRY_TYPE_DIR: style = STL_YELLOW; break;
+            case ENTRY_TYPE_ROM: style = STL_DEFAULT; break;
+            case ENTRY_TYPE_ROM_COMPRESSED: style = STL_DEFAULT; break;
+            case ENTRY_TYPE_DISK: style = STL_DEFAULT; break;
+            case ENTRY_TYPE_EMULATOR: style = STL_DEFAULT; break;
+            case ENTRY_TYPE_SAVE: style = STL_GREEN; break;
+            case ENTRY_TYPE_IMAGE: style = STL_BLUE; break;
+            case ENTRY_TYPE_MUSIC: style = STL_BLUE; break;
+            case ENTRY_TYPE_TEXT: style = STL_ORANGE; break;
+            case ENTRY_TYPE_OTHER: style = STL_GRAY; break;
+            case ENTRY_TYPE_ARCHIVE: style = STL_ORANGE; break;
+            case ENTRY_TYPE_ARCHIVED: style = STL_DEFAULT; break;
+            default: style = STL_GRAY; break;
+        }
+
+        rdpq_paragraph_builder_style(style);
+
+        fonts_paragraph_builder_span(entry->name, name_lengths[i]);
+
+        if ((entry_index + 1) >= entries) {
+            break;
+        }
+
+        rdpq_paragraph_builder_newline();
+    }
+
+    names_layout = rdpq_paragraph_builder_end();
+
+    rdpq_paragraph_builder_begin(
+        &(rdpq_textparms_t) {
+            .width = VISIBLE_AREA_WIDTH - LIST_SCROLLBAR_WIDTH - (TEXT_MARGIN_HORIZONTAL * 2),
+            .height = LAYOUT_ACTIONS_SEPARATOR_Y - VISIBLE_AREA_Y0  - (TEXT_MARGIN_VERTICAL * 2),
+            .align = ALIGN_RIGHT,
+            .wrap = WRAP_ELLIPSES,
+            .line_spacing = TEXT_LINE_SPACING_ADJUST,
+        },
+        FNT_DEFAULT,
+        NULL
+    );
+
+    char file_size[16];
+    char rom_tags[24];
+
+    for (int i = starting_position; i < entries; i++) {
+        entry_t *entry = &list[i];
+
+        // NOTE: The tags come from the byte filled in by the header scanner, drawing never reads the ROM headers
+        if (show_tags && (entry->tags & ~ROM_TAG_SCANNED)) {
+            rdpq_paragraph_builder_style(STL_GRAY);
+            rdpq_paragraph_builder_span(rom_tags, format_rom_tags(rom_tags, entry->tags));
+            rdpq_paragraph_builder_style(STL_DEFAULT);
+        }
+
+        if (entry->type != ENTRY_TYPE_DIR) {
+            // TODO: add option to use font icons instead of file sizes.
+            rdpq_paragraph_builder_span(file_size, format_file_size(file_size, entry->size));
+        }
+        else {
+            rdpq_paragraph_builder_span(directory_icon, 5);
+        }
+
+        if ((i + 1) == (starting_position + LIST_ENTRIES)) {
+            break;
+        }
+
+        rdpq_paragraph_builder_newline();
+    }
+
+    sizes_layout = rdpq_paragraph_builder_end();
+
+    if (file_list_cache.display_list) {
+        rdpq_call_deferred(display_list_free, file_list_cache.display_list);
+    }
+
+    rspq_block_begin();
+
+    rdpq_paragraph_render(
+        names_layout,
+        VISIBLE_AREA_X0 + TEXT_MARGIN_HORIZONTAL,
+        VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TAB_HEIGHT + TEXT_OFFSET_VERTICAL
+    );
+
+    rdpq_paragraph_render(
+        sizes_layout,
+        VISIBLE_AREA_X0 + TEXT_MARGIN_HORIZONTAL,
+        VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TAB_HEIGHT + TEXT_OFFSET_VERTICAL
+    );
+
+    file_list_cache.display_list = rspq_block_end();
+
+    file_list_cache.highlight_height = (names_layout->bbox.y1 - names_layout->bbox.y0) / names_layout->nlines;
+
+    rdpq_paragraph_free(names_layout);
+    rdpq_paragraph_free(sizes_layout);
+
+    file_list_cache.valid = true;
+    file_list_cache.list = list;
+    file_list_cache.entries = entries;
+    file_list_cache.starting_position = starting_position;
+    file_list_cache.show_tags = show_tags;
+    file_list_cache.fonts_generation = fonts_get_generation();
+}
+
+/**
+ * @brief Drop the cached rendering of the file list.
+ */
+void ui_components_file_list_invalidate(void) {
+    file_list_cache.valid = false;
+}
+
 /**
  * @brief Draw the file list UI component.
  *
+ * The layouts are only rebuilt when the visible part of the list changes,
+ * moving the selection within it only moves the highlight.
+ *
  * @param list Pointer to the list of file entries.
  * @param entries Number of entries in the list.
  * @param selected Index of the currently selected entry.
+ * @param show_tags Show the ROM tags of the entries next to their sizes.
  */
-void ui_components_file_list_draw(entry_t *list, int entries, int selected) {
+void ui_components_file_list_draw(entry_t *list, int entries, int selected, bool show_tags) {
     int starting_position = 0;
 
     if (entries > LIST_ENTRIES && selected >= (LIST_ENTRIES / 2)) {
@@ -74,75 +299,18 @@ void ui_components_file_list_draw(entry_t *list, int entries, int selected) {
             STL_GRAY
         );
     } else {
-        rdpq_paragraph_t *file_list_layout;
-        rdpq_paragraph_t *layout;
-
-        size_t name_lengths[LIST_ENTRIES];
-        size_t total_length = 1;
-
-        for (int i = 0; i < LIST_ENTRIES; i++) {
-            int entry_index = starting_position + i;
-
-            if (entry_index >= entries) {
-                name_lengths[i] = 0;
-            } else {
-                size_t length = strlen(list[entry_index].name);
-                name_lengths[i] = length;
-                total_length += length;
-            }
-        }
-
-        file_list_layout = malloc(sizeof(rdpq_paragraph_t) + (sizeof(rdpq_paragraph_char_t) * total_length));
-        memset(file_list_layout, 0, sizeof(rdpq_paragraph_t));
-        file_list_layout->capacity = total_length;
-
-        rdpq_paragraph_builder_begin(
-            &(rdpq_textparms_t) {
-                .width = FILE_LIST_MAX_WIDTH - (TEXT_MARGIN_HORIZONTAL * 2),
-                .height = LAYOUT_ACTIONS_SEPARATOR_Y - VISIBLE_AREA_Y0  - (TEXT_MARGIN_VERTICAL * 2),
-                .wrap = WRAP_ELLIPSES,
-                .line_spacing = TEXT_LINE_SPACING_ADJUST,
-            },
-            FNT_DEFAULT,
-            file_list_layout
-        );
-
-        for (int i = 0; i < LIST_ENTRIES; i++) {
-            int entry_index = starting_position + i;
-
-            entry_t *entry = &list[entry_index];
-
-            menu_font_style_t style;
-
-            switch (entry->type) {
-                case ENTRY_TYPE_DIR: style = STL_YELLOW; break;
-                case ENTRY_TYPE_ROM: style = STL_DEFAULT; break;
-                case ENTRY_TYPE_DISK: style = STL_DEFAULT; break;
-                case ENTRY_TYPE_EMULATOR: style = STL_DEFAULT; break;
-                case ENTRY_TYPE_SAVE: style = STL_GREEN; break;
-                case ENTRY_TYPE_IMAGE: style = STL_BLUE; break;
-                case ENTRY_TYPE_MUSIC: style = STL_BLUE; break;
-                case ENTRY_TYPE_TEXT: style = STL_ORANGE; break;
-                case ENTRY_TYPE_OTHER: style = STL_GRAY; break;
-                case ENTRY_TYPE_ARCHIVE: style = STL_ORANGE; break;
-                case ENTRY_TYPE_ARCHIVED: style = STL_DEFAULT; break;
-                default: style = STL_GRAY; break;
-            }
-
-            rdpq_paragraph_builder_style(style);
-
-            rdpq_paragraph_builder_span(entry->name, name_lengths[i]);
-
-            if ((entry_index + 1) >= entries) {
-                break;
-            }
-
-            rdpq_paragraph_builder_newline();
+        if (
+            !file_list_cache.valid ||
+            (file_list_cache.list != list) ||
+            (file_list_cache.entries != entries) ||
+            (file_list_cache.starting_position != starting_position) ||
+            (file_list_cache.show_tags != show_tags) ||
+            (file_list_cache.fonts_generation != fonts_get_generation())
+        ) {
+            file_list_cache_build(list, entries, starting_position, show_tags);
         }
 
-        layout = rdpq_paragraph_builder_end();
-
-        int highlight_height = (layout->bbox.y1 - layout->bbox.y0) / layout->nlines;
+        int highlight_height = file_list_cache.highlight_height;
         int highlight_y = VISIBLE_AREA_Y0 + TAB_HEIGHT + TEXT_MARGIN_VERTICAL + TEXT_OFFSET_VERTICAL + ((selected - starting_position) * highlight_height);
 
         ui_components_box_draw(
@@ -153,54 +321,6 @@ void ui_components_file_list_draw(entry_t *list, int entries, int selected) {
             FILE_LIST_HIGHLIGHT_COLOR
         );
 
-        rdpq_paragraph_render(
-            layout,
-            VISIBLE_AREA_X0 + TEXT_MARGIN_HORIZONTAL,
-            VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TAB_HEIGHT + TEXT_OFFSET_VERTICAL
-        );
-
-        rdpq_paragraph_free(layout);
-
-        rdpq_paragraph_builder_begin(
-            &(rdpq_textparms_t) {
-                .width = VISIBLE_AREA_WIDTH - LIST_SCROLLBAR_WIDTH - (TEXT_MARGIN_HORIZONTAL * 2),
-                .height = LAYOUT_ACTIONS_SEPARATOR_Y - VISIBLE_AREA_Y0  - (TEXT_MARGIN_VERTICAL * 2),
-                .align = ALIGN_RIGHT,
-                .wrap = WRAP_ELLIPSES,
-                .line_spacing = TEXT_LINE_SPACING_ADJUST,
-            },
-            FNT_DEFAULT,
-            NULL
-        );
-
-        char file_size[16];
-
-        for (int i = starting_position; i < entries; i++) {
-            entry_t *entry = &list[i];
-
-            if (entry->type != ENTRY_TYPE_DIR) {
-                // TODO: add option to use font icons instead of file sizes.
-                rdpq_paragraph_builder_span(file_size, format_file_size(file_size, entry->size));
-            }
-            else {
-                rdpq_paragraph_builder_span(directory_icon, 5);
-            }
-
-            if ((i + 1) == (starting_position + LIST_ENTRIES)) {
-                break;
-            }
-
-            rdpq_paragraph_builder_newline();
-        }
-
-        layout = rdpq_paragraph_builder_end();
-
-        rdpq_paragraph_render(
-            layout,
-            VISIBLE_AREA_X0 + TEXT_MARGIN_HORIZONTAL,
-            VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TAB_HEIGHT + TEXT_OFFSET_VERTICAL
-        );
-
-        rdpq_paragraph_free(layout);
+        rspq_block_run(file_list_cache.display_list);
     }
 }
@@ -0,0 +1,236 @@
+/**
+ * @file perf_hud.c
+ * @brief Performance overlay UI component implementation
+ * @ingroup ui_components
+ */
+
+#include <libdragon.h>
+
+#include "../ui_components.h"
+#include "../fonts.h"
+#include "../scheduler.h"
+#include "../telemetry.h"
+#include "constants.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
+
+#define DPC_STATUS_REG          ((volatile uint32_t *) (0xA410000C))
+#define DPC_CLOCK_REG           ((volatile uint32_t *) (0xA4100010))
+#define DPC_PIPEBUSY_REG        ((volatile uint32_t *) (0xA4100018))
+#define DPC_CLR_PIPE_CTR        (1 << 7)
+#define DPC_CLR_CLOCK_CTR       (1 << 9)
+#define DPC_COUNTER_MASK        (0xFFFFFF)
+#define DPC_COUNTER_MAX_US      (250000)
+
+#define SD_WINDOW_US            (1000000)
+
+
+/** @brief Performance overlay state Structure. */
+static struct {
+    bool enabled; /**< Overlay is drawn */
+    bool measuring; /**< Frame times are measured, for the overlay or the telemetry stream */
+    uint64_t frame_start_us; /**< Start time of the current frame */
+    uint32_t frame_us; /**< Frame time running average in microseconds */
+    uint32_t cpu_us; /**< CPU time per frame running average in microseconds */
+    uint32_t last_cpu_us; /**< CPU time of the last frame in microseconds */
+    int rdp_busy; /**< RDP pipeline busy percentage over the last frame */
+
+    uint64_t sd_window_start_us; /**< Start time of the SD throughput window */
+    fs_stats_t sd_window_stats; /**< File helper statistics at the start of the window */
+    uint32_t sd_throughput; /**< SD throughput while transferring in KiB/s */
+    int sd_busy; /**< Percentage of the last window spent transferring */
+
+    uint64_t input_us; /**< Time of the input the current frame responds to */
+    surface_t *finishing_display; /**< Display of the frame the RDP is finishing */
+    uint64_t finishing_input_us; /**< Time of the input of the frame the RDP is finishing */
+    uint32_t input_latency_shown_us; /**< Last input-to-display latency, kept for the overlay */
+    volatile uint64_t presented_input_us; /**< Time of the input of the frame waiting for the scanout */
+    volatile uint32_t input_latency_us; /**< Input-to-display latency of the last input */
+    volatile uint32_t input_latency_max_us; /**< Highest input-to-display latency since the measurement started */
+    bool vi_handler_registered; /**< The scanout handler is registered */
+} hud;
+
+
+static uint32_t average (uint32_t current, uint32_t sample) {
+    return (current == 0) ? sample : (((current * 7) + sample) / 8);
+}
+
+static void sd_window_update (uint64_t now_us) {
+    fs_stats_t *stats = fs_get_stats();
+    uint64_t window_us = now_us - hud.sd_window_start_us;
+
+    if (window_us < SD_WINDOW_US) {
+        return;
+    }
+
+    uint64_t bytes = (stats->read_bytes + stats->written_bytes) - (hud.sd_window_stats.read_bytes + hud.sd_window_stats.written_bytes);
+    uint64_t busy_us = stats->busy_us - hud.sd_window_stats.busy_us;
+
+    hud.sd_throughput = (busy_us > 0) ? (uint32_t) ((bytes * 1000000ULL) / (busy_us * 1024)) : 0;
+    hud.sd_busy = (int) ((busy_us * 100) / window_us);
+
+    hud.sd_window_start_us = now_us;
+    hud.sd_window_stats = *stats;
+}
+
+
+/**
+ * @brief Measure the latency when the frame responding to an input starts being scanned out.
+ *
+ * The VI interrupt fires once per field, a frame shown by display_show is scanned out from the next field.
+ */
+static void vi_handler (void) {
+    if (hud.presented_input_us == 0) {
+        return;
+    }
+
+    uint32_t latency_us = (uint32_t) (get_ticks_us() - hud.presented_input_us);
+    hud.presented_input_us = 0;
+    hud.input_latency_us = latency_us;
+    hud.input_latency_max_us = MAX(hud.input_latency_max_us, latency_us);
+}
+
+/**
+ * @brief Show the display once the RDP finished drawing the frame, the time of its input is handed to the scanout handler.
+ */
+static void frame_finished (void *arg) {
+    display_show(hud.finishing_display);
+    hud.presented_input_us = hud.finishing_input_us;
+}
+
+static void measure_start (void) {
+    hud.frame_us = 0;
+    hud.cpu_us = 0;
+    hud.last_cpu_us = 0;
+    hud.rdp_busy = 0;
+    hud.sd_throughput = 0;
+    hud.sd_busy = 0;
+    hud.frame_start_us = get_ticks_us();
+    hud.sd_window_start_us = hud.frame_start_us;
+    hud.sd_window_stats = *fs_get_stats();
+    hud.input_us = 0;
+    hud.presented_input_us = 0;
+    hud.input_latency_us = 0;
+    hud.input_latency_max_us = 0;
+    hud.input_latency_shown_us = 0;
+    *DPC_STATUS_REG = (DPC_CLR_CLOCK_CTR | DPC_CLR_PIPE_CTR);
+
+    if (!hud.vi_handler_registered) {
+        register_VI_handler(vi_handler);
+        hud.vi_handler_registered = true;
+    }
+}
+
+
+void ui_components_perf_hud_toggle (void) {
+    hud.enabled = !hud.enabled;
+    hud.measuring = false;
+}
+
+void ui_components_perf_hud_frame_begin (void) {
+    bool measure = hud.enabled || telemetry_is_subscribed(TELEMETRY_CHANNEL_FRAME);
+
+    if (!measure || !hud.measuring) {
+        hud.measuring = measure;
+        if (measure) {
+            measure_start();
+        }
+        return;
+    }
+
+    uint64_t now_us = get_ticks_us();
+    uint32_t frame_us = (uint32_t) (now_us - hud.frame_start_us);
+
+    hud.frame_us = average(hud.frame_us, frame_us);
+    hud.frame_start_us = now_us;
+
+    // NOTE: The RDP counters are only 24 bits wide, the reading is kept when the frame was long enough for them to overflow
+    uint32_t clock = (*DPC_CLOCK_REG & DPC_COUNTER_MASK);
+    uint32_t busy = (*DPC_PIPEBUSY_REG & DPC_COUNTER_MASK);
+    if ((frame_us < DPC_COUNTER_MAX_US) && (clock > 0)) {
+        hud.rdp_busy = (int) ((MIN(busy, clock) * 100ULL) / clock);
+    }
+    *DPC_STATUS_REG = (DPC_CLR_CLOCK_CTR | DPC_CLR_PIPE_CTR);
+
+    sd_window_update(now_us);
+
+    disable_interrupts();
+    uint32_t input_latency_us = hud.input_latency_us;
+    hud.input_latency_us = 0;
+    enable_interrupts();
+
+    if (input_latency_us > 0) {
+        hud.input_latency_shown_us = input_latency_us;
+    }
+
+    telemetry_frame(frame_us, hud.last_cpu_us, hud.rdp_busy, input_latency_us / 1000);
+}
+
+void ui_components_perf_hud_input (uint64_t input_us) {
+    hud.input_us = input_us;
+}
+
+/**
+ * @brief Draw the performance overlay.
+ */
+static void perf_hud_draw (void) {
+    heap_stats_t heap;
+    sys_get_heap_stats(&heap);
+
+    scheduler_stats_t *tasks = scheduler_get_stats();
+
+    uint32_t fps_x10 = (hud.frame_us > 0) ? (10000000 / hud.frame_us) : 0;
+    int cpu_busy = (hud.frame_us > 0) ? (int) (MIN(hud.cpu_us, hud.frame_us) * 100 / hud.frame_us) : 0;
+
+    ui_components_box_draw(PERF_HUD_X, PERF_HUD_Y, PERF_HUD_X + PERF_HUD_WIDTH, PERF_HUD_Y + PERF_HUD_HEIGHT, PERF_HUD_BG_COLOR);
+
+    rdpq_text_printf(
+        &(rdpq_textparms_t) {
+            .width = PERF_HUD_WIDTH - (TEXT_MARGIN_HORIZONTAL * 2),
+            .height = PERF_HUD_HEIGHT - (TEXT_MARGIN_VERTICAL * 2),
+            .align = ALIGN_LEFT,
+            .valign = VALIGN_TOP,
+            .wrap = WRAP_NONE,
+        },
+        FNT_DEFAULT,
+        PERF_HUD_X + TEXT_MARGIN_HORIZONTAL,
+        PERF_HUD_Y + TEXT_MARGIN_VERTICAL,
+        "Frame: %lu.%lu ms (%lu.%lu fps)\n"
+        "CPU: %d%%\n"
+        "RDP: %d%%\n"
+        "Heap: %d / %d KiB\n"
+        "Decoder jobs: %d\n"
+        "Tasks: %d queued, %lu overruns\n"
+        "SD: %lu KiB/s, %d%% busy\n"
+        "Input: %lu ms (max %lu ms)",
+        hud.frame_us / 1000, (hud.frame_us / 100) % 10,
+        fps_x10 / 10, fps_x10 % 10,
+        cpu_busy,
+        hud.rdp_busy,
+        heap.used / 1024, heap.total / 1024,
+        png_decoder_get_jobs(),
+        tasks->queue_depth, tasks->overruns,
+        hud.sd_throughput, hud.sd_busy,
+        hud.input_latency_shown_us / 1000, hud.input_latency_max_us / 1000
+    );
+}
+
+void ui_components_detach_show (void) {
+    if (hud.measuring) {
+        hud.last_cpu_us = (uint32_t) (get_ticks_us() - hud.frame_start_us);
+        hud.cpu_us = average(hud.cpu_us, hud.last_cpu_us);
+    }
+
+    if (hud.enabled) {
+        perf_hud_draw();
+    }
+
+    if (hud.measuring && (hud.input_us != 0)) {
+        hud.finishing_display = rdpq_get_attached();
+        hud.finishing_input_us = hud.input_us;
+        hud.input_us = 0;
+        rdpq_detach_cb(frame_finished, NULL);
+    } else {
+        rdpq_detach_show();
+    }
+}
@@ -9,14 +9,77 @@
 //       (for example replace files on the SD card or reboot menu).
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <libcart/cart.h>
+#include <miniz.h>
 #include <usb.h>
 
+#include "benchmark.h"
+#include "cart_load.h"
+#include "file_ops.h"
+#include "flashcart/flashcart.h"
+#ifdef FEATURE_SIMULATION_FLASHCART_ENABLED
+#include "flashcart/sim/sim.h"
+#endif
+#include "rom_info.h"
+#include "telemetry.h"
 #include "usb_comm.h"
+#include "utils/fs.h"
+#include "utils/trace_events.h"
 #include "utils/utils.h"
 
-#define MAX_FILE_SIZE   MiB(4)
+#define MAX_FILE_SIZE       MiB(64)
+#define RECEIVE_CHUNK_SIZE  KiB(256)
+#define BOOT_ROM_PATH       "/menu/usb.z64"
+#define TRACE_EVENTS_FILE   "/menu/trace.json"
+#define ROM_HEADER_SIZE     KiB(4)
+#define BATCH_MANIFEST_SIZE KiB(64)
+#define BATCH_ENTRIES_MAX   (1024)
+#define BATCH_PATH_LENGTH   (256)
+#define POLL_IDLE_INTERVAL_US   (100 * 1000)
+#define POLL_ACTIVE_WINDOW_US   (2 * 1000 * 1000)
+
+/** @brief USB polling state structure. */
+static struct {
+    bool checked; /**< The flashcart USB support was checked */
+    bool supported; /**< The flashcart has an USB interface */
+    uint64_t next_poll_us; /**< Time of the next poll while idle */
+    uint64_t last_activity_us; /**< Time the last message was received */
+} poll_state;
+
+/** @brief Batch transfer entry structure. */
+typedef struct {
+    char path[BATCH_PATH_LENGTH]; /**< File path, relative to the storage root */
+    uint32_t size; /**< File size */
+    uint32_t crc; /**< CRC32 of the file contents */
+    bool needed; /**< The file differs from the one on the SD card */
+    bool done; /**< The file was received and verified */
+} batch_entry_t;
+
+/** @brief Batch transfer session structure, kept until the batch ends so an interrupted transfer can resume. */
+static struct {
+    uint32_t manifest_crc; /**< CRC32 of the manifest */
+    int count; /**< Number of entries */
+    batch_entry_t *entries; /**< Manifest entries */
+    int received; /**< Number of received files */
+    int failed; /**< Number of files failing the checksum check */
+} batch;
+
+/** @brief Batch file receive state structure. */
+typedef struct {
+    uint32_t crc; /**< Running CRC32 of the received data */
+    uint32_t expected_crc; /**< CRC32 from the manifest */
+    uint32_t size; /**< File size */
+    uint64_t usb_us; /**< Time spent reading from USB in microseconds */
+} batch_receive_t;
+
+/** @brief Boot ROM receive state structure. */
+typedef struct {
+    size_t received; /**< Number of bytes read from USB */
+    uint64_t usb_us; /**< Time spent reading from USB in microseconds */
+} boot_receive_t;
 
 /** @brief The supported USB commands structure. */
 typedef struct {
@@ -99,77 +162,636 @@ static void command_reboot (menu_t *menu) {
     menu->boot_params->cheat_list = NULL;
 }
 
+/**
+ * @brief Read the size argument of a data transfer, formatted as "@<size>@".
+ *
+ * @param size Pointer to store the size.
+ * @param max_size Maximum accepted size.
+ * @return true if the argument is invalid, false otherwise.
+ */
+static bool usb_comm_read_size (int *size, int max_size) {
+    char length[12];
+
+    if (usb_comm_get_char() != '@') {
+        usb_comm_send_error("Invalid argument\n");
+        return true;
+    }
+
+    if (usb_comm_read_string(length, sizeof(length), '@')) {
+        usb_comm_send_error("Invalid file length argument\n");
+        return true;
+    }
+
+    *size = atoi(length);
+
+    if ((*size < 0) || (*size > max_size)) {
+        usb_comm_send_error("File size too big\n");
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Read the next chunk of the received file from USB.
+ * 
+ * @param buffer Pointer to the chunk buffer.
+ * @param offset Offset of the chunk in the file.
+ * @param length Length of the chunk.
+ * @param arg Pointer to the time spent reading from USB, in microseconds.
+ * @return false, USB reads can't fail.
+ */
+static bool receive_file_chunk (void *buffer, size_t offset, size_t length, void *arg) {
+    uint64_t start = get_ticks_us();
+    usb_read(buffer, length);
+#ifdef FEATURE_SIMULATION_FLASHCART_ENABLED
+    if (cart_type == CART_NULL) {
+        sim_usb_transfer(length, start);
+    }
+#endif
+    *((uint64_t *) (arg)) += (get_ticks_us() - start);
+    return false;
+}
+
+/**
+ * @brief Send the transfer statistics over USB.
+ *
+ * @param size Number of bytes transferred.
+ * @param total_us Total transfer time in microseconds.
+ * @param usb_us Time spent reading from USB in microseconds.
+ */
+static void usb_comm_send_transfer_stats (int size, uint64_t total_us, uint64_t usb_us) {
+    char message[128];
+    uint32_t rate = (total_us > 0) ? (uint32_t) ((size * 100ULL) / total_us) : 0;
+
+    int length = snprintf(message, sizeof(message),
+        "Received %d bytes in %lu ms (%lu.%02lu MB/s), USB %lu ms, SD %lu ms\n",
+        size,
+        (uint32_t) (total_us / 1000),
+        rate / 100, rate % 100,
+        (uint32_t) (usb_us / 1000),
+        (uint32_t) ((total_us - usb_us) / 1000)
+    );
+
+    usb_write(DATATYPE_TEXT, message, length);
+}
+
 /**
  * @brief Receive a file over USB and save it to the storage.
  * 
  * @param menu Pointer to the menu structure.
  */
 static void command_receive_file (menu_t *menu) {
-    FILE *f;
     char buffer[256];
-    uint8_t data[8192];
-    char length[8];
+    int size;
 
     if (usb_comm_read_string(buffer, sizeof(buffer), ' ')) {
         return usb_comm_send_error("Invalid path argument\n");
     }
 
-    if (usb_comm_get_char() != '@') {
-        return usb_comm_send_error("Invalid argument\n");
+    if (usb_comm_read_size(&size, MAX_FILE_SIZE)) {
+        return;
     }
 
-    if (usb_comm_read_string(length, sizeof(length), '@')) {
-        return usb_comm_send_error("Invalid file length argument\n");
+    // NOTE: The large chunks keep the SD writes in long multi-sector bursts into the contiguously allocated file
+    size_t chunk_size = MIN(RECEIVE_CHUNK_SIZE, ALIGN(MAX(size, 1), FS_SECTOR_SIZE));
+    void *chunk = memalign(16, chunk_size);
+    if (chunk == NULL) {
+        return usb_comm_send_error("Couldn't allocate memory for the file transfer\n");
     }
 
     path_t *path = path_init(menu->storage_prefix, buffer);
+    uint64_t usb_us = 0;
+    uint64_t start = get_ticks_us();
+
+    bool error = file_write_stream_buffered(path_get(path), size, chunk, chunk_size, receive_file_chunk, &usb_us, NULL);
 
-    if ((f = fopen(path_get(path), "wb")) == NULL) {
+    uint64_t total_us = get_ticks_us() - start;
+
+    free(chunk);
+
+    if (error) {
         path_free(path);
-        return usb_comm_send_error("Couldn't create file\n");
+        return usb_comm_send_error("Couldn't write all required data to the file\n");
     }
-    setbuf(f, NULL);
+
+    file_ops_notify_written(path);
     path_free(path);
 
-    int remaining = atoi(length);
+    if (usb_comm_get_char() != '\0') {
+        return usb_comm_send_error("Invalid token at the end of data stream\n");
+    }
+
+    usb_comm_send_transfer_stats(size, total_us, usb_us);
+}
+
+/**
+ * @brief Read the next chunk of the received ROM from USB, keeping track of the received length.
+ *
+ * @param buffer Pointer to the chunk buffer.
+ * @param offset Offset of the chunk in the ROM.
+ * @param length Length of the chunk.
+ * @param arg Pointer to the receive state.
+ * @return false, USB reads can't fail.
+ */
+static bool boot_receive_chunk (void *buffer, size_t offset, size_t length, void *arg) {
+    boot_receive_t *receive = (boot_receive_t *) (arg);
 
-    if (remaining > MAX_FILE_SIZE) {
-        return usb_comm_send_error("File size too big\n");
+    receive_file_chunk(buffer, offset, length, &receive->usb_us);
+    receive->received = (offset + length);
+
+    return false;
+}
+
+/**
+ * @brief Read and discard the rest of an aborted transfer and its end token, so they aren't parsed as the next command.
+ *
+ * @param buffer Pointer to a scratch buffer.
+ * @param buffer_size Size of the scratch buffer.
+ * @param length Number of bytes left in the transfer.
+ */
+static void usb_comm_drain (void *buffer, size_t buffer_size, size_t length) {
+    while (length > 0) {
+        size_t chunk_length = MIN(length, buffer_size);
+        usb_read(buffer, chunk_length);
+        length -= chunk_length;
     }
+    usb_comm_get_char();
+}
 
-    while (remaining > 0) {
-        int block_size = MIN(remaining, sizeof(data));
-        usb_read(data, block_size);
-        if (fwrite(data, 1, block_size, f) != block_size) {
-            fclose(f);
-            return usb_comm_send_error("Couldn't write all required data to the file\n");
-        }
-        remaining -= block_size;
+/**
+ * @brief Receive a ROM over USB straight into the cart SDRAM and boot it, the SD card isn't touched.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void command_boot_rom (menu_t *menu) {
+    int size;
+
+    if (usb_comm_read_size(&size, MAX_FILE_SIZE)) {
+        return;
     }
 
-    if (fclose(f)) {
-        return usb_comm_send_error("Couldn't flush data to the file\n");
+    if (size < ROM_HEADER_SIZE) {
+        return usb_comm_send_error("ROM file too small\n");
     }
 
+    size_t chunk_size = MIN(RECEIVE_CHUNK_SIZE, ALIGN(size, FS_SECTOR_SIZE));
+    void *chunk = memalign(16, chunk_size);
+    if (chunk == NULL) {
+        return usb_comm_send_error("Couldn't allocate memory for the ROM transfer\n");
+    }
+
+    boot_receive_t receive = { 0 };
+    uint64_t start = get_ticks_us();
+
+    // NOTE: The header decides the byte order of the whole stream, so the first chunk is received before the load starts
+    size_t head_length = MIN((size_t) (size), chunk_size);
+    boot_receive_chunk(chunk, 0, head_length, &receive);
+
+    path_t *path = path_init(menu->storage_prefix, BOOT_ROM_PATH);
+    rom_err_t rom_err = rom_config_load_from_header(path, chunk, head_length, &menu->load.rom_info);
+    path_free(path);
+
+    if (rom_err != ROM_OK) {
+        usb_comm_drain(chunk, chunk_size, size - receive.received);
+        free(chunk);
+        return usb_comm_send_error("Couldn't parse the ROM header\n");
+    }
+
+    // NOTE: The first chunk is written out before the buffer is reused for the next one
+    cart_load_err_t err = cart_load_n64_rom_stream(menu, size, chunk, head_length, chunk, chunk_size, boot_receive_chunk, &receive);
+
+    if (err != CART_LOAD_OK) {
+        usb_comm_drain(chunk, chunk_size, size - receive.received);
+        free(chunk);
+        return usb_comm_send_error(cart_load_convert_error_message(err));
+    }
+
+    free(chunk);
+
     if (usb_comm_get_char() != '\0') {
         return usb_comm_send_error("Invalid token at the end of data stream\n");
     }
+
+    usb_comm_send_transfer_stats(size, get_ticks_us() - start, receive.usb_us);
+
+    menu->next_mode = MENU_MODE_BOOT;
+
+    menu->boot_params->device_type = BOOT_DEVICE_TYPE_ROM;
+    menu->boot_params->detect_cic_seed = rom_info_get_cic_seed(&menu->load.rom_info, &menu->boot_params->cic_seed);
+    switch (rom_info_get_tv_type(&menu->load.rom_info)) {
+        case ROM_TV_TYPE_PAL: menu->boot_params->tv_type = BOOT_TV_TYPE_PAL; break;
+        case ROM_TV_TYPE_NTSC: menu->boot_params->tv_type = BOOT_TV_TYPE_NTSC; break;
+        case ROM_TV_TYPE_MPAL: menu->boot_params->tv_type = BOOT_TV_TYPE_MPAL; break;
+        default: menu->boot_params->tv_type = BOOT_TV_TYPE_PASSTHROUGH; break;
+    }
+    menu->boot_params->cheat_list = NULL;
+}
+
+/**
+ * @brief Accumulate the CRC32 of a file chunk.
+ *
+ * @param buffer Pointer to the chunk.
+ * @param offset Offset of the chunk in the file.
+ * @param length Length of the chunk.
+ * @param arg Pointer to the running CRC32.
+ * @return false, the hash can't fail.
+ */
+static bool batch_crc_chunk (void *buffer, size_t offset, size_t length, void *arg) {
+    *((uint32_t *) (arg)) = (uint32_t) (mz_crc32(*((uint32_t *) (arg)), buffer, length));
+    return false;
+}
+
+/**
+ * @brief Check if the file on the SD card already matches a manifest entry.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param entry Pointer to the manifest entry.
+ * @return true if the file is unchanged, false otherwise.
+ */
+static bool batch_entry_unchanged (menu_t *menu, batch_entry_t *entry) {
+    path_t *path = path_init(menu->storage_prefix, entry->path);
+    uint32_t crc = MZ_CRC32_INIT;
+
+    // NOTE: The size is compared first, only the files of the same size are read back for the hash
+    bool unchanged = (file_get_size(path_get(path)) == entry->size) &&
+        !file_read_stream(path_get(path), FS_IO_BUFFER_SIZE, batch_crc_chunk, &crc, NULL) &&
+        (crc == entry->crc);
+
+    path_free(path);
+
+    return unchanged;
+}
+
+/**
+ * @brief Drop the batch transfer session.
+ */
+static void batch_free (void) {
+    free(batch.entries);
+    memset(&batch, 0, sizeof(batch));
+}
+
+/**
+ * @brief Parse the batch manifest, one "<size> <crc32> <path>" line per file.
+ *
+ * @param manifest Manifest text.
+ * @return true if the manifest is invalid, false otherwise.
+ */
+static bool batch_parse_manifest (char *manifest) {
+    batch.entries = calloc(BATCH_ENTRIES_MAX, sizeof(batch_entry_t));
+    if (batch.entries == NULL) {
+        return true;
+    }
+
+    char *line = manifest;
+    while (*line != '\0') {
+        char *end = strchr(line, '\n');
+        if (end != NULL) {
+            *end = '\0';
+        }
+
+        if (*line != '\0') {
+            batch_entry_t *entry = &batch.entries[batch.count];
+            unsigned long size, crc;
+            int offset = 0;
+
+            if ((batch.count == BATCH_ENTRIES_MAX) || (sscanf(line, "%lu %lx %n", &size, &crc, &offset) != 2) || (offset == 0) || (size > MAX_FILE_SIZE)) {
+                return true;
+            }
+
+            strncpy(entry->path, &line[offset], BATCH_PATH_LENGTH - 1);
+            entry->size = (uint32_t) (size);
+            entry->crc = (uint32_t) (crc);
+            batch.count += 1;
+        }
+
+        if (end == NULL) {
+            break;
+        }
+        line = end + 1;
+    }
+
+    return (batch.count == 0);
+}
+
+/**
+ * @brief Start or resume a batch transfer.
+ *
+ * The reply lists the files to send as a string of '0' and '1' characters in the manifest order,
+ * unchanged files and the files received before an interruption of the same batch are skipped.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void command_batch_begin (menu_t *menu) {
+    int size;
+
+    if (usb_comm_read_size(&size, BATCH_MANIFEST_SIZE)) {
+        return;
+    }
+
+    char *manifest = malloc(size + 1);
+    if (manifest == NULL) {
+        return usb_comm_send_error("Couldn't allocate memory for the manifest\n");
+    }
+    usb_read(manifest, size);
+    manifest[size] = '\0';
+
+    uint32_t manifest_crc = (uint32_t) (mz_crc32(MZ_CRC32_INIT, (const uint8_t *) (manifest), size));
+    bool resumed = (batch.entries != NULL) && (batch.manifest_crc == manifest_crc);
+
+    if (!resumed) {
+        batch_free();
+        batch.manifest_crc = manifest_crc;
+        if (batch_parse_manifest(manifest)) {
+            free(manifest);
+            batch_free();
+            return usb_comm_send_error("Invalid batch manifest\n");
+        }
+        for (int i = 0; i < batch.count; i++) {
+            batch.entries[i].needed = !batch_entry_unchanged(menu, &batch.entries[i]);
+        }
+    }
+
+    free(manifest);
+
+    char *reply = malloc(batch.count + 64);
+    if (reply == NULL) {
+        return usb_comm_send_error("Couldn't allocate memory for the reply\n");
+    }
+
+    int needed = 0;
+    int length = sprintf(reply, "batch %s %d ", resumed ? "resume" : "begin", batch.count);
+    for (int i = 0; i < batch.count; i++) {
+        bool send = (batch.entries[i].needed && !batch.entries[i].done);
+        reply[length++] = send ? '1' : '0';
+        needed += send ? 1 : 0;
+    }
+    length += sprintf(&reply[length], " %d\n", needed);
+
+    usb_write(DATATYPE_TEXT, reply, length);
+
+    free(reply);
+}
+
+/**
+ * @brief Read the next chunk of a batch file from USB, verifying the checksum with the last chunk.
+ *
+ * @param buffer Pointer to the chunk buffer.
+ * @param offset Offset of the chunk in the file.
+ * @param length Length of the chunk.
+ * @param arg Pointer to the receive state.
+ * @return true if the checksum doesn't match, false otherwise.
+ */
+static bool batch_receive_chunk (void *buffer, size_t offset, size_t length, void *arg) {
+    batch_receive_t *receive = (batch_receive_t *) (arg);
+
+    receive_file_chunk(buffer, offset, length, &receive->usb_us);
+
+    receive->crc = (uint32_t) (mz_crc32(receive->crc, buffer, length));
+
+    return ((offset + length) == receive->size) && (receive->crc != receive->expected_crc);
+}
+
+/**
+ * @brief Receive a file of the batch, formatted as "<index> @<size>@<data>".
+ *
+ * The host can send the files back to back without waiting for the replies. A file failing the
+ * checksum check is removed, it's sent again when the batch is resumed.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void command_batch_file (menu_t *menu) {
+    char index_string[8];
+    int size;
+
+    if (batch.entries == NULL) {
+        return usb_comm_send_error("No batch in progress\n");
+    }
+
+    if (usb_comm_read_string(index_string, sizeof(index_string), ' ')) {
+        return usb_comm_send_error("Invalid index argument\n");
+    }
+
+    int index = atoi(index_string);
+    if ((index < 0) || (index >= batch.count)) {
+        return usb_comm_send_error("Invalid index argument\n");
+    }
+
+    batch_entry_t *entry = &batch.entries[index];
+
+    if (usb_comm_read_size(&size, MAX_FILE_SIZE)) {
+        return;
+    }
+
+    if (size != entry->size) {
+        return usb_comm_send_error("File size doesn't match the manifest\n");
+    }
+
+    size_t chunk_size = MIN(RECEIVE_CHUNK_SIZE, ALIGN(MAX(size, 1), FS_SECTOR_SIZE));
+    void *chunk = memalign(16, chunk_size);
+    if (chunk == NULL) {
+        return usb_comm_send_error("Couldn't allocate memory for the file transfer\n");
+    }
+
+    batch_receive_t receive = {
+        .crc = MZ_CRC32_INIT,
+        .expected_crc = entry->crc,
+        .size = size,
+    };
+
+    path_t *path = path_init(menu->storage_prefix, entry->path);
+
+    bool error = file_write_stream_buffered(path_get(path), size, chunk, chunk_size, batch_receive_chunk, &receive, NULL);
+    if (size == 0) {
+        error = (receive.crc != receive.expected_crc);
+    }
+
+    free(chunk);
+
+    char reply[64];
+    int length;
+
+    if (error) {
+        batch.failed += 1;
+        length = snprintf(reply, sizeof(reply), "batch fail %d\n", index);
+    } else {
+        file_ops_notify_written(path);
+        entry->done = true;
+        batch.received += 1;
+        length = snprintf(reply, sizeof(reply), "batch ok %d\n", index);
+    }
+
+    path_free(path);
+
+    usb_write(DATATYPE_TEXT, reply, length);
+}
+
+/**
+ * @brief End the batch transfer, reporting the results.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void command_batch_end (menu_t *menu) {
+    char reply[96];
+    int skipped = 0;
+    int missing = 0;
+
+    if (batch.entries == NULL) {
+        return usb_comm_send_error("No batch in progress\n");
+    }
+
+    for (int i = 0; i < batch.count; i++) {
+        skipped += batch.entries[i].needed ? 0 : 1;
+        missing += (batch.entries[i].needed && !batch.entries[i].done) ? 1 : 0;
+    }
+
+    int length = snprintf(reply, sizeof(reply), "batch end %d received, %d skipped, %d failed, %d missing\n", batch.received, skipped, batch.failed, missing);
+
+    batch_free();
+
+    usb_write(DATATYPE_TEXT, reply, length);
+}
+
+/**
+ * @brief Subscribe to the telemetry stream, formatted as "<channel mask> <status interval in ms>", a zero mask stops the stream.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void command_telemetry (menu_t *menu) {
+    char channels_string[12];
+    char interval_string[12];
+    char reply[64];
+
+    if (usb_comm_read_string(channels_string, sizeof(channels_string), ' ')) {
+        return usb_comm_send_error("Invalid channels argument\n");
+    }
+
+    if (usb_comm_read_string(interval_string, sizeof(interval_string), '\0')) {
+        return usb_comm_send_error("Invalid interval argument\n");
+    }
+
+    uint32_t channels = strtoul(channels_string, NULL, 0);
+    uint32_t interval_ms = strtoul(interval_string, NULL, 0);
+
+    telemetry_subscribe(channels, interval_ms);
+
+    int length = snprintf(reply, sizeof(reply), "telemetry %lu %lu\n", channels & TELEMETRY_CHANNEL_ALL, interval_ms);
+
+    usb_write(DATATYPE_TEXT, reply, length);
+}
+
+/**
+ * @brief Run an on-device benchmark, formatted as "<name> <argument>", and reply with its results.
+ *
+ * The ROM load benchmark overwrites the menu ROM, the loaded ROM is booted after the results are sent.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void command_benchmark (menu_t *menu) {
+    char name[32];
+    char argument[256];
+    char reply[192];
+    benchmark_result_t result;
+
+    if (usb_comm_read_string(name, sizeof(name), ' ')) {
+        return usb_comm_send_error("Invalid benchmark name argument\n");
+    }
+
+    if (usb_comm_read_string(argument, sizeof(argument), '\0')) {
+        return usb_comm_send_error("Invalid benchmark argument\n");
+    }
+
+    benchmark_err_t err = benchmark_run(name, menu->storage_prefix, argument, &result);
+
+    int length;
+    if (err != BENCHMARK_OK) {
+        length = snprintf(reply, sizeof(reply), "benchmark %s error %s\n", name, benchmark_convert_error_message(err));
+    } else {
+        length = snprintf(reply, sizeof(reply), "benchmark %s ok bytes=%llu items=%lu total_us=%llu work_us=%llu media_us=%llu\n",
+            name,
+            result.bytes,
+            result.items,
+            result.total_us,
+            result.work_us,
+            result.media_us
+        );
+    }
+
+    usb_write(DATATYPE_TEXT, reply, length);
+
+    if (result.rom_overwritten) {
+        command_reboot(menu);
+    }
+}
+
+/**
+ * @brief Save the event trace ring to the storage in the Chrome trace event format.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void command_trace_dump (menu_t *menu) {
+    char reply[96];
+
+    path_t *path = path_init(menu->storage_prefix, TRACE_EVENTS_FILE);
+    bool error = trace_events_save(path_get(path));
+    path_free(path);
+
+    if (error) {
+        return usb_comm_send_error("Couldn't save the trace\n");
+    }
+
+    int length = snprintf(reply, sizeof(reply), "trace-dump %d events saved to %s\n", trace_events_get_count(), TRACE_EVENTS_FILE);
+
+    usb_write(DATATYPE_TEXT, reply, length);
 }
 
 static usb_comm_command_t commands[] = {
     { .id = "reboot", .op = command_reboot },
+    { .id = "boot-rom", .op = command_boot_rom },
     { .id = "send-file", .op = command_receive_file }, // Note that this is a crossover with the `id` related to the PC commands.
+    { .id = "batch-begin", .op = command_batch_begin },
+    { .id = "batch-file", .op = command_batch_file },
+    { .id = "batch-end", .op = command_batch_end },
+    { .id = "telemetry", .op = command_telemetry },
+    { .id = "benchmark", .op = command_benchmark },
+    { .id = "trace-dump", .op = command_trace_dump },
     { .id = NULL },
 };
 
 /**
  * @brief Poll the USB input for commands.
  * 
+ * The cart USB status is read on every call only for a while after the last received message,
+ * otherwise it's read at a slow rate. Flashcarts without USB support aren't polled at all.
+ * 
  * @param menu Pointer to the menu structure.
  */
 void usb_comm_poll (menu_t *menu) {
+    if (!poll_state.checked) {
+        poll_state.checked = true;
+        poll_state.supported = flashcart_has_feature(FLASHCART_FEATURE_USB);
+    }
+
+    if (!poll_state.supported) {
+        return;
+    }
+
+    uint64_t now = get_ticks_us();
+
+    if (((now - poll_state.last_activity_us) >= POLL_ACTIVE_WINDOW_US) && (now < poll_state.next_poll_us)) {
+        return;
+    }
+
+    poll_state.next_poll_us = now + POLL_IDLE_INTERVAL_US;
+
     uint32_t header = usb_poll();
 
+    if (header == 0) {
+        return;
+    }
+
+    poll_state.last_activity_us = now;
+
     if (USBHEADER_GETTYPE(header) != DATATYPE_TEXT) {
         usb_purge();
         return;
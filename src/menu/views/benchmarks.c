@@ -0,0 +1,336 @@
+/**
+ * @file benchmarks.c
+ * @brief On-device benchmark suite view implementation
+ * @ingroup views
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <libcart/cart.h>
+#include <mini.c/src/mini.h>
+
+#include "../benchmark.h"
+#include "../sound.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
+#include "views.h"
+
+#ifndef MENU_VERSION
+#define MENU_VERSION "Unknown"
+#endif
+
+#define BENCHMARK_DIRECTORY     "/menu/benchmark"
+#define BENCHMARK_RESULTS_FILE  "/menu/bench.ini"
+#define SCENARIO_FILE           "scenario.txt"
+#define SCENARIO_ENTRIES_MAX    (16)
+#define SCENARIO_LINE_LENGTH    (96)
+
+/** @brief Suite entry structure. */
+typedef struct {
+    const char *label; /**< Name shown on screen */
+    const char *benchmark; /**< Benchmark name */
+    const char *file; /**< Reference file in the benchmark directory, NULL for the directory itself */
+    const char *argument; /**< Argument of the benchmarks that don't take a path */
+} suite_entry_t;
+
+/** @brief Suite entry result structure. */
+typedef struct {
+    bool done; /**< The entry was run or skipped */
+    bool skipped; /**< The reference file is missing */
+    benchmark_err_t err; /**< Benchmark error */
+    benchmark_result_t result; /**< Benchmark results */
+} suite_result_t;
+
+// NOTE: The ROM load overwrites the menu ROM the assets are read from, so it must stay the last entry
+static const suite_entry_t suite[] = {
+    { .label = "SD sequential read", .benchmark = "sd-read", .file = "reference.bin" },
+    { .label = "SD random read", .benchmark = "sd-random-read", .file = "reference.bin" },
+    { .label = "PI DMA read", .benchmark = "pi-read", .argument = "1024" },
+    { .label = "PI DMA write", .benchmark = "pi-write", .argument = "1024" },
+    { .label = "PNG decode", .benchmark = "png-decode", .file = "reference.png" },
+    { .label = "MP3 decode", .benchmark = "mp3-decode", .file = "reference.mp3" },
+    { .label = "Directory load", .benchmark = "dir-enum" },
+    { .label = "ROM load", .benchmark = "rom-load", .file = "reference.z64" },
+};
+
+#define SUITE_COUNT     (sizeof(suite) / sizeof(suite[0]))
+
+_Static_assert(SUITE_COUNT <= SCENARIO_ENTRIES_MAX, "Too many suite entries for the results");
+
+static char scenario_lines[SCENARIO_ENTRIES_MAX][SCENARIO_LINE_LENGTH];
+static char scenario_labels[SCENARIO_ENTRIES_MAX][SCENARIO_LINE_LENGTH];
+static suite_entry_t scenario[SCENARIO_ENTRIES_MAX];
+
+static const suite_entry_t *entries;
+static int entries_count;
+static bool scenario_loaded;
+
+static suite_result_t results[SCENARIO_ENTRIES_MAX];
+static int next_entry;
+static bool rom_overwritten;
+static bool results_saved;
+
+
+static const char *format_result (int i) {
+    static char buffer[64];
+    suite_result_t *r = &results[i];
+
+    if (!r->done) {
+        return (i == next_entry) ? "Running..." : "";
+    }
+
+    if (r->skipped) {
+        return "Skipped, no reference file";
+    }
+
+    if (r->err != BENCHMARK_OK) {
+        return benchmark_convert_error_message(r->err);
+    }
+
+    uint64_t us = (r->result.work_us > 0) ? r->result.work_us : r->result.total_us;
+
+    if (r->result.media_us > 0) {
+        sprintf(buffer, "%llu.%02llux real-time", r->result.media_us / MAX(us, 1), ((r->result.media_us * 100) / MAX(us, 1)) % 100);
+    } else if ((r->result.bytes > 0) && (strcmp(entries[i].benchmark, "dir-enum") != 0)) {
+        sprintf(buffer, "%llu KiB/s (%llu ms)", (r->result.bytes * 1000000 / MAX(us, 1)) / 1024, us / 1000);
+    } else {
+        sprintf(buffer, "%lu items in %llu ms", r->result.items, us / 1000);
+    }
+
+    return buffer;
+}
+
+static bool save_results (menu_t *menu) {
+    char buffer[32];
+
+    path_t *path = path_init(menu->storage_prefix, BENCHMARK_RESULTS_FILE);
+    mini_t *ini = mini_create(path_get(path));
+    path_free(path);
+
+    if (ini == NULL) {
+        return true;
+    }
+
+    flashcart_firmware_version_t version = flashcart_get_firmware_version();
+    sprintf(buffer, "%u.%u.%lu", version.major, version.minor, version.revision);
+
+    mini_set_string(ini, "system", "menu_version", MENU_VERSION);
+    mini_set_int(ini, "system", "cart_type", cart_type);
+    mini_set_string(ini, "system", "firmware_version", buffer);
+    mini_set_int(ini, "system", "expansion_pak", is_memory_expanded());
+
+    for (int i = 0; i < entries_count; i++) {
+        suite_result_t *r = &results[i];
+        const char *group = entries[i].benchmark;
+        char scenario_group[16];
+
+        if (scenario_loaded) {
+            sprintf(scenario_group, "scenario_%02d", i);
+            mini_set_string(ini, scenario_group, "benchmark", entries[i].benchmark);
+            mini_set_string(ini, scenario_group, "argument", entries[i].argument);
+            group = scenario_group;
+        }
+
+        if (r->skipped) {
+            mini_set_string(ini, group, "status", "skipped");
+            continue;
+        }
+
+        mini_set_string(ini, group, "status", (r->err == BENCHMARK_OK) ? "ok" : benchmark_convert_error_message(r->err));
+
+        if (r->err == BENCHMARK_OK) {
+            sprintf(buffer, "%llu", r->result.bytes);
+            mini_set_string(ini, group, "bytes", buffer);
+            mini_set_int(ini, group, "items", r->result.items);
+            sprintf(buffer, "%llu", r->result.total_us);
+            mini_set_string(ini, group, "total_us", buffer);
+            sprintf(buffer, "%llu", r->result.work_us);
+            mini_set_string(ini, group, "work_us", buffer);
+            sprintf(buffer, "%llu", r->result.media_us);
+            mini_set_string(ini, group, "media_us", buffer);
+        }
+    }
+
+    bool error = (mini_save(ini, MINI_FLAGS_NONE) != MINI_OK);
+
+    mini_free(ini);
+
+    return error;
+}
+
+/**
+ * @brief Load the scenario file, one "<benchmark> <argument>" line per entry.
+ *
+ * @param menu Pointer to the menu structure.
+ * @return true if there's no scenario file, false otherwise.
+ */
+static bool load_scenario (menu_t *menu) {
+    path_t *path = path_init(menu->storage_prefix, BENCHMARK_DIRECTORY);
+    path_push(path, SCENARIO_FILE);
+    FILE *f = fopen(path_get(path), "r");
+    path_free(path);
+
+    if (f == NULL) {
+        return true;
+    }
+
+    entries_count = 0;
+
+    while ((entries_count < SCENARIO_ENTRIES_MAX) && fgets(scenario_lines[entries_count], SCENARIO_LINE_LENGTH, f)) {
+        char *line = scenario_lines[entries_count];
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if ((line[0] == '\0') || (line[0] == '#')) {
+            continue;
+        }
+
+        snprintf(scenario_labels[entries_count], SCENARIO_LINE_LENGTH, "%s", line);
+
+        char *argument = strchr(line, ' ');
+        if (argument != NULL) {
+            *argument++ = '\0';
+        }
+
+        scenario[entries_count] = (suite_entry_t) {
+            .label = scenario_labels[entries_count],
+            .benchmark = line,
+            .argument = argument ? argument : "",
+        };
+        entries_count += 1;
+    }
+
+    fclose(f);
+
+    return (entries_count == 0);
+}
+
+static void run_next_entry (menu_t *menu) {
+    const suite_entry_t *entry = &entries[next_entry];
+    suite_result_t *r = &results[next_entry];
+
+    path_t *path = path_init(menu->storage_prefix, BENCHMARK_DIRECTORY);
+    if (entry->file) {
+        path_push(path, (char *) (entry->file));
+    }
+
+    bool present = entry->file ? file_exists(path_get(path)) : directory_exists(path_get(path));
+    path_free(path);
+
+    r->done = true;
+
+    if (!entry->argument && !present) {
+        r->skipped = true;
+    } else {
+        char argument[SCENARIO_LINE_LENGTH];
+        snprintf(argument, sizeof(argument), "%s%s%s", entry->argument ? entry->argument : BENCHMARK_DIRECTORY, entry->file ? "/" : "", entry->file ? entry->file : "");
+        r->err = benchmark_run(entry->benchmark, menu->storage_prefix, argument, &r->result);
+        rom_overwritten = rom_overwritten || r->result.rom_overwritten;
+    }
+
+    next_entry += 1;
+}
+
+static void boot_loaded_rom (menu_t *menu) {
+    menu->next_mode = MENU_MODE_BOOT;
+
+    menu->boot_params->device_type = BOOT_DEVICE_TYPE_ROM;
+    menu->boot_params->tv_type = BOOT_TV_TYPE_PASSTHROUGH;
+    menu->boot_params->detect_cic_seed = true;
+    menu->boot_params->cheat_list = NULL;
+}
+
+static void process (menu_t *menu) {
+    // NOTE: Once the ROM load ran the menu can't load its assets anymore, booting the loaded ROM is the only way out
+    if (rom_overwritten) {
+        if (menu->actions.enter) {
+            boot_loaded_rom(menu);
+        }
+        return;
+    }
+
+    if (menu->actions.back && (next_entry >= entries_count)) {
+        sound_play_effect(SFX_EXIT);
+        menu->next_mode = MENU_MODE_BROWSER;
+    }
+}
+
+static void draw (menu_t *menu, surface_t *d) {
+    char text[SCENARIO_ENTRIES_MAX * 80];
+    int length = 0;
+
+    for (int i = 0; i < entries_count; i++) {
+        length += snprintf(text + length, sizeof(text) - length, "%-32.32s %s\n", entries[i].label, format_result(i));
+    }
+
+    rdpq_attach(d, NULL);
+
+    ui_components_background_draw();
+
+    ui_components_layout_draw();
+
+    ui_components_main_text_draw(
+        STL_DEFAULT,
+        ALIGN_CENTER, VALIGN_TOP,
+        "BENCHMARKS"
+    );
+
+    ui_components_main_text_draw(
+        STL_DEFAULT,
+        ALIGN_LEFT, VALIGN_TOP,
+        "\n"
+        "\n"
+        "%s" BENCHMARK_DIRECTORY "\n"
+        "\n"
+        "%s"
+        "\n"
+        "%s",
+        scenario_loaded ? "Scenario: " : "Reference files: ",
+        text,
+        results_saved ? "Results saved to " BENCHMARK_RESULTS_FILE "\n" : ""
+    );
+
+    if (rom_overwritten) {
+        ui_components_actions_bar_text_draw(
+            STL_DEFAULT,
+            ALIGN_LEFT, VALIGN_TOP,
+            "A: Boot the reference ROM\n"
+            "The menu ROM was overwritten by the ROM load"
+        );
+    } else if (next_entry >= entries_count) {
+        ui_components_actions_bar_text_draw(
+            STL_DEFAULT,
+            ALIGN_LEFT, VALIGN_TOP,
+            "\n"
+            "B: Exit"
+        );
+    }
+
+    ui_components_detach_show();
+}
+
+
+void view_benchmark_init (menu_t *menu) {
+    scenario_loaded = !load_scenario(menu);
+    entries = scenario_loaded ? scenario : suite;
+    entries_count = scenario_loaded ? entries_count : SUITE_COUNT;
+
+    memset(results, 0, sizeof(results));
+    next_entry = 0;
+    rom_overwritten = false;
+    results_saved = false;
+}
+
+void view_benchmark_display (menu_t *menu, surface_t *display) {
+    process(menu);
+
+    draw(menu, display);
+
+    // NOTE: One entry runs per frame, after the frame showing it as running
+    if (next_entry < entries_count) {
+        run_next_entry(menu);
+        if (next_entry == entries_count) {
+            results_saved = !save_results(menu);
+        }
+    }
+}
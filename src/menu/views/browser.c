@@ -1,3 +1,4 @@
+#include <ctype.h>
 #include <errno.h>
 #include <miniz.h>
 #include <miniz_zip.h>
@@ -5,84 +6,109 @@
 #include <string.h>
 #include <time.h>
 
+#include <fatfs/ff.h>
+
 #include "../cart_load.h"
+#include "../directory_index.h"
+#include "../file_ops.h"
+#include "../file_types.h"
 #include "../fonts.h"
+#include "../memory_budget.h"
+#include "../rom_info.h"
+#include "../search_index.h"
+#include "../ui_components/constants.h"
 #include "utils/fs.h"
+#include "utils/hash.h"
+#include "utils/utils.h"
 #include "views.h"
 #include "../sound.h"
 
 
 
-static const char *archive_extensions[] = { "zip", NULL };
-static const char *cheat_extensions[] = {"cht", "cheats", "datel", "gameshark", NULL};
-static const char *disk_extensions[] = { "ndd", NULL };
-static const char *emulator_extensions[] = { "nes", "sfc", "smc", "gb", "gbc", "sms", "gg", "sg", "chf", NULL };
-static const char *image_extensions[] = { "png", NULL };
-static const char *music_extensions[] = { "mp3", NULL };
-static const char *n64_rom_extensions[] = { "z64", "n64", "v64", "rom", NULL };
-static const char *patch_extensions[] = { "bps", "ips", "aps", "ups", "xdelta", NULL };
-// TODO: "eep", "sra", "srm", "fla" could be used if transfered from different flashcarts.
-static const char *save_extensions[] = { "sav", NULL };
-static const char *text_extensions[] = { "txt", "ini", "yml", "yaml", NULL };
-
-static const char *hidden_root_paths[] = {
-    "/menu.bin",
-    "/menu",
-    "/N64FlashcartMenu.n64",
-    "/ED64",
-    "/ED64P",
-    "/sc64menu.n64",
+#define HEADER_SCAN_BUDGET_US   (8000)
+#define LOAD_DIRECTORY_BUDGET_US    (10000)
+#define SEARCH_INDEX_BUDGET_US      (4000)
+#define PREFETCH_REST_MS            (150)
+#define LIST_INITIAL_ENTRIES    (64)
+#define DIRECTORY_CACHE_ENTRIES (4)
+#define JUMP_GROUPS_MAX         (48)
+#define JUMP_MENU_ROWS          (16)
+#define NAMES_INITIAL_SIZE      (KiB(4))
+#define ARCHIVED_SIZE_UNKNOWN   (-2) // -1 is reported for members that can't be stat'ed
+
+
+#define HIDDEN_NAMES_BUCKETS    (32)
+
+#define HIDDEN_IN_ROOT          (1 << 0)
+#define HIDDEN_EVERYWHERE       (1 << 1)
+
+typedef struct {
+    const char *name;
+    int scope;
+} hidden_name_t;
+
+static const hidden_name_t hidden_names[] = {
+    { "menu.bin", HIDDEN_IN_ROOT },
+    { "menu", HIDDEN_IN_ROOT },
+    { "N64FlashcartMenu.n64", HIDDEN_IN_ROOT },
+    { "ED64", HIDDEN_IN_ROOT },
+    { "ED64P", HIDDEN_IN_ROOT },
+    { "sc64menu.n64", HIDDEN_IN_ROOT },
     // Windows garbage
-    "/System Volume Information",
+    { "System Volume Information", HIDDEN_IN_ROOT },
+    { "desktop.ini", HIDDEN_EVERYWHERE }, // Windows Explorer settings
+    { "Thumbs.db", HIDDEN_EVERYWHERE },   // Windows Explorer thumbnails
     // macOS garbage
-    "/.fseventsd",
-    "/.Spotlight-V100",
-    "/.Trashes",
-    "/.VolumeIcon.icns",
-    "/.metadata_never_index",
-    NULL,
+    { ".fseventsd", HIDDEN_IN_ROOT },
+    { ".Spotlight-V100", HIDDEN_IN_ROOT },
+    { ".Trashes", HIDDEN_IN_ROOT },
+    { ".VolumeIcon.icns", HIDDEN_IN_ROOT },
+    { ".metadata_never_index", HIDDEN_IN_ROOT },
+    { ".DS_Store", HIDDEN_EVERYWHERE },   // macOS Finder settings
 };
+#define HIDDEN_NAMES_COUNT (sizeof(hidden_names) / sizeof(hidden_names[0]))
 
 struct substr { const char *str; size_t len; };
 #define substr(str) ((struct substr){ str, sizeof(str) - 1 })
 
-static const struct substr hidden_basenames[] = {
-    substr("desktop.ini"), // Windows Explorer settings
-    substr("Thumbs.db"),   // Windows Explorer thumbnails
-    substr(".DS_Store"),   // macOS Finder settings
-};
-#define HIDDEN_BASENAMES_COUNT (sizeof(hidden_basenames) / sizeof(hidden_basenames[0]))
-
 static const struct substr hidden_prefixes[] = {
     substr("._"), // macOS "AppleDouble" metadata files
 };
 #define HIDDEN_PREFIXES_COUNT (sizeof(hidden_prefixes) / sizeof(hidden_prefixes[0]))
 
+static const hidden_name_t *hidden_names_set[HIDDEN_NAMES_BUCKETS];
+static bool hidden_names_set_ready = false;
 
-static bool path_is_hidden (path_t *path) {
-    char *stripped_path = strip_fs_prefix(path_get(path));
 
-    // Check for hidden files based on full path
-    for (size_t i = 0; hidden_root_paths[i] != NULL; i++) {
-        if (strcmp(stripped_path, hidden_root_paths[i]) == 0) {
-            return true;
+static void hidden_names_set_build (void) {
+    for (size_t i = 0; i < HIDDEN_NAMES_COUNT; i++) {
+        uint32_t bucket = fnv1a32_string(hidden_names[i].name) % HIDDEN_NAMES_BUCKETS;
+        while (hidden_names_set[bucket] != NULL) {
+            bucket = (bucket + 1) % HIDDEN_NAMES_BUCKETS;
         }
+        hidden_names_set[bucket] = &hidden_names[i];
     }
 
-    char *basename = file_basename(stripped_path);
-    size_t basename_len = strlen(basename);
+    hidden_names_set_ready = true;
+}
 
+static bool name_is_hidden (const char *name, int scope) {
     // Check for hidden files based on filename
-    for (size_t i = 0; i < HIDDEN_BASENAMES_COUNT; i++) {
-        if (basename_len == hidden_basenames[i].len &&
-            strncmp(basename, hidden_basenames[i].str, hidden_basenames[i].len) == 0) {
+    uint32_t bucket = fnv1a32_string(name) % HIDDEN_NAMES_BUCKETS;
+
+    while (hidden_names_set[bucket] != NULL) {
+        if ((hidden_names_set[bucket]->scope & scope) && (strcmp(name, hidden_names_set[bucket]->name) == 0)) {
             return true;
         }
+        bucket = (bucket + 1) % HIDDEN_NAMES_BUCKETS;
     }
+
     // Check for hidden files based on filename prefix
+    size_t name_len = strlen(name);
+
     for (size_t i = 0; i < HIDDEN_PREFIXES_COUNT; i++) {
-        if (basename_len > hidden_prefixes[i].len &&
-            strncmp(basename, hidden_prefixes[i].str, hidden_prefixes[i].len) == 0) {
+        if (name_len > hidden_prefixes[i].len &&
+            strncmp(name, hidden_prefixes[i].str, hidden_prefixes[i].len) == 0) {
             return true;
         }
     }
@@ -90,77 +116,707 @@ static bool path_is_hidden (path_t *path) {
     return false;
 }
 
-static int compare_entry (const void *pa, const void *pb) {
-    entry_t *a = (entry_t *) (pa);
-    entry_t *b = (entry_t *) (pb);
-
-    if (a->type != b->type) {
-        if (a->type == ENTRY_TYPE_DIR) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_DIR) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_ARCHIVE) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_ARCHIVE) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_DISK) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_DISK) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_EMULATOR) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_EMULATOR) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_IMAGE) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_IMAGE) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_MUSIC) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_MUSIC) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_ROM) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_ROM) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_ROM_CHEAT) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_ROM_CHEAT) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_ROM_PATCH) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_ROM_PATCH) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_SAVE) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_SAVE) {
-            return 1;
-        } else if (a->type == ENTRY_TYPE_TEXT) {
-            return -1;
-        } else if (b->type == ENTRY_TYPE_TEXT) {
-            return 1;
-        }
-    }
-
-    return strcasecmp((const char *) (a->name), (const char *) (b->name));
+#define SORT_KEY_NAME_LENGTH    (7)
+
+static const uint8_t entry_type_rank[] = {
+    [ENTRY_TYPE_DIR] = 0,
+    [ENTRY_TYPE_ARCHIVE] = 1,
+    [ENTRY_TYPE_DISK] = 2,
+    [ENTRY_TYPE_EMULATOR] = 3,
+    [ENTRY_TYPE_IMAGE] = 4,
+    [ENTRY_TYPE_MUSIC] = 5,
+    [ENTRY_TYPE_ROM] = 6,
+    [ENTRY_TYPE_ROM_COMPRESSED] = 6,
+    [ENTRY_TYPE_ROM_CHEAT] = 7,
+    [ENTRY_TYPE_ROM_PATCH] = 8,
+    [ENTRY_TYPE_SAVE] = 9,
+    [ENTRY_TYPE_TEXT] = 10,
+    [ENTRY_TYPE_OTHER] = 11,
+    [ENTRY_TYPE_ARCHIVED] = 11,
+};
+
+static uint64_t make_sort_key (entry_t *entry) {
+    uint64_t key = entry_type_rank[entry->type];
+    const char *name = entry->name;
+
+    for (int i = 0; i < SORT_KEY_NAME_LENGTH; i++) {
+        key <<= 8;
+        if (*name) {
+            key |= (uint8_t) (tolower((unsigned char) (*name++)));
+        }
+    }
+
+    return key;
+}
+
+// NOTE: Sorting runs over a packed array of sort records instead of the entry_t array,
+//       the names stay in the string pool and are only followed on a sort key tie,
+//       then the entries are permuted once in the sorted order.
+#define SORT_SIZE_MASK          (0x00FFFFFFFFFFFFFFULL)
+
+typedef struct {
+    uint64_t key;
+    uint64_t tiebreak;
+    uint32_t name_offset;
+    int32_t position;
+} sort_record_t;
+
+static const char *sort_names = NULL;
+
+static void make_sort_record (sort_record_t *record, entry_t *entry, int32_t position, bool by_size) {
+    if (by_size) {
+        uint64_t size = (entry->size < 0) ? 0 : MIN((uint64_t) (entry->size) + 1, SORT_SIZE_MASK);
+        record->key = (entry->sort_key & ~SORT_SIZE_MASK) | (SORT_SIZE_MASK - size);
+        record->tiebreak = entry->sort_key;
+    } else {
+        record->key = entry->sort_key;
+        record->tiebreak = 0;
+    }
+    record->name_offset = (uint32_t) (entry->name - sort_names);
+    record->position = position;
 }
 
+static int compare_sort_record (const void *pa, const void *pb) {
+    const sort_record_t *a = (const sort_record_t *) (pa);
+    const sort_record_t *b = (const sort_record_t *) (pb);
+
+    if (a->key != b->key) {
+        return (a->key < b->key) ? -1 : 1;
+    }
+
+    if (a->tiebreak != b->tiebreak) {
+        return (a->tiebreak < b->tiebreak) ? -1 : 1;
+    }
+
+    return strcasecmp(&sort_names[a->name_offset], &sort_names[b->name_offset]);
+}
+
+typedef struct {
+    int32_t first;
+    uint8_t rank;
+    char letter;
+} jump_group_t;
+
+static jump_group_t jump_groups[JUMP_GROUPS_MAX];
+static int jump_group_count = 0;
+static bool jump_index_valid = false;
+static char jump_labels[JUMP_MENU_ROWS][24];
+
+/**
+ * @brief Build the index of the first entry of each type and first letter group.
+ *
+ * Groups are only contiguous when the listing is sorted by name.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void jump_index_build (menu_t *menu) {
+    jump_group_count = 0;
+    jump_index_valid = true;
+
+    if (menu->browser.loading || (menu->browser.sort != BROWSER_SORT_NAME)) {
+        return;
+    }
+
+    for (int32_t i = 0; (i < menu->browser.entries) && (jump_group_count < JUMP_GROUPS_MAX); i++) {
+        entry_t *entry = &menu->browser.list[i];
+        uint8_t rank = (entry->sort_key >> 56);
+        char letter = tolower((unsigned char) (entry->name[0]));
+
+        if ((jump_group_count == 0) || (jump_groups[jump_group_count - 1].rank != rank) || (jump_groups[jump_group_count - 1].letter != letter)) {
+            jump_groups[jump_group_count++] = (jump_group_t) { .first = i, .rank = rank, .letter = letter };
+        }
+    }
+}
+
+/**
+ * @brief Find the group holding an entry.
+ *
+ * @param position Index of the entry in the sorted list.
+ * @return int Index of the group, or -1 if the index is empty.
+ */
+static int jump_index_find (int32_t position) {
+    int low = 0;
+    int high = jump_group_count - 1;
+    int found = -1;
+
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (jump_groups[middle].first <= position) {
+            found = middle;
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    return found;
+}
+
+static void jump_to_group (menu_t *menu, int group) {
+    if ((group < 0) || (group >= jump_group_count)) {
+        return;
+    }
+    menu->browser.selected = jump_groups[group].first;
+    menu->browser.entry = &menu->browser.list[menu->browser.selected];
+}
+
+/**
+ * @brief Move the selection to the first entry of the next or previous letter group.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param direction 1 for the next group, -1 for the previous group.
+ * @return true if the selection was moved, false otherwise.
+ */
+static bool jump_letter (menu_t *menu, int direction) {
+    if (!jump_index_valid) {
+        jump_index_build(menu);
+    }
+
+    int group = jump_index_find(menu->browser.selected);
+
+    if (group < 0) {
+        return false;
+    }
+
+    if ((direction < 0) && (jump_groups[group].first != menu->browser.selected)) {
+        jump_to_group(menu, group);
+        return true;
+    }
+
+    if ((group + direction < 0) || (group + direction >= jump_group_count)) {
+        return false;
+    }
+
+    jump_to_group(menu, group + direction);
+
+    return true;
+}
+
+/**
+ * @brief Read the sizes of the archived entries in a range of the list that weren't stat'ed yet.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param first Index of the first entry.
+ * @param last Index of the last entry.
+ * @return true if any entry was updated, false otherwise.
+ */
+static bool archive_stat_entries (menu_t *menu, int32_t first, int32_t last) {
+    bool updated = false;
+
+    first = MAX(first, 0);
+    last = MIN(last, menu->browser.entries - 1);
+
+    for (int32_t i = first; i <= last; i++) {
+        entry_t *entry = &menu->browser.list[i];
+        mz_zip_archive_file_stat info;
+
+        if ((entry->type != ENTRY_TYPE_ARCHIVED) || (entry->size != ARCHIVED_SIZE_UNKNOWN)) {
+            continue;
+        }
+
+        entry->size = mz_zip_reader_file_stat(&menu->browser.zip, entry->index, &info) ? (int64_t) (info.m_uncomp_size) : -1;
+        updated = true;
+    }
+
+    return updated;
+}
+
+/**
+ * @brief Sort the list in the current sort order.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param keep_selection Keep the selected entry selected, otherwise the first entry is selected.
+ */
+static void browser_list_sort (menu_t *menu, bool keep_selection) {
+    char *selected_name = (keep_selection && menu->browser.entry) ? menu->browser.entry->name : NULL;
+
+    if (menu->browser.archive && (menu->browser.sort == BROWSER_SORT_SIZE)) {
+        archive_stat_entries(menu, 0, menu->browser.entries - 1);
+    }
+
+    jump_index_valid = false;
+    ui_components_file_list_invalidate();
+
+    int32_t entries = menu->browser.entries;
+    bool by_size = (menu->browser.sort == BROWSER_SORT_SIZE);
+
+    if (entries < 2) {
+        return;
+    }
+
+    size_t records_size = entries * sizeof(sort_record_t);
+    sort_record_t *records = memory_budget_reserve(records_size) ? NULL : malloc(records_size);
+
+    if (records == NULL) {
+        return;
+    }
+
+    sort_names = menu->browser.names;
+
+    for (int32_t i = 0; i < entries; i++) {
+        make_sort_record(&records[i], &menu->browser.list[i], i, by_size);
+    }
+
+    qsort(records, entries, sizeof(sort_record_t), compare_sort_record);
+
+    // NOTE: Permute in place by following the cycles, every moved slot is marked done
+    for (int32_t i = 0; i < entries; i++) {
+        if ((records[i].position < 0) || (records[i].position == i)) {
+            continue;
+        }
+
+        entry_t first = menu->browser.list[i];
+        int32_t slot = i;
+
+        while (records[slot].position != i) {
+            int32_t source = records[slot].position;
+            menu->browser.list[slot] = menu->browser.list[source];
+            records[slot].position = -1;
+            slot = source;
+        }
+
+        menu->browser.list[slot] = first;
+        records[slot].position = -1;
+    }
+
+    free(records);
+
+    menu->browser.scan_position = 0;
+
+    if (!keep_selection) {
+        menu->browser.selected = (menu->browser.entries > 0) ? 0 : -1;
+        menu->browser.entry = (menu->browser.entries > 0) ? &menu->browser.list[0] : NULL;
+        return;
+    }
+
+    for (int32_t i = 0; i < menu->browser.entries; i++) {
+        if (menu->browser.list[i].name == selected_name) {
+            menu->browser.selected = i;
+            menu->browser.entry = &menu->browser.list[i];
+            break;
+        }
+    }
+}
+
+static uint32_t make_listing_filter (bool hide_protected, bool hide_saves) {
+    return ((hide_protected ? (1 << 0) : 0) | (hide_saves ? (1 << 1) : 0));
+}
+
+static path_t *load_path = NULL;
+static dir_t load_info;
+static int load_result;
+static bool load_hide_protected;
+static bool load_hide_saves;
+static int load_hidden_scope;
+static uint32_t load_filter;
+static char *load_select_name = NULL;
+static int32_t load_select_index = -1;
+static bool load_selection_moved;
+
+static int32_t list_capacity = 0;
+static size_t names_length = 0;
+static size_t names_capacity = 0;
+
+typedef struct {
+    char *directory;
+    uint32_t timestamp;
+    uint32_t last_used;
+    bool hide_protected;
+    bool hide_saves;
+    browser_sort_t sort;
+    entry_t *list;
+    char *names;
+    int32_t entries;
+    int32_t list_capacity;
+    size_t names_length;
+    size_t names_capacity;
+    int32_t selected;
+    size_t size;
+    bool pinned;
+} directory_cache_entry_t;
+
+static directory_cache_entry_t directory_cache[DIRECTORY_CACHE_ENTRIES];
+static uint32_t directory_cache_clock = 0;
+static bool directory_cache_restored = false;
+static size_t directory_cache_size = 0;
+
 static void browser_list_free (menu_t *menu) {
     if (menu->browser.archive) {
         mz_zip_reader_end(&menu->browser.zip);
     }
     menu->browser.archive = false;
 
-    for (int i = menu->browser.entries - 1; i >= 0; i--) {
-        free(menu->browser.list[i].name);
-    }
+    path_free(load_path);
+    load_path = NULL;
+    menu->browser.loading = false;
+
+    free(load_select_name);
+    load_select_name = NULL;
+    load_select_index = -1;
 
     free(menu->browser.list);
+    free(menu->browser.names);
+
+    jump_index_valid = false;
+    ui_components_file_list_invalidate();
+
+    list_capacity = 0;
+    names_length = 0;
+    names_capacity = 0;
 
     menu->browser.list = NULL;
+    menu->browser.names = NULL;
     menu->browser.entries = 0;
     menu->browser.entry = NULL;
     menu->browser.selected = -1;
+    menu->browser.scan_position = 0;
+}
+
+static bool get_directory_timestamp (path_t *path, uint32_t *timestamp) {
+    FILINFO info;
+
+    if (path_is_root(path) || (f_stat(strip_fs_prefix(path_get(path)), &info) != FR_OK)) {
+        return true;
+    }
+
+    *timestamp = ((info.fdate << 16) | info.ftime);
+
+    return false;
+}
+
+static void directory_cache_entry_free (directory_cache_entry_t *cached) {
+    directory_cache_size -= cached->size;
+    free(cached->directory);
+    free(cached->list);
+    free(cached->names);
+    memset(cached, 0, sizeof(directory_cache_entry_t));
+}
+
+static size_t directory_cache_usage (void) {
+    return directory_cache_size;
+}
+
+/**
+ * @brief Drop the least recently used cached listing.
+ *
+ * A pinned entry holds the browser's own listing while a cached listing is patched, it's never dropped.
+ *
+ * @return true if there was a listing to drop, false otherwise.
+ */
+static bool directory_cache_evict_oldest (void) {
+    directory_cache_entry_t *oldest = NULL;
+
+    for (int i = 0; i < DIRECTORY_CACHE_ENTRIES; i++) {
+        if (directory_cache[i].directory && !directory_cache[i].pinned && ((oldest == NULL) || (directory_cache[i].last_used < oldest->last_used))) {
+            oldest = &directory_cache[i];
+        }
+    }
+
+    if (oldest == NULL) {
+        return false;
+    }
+
+    directory_cache_entry_free(oldest);
+
+    return true;
+}
+
+/**
+ * @brief Keep the complete listing of the current directory in the cache instead of freeing it.
+ *
+ * The least recently used listings are dropped when the cache is full or over its memory quota.
+ * Root and archive listings are not cached, since their timestamp can't be checked.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void directory_cache_stash (menu_t *menu) {
+    uint32_t timestamp;
+
+    if (menu->browser.archive || menu->browser.loading || (menu->browser.list == NULL)) {
+        return;
+    }
+
+    if (get_directory_timestamp(menu->browser.directory, &timestamp)) {
+        return;
+    }
+
+    memory_budget_register(MEMORY_CACHE_DIRECTORY, directory_cache_usage, directory_cache_evict_oldest);
+
+    size_t size = (list_capacity * sizeof(entry_t)) + names_capacity;
+
+    while (memory_budget_over_quota(MEMORY_CACHE_DIRECTORY, size) && directory_cache_evict_oldest());
+
+    if (memory_budget_over_quota(MEMORY_CACHE_DIRECTORY, size)) {
+        return;
+    }
+
+    directory_cache_entry_t *cached = &directory_cache[0];
+    for (int i = 0; i < DIRECTORY_CACHE_ENTRIES; i++) {
+        if (directory_cache[i].directory == NULL) {
+            cached = &directory_cache[i];
+            break;
+        }
+        if (directory_cache[i].last_used < cached->last_used) {
+            cached = &directory_cache[i];
+        }
+    }
+    directory_cache_entry_free(cached);
+
+    *cached = (directory_cache_entry_t) {
+        .directory = strdup(path_get(menu->browser.directory)),
+        .timestamp = timestamp,
+        .last_used = ++directory_cache_clock,
+        .hide_protected = !menu->settings.show_protected_entries,
+        .hide_saves = !menu->settings.show_saves_folder,
+        .sort = menu->browser.sort,
+        .list = menu->browser.list,
+        .names = menu->browser.names,
+        .entries = menu->browser.entries,
+        .list_capacity = list_capacity,
+        .names_length = names_length,
+        .names_capacity = names_capacity,
+        .selected = menu->browser.selected,
+        .size = size,
+    };
+
+    directory_cache_size += size;
+
+    if (cached->directory == NULL) {
+        directory_cache_entry_free(cached);
+        return;
+    }
+
+    menu->browser.list = NULL;
+    menu->browser.names = NULL;
+    menu->browser.entries = 0;
+}
+
+/**
+ * @brief Restore the listing of the current directory from the cache.
+ *
+ * @param menu Pointer to the menu structure.
+ * @return true if the listing was restored, false otherwise.
+ */
+static bool directory_cache_restore (menu_t *menu) {
+    uint32_t timestamp;
+
+    for (int i = 0; i < DIRECTORY_CACHE_ENTRIES; i++) {
+        directory_cache_entry_t *cached = &directory_cache[i];
+
+        if ((cached->directory == NULL) || (strcmp(cached->directory, path_get(menu->browser.directory)) != 0)) {
+            continue;
+        }
+
+        if (
+            get_directory_timestamp(menu->browser.directory, &timestamp) ||
+            (cached->timestamp != timestamp) ||
+            (cached->hide_protected != !menu->settings.show_protected_entries) ||
+            (cached->hide_saves != !menu->settings.show_saves_folder)
+        ) {
+            directory_cache_entry_free(cached);
+            return false;
+        }
+
+        ui_components_file_list_invalidate();
+
+        menu->browser.list = cached->list;
+        menu->browser.names = cached->names;
+        menu->browser.entries = cached->entries;
+        menu->browser.selected = cached->selected;
+        menu->browser.entry = (menu->browser.selected >= 0) ? &menu->browser.list[menu->browser.selected] : NULL;
+        list_capacity = cached->list_capacity;
+        names_length = cached->names_length;
+        names_capacity = cached->names_capacity;
+
+        bool sorted = (cached->sort == menu->browser.sort);
+
+        cached->list = NULL;
+        cached->names = NULL;
+        directory_cache_entry_free(cached);
+
+        if (!sorted) {
+            browser_list_sort(menu, true);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Drop all cached directory listings.
+ */
+static void directory_cache_clear (void) {
+    for (int i = 0; i < DIRECTORY_CACHE_ENTRIES; i++) {
+        directory_cache_entry_free(&directory_cache[i]);
+    }
+}
+
+/**
+ * @brief Append an entry to the list, growing the list and the name pool geometrically.
+ *
+ * Entry names point into the name pool, they are moved along with the pool when it grows.
+ * The name space is reserved but left for the caller to fill in.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param name_size Size of the name, including the terminator.
+ * @return entry_t* Pointer to the new entry, or NULL if out of memory.
+ */
+static entry_t *browser_list_reserve (menu_t *menu, size_t name_size) {
+    if (menu->browser.entries == list_capacity) {
+        int32_t capacity = MAX(LIST_INITIAL_ENTRIES, list_capacity * 2);
+        memory_budget_reserve(capacity * sizeof(entry_t));
+        entry_t *list = realloc(menu->browser.list, capacity * sizeof(entry_t));
+        if (!list) {
+            return NULL;
+        }
+        menu->browser.list = list;
+        list_capacity = capacity;
+    }
+
+    if ((names_length + name_size) > names_capacity) {
+        size_t capacity = MAX(NAMES_INITIAL_SIZE, names_capacity * 2);
+        while (capacity < (names_length + name_size)) {
+            capacity *= 2;
+        }
+        memory_budget_reserve(capacity);
+        char *names = realloc(menu->browser.names, capacity);
+        if (!names) {
+            return NULL;
+        }
+        if (names != menu->browser.names) {
+            for (int32_t i = 0; i < menu->browser.entries; i++) {
+                menu->browser.list[i].name = names + (menu->browser.list[i].name - menu->browser.names);
+            }
+        }
+        menu->browser.names = names;
+        names_capacity = capacity;
+    }
+
+    entry_t *entry = &menu->browser.list[menu->browser.entries++];
+    entry->name = &menu->browser.names[names_length];
+    entry->tags = 0;
+    names_length += name_size;
+
+    return entry;
+}
+
+/**
+ * @brief Append an entry with a copy of the name to the list.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param name Name of the entry.
+ * @return entry_t* Pointer to the new entry, or NULL if out of memory.
+ */
+static entry_t *browser_list_add (menu_t *menu, const char *name) {
+    size_t name_size = strlen(name) + 1;
+
+    entry_t *entry = browser_list_reserve(menu, name_size);
+    if (entry) {
+        memcpy(entry->name, name, name_size);
+    }
+
+    return entry;
+}
+
+/**
+ * @brief Build the entry sort keys once the listing is complete.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void browser_list_finalize (menu_t *menu) {
+    for (int32_t i = 0; i < menu->browser.entries; i++) {
+        menu->browser.list[i].sort_key = make_sort_key(&menu->browser.list[i]);
+    }
+}
+
+/**
+ * @brief Remove an entry from the sorted list, its name is left in the pool until the listing is freed.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param name Name of the entry.
+ * @return true if the entry was found, false otherwise.
+ */
+static bool browser_list_remove (menu_t *menu, const char *name) {
+    for (int32_t i = 0; i < menu->browser.entries; i++) {
+        if (strcmp(menu->browser.list[i].name, name) != 0) {
+            continue;
+        }
+
+        memmove(&menu->browser.list[i], &menu->browser.list[i + 1], (menu->browser.entries - i - 1) * sizeof(entry_t));
+        menu->browser.entries -= 1;
+
+        if ((menu->browser.selected > i) || (menu->browser.selected >= menu->browser.entries)) {
+            menu->browser.selected -= 1;
+        }
+        menu->browser.entry = (menu->browser.selected >= 0) ? &menu->browser.list[menu->browser.selected] : NULL;
+
+        jump_index_valid = false;
+        ui_components_file_list_invalidate();
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Insert an entry into the sorted list at its sorted position.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param name Name of the entry.
+ * @param type Type of the entry.
+ * @param size Size of the entry.
+ * @return true if out of memory, false otherwise.
+ */
+static bool browser_list_insert (menu_t *menu, const char *name, entry_type_t type, int64_t size) {
+    entry_t *entry = browser_list_add(menu, name);
+    if (!entry) {
+        return true;
+    }
+
+    entry->type = type;
+    entry->size = size;
+    entry->index = menu->browser.entries - 1;
+    entry->sort_key = make_sort_key(entry);
+
+    entry_t added = *entry;
+    bool by_size = (menu->browser.sort == BROWSER_SORT_SIZE);
+    sort_record_t record;
+    sort_record_t probe;
+
+    sort_names = menu->browser.names;
+    make_sort_record(&record, &added, 0, by_size);
+
+    int32_t low = 0;
+    int32_t high = menu->browser.entries - 1;
+
+    while (low < high) {
+        int32_t middle = low + ((high - low) / 2);
+        make_sort_record(&probe, &menu->browser.list[middle], middle, by_size);
+        if (compare_sort_record(&probe, &record) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    memmove(&menu->browser.list[low + 1], &menu->browser.list[low], (menu->browser.entries - 1 - low) * sizeof(entry_t));
+    menu->browser.list[low] = added;
+
+    // NOTE: The scanner skips the entries that already have their tags, so going back only costs a pass over the list
+    menu->browser.scan_position = MIN(menu->browser.scan_position, low);
+
+    if ((menu->browser.selected < 0) || (menu->browser.selected >= low)) {
+        menu->browser.selected = (menu->browser.selected < 0) ? low : (menu->browser.selected + 1);
+    }
+    menu->browser.entry = &menu->browser.list[menu->browser.selected];
+
+    jump_index_valid = false;
+    ui_components_file_list_invalidate();
+
+    return false;
 }
 
 static bool load_archive (menu_t *menu) {
@@ -172,145 +828,214 @@ static bool load_archive (menu_t *menu) {
     }
 
     menu->browser.archive = true;
-    menu->browser.entries = (int32_t)mz_zip_reader_get_num_files(&menu->browser.zip);
-    menu->browser.list = malloc(menu->browser.entries * sizeof(entry_t));
-    if (!menu->browser.list) {
-        browser_list_free(menu);
-        return true;
-    }
 
-    for (int32_t i = 0; i < menu->browser.entries; i++) {
-        entry_t *entry = &menu->browser.list[i];
+    int32_t files = (int32_t)mz_zip_reader_get_num_files(&menu->browser.zip);
 
-        mz_zip_archive_file_stat info;
-        if (!mz_zip_reader_file_stat(&menu->browser.zip, i, &info)) {
+    // NOTE: Names are copied straight from the central directory, members are only stat'ed once they're shown
+    for (int32_t i = 0; i < files; i++) {
+        mz_uint name_size = mz_zip_reader_get_filename(&menu->browser.zip, i, NULL, 0);
+        if (name_size == 0) {
             browser_list_free(menu);
             return true;
         }
 
-        entry->name = strdup(info.m_filename);
-        if (!entry->name) {
+        entry_t *entry = browser_list_reserve(menu, name_size);
+        if (!entry) {
             browser_list_free(menu);
             return true;
         }
 
+        mz_zip_reader_get_filename(&menu->browser.zip, i, entry->name, name_size);
+
         entry->type = ENTRY_TYPE_ARCHIVED;
-        entry->size = info.m_uncomp_size;
+        entry->size = ARCHIVED_SIZE_UNKNOWN;
         entry->index = i;
     }
 
-    if (menu->browser.entries > 0) {
-        menu->browser.selected = 0;
-        menu->browser.entry = &menu->browser.list[menu->browser.selected];
-    }
+    browser_list_finalize(menu);
 
-    qsort(menu->browser.list, menu->browser.entries, sizeof(entry_t), compare_entry);
+    browser_list_sort(menu, false);
 
     return false;
 }
 
-static bool load_directory (menu_t *menu) {
-    int result;
-    dir_t info;
-
-    browser_list_free(menu);
+static void apply_pending_selection (menu_t *menu) {
+    if (load_select_name) {
+        for (int32_t i = 0; i < menu->browser.entries; i++) {
+            if (strcmp(menu->browser.list[i].name, load_select_name) == 0) {
+                menu->browser.selected = i;
+                break;
+            }
+        }
+    } else if (load_select_index >= 0) {
+        menu->browser.selected = MIN(load_select_index, menu->browser.entries - 1);
+    }
+    menu->browser.entry = menu->browser.selected >= 0 ? &menu->browser.list[menu->browser.selected] : NULL;
 
-    path_t *path = path_clone(menu->browser.directory);
+    free(load_select_name);
+    load_select_name = NULL;
+    load_select_index = -1;
+}
 
-    result = dir_findfirst(path_get(path), &info);
+/**
+ * @brief Select an entry once the directory listing is complete.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param name Name of the entry to select, or NULL to select by index.
+ * @param index Index of the entry to select when no name is given.
+ */
+static void select_entry_on_load (menu_t *menu, char *name, int32_t index) {
+    free(load_select_name);
+    load_select_name = name ? strdup(name) : NULL;
+    load_select_index = index;
+
+    if (!menu->browser.loading) {
+        apply_pending_selection(menu);
+    }
+}
 
-    while (result == 0) {
+/**
+ * @brief Continue the directory enumeration started by load_directory.
+ *
+ * The entries read so far are shown while the enumeration continues across frames,
+ * the listing is sorted once it's complete.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param budget_us Maximum time to spend reading entries.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool load_directory_continue (menu_t *menu, uint64_t budget_us) {
+    uint64_t start = get_ticks_us();
+
+    while ((load_result == 0) && ((get_ticks_us() - start) < budget_us)) {
         bool hide = false;
 
-        if (!menu->settings.show_protected_entries) {
-            path_push(path, info.d_name);
-            hide = path_is_hidden(path);
-            path_pop(path);
+        if (load_hide_protected) {
+            hide = name_is_hidden(load_info.d_name, load_hidden_scope);
         }
 
-        if (!menu->settings.show_saves_folder) {
-            path_push(path, info.d_name);
-            // Skip the "saves" directory if it is hidden (this is case sensitive)
-            if (strcmp(info.d_name, SAVE_DIRECTORY_NAME) == 0) {
-                hide = true;
-            }
-            path_pop(path);
+        // Skip the "saves" directory if it is hidden (this is case sensitive)
+        if (load_hide_saves && (strcmp(load_info.d_name, SAVE_DIRECTORY_NAME) == 0)) {
+            hide = true;
         }
 
         if (!hide) {
-            menu->browser.list = realloc(menu->browser.list, (menu->browser.entries + 1) * sizeof(entry_t));
-
-            entry_t *entry = &menu->browser.list[menu->browser.entries++];
-
-            entry->name = strdup(info.d_name);
-            if (!entry->name) {
-                path_free(path);
+            entry_t *entry = browser_list_add(menu, load_info.d_name);
+            if (!entry) {
                 browser_list_free(menu);
                 return true;
             }
 
-            if (info.d_type == DT_DIR) {
+            if (load_info.d_type == DT_DIR) {
                 entry->type = ENTRY_TYPE_DIR;
-            } else if (file_has_extensions(entry->name, n64_rom_extensions)) {
-                entry->type = ENTRY_TYPE_ROM;
-            } else if (file_has_extensions(entry->name, disk_extensions)) {
-                entry->type = ENTRY_TYPE_DISK;
-            } else if (file_has_extensions(entry->name, patch_extensions)) {
-                entry->type = ENTRY_TYPE_ROM_PATCH;
-            } else if (file_has_extensions(entry->name, cheat_extensions)) {
-                entry->type = ENTRY_TYPE_ROM_CHEAT;
-            } else if (file_has_extensions(entry->name, emulator_extensions)) {
-                entry->type = ENTRY_TYPE_EMULATOR;
-            } else if (file_has_extensions(entry->name, save_extensions)) {
-                entry->type = ENTRY_TYPE_SAVE;
-            } else if (file_has_extensions(entry->name, image_extensions)) {
-                entry->type = ENTRY_TYPE_IMAGE;
-            } else if (file_has_extensions(entry->name, text_extensions)) {
-                entry->type = ENTRY_TYPE_TEXT;
-            } else if (file_has_extensions(entry->name, music_extensions)) {
-                entry->type = ENTRY_TYPE_MUSIC;
-            } else if (file_has_extensions(entry->name, archive_extensions)) {
-                entry->type = ENTRY_TYPE_ARCHIVE;
             } else {
-                entry->type = ENTRY_TYPE_OTHER;
+                entry->type = file_type_get(load_info.d_name);
             }
 
-            entry->size = info.d_size;
+            entry->size = load_info.d_size;
             entry->index = menu->browser.entries - 1;
         }
 
-        result = dir_findnext(path_get(path), &info);
+        load_result = dir_findnext(path_get(load_path), &load_info);
     }
 
-    path_free(path);
-
-    if (result < -1) {
+    if (load_result < -1) {
         browser_list_free(menu);
         return true;
     }
 
-    if (menu->browser.entries > 0) {
+    if ((menu->browser.selected < 0) && (menu->browser.entries > 0)) {
         menu->browser.selected = 0;
-        menu->browser.entry = &menu->browser.list[menu->browser.selected];
+    }
+    menu->browser.entry = menu->browser.selected >= 0 ? &menu->browser.list[menu->browser.selected] : NULL;
+
+    if (load_result == 0) {
+        return false;
+    }
+
+    path_free(load_path);
+    load_path = NULL;
+    menu->browser.loading = false;
+
+    browser_list_finalize(menu);
+
+    // NOTE: The first entry read isn't the first one once sorted, the selection is only kept when the user moved it during the enumeration
+    browser_list_sort(menu, load_selection_moved);
+
+    if (menu->browser.entries >= DIRECTORY_INDEX_MIN_ENTRIES) {
+        directory_index_save(menu->browser.directory, &((directory_index_listing_t) {
+            .list = menu->browser.list,
+            .names = menu->browser.names,
+            .entries = menu->browser.entries,
+            .names_length = names_length,
+            .filter = load_filter,
+            .sort = menu->browser.sort,
+        }));
     }
 
-    qsort(menu->browser.list, menu->browser.entries, sizeof(entry_t), compare_entry);
+    apply_pending_selection(menu);
 
     return false;
 }
 
+static bool load_directory (menu_t *menu) {
+    browser_list_free(menu);
+
+    load_hide_protected = !menu->settings.show_protected_entries;
+    load_hide_saves = !menu->settings.show_saves_folder;
+    load_filter = make_listing_filter(load_hide_protected, load_hide_saves);
+
+    if ((directory_cache_restored = directory_cache_restore(menu))) {
+        return false;
+    }
+
+    directory_index_listing_t listing;
+
+    if (!directory_index_load(menu->browser.directory, load_filter, &listing)) {
+        menu->browser.list = listing.list;
+        menu->browser.names = listing.names;
+        menu->browser.entries = listing.entries;
+        list_capacity = listing.entries;
+        names_length = listing.names_length;
+        names_capacity = listing.names_length;
+
+        browser_list_finalize(menu);
+
+        menu->browser.selected = 0;
+        menu->browser.entry = &menu->browser.list[0];
+
+        if (listing.sort != menu->browser.sort) {
+            browser_list_sort(menu, false);
+        }
+
+        return false;
+    }
+
+    if (!hidden_names_set_ready) {
+        hidden_names_set_build();
+    }
+
+    load_path = path_clone(menu->browser.directory);
+    load_hidden_scope = (path_is_root(load_path) ? (HIDDEN_IN_ROOT | HIDDEN_EVERYWHERE) : HIDDEN_EVERYWHERE);
+
+    load_result = dir_findfirst(path_get(load_path), &load_info);
+
+    menu->browser.loading = true;
+    load_selection_moved = false;
+
+    return load_directory_continue(menu, LOAD_DIRECTORY_BUDGET_US);
+}
+
 static bool reload_directory (menu_t *menu) {
     int selected = menu->browser.selected;
 
+    directory_index_remove(menu->browser.directory);
+
     if (load_directory(menu)) {
         return true;
     }
 
-    menu->browser.selected = selected;
-    if (menu->browser.selected >= menu->browser.entries) {
-        menu->browser.selected = menu->browser.entries - 1;
-    }
-    menu->browser.entry = menu->browser.selected >= 0 ? &menu->browser.list[menu->browser.selected] : NULL;
+    select_entry_on_load(menu, NULL, selected);
 
     return false;
 }
@@ -318,6 +1043,8 @@ static bool reload_directory (menu_t *menu) {
 static bool push_directory (menu_t *menu, char *directory, bool archive) {
     path_t *previous_directory = path_clone(menu->browser.directory);
 
+    directory_cache_stash(menu);
+
     path_push(menu->browser.directory, directory);
 
     if (archive ? load_archive(menu) : load_directory(menu)) {
@@ -334,6 +1061,8 @@ static bool push_directory (menu_t *menu, char *directory, bool archive) {
 static bool pop_directory (menu_t *menu) {
     path_t *previous_directory = path_clone(menu->browser.directory);
 
+    directory_cache_stash(menu);
+
     path_pop(menu->browser.directory);
 
     if (load_directory(menu)) {
@@ -342,12 +1071,8 @@ static bool pop_directory (menu_t *menu) {
         return true;
     }
 
-    for (uint16_t i = 0; i < menu->browser.entries; i++) {
-        if (strcmp(menu->browser.list[i].name, path_last_get(previous_directory)) == 0) {
-            menu->browser.selected = i;
-            menu->browser.entry = &menu->browser.list[menu->browser.selected];
-            break;
-        }
+    if (!directory_cache_restored) {
+        select_entry_on_load(menu, path_last_get(previous_directory), -1);
     }
 
     path_free(previous_directory);
@@ -358,6 +1083,8 @@ static bool pop_directory (menu_t *menu) {
 static bool select_file (menu_t *menu, path_t *file) {
     path_t *previous_directory = path_clone(menu->browser.directory);
 
+    directory_cache_stash(menu);
+
     path_free(menu->browser.directory);
     menu->browser.directory = path_clone(file);
     path_pop(menu->browser.directory);
@@ -368,13 +1095,7 @@ static bool select_file (menu_t *menu, path_t *file) {
         return true;
     }
 
-    for (uint16_t i = 0; i < menu->browser.entries; i++) {
-        if (strcmp(menu->browser.list[i].name, path_last_get(file)) == 0) {
-            menu->browser.selected = i;
-            menu->browser.entry = &menu->browser.list[menu->browser.selected];
-            break;
-        }
-    }
+    select_entry_on_load(menu, path_last_get(file), -1);
 
     path_free(previous_directory);
 
@@ -385,26 +1106,206 @@ static void show_properties (menu_t *menu, void *arg) {
     menu->next_mode = menu->browser.entry->type == ENTRY_TYPE_ARCHIVED ? MENU_MODE_EXTRACT_FILE : MENU_MODE_FILE_INFO;
 }
 
-static void delete_entry (menu_t *menu, void *arg) {
-    path_t *path = path_clone_push(menu->browser.directory, menu->browser.entry->name);
+/**
+ * @brief Store the patched listing of the current directory in its index file.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param directory Pointer to the directory path.
+ * @param filter Filter the listing was created with.
+ */
+static void directory_index_update (menu_t *menu, path_t *directory, uint32_t filter) {
+    if (menu->browser.entries < DIRECTORY_INDEX_MIN_ENTRIES) {
+        directory_index_remove(directory);
+        return;
+    }
+
+    directory_index_save(directory, &((directory_index_listing_t) {
+        .list = menu->browser.list,
+        .names = menu->browser.names,
+        .entries = menu->browser.entries,
+        .names_length = names_length,
+        .filter = filter,
+        .sort = menu->browser.sort,
+    }));
+}
+
+/**
+ * @brief Apply a listing change to the list held by the browser.
+ *
+ * @return true if the list couldn't be patched, false otherwise.
+ */
+static bool browser_list_patch (menu_t *menu, file_ops_change_t change, path_t *directory, char *name, bool is_directory, int64_t size) {
+    if (change == FILE_OPS_ENTRY_REMOVED) {
+        browser_list_remove(menu, name);
+        return false;
+    }
+
+    if (!hidden_names_set_ready) {
+        hidden_names_set_build();
+    }
+
+    bool hidden = (
+        (!menu->settings.show_protected_entries && name_is_hidden(name, path_is_root(directory) ? (HIDDEN_IN_ROOT | HIDDEN_EVERYWHERE) : HIDDEN_EVERYWHERE)) ||
+        (!menu->settings.show_saves_folder && (strcmp(name, SAVE_DIRECTORY_NAME) == 0))
+    );
+
+    if (hidden) {
+        return false;
+    }
+
+    // NOTE: An overwritten entry is listed once
+    browser_list_remove(menu, name);
+
+    return browser_list_insert(menu, name, is_directory ? ENTRY_TYPE_DIR : file_type_get(name), size);
+}
 
-    if (remove(path_get(path))) {
-        menu->browser.valid = false;
-        if (menu->browser.entry->type == ENTRY_TYPE_DIR) {
-            menu_show_error(menu, "Couldn't delete directory\nDirectory might not be empty");
+/**
+ * @brief Exchange the list held by the browser with a cached listing.
+ */
+static void directory_cache_swap (menu_t *menu, directory_cache_entry_t *cached) {
+    entry_t *list = menu->browser.list;
+    char *names = menu->browser.names;
+    int32_t entries = menu->browser.entries;
+    int32_t selected = menu->browser.selected;
+    browser_sort_t sort = menu->browser.sort;
+    int32_t capacity = list_capacity;
+    size_t length = names_length;
+    size_t pool_capacity = names_capacity;
+
+    menu->browser.list = cached->list;
+    menu->browser.names = cached->names;
+    menu->browser.entries = cached->entries;
+    menu->browser.selected = cached->selected;
+    menu->browser.sort = cached->sort;
+    menu->browser.entry = (menu->browser.selected >= 0) ? &menu->browser.list[menu->browser.selected] : NULL;
+    list_capacity = cached->list_capacity;
+    names_length = cached->names_length;
+    names_capacity = cached->names_capacity;
+
+    cached->list = list;
+    cached->names = names;
+    cached->entries = entries;
+    cached->selected = selected;
+    cached->sort = sort;
+    cached->list_capacity = capacity;
+    cached->names_length = length;
+    cached->names_capacity = pool_capacity;
+}
+
+/**
+ * @brief Patch the listings of a directory after a background file operation.
+ *
+ * The current listing, its cached copy and its index file are updated in place,
+ * since FAT doesn't update the directory timestamps the caches are validated with.
+ */
+static void file_ops_listener (file_ops_change_t change, path_t *path, bool is_directory, int64_t size, void *arg) {
+    menu_t *menu = (menu_t *) (arg);
+    path_t *directory = path_clone(path);
+    path_pop(directory);
+    char *name = path_last_get(path);
+
+    if (!menu->browser.archive && path_are_match(directory, menu->browser.directory)) {
+        if (menu->browser.loading) {
+            reload_directory(menu);
+        } else if (browser_list_patch(menu, change, directory, name, is_directory, size)) {
+            directory_index_remove(directory);
+            reload_directory(menu);
         } else {
-            menu_show_error(menu, "Couldn't delete file");
+            directory_index_update(menu, directory, load_filter);
         }
-        path_free(path);
+        path_free(directory);
         return;
     }
 
+    bool indexed = false;
+
+    for (int i = 0; i < DIRECTORY_CACHE_ENTRIES; i++) {
+        directory_cache_entry_t *cached = &directory_cache[i];
+
+        if ((cached->directory == NULL) || (strcmp(cached->directory, path_get(directory)) != 0)) {
+            continue;
+        }
+
+        // NOTE: The cached listing is patched in the browser list, the list held by the browser is parked in the pinned cache entry meanwhile
+        directory_cache_swap(menu, cached);
+        cached->pinned = true;
+        bool failed = browser_list_patch(menu, change, directory, name, is_directory, size);
+        if (!failed) {
+            directory_index_update(menu, directory, make_listing_filter(cached->hide_protected, cached->hide_saves));
+            indexed = true;
+        }
+        cached->pinned = false;
+        directory_cache_swap(menu, cached);
+        menu->browser.entry = (menu->browser.selected >= 0) ? &menu->browser.list[menu->browser.selected] : NULL;
+        ui_components_file_list_invalidate();
+
+        size_t cached_size = (cached->list_capacity * sizeof(entry_t)) + cached->names_capacity;
+        directory_cache_size += (cached_size - cached->size);
+        cached->size = cached_size;
+
+        if (failed) {
+            directory_cache_entry_free(cached);
+        }
+        break;
+    }
+
+    if (!indexed) {
+        directory_index_remove(directory);
+    }
+
+    path_free(directory);
+}
+
+static void report_file_ops_error (menu_t *menu, file_ops_err_t err) {
+    if (err != FILE_OPS_OK) {
+        menu_show_error(menu, file_ops_convert_error_message(err));
+    }
+}
+
+static path_t *clipboard_path = NULL;
+static bool clipboard_move = false;
+
+static void delete_entry (menu_t *menu, void *arg) {
+    path_t *path = path_clone_push(menu->browser.directory, menu->browser.entry->name);
+
+    report_file_ops_error(menu, file_ops_delete(path, (bool) (uintptr_t) (arg)));
+
     path_free(path);
+}
+
+static void copy_entry (menu_t *menu, void *arg) {
+    path_free(clipboard_path);
+    clipboard_path = path_clone_push(menu->browser.directory, menu->browser.entry->name);
+    clipboard_move = (bool) (uintptr_t) (arg);
+}
+
+static void paste_entry (menu_t *menu, void *arg) {
+    if (clipboard_path == NULL) {
+        menu_show_error(menu, "No entry was copied or moved");
+        return;
+    }
+
+    file_ops_err_t err = file_ops_copy(clipboard_path, menu->browser.directory, clipboard_move);
 
-    if (reload_directory(menu)) {
-        menu->browser.valid = false;
-        menu_show_error(menu, "Couldn't refresh directory contents after delete operation");
+    if ((err == FILE_OPS_OK) && clipboard_move) {
+        path_free(clipboard_path);
+        clipboard_path = NULL;
     }
+
+    report_file_ops_error(menu, err);
+}
+
+static void optimize_directory (menu_t *menu, void *arg) {
+    report_file_ops_error(menu, file_ops_relocate(menu->browser.directory));
+}
+
+static void cancel_file_operation (menu_t *menu, void *arg) {
+    file_ops_cancel();
+}
+
+static void rescan_directory (menu_t *menu, void *arg) {
+    // NOTE: The reload drops the cached listings and the index file of the directory
+    menu->browser.reload = true;
 }
 
 static void extract_entry (menu_t *menu, void *arg) {
@@ -412,17 +1313,113 @@ static void extract_entry (menu_t *menu, void *arg) {
     menu->next_mode = MENU_MODE_EXTRACT_FILE;
 }
 
+static void load_archived_entry (menu_t *menu, void *arg) {
+    if (file_type_get(menu->browser.entry->name) != ENTRY_TYPE_ROM) {
+        menu_show_error(menu, "Selected entry is not an N64 ROM");
+        return;
+    }
+    menu->load.load_archive_id = menu->browser.entry->index;
+    menu->next_mode = MENU_MODE_LOAD_ROM;
+}
+
 static void set_default_directory (menu_t *menu, void *arg) {
     free(menu->settings.default_directory);
     menu->settings.default_directory = strdup(strip_fs_prefix(path_get(menu->browser.directory)));
     settings_save(&menu->settings);
 }
 
+static void jump_to_letter (menu_t *menu, void *arg) {
+    jump_to_group(menu, (int) (uintptr_t) (arg));
+}
+
+static component_context_menu_t jump_context_menu = {
+    .list = {
+        [JUMP_MENU_ROWS] = COMPONENT_CONTEXT_MENU_LIST_END,
+    }
+};
+
+/**
+ * @brief Show the letter groups of the selected entry type in the jump menu.
+ *
+ * When there are more groups than the menu can show, only evenly spaced groups are listed,
+ * the next and previous letter actions can be used from there.
+ *
+ * @param menu Pointer to the menu structure.
+ * @return true if there are letter groups to jump to, false otherwise.
+ */
+static bool jump_context_menu_prepare (menu_t *menu) {
+    static const char *rank_names[] = { "Folders", "Archives", "Disks", "Emulator ROMs", "Images", "Music", "ROMs", "Cheats", "Patches", "Saves", "Text", "Files" };
+
+    if (!jump_index_valid) {
+        jump_index_build(menu);
+    }
+
+    int group = jump_index_find(menu->browser.selected);
+
+    if (group < 0) {
+        return false;
+    }
+
+    int first = group;
+    int last = group;
+    while ((first > 0) && (jump_groups[first - 1].rank == jump_groups[group].rank)) {
+        first--;
+    }
+    while ((last < (jump_group_count - 1)) && (jump_groups[last + 1].rank == jump_groups[group].rank)) {
+        last++;
+    }
+
+    int count = (last - first + 1);
+    int step = ((count + JUMP_MENU_ROWS - 1) / JUMP_MENU_ROWS);
+    int rows = 0;
+
+    for (int i = first; i <= last; i += step) {
+        char letter = toupper((unsigned char) (jump_groups[i].letter));
+        snprintf(jump_labels[rows], sizeof(jump_labels[rows]), "%s: %c", rank_names[jump_groups[i].rank], ((letter > ' ') && (letter <= '~')) ? letter : '?');
+        jump_context_menu.list[rows].text = jump_labels[rows];
+        jump_context_menu.list[rows].action = jump_to_letter;
+        jump_context_menu.list[rows].arg = (void *) (uintptr_t) (i);
+        jump_context_menu.list[rows].submenu = NULL;
+        rows++;
+    }
+    jump_context_menu.list[rows].text = NULL;
+
+    ui_components_context_menu_init(&jump_context_menu);
+
+    return (rows > 1);
+}
+
+static void set_sort_order (menu_t *menu, void *arg) {
+    menu->browser.sort = (browser_sort_t) (arg);
+    browser_list_sort(menu, true);
+}
+
+static int get_sort_order_current_selection (menu_t *menu) {
+    return (int) (menu->browser.sort);
+}
+
+static component_context_menu_t sort_context_menu = {
+    .get_default_selection = get_sort_order_current_selection,
+    .list = {
+        { .text = "Sort by name", .action = set_sort_order, .arg = (void *) (BROWSER_SORT_NAME) },
+        { .text = "Sort by size", .action = set_sort_order, .arg = (void *) (BROWSER_SORT_SIZE) },
+        COMPONENT_CONTEXT_MENU_LIST_END,
+    }
+};
+
 static component_context_menu_t entry_context_menu = {
     .list = {
         { .text = "Show entry properties", .action = show_properties },
-        { .text = "Delete selected entry", .action = delete_entry },
+        { .text = "Delete selected entry", .action = delete_entry, .arg = (void *) (false) },
+        { .text = "Delete with contents", .action = delete_entry, .arg = (void *) (true) },
+        { .text = "Copy selected entry", .action = copy_entry, .arg = (void *) (false) },
+        { .text = "Move selected entry", .action = copy_entry, .arg = (void *) (true) },
+        { .text = "Paste into this directory", .action = paste_entry },
+        { .text = "Optimize this directory", .action = optimize_directory },
+        { .text = "Rescan this directory", .action = rescan_directory },
+        { .text = "Cancel file operation", .action = cancel_file_operation },
         { .text = "Set current directory as default", .action = set_default_directory },
+        { .text = "Change sort order", .submenu = &sort_context_menu },
         COMPONENT_CONTEXT_MENU_LIST_END,
     }
 };
@@ -431,6 +1428,7 @@ static component_context_menu_t archive_context_menu = {
     .list = {
         { .text = "Show entry properties", .action = show_properties },
         { .text = "Extract selected entry", .action = extract_entry },
+        { .text = "Load ROM without extracting", .action = load_archived_entry },
         COMPONENT_CONTEXT_MENU_LIST_END,
     }
 };
@@ -442,17 +1440,27 @@ static void set_menu_next_mode (menu_t *menu, void *arg) {
 
 static component_context_menu_t settings_context_menu = {
     .list = {
+        { .text = "Search ROMs", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_SEARCH) },
         { .text = "Controller Pak manager", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_CONTROLLER_PAKFS) },
         { .text = "Menu settings", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_SETTINGS_EDITOR) },
         { .text = "Time (RTC) settings", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_RTC) },
         { .text = "Menu information", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_CREDITS) },
         { .text = "Flashcart information", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_FLASHCART) },
         { .text = "N64 information", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_SYSTEM_INFO) },
+        { .text = "Run benchmarks", .action = set_menu_next_mode, .arg = (void *) (MENU_MODE_BENCHMARK) },
         COMPONENT_CONTEXT_MENU_LIST_END,
     }
 };
 
 static void process (menu_t *menu) {
+    file_ops_err_t file_ops_err;
+
+    // NOTE: Cancelling is requested by the user, it's not reported as an error
+    if (file_ops_take_result(&file_ops_err) && (file_ops_err != FILE_OPS_OK) && (file_ops_err != FILE_OPS_ERR_CANCELLED)) {
+        menu_show_error(menu, file_ops_convert_error_message(file_ops_err));
+        return;
+    }
+
     if (ui_components_context_menu_process(menu, menu->browser.archive ? &archive_context_menu : &entry_context_menu)) {
         return;
     }
@@ -461,7 +1469,11 @@ static void process (menu_t *menu) {
         return;
     }
 
-    int scroll_speed = menu->actions.go_fast ? 10 : 1;
+    if (ui_components_context_menu_process(menu, &jump_context_menu)) {
+        return;
+    }
+
+    int scroll_speed = menu->actions.go_fast ? 10 : menu->actions.steps;
 
     if (menu->browser.entries > 1) {
         if (menu->actions.go_up) {
@@ -478,6 +1490,7 @@ static void process (menu_t *menu) {
             sound_play_effect(SFX_CURSOR);
         }
         menu->browser.entry = &menu->browser.list[menu->browser.selected];
+        load_selection_moved |= (menu->actions.go_up || menu->actions.go_down);
     }
 
     if (menu->actions.enter && menu->browser.entry) {
@@ -511,6 +1524,7 @@ static void process (menu_t *menu) {
                 menu->next_mode = MENU_MODE_MUSIC_PLAYER;
                 break;
             case ENTRY_TYPE_ROM:
+            case ENTRY_TYPE_ROM_COMPRESSED:
                 menu->next_mode = MENU_MODE_LOAD_ROM;
                 break;
             case ENTRY_TYPE_ROM_CHEAT:
@@ -539,6 +1553,15 @@ static void process (menu_t *menu) {
     } else if (menu->actions.settings) {
         ui_components_context_menu_show(&settings_context_menu);
         sound_play_effect(SFX_SETTING);
+    } else if (menu->actions.lz_context && !menu->browser.archive) {
+        if (jump_context_menu_prepare(menu)) {
+            ui_components_context_menu_show(&jump_context_menu);
+            sound_play_effect(SFX_SETTING);
+        }
+    } else if (menu->actions.go_fast && (menu->actions.go_left || menu->actions.go_right)) {
+        if (jump_letter(menu, menu->actions.go_right ? 1 : -1)) {
+            sound_play_effect(SFX_CURSOR);
+        }
     } else if (menu->actions.go_right) {
         menu->next_mode = MENU_MODE_HISTORY;
         sound_play_effect(SFX_CURSOR);
@@ -548,6 +1571,135 @@ static void process (menu_t *menu) {
     }
 }
 
+static bool is_idle (menu_t *menu) {
+    return !(
+        menu->actions.go_up ||
+        menu->actions.go_down ||
+        menu->actions.go_left ||
+        menu->actions.go_right ||
+        menu->actions.enter ||
+        menu->actions.back ||
+        menu->actions.options ||
+        menu->actions.settings ||
+        menu->actions.lz_context
+    );
+}
+
+/**
+ * @brief Fill in the tags of an entry from the ROM header cache, reading the header when it's not cached yet.
+ *
+ * @return true if the entry is near the selection and the file list has to be redrawn, false otherwise.
+ */
+static bool scan_entry (menu_t *menu, path_t *path, int32_t index) {
+    entry_t *entry = &menu->browser.list[index];
+
+    if ((entry->type != ENTRY_TYPE_ROM) || (entry->tags & ROM_TAG_SCANNED)) {
+        return false;
+    }
+
+    rom_info_t rom_info;
+
+    path_push(path, entry->name);
+    entry->tags = (rom_info_cache_load(path, &rom_info) == ROM_OK) ? rom_info_get_tags(&rom_info) : ROM_TAG_SCANNED;
+    path_pop(path);
+
+    return (abs(index - menu->browser.selected) <= LIST_ENTRIES);
+}
+
+static void scan_headers (menu_t *menu) {
+    if (menu->browser.archive || menu->browser.loading || (menu->browser.scan_position >= menu->browser.entries) || (menu->next_mode != MENU_MODE_BROWSER)) {
+        return;
+    }
+
+    // NOTE: A single header read can't be interrupted, so the budget is only checked between the reads
+    uint64_t start = get_ticks_us();
+    bool redraw = false;
+
+    path_scratch_begin();
+
+    path_t *path = path_clone(menu->browser.directory);
+
+    // NOTE: The entries around the selection are tagged first, so the visible tags don't wait for the rest of the directory
+    int32_t first = MAX(menu->browser.selected - LIST_ENTRIES, 0);
+    int32_t last = MIN(menu->browser.selected + LIST_ENTRIES, menu->browser.entries - 1);
+
+    for (int32_t i = first; (i <= last) && ((get_ticks_us() - start) < HEADER_SCAN_BUDGET_US); i++) {
+        redraw |= scan_entry(menu, path, i);
+    }
+
+    while ((menu->browser.scan_position < menu->browser.entries) && ((get_ticks_us() - start) < HEADER_SCAN_BUDGET_US)) {
+        redraw |= scan_entry(menu, path, menu->browser.scan_position++);
+    }
+
+    path_free(path);
+
+    path_scratch_end();
+
+    if (redraw && menu->settings.show_browser_rom_tags) {
+        ui_components_file_list_invalidate();
+    }
+}
+
+static const int prefetch_offsets[] = { 0, 1, 2, 3, -1 };
+#define PREFETCH_ENTRIES    (sizeof(prefetch_offsets) / sizeof(prefetch_offsets[0]))
+
+static struct {
+    entry_t *list;
+    int32_t selected;
+    int direction;
+    uint64_t rest_start_ms;
+    int step;
+    component_boxart_t *boxart;
+} prefetch = { .selected = -1, .direction = 1 };
+
+static time_t drawn_time = -1;
+
+static void prefetch_cancel (void) {
+    // NOTE: A finished boxart goes to the recently shown images, a loading one is aborted
+    ui_components_boxart_free(prefetch.boxart);
+    prefetch.boxart = NULL;
+}
+
+static void prefetch_step (menu_t *menu) {
+    if ((menu->browser.list != prefetch.list) || (menu->browser.selected != prefetch.selected)) {
+        if ((menu->browser.list == prefetch.list) && (prefetch.selected >= 0) && (menu->browser.selected >= 0)) {
+            prefetch.direction = (menu->browser.selected < prefetch.selected) ? -1 : 1;
+        }
+        prefetch.list = menu->browser.list;
+        prefetch.selected = menu->browser.selected;
+        prefetch.rest_start_ms = get_ticks_ms();
+        prefetch.step = 0;
+        prefetch_cancel();
+        return;
+    }
+
+    if ((get_ticks_ms() - prefetch.rest_start_ms) < PREFETCH_REST_MS) {
+        return;
+    }
+
+    if (prefetch.boxart) {
+        if (prefetch.boxart->loading) {
+            return;
+        }
+        prefetch_cancel();
+    }
+
+    while ((prefetch.boxart == NULL) && (prefetch.step < PREFETCH_ENTRIES)) {
+        int32_t index = prefetch.selected + (prefetch_offsets[prefetch.step++] * prefetch.direction);
+
+        if ((index < 0) || (index >= menu->browser.entries) || (menu->browser.list[index].type != ENTRY_TYPE_ROM)) {
+            continue;
+        }
+
+        rom_info_t rom_info;
+        path_t *path = path_clone_push(menu->browser.directory, menu->browser.list[index].name);
+        if (rom_info_cache_load(path, &rom_info) == ROM_OK) {
+            prefetch.boxart = ui_components_boxart_init(menu->storage_prefix, rom_info.game_code, rom_info.title, IMAGE_BOXART_FRONT);
+        }
+        path_free(path);
+    }
+}
+
 static void draw (menu_t *menu, surface_t *d) {
     rdpq_attach(d, NULL);
 
@@ -557,7 +1709,7 @@ static void draw (menu_t *menu, surface_t *d) {
 
     ui_components_layout_draw_tabbed();
 
-    ui_components_file_list_draw(menu->browser.list, menu->browser.entries, menu->browser.selected);
+    ui_components_file_list_draw(menu->browser.list, menu->browser.entries, menu->browser.selected, menu->settings.show_browser_rom_tags);
 
     const char *action = NULL;
 
@@ -565,6 +1717,7 @@ static void draw (menu_t *menu, surface_t *d) {
         switch (menu->browser.entry->type) {
             case ENTRY_TYPE_DIR: action = "A: Enter"; break;
             case ENTRY_TYPE_ROM: action = "A: Load"; break;
+            case ENTRY_TYPE_ROM_COMPRESSED: action = "A: Load"; break;
             case ENTRY_TYPE_DISK: action = "A: Load"; break;
             case ENTRY_TYPE_IMAGE: action = "A: Show"; break;
             case ENTRY_TYPE_TEXT: action = "A: View"; break;
@@ -591,11 +1744,31 @@ static void draw (menu_t *menu, surface_t *d) {
         menu->browser.entries == 0 ? STL_GRAY : STL_DEFAULT
     );
 
-    if (menu->current_time >= 0) {
+    file_ops_status_t *file_ops = file_ops_get_status();
+
+    if (menu->browser.loading) {
+        ui_components_actions_bar_text_draw(
+            STL_DEFAULT,
+            ALIGN_CENTER, VALIGN_TOP,
+            "Loading directory...\n"
+            "%d entries",
+            (int) (menu->browser.entries)
+        );
+    } else if (file_ops->busy) {
+        ui_components_actions_bar_text_draw(
+            STL_DEFAULT,
+            ALIGN_CENTER, VALIGN_TOP,
+            "%s... %d files done\n"
+            "%d%% of the current file",
+            file_ops_get_type_name(file_ops->type),
+            file_ops->files,
+            (file_ops->bytes_total > 0) ? (int) ((file_ops->bytes_done * 100) / file_ops->bytes_total) : 0
+        );
+    } else if (menu->current_time >= 0) {
         ui_components_actions_bar_text_draw(
             STL_DEFAULT,
             ALIGN_CENTER, VALIGN_TOP,
-            "C-▼▲ Fast Scroll | ◀ Tabs ▶ \n"
+            "C-▼▲ Fast Scroll | C-◀▶ Letter | ◀ Tabs ▶ \n"
             "%s",
             ctime(&menu->current_time)
         );
@@ -603,7 +1776,7 @@ static void draw (menu_t *menu, surface_t *d) {
         ui_components_actions_bar_text_draw(
             STL_DEFAULT,
             ALIGN_CENTER, VALIGN_TOP,
-            "C-▼▲ Fast Scroll | ◀ Tabs ▶ \n"
+            "C-▼▲ Fast Scroll | C-◀▶ Letter | ◀ Tabs ▶ \n"
             "\n"
         );
     }
@@ -612,15 +1785,20 @@ static void draw (menu_t *menu, surface_t *d) {
 
     ui_components_context_menu_draw(&settings_context_menu);
 
-    rdpq_detach_show();
+    ui_components_context_menu_draw(&jump_context_menu);
+
+    ui_components_detach_show();
 }
 
 
 void view_browser_init (menu_t *menu) {
+    file_ops_set_listener(file_ops_listener, menu);
+
     if (!menu->browser.valid) {
         ui_components_context_menu_init(&entry_context_menu);
         ui_components_context_menu_init(&archive_context_menu);
         ui_components_context_menu_init(&settings_context_menu);
+        ui_components_context_menu_init(&jump_context_menu);
         if (load_directory(menu)) {
             path_free(menu->browser.directory);
             menu->browser.directory = path_init(menu->storage_prefix, "");
@@ -641,6 +1819,8 @@ void view_browser_init (menu_t *menu) {
 
     if (menu->browser.reload) {
         menu->browser.reload = false;
+        // NOTE: FAT doesn't update directory timestamps when their content changes
+        directory_cache_clear();
         if (reload_directory(menu)) {
             menu_show_error(menu, "Error while reloading current directory");
             menu->browser.valid = false;
@@ -648,8 +1828,56 @@ void view_browser_init (menu_t *menu) {
     }
 }
 
+static void background_work (menu_t *menu) {
+    if (menu->browser.archive || menu->browser.loading || (menu->next_mode != MENU_MODE_BROWSER)) {
+        prefetch.list = NULL;
+        prefetch_cancel();
+    } else if (is_idle(menu)) {
+        prefetch_step(menu);
+    }
+
+    if (is_idle(menu)) {
+        scan_headers(menu);
+        if (!menu->browser.loading && (menu->browser.scan_position >= menu->browser.entries) && (menu->next_mode == MENU_MODE_BROWSER)) {
+            search_index_step(SEARCH_INDEX_BUDGET_US);
+        }
+    }
+}
+
 void view_browser_display (menu_t *menu, surface_t *display) {
     process(menu);
 
+    if (menu->browser.loading) {
+        // NOTE: Other views can list directories too, so the enumeration is completed before leaving the browser
+        uint64_t budget = (menu->next_mode == MENU_MODE_BROWSER) ? LOAD_DIRECTORY_BUDGET_US : UINT64_MAX;
+        if (load_directory_continue(menu, budget)) {
+            menu->browser.valid = false;
+            menu_show_error(menu, "Couldn't read directory contents");
+        }
+    }
+
+    if (menu->browser.archive && archive_stat_entries(menu, menu->browser.selected - LIST_ENTRIES, menu->browser.selected + LIST_ENTRIES)) {
+        ui_components_file_list_invalidate();
+    }
+
     draw(menu, display);
+    drawn_time = menu->current_time;
+
+    background_work(menu);
+}
+
+bool view_browser_idle (menu_t *menu) {
+    // NOTE: The directory loading progress is drawn, keep drawing until it's done
+    if (menu->browser.loading) {
+        return true;
+    }
+
+    if (menu->browser.archive && archive_stat_entries(menu, menu->browser.selected - LIST_ENTRIES, menu->browser.selected + LIST_ENTRIES)) {
+        ui_components_file_list_invalidate();
+        return true;
+    }
+
+    background_work(menu);
+
+    return (menu->current_time != drawn_time);
 }
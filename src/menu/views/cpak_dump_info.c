@@ -1,11 +1,14 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <libdragon.h>
 #include "views.h"
 #include "../sound.h"
 #include "../fonts.h"
 #include <fatfs/ff.h>
 #include "utils/cpakfs_utils.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
 
 
 static char cpak_path[255];
@@ -14,93 +17,113 @@ static char failure_message[255];
 static bool start_complete_restore;
 
 #define CONTROLLERPAK_BANK_SIZE 32768
+#define CONTROLLERPAK_PAGE_SIZE 256
 
-static bool restore_controller_pak(int controller) {
-    sprintf(failure_message, " ");
+static int pages_written;
+static int pages_total;
 
-    if (!has_cpak(controller)) {
-        sprintf(failure_message, "No Controller Pak detected on controller %d!", controller + 1);
+static bool restore_page(int controller, int bank, uint16_t address, uint8_t *data) {
+    uint8_t current[CONTROLLERPAK_PAGE_SIZE];
+
+    if (cpak_read((joypad_port_t)controller, (uint8_t)bank, address, current, CONTROLLERPAK_PAGE_SIZE) != CONTROLLERPAK_PAGE_SIZE) {
+        sprintf(failure_message, "Failed to read bank %d page %d from Controller Pak!", bank, address / CONTROLLERPAK_PAGE_SIZE);
+        return true;
+    }
+
+    if (memcmp(current, data, CONTROLLERPAK_PAGE_SIZE) == 0) {
         return false;
     }
 
-    cpakfs_unmount(controller);
+    int written = cpak_write((joypad_port_t)controller, (uint8_t)bank, address, data, CONTROLLERPAK_PAGE_SIZE);
+    if (written < 0) {
+        sprintf(failure_message, "Failed to write bank %d to Controller Pak! errno=%d", bank, written);
+        return true;
+    }
+    if (written != CONTROLLERPAK_PAGE_SIZE) {
+        sprintf(failure_message, "Short write on bank %d: wrote %d / %d bytes", bank, written, CONTROLLERPAK_PAGE_SIZE);
+        return true;
+    }
 
-    uint8_t *data = malloc(CONTROLLERPAK_BANK_SIZE);
-    if (!data) {
-        sprintf(failure_message, "Memory allocation failed!");
-        return false;
+    if ((cpak_read((joypad_port_t)controller, (uint8_t)bank, address, current, CONTROLLERPAK_PAGE_SIZE) != CONTROLLERPAK_PAGE_SIZE) ||
+        (memcmp(current, data, CONTROLLERPAK_PAGE_SIZE) != 0)) {
+        sprintf(failure_message, "Verify failed on bank %d page %d!", bank, address / CONTROLLERPAK_PAGE_SIZE);
+        return true;
     }
 
-    FILE *fp = fopen(cpak_path, "rb");
-    if (!fp) {
-        sprintf(failure_message, "Failed to open file for reading!");
-        free(data);
-        return false;
+    pages_written += 1;
+
+    return false;
+}
+
+static bool restore_bank(void *buffer, size_t offset, size_t length, void *arg) {
+    int controller = (int) (uintptr_t) (arg);
+    int bank = (int) (offset / CONTROLLERPAK_BANK_SIZE);
+
+    // NOTE: Only the pages that differ from the pak contents are written, a short last page is padded with the current contents
+    for (size_t page = 0; page < length; page += CONTROLLERPAK_PAGE_SIZE) {
+        uint8_t data[CONTROLLERPAK_PAGE_SIZE];
+        size_t page_length = MIN(length - page, CONTROLLERPAK_PAGE_SIZE);
+
+        if (page_length < CONTROLLERPAK_PAGE_SIZE) {
+            if (cpak_read((joypad_port_t)controller, (uint8_t)bank, (uint16_t)(page), data, CONTROLLERPAK_PAGE_SIZE) != CONTROLLERPAK_PAGE_SIZE) {
+                sprintf(failure_message, "Failed to read bank %d from Controller Pak!", bank);
+                return true;
+            }
+        }
+        memcpy(data, (uint8_t *) (buffer) + page, page_length);
+
+        if (restore_page(controller, bank, (uint16_t)(page), data)) {
+            return true;
+        }
+
+        pages_total += 1;
     }
 
-    if (fseek(fp, 0, SEEK_END) != 0) {
-        sprintf(failure_message, "Seek failed!");
-        fclose(fp);
-        free(data);
+    return false;
+}
+
+static bool restore_controller_pak(int controller) {
+    sprintf(failure_message, " ");
+
+    if (!has_cpak(controller)) {
+        sprintf(failure_message, "No Controller Pak detected on controller %d!", controller + 1);
         return false;
     }
-    long filesize = ftell(fp);
+
+    cpakfs_unmount(controller);
+
+    int64_t filesize = file_get_size(cpak_path);
     if (filesize < 0) {
-        sprintf(failure_message, "ftell failed!");
-        fclose(fp);
-        free(data);
+        sprintf(failure_message, "Failed to open file for reading!");
         return false;
     }
-    rewind(fp);
 
     int total_banks = (int)((filesize + CONTROLLERPAK_BANK_SIZE - 1) / CONTROLLERPAK_BANK_SIZE);
 
     int banks_on_device = cpak_probe_banks(controller);
     if (banks_on_device < 1) {
         sprintf(failure_message, "Cannot probe Controller Pak banks (err=%d)!", banks_on_device);
-        fclose(fp);
-        free(data);
         return false;
     }
     if (total_banks > banks_on_device) {
         sprintf(failure_message, "Dump file too large (%d banks) for controller (%d banks)!",
                 total_banks, banks_on_device);
-        fclose(fp);
-        free(data);
         return false;
     }
 
-    debugf("Restoring Controller Pak: %ld bytes (%d banks)\n", filesize, total_banks);
+    debugf("Restoring Controller Pak: %lld bytes (%d banks)\n", filesize, total_banks);
 
-    for (int bank = 0; bank < total_banks; bank++) {
-        size_t bytesRead = fread(data, 1, CONTROLLERPAK_BANK_SIZE, fp);
-        if (bytesRead == 0 && ferror(fp)) {
+    failure_message[0] = '\0';
+    pages_written = 0;
+    pages_total = 0;
+    if (file_read_stream(cpak_path, CONTROLLERPAK_BANK_SIZE, restore_bank, (void *) (uintptr_t) (controller), NULL)) {
+        if (!failure_message[0]) {
             sprintf(failure_message, "Read error from dump file!");
-            fclose(fp);
-            free(data);
-            return false;
-        }
-        if (bytesRead == 0 && feof(fp)) break; // empty trailing chunk (shouldn't happen)
-
-        int written = cpak_write((joypad_port_t)controller, (uint8_t)bank, 0, data, bytesRead);
-        if (written < 0) {
-            sprintf(failure_message, "Failed to write bank %d to Controller Pak! errno=%d", bank, written);
-            fclose(fp);
-            free(data);
-            return false;
-        }
-        if ((size_t)written != bytesRead) {
-            sprintf(failure_message, "Short write on bank %d: wrote %d / %zu bytes", bank, written, bytesRead);
-            fclose(fp);
-            free(data);
-            return false;
         }
+        return false;
     }
 
-    fclose(fp);
-    free(data);
-
-    sprintf(failure_message, "Dump restored on controller %d!", controller + 1);
+    sprintf(failure_message, "Dump restored on controller %d! %d of %d pages written", controller + 1, pages_written, pages_total);
     return true;
 }
 
@@ -160,7 +183,7 @@ static void draw (menu_t *menu, surface_t *d) {
 
     if (start_complete_restore) {
         ui_components_loader_draw(0, "Writing Controller Pak...");
-        rdpq_detach_show();
+        ui_components_detach_show();
         if (restore_controller_pak(controller_selected) && !failure_message[0]) {
             menu->next_mode = MENU_MODE_BROWSER;
         } 
@@ -169,7 +192,7 @@ static void draw (menu_t *menu, surface_t *d) {
         
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 void view_controller_pak_dump_info_init (menu_t *menu) {
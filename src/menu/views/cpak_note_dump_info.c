@@ -72,32 +72,25 @@ static bool restore_controller_pak_note(int controller) {
     }
 
 
-    sprintf(filename_note, "%s%s", CPAK_MOUNT_ARRAY[controller], title);
-    
-    //debugf("Dest. filename: %s\n", filename_note);
-
-    //Check if the file already exists, and if so, pick a unique name
-    if (file_exists_full(filename_note)) {
-        char unique_full[256];
-
-        // Strip the prefix from filename_note to get just the CPAK full name:
-        // (title already has no prefix, so pass 'title' directly)
-        if (pick_unique_fullname_with_mount(CPAK_MOUNT_ARRAY[controller],
-                                            title, /* NO prefix */
-                                            unique_full, sizeof unique_full,
-                                            file_exists_full) == 0)
-        {
-            strcpy(filename_note, unique_full);
-            //debugf("File exists, new name picked: %s\n", filename_note);
-        } else {
-            cpakfs_unmount(controller);
-            fclose(fSource);
-            snprintf(failure_message_note, sizeof failure_message_note,
-                     "Unable to pick a unique destination name for %s", title);
-            return false;
-        }
+    //Pick a unique name if a note with the same name already exists
+    char note_names[MAX_NUM_NOTES][MAX_NOTE_NAME_LENGTH];
+    int note_count = list_cpakfs_note_names(CPAK_MOUNT_ARRAY[controller], note_names, MAX_NUM_NOTES);
+
+    // (title already has no prefix, so pass 'title' directly)
+    if (pick_unique_fullname_with_mount(CPAK_MOUNT_ARRAY[controller],
+                                        title, /* NO prefix */
+                                        (const char (*)[MAX_NOTE_NAME_LENGTH]) (note_names), note_count,
+                                        filename_note, sizeof filename_note) != 0)
+    {
+        cpakfs_unmount(controller);
+        fclose(fSource);
+        snprintf(failure_message_note, sizeof failure_message_note,
+                 "Unable to pick a unique destination name for %s", title);
+        return false;
     }
 
+    //debugf("Dest. filename: %s\n", filename_note);
+
     fDestination = fopen(filename_note, "wb");
     if (!fDestination) {
         fclose(fSource);
@@ -112,7 +105,7 @@ static bool restore_controller_pak_note(int controller) {
     
     ui_components_layout_draw();
     ui_components_loader_draw(0, "Restoring Controller Pak note...");
-    rdpq_detach_show();
+    ui_components_detach_show();
 
     char buffer[4096];
     size_t bytesRead;
@@ -197,7 +190,7 @@ static void draw (menu_t *menu, surface_t *d) {
     );
 
     if (start_note_restore) {
-        rdpq_detach_show();
+        ui_components_detach_show();
         if (restore_controller_pak_note(controller_selected) && !failure_message_note[0]) {
             menu->next_mode = MENU_MODE_BROWSER;
         } 
@@ -206,7 +199,7 @@ static void draw (menu_t *menu, surface_t *d) {
         
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 void view_controller_pak_note_dump_info_init (menu_t *menu) {
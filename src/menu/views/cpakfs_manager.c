@@ -1,5 +1,7 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <libdragon.h>
 #include "views.h"
 #include "../sound.h"
@@ -8,10 +10,15 @@
 #include <errno.h>
 #include <dir.h>
 #include "utils/cpakfs_utils.h"
+#include "utils/fs.h"
+#include "utils/hash.h"
 
 #define MAX_STRING_LENGTH 62
 
 #define MEMPAK_BANK_SIZE 32768
+#define DUMP_CHUNK_SIZE 8192
+#define ID_BLOCK_ADDRESS 0x20
+#define ID_BLOCK_SIZE 32
 
 #define CPAK_EXTENSION ".pak"   
 #define CPAK_NOTE_EXTENSION ".paknote"
@@ -34,8 +41,15 @@ static bool unmounted;
 static bool ctr_p_data_loop; // to avoid repopulating the list multiple times
 static cpakfs_stats_t cpakfs_stats;
 static dir_t dir_entry;
+static size_t dump_size;
+static uint64_t dump_start_us;
+static int dump_port;
+static char dump_all_results[4][64];
+static bool dump_unchanged;
+static char dump_existing[200];
 
 static bool process_complete_full_dump;
+static bool process_complete_dump_all;
 static bool process_complete_note_dump;
 static bool process_complete_format;
 static bool process_complete_delete;
@@ -46,6 +60,17 @@ static char controller_pak_name_notes_bank_size[MAX_NUM_NOTES][6]; // "(XXX)" =
 
 static cpakfs_path_strings_t cpakfs_path_strings[MAX_NUM_NOTES];
 
+/** @brief Cached note directory of a single controller port. */
+typedef struct {
+    bool valid; /**< The directory was read from the pak with this ID block */
+    uint8_t id_block[ID_BLOCK_SIZE]; /**< ID block of the pak, identifies the pak across hot swaps */
+    char names[MAX_NUM_NOTES][MAX_STRING_LENGTH]; /**< Note names */
+    char bank_sizes[MAX_NUM_NOTES][6]; /**< Formatted note block sizes */
+    cpakfs_path_strings_t path_strings[MAX_NUM_NOTES]; /**< Parsed note names */
+} note_cache_t;
+
+static note_cache_t note_cache[4];
+
 static bool show_complete_dump_confirm_message;
 static bool show_single_note_dump_confirm_message;
 static bool show_single_note_delete_confirm_message;
@@ -53,6 +78,7 @@ static bool show_format_controller_pak_confirm_message;
 static bool show_complete_write_confirm_message;
 
 static bool start_complete_dump;
+static bool start_dump_all;
 static bool start_single_note_dump;
 static bool start_single_note_delete;
 static bool start_format_controller_pak;
@@ -61,6 +87,7 @@ static char * CPAK_PATH = "sd:/cpak_saves";
 static char * CPAK_PATH_NO_PRE = "/cpak_saves";
 static char * CPAK_NOTES_PATH = "sd:/cpak_saves/notes";
 static char * CPAK_NOTES_PATH_NO_PRE = "/cpak_saves/notes";
+static char * CPAK_BACKUP_INDEX = "sd:/cpak_saves/backups.idx";
 
 static void reset_vars(){
     has_mem = false;
@@ -72,10 +99,12 @@ static void reset_vars(){
     show_format_controller_pak_confirm_message = false;
     show_complete_write_confirm_message = false;
     start_complete_dump = false;
+    start_dump_all = false;
     start_single_note_dump = false;
     start_single_note_delete = false;
     start_format_controller_pak = false;
     process_complete_full_dump = false;
+    process_complete_dump_all = false;
     process_complete_note_dump = false;
     process_complete_format = false;
     process_complete_delete = false;
@@ -173,6 +202,7 @@ static void format_controller_pak () {
         error_message_displayed = true;
     }
     reset_vars();
+    note_cache[controller_selected].valid = false;
     cpakfs_unmount(controller_selected);
     mounted[controller_selected] = false;
     has_pak[controller_selected] = false;
@@ -192,11 +222,16 @@ static void active_restore_controller_pak_message(menu_t *menu, void *arg) {
     show_complete_write_confirm_message = true;
 }
 
+static void active_dump_all_controller_paks(menu_t *menu, void *arg) {
+    start_dump_all = true;
+}
+
 static component_context_menu_t options_context_menu = {
     .list = {
         { .text = "Format Controller Pak", .action = active_format_controller_pak_message },
         { .text = "Delete single note", .action = active_single_note_delete_message },
         { .text = "Restore a dump to the Controller Pak", .action = active_restore_controller_pak_message },
+        { .text = "Backup all connected Controller Paks", .action = active_dump_all_controller_paks },
         COMPONENT_CONTEXT_MENU_LIST_END,
     }
 };
@@ -215,11 +250,70 @@ static void write_note_name_info_list(int16_t controller, int index, char* entry
     parse_cpakfs_fullname(entry_name, &cpakfs_path_strings[index]);
 }
 
+static bool read_id_block(int controller, uint8_t *id_block) {
+    return (cpak_read((joypad_port_t)controller, 0, ID_BLOCK_ADDRESS, id_block, ID_BLOCK_SIZE) != ID_BLOCK_SIZE);
+}
+
+static void note_cache_store(int controller, uint8_t *id_block) {
+    note_cache_t *cache = &note_cache[controller];
+
+    memcpy(cache->id_block, id_block, ID_BLOCK_SIZE);
+    memcpy(cache->names, controller_pak_name_notes, sizeof(cache->names));
+    memcpy(cache->bank_sizes, controller_pak_name_notes_bank_size, sizeof(cache->bank_sizes));
+    memcpy(cache->path_strings, cpakfs_path_strings, sizeof(cache->path_strings));
+    cache->valid = true;
+}
+
+static bool note_cache_load(int controller, uint8_t *id_block) {
+    note_cache_t *cache = &note_cache[controller];
+
+    if (!cache->valid || (memcmp(cache->id_block, id_block, ID_BLOCK_SIZE) != 0)) {
+        return true;
+    }
+
+    memcpy(controller_pak_name_notes, cache->names, sizeof(cache->names));
+    memcpy(controller_pak_name_notes_bank_size, cache->bank_sizes, sizeof(cache->bank_sizes));
+    memcpy(cpakfs_path_strings, cache->path_strings, sizeof(cache->path_strings));
+
+    return false;
+}
+
+static void note_cache_remove(int controller, int index) {
+    note_cache_t *cache = &note_cache[controller];
+
+    if (!cache->valid) {
+        return;
+    }
+
+    for (int i = index; i < (MAX_NUM_NOTES - 1); i++) {
+        memcpy(cache->names[i], cache->names[i + 1], sizeof(cache->names[i]));
+        memcpy(cache->bank_sizes[i], cache->bank_sizes[i + 1], sizeof(cache->bank_sizes[i]));
+        cache->path_strings[i] = cache->path_strings[i + 1];
+    }
+
+    cpakfs_path_strings_t *last = &cache->path_strings[MAX_NUM_NOTES - 1];
+    sprintf(cache->names[MAX_NUM_NOTES - 1], " ");
+    sprintf(cache->bank_sizes[MAX_NUM_NOTES - 1], " ");
+    sprintf(last->gamecode, " ");
+    sprintf(last->pubcode, " ");
+    sprintf(last->filename, " ");
+    sprintf(last->ext, " ");
+}
+
 static void populate_list_cpakfs() {  
     if (has_mem && !ctr_p_data_loop) {
         
         free_controller_pak_name_notes();
 
+        // NOTE: Reading the ID block is a single joybus transfer, the directory is only enumerated for a pak that isn't cached
+        uint8_t id_block[ID_BLOCK_SIZE];
+        bool id_block_error = read_id_block(controller_selected, id_block);
+
+        if (!id_block_error && !note_cache_load(controller_selected, id_block)) {
+            ctr_p_data_loop = true;
+            return;
+        }
+
         if (dir_findfirst(CPAK_MOUNT_ARRAY[controller_selected], &dir_entry) >= 0) {
             
             write_note_name_info_list(controller_selected, 0, dir_entry.d_name);
@@ -231,89 +325,231 @@ static void populate_list_cpakfs() {
             
                 i++;
                 if (i >= MAX_NUM_NOTES) break;
-
-                ctr_p_data_loop = true;
             }
         }
+
+        ctr_p_data_loop = true;
+
+        if (!id_block_error) {
+            note_cache_store(controller_selected, id_block);
+        }
     }
 }
 
-static void dump_complete_cpak(int port) {
-    sprintf(failure_message_note, " ");
+/**
+ * @brief Find an existing backup with the same contents.
+ *
+ * Every backup written by the manager is listed in the index file with the hash and size of its contents.
+ *
+ * @param hash Hash of the contents.
+ * @param size Size of the contents.
+ * @param filename Buffer to store the path of the existing backup.
+ * @param filename_size Size of the filename buffer.
+ * @return true if no backup with the same contents exists, false otherwise.
+ */
+static bool backup_find(uint64_t hash, size_t size, char *filename, size_t filename_size) {
+    FILE *f = fopen(CPAK_BACKUP_INDEX, "r");
+    if (f == NULL) {
+        return true;
+    }
 
-    
-    int banks = cpak_probe_banks(port);
-    if (banks < 1) {
+    bool not_found = true;
+    char line[300];
+
+    while (not_found && (fgets(line, sizeof(line), f) != NULL)) {
+        unsigned long long entry_hash;
+        unsigned long entry_size;
+        int name_offset;
+
+        if (sscanf(line, "%llx %lu %n", &entry_hash, &entry_size, &name_offset) != 2) {
+            continue;
+        }
+        if ((entry_hash != hash) || (entry_size != size)) {
+            continue;
+        }
+
+        line[strcspn(line, "\r\n")] = '\0';
+
+        // NOTE: Backups deleted from the SD card stay in the index, they are skipped here
+        if (file_exists_full(&line[name_offset])) {
+            snprintf(filename, filename_size, "%s", &line[name_offset]);
+            not_found = false;
+        }
+    }
+
+    fclose(f);
+
+    return not_found;
+}
+
+static void backup_add(uint64_t hash, size_t size, const char *filename) {
+    FILE *f = fopen(CPAK_BACKUP_INDEX, "a");
+    if (f == NULL) {
+        return;
+    }
+
+    fprintf(f, "%016llx %lu %s\n", (unsigned long long) (hash), (unsigned long) (size), filename);
+    fclose(f);
+}
+
+/**
+ * @brief Store a backup unless one with the same contents already exists.
+ *
+ * @param filename Path of the new backup.
+ * @param data Backup contents.
+ * @param size Size of the contents.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool backup_store(const char *filename, uint8_t *data, size_t size) {
+    uint64_t hash = fnv1a64(FNV1A64_INIT, data, size);
+
+    dump_unchanged = !backup_find(hash, size, dump_existing, sizeof(dump_existing));
+    if (dump_unchanged) {
+        return false;
+    }
+
+    if (file_write_all((char *) (filename), data, size)) {
+        sprintf(failure_message_note, "Failed to write data to file: %s", filename);
+        return true;
+    }
+
+    backup_add(hash, size, filename);
+
+    return false;
+}
+
+static bool dump_bank(void *buffer, size_t offset, size_t length, void *arg) {
+    int port = (int) (uintptr_t) (arg);
+    int bank = (int) (offset / MEMPAK_BANK_SIZE);
+
+    int rd = cpak_read((joypad_port_t)port, (uint8_t)bank, (uint16_t)(offset % MEMPAK_BANK_SIZE), buffer, length);
+    if (rd < 0 || (size_t) rd != length) {
+        sprintf(failure_message_note, "Failed to read Controller Pak bank %d (err=%d)", bank, (rd < 0) ? errno : -1);
+        return true;
+    }
+
+    return false;
+}
+
+static void dump_progress(float progress) {
+    surface_t *d = (progress >= 1.0f) ? display_get() : display_try_get();
+
+    if (d) {
+        char message[64];
+        uint64_t elapsed_us = get_ticks_us() - dump_start_us;
+        uint32_t speed = (elapsed_us > 0) ? (uint32_t) (((dump_size * progress) * 1000000.0f) / (elapsed_us * 1024.0f)) : 0;
+
+        sprintf(message, "Saving Controller Pak %d... %lu KiB/s", dump_port + 1, speed);
+
+        rdpq_attach(d, NULL);
+
+        ui_components_background_draw();
+
+        ui_components_loader_draw(progress, message);
+
+        ui_components_detach_show();
+    }
+}
+
+static bool dump_cpak_to_file(int port, const char *filename, int *banks) {
+    *banks = cpak_probe_banks(port);
+    if (*banks < 1) {
         // Fallback to 1 bank if probing not available; or show error.
-        banks = 1;
+        *banks = 1;
+    }
+
+    failure_message_note[0] = '\0';
+    dump_port = port;
+    dump_size = *banks * MEMPAK_BANK_SIZE;
+    dump_start_us = get_ticks_us();
+
+    uint8_t *image = malloc(dump_size);
+    if (image == NULL) {
+        sprintf(failure_message_note, "Couldn't allocate memory for the Controller Pak image");
+        return true;
+    }
+
+    // NOTE: Banks are read in smaller chunks, so the progress bar moves for single bank paks too
+    for (size_t offset = 0; offset < dump_size; offset += DUMP_CHUNK_SIZE) {
+        if (dump_bank(&image[offset], offset, DUMP_CHUNK_SIZE, (void *) (uintptr_t) (port))) {
+            free(image);
+            return true;
+        }
+        dump_progress((float) (offset + DUMP_CHUNK_SIZE) / dump_size);
     }
 
+    bool error = backup_store(filename, image, dump_size);
+
+    free(image);
+
+    return error;
+}
+
+static void dump_complete_cpak(int port) {
     get_rtc_time(string_datetime_cpak);
     char complete_filename[200];
     sprintf(complete_filename, "%s/CPAK_%s%s", CPAK_PATH, string_datetime_cpak, CPAK_EXTENSION);
 
-    FILE *fp = fopen(complete_filename, "wb");
-    if (!fp) {
-        sprintf(failure_message_note, "Failed to open file for writing: %s\n", complete_filename);
+    int banks;
+    if (dump_cpak_to_file(port, complete_filename, &banks)) {
         error_message_displayed = true;
         return;
     }
 
-    uint8_t *bankbuf = malloc(MEMPAK_BANK_SIZE);
-    if (!bankbuf) {
-        sprintf(failure_message_note, "Memory allocation failed!");
-        error_message_displayed = true;
-        fclose(fp);
-        return;
-    }
+    process_complete_full_dump = true;
+}
 
-    for (int b = 0; b < banks; ++b) {
-        int rd = cpak_read((joypad_port_t)port, (uint8_t)b, 0, bankbuf, MEMPAK_BANK_SIZE);
-        if (rd < 0 || rd != MEMPAK_BANK_SIZE) {
-            sprintf(failure_message_note, "Failed to read Controller Pak bank %d (err=%d)", b, (rd < 0) ? errno : -1);
-            error_message_displayed = true;
-            free(bankbuf);
-            fclose(fp);
-            return;
+static void dump_all_cpaks(void) {
+    // NOTE: libdragon serves one accessory transfer per joybus command, the ports are dumped one after another
+    get_rtc_time(string_datetime_cpak);
+
+    for (int port = 0; port < 4; port++) {
+        if (joypad_get_accessory_type(port) != JOYPAD_ACCESSORY_TYPE_CONTROLLER_PAK) {
+            sprintf(dump_all_results[port], "Controller %d: No Controller Pak", port + 1);
+            continue;
         }
 
-        size_t wr = fwrite(bankbuf, 1, MEMPAK_BANK_SIZE, fp);
-        if (wr != MEMPAK_BANK_SIZE) {
-            sprintf(failure_message_note, "Failed to write data to file: %s", complete_filename);
-            error_message_displayed = true;
-            free(bankbuf);
-            fclose(fp);
-            return;
+        char complete_filename[200];
+        sprintf(complete_filename, "%s/CPAK_%s_P%d%s", CPAK_PATH, string_datetime_cpak, port + 1, CPAK_EXTENSION);
+
+        int banks;
+        if (dump_cpak_to_file(port, complete_filename, &banks)) {
+            sprintf(dump_all_results[port], "Controller %d: Failed", port + 1);
+        } else if (dump_unchanged) {
+            sprintf(dump_all_results[port], "Controller %d: Unchanged since the last backup", port + 1);
+        } else {
+            sprintf(dump_all_results[port], "Controller %d: Saved, %d bank%s", port + 1, banks, (banks == 1) ? "" : "s");
         }
     }
 
-    free(bankbuf);
-    fclose(fp);
-    process_complete_full_dump = true;
+    process_complete_dump_all = true;
 }
 
 static void dump_single_note(int _port, int16_t selected_index) {
     sprintf(failure_message_note, " ");
-    FILE *fSource, *fDump;
+    FILE *fSource;
     char filename_note[256];
 
     get_rtc_time(string_datetime_cpak);
 
     sprintf(filename_note, "%s%s", CPAK_MOUNT_ARRAY[controller_selected], controller_pak_name_notes[selected_index]);
 
+    int size = get_file_size_from_fs_path(filename_note);
+
     fSource = fopen(filename_note, "rb");
-    if (fSource == NULL) {
+    if ((fSource == NULL) || (size < 0)) {
+        if (fSource != NULL) {
+            fclose(fSource);
+        }
         sprintf(failure_message_note, "No note found in controller %d at slot %d!", controller_selected + 1, selected_index + 1);
         error_message_displayed = true;
         return;
     }
 
-    sprintf(filename_note, "%s/%s_%s%s", CPAK_NOTES_PATH, controller_pak_name_notes[selected_index], string_datetime_cpak, CPAK_NOTE_EXTENSION);
-
-    fDump = fopen(filename_note, "wb");
-    if (fDump == NULL) {
-        sprintf(failure_message_note, "Unable to create dump file: %s", filename_note);
+    uint8_t *note = malloc(size);
+    if (note == NULL) {
         fclose(fSource);
+        sprintf(failure_message_note, "Couldn't allocate memory for the note");
         error_message_displayed = true;
         return;
     }
@@ -329,38 +565,29 @@ static void dump_single_note(int _port, int16_t selected_index) {
         index_selected + 1
     );
     ui_components_loader_draw(0, "Saving Controller Pak note...");
-    rdpq_detach_show();
+    ui_components_detach_show();
 
-    char buffer[4096];
-    size_t bytesRead;
-
-    while ((bytesRead = fread(buffer, 1, sizeof(buffer), fSource)) > 0) {
-        size_t bytesWritten = fwrite(buffer, 1, bytesRead, fDump);
-        if (bytesWritten < bytesRead) {
-            fclose(fSource);
-            fclose(fDump);
-            sprintf(failure_message_note, "Write error while copying to destination!");
-            error_message_displayed = true;
-            return;
-        }
+    if (fread(note, 1, size, fSource) != (size_t) (size)) {
+        fclose(fSource);
+        free(note);
+        sprintf(failure_message_note, "Read error while copying the note!");
+        error_message_displayed = true;
+        return;
     }
 
     fclose(fSource);
-    fclose(fDump);
-    process_complete_note_dump = true;
 
-}
+    sprintf(filename_note, "%s/%s_%s%s", CPAK_NOTES_PATH, controller_pak_name_notes[selected_index], string_datetime_cpak, CPAK_NOTE_EXTENSION);
 
-static bool file_exists(const char *filename)
-{
-    FILE *fp = fopen(filename, "r");
-    bool is_exist = false;
-    if (fp != NULL)
-    {
-        is_exist = true;
-        fclose(fp);
+    failure_message_note[0] = '\0';
+    if (backup_store(filename_note, note, size)) {
+        free(note);
+        error_message_displayed = true;
+        return;
     }
-    return is_exist;
+
+    free(note);
+    process_complete_note_dump = true;
 }
 
 static void delete_single_note(int _port, unsigned short selected_index) {
@@ -369,7 +596,7 @@ static void delete_single_note(int _port, unsigned short selected_index) {
 
     sprintf(filename_note, "%s%s", CPAK_MOUNT_ARRAY[controller_selected], controller_pak_name_notes[selected_index]);
 
-    if (!file_exists(filename_note)) {
+    if (!file_exists_full(filename_note)) {
         sprintf(failure_message_note, "No note found in controller %d at slot %d!", controller_selected + 1, selected_index + 1);
         error_message_displayed = true;
         return;
@@ -377,13 +604,14 @@ static void delete_single_note(int _port, unsigned short selected_index) {
 
     remove(filename_note);
 
-    if (file_exists(filename_note)) {
+    if (file_exists_full(filename_note)) {
         sprintf(failure_message_note, "Failed to delete file: %s", filename_note);
         error_message_displayed = true;
         return;
     }  
 
     reset_vars();
+    note_cache_remove(controller_selected, selected_index);
     cpakfs_unmount(controller_selected);
     mounted[controller_selected] = false;
     has_pak[controller_selected] = false;
@@ -394,6 +622,7 @@ static void delete_single_note(int _port, unsigned short selected_index) {
 
 static bool is_one_of_process_complete() {
     return process_complete_full_dump 
+    || process_complete_dump_all
     || process_complete_note_dump 
     || process_complete_format 
     || process_complete_delete
@@ -411,6 +640,12 @@ static void process (menu_t *menu) {
             return;
         }
 
+        if(process_complete_dump_all && menu->actions.enter) {
+            sound_play_effect(SFX_ENTER);
+            process_complete_dump_all = false;
+            return;
+        }
+
         if(process_complete_note_dump && menu->actions.enter) {
             sound_play_effect(SFX_ENTER);
             process_complete_note_dump = false;
@@ -887,7 +1122,14 @@ static void draw (menu_t *menu, surface_t *d) {
         );   
     }
 
-    if (process_complete_full_dump) {
+    if (process_complete_full_dump && dump_unchanged) {
+        ui_components_messagebox_draw(
+            "Pak unchanged since the backup:\n"
+            "%s\n\n"
+            "Press A to continue.",
+            file_basename(dump_existing)
+        );
+    } else if (process_complete_full_dump) {
         ui_components_messagebox_draw(
             "Pak saved to:\n"
             "%s\n\n"
@@ -896,7 +1138,28 @@ static void draw (menu_t *menu, surface_t *d) {
         );   
     }
 
-    if (process_complete_note_dump) {
+    if (process_complete_dump_all) {
+        ui_components_messagebox_draw(
+            "Paks saved to:\n"
+            "%s\n\n"
+            "%s\n%s\n%s\n%s\n\n"
+            "Press A to continue.",
+            CPAK_PATH,
+            dump_all_results[0],
+            dump_all_results[1],
+            dump_all_results[2],
+            dump_all_results[3]
+        );
+    }
+
+    if (process_complete_note_dump && dump_unchanged) {
+        ui_components_messagebox_draw(
+            "Note unchanged since the backup:\n"
+            "%s\n\n"
+            "Press A to continue.",
+            file_basename(dump_existing)
+        );
+    } else if (process_complete_note_dump) {
         ui_components_messagebox_draw(
             "Note saved to:\n"
             "%s/notes\n\n"
@@ -960,7 +1223,7 @@ static void draw (menu_t *menu, surface_t *d) {
     if (start_complete_dump) {
 
         if (cpakfs_stats.pages.used <= 0) {
-            rdpq_detach_show();
+            ui_components_detach_show();
             sprintf(failure_message_note, "No data found on Controller Pak on controller %d!", controller_selected + 1);
             error_message_displayed = true;
             start_complete_dump = false;
@@ -968,35 +1231,43 @@ static void draw (menu_t *menu, surface_t *d) {
 
         } else {
             ui_components_loader_draw(0, "Saving Controller Pak...");
-            rdpq_detach_show();
+            ui_components_detach_show();
             dump_complete_cpak(controller_selected);
             start_complete_dump = false;
             return;
         }
     }
 
+    if (start_dump_all) {
+        ui_components_loader_draw(0, "Saving Controller Paks...");
+        ui_components_detach_show();
+        dump_all_cpaks();
+        start_dump_all = false;
+        return;
+    }
+
     if (start_single_note_dump) {
-        rdpq_detach_show();
+        ui_components_detach_show();
         dump_single_note(controller_selected, index_selected);
         start_single_note_dump = false;
         return;
     }
 
     if (start_single_note_delete) {
-        rdpq_detach_show();
+        ui_components_detach_show();
         delete_single_note(controller_selected, index_selected);
         start_single_note_delete = false;
         return;
     }
 
     if (start_format_controller_pak) {
-        rdpq_detach_show();
+        ui_components_detach_show();
         format_controller_pak();
         start_format_controller_pak = false;
         return;
     }
     
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 void view_controller_pakfs_init (menu_t *menu) {
@@ -1006,11 +1277,13 @@ void view_controller_pakfs_init (menu_t *menu) {
     unmount_all_cpakfs();
     unmounted = true;
 
+    // NOTE: Notes may have been restored from other views, the cache only lives while the manager is open
     for(int i = 0; i < 4; i++){
         mounted[i] = false;
         has_pak[i] = false;
         corrupted[i] = false;
         memset(&stats_per_port[i], 0, sizeof(stats_per_port[i]));
+        note_cache[i].valid = false;
     }
 
     use_rtc = menu->current_time >= 0 ? true : false;
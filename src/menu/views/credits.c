@@ -63,7 +63,7 @@ static void draw (menu_t *menu, surface_t *d) {
         "B: Exit"
     );
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
@@ -444,7 +444,7 @@ static void draw (menu_t *menu, surface_t *display) {
         );
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 void view_datel_code_editor_init (menu_t *menu) {
@@ -20,7 +20,7 @@ static void draw (menu_t *menu, surface_t *d) {
         ui_components_messagebox_draw("Unspecified error");
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 static void deinit (menu_t *menu) {
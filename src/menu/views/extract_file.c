@@ -1,6 +1,7 @@
 #include <miniz.h>
 #include <miniz_zip.h>
-#include <sys/utime.h>
+#include "../file_ops.h"
+#include "../file_types.h"
 #include "../sound.h"
 
 #include "utils/fs.h"
@@ -8,25 +9,8 @@
 
 static mz_zip_archive_file_stat st;
 
-static size_t mz_zip_file_write_callback(void *pOpaque, mz_uint64 ofs, const void *pBuf, size_t n) {
-    float progress = ofs / (float)st.m_uncomp_size;
-    surface_t *d = (progress >= 1.0f) ? display_get() : display_try_get();
-    n = fwrite(pBuf, 1, n, (FILE *)pOpaque);
 
-    if (d) {
-        rdpq_attach(d, NULL);
-
-        ui_components_background_draw();
-
-        ui_components_loader_draw(progress, "Extracting file...");  
-
-        rdpq_detach_show();
-    }
-
-    return n;
-}
-
-static void extract(menu_t *menu) {
+static void extract (menu_t *menu) {
     path_t *path = path_clone(menu->browser.directory);
     path_pop(path);
     path_push(path, st.m_filename);
@@ -34,39 +18,36 @@ static void extract(menu_t *menu) {
     path_t *dir = path_clone(path);
     path_pop(dir);
 
+    file_ops_err_t err;
+
     if (file_exists(path_get(path))) {
         menu->browser.select_file = path_clone(path);
         menu_show_error(menu, "File already exists");
     } else if (directory_create(path_get(dir))) {
         menu_show_error(menu, "Failed to create directory");
+    } else if ((err = file_ops_extract(menu->browser.directory, st.m_file_index, path, st.m_time)) != FILE_OPS_OK) {
+        menu_show_error(menu, file_ops_convert_error_message(err));
     } else {
-        FILE *file = fopen(path_get(path), "wb");
-        if (file) {
-            struct utimbuf mtime = { st.m_time, st.m_time };
-            if (!mz_zip_reader_extract_to_callback(
-                &menu->browser.zip,
-                st.m_file_index,
-                mz_zip_file_write_callback,
-                file, 0)) {
-                menu_show_error(menu, "Failed to extract file");
-            }
-            fclose(file);
-            utime(path_get(path), &mtime);
-            menu->browser.select_file = path_clone(path);
-            menu->next_mode = MENU_MODE_BROWSER;
-        } else {
-            menu_show_error(menu, "Failed to create file");
-        }
+        // NOTE: The file is extracted in the background, the browser shows the progress
+        menu->next_mode = MENU_MODE_BROWSER;
     }
 
     path_free(path);
     path_free(dir);
 }
 
+static bool is_loadable_rom (void) {
+    return !st.m_is_directory && st.m_is_supported && (file_type_get(st.m_filename) == ENTRY_TYPE_ROM);
+}
+
 static void process (menu_t *menu) {
     if (menu->actions.enter && !st.m_is_directory && st.m_is_supported) {
         sound_play_effect(SFX_ENTER);
         menu->load_pending.extract_file = true;
+    } else if (menu->actions.options && is_loadable_rom()) {
+        sound_play_effect(SFX_ENTER);
+        menu->load.load_archive_id = st.m_file_index;
+        menu->next_mode = MENU_MODE_LOAD_ROM;
     } else if (menu->actions.back) {
         sound_play_effect(SFX_EXIT);
         menu->next_mode = MENU_MODE_BROWSER;
@@ -112,9 +93,18 @@ static void draw (menu_t *menu, surface_t *d) {
             ALIGN_LEFT, VALIGN_TOP,
             st.m_is_supported ? "A: Extract\nB: Exit" : "\nB: Exit"
         );
+
+        if (is_loadable_rom()) {
+            ui_components_actions_bar_text_draw(
+                STL_DEFAULT,
+                ALIGN_RIGHT, VALIGN_TOP,
+                "R: Load ROM\n"
+                "\n"
+            );
+        }
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
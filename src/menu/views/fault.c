@@ -1,5 +1,10 @@
+#include "utils/trace_events.h"
 #include "views.h"
 
+#define TRACE_EVENTS_FILE   "/menu/trace.json"
+
+static bool trace_saved;
+
 
 static void draw (menu_t *menu, surface_t *d) {
     rdpq_attach(d, NULL);
@@ -18,17 +23,21 @@ static void draw (menu_t *menu, surface_t *d) {
         "\n"
         "%s\n"
         "\n"
+        "%s"
         "%s",
         flashcart_convert_error_message(menu->flashcart_err),
-        (menu->flashcart_err == FLASHCART_ERR_OUTDATED) ? firmware_message : ""
+        (menu->flashcart_err == FLASHCART_ERR_OUTDATED) ? firmware_message : "",
+        trace_saved ? "\n\nTrace saved to " TRACE_EVENTS_FILE : ""
     );
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
 void view_fault_init (menu_t *menu) {
-    // Nothing to initialize (yet)
+    path_t *path = path_init(menu->storage_prefix, TRACE_EVENTS_FILE);
+    trace_saved = !trace_events_save(path_get(path));
+    path_free(path);
 }
 
 void view_fault_display (menu_t *menu, surface_t *display) {
@@ -1,11 +1,28 @@
 #include <sys/stat.h>
+#include "../file_ops.h"
 #include "../sound.h"
+#include "flashcart/flashcart_utils.h"
 
 #include "views.h"
 
 static struct stat st;
 
 static file_info_t info;
+static bool relocatable;
+
+
+static void relocate (menu_t *menu) {
+    path_t *path = path_clone_push(menu->browser.directory, menu->browser.entry->name);
+    file_ops_err_t err = file_ops_relocate(path);
+    path_free(path);
+
+    if (err != FILE_OPS_OK) {
+        menu_show_error(menu, file_ops_convert_error_message(err));
+        return;
+    }
+
+    menu->next_mode = MENU_MODE_BROWSER;
+}
 
 static void process (menu_t *menu) {
     if (info.is_controller_pak_dump && menu->actions.enter) {
@@ -14,6 +31,9 @@ static void process (menu_t *menu) {
     } else if (info.is_controller_pak_dump_note  && menu->actions.enter) {
         sound_play_effect(SFX_ENTER);
         menu->next_mode = MENU_MODE_CONTROLLER_PAK_DUMP_NOTE_INFO;
+    } else if (relocatable && menu->actions.enter) {
+        sound_play_effect(SFX_ENTER);
+        relocate(menu);
     } else if (menu->actions.back) {
         sound_play_effect(SFX_EXIT);
         menu->next_mode = MENU_MODE_BROWSER;
@@ -41,6 +61,12 @@ static void draw (menu_t *menu, surface_t *d) {
             "A: Restore note to Controller Pak\n"
             "B: Back"
         );
+    } else if (relocatable) {
+        ui_components_actions_bar_text_draw(STL_DEFAULT,
+            ALIGN_LEFT, VALIGN_TOP,
+            "A: Relocate contiguously\n"
+            "B: Back"
+        );
     } else {
         ui_components_actions_bar_text_draw(STL_DEFAULT,
             ALIGN_LEFT, VALIGN_TOP,
@@ -49,7 +75,7 @@ static void draw (menu_t *menu, surface_t *d) {
         );
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
@@ -71,8 +97,13 @@ void view_file_info_init (menu_t *menu) {
             .is_controller_pak_dump = false,
             .is_controller_pak_dump_note = false,
         };
+        if (!info.directory) {
+            info.fragments = fatfs_get_file_fragments(path_get(path));
+        }
     }
 
+    relocatable = (info.fragments > 1) && file_ops_can_relocate(menu->browser.entry->name);
+
     path_free(path);
 }
 
@@ -1,5 +1,7 @@
 #include "views.h"
 #include "../sound.h"
+#include "utils/trace.h"
+#include "utils/utils.h"
 #include <libcart/cart.h>
 
 
@@ -33,6 +35,73 @@ static const char *format_cart_version () {
     return buffer;
 }
 
+static const char *format_load_stats () {
+    flashcart_load_stats_t *stats = flashcart_get_load_stats();
+    static char buffer[160];
+
+    if ((stats->bytes == 0) || (stats->total_us == 0)) {
+        return "  No data";
+    }
+
+    uint32_t throughput = (uint32_t) ((stats->bytes * 1000000ULL) / stats->total_us / KiB(1));
+
+    sprintf(buffer,
+        "  Throughput: %lu KiB/s (%lu KiB chunks)\n"
+        "  Stall time: %lu ms of %lu ms\n"
+        "  Chunk time: %lu - %lu us",
+        throughput, stats->chunk_size / KiB(1),
+        (uint32_t) (stats->stall_us / 1000), (uint32_t) (stats->total_us / 1000),
+        stats->chunk_min_us, stats->chunk_max_us
+    );
+
+    return buffer;
+}
+
+static const char *format_boot_history () {
+    static char buffer[TRACE_HISTORY_COUNT * 80];
+    int length = 0;
+
+    if (trace_get_record_count() == 0) {
+        return "  No data";
+    }
+
+    for (int i = 0; i < trace_get_record_count(); i++) {
+        trace_record_t *record = trace_get_record(i);
+        trace_phase_t *slowest = NULL;
+        uint32_t total_us = 0;
+
+        for (int p = 0; p < record->phase_count; p++) {
+            trace_phase_t *phase = &record->phases[p];
+            if (phase->depth != 0) {
+                continue;
+            }
+            total_us += phase->duration_us;
+            if ((slowest == NULL) || (phase->duration_us > slowest->duration_us)) {
+                slowest = phase;
+            }
+        }
+
+        length += snprintf(buffer + length, sizeof(buffer) - length,
+            "%s  %.20s: %lu ms",
+            (i == 0) ? "" : "\n",
+            record->name,
+            total_us / 1000
+        );
+        if ((slowest != NULL) && (length < (int) (sizeof(buffer)))) {
+            length += snprintf(buffer + length, sizeof(buffer) - length,
+                " (%s %lu ms)",
+                slowest->name,
+                slowest->duration_us / 1000
+            );
+        }
+        if (length >= (int) (sizeof(buffer))) {
+            break;
+        }
+    }
+
+    return buffer;
+}
+
 static void process (menu_t *menu) {
     if (menu->actions.back) {
         sound_play_effect(SFX_EXIT);
@@ -73,6 +142,11 @@ static void draw (menu_t *menu, surface_t *d) {
         "  Save Writeback:   %s.\n"
         "  Auto F/W Updates: %s.\n"
         "  Fast ROM Reboots: %s.\n"
+        "  HW Byte Swap:     %s.\n\n"
+        "Last load:\n"
+        "%s\n\n"
+        "Recent boots:\n"
+        "%s\n"
         "\n\n",
         format_cart_type(),
         format_cart_version(),
@@ -83,7 +157,10 @@ static void draw (menu_t *menu, surface_t *d) {
         format_boolean_type(flashcart_has_feature(FLASHCART_FEATURE_AUTO_REGION)),
         format_boolean_type(flashcart_has_feature(FLASHCART_FEATURE_SAVE_WRITEBACK)),
         format_boolean_type(flashcart_has_feature(FLASHCART_FEATURE_BIOS_UPDATE_FROM_MENU)),
-        format_boolean_type(flashcart_has_feature(FLASHCART_FEATURE_ROM_REBOOT_FAST))
+        format_boolean_type(flashcart_has_feature(FLASHCART_FEATURE_ROM_REBOOT_FAST)),
+        format_boolean_type(flashcart_has_feature(FLASHCART_FEATURE_BYTESWAP_ON_LOAD)),
+        format_load_stats(),
+        format_boot_history()
 
         //TODO: display the battery and temperature information (if available).
         //format_diagnostic_data(flashcart_has_feature(FLASHCART_FEATURE_DIAGNOSTIC_DATA))
@@ -96,7 +173,7 @@ static void draw (menu_t *menu, surface_t *d) {
         "B: Back"
     );
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
@@ -1,10 +1,17 @@
 #include <stdarg.h>
 #include "../bookkeeping.h"
 #include "../fonts.h"
+#include "../rom_info.h"
 #include "../ui_components/constants.h"
 #include "../sound.h"
+#include "utils/utils.h"
 #include "views.h"
 
+#define PAGE_ENTRIES            (8)
+#define PRELOAD_BUDGET_US       (2000)
+#define PRELOAD_BOXART_COUNT    (3)
+#define ITEMS_MAX               ((HISTORY_COUNT > FAVORITES_COUNT) ? HISTORY_COUNT : FAVORITES_COUNT)
+
 
 typedef enum {
     BOOKKEEPING_TAB_CONTEXT_HISTORY,
@@ -13,10 +20,142 @@ typedef enum {
 } bookkeeping_tab_context_t;
 
 
+/** @brief Preloaded item information structure. */
+typedef struct {
+    bool loaded; /**< The information was looked up */
+    bool valid; /**< The ROM header information is available */
+    char title[21]; /**< Title from the ROM header */
+    char game_code[4]; /**< Game code from the ROM header */
+} item_info_t;
+
+/** @brief Preloaded box art structure. */
+typedef struct {
+    int item; /**< Item index, -1 when unused */
+    component_boxart_t *boxart; /**< Box art component */
+} item_boxart_t;
+
+
 static bookkeeping_tab_context_t tab_context = BOOKKEEPING_TAB_CONTEXT_NONE;
 static int selected_item = -1;
 static bookkeeping_item_t *item_list;
 static uint16_t item_max = 0;
+static item_info_t item_info[ITEMS_MAX];
+static item_boxart_t item_boxart[PRELOAD_BOXART_COUNT] = {
+    [0 ... (PRELOAD_BOXART_COUNT - 1)] = { .item = -1, .boxart = NULL },
+};
+static rom_info_t rom_info;
+
+
+static int page_start (void) {
+    return (selected_item > 0) ? ((selected_item / PAGE_ENTRIES) * PAGE_ENTRIES) : 0;
+}
+
+static void item_boxart_free (item_boxart_t *slot) {
+    ui_components_boxart_free(slot->boxart);
+    slot->boxart = NULL;
+    slot->item = -1;
+}
+
+static item_boxart_t *item_boxart_get (int item) {
+    for (int i = 0; i < PRELOAD_BOXART_COUNT; i++) {
+        if (item_boxart[i].item == item) {
+            return &item_boxart[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Drop the preloaded information, the item indices changed.
+ */
+static void item_info_reset (void) {
+    memset(item_info, 0, sizeof(item_info));
+    for (int i = 0; i < PRELOAD_BOXART_COUNT; i++) {
+        item_boxart_free(&item_boxart[i]);
+    }
+}
+
+/**
+ * @brief Look up the ROM header information of an item, from the ROM info cache when possible.
+ *
+ * @param item Item index.
+ */
+static void item_info_load (int item) {
+    item_info_t *info = &item_info[item];
+
+    info->loaded = true;
+
+    if ((item_list[item].bookkeeping_type != BOOKKEEPING_TYPE_ROM) || !path_has_value(item_list[item].primary_path)) {
+        return;
+    }
+
+    if (rom_info_cache_load(item_list[item].primary_path, &rom_info) == ROM_OK) {
+        info->valid = true;
+        memcpy(info->title, rom_info.title, sizeof(rom_info.title));
+        info->title[sizeof(rom_info.title)] = '\0';
+        memcpy(info->game_code, rom_info.game_code, sizeof(info->game_code));
+    }
+}
+
+/**
+ * @brief Load the information of the items around the visible page and the box art of the items around the selection.
+ *
+ * The items on the visible page are looked up first, then the ones on the neighbouring pages, within the time budget.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+static void items_preload (menu_t *menu) {
+    uint64_t start = get_ticks_us();
+    int first = page_start();
+
+    for (int pass = 0; pass < 3; pass++) {
+        int from = (pass == 0) ? first : ((pass == 1) ? (first + PAGE_ENTRIES) : (first - PAGE_ENTRIES));
+        for (int i = MAX(from, 0); (i < (from + PAGE_ENTRIES)) && (i < item_max); i++) {
+            if (item_list[i].bookkeeping_type == BOOKKEEPING_TYPE_EMPTY) {
+                break;
+            }
+            if (item_info[i].loaded) {
+                continue;
+            }
+            if ((get_ticks_us() - start) >= PRELOAD_BUDGET_US) {
+                return;
+            }
+            item_info_load(i);
+        }
+    }
+
+    if (selected_item < 0) {
+        return;
+    }
+
+    int wanted[PRELOAD_BOXART_COUNT] = { selected_item, selected_item + 1, selected_item - 1 };
+
+    for (int i = 0; i < PRELOAD_BOXART_COUNT; i++) {
+        bool keep = false;
+        for (int w = 0; w < PRELOAD_BOXART_COUNT; w++) {
+            keep |= (item_boxart[i].item == wanted[w]);
+        }
+        if (!keep && (item_boxart[i].item != -1)) {
+            item_boxart_free(&item_boxart[i]);
+        }
+    }
+
+    // NOTE: Only one box art is started per frame, the PNG decoder handles a single image at a time
+    for (int w = 0; w < PRELOAD_BOXART_COUNT; w++) {
+        int item = wanted[w];
+        if ((item < 0) || (item >= item_max) || !item_info[item].valid || (item_boxart_get(item) != NULL)) {
+            continue;
+        }
+        item_boxart_t *slot = item_boxart_get(-1);
+        if (slot == NULL) {
+            break;
+        }
+        if ((slot->boxart = ui_components_boxart_init(menu->storage_prefix, item_info[item].game_code, item_info[item].title, IMAGE_BOXART_FRONT)) != NULL) {
+            slot->item = item;
+        }
+        break;
+    }
+}
 
 
 static void item_reset_selected(menu_t *menu) {
@@ -30,7 +169,7 @@ static void item_reset_selected(menu_t *menu) {
     }  
 }
 
-static void item_move_next() {
+static bool item_move_next() {
     int last = selected_item;
 
     do
@@ -39,15 +178,14 @@ static void item_move_next() {
 
         if(selected_item >= item_max) {
             selected_item = last;
-            break;
+            return false;
         } else if(item_list[selected_item].bookkeeping_type != BOOKKEEPING_TYPE_EMPTY) {
-            sound_play_effect(SFX_CURSOR);
-            break;
+            return true;
         }
     } while (true);  
 }
 
-static void item_move_previous() {
+static bool item_move_previous() {
     int last = selected_item;
     do
     {
@@ -55,19 +193,33 @@ static void item_move_previous() {
 
         if(selected_item < 0) {
             selected_item = last;
-            break;
+            return false;
         } else if(item_list[selected_item].bookkeeping_type != BOOKKEEPING_TYPE_EMPTY) {
-            sound_play_effect(SFX_CURSOR);
-            break;
+            return true;
         }
     } while (true);
 }
 
+static void item_move(int steps) {
+    bool moved = false;
+
+    for(int i = 0; i < abs(steps); i++) {
+        if(!((steps > 0) ? item_move_next() : item_move_previous())) {
+            break;
+        }
+        moved = true;
+    }
+
+    if(moved) {
+        sound_play_effect(SFX_CURSOR);
+    }
+}
+
 static void process(menu_t *menu) {
     if(menu->actions.go_down) {
-        item_move_next();   
+        item_move(menu->actions.go_fast ? PAGE_ENTRIES : menu->actions.steps);
     } else if(menu->actions.go_up) {
-        item_move_previous();
+        item_move(menu->actions.go_fast ? -PAGE_ENTRIES : -menu->actions.steps);
     } else if(menu->actions.enter && selected_item != -1) {
                 
         if(tab_context == BOOKKEEPING_TAB_CONTEXT_FAVORITE) {
@@ -101,14 +253,22 @@ static void process(menu_t *menu) {
         sound_play_effect(SFX_CURSOR);
     }else if(tab_context == BOOKKEEPING_TAB_CONTEXT_FAVORITE && menu->actions.options && selected_item != -1) {
         bookkeeping_favorite_remove(&menu->bookkeeping, selected_item);
+        item_info_reset();
         item_reset_selected(menu);
         sound_play_effect(SFX_SETTING);
     }
 }
 
 static void draw_list(menu_t *menu, surface_t *display) {
+    int first = page_start();
+    int items = 0;
+
+    while((items < item_max) && (item_list[items].bookkeeping_type != BOOKKEEPING_TYPE_EMPTY)) {
+        items++;
+    }
+
     if(selected_item != -1) {
-        float highlight_y = VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TAB_HEIGHT +  TEXT_OFFSET_VERTICAL + (selected_item * 19 * 2);
+        float highlight_y = VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TAB_HEIGHT +  TEXT_OFFSET_VERTICAL + ((selected_item - first) * 19 * 2);
 
         ui_components_box_draw(
             VISIBLE_AREA_X0,
@@ -119,10 +279,10 @@ static void draw_list(menu_t *menu, surface_t *display) {
         );
     }
 
-    char buffer[1024];
+    char buffer[2048];
     buffer[0] = 0;
 
-    for(uint16_t i=0; i < item_max; i++) {   
+    for(int i = first; (i < (first + PAGE_ENTRIES)) && (i < item_max); i++) {
         if(path_has_value(item_list[i].primary_path)) {
             sprintf(buffer, "%s%d  : %s\n",buffer ,(i+1), path_last_get(item_list[i].primary_path));
         } else {
@@ -131,15 +291,20 @@ static void draw_list(menu_t *menu, surface_t *display) {
 
         if(path_has_value(item_list[i].secondary_path)) {
             sprintf(buffer, "%s     %s\n", buffer, path_last_get(item_list[i].secondary_path));
+        } else if(item_info[i].valid) {
+            sprintf(buffer, "%s     ^%02X%s^00\n", buffer, STL_GRAY, item_info[i].title);
         } else {
             sprintf(buffer, "%s\n", buffer);
         }
     }
 
+    item_boxart_t *slot = (selected_item != -1) ? item_boxart_get(selected_item) : NULL;
+
     int nbytes = strlen(buffer);
+    const char *text = fonts_prepare_text(buffer, &nbytes);
     rdpq_text_printn(
         &(rdpq_textparms_t) {
-            .width = VISIBLE_AREA_WIDTH - (TEXT_MARGIN_HORIZONTAL * 2),
+            .width = ((slot != NULL) ? (BOXART_X - VISIBLE_AREA_X0) : VISIBLE_AREA_WIDTH) - (TEXT_MARGIN_HORIZONTAL * 2),
             .height = LAYOUT_ACTIONS_SEPARATOR_Y - OVERSCAN_HEIGHT - (TEXT_MARGIN_VERTICAL * 2),
             .align = ALIGN_LEFT,
             .valign = VALIGN_TOP,
@@ -149,9 +314,15 @@ static void draw_list(menu_t *menu, surface_t *display) {
         FNT_DEFAULT,
         VISIBLE_AREA_X0 + TEXT_MARGIN_HORIZONTAL,
         VISIBLE_AREA_Y0 + TEXT_MARGIN_VERTICAL + TAB_HEIGHT +  TEXT_OFFSET_VERTICAL,
-        buffer,
+        text,
         nbytes
     );           
+
+    ui_components_list_scrollbar_draw(MAX(selected_item, 0), items, PAGE_ENTRIES);
+
+    if(slot != NULL) {
+        ui_components_boxart_draw(slot->boxart);
+    }
 }
 
 static void draw(menu_t *menu, surface_t *display) {
@@ -194,7 +365,7 @@ static void draw(menu_t *menu, surface_t *display) {
         "\n"
     );    
 
-    rdpq_detach_show();   
+    ui_components_detach_show();   
 }
 
 void view_favorite_init (menu_t *menu) {
@@ -202,12 +373,18 @@ void view_favorite_init (menu_t *menu) {
     item_list = menu->bookkeeping.favorite_items;
     item_max = FAVORITES_COUNT;
 
+    item_info_reset();
     item_reset_selected(menu);
 }
 
 void view_favorite_display (menu_t *menu, surface_t *display) {
     process(menu);
+    items_preload(menu);
     draw(menu, display); 
+
+    if (menu->next_mode != MENU_MODE_FAVORITE) {
+        item_info_reset();
+    }
 }
 
 void view_history_init (menu_t *menu) {
@@ -215,10 +392,16 @@ void view_history_init (menu_t *menu) {
     item_list = menu->bookkeeping.history_items;
     item_max = HISTORY_COUNT;
 
+    item_info_reset();
     item_reset_selected(menu);
 }
 
 void view_history_display (menu_t *menu, surface_t *display) {
     process(menu);
+    items_preload(menu);
     draw(menu, display); 
+
+    if (menu->next_mode != MENU_MODE_HISTORY) {
+        item_info_reset();
+    }
 }
@@ -9,15 +9,17 @@ static bool show_message;
 static bool image_loading;
 static bool image_set_as_background;
 static surface_t *image;
+static png_job_t image_job;
 
 
 static char *convert_error_message (png_err_t err) {
     switch (err) {
         case PNG_ERR_INT: return "Internal PNG decoder error";
-        case PNG_ERR_BUSY: return "PNG decode already in process";
+        case PNG_ERR_BUSY: return "PNG decode queue is full";
         case PNG_ERR_OUT_OF_MEM: return "PNG decode failed due to insufficient memory";
         case PNG_ERR_NO_FILE: return "PNG decoder couldn't open file";
         case PNG_ERR_BAD_FILE: return "Invalid PNG file";
+        case PNG_ERR_TOO_LARGE: return "Interlaced PNG file is too large to be displayed";
         default: return "Unknown PNG decoder error";
     }
 }
@@ -60,7 +62,7 @@ static void draw (menu_t *menu, surface_t *d) {
 
         ui_components_background_draw();
 
-        ui_components_loader_draw(png_decoder_get_progress(), "Loading image...");
+        ui_components_loader_draw(png_decoder_get_progress(image_job), "Loading image...");
     } else {
         rdpq_attach_clear(d, NULL);
 
@@ -83,12 +85,12 @@ static void draw (menu_t *menu, surface_t *d) {
         }
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 static void deinit (menu_t *menu) {
     if (image_loading) {
-        png_decoder_abort();
+        png_decoder_abort(image_job);
     }
 
     if (image) {
@@ -107,12 +109,18 @@ void view_image_viewer_init (menu_t *menu) {
     image_loading = true;
     image_set_as_background = false;
     image = NULL;
+    image_job = PNG_JOB_NONE;
 
     path_t *path = path_clone_push(menu->browser.directory, menu->browser.entry->name);
 
-    png_err_t err = png_decoder_start(path_get(path), 640, 480, image_callback, menu);
+    ui_components_boxart_cache_flush();
+
+    png_err_t err = png_decoder_start(path_get(path), 640, 480, PNG_PRIORITY_FOREGROUND, image_callback, menu, &image_job);
     if (err != PNG_OK) {
         menu_show_error(menu, convert_error_message(err));
+    } else {
+        png_decoder_set_dither(image_job, true);
+        png_decoder_set_downscale(image_job, true);
     }
 
     path_free(path);
@@ -1,9 +1,13 @@
+#include <string.h>
+
 #include "../cart_load.h"
 #include "../disk_info.h"
+#include "../file_types.h"
 #include "boot/boot.h"
 #include "../sound.h"
 #include "views.h"
 #include "../bookkeeping.h"
+#include "utils/fs.h"
 
 static component_boxart_t *boxart;
 static char *disk_filename;
@@ -36,6 +40,65 @@ static char *format_disk_region (disk_region_t region) {
 }
 
 
+static size_t disk_set_name_length (char *name) {
+    // NOTE: Disks of a set share the file name up to the first tag, e.g. "Title (Japan) (Disk 1).ndd"
+    char *end = strpbrk(name, "([");
+    if (end == NULL) {
+        end = strrchr(name, '.');
+    }
+    size_t length = (end != NULL) ? (size_t) (end - name) : strlen(name);
+    while ((length > 0) && (name[length - 1] == ' ')) {
+        length--;
+    }
+    return length;
+}
+
+static void disk_slots_free (menu_t *menu) {
+    for (int i = 0; i < menu->load.disk_slots.slot_count; i++) {
+        path_free(menu->load.disk_slots.slot[i].disk_path);
+        menu->load.disk_slots.slot[i].disk_path = NULL;
+    }
+    menu->load.disk_slots.slot_count = 0;
+}
+
+static void load_swap_disks (menu_t *menu) {
+    disk_slot_t *slots = &menu->load.disk_slots;
+    char *primary_name = path_last_get(slots->primary.disk_path);
+    size_t name_length = disk_set_name_length(primary_name);
+
+    disk_slots_free(menu);
+
+    if (name_length == 0) {
+        return;
+    }
+
+    path_t *directory = path_clone(slots->primary.disk_path);
+    path_pop(directory);
+
+    dir_t info;
+    int result = dir_findfirst(path_get(directory), &info);
+
+    while ((result == 0) && (slots->slot_count < (FLASHCART_64DD_MAX_DISKS - 1))) {
+        if ((info.d_type != DT_DIR) &&
+            (file_type_get(info.d_name) == ENTRY_TYPE_DISK) &&
+            (strcmp(info.d_name, primary_name) != 0) &&
+            (disk_set_name_length(info.d_name) == name_length) &&
+            (strncmp(info.d_name, primary_name, name_length) == 0)) {
+            disk_slot_entry_t *slot = &slots->slot[slots->slot_count];
+            slot->disk_path = path_clone_push(directory, info.d_name);
+            if ((disk_info_load(slot->disk_path, &slot->disk_info) == DISK_OK) && (slot->disk_info.region == slots->primary.disk_info.region)) {
+                slots->slot_count += 1;
+            } else {
+                path_free(slot->disk_path);
+                slot->disk_path = NULL;
+            }
+        }
+        result = dir_findnext(path_get(directory), &info);
+    }
+
+    path_free(directory);
+}
+
 static void add_favorite (menu_t *menu, void *arg) {
     bookkeeping_favorite_add(&menu->bookkeeping, menu->load.disk_slots.primary.disk_path, menu->load.rom_path, BOOKKEEPING_TYPE_DISK);
 }
@@ -111,12 +174,14 @@ static void draw (menu_t *menu, surface_t *d) {
             " Unique ID:\t%.4s\n"
             " Version:\t%hhu\n"
             " Disk type:\t%d\n"
+            " Disk set:\t%d disk(s)\n"
             "\n"
             ,
             format_disk_region(menu->load.disk_slots.primary.disk_info.region),
             menu->load.disk_slots.primary.disk_info.id,
             menu->load.disk_slots.primary.disk_info.version,
-            menu->load.disk_slots.primary.disk_info.disk_type
+            menu->load.disk_slots.primary.disk_info.disk_type,
+            (menu->load.disk_slots.slot_count + 1)
         );
 
         ui_components_actions_bar_text_draw(
@@ -149,7 +214,7 @@ static void draw (menu_t *menu, surface_t *d) {
         ui_components_context_menu_draw(&options_context_menu);
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 static void draw_progress (float progress) {
@@ -162,7 +227,7 @@ static void draw_progress (float progress) {
         
         ui_components_loader_draw(progress, "Loading 64DD disk...");
 
-        rdpq_detach_show();
+        ui_components_detach_show();
     }
 }
 
@@ -234,6 +299,7 @@ void view_load_disk_init (menu_t *menu) {
         path_free(menu->load.disk_slots.primary.disk_path);
         menu->load.disk_slots.primary.disk_path = NULL;
     }
+    disk_slots_free(menu);
 
     menu->load_pending.disk_file = false;
 
@@ -284,12 +350,8 @@ void view_load_disk_init (menu_t *menu) {
         menu_show_error(menu, convert_disk_error_message(err));
         return;
     }
-    // load swap disks
-    // disk_err_t err = disk_info_load(menu->load.disk_slots.slot[0].disk_path, &menu->load.disk_slots.slot[0].disk_info);
-    // if (err != DISK_OK) {
-    //     menu_show_error(menu, convert_disk_error_message(err));
-    //     return;
-    // }
+
+    load_swap_disks(menu);
 
     ui_components_context_menu_init(&options_context_menu);
     boxart = ui_components_boxart_init(menu->storage_prefix, menu->load.disk_slots.primary.disk_info.id, NULL, IMAGE_BOXART_FRONT);
@@ -78,7 +78,7 @@ static void draw (menu_t *menu, surface_t *d) {
         );
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 static void draw_progress (float progress) {
@@ -91,7 +91,7 @@ static void draw_progress (float progress) {
 
         ui_components_loader_draw(progress, "Loading emulated ROM...");
 
-        rdpq_detach_show();
+        ui_components_detach_show();
     }
 }
 
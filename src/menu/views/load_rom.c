@@ -1,13 +1,22 @@
 #include "../bookkeeping.h"
 #include "../cart_load.h"
+#include "../compressed_rom.h"
 #include "../datel_codes.h"
+#include "../file_types.h"
+#include "../metadata.h"
 #include "../rom_info.h"
 #include "../sound.h"
 #include "boot/boot.h"
 #include "utils/fs.h"
+#include "utils/trace.h"
+#include "utils/utils.h"
 #include "views.h"
+#include <miniz.h>
+#include <miniz_zip.h>
 #include <string.h>
 
+#define ROM_HEADER_READ_SIZE    (KiB(4))
+
 static bool show_extra_info_message = false;
 static component_boxart_t *boxart;
 static char *rom_filename = NULL;
@@ -24,74 +33,6 @@ static const file_image_type_t metadata_image_filename_cache[] = {
     IMAGE_GAMEPAK_BACK
 };
 static const uint16_t metadata_image_filename_cache_length = sizeof(metadata_image_filename_cache) / sizeof(metadata_image_filename_cache[0]);
-static bool metadata_image_available[sizeof(metadata_image_filename_cache) / sizeof(metadata_image_filename_cache[0])] = {false};
-static bool metadata_images_scanned = false;
-
-static void scan_metadata_images(menu_t *menu) {
-    if (metadata_images_scanned) {
-        return;
-    }
-
-    path_t *path = path_init(menu->storage_prefix, "menu/metadata"); // should be METADATA_BASE_DIRECTORY
-    char game_code_path[50];
-
-    if (menu->load.rom_info.game_code[1] == 'E' && menu->load.rom_info.game_code[2] == 'D') {
-        // This is using a homebrew ROM ID, use the title for the file name instead.
-        // Create a null-terminated copy of the title for safe string operations
-        char safe_title[21];  // 20 chars + null terminator
-        memcpy(safe_title, menu->load.rom_info.title, 20);
-        safe_title[20] = '\0';
-        
-        sprintf(game_code_path, "homebrew/%s", safe_title); // should be HOMEBREW_ID_SUBDIRECTORY
-        path_push(path, game_code_path);
-    }
-    else {
-        snprintf(game_code_path, sizeof(game_code_path), "%c/%c/%c/%c",
-            menu->load.rom_info.game_code[0],
-            menu->load.rom_info.game_code[1],
-            menu->load.rom_info.game_code[2],
-            menu->load.rom_info.game_code[3]);
-        path_push(path, game_code_path);
-
-        if (!directory_exists(path_get(path))) { // Allow boxart to not specify the region code.
-            path_pop(path);
-        }
-    }
-
-    bool dir_exists = directory_exists(path_get(path));
-
-    if (dir_exists) {
-        // Filenames array matches metadata_image_filename_cache order for indexed access
-        // Note: This mapping is also present in boxart.c but duplicated here
-        // for efficient scanning without calling into the component layer
-        char *filenames[] = {
-            "boxart_front.png",
-            "boxart_back.png",
-            "boxart_left.png",
-            "boxart_right.png",
-            "boxart_top.png",
-            "boxart_bottom.png",
-            "gamepak_front.png",
-            "gamepak_back.png"
-        };
-
-        for (uint16_t i = 0; i < metadata_image_filename_cache_length; i++) {
-            path_push(path, filenames[i]);
-            metadata_image_available[i] = file_exists(path_get(path));
-            path_pop(path);
-        }
-    } else {
-        // No directory exists, mark all images as unavailable
-        for (uint16_t i = 0; i < metadata_image_filename_cache_length; i++) {
-            metadata_image_available[i] = false;
-        }
-    }
-
-    debugf("Metadata: Scanned metadata for ROM ID %s. \n", game_code_path);
-
-    path_free(path);
-    metadata_images_scanned = true;
-}
 
 static const char *format_rom_description(menu_t *menu) {
     char *rom_description = NULL;
@@ -111,7 +52,7 @@ static char *convert_error_message (rom_err_t err) {
 static const char *format_rom_endianness (rom_endianness_t endianness) {
     switch (endianness) {
         case ENDIANNESS_BIG: return "Big (default)";
-        case ENDIANNESS_LITTLE: return "Little (unsupported)";
+        case ENDIANNESS_LITTLE: return "Little";
         case ENDIANNESS_BYTE_SWAP: return "Byte swapped";
         default: return "Unknown";
     }
@@ -294,11 +235,15 @@ static void set_patcher_option(menu_t *menu, void *arg) {
 #endif
 
 static void add_favorite (menu_t *menu, void *arg) {
+    if (menu->load.load_archive_id != -1) {
+        menu_show_error(menu, "Archived ROMs can't be added to favorites");
+        return;
+    }
     bookkeeping_favorite_add(&menu->bookkeeping, menu->load.rom_path, NULL, BOOKKEEPING_TYPE_ROM);
 }
 
 static void iterate_metadata_image(menu_t *menu, int direction) {
-    scan_metadata_images(menu);
+    uint32_t metadata_images = metadata_get_images(menu->storage_prefix, menu->load.rom_info.game_code, menu->load.rom_info.title);
 
     // Transverse to next/previous available image based on direction (1 = next, -1 = previous)
     int16_t start_metadata_image_index = current_metadata_image_index;
@@ -306,7 +251,7 @@ static void iterate_metadata_image(menu_t *menu, int direction) {
 
     // Find next available image from our cached list
     while (new_metadata_image_index != start_metadata_image_index) {
-        if (metadata_image_available[new_metadata_image_index]) {
+        if (metadata_images & METADATA_IMAGE_MASK(metadata_image_filename_cache[new_metadata_image_index])) {
             // ui_components_boxart_init returns NULL if PNG decoder is busy
             component_boxart_t *new_boxart = ui_components_boxart_init(
                 menu->storage_prefix,
@@ -431,6 +376,15 @@ static void process (menu_t *menu) {
 }
 
 static void draw (menu_t *menu, surface_t *d) {
+#ifdef FEATURE_AUTOLOAD_ROM_ENABLED
+    // NOTE: The UI stack isn't initialized when autoloading without the progress bar, only a blank frame is shown
+    if (menu->load_pending.rom_file && menu->settings.rom_autoload_enabled && !menu->settings.loading_progress_bar_enabled) {
+        rdpq_attach_clear(d, NULL);
+        rdpq_detach_show();
+        return;
+    }
+#endif
+
     rdpq_attach(d, NULL);
 
     ui_components_background_draw();
@@ -531,7 +485,7 @@ static void draw (menu_t *menu, surface_t *d) {
     }
 #endif
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 static void draw_progress (float progress) {
@@ -544,13 +498,21 @@ static void draw_progress (float progress) {
 
         ui_components_loader_draw(progress, "Loading ROM...");  
 
-        rdpq_detach_show();
+        ui_components_detach_show();
     }
 }
 
 static void load (menu_t *menu) {
     debugf("Load ROM: load function called\n");
     cart_load_err_t err;
+
+    rom_err_t config_err = rom_config_flush(menu->load.rom_path, &menu->load.rom_info);
+    if (config_err != ROM_OK) {
+        menu_show_error(menu, convert_error_message(config_err));
+        return;
+    }
+
+    trace_start(path_last_get(menu->load.rom_path));
 #ifdef FEATURE_AUTOLOAD_ROM_ENABLED
     if (!menu->settings.loading_progress_bar_enabled) {
         err = cart_load_n64_rom_and_save(menu, NULL);
@@ -566,7 +528,10 @@ static void load (menu_t *menu) {
         return;
     }
 
-    bookkeeping_history_add(&menu->bookkeeping, menu->load.rom_path, NULL, BOOKKEEPING_TYPE_ROM);
+    // NOTE: Archived ROMs don't exist as files, history entries would point nowhere
+    if (menu->load.load_archive_id == -1) {
+        bookkeeping_history_add(&menu->bookkeeping, menu->load.rom_path, NULL, BOOKKEEPING_TYPE_ROM);
+    }
 
     menu->next_mode = MENU_MODE_BOOT;
 
@@ -579,6 +544,8 @@ static void load (menu_t *menu) {
         default: menu->boot_params->tv_type = BOOT_TV_TYPE_PASSTHROUGH; break;
     }
 
+    trace_phase_begin("Cheat list generation");
+
     // Handle cheat codes only if Expansion Pak is present and cheats are enabled
     if (is_memory_expanded() && menu->load.rom_info.settings.cheats_enabled) {
         uint32_t tmp_cheats[MAX_CHEAT_CODE_ARRAYLIST_SIZE];
@@ -606,18 +573,51 @@ static void load (menu_t *menu) {
         debugf("Cheats disabled or Expansion Pak not present\n");
         menu->boot_params->cheat_list = NULL;
     }
+
+    trace_phase_end();
+}
+
+/**
+ * @brief Load the ROM information of an archived ROM from the start of its decompressed data.
+ *
+ * @param menu Pointer to the menu structure.
+ * @return rom_err_t Error code.
+ */
+static rom_err_t load_archived_rom_config (menu_t *menu) {
+    static uint8_t header[ROM_HEADER_READ_SIZE] __attribute__((aligned(8)));
+
+    mz_zip_reader_extract_iter_state *iter = mz_zip_reader_extract_iter_new(&menu->browser.zip, menu->load.load_archive_id, 0);
+    if (iter == NULL) {
+        return ROM_ERR_NO_FILE;
+    }
+
+    size_t length = mz_zip_reader_extract_iter_read(iter, header, sizeof(header));
+
+    mz_zip_reader_extract_iter_free(iter);
+
+    return rom_config_load_from_header(menu->load.rom_path, header, length, &menu->load.rom_info);
+}
+
+/**
+ * @brief Load the ROM information of a compressed ROM from its first decompressed chunk.
+ *
+ * @param menu Pointer to the menu structure.
+ * @return rom_err_t Error code.
+ */
+static rom_err_t load_compressed_rom_config (menu_t *menu) {
+    static uint8_t header[ROM_HEADER_READ_SIZE] __attribute__((aligned(8)));
+
+    if (compressed_rom_read_header(menu->load.rom_path, header, sizeof(header))) {
+        return ROM_ERR_LOAD_IO;
+    }
+
+    return rom_config_load_from_header(menu->load.rom_path, header, sizeof(header), &menu->load.rom_info);
 }
 
 static void deinit (void) {
     ui_components_boxart_free(boxart);
     boxart = NULL;
     current_metadata_image_index = 0;
-    metadata_images_scanned = false;
-
-    // Clear availability cache
-    for (uint16_t i = 0; i < metadata_image_filename_cache_length; i++) {
-        metadata_image_available[i] = false;
-    }
 }
 
 
@@ -629,7 +629,14 @@ void view_load_rom_init (menu_t *menu) {
             path_free(menu->load.rom_path);
         }
 
-        if(menu->load.load_history_id != -1) {
+        if (menu->load.load_archive_id != -1) {
+            mz_zip_archive_file_stat st;
+            menu->load.rom_path = path_clone(menu->browser.directory);
+            path_pop(menu->load.rom_path);
+            if (mz_zip_reader_file_stat(&menu->browser.zip, menu->load.load_archive_id, &st)) {
+                path_push(menu->load.rom_path, st.m_filename);
+            }
+        } else if(menu->load.load_history_id != -1) {
             menu->load.rom_path = path_clone(menu->bookkeeping.history_items[menu->load.load_history_id].primary_path);
         } else if(menu->load.load_favorite_id != -1) {
             menu->load.rom_path = path_clone(menu->bookkeeping.favorite_items[menu->load.load_favorite_id].primary_path);
@@ -647,7 +654,14 @@ void view_load_rom_init (menu_t *menu) {
     }
 
     debugf("Load ROM: loading ROM info from %s\n", path_get(menu->load.rom_path));
-    rom_err_t err = rom_config_load(menu->load.rom_path, &menu->load.rom_info);
+    rom_err_t err;
+    if (menu->load.load_archive_id != -1) {
+        err = load_archived_rom_config(menu);
+    } else if (file_type_get(path_get(menu->load.rom_path)) == ENTRY_TYPE_ROM_COMPRESSED) {
+        err = load_compressed_rom_config(menu);
+    } else {
+        err = rom_config_load(menu->load.rom_path, &menu->load.rom_info);
+    }
     if (err != ROM_OK) {
         path_free(menu->load.rom_path);
         menu->load.rom_path = NULL;
@@ -676,9 +690,17 @@ void view_load_rom_display (menu_t *menu, surface_t *display) {
         load(menu);
     }
 
+    if (menu->next_mode != MENU_MODE_LOAD_ROM) {
+        rom_err_t err = rom_config_flush(menu->load.rom_path, &menu->load.rom_info);
+        if (err != ROM_OK) {
+            menu_show_error(menu, convert_error_message(err));
+        }
+    }
+
     if (menu->next_mode != MENU_MODE_LOAD_ROM && menu->next_mode != MENU_MODE_DATEL_CODE_EDITOR) {
         menu->load.load_history_id = -1;
         menu->load.load_favorite_id = -1;
+        menu->load.load_archive_id = -1;
         deinit();
     }
 }
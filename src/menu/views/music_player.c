@@ -1,3 +1,4 @@
+#include "../bgm.h"
 #include "../mp3_player.h"
 #include "../sound.h"
 #include "views.h"
@@ -6,6 +7,8 @@
 #define SEEK_SECONDS        (5)
 #define SEEK_SECONDS_FAST   (60)
 
+static bool playlist = false;
+
 
 static char *convert_error_message (mp3player_err_t err) {
     switch (err) {
@@ -34,10 +37,46 @@ static void format_elapsed_duration (char *buffer, float elapsed, float duration
 }
 
 
+static int find_next_track (menu_t *menu) {
+    for (int i = menu->browser.selected + 1; i < menu->browser.entries; i++) {
+        if (menu->browser.list[i].type == ENTRY_TYPE_MUSIC) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void queue_next_track (menu_t *menu) {
+    int next = find_next_track(menu);
+
+    if (next < 0) {
+        return;
+    }
+
+    path_t *path = path_clone_push(menu->browser.directory, menu->browser.list[next].name);
+
+    // NOTE: A track that fails to load is not queued, the playback just stops at the end of the current one
+    mp3player_queue(path_get(path));
+
+    path_free(path);
+}
+
 static void process (menu_t *menu) {
     mp3player_err_t err;
 
     err = mp3player_process();
+
+    if (mp3player_track_changed()) {
+        int next = find_next_track(menu);
+        if (next >= 0) {
+            menu->browser.selected = next;
+            menu->browser.entry = &menu->browser.list[next];
+        }
+        if (playlist) {
+            queue_next_track(menu);
+        }
+    }
+
     if (err != MP3PLAYER_OK) {
         menu_show_error(menu, convert_error_message(err));
     } else if (menu->actions.back) {
@@ -55,6 +94,14 @@ static void process (menu_t *menu) {
         if (err != MP3PLAYER_OK) {
             menu_show_error(menu, convert_error_message(err));
         }
+    } else if (menu->actions.options) {
+        playlist = !playlist;
+        if (playlist) {
+            queue_next_track(menu);
+        } else {
+            mp3player_dequeue();
+        }
+        sound_play_effect(SFX_SETTING);
     }
 }
 
@@ -98,10 +145,15 @@ static void draw (menu_t *menu, surface_t *d) {
         "  %.0f kbps\n"
         "\n"
         " Samplerate:\n"
-        "  %d Hz",
+        "  %d Hz\n"
+        "\n"
+        " Decoder load / buffer underruns:\n"
+        "  %d%% / %lu",
         formatted_track_elapsed_length,
         mp3player_get_bitrate() / 1000,
-        mp3player_get_samplerate()
+        mp3player_get_samplerate(),
+        mp3player_get_decode_load(),
+        mp3player_get_underruns()
     );
 
     ui_components_actions_bar_text_draw(
@@ -118,12 +170,21 @@ static void draw (menu_t *menu, surface_t *d) {
         "◀ Rewind | Fast forward ▶\n"
     );
 
-    rdpq_detach_show();
+    ui_components_actions_bar_text_draw(
+        STL_DEFAULT,
+        ALIGN_RIGHT, VALIGN_TOP,
+        "R: Playlist %s\n"
+        "\n",
+        playlist ? "on" : "off"
+    );
+
+    ui_components_detach_show();
 }
 
 static void deinit (void) {
     sound_init_default();
     mp3player_deinit();
+    bgm_set_paused(false);
 }
 
 
@@ -137,6 +198,8 @@ void view_music_player_init (menu_t *menu) {
         return;
     }
 
+    mp3player_set_frame_scan(menu->settings.mp3_frame_scan_enabled);
+
     path_t *path = path_clone_push(menu->browser.directory, menu->browser.entry->name);
 
     err = mp3player_load(path_get(path));
@@ -144,12 +207,15 @@ void view_music_player_init (menu_t *menu) {
         menu_show_error(menu, convert_error_message(err));
         mp3player_deinit();
     } else {
+        bgm_set_paused(true);
         sound_init_mp3_playback();
         mp3player_mute(false);
         err = mp3player_play();
         if (err != MP3PLAYER_OK) {
             menu_show_error(menu, convert_error_message(err));
             mp3player_deinit();
+        } else if (playlist) {
+            queue_next_track(menu);
         }
     }
 
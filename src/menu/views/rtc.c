@@ -215,7 +215,7 @@ static void draw (menu_t *menu, surface_t *d) {
         rtc_ui_component_editdatetime_draw(rtc_tm, editing_field_type);
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
@@ -0,0 +1,205 @@
+/**
+ * @file search.c
+ * @brief Card-wide ROM search view implementation
+ * @ingroup views
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../fonts.h"
+#include "../search_index.h"
+#include "../sound.h"
+#include "utils/fs.h"
+#include "utils/utils.h"
+#include "views.h"
+
+#define SEARCH_VISIBLE_RESULTS  (14)
+#define SEARCH_BUDGET_US        (8000)
+
+static const char characters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 -_.'&!";
+#define CHARACTERS_COUNT        (sizeof(characters) - 1)
+
+static char query[SEARCH_INDEX_QUERY_LENGTH + 1];
+static int query_length = 0;
+static int selected = 0;
+
+
+static void query_character_change (int direction) {
+    if (query_length == 0) {
+        return;
+    }
+
+    const char *current = strchr(characters, query[query_length - 1]);
+    int index = (current != NULL) ? (current - characters) : 0;
+    index = (index + direction + CHARACTERS_COUNT) % CHARACTERS_COUNT;
+    query[query_length - 1] = characters[index];
+
+    search_index_query(query);
+    selected = 0;
+}
+
+static void open_selected (menu_t *menu) {
+    path_t *path = search_index_query_get_path(selected);
+
+    if (path == NULL) {
+        return;
+    }
+
+    if (!file_exists(path_get(path))) {
+        search_index_remove(path);
+        path_free(path);
+        menu_show_error(menu, "File no longer exists on the SD card");
+        return;
+    }
+
+    path_free(menu->browser.select_file);
+    menu->browser.select_file = path;
+    menu->next_mode = MENU_MODE_BROWSER;
+}
+
+static void process (menu_t *menu) {
+    int results = search_index_query_get_results();
+
+    if (menu->actions.go_fast && (menu->actions.go_up || menu->actions.go_down)) {
+        if (menu->actions.go_up && (selected > 0)) {
+            selected -= 1;
+            sound_play_effect(SFX_CURSOR);
+        } else if (menu->actions.go_down && (selected < (results - 1))) {
+            selected += 1;
+            sound_play_effect(SFX_CURSOR);
+        }
+    } else if (menu->actions.go_up) {
+        query_character_change(1);
+        sound_play_effect(SFX_CURSOR);
+    } else if (menu->actions.go_down) {
+        query_character_change(-1);
+        sound_play_effect(SFX_CURSOR);
+    } else if (menu->actions.go_right) {
+        if (query_length < SEARCH_INDEX_QUERY_LENGTH) {
+            query[query_length++] = characters[0];
+            query[query_length] = '\0';
+            search_index_query(query);
+            selected = 0;
+            sound_play_effect(SFX_CURSOR);
+        }
+    } else if (menu->actions.go_left) {
+        if (query_length > 0) {
+            query[--query_length] = '\0';
+            search_index_query(query);
+            selected = 0;
+            sound_play_effect(SFX_CURSOR);
+        }
+    } else if (menu->actions.enter && (results > 0)) {
+        sound_play_effect(SFX_ENTER);
+        open_selected(menu);
+    } else if (menu->actions.options) {
+        sound_play_effect(SFX_SETTING);
+        search_index_rebuild();
+        search_index_query(query);
+        selected = 0;
+    } else if (menu->actions.back) {
+        sound_play_effect(SFX_EXIT);
+        menu->next_mode = MENU_MODE_BROWSER;
+    }
+}
+
+static void draw (menu_t *menu, surface_t *d) {
+    char buffer[2048];
+    size_t length = 0;
+
+    int results = search_index_query_get_results();
+
+    if (selected >= results) {
+        selected = (results > 0) ? (results - 1) : 0;
+    }
+
+    int start = 0;
+    if ((results > SEARCH_VISIBLE_RESULTS) && (selected >= (SEARCH_VISIBLE_RESULTS / 2))) {
+        start = MIN(selected - (SEARCH_VISIBLE_RESULTS / 2), results - SEARCH_VISIBLE_RESULTS);
+    }
+
+    buffer[0] = '\0';
+
+    for (int i = start; (i < results) && (i < (start + SEARCH_VISIBLE_RESULTS)) && (length < sizeof(buffer)); i++) {
+        search_index_result_t result;
+        if (search_index_query_get_result(i, &result)) {
+            break;
+        }
+        length += snprintf(
+            &buffer[length], sizeof(buffer) - length,
+            "^%02X%s %s ^%02X%s^00\n",
+            (i == selected) ? STL_YELLOW : STL_DEFAULT,
+            (i == selected) ? ">" : " ",
+            result.name,
+            STL_GRAY,
+            result.title
+        );
+    }
+
+    rdpq_attach(d, NULL);
+
+    ui_components_background_draw();
+
+    ui_components_layout_draw();
+
+    ui_components_main_text_draw(
+        STL_DEFAULT,
+        ALIGN_LEFT, VALIGN_TOP,
+        "Search: %s^%02X_^00\n"
+        "^%02X%d %s%s | %d files indexed%s^00\n"
+        "\n"
+        "%s",
+        query,
+        STL_YELLOW,
+        STL_GRAY,
+        results,
+        (results == 1) ? "result" : "results",
+        search_index_query_is_complete() ? "" : "...",
+        (int) (search_index_get_entries()),
+        search_index_is_complete() ? "" : ", indexing the SD card",
+        buffer
+    );
+
+    ui_components_actions_bar_text_draw(
+        STL_DEFAULT,
+        ALIGN_LEFT, VALIGN_TOP,
+        "^%02XA: Show in browser^00\n"
+        "B: Back",
+        (results > 0) ? STL_DEFAULT : STL_GRAY
+    );
+
+    ui_components_actions_bar_text_draw(
+        STL_DEFAULT,
+        ALIGN_RIGHT, VALIGN_TOP,
+        "R: Rebuild index\n"
+        "\n"
+    );
+
+    ui_components_actions_bar_text_draw(
+        STL_DEFAULT,
+        ALIGN_CENTER, VALIGN_TOP,
+        "▲▼ Letter | ◀▶ Delete/Add\n"
+        "C-▲▼ Select result"
+    );
+
+    ui_components_detach_show();
+}
+
+
+void view_search_init (menu_t *menu) {
+    search_index_query(query);
+}
+
+void view_search_display (menu_t *menu, surface_t *display) {
+    process(menu);
+
+    search_index_query_continue(SEARCH_BUDGET_US);
+
+    draw(menu, display);
+
+    if (!search_index_is_complete()) {
+        search_index_step(SEARCH_BUDGET_US);
+    }
+}
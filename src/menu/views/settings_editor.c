@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include "../bgm.h"
 #include "../sound.h"
 #include "../settings.h"
 #include "views.h"
@@ -38,6 +39,11 @@ static void set_show_saves_folder_type (menu_t *menu, void *arg) {
     menu->browser.reload = true;
 }
 
+static void set_scroll_acceleration_type (menu_t *menu, void *arg) {
+    menu->settings.scroll_acceleration_enabled = (bool)(uintptr_t)(arg);
+    settings_save(&menu->settings);
+}
+
 static void set_soundfx_enabled_type (menu_t *menu, void *arg) {
     menu->settings.soundfx_enabled = (bool)(uintptr_t)(arg);
     sound_use_sfx(menu->settings.soundfx_enabled);
@@ -52,6 +58,36 @@ static void set_use_rom_fast_reboot_enabled_type (menu_t *menu, void *arg) {
 #endif
 
 #ifdef BETA_SETTINGS
+static void set_rom_settings_store_enabled_type (menu_t *menu, void *arg) {
+    menu->settings.rom_settings_store_enabled = (bool)(uintptr_t)(arg);
+    settings_save(&menu->settings);
+}
+
+static void set_rom_verify_enabled_type (menu_t *menu, void *arg) {
+    menu->settings.rom_verify_enabled = (bool)(uintptr_t)(arg);
+    settings_save(&menu->settings);
+}
+
+static void set_save_backups_enabled_type (menu_t *menu, void *arg) {
+    menu->settings.save_backups_enabled = (bool)(uintptr_t)(arg);
+    settings_save(&menu->settings);
+}
+
+static void set_directory_index_enabled_type (menu_t *menu, void *arg) {
+    menu->settings.directory_index_enabled = (bool)(uintptr_t)(arg);
+    settings_save(&menu->settings);
+}
+
+static void set_mp3_frame_scan_enabled_type (menu_t *menu, void *arg) {
+    menu->settings.mp3_frame_scan_enabled = (bool)(uintptr_t)(arg);
+    settings_save(&menu->settings);
+}
+
+static void set_triple_buffering_enabled_type (menu_t *menu, void *arg) {
+    menu->settings.triple_buffering_enabled = (bool)(uintptr_t)(arg);
+    settings_save(&menu->settings);
+}
+
 static void set_pal60_type (menu_t *menu, void *arg) {
     menu->settings.pal60_enabled = (bool)(uintptr_t)(arg);
     settings_save(&menu->settings);
@@ -76,6 +112,9 @@ static void set_show_browser_rom_tags_type (menu_t *menu, void *arg) {
 static void set_bgm_enabled_type (menu_t *menu, void *arg) {
     menu->settings.bgm_enabled = (bool)(uintptr_t)(arg);
     settings_save(&menu->settings);
+    if (bgm_set_enabled(menu->settings.bgm_enabled)) {
+        menu_show_error(menu, "Background music file not found");
+    }
 }
 
 static void set_rumble_enabled_type (menu_t *menu, void *arg) {
@@ -151,6 +190,18 @@ static component_context_menu_t set_show_saves_folder_type_context_menu = {
     COMPONENT_CONTEXT_MENU_LIST_END,
 }};
 
+static int get_scroll_acceleration_current_selection (menu_t *menu) {
+    return menu->settings.scroll_acceleration_enabled ? 0 : 1;
+}
+
+static component_context_menu_t set_scroll_acceleration_type_context_menu = {
+    .get_default_selection = get_scroll_acceleration_current_selection,
+    .list = {
+        {.text = "On", .action = set_scroll_acceleration_type, .arg = (void *)(uintptr_t)(true) },
+        {.text = "Off", .action = set_scroll_acceleration_type, .arg = (void *)(uintptr_t)(false) },
+    COMPONENT_CONTEXT_MENU_LIST_END,
+}};
+
 #ifndef FEATURE_AUTOLOAD_ROM_ENABLED
 static int get_use_rom_fast_reboot_current_selection (menu_t *menu) {
     return menu->settings.rom_fast_reboot_enabled ? 0 : 1;
@@ -166,6 +217,78 @@ static component_context_menu_t set_use_rom_fast_reboot_context_menu = {
 #endif
 
 #ifdef BETA_SETTINGS
+static int get_rom_settings_store_enabled_current_selection (menu_t *menu) {
+    return menu->settings.rom_settings_store_enabled ? 0 : 1;
+}
+
+static component_context_menu_t set_rom_settings_store_enabled_type_context_menu = {
+    .get_default_selection = get_rom_settings_store_enabled_current_selection,
+    .list = {
+        {.text = "On", .action = set_rom_settings_store_enabled_type, .arg = (void *)(uintptr_t)(true) },
+        {.text = "Off", .action = set_rom_settings_store_enabled_type, .arg = (void *)(uintptr_t)(false) },
+    COMPONENT_CONTEXT_MENU_LIST_END,
+}};
+
+static int get_rom_verify_enabled_current_selection (menu_t *menu) {
+    return menu->settings.rom_verify_enabled ? 0 : 1;
+}
+
+static component_context_menu_t set_rom_verify_enabled_type_context_menu = {
+    .get_default_selection = get_rom_verify_enabled_current_selection,
+    .list = {
+        {.text = "On", .action = set_rom_verify_enabled_type, .arg = (void *)(uintptr_t)(true) },
+        {.text = "Off", .action = set_rom_verify_enabled_type, .arg = (void *)(uintptr_t)(false) },
+    COMPONENT_CONTEXT_MENU_LIST_END,
+}};
+
+static int get_save_backups_enabled_current_selection (menu_t *menu) {
+    return menu->settings.save_backups_enabled ? 0 : 1;
+}
+
+static component_context_menu_t set_save_backups_enabled_type_context_menu = {
+    .get_default_selection = get_save_backups_enabled_current_selection,
+    .list = {
+        {.text = "On", .action = set_save_backups_enabled_type, .arg = (void *)(uintptr_t)(true) },
+        {.text = "Off", .action = set_save_backups_enabled_type, .arg = (void *)(uintptr_t)(false) },
+    COMPONENT_CONTEXT_MENU_LIST_END,
+}};
+
+static int get_directory_index_enabled_current_selection (menu_t *menu) {
+    return menu->settings.directory_index_enabled ? 0 : 1;
+}
+
+static component_context_menu_t set_directory_index_enabled_type_context_menu = {
+    .get_default_selection = get_directory_index_enabled_current_selection,
+    .list = {
+        {.text = "On", .action = set_directory_index_enabled_type, .arg = (void *)(uintptr_t)(true) },
+        {.text = "Off", .action = set_directory_index_enabled_type, .arg = (void *)(uintptr_t)(false) },
+    COMPONENT_CONTEXT_MENU_LIST_END,
+}};
+
+static int get_mp3_frame_scan_enabled_current_selection (menu_t *menu) {
+    return menu->settings.mp3_frame_scan_enabled ? 0 : 1;
+}
+
+static component_context_menu_t set_mp3_frame_scan_enabled_type_context_menu = {
+    .get_default_selection = get_mp3_frame_scan_enabled_current_selection,
+    .list = {
+        {.text = "On", .action = set_mp3_frame_scan_enabled_type, .arg = (void *)(uintptr_t)(true) },
+        {.text = "Off", .action = set_mp3_frame_scan_enabled_type, .arg = (void *)(uintptr_t)(false) },
+    COMPONENT_CONTEXT_MENU_LIST_END,
+}};
+
+static int get_triple_buffering_enabled_current_selection (menu_t *menu) {
+    return menu->settings.triple_buffering_enabled ? 0 : 1;
+}
+
+static component_context_menu_t set_triple_buffering_enabled_type_context_menu = {
+    .get_default_selection = get_triple_buffering_enabled_current_selection,
+    .list = {
+        {.text = "On", .action = set_triple_buffering_enabled_type, .arg = (void *)(uintptr_t)(true) },
+        {.text = "Off", .action = set_triple_buffering_enabled_type, .arg = (void *)(uintptr_t)(false) },
+    COMPONENT_CONTEXT_MENU_LIST_END,
+}};
+
 static int get_pal60_current_selection (menu_t *menu) {
     return menu->settings.pal60_enabled ? 0 : 1;
 }
@@ -244,6 +367,7 @@ static component_context_menu_t options_context_menu = { .list = {
     { .text = "Sound Effects", .submenu = &set_soundfx_enabled_type_context_menu },
     { .text = "Use Saves Folder", .submenu = &set_use_saves_folder_type_context_menu },
     { .text = "Show Saves Folder", .submenu = &set_show_saves_folder_type_context_menu },
+    { .text = "Scroll Acceleration", .submenu = &set_scroll_acceleration_type_context_menu },
 #ifdef FEATURE_AUTOLOAD_ROM_ENABLED
     { .text = "ROM Loading Bar", .submenu = &set_loading_progress_bar_enabled_context_menu },
 #else
@@ -256,6 +380,12 @@ static component_context_menu_t options_context_menu = { .list = {
     { .text = "Hide ROM Tags", .submenu = &set_show_browser_rom_tags_context_menu },
     { .text = "Background Music", .submenu = &set_bgm_enabled_type_context_menu },
     { .text = "Rumble Feedback", .submenu = &set_rumble_enabled_type_context_menu },
+    { .text = "ROM Settings Store", .submenu = &set_rom_settings_store_enabled_type_context_menu },
+    { .text = "Verify ROM Data", .submenu = &set_rom_verify_enabled_type_context_menu },
+    { .text = "Save Backups", .submenu = &set_save_backups_enabled_type_context_menu },
+    { .text = "Directory Index", .submenu = &set_directory_index_enabled_type_context_menu },
+    { .text = "MP3 Frame Scan", .submenu = &set_mp3_frame_scan_enabled_type_context_menu },
+    { .text = "Triple Buffering", .submenu = &set_triple_buffering_enabled_type_context_menu },
     // { .text = "Restore Defaults", .action = set_use_default_settings },
 #endif
 
@@ -313,6 +443,7 @@ static void draw (menu_t *menu, surface_t *d) {
         "     Sound Effects     : %s\n"
         "     Use Saves folder  : %s\n"
         "     Show Saves folder : %s\n"
+        "     Scroll Accel.     : %s\n"
 #ifdef FEATURE_AUTOLOAD_ROM_ENABLED
         "  Autoload ROM      : %s\n\n"
         "    ROM Loading Bar   : %s\n"
@@ -326,7 +457,13 @@ static void draw (menu_t *menu, surface_t *d) {
         "     Hide ROM Tags     : %s\n"
         "     Background Music  : %s\n"
         "     Rumble Feedback   : %s\n"
-        "\n\n"
+        "*    ROM Settings Store: %s\n"
+        "*    Verify ROM Data   : %s\n"
+        "     Save Backups      : %s\n"
+        "*    Directory Index   : %s\n"
+        "     MP3 Frame Scan    : %s\n"
+        "*    Triple Buffering  : %s\n"
+        "\n"
         "Note: Certain settings have the following caveats:\n"
         "*    Requires rebooting the N64 Console.\n"
 #endif
@@ -336,6 +473,7 @@ static void draw (menu_t *menu, surface_t *d) {
         format_switch(menu->settings.soundfx_enabled),
         format_switch(menu->settings.use_saves_folder),
         format_switch(menu->settings.show_saves_folder),
+        format_switch(menu->settings.scroll_acceleration_enabled),
 #ifdef FEATURE_AUTOLOAD_ROM_ENABLED
         format_switch(menu->settings.rom_autoload_enabled),
         format_switch(menu->settings.loading_progress_bar_enabled)
@@ -349,7 +487,13 @@ static void draw (menu_t *menu, surface_t *d) {
         format_switch(menu->settings.show_browser_file_extensions),
         format_switch(menu->settings.show_browser_rom_tags),
         format_switch(menu->settings.bgm_enabled),
-        format_switch(menu->settings.rumble_enabled)
+        format_switch(menu->settings.rumble_enabled),
+        format_switch(menu->settings.rom_settings_store_enabled),
+        format_switch(menu->settings.rom_verify_enabled),
+        format_switch(menu->settings.save_backups_enabled),
+        format_switch(menu->settings.directory_index_enabled),
+        format_switch(menu->settings.mp3_frame_scan_enabled),
+        format_switch(menu->settings.triple_buffering_enabled)
 #endif
     );
 
@@ -376,7 +520,7 @@ static void draw (menu_t *menu, surface_t *d) {
         );
     }
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
@@ -4,11 +4,30 @@
 
 static void draw (menu_t *menu, surface_t *d) {
     rdpq_attach_clear(d, NULL);
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
 void view_startup_init (menu_t *menu) {
+    if (flashcart_reboot_rom_pending()) {
+        joypad_poll();
+        // NOTE: Holding START on any controller returns to the menu instead
+        bool skip = false;
+        JOYPAD_PORT_FOREACH (port) {
+            skip |= joypad_get_buttons_held(port).start;
+        }
+        if (skip) {
+            flashcart_set_next_boot_mode(FLASHCART_REBOOT_MODE_MENU);
+        } else {
+            menu->next_mode = MENU_MODE_BOOT;
+            menu->boot_params->device_type = BOOT_DEVICE_TYPE_ROM;
+            menu->boot_params->tv_type = BOOT_TV_TYPE_PASSTHROUGH;
+            menu->boot_params->detect_cic_seed = true;
+            menu->boot_params->cheat_list = NULL;
+            return;
+        }
+    }
+
 #ifdef FEATURE_AUTOLOAD_ROM_ENABLED
     // FIXME: rather than use a controller button, would it be better to use the cart button?
     JOYPAD_PORT_FOREACH (port) {
@@ -1,6 +1,9 @@
 #include <time.h>
 
+#include "../memory_budget.h"
 #include "../sound.h"
+#include "utils/trace.h"
+#include "utils/utils.h"
 #include "views.h"
 
 
@@ -21,6 +24,55 @@ static const char *format_accessory (int joypad) {
 }
 
 
+static uint32_t startup_total_us (trace_record_t *record) {
+    uint32_t total_us = 0;
+
+    for (int p = 0; p < record->phase_count; p++) {
+        trace_phase_t *phase = &record->phases[p];
+        total_us = MAX(total_us, phase->start_us + phase->duration_us);
+    }
+
+    return total_us;
+}
+
+static const char *format_startup_profile (void) {
+    static char buffer[TRACE_MAX_PHASES * 40];
+    int length = 0;
+    int column = 0;
+
+    trace_record_t *record = trace_get_startup_record(false);
+    trace_record_t *previous = trace_get_startup_record(true);
+
+    if (record == NULL) {
+        return "Startup: No data\n";
+    }
+
+    length += snprintf(buffer, sizeof(buffer), "Startup: %lu ms", startup_total_us(record) / 1000);
+    if (previous != NULL) {
+        length += snprintf(buffer + length, sizeof(buffer) - length, " (previous: %lu ms)", startup_total_us(previous) / 1000);
+    }
+
+    for (int p = 0; (p < record->phase_count) && (length < (int) (sizeof(buffer))); p++) {
+        trace_phase_t *phase = &record->phases[p];
+        if (phase->depth != 0) {
+            continue;
+        }
+        length += snprintf(buffer + length, sizeof(buffer) - length,
+            "%s%-18.18s %5lu ms",
+            (column == 0) ? "\n  " : "  |  ",
+            phase->name,
+            phase->duration_us / 1000
+        );
+        column = (column + 1) % 2;
+    }
+
+    if (length < (int) (sizeof(buffer))) {
+        snprintf(buffer + length, sizeof(buffer) - length, "\n");
+    }
+
+    return buffer;
+}
+
 static void process (menu_t *menu) {
     JOYPAD_PORT_FOREACH (port) {
         joypad[port] = (joypad_get_style(port) != JOYPAD_STYLE_NONE);
@@ -52,20 +104,24 @@ static void draw (menu_t *menu, surface_t *d) {
         "\n"
         "\n"
         "Expansion PAK is %sinserted\n"
+        "Menu caches: %d KiB\n"
         "\n"
         "Joypad 1 is %sconnected %s\n"
         "Joypad 2 is %sconnected %s\n"
         "Joypad 3 is %sconnected %s\n"
         "Joypad 4 is %sconnected %s\n"
         "\n"
+        "Physical Disk Drive attached: %s\n"
         "\n"
-        "Physical Disk Drive attached: %s\n",
+        "%s",
         is_memory_expanded() ? "" : "not ",
+        (int) (memory_budget_get_usage() / 1024),
         (joypad[0]) ? "" : "not ", format_accessory(0),
         (joypad[1]) ? "" : "not ", format_accessory(1),
         (joypad[2]) ? "" : "not ", format_accessory(2),
         (joypad[3]) ? "" : "not ", format_accessory(3),
-        "Unknown" // Fixme: Implement disk drive detection
+        "Unknown", // Fixme: Implement disk drive detection
+        format_startup_profile()
     );
 
     ui_components_actions_bar_text_draw(
@@ -75,7 +131,7 @@ static void draw (menu_t *menu, surface_t *d) {
         "B: Exit"
     );
 
-    rdpq_detach_show();
+    ui_components_detach_show();
 }
 
 
@@ -5,32 +5,184 @@
  */
 
 #include <stdio.h>
-#include <sys/stat.h>
+#include <stdlib.h>
+
+#include <fatfs/ff.h>
 
 #include "../ui_components/constants.h"
 #include "../fonts.h"
 #include "../sound.h"
+#include "utils/fs.h"
 #include "utils/utils.h"
 #include "views.h"
 
-#define MAX_FILE_SIZE KiB(128)
+#define WINDOW_SIZE             KiB(16)
+#define DRAW_LENGTH_MIN         KiB(4)
+#define INDEX_CHUNK_SIZE        KiB(8)
+#define INDEX_BUDGET_US         (2000)
+#define INDEX_ENTRIES_MAX       (2048)
+#define INDEX_STEP_INITIAL      (64)
+#define JUMP_LINES_MIN          (LIST_ENTRIES)
 
 /** @brief Text file structure */
 typedef struct {
-    FILE *f; /**< File pointer */
-    char *contents; /**< File contents */
+    FIL fil; /**< File handle */
     size_t length; /**< File length */
-    int lines; /**< Number of lines */
+    int lines; /**< Number of lines, a lower bound until the index is complete */
     int current_line; /**< Current line */
-    int offset; /**< Offset in the file */
+    size_t offset; /**< File offset of the current line */
     bool vertical_scroll_possible; /**< Flag indicating if vertical scroll is possible */
+
+    char window[WINDOW_SIZE]; /**< Part of the file kept in memory */
+    size_t window_offset; /**< File offset of the window */
+    size_t window_length; /**< Number of valid bytes in the window */
+
+    uint32_t index[INDEX_ENTRIES_MAX]; /**< File offsets of every index_step-th line */
+    int index_entries; /**< Number of valid index entries */
+    int index_step; /**< Number of lines between index entries */
+    size_t index_position; /**< File offset the indexing continues from */
+    int index_lines; /**< Number of line breaks found so far */
+    bool index_complete; /**< The whole file has been indexed */
+    uint8_t index_chunk[INDEX_CHUNK_SIZE]; /**< Indexing read buffer */
+
+    bool error; /**< A read failed */
 } text_file_t;
 
 static text_file_t *text;
 
+/**
+ * @brief Read a part of the file.
+ *
+ * @param offset File offset.
+ * @param buffer Destination buffer.
+ * @param length Number of bytes to read.
+ * @param read Pointer to store the number of bytes read.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool text_read (size_t offset, void *buffer, size_t length, size_t *read) {
+    UINT br;
+
+    if ((f_lseek(&text->fil, offset) != FR_OK) || (f_read(&text->fil, buffer, length, &br) != FR_OK)) {
+        text->error = true;
+        return true;
+    }
+
+    *read = br;
+
+    return false;
+}
+
+/**
+ * @brief Load the window starting at the specified file offset.
+ *
+ * @param offset File offset.
+ */
+static void window_load (size_t offset) {
+    if (text_read(offset, text->window, WINDOW_SIZE, &text->window_length)) {
+        text->window_length = 0;
+    }
+    text->window_offset = offset;
+}
+
+/**
+ * @brief Get a character of the file, the window is moved around it when it's not loaded.
+ *
+ * @param position File offset.
+ * @return char Character at the offset.
+ */
+static char char_at (size_t position) {
+    if ((position < text->window_offset) || (position >= (text->window_offset + text->window_length))) {
+        window_load((position > (WINDOW_SIZE / 2)) ? (position - (WINDOW_SIZE / 2)) : 0);
+        if ((position < text->window_offset) || (position >= (text->window_offset + text->window_length))) {
+            return '\0';
+        }
+    }
+
+    return text->window[position - text->window_offset];
+}
+
+/**
+ * @brief Make sure the text drawn from the current line is in the window.
+ *
+ * @return size_t Number of bytes available from the current line.
+ */
+static size_t window_prepare_draw (void) {
+    size_t window_end = text->window_offset + text->window_length;
+    size_t needed_end = MIN(text->offset + DRAW_LENGTH_MIN, text->length);
+
+    if ((text->offset < text->window_offset) || (needed_end > window_end)) {
+        // NOTE: Some text before the current line is kept, so scrolling back doesn't reload the window right away
+        window_load((text->offset > (WINDOW_SIZE / 4)) ? (text->offset - (WINDOW_SIZE / 4)) : 0);
+    }
+
+    if ((text->offset < text->window_offset) || (text->offset > (text->window_offset + text->window_length))) {
+        return 0;
+    }
+
+    return (text->window_offset + text->window_length) - text->offset;
+}
+
+/**
+ * @brief Record the file offset of a line in the sparse index.
+ *
+ * The step between the entries is doubled when the index is full, keeping the memory use constant.
+ *
+ * @param line Line number.
+ * @param offset File offset of the line.
+ */
+static void index_add (int line, size_t offset) {
+    if ((line % text->index_step) != 0) {
+        return;
+    }
+
+    if (text->index_entries == INDEX_ENTRIES_MAX) {
+        for (int i = 0; i < (INDEX_ENTRIES_MAX / 2); i++) {
+            text->index[i] = text->index[(i * 2) + 1];
+        }
+        text->index_entries = INDEX_ENTRIES_MAX / 2;
+        text->index_step *= 2;
+        if ((line % text->index_step) != 0) {
+            return;
+        }
+    }
+
+    text->index[text->index_entries++] = offset;
+}
+
+/**
+ * @brief Continue building the line index.
+ *
+ * @param budget_us Time budget in microseconds.
+ */
+static void index_continue (uint64_t budget_us) {
+    uint64_t start = get_ticks_us();
+
+    while (!text->index_complete && ((get_ticks_us() - start) < budget_us)) {
+        size_t length;
+
+        if (text_read(text->index_position, text->index_chunk, INDEX_CHUNK_SIZE, &length) || (length == 0)) {
+            text->index_complete = true;
+            break;
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            if (text->index_chunk[i] == '\n') {
+                text->index_lines += 1;
+                index_add(text->index_lines, text->index_position + i + 1);
+            }
+        }
+
+        text->index_position += length;
+        text->index_complete = (text->index_position >= text->length);
+    }
+
+    text->lines = text->index_lines + 1;
+    text->vertical_scroll_possible = !text->index_complete || (text->lines > LIST_ENTRIES);
+}
+
 /**
  * @brief Perform vertical scroll in the text file.
- * 
+ *
  * @param lines Number of lines to scroll.
  */
 static void perform_vertical_scroll (int lines) {
@@ -39,20 +191,20 @@ static void perform_vertical_scroll (int lines) {
     }
 
     int direction = (lines < 0) ? -1 : 1;
-    int next_offset = text->offset;
+    size_t next_offset = text->offset;
 
     for (int i = 0; i < abs(lines); i++) {
         while (true) {
-            next_offset += direction;
-            if (next_offset <= 0) {
+            if ((direction < 0) && (next_offset <= 1)) {
                 text->current_line = 0;
                 text->offset = 0;
                 return;
             }
+            next_offset = (direction < 0) ? (next_offset - 1) : (next_offset + 1);
             if (next_offset > text->length) {
                 return;
             }
-            if (text->contents[next_offset - 1] == '\n') {
+            if (char_at(next_offset - 1) == '\n') {
                 break;
             }
         }
@@ -61,9 +213,31 @@ static void perform_vertical_scroll (int lines) {
     }
 }
 
+/**
+ * @brief Jump to a line using the line index.
+ *
+ * @param line Target line number.
+ */
+static void jump_to_line (int line) {
+    line = MAX(0, MIN(line, text->lines - 1));
+
+    int entry = MIN(line / text->index_step, text->index_entries);
+
+    // NOTE: Index entry k holds the line (k + 1) * index_step, the lines before the first entry are scanned from the file start
+    if (entry == 0) {
+        text->current_line = 0;
+        text->offset = 0;
+    } else {
+        text->current_line = entry * text->index_step;
+        text->offset = text->index[entry - 1];
+    }
+
+    perform_vertical_scroll(line - text->current_line);
+}
+
 /**
  * @brief Process user actions for the text viewer.
- * 
+ *
  * @param menu Pointer to the menu structure.
  */
 static void process (menu_t *menu) {
@@ -71,21 +245,29 @@ static void process (menu_t *menu) {
         sound_play_effect(SFX_EXIT);
         menu->next_mode = MENU_MODE_BROWSER;
     } else if (text) {
+        int jump_lines = MAX(text->lines / 10, JUMP_LINES_MIN);
+
         if (menu->actions.go_up) {
             perform_vertical_scroll(menu->actions.go_fast ? -10 : -1);
         } else if (menu->actions.go_down) {
             perform_vertical_scroll(menu->actions.go_fast ? 10 : 1);
+        } else if (menu->actions.go_left && text->vertical_scroll_possible) {
+            jump_to_line(text->current_line - jump_lines);
+        } else if (menu->actions.go_right && text->vertical_scroll_possible) {
+            jump_to_line(text->current_line + jump_lines);
         }
     }
 }
 
 /**
  * @brief Draw the text viewer.
- * 
+ *
  * @param menu Pointer to the menu structure.
  * @param d Pointer to the display surface.
  */
 static void draw (menu_t *menu, surface_t *d) {
+    size_t available = window_prepare_draw();
+
     rdpq_attach(d, NULL);
 
     ui_components_background_draw();
@@ -95,8 +277,9 @@ static void draw (menu_t *menu, surface_t *d) {
     ui_components_main_text_draw(
         STL_DEFAULT,
         ALIGN_LEFT, VALIGN_TOP,
-        "%s\n",
-        text->contents + text->offset
+        "%.*s\n",
+        (int) (available),
+        &text->window[text->offset - text->window_offset]
     );
 
     ui_components_list_scrollbar_draw(text->current_line, text->lines, LIST_ENTRIES);
@@ -104,12 +287,22 @@ static void draw (menu_t *menu, surface_t *d) {
     ui_components_actions_bar_text_draw(
         STL_DEFAULT,
         ALIGN_LEFT, VALIGN_TOP,
-        "^%02XUp / Down: Scroll^00\n"
+        "^%02XUp / Down: Scroll | Left / Right: Jump^00\n"
         "B: Back",
         text->vertical_scroll_possible ? STL_DEFAULT : STL_GRAY
     );
 
-    rdpq_detach_show();
+    if (!text->index_complete) {
+        ui_components_actions_bar_text_draw(
+            STL_GRAY,
+            ALIGN_RIGHT, VALIGN_TOP,
+            "Indexing %d%%\n"
+            "\n",
+            (int) ((text->index_position * 100) / text->length)
+        );
+    }
+
+    ui_components_detach_show();
 }
 
 /**
@@ -117,12 +310,7 @@ static void draw (menu_t *menu, surface_t *d) {
  */
 static void deinit (void) {
     if (text) {
-        if (text->f) {
-            fclose(text->f);
-        }
-        if (text->contents) {
-            free(text->contents);
-        }
+        f_close(&text->fil);
         free(text);
         text = NULL;
     }
@@ -130,7 +318,9 @@ static void deinit (void) {
 
 /**
  * @brief Initialize the text viewer.
- * 
+ *
+ * Only the first window of the file is read here, the line index is built while the text is displayed.
+ *
  * @param menu Pointer to the menu structure.
  */
 void view_text_viewer_init (menu_t *menu) {
@@ -139,69 +329,54 @@ void view_text_viewer_init (menu_t *menu) {
     }
 
     path_t *path = path_clone_push(menu->browser.directory, menu->browser.entry->name);
-    text->f = fopen(path_get(path), "r");
+    FRESULT res = f_open(&text->fil, strip_fs_prefix(path_get(path)), FA_READ);
     path_free(path);
 
-    if (text->f == NULL) {
-        deinit();
+    if (res != FR_OK) {
+        free(text);
+        text = NULL;
         return menu_show_error(menu, "Couldn't open text file");
     }
 
-    struct stat st;
-    if (fstat(fileno(text->f), &st)) {
-        deinit();
-        return menu_show_error(menu, "Couldn't get text file size");
-    }
-    text->length = st.st_size;
+    text->length = f_size(&text->fil);
 
-    if (text->length <= 0) {
+    if (text->length == 0) {
         deinit();
         return menu_show_error(menu, "Text file is empty");
     }
 
-    if (text->length > MAX_FILE_SIZE) {
-        deinit();
-        return menu_show_error(menu, "Text file is too big to be displayed");
-    }
+    text->index_step = INDEX_STEP_INITIAL;
+    text->lines = 1;
 
-    if ((text->contents = malloc((text->length + 1) * sizeof(char))) == NULL) {
-        deinit();
-        return menu_show_error(menu, "Couldn't allocate memory for the text file contents");
-    }
+    window_load(0);
 
-    if (fread(text->contents, text->length, 1, text->f) != 1) {
+    if (text->error) {
         deinit();
         return menu_show_error(menu, "Couldn't read text file contents");
     }
-    text->contents[text->length] = '\0';
 
-    if (fclose(text->f)) {
-        deinit();
-        return menu_show_error(menu, "Couldn't close text file");
-    }
-    text->f = NULL;
-
-    text->lines = 1;
-    for (size_t i = 0; i < text->length; i++) {
-        if (text->contents[i] == '\n') {
-            text->lines += 1;
-        }
-    }
-
-    text->vertical_scroll_possible = (text->lines > LIST_ENTRIES);
+    index_continue(INDEX_BUDGET_US);
 }
 
 /**
  * @brief Display the text viewer.
- * 
+ *
  * @param menu Pointer to the menu structure.
  * @param display Pointer to the display surface.
  */
 void view_text_viewer_display (menu_t *menu, surface_t *display) {
     process(menu);
 
+    if (text->error) {
+        menu_show_error(menu, "Couldn't read text file contents");
+    }
+
     draw(menu, display);
 
+    if (!text->index_complete) {
+        index_continue(INDEX_BUDGET_US);
+    }
+
     if (menu->next_mode != MENU_MODE_TEXT_VIEWER) {
         deinit();
     }
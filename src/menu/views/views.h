@@ -48,6 +48,14 @@ void view_browser_init(menu_t *menu);
  */
 void view_browser_display(menu_t *menu, surface_t *display);
 
+/**
+ * @brief Run the browser background work while there's no input, without drawing.
+ *
+ * @param menu Pointer to the menu structure.
+ * @return true if the browser must be redrawn, false otherwise.
+ */
+bool view_browser_idle(menu_t *menu);
+
 /**
  * @brief Initialize the file info view.
  *
@@ -354,6 +362,36 @@ void view_extract_file_init(menu_t *menu);
  */
 void view_extract_file_display(menu_t *menu, surface_t *display);
 
+/**
+ * @brief Initialize the search view.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+void view_search_init(menu_t *menu);
+
+/**
+ * @brief Display the search view.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param display Pointer to the display surface.
+ */
+void view_search_display(menu_t *menu, surface_t *display);
+
+/**
+ * @brief Initialize the benchmark view, the suite starts running with the next frame.
+ *
+ * @param menu Pointer to the menu structure.
+ */
+void view_benchmark_init(menu_t *menu);
+
+/**
+ * @brief Display the benchmark view.
+ *
+ * @param menu Pointer to the menu structure.
+ * @param display Pointer to the display surface.
+ */
+void view_benchmark_display(menu_t *menu, surface_t *display);
+
 /**
  * @brief Show an error message in the menu.
  *
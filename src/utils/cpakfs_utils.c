@@ -6,6 +6,7 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <libdragon.h>
 #include <fatfs/ff.h>
 #include <errno.h>
@@ -320,45 +321,78 @@ static int join_mount_name(const char *mount, const char *name, char *out, size_
     return 0;
 }
 
+/**
+ * @brief List the note names on a mounted Controller Pak.
+ *
+ * @param mount_prefix The mount prefix (e.g., "cpak1:/").
+ * @param names Output array for the note names.
+ * @param max_names Size of the output array.
+ * @return The number of notes listed.
+ */
+int list_cpakfs_note_names(const char *mount_prefix, char names[][MAX_NOTE_NAME_LENGTH], int max_names) {
+    dir_t entry;
+    int count = 0;
+
+    if ((max_names <= 0) || (dir_findfirst(mount_prefix, &entry) < 0)) {
+        return 0;
+    }
+
+    do {
+        snprintf(names[count++], MAX_NOTE_NAME_LENGTH, "%s", entry.d_name);
+    } while ((count < max_names) && (dir_findnext(mount_prefix, &entry) == 0));
+
+    return count;
+}
+
 /**
  * @brief Pick a unique full filename with mount prefix, avoiding collisions.
  *
- * This function attempts to find a unique filename by incrementing the extension in base36 if needed.
+ * The extensions already used by notes with the same base name are gathered from the note list,
+ * the next free base36 extension is then picked without touching the pak.
  *
  * @param mount_prefix The mount prefix (e.g., "cpak1:/").
  * @param desired_name The desired base filename.
+ * @param names Names of the notes on the pak.
+ * @param count Number of notes on the pak.
  * @param out_fullpath Output buffer for the unique full path.
  * @param outsz Size of the output buffer.
- * @param exists_fullpath Function pointer to check if a full path exists.
  * @return 0 on success, negative value on error.
  */
 int pick_unique_fullname_with_mount(const char *mount_prefix,
                                     const char *desired_name,
-                                    char *out_fullpath, size_t outsz,
-                                    int (*exists_fullpath)(const char *fullpath))
+                                    const char names[][MAX_NOTE_NAME_LENGTH], int count,
+                                    char *out_fullpath, size_t outsz)
 {
     cpakfs_path_strings_t want;
     if (parse_fullname(desired_name, &want) != 0) return -1;
 
+    // Gather the extensions in use by notes sharing the base name
+    char used[MAX_NUM_NOTES][5];
+    int used_count = 0;
+    bool desired_used = false;
+    for (int i = 0; i < count; ++i) {
+        cpakfs_path_strings_t note;
+        if (parse_fullname(names[i], &note) != 0) continue;
+        if (strcmp(note.gamecode, want.gamecode) || strcmp(note.pubcode, want.pubcode) || strcmp(note.filename, want.filename)) continue;
+        if (!strcmp(note.ext, want.ext)) desired_used = true;
+        if (used_count < MAX_NUM_NOTES) {
+            memcpy(used[used_count++], note.ext, sizeof used[0]);
+        }
+    }
+
     /* If desired is free (with mount), use it */
-    char test_full[256];
-    if (join_mount_name(mount_prefix, desired_name, test_full, sizeof test_full) != 0) return -2;
-    if (!exists_fullpath(test_full)) {
-        // Copy full path (with prefix) out
-        size_t need = strlen(test_full) + 1;
-        if (need > outsz) return -3;
-        memcpy(out_fullpath, test_full, need);
+    if (!desired_used) {
+        if (join_mount_name(mount_prefix, desired_name, out_fullpath, outsz) != 0) return -3;
         return 0;
     }
 
     // Build base without extension
     cpakfs_path_strings_t base = want; base.ext[0] = '\0';
-    char base_name[128];
-    if (format_fullname(&base, base_name, sizeof base_name) != 0) return -4;
 
     // Starting counter
     unsigned start = is_base36_str(want.ext) ? (base36_to_uint(want.ext) + 1) : 0;
 
+    // NOTE: At most used_count candidates are taken, so this ends after a few iterations
     const unsigned MAX = 36 + 36*36 + 36*36*36 + 36*36*36*36;
     for (unsigned k = 0; k < MAX; ++k) {
         unsigned cand = start + k;
@@ -368,21 +402,20 @@ int pick_unique_fullname_with_mount(const char *mount_prefix,
         else if (cand < 36U*36U*36U)    uint_to_base36(cand, ext, 3);
         else                            uint_to_base36(cand, ext, 4);
 
+        bool taken = false;
+        for (int i = 0; i < used_count && !taken; ++i) {
+            taken = !strcmp(used[i], ext);
+        }
+        if (taken) continue;
+
         cpakfs_path_strings_t candp = base;
         strncpy(candp.ext, ext, sizeof candp.ext); candp.ext[sizeof candp.ext - 1] = '\0';
 
         char cand_name[128];
-        if (format_fullname(&candp, cand_name, sizeof cand_name) != 0) continue;
-
-        char cand_full[256];
-        if (join_mount_name(mount_prefix, cand_name, cand_full, sizeof cand_full) != 0) continue;
+        if (format_fullname(&candp, cand_name, sizeof cand_name) != 0) return -4;
 
-        if (!exists_fullpath(cand_full)) {
-            size_t need = strlen(cand_full) + 1;
-            if (need > outsz) return -5;
-            memcpy(out_fullpath, cand_full, need);
-            return 0;
-        }
+        if (join_mount_name(mount_prefix, cand_name, out_fullpath, outsz) != 0) return -5;
+        return 0;
     }
     return -6; // exhausted (unlikely)
 }
@@ -24,6 +24,12 @@
  */
 #define MAX_NUM_NOTES 16
 
+/**
+ * @def MAX_NOTE_NAME_LENGTH
+ * @brief Maximum length of a Controller Pak note full filename, including the null terminator.
+ */
+#define MAX_NOTE_NAME_LENGTH 32
+
 /**
  * @struct cpakfs_path_strings_t
  * @brief Structure holding parsed components of a Controller Pak file path.
@@ -123,21 +129,32 @@ int inc_index_note(int current_index);
  */
 int dec_index_note(int current_index);
 
+/**
+ * @brief List the note names on a mounted Controller Pak.
+ *
+ * @param mount_prefix The mount prefix (e.g., "cpak1:/").
+ * @param names Output array for the note names.
+ * @param max_names Size of the output array.
+ * @return The number of notes listed.
+ */
+int list_cpakfs_note_names(const char *mount_prefix, char names[][MAX_NOTE_NAME_LENGTH], int max_names);
+
 /**
  * @brief Pick a unique full filename with mount prefix, avoiding collisions.
  *
- * Attempts to find a unique filename by incrementing the extension in base36 if needed.
+ * Picks the next free base36 extension from the supplied note list, the pak itself isn't accessed.
  *
  * @param mount_prefix The mount prefix (e.g., "cpak1:/").
  * @param desired_name The desired base filename.
+ * @param names Names of the notes on the pak.
+ * @param count Number of notes on the pak.
  * @param out_fullpath Output buffer for the unique full path.
  * @param outsz Size of the output buffer.
- * @param exists_fullpath Function pointer to check if a full path exists.
  * @return 0 on success, negative value on error.
  */
 int pick_unique_fullname_with_mount(const char *mount_prefix,
                                     const char *desired_name,
-                                    char *out_fullpath, size_t outsz,
-                                    int (*exists_fullpath)(const char *fullpath));
+                                    const char names[][MAX_NOTE_NAME_LENGTH], int count,
+                                    char *out_fullpath, size_t outsz);
 
 #endif // CPAKFS_UTILS__H__
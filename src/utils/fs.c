@@ -10,9 +10,48 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include <fatfs/ff.h>
+#include <libdragon.h>
+
 #include "fs.h"
 #include "utils.h"
 
+#define FILL_BUFFER_SIZE    (FS_SECTOR_SIZE * 32)
+
+static uint8_t io_buffer[FS_IO_BUFFER_SIZE] __attribute__((aligned(16)));
+static fs_stats_t stats;
+
+/**
+ * @brief Read from a file, counting the transfer in the statistics.
+ */
+static FRESULT fs_read (FIL *fil, void *buffer, UINT length, UINT *br) {
+    uint64_t start = get_ticks_us();
+    FRESULT res = f_read(fil, buffer, length, br);
+    stats.busy_us += (get_ticks_us() - start);
+    stats.read_bytes += *br;
+    return res;
+}
+
+/**
+ * @brief Write to a file, counting the transfer in the statistics.
+ */
+static FRESULT fs_write (FIL *fil, const void *buffer, UINT length, UINT *bw) {
+    uint64_t start = get_ticks_us();
+    FRESULT res = f_write(fil, buffer, length, bw);
+    stats.busy_us += (get_ticks_us() - start);
+    stats.written_bytes += *bw;
+    return res;
+}
+
+/**
+ * @brief Get the bulk transfer statistics.
+ *
+ * @return Pointer to the statistics.
+ */
+fs_stats_t *fs_get_stats(void) {
+    return &stats;
+}
+
 /**
  * @brief Strip the file system prefix from a path.
  *
@@ -101,6 +140,29 @@ bool file_allocate(char *path, size_t size) {
     return false;
 }
 
+/**
+ * @brief Open a file for writing, replacing any existing file, and allocate it contiguously when possible.
+ *
+ * @param fil Pointer to the file object.
+ * @param path The path to the file.
+ * @param size The size of the file in bytes.
+ * @return true if an error occurred, false otherwise.
+ */
+static bool file_create_sized(FIL *fil, char *path, size_t size) {
+    if (f_open(fil, strip_fs_prefix(path), FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return true;
+    }
+
+#if FF_USE_EXPAND
+    // NOTE: Contiguous allocation is only an optimization, regular cluster allocation is used on failure
+    if (f_expand(fil, size, 1) != FR_OK) {
+        f_lseek(fil, 0);
+    }
+#endif
+
+    return false;
+}
+
 /**
  * @brief Fill a file with the specified value.
  *
@@ -111,37 +173,368 @@ bool file_allocate(char *path, size_t size) {
  * @return true if the file was successfully filled, false otherwise.
  */
 bool file_fill(char *path, uint8_t value) {
-    FILE *f;
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    if (f_open(&fil, strip_fs_prefix(path), FA_READ | FA_WRITE) != FR_OK) {
+        return true;
+    }
+
+    memset(io_buffer, value, sizeof(io_buffer));
+
+    size_t size = f_size(&fil);
+
+    for (size_t offset = 0; offset < size; offset += sizeof(io_buffer)) {
+        size_t bytes_to_write = MIN(size - offset, sizeof(io_buffer));
+        if ((fs_write(&fil, io_buffer, bytes_to_write, &bw) != FR_OK) || (bw != bytes_to_write)) {
+            error = true;
+            break;
+        }
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Create a file of the specified size filled with the specified value.
+ *
+ * @param path The path to the file.
+ * @param size The size of the file to create in bytes.
+ * @param value The value to fill the file with (byte).
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_allocate_filled(char *path, size_t size, uint8_t value) {
+    static uint8_t fill_buffer[FILL_BUFFER_SIZE] __attribute__((aligned(8)));
+    static int fill_value = -1;
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    if (fill_value != value) {
+        memset(fill_buffer, value, sizeof(fill_buffer));
+        fill_value = value;
+    }
+
+    if (file_create_sized(&fil, path, size)) {
+        return true;
+    }
+
+    for (size_t offset = 0; offset < size; offset += sizeof(fill_buffer)) {
+        size_t bytes_to_write = MIN(size - offset, sizeof(fill_buffer));
+        if ((fs_write(&fil, fill_buffer, bytes_to_write, &bw) != FR_OK) || (bw != bytes_to_write)) {
+            error = true;
+            break;
+        }
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Read a range of a file into a buffer.
+ *
+ * @param path The path to the file.
+ * @param offset Offset of the range in the file.
+ * @param buffer Pointer to the output buffer.
+ * @param length Length of the range.
+ * @return true if an error occurred or the file is shorter than the range, false otherwise.
+ */
+bool file_read_range(char *path, uint64_t offset, void *buffer, size_t length) {
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if (f_open(&fil, strip_fs_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    if ((f_lseek(&fil, offset) != FR_OK) || (fs_read(&fil, buffer, length, &br) != FR_OK) || (br != length)) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Read a whole file into a caller supplied buffer.
+ *
+ * @param path The path to the file.
+ * @param buffer Pointer to the output buffer.
+ * @param capacity Size of the output buffer.
+ * @param length Pointer to store the file length.
+ * @return true if an error occurred or the file doesn't fit in the buffer, false otherwise.
+ */
+bool file_read_all(char *path, void *buffer, size_t capacity, size_t *length) {
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if (f_open(&fil, strip_fs_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    size_t size = f_size(&fil);
+
+    if ((size > capacity) || (fs_read(&fil, buffer, size, &br) != FR_OK) || (br != size)) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    *length = size;
+
+    return error;
+}
+
+/**
+ * @brief Replace a file with the specified data.
+ *
+ * @param path The path to the file.
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_write_all(char *path, const void *data, size_t length) {
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    char *temp_path = malloc(strlen(path) + sizeof(".tmp"));
+    if (temp_path == NULL) {
+        return true;
+    }
+    sprintf(temp_path, "%s.tmp", path);
+
+    if (file_create_sized(&fil, temp_path, length)) {
+        free(temp_path);
+        return true;
+    }
+
+    if ((fs_write(&fil, data, length, &bw) != FR_OK) || (bw != length)) {
+        error = true;
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    // NOTE: FatFs can't rename over an existing file, a reset in between loses the file but never leaves a truncated one
+    if (!error) {
+        f_unlink(strip_fs_prefix(path));
+        error = (f_rename(strip_fs_prefix(temp_path), strip_fs_prefix(path)) != FR_OK);
+    }
+
+    if (error) {
+        f_unlink(strip_fs_prefix(temp_path));
+    }
+
+    free(temp_path);
+
+    return error;
+}
+
+/**
+ * @brief Append data to the end of a file, the file is created when it doesn't exist.
+ *
+ * @param path The path to the file.
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_append(char *path, const void *data, size_t length) {
+    FIL fil;
+    UINT bw;
     bool error = false;
-    uint8_t buffer[FS_SECTOR_SIZE * 8];
-    size_t bytes_to_write;
 
-    for (int i = 0; i < sizeof(buffer); i++) {
-        buffer[i] = value;
+    if (f_open(&fil, strip_fs_prefix(path), FA_WRITE | FA_OPEN_APPEND) != FR_OK) {
+        return true;
+    }
+
+    if ((fs_write(&fil, data, length, &bw) != FR_OK) || (bw != length)) {
+        error = true;
     }
 
-    if ((f = fopen(path, "rb+")) == NULL) {
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Read a file in chunks, passing each chunk to a callback.
+ *
+ * @param path The path to the file.
+ * @param chunk_size Size of the chunks, up to FS_IO_BUFFER_SIZE.
+ * @param sink Callback consuming the chunks.
+ * @param arg Callback argument.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_read_stream(char *path, size_t chunk_size, fs_chunk_callback_t *sink, void *arg, fs_progress_callback_t *progress) {
+    FIL fil;
+    UINT br;
+    bool error = false;
+
+    if ((chunk_size == 0) || (chunk_size > sizeof(io_buffer))) {
         return true;
     }
 
-    setbuf(f, NULL);
+    if (f_open(&fil, strip_fs_prefix(path), FA_READ) != FR_OK) {
+        return true;
+    }
 
-    fseek(f, 0, SEEK_END);
-    size_t size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    size_t size = f_size(&fil);
 
-    for (size_t i = 0; i < size; i += sizeof(buffer)) {
-        bytes_to_write = MIN(size - ftell(f), sizeof(buffer));
-        if (fwrite(buffer, 1, bytes_to_write, f) != bytes_to_write) {
+    for (size_t offset = 0; offset < size; offset += chunk_size) {
+        size_t length = MIN(size - offset, chunk_size);
+        if ((fs_read(&fil, io_buffer, length, &br) != FR_OK) || (br != length) || sink(io_buffer, offset, length, arg)) {
             error = true;
             break;
         }
+        if (progress) {
+            progress((offset + length) / (float) (size));
+        }
     }
 
-    if (fclose(f)) {
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Replace a file with data produced in chunks by a callback.
+ *
+ * @param path The path to the file.
+ * @param size The size of the file in bytes.
+ * @param chunk_size Size of the chunks, up to FS_IO_BUFFER_SIZE.
+ * @param source Callback producing the chunks.
+ * @param arg Callback argument.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_write_stream(char *path, size_t size, size_t chunk_size, fs_chunk_callback_t *source, void *arg, fs_progress_callback_t *progress) {
+    if (chunk_size > sizeof(io_buffer)) {
+        return true;
+    }
+
+    return file_write_stream_buffered(path, size, io_buffer, chunk_size, source, arg, progress);
+}
+
+/**
+ * @brief Replace a file with data produced in chunks by a callback, using a caller provided buffer.
+ *
+ * @param path The path to the file.
+ * @param size The size of the file in bytes.
+ * @param buffer Chunk buffer.
+ * @param chunk_size Size of the chunks and of the buffer.
+ * @param source Callback producing the chunks.
+ * @param arg Callback argument.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_write_stream_buffered(char *path, size_t size, void *buffer, size_t chunk_size, fs_chunk_callback_t *source, void *arg, fs_progress_callback_t *progress) {
+    FIL fil;
+    UINT bw;
+    bool error = false;
+
+    if ((buffer == NULL) || (chunk_size == 0)) {
+        return true;
+    }
+
+    if (file_create_sized(&fil, path, size)) {
+        return true;
+    }
+
+    for (size_t offset = 0; offset < size; offset += chunk_size) {
+        size_t length = MIN(size - offset, chunk_size);
+        if (source(buffer, offset, length, arg) || (fs_write(&fil, buffer, length, &bw) != FR_OK) || (bw != length)) {
+            error = true;
+            break;
+        }
+        if (progress) {
+            progress((offset + length) / (float) (size));
+        }
+    }
+
+    if (f_close(&fil) != FR_OK) {
+        error = true;
+    }
+
+    if (error) {
+        f_unlink(strip_fs_prefix(path));
+    }
+
+    return error;
+}
+
+/**
+ * @brief Copy a file.
+ *
+ * @param source_path The path to the source file.
+ * @param destination_path The path to the destination file, replaced if it exists.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_copy(char *source_path, char *destination_path, fs_progress_callback_t *progress) {
+    FIL source;
+    FIL destination;
+    UINT br, bw;
+    bool error = false;
+
+    if (f_open(&source, strip_fs_prefix(source_path), FA_READ) != FR_OK) {
+        return true;
+    }
+
+    size_t size = f_size(&source);
+
+    if (file_create_sized(&destination, destination_path, size)) {
+        f_close(&source);
+        return true;
+    }
+
+    for (size_t offset = 0; offset < size; offset += sizeof(io_buffer)) {
+        size_t length = MIN(size - offset, sizeof(io_buffer));
+        if ((fs_read(&source, io_buffer, length, &br) != FR_OK) || (br != length)) {
+            error = true;
+            break;
+        }
+        if ((fs_write(&destination, io_buffer, length, &bw) != FR_OK) || (bw != length)) {
+            error = true;
+            break;
+        }
+        if (progress) {
+            progress((offset + length) / (float) (size));
+        }
+    }
+
+    f_close(&source);
+
+    if (f_close(&destination) != FR_OK) {
         error = true;
     }
 
+    if (error) {
+        f_unlink(strip_fs_prefix(destination_path));
+    }
+
     return error;
 }
 
@@ -11,6 +11,37 @@
  */
 #define FS_SECTOR_SIZE      (512)
 
+/**
+ * @def FS_IO_BUFFER_SIZE
+ * @brief The size of the shared bulk transfer buffer, and the largest chunk passed to the chunk callbacks.
+ */
+#define FS_IO_BUFFER_SIZE   (FS_SECTOR_SIZE * 64)
+
+/**
+ * @brief Bulk transfer progress callback.
+ *
+ * @param progress Transferred fraction of the file.
+ */
+typedef void fs_progress_callback_t (float progress);
+
+/**
+ * @brief Bulk transfer chunk callback, produces or consumes one chunk of the file.
+ *
+ * @param buffer Pointer to the chunk data.
+ * @param offset Offset of the chunk in the file.
+ * @param length Length of the chunk.
+ * @param arg Callback argument.
+ * @return true if an error occurred and the transfer should stop, false otherwise.
+ */
+typedef bool fs_chunk_callback_t (void *buffer, size_t offset, size_t length, void *arg);
+
+/** @brief Bulk transfer statistics Structure. */
+typedef struct {
+    uint64_t read_bytes; /**< Number of bytes read since boot */
+    uint64_t written_bytes; /**< Number of bytes written since boot */
+    uint64_t busy_us; /**< Time spent transferring in microseconds */
+} fs_stats_t;
+
 /**
  * @file fs.h
  * @brief File system utility functions for file and directory operations.
@@ -79,6 +110,119 @@ bool file_allocate(char *path, size_t size);
  */
 bool file_fill(char *path, uint8_t value);
 
+/**
+ * @brief Create a file of the specified size filled with the specified value.
+ *
+ * Allocates the file contiguously when possible and writes it in large sector aligned blocks
+ * from a reusable fill buffer. Any existing file at the path is replaced.
+ *
+ * @param path The path to the file.
+ * @param size The size of the file to create in bytes.
+ * @param value The value to fill the file with (byte).
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_allocate_filled(char *path, size_t size, uint8_t value);
+
+/**
+ * @brief Read a range of a file into a buffer.
+ *
+ * The data is read with a single FatFs call, whole sectors are transferred straight into the buffer.
+ *
+ * @param path The path to the file.
+ * @param offset Offset of the range in the file.
+ * @param buffer Pointer to the output buffer.
+ * @param length Length of the range.
+ * @return true if an error occurred or the file is shorter than the range, false otherwise.
+ */
+bool file_read_range(char *path, uint64_t offset, void *buffer, size_t length);
+
+/**
+ * @brief Read a whole file into a caller supplied buffer.
+ *
+ * @param path The path to the file.
+ * @param buffer Pointer to the output buffer.
+ * @param capacity Size of the output buffer.
+ * @param length Pointer to store the file length.
+ * @return true if an error occurred or the file doesn't fit in the buffer, false otherwise.
+ */
+bool file_read_all(char *path, void *buffer, size_t capacity, size_t *length);
+
+/**
+ * @brief Replace a file with the specified data.
+ *
+ * The file is allocated contiguously when possible. The data is written to a temporary
+ * file first, on failure the previous file is left untouched.
+ *
+ * @param path The path to the file.
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_write_all(char *path, const void *data, size_t length);
+
+/**
+ * @brief Append data to the end of a file, the file is created when it doesn't exist.
+ *
+ * @param path The path to the file.
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_append(char *path, const void *data, size_t length);
+
+/**
+ * @brief Read a file in chunks, passing each chunk to a callback.
+ *
+ * @param path The path to the file.
+ * @param chunk_size Size of the chunks, up to FS_IO_BUFFER_SIZE. The last chunk can be shorter.
+ * @param sink Callback consuming the chunks.
+ * @param arg Callback argument.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_read_stream(char *path, size_t chunk_size, fs_chunk_callback_t *sink, void *arg, fs_progress_callback_t *progress);
+
+/**
+ * @brief Replace a file with data produced in chunks by a callback.
+ *
+ * The file is allocated contiguously when possible. A partially written file is removed on failure.
+ *
+ * @param path The path to the file.
+ * @param size The size of the file in bytes.
+ * @param chunk_size Size of the chunks, up to FS_IO_BUFFER_SIZE. The last chunk can be shorter.
+ * @param source Callback producing the chunks.
+ * @param arg Callback argument.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_write_stream(char *path, size_t size, size_t chunk_size, fs_chunk_callback_t *source, void *arg, fs_progress_callback_t *progress);
+
+/**
+ * @brief Replace a file with data produced in chunks by a callback, using a caller provided buffer.
+ *
+ * Same as file_write_stream, for chunks larger than FS_IO_BUFFER_SIZE.
+ *
+ * @param path The path to the file.
+ * @param size The size of the file in bytes.
+ * @param buffer Chunk buffer, sector aligned chunks are written without extra copies.
+ * @param chunk_size Size of the chunks and of the buffer. The last chunk can be shorter.
+ * @param source Callback producing the chunks.
+ * @param arg Callback argument.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_write_stream_buffered(char *path, size_t size, void *buffer, size_t chunk_size, fs_chunk_callback_t *source, void *arg, fs_progress_callback_t *progress);
+
+/**
+ * @brief Copy a file.
+ *
+ * @param source_path The path to the source file.
+ * @param destination_path The path to the destination file, replaced if it exists.
+ * @param progress Progress callback, can be NULL.
+ * @return true if an error occurred, false otherwise.
+ */
+bool file_copy(char *source_path, char *destination_path, fs_progress_callback_t *progress);
+
 /**
  * @brief Check if a file has one of the specified extensions.
  *
@@ -110,4 +254,13 @@ bool directory_exists(char *path);
  */
 bool directory_create(char *path);
 
+/**
+ * @brief Get the statistics of the transfers done by the file helpers.
+ *
+ * Only the transfers done through this module are counted, files accessed directly with FatFs aren't.
+ *
+ * @return Pointer to the statistics.
+ */
+fs_stats_t *fs_get_stats(void);
+
 #endif // UTILS_FS_H__
@@ -0,0 +1,54 @@
+/**
+ * @file hash.c
+ * @brief Implementation of the FNV-1a hashing and hashed cache slot helpers.
+ * @ingroup utils
+ */
+
+#include "hash.h"
+
+#define FNV1A32_PRIME   (0x01000193UL)
+#define FNV1A64_PRIME   (0x100000001B3ULL)
+
+uint32_t fnv1a32 (uint32_t hash, const void *data, size_t length) {
+    const uint8_t *bytes = data;
+
+    for (size_t i = 0; i < length; i++) {
+        hash = ((hash ^ bytes[i]) * FNV1A32_PRIME);
+    }
+
+    return hash;
+}
+
+uint32_t fnv1a32_string (const char *text) {
+    uint32_t hash = FNV1A32_INIT;
+
+    while (*text) {
+        hash = ((hash ^ (uint8_t) (*text++)) * FNV1A32_PRIME);
+    }
+
+    return hash;
+}
+
+uint64_t fnv1a64 (uint64_t hash, const void *data, size_t length) {
+    const uint8_t *bytes = data;
+
+    for (size_t i = 0; i < length; i++) {
+        hash = ((hash ^ bytes[i]) * FNV1A64_PRIME);
+    }
+
+    return hash;
+}
+
+uint64_t fnv1a64_string (const char *text) {
+    uint64_t hash = FNV1A64_INIT;
+
+    while (*text) {
+        hash = ((hash ^ (uint8_t) (*text++)) * FNV1A64_PRIME);
+    }
+
+    return hash;
+}
+
+long hash_slot_offset (uint64_t hash, size_t slots, size_t slot_size) {
+    return (long) ((hash % slots) * slot_size);
+}
@@ -0,0 +1,64 @@
+/**
+ * @file hash.h
+ * @brief FNV-1a hashing and hashed cache slot helpers.
+ * @ingroup utils
+ */
+
+#ifndef UTILS_HASH_H__
+#define UTILS_HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Initial value of the 32-bit FNV-1a hash. */
+#define FNV1A32_INIT    (0x811C9DC5UL)
+/** @brief Initial value of the 64-bit FNV-1a hash. */
+#define FNV1A64_INIT    (0xCBF29CE484222325ULL)
+
+/**
+ * @brief Continue a 32-bit FNV-1a hash over a buffer.
+ *
+ * @param hash Current hash value, FNV1A32_INIT to start a new hash.
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return uint32_t Updated hash value.
+ */
+uint32_t fnv1a32(uint32_t hash, const void *data, size_t length);
+
+/**
+ * @brief Calculate the 32-bit FNV-1a hash of a string, without the terminator.
+ *
+ * @param text The string.
+ * @return uint32_t Hash of the string.
+ */
+uint32_t fnv1a32_string(const char *text);
+
+/**
+ * @brief Continue a 64-bit FNV-1a hash over a buffer.
+ *
+ * @param hash Current hash value, FNV1A64_INIT to start a new hash.
+ * @param data Pointer to the data.
+ * @param length Length of the data.
+ * @return uint64_t Updated hash value.
+ */
+uint64_t fnv1a64(uint64_t hash, const void *data, size_t length);
+
+/**
+ * @brief Calculate the 64-bit FNV-1a hash of a string, without the terminator.
+ *
+ * @param text The string.
+ * @return uint64_t Hash of the string.
+ */
+uint64_t fnv1a64_string(const char *text);
+
+/**
+ * @brief Get the file offset of the slot selected by a hash in a fixed-size slot cache file.
+ *
+ * @param hash Hash of the entry key.
+ * @param slots Number of slots in the cache file.
+ * @param slot_size Size of one slot.
+ * @return long Offset of the slot in the cache file.
+ */
+long hash_slot_offset(uint64_t hash, size_t slots, size_t slot_size);
+
+#endif /* UTILS_HASH_H__ */
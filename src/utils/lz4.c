@@ -0,0 +1,96 @@
+/**
+ * @file lz4.c
+ * @brief Implementation of the LZ4 block decompressor.
+ * @ingroup utils
+ */
+
+#include <string.h>
+
+#include "lz4.h"
+
+#define LZ4_MIN_MATCH   (4)
+
+/**
+ * @brief Read an extended LZ4 length, a sequence of bytes added to the length until one is below 255.
+ *
+ * @param ip Pointer to the input position.
+ * @param end End of the input.
+ * @param length Pointer to the length to extend.
+ * @return 0 on success, -1 if the input ended.
+ */
+static int read_length (const uint8_t **ip, const uint8_t *end, size_t *length) {
+    uint8_t byte;
+
+    do {
+        if (*ip >= end) {
+            return -1;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+
+    return 0;
+}
+
+int lz4_decompress_block (const uint8_t *src, size_t src_length, uint8_t *dst, size_t dst_length) {
+    const uint8_t *ip = src;
+    const uint8_t *ip_end = src + src_length;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + dst_length;
+
+    while (ip < ip_end) {
+        uint8_t token = *ip++;
+
+        size_t literals = (token >> 4);
+        if ((literals == 15) && read_length(&ip, ip_end, &literals)) {
+            return -1;
+        }
+
+        if ((literals > (size_t) (ip_end - ip)) || (literals > (size_t) (op_end - op))) {
+            return -1;
+        }
+
+        memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+
+        // NOTE: The last sequence only contains literals
+        if (ip >= ip_end) {
+            break;
+        }
+
+        if ((ip_end - ip) < 2) {
+            return -1;
+        }
+
+        size_t offset = (ip[0] | (ip[1] << 8));
+        ip += 2;
+
+        if ((offset == 0) || (offset > (size_t) (op - dst))) {
+            return -1;
+        }
+
+        size_t length = (token & 0x0F);
+        if ((length == 15) && read_length(&ip, ip_end, &length)) {
+            return -1;
+        }
+        length += LZ4_MIN_MATCH;
+
+        if (length > (size_t) (op_end - op)) {
+            return -1;
+        }
+
+        const uint8_t *match = op - offset;
+        if (offset >= length) {
+            memcpy(op, match, length);
+            op += length;
+        } else {
+            // NOTE: Overlapping matches repeat their own output, so the copy must go byte by byte
+            for (size_t i = 0; i < length; i++) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return (int) (op - dst);
+}
@@ -0,0 +1,26 @@
+/**
+ * @file lz4.h
+ * @brief LZ4 block decompressor.
+ * @ingroup utils
+ */
+
+#ifndef UTILS_LZ4_H__
+#define UTILS_LZ4_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Decompress a single raw LZ4 block, without the frame header.
+ *
+ * The input is fully bounds checked, a damaged block can't write past the output buffer.
+ *
+ * @param src Pointer to the compressed data.
+ * @param src_length Length of the compressed data.
+ * @param dst Pointer to the output buffer.
+ * @param dst_length Size of the output buffer.
+ * @return Number of decompressed bytes, or -1 if the block is damaged or doesn't fit in the output buffer.
+ */
+int lz4_decompress_block(const uint8_t *src, size_t src_length, uint8_t *dst, size_t dst_length);
+
+#endif /* UTILS_LZ4_H__ */
@@ -0,0 +1,305 @@
+/**
+ * @file trace.c
+ * @brief Implementation of the load and boot phase timing tracer.
+ * @ingroup utils
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdragon.h>
+
+#include "trace.h"
+#include "trace_events.h"
+
+#define TRACE_MAGIC         (0x54524331) // "TRC1"
+#define STARTUP_MAGIC       (0x54525331) // "TRS1"
+#define TRACE_MAX_DEPTH     (4)
+
+/** @brief Boot history file structure. */
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t head;
+    trace_record_t records[TRACE_HISTORY_COUNT];
+} trace_history_t;
+
+/** @brief Startup profile file structure. */
+typedef struct {
+    uint32_t magic;
+    trace_record_t record;
+} trace_startup_file_t;
+
+static trace_history_t history;
+static char *history_path = NULL;
+static trace_record_t *current = NULL;
+static uint64_t trace_start_us;
+
+static struct {
+    const char *name;
+    uint64_t start_us;
+} stack[TRACE_MAX_DEPTH];
+static int stack_depth = 0;
+
+static trace_record_t startup_record;
+static trace_record_t startup_previous;
+static bool startup_previous_valid = false;
+static bool startup_active = false;
+static bool startup_complete = false;
+static char *startup_path = NULL;
+
+static trace_phase_listener_t *phase_listener = NULL;
+
+/**
+ * @brief Initialize the tracer and load the boot history.
+ *
+ * @param cache_location Path to the boot history file.
+ */
+void trace_init (char *cache_location) {
+    FILE *f;
+
+    free(history_path);
+    history_path = strdup(cache_location);
+
+    memset(&history, 0, sizeof(history));
+
+    if ((f = fopen(history_path, "rb")) == NULL) {
+        return;
+    }
+
+    setbuf(f, NULL);
+
+    if ((fread(&history, sizeof(history), 1, f) != 1) || (history.magic != TRACE_MAGIC) || (history.count > TRACE_HISTORY_COUNT) || (history.head >= TRACE_HISTORY_COUNT)) {
+        memset(&history, 0, sizeof(history));
+    }
+
+    fclose(f);
+}
+
+/**
+ * @brief Start tracing a new boot.
+ *
+ * @param name Name of the loaded file.
+ */
+void trace_start (const char *name) {
+    history.magic = TRACE_MAGIC;
+    history.head = ((history.head + 1) % TRACE_HISTORY_COUNT);
+    if (history.count < TRACE_HISTORY_COUNT) {
+        history.count += 1;
+    }
+
+    current = &history.records[history.head];
+    memset(current, 0, sizeof(trace_record_t));
+    strncpy(current->name, name, TRACE_NAME_LENGTH - 1);
+
+    stack_depth = 0;
+    trace_start_us = get_ticks_us();
+
+    debugf("Trace: %s\n", current->name);
+}
+
+/**
+ * @brief Begin a timed phase.
+ *
+ * @param name Phase name.
+ */
+void trace_phase_begin (const char *name) {
+    trace_event_begin("phase", name);
+
+    if (stack_depth >= TRACE_MAX_DEPTH) {
+        stack_depth += 1;
+        return;
+    }
+
+    stack[stack_depth].name = name;
+    stack[stack_depth].start_us = get_ticks_us();
+    stack_depth += 1;
+}
+
+/**
+ * @brief End the most recently started phase and log its duration.
+ */
+void trace_phase_end (void) {
+    if (stack_depth <= 0) {
+        return;
+    }
+
+    stack_depth -= 1;
+
+    if (stack_depth >= TRACE_MAX_DEPTH) {
+        trace_event_end("phase", "");
+        return;
+    }
+
+    trace_event_end("phase", stack[stack_depth].name);
+
+    uint64_t now = get_ticks_us();
+    uint32_t duration_us = (uint32_t) (now - stack[stack_depth].start_us);
+
+    debugf("Trace: %*s%s: %lu us\n", (stack_depth * 2), "", stack[stack_depth].name, duration_us);
+
+    trace_phase_t phase = { 0 };
+    strncpy(phase.name, stack[stack_depth].name, TRACE_NAME_LENGTH - 1);
+    phase.depth = stack_depth;
+    phase.start_us = (uint32_t) (stack[stack_depth].start_us - trace_start_us);
+    phase.duration_us = duration_us;
+
+    if (phase_listener != NULL) {
+        phase_listener(&phase);
+    }
+
+    if ((current == NULL) || (current->phase_count >= TRACE_MAX_PHASES)) {
+        return;
+    }
+
+    current->phases[current->phase_count++] = phase;
+}
+
+/**
+ * @brief Store the boot history.
+ */
+void trace_save (void) {
+    FILE *f;
+
+    if ((history_path == NULL) || (current == NULL)) {
+        return;
+    }
+
+    if ((f = fopen(history_path, "wb")) == NULL) {
+        return;
+    }
+
+    fwrite(&history, sizeof(history), 1, f);
+
+    fclose(f);
+}
+
+/**
+ * @brief Get the number of records in the boot history.
+ *
+ * @return int Number of records.
+ */
+int trace_get_record_count (void) {
+    return history.count;
+}
+
+/**
+ * @brief Get a record from the boot history.
+ *
+ * @param index Record index, 0 is the most recent boot.
+ * @return trace_record_t* Pointer to the record, NULL if the index is out of range.
+ */
+trace_record_t *trace_get_record (int index) {
+    if ((index < 0) || (index >= history.count)) {
+        return NULL;
+    }
+
+    return &history.records[(history.head + TRACE_HISTORY_COUNT - index) % TRACE_HISTORY_COUNT];
+}
+
+/**
+ * @brief Start tracing the menu startup.
+ */
+void trace_startup_begin (void) {
+    memset(&startup_record, 0, sizeof(startup_record));
+    strncpy(startup_record.name, "Menu startup", TRACE_NAME_LENGTH - 1);
+
+    current = &startup_record;
+    stack_depth = 0;
+    trace_start_us = get_ticks_us();
+    startup_active = true;
+}
+
+/**
+ * @brief Set the startup profile file and load the profile of the previous startup.
+ *
+ * @param cache_location Path to the startup profile file.
+ */
+void trace_startup_init (char *cache_location) {
+    FILE *f;
+
+    free(startup_path);
+    startup_path = strdup(cache_location);
+
+    startup_previous_valid = false;
+
+    if ((f = fopen(startup_path, "rb")) == NULL) {
+        return;
+    }
+
+    setbuf(f, NULL);
+
+    trace_startup_file_t file;
+    if ((fread(&file, sizeof(file), 1, f) == 1) && (file.magic == STARTUP_MAGIC) && (file.record.phase_count <= TRACE_MAX_PHASES)) {
+        startup_previous = file.record;
+        startup_previous_valid = true;
+    }
+
+    fclose(f);
+}
+
+/**
+ * @brief Stop tracing the menu startup and store the profile.
+ */
+void trace_startup_end (void) {
+    FILE *f;
+
+    if (!startup_active) {
+        return;
+    }
+
+    startup_active = false;
+    startup_complete = true;
+
+    // NOTE: A ROM load may have started its own trace in the meantime, it's kept running
+    if (current == &startup_record) {
+        current = NULL;
+        stack_depth = 0;
+    }
+
+    if ((startup_path == NULL) || ((f = fopen(startup_path, "wb")) == NULL)) {
+        return;
+    }
+
+    trace_startup_file_t file = {
+        .magic = STARTUP_MAGIC,
+        .record = startup_record,
+    };
+
+    fwrite(&file, sizeof(file), 1, f);
+
+    fclose(f);
+}
+
+/**
+ * @brief Check if the menu startup is being traced.
+ *
+ * @return true if the startup is being traced, false otherwise.
+ */
+bool trace_startup_active (void) {
+    return startup_active && (current == &startup_record);
+}
+
+/**
+ * @brief Get a startup profile.
+ *
+ * @param previous Get the profile of the previous startup instead of the current one.
+ * @return trace_record_t* Pointer to the profile, NULL if it's not available.
+ */
+trace_record_t *trace_get_startup_record (bool previous) {
+    if (previous) {
+        return startup_previous_valid ? &startup_previous : NULL;
+    }
+
+    return startup_complete ? &startup_record : NULL;
+}
+
+/**
+ * @brief Set the phase listener.
+ *
+ * @param listener Listener callback, NULL removes the listener.
+ */
+void trace_set_phase_listener (trace_phase_listener_t *listener) {
+    phase_listener = listener;
+}
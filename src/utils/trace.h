@@ -0,0 +1,138 @@
+/**
+ * @file trace.h
+ * @brief Load and boot phase timing tracer.
+ * @ingroup utils
+ */
+
+#ifndef UTILS_TRACE_H__
+#define UTILS_TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @def TRACE_HISTORY_COUNT
+ * @brief Number of the last traced boots kept in the history ring.
+ */
+#define TRACE_HISTORY_COUNT     (4)
+
+/**
+ * @def TRACE_MAX_PHASES
+ * @brief Maximum number of phases recorded per traced boot.
+ */
+#define TRACE_MAX_PHASES        (16)
+
+/**
+ * @def TRACE_NAME_LENGTH
+ * @brief Maximum length of the phase and boot names, including the null terminator.
+ */
+#define TRACE_NAME_LENGTH       (24)
+
+/** @brief Traced phase structure. */
+typedef struct {
+    char name[TRACE_NAME_LENGTH];   /**< Phase name */
+    uint8_t depth;                  /**< Nesting depth of the phase */
+    uint32_t start_us;              /**< Phase start time relative to the trace start in microseconds */
+    uint32_t duration_us;           /**< Phase duration in microseconds */
+} trace_phase_t;
+
+/** @brief Traced boot structure. */
+typedef struct {
+    char name[TRACE_NAME_LENGTH];   /**< Name of the loaded file */
+    uint32_t phase_count;           /**< Number of recorded phases */
+    trace_phase_t phases[TRACE_MAX_PHASES]; /**< Recorded phases, in order of completion */
+} trace_record_t;
+
+/**
+ * @brief Phase listener callback, called when a phase ends.
+ *
+ * @param phase Pointer to the ended phase.
+ */
+typedef void trace_phase_listener_t (const trace_phase_t *phase);
+
+/**
+ * @brief Initialize the tracer and load the boot history.
+ *
+ * @param cache_location Path to the boot history file.
+ */
+void trace_init (char *cache_location);
+
+/**
+ * @brief Start tracing a new boot, the oldest record in the history ring is replaced.
+ *
+ * @param name Name of the loaded file.
+ */
+void trace_start (const char *name);
+
+/**
+ * @brief Begin a timed phase, phases can be nested.
+ *
+ * @param name Phase name.
+ */
+void trace_phase_begin (const char *name);
+
+/**
+ * @brief End the most recently started phase and log its duration.
+ */
+void trace_phase_end (void);
+
+/**
+ * @brief Store the boot history.
+ */
+void trace_save (void);
+
+/**
+ * @brief Get the number of records in the boot history.
+ *
+ * @return int Number of records.
+ */
+int trace_get_record_count (void);
+
+/**
+ * @brief Get a record from the boot history.
+ *
+ * @param index Record index, 0 is the most recent boot.
+ * @return trace_record_t* Pointer to the record, NULL if the index is out of range.
+ */
+trace_record_t *trace_get_record (int index);
+
+/**
+ * @brief Start tracing the menu startup, the phases are recorded until trace_startup_end is called.
+ */
+void trace_startup_begin (void);
+
+/**
+ * @brief Set the startup profile file and load the profile of the previous startup.
+ *
+ * @param cache_location Path to the startup profile file.
+ */
+void trace_startup_init (char *cache_location);
+
+/**
+ * @brief Stop tracing the menu startup and store the profile.
+ */
+void trace_startup_end (void);
+
+/**
+ * @brief Check if the menu startup is being traced.
+ *
+ * @return true if the startup is being traced, false otherwise.
+ */
+bool trace_startup_active (void);
+
+/**
+ * @brief Get a startup profile.
+ *
+ * @param previous Get the profile of the previous startup instead of the current one.
+ * @return trace_record_t* Pointer to the profile, NULL if it's not available.
+ */
+trace_record_t *trace_get_startup_record (bool previous);
+
+/**
+ * @brief Set the listener notified about every ended phase, traced or not.
+ *
+ * @param listener Listener callback, NULL removes the listener.
+ */
+void trace_set_phase_listener (trace_phase_listener_t *listener);
+
+#endif /* UTILS_TRACE_H__ */
@@ -0,0 +1,155 @@
+/**
+ * @file trace_events.c
+ * @brief Implementation of the timestamped event trace ring.
+ * @ingroup utils
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdragon.h>
+
+#include "trace_events.h"
+
+#define TRACE_EVENTS_MASK       (TRACE_EVENTS_COUNT - 1)
+#define SAVE_BUFFER_SIZE        (16 * 1024)
+
+_Static_assert((TRACE_EVENTS_COUNT & TRACE_EVENTS_MASK) == 0, "TRACE_EVENTS_COUNT must be a power of two");
+
+/** @brief Event phase enumeration, values match the Chrome trace event phases. */
+typedef enum {
+    EVENT_BEGIN = 'B',
+    EVENT_END = 'E',
+    EVENT_INSTANT = 'i',
+} event_phase_t;
+
+/** @brief Recorded event structure. */
+typedef struct {
+    uint32_t ticks; /**< CPU count register value */
+    char phase; /**< Event phase */
+    const char *category; /**< Event category */
+    const char *name; /**< Event name */
+} trace_event_t;
+
+static trace_event_t events[TRACE_EVENTS_COUNT];
+static uint32_t recorded = 0;
+
+
+static void record (char phase, const char *category, const char *name) {
+    trace_event_t *event = &events[recorded & TRACE_EVENTS_MASK];
+
+    event->ticks = C0_COUNT();
+    event->phase = phase;
+    event->category = category;
+    event->name = name;
+
+    recorded += 1;
+}
+
+static void save_string (FILE *f, const char *string) {
+    fputc('"', f);
+    for (; *string != '\0'; string++) {
+        if ((*string == '"') || (*string == '\\')) {
+            fputc('\\', f);
+        }
+        fputc(((uint8_t) (*string) < ' ') ? ' ' : *string, f);
+    }
+    fputc('"', f);
+}
+
+
+/**
+ * @brief Record the beginning of a duration event.
+ *
+ * @param category Event category.
+ * @param name Event name.
+ */
+void trace_event_begin (const char *category, const char *name) {
+    record(EVENT_BEGIN, category, name);
+}
+
+/**
+ * @brief Record the end of the most recently begun duration event.
+ *
+ * @param category Event category.
+ * @param name Event name.
+ */
+void trace_event_end (const char *category, const char *name) {
+    record(EVENT_END, category, name);
+}
+
+/**
+ * @brief Record an instant event.
+ *
+ * @param category Event category.
+ * @param name Event name.
+ */
+void trace_event_instant (const char *category, const char *name) {
+    record(EVENT_INSTANT, category, name);
+}
+
+/**
+ * @brief Get the number of events in the ring.
+ *
+ * @return int Number of events.
+ */
+int trace_events_get_count (void) {
+    return (recorded < TRACE_EVENTS_COUNT) ? recorded : TRACE_EVENTS_COUNT;
+}
+
+/**
+ * @brief Save the events in the ring in the Chrome trace event format.
+ *
+ * @param path Path to the trace file.
+ * @return true if the file couldn't be written, false otherwise.
+ */
+bool trace_events_save (const char *path) {
+    FILE *f;
+
+    if ((f = fopen(path, "w")) == NULL) {
+        return true;
+    }
+
+    char *buffer = malloc(SAVE_BUFFER_SIZE);
+    if (buffer != NULL) {
+        setvbuf(f, buffer, _IOFBF, SAVE_BUFFER_SIZE);
+    }
+
+    int count = trace_events_get_count();
+    uint32_t first = (recorded - count);
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Main\"}}");
+
+    // NOTE: The count register wraps every ~91 seconds, events are never further apart than that
+    uint64_t ticks = 0;
+    uint32_t previous = (count > 0) ? events[first & TRACE_EVENTS_MASK].ticks : 0;
+
+    for (int i = 0; i < count; i++) {
+        trace_event_t *event = &events[(first + i) & TRACE_EVENTS_MASK];
+
+        ticks += (uint32_t) (event->ticks - previous);
+        previous = event->ticks;
+
+        uint64_t ns = ((ticks / TICKS_PER_SECOND) * 1000000000ULL) + (((ticks % TICKS_PER_SECOND) * 1000000000ULL) / TICKS_PER_SECOND);
+
+        fprintf(f, ",\n{\"name\":");
+        save_string(f, event->name);
+        fprintf(f, ",\"cat\":");
+        save_string(f, event->category);
+        fprintf(f, ",\"ph\":\"%c\",\"ts\":%llu.%03llu,\"pid\":1,\"tid\":1%s}", event->phase, ns / 1000, ns % 1000, (event->phase == EVENT_INSTANT) ? ",\"s\":\"t\"" : "");
+    }
+
+    fprintf(f, "\n]}\n");
+
+    bool error = (ferror(f) != 0);
+
+    if (fclose(f)) {
+        error = true;
+    }
+
+    free(buffer);
+
+    return error;
+}
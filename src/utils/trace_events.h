@@ -0,0 +1,62 @@
+/**
+ * @file trace_events.h
+ * @brief Timestamped event trace ring.
+ * @ingroup utils
+ *
+ * Begin, end and instant events are recorded with the CPU count register
+ * into a fixed size ring, the oldest events are overwritten. The ring can be
+ * saved in the Chrome trace event format, viewable in chrome://tracing or Perfetto.
+ */
+
+#ifndef UTILS_TRACE_EVENTS_H__
+#define UTILS_TRACE_EVENTS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @def TRACE_EVENTS_COUNT
+ * @brief Number of the last events kept in the ring, must be a power of two.
+ */
+#define TRACE_EVENTS_COUNT      (4096)
+
+/**
+ * @brief Record the beginning of a duration event, events of the same category can be nested.
+ *
+ * @param category Event category, must stay valid until the ring is saved.
+ * @param name Event name, must stay valid until the ring is saved.
+ */
+void trace_event_begin (const char *category, const char *name);
+
+/**
+ * @brief Record the end of the most recently begun duration event.
+ *
+ * @param category Event category, must stay valid until the ring is saved.
+ * @param name Event name, must stay valid until the ring is saved.
+ */
+void trace_event_end (const char *category, const char *name);
+
+/**
+ * @brief Record an instant event.
+ *
+ * @param category Event category, must stay valid until the ring is saved.
+ * @param name Event name, must stay valid until the ring is saved.
+ */
+void trace_event_instant (const char *category, const char *name);
+
+/**
+ * @brief Get the number of events in the ring.
+ *
+ * @return int Number of events.
+ */
+int trace_events_get_count (void);
+
+/**
+ * @brief Save the events in the ring in the Chrome trace event format.
+ *
+ * @param path Path to the trace file.
+ * @return true if the file couldn't be written, false otherwise.
+ */
+bool trace_events_save (const char *path);
+
+#endif /* UTILS_TRACE_EVENTS_H__ */
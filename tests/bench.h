@@ -0,0 +1,39 @@
+/**
+ * @file bench.h
+ * @brief Host micro-benchmark helpers for the acutest suite
+ */
+
+#ifndef TESTS_BENCH_H__
+#define TESTS_BENCH_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns (void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) (ts.tv_sec) * 1000000000ULL) + (uint64_t) (ts.tv_nsec);
+}
+
+/**
+ * @brief Time a statement and print the average time of one run.
+ *
+ * The benchmarks only guard against regressions on the same machine,
+ * the host timings don't translate to the console.
+ *
+ * @param name Benchmark name.
+ * @param iterations Number of runs.
+ * @param statement Statement to time.
+ */
+#define BENCH(name, iterations, statement) \
+    do { \
+        uint64_t bench_start_ = bench_now_ns(); \
+        for (long bench_i_ = 0; bench_i_ < (iterations); bench_i_++) { \
+            statement; \
+        } \
+        uint64_t bench_end_ = bench_now_ns(); \
+        printf("  %-32s %10.1f ns/op\n", (name), (double) (bench_end_ - bench_start_) / (double) (iterations)); \
+    } while (0)
+
+#endif /* TESTS_BENCH_H__ */
@@ -0,0 +1,139 @@
+#include <string.h>
+
+#include "acutest/acutest.h"
+#include "bench.h"
+#include "menu/bgm_stream.h"
+
+#define FILE_SIZE   (10000)
+#define HEAD_SIZE   (1024)
+#define RING_SIZE   (4096)
+
+typedef struct {
+    uint8_t data[FILE_SIZE];
+    int reads;
+    bool failing;
+} file_t;
+
+static file_t file;
+static bgm_stream_t stream;
+static uint8_t head[HEAD_SIZE];
+static uint8_t ring[RING_SIZE];
+
+static bool file_read (void *arg, uint32_t offset, void *buffer, size_t length) {
+    file_t *f = arg;
+    if (f->failing || ((offset + length) > FILE_SIZE)) {
+        return true;
+    }
+    memcpy(buffer, &f->data[offset], length);
+    f->reads += 1;
+    return false;
+}
+
+static void stream_init (void) {
+    memset(&file, 0, sizeof(file));
+    for (int i = 0; i < FILE_SIZE; i++) {
+        file.data[i] = (uint8_t) ((i * 31) + (i >> 8));
+    }
+    TEST_CHECK(!bgm_stream_init(&stream, file_read, &file, FILE_SIZE, head, sizeof(head), ring, sizeof(ring)));
+}
+
+static bool read_check (uint32_t length) {
+    uint8_t buffer[2048];
+    uint32_t position = stream.position;
+    int result = bgm_stream_read(&stream, buffer, length);
+    return (result == (int) (length)) && (memcmp(buffer, &file.data[position], length) == 0);
+}
+
+static void test_sequential (void) {
+    stream_init();
+
+    while (bgm_stream_refill(&stream, 512) > 0);
+    TEST_CHECK(stream.fill == RING_SIZE);
+    TEST_CHECK(!bgm_stream_needs_refill(&stream));
+
+    int reads = file.reads;
+    uint32_t position = 0;
+    while (position < FILE_SIZE) {
+        uint32_t length = ((FILE_SIZE - position) < 700) ? (FILE_SIZE - position) : 700;
+        TEST_CHECK(read_check(length));
+        position += length;
+        while (bgm_stream_refill(&stream, 512) > 0);
+    }
+
+    TEST_MSG("the mixer reads must be served from memory");
+    TEST_CHECK(stream.underruns == 0);
+    TEST_CHECK(file.reads > reads);
+
+    uint8_t buffer[16];
+    TEST_CHECK(bgm_stream_read(&stream, buffer, sizeof(buffer)) == 0);
+}
+
+static void test_loop (void) {
+    stream_init();
+
+    bgm_stream_seek(&stream, 8000);
+    while (bgm_stream_refill(&stream, 4096) > 0);
+    TEST_CHECK(read_check(2000));
+
+    bgm_stream_seek(&stream, 64);
+    TEST_MSG("the head of the file must be resident");
+    int reads = file.reads;
+    TEST_CHECK(read_check(512));
+    TEST_CHECK(file.reads == reads);
+    TEST_CHECK(stream.base == HEAD_SIZE);
+
+    while (bgm_stream_refill(&stream, 4096) > 0);
+    TEST_CHECK(read_check(2000));
+    TEST_CHECK(stream.underruns == 0);
+}
+
+static void test_underrun (void) {
+    stream_init();
+
+    TEST_CHECK(read_check(HEAD_SIZE));
+    TEST_CHECK(read_check(800));
+    TEST_CHECK(stream.underruns == 1);
+    TEST_CHECK(stream.base == (HEAD_SIZE + 800));
+
+    bgm_stream_refill(&stream, 300);
+    TEST_MSG("a read crossing the end of the buffered data must be completed from the file");
+    TEST_CHECK(read_check(500));
+    TEST_CHECK(stream.underruns == 2);
+
+    bgm_stream_seek(&stream, FILE_SIZE + 100);
+    TEST_CHECK(stream.position == FILE_SIZE);
+    TEST_CHECK(!bgm_stream_needs_refill(&stream));
+}
+
+static void test_error (void) {
+    stream_init();
+
+    file.failing = true;
+    TEST_CHECK(bgm_stream_refill(&stream, 512) == 0);
+    TEST_CHECK(stream.error);
+
+    uint8_t buffer[16];
+    TEST_CHECK(bgm_stream_read(&stream, buffer, sizeof(buffer)) == -1);
+}
+
+static void bench_read (void) {
+    stream_init();
+
+    uint8_t buffer[1024];
+    BENCH("Read 1 KiB from the ring buffer", 100000, {
+        if (stream.position >= (FILE_SIZE - sizeof(buffer))) {
+            bgm_stream_seek(&stream, 0);
+        }
+        while (bgm_stream_refill(&stream, 4096) > 0);
+        bgm_stream_read(&stream, buffer, sizeof(buffer));
+    });
+}
+
+TEST_LIST = {
+    { "bgm_stream/sequential", test_sequential },
+    { "bgm_stream/loop", test_loop },
+    { "bgm_stream/underrun", test_underrun },
+    { "bgm_stream/error", test_error },
+    { "bench/bgm_stream_read", bench_read },
+    { NULL, NULL }
+};
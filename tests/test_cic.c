@@ -0,0 +1,51 @@
+#include <string.h>
+
+#include "acutest/acutest.h"
+#include "bench.h"
+#include "boot/cic.h"
+
+static uint8_t ipl3[IPL3_LENGTH];
+
+static void fill_pattern (uint8_t *buffer, uint32_t seed) {
+    for (int i = 0; i < IPL3_LENGTH; i++) {
+        seed = (seed * 1103515245) + 12345;
+        buffer[i] = (uint8_t) (seed >> 16);
+    }
+}
+
+static void test_unknown (void) {
+    memset(ipl3, 0, sizeof(ipl3));
+    TEST_CHECK(cic_detect(ipl3) == CIC_UNKNOWN);
+
+    fill_pattern(ipl3, 1);
+    TEST_CHECK(cic_detect(ipl3) == CIC_UNKNOWN);
+
+    // NOTE: The second detection of the same IPL3 comes from the fingerprint cache
+    TEST_CHECK(cic_detect(ipl3) == CIC_UNKNOWN);
+}
+
+static void test_seeds (void) {
+    TEST_CHECK(cic_get_seed(CIC_6101) == 0x3F);
+    TEST_CHECK(cic_get_seed(CIC_x102) == 0x3F);
+    TEST_CHECK(cic_get_seed(CIC_x103) == 0x78);
+    TEST_CHECK(cic_get_seed(CIC_x105) == 0x91);
+    TEST_CHECK(cic_get_seed(CIC_x106) == 0x85);
+    TEST_CHECK(cic_get_seed(CIC_8303) == 0xDD);
+}
+
+static void bench_detect (void) {
+    uint32_t seed = 0;
+
+    fill_pattern(ipl3, 2);
+    BENCH("cic detect (cached)", 100000, cic_detect(ipl3));
+
+    // NOTE: A new IPL3 every run misses the cache and tries the checksum of every seed
+    BENCH("cic detect (unknown IPL3)", 2000, { ipl3[0] = (uint8_t) (seed); ipl3[1] = (uint8_t) (seed++ >> 8); cic_detect(ipl3); });
+}
+
+TEST_LIST = {
+    { "cic/unknown", test_unknown },
+    { "cic/seeds", test_seeds },
+    { "bench/cic_detect", bench_detect },
+    { NULL, NULL }
+};
@@ -0,0 +1,193 @@
+#include <string.h>
+
+#include "acutest/acutest.h"
+#include "bench.h"
+#include "menu/font_pages.h"
+
+typedef struct {
+    int fonts[FONT_PAGES_SLOTS];
+    int loads;
+    int unloads;
+    uint32_t failing_page;
+} pages_t;
+
+static pages_t pages;
+static font_pages_t fp;
+
+static void *page_load (uint32_t page, int slot, void *arg) {
+    pages_t *p = arg;
+    if (page == p->failing_page) {
+        return NULL;
+    }
+    p->loads += 1;
+    p->fonts[slot] = page;
+    return &p->fonts[slot];
+}
+
+static void page_unload (void *font, int slot, void *arg) {
+    pages_t *p = arg;
+    TEST_CHECK(font == &p->fonts[slot]);
+    p->unloads += 1;
+}
+
+static void cache_init (void) {
+    memset(&pages, 0, sizeof(pages));
+    pages.failing_page = UINT32_MAX;
+    font_pages_init(&fp, page_load, page_unload, &pages);
+}
+
+static void test_resident (void) {
+    cache_init();
+
+    font_pages_begin_text(&fp);
+    TEST_CHECK(font_pages_get_slot(&fp, 'A') == FONT_PAGES_RESIDENT);
+    TEST_CHECK(font_pages_get_slot(&fp, 0x4E00) == FONT_PAGES_RESIDENT);
+
+    char output[64];
+    const char *text = "Hello \xE4\xB8\x80";
+    TEST_CHECK(font_pages_rewrite(&fp, text, strlen(text), output, sizeof(output), 1, 2) == 0);
+    TEST_CHECK(pages.loads == 0);
+}
+
+static void test_rewrite (void) {
+    cache_init();
+    font_pages_set_available(&fp, 0x4E);
+
+    char output[64];
+    const char *text = "A\xE4\xB8\x80\xE4\xB8\x81" "B";
+
+    font_pages_begin_text(&fp);
+    size_t length = font_pages_rewrite(&fp, text, strlen(text), output, sizeof(output), 1, 2);
+
+    const char *expected = "A$02\xE4\xB8\x80\xE4\xB8\x81$01B";
+    TEST_CHECK(length == strlen(expected));
+    TEST_CHECK(memcmp(output, expected, length) == 0);
+    TEST_CHECK(pages.loads == 1);
+
+    text = "\xE4\xB8\x80";
+    font_pages_begin_text(&fp);
+    length = font_pages_rewrite(&fp, text, strlen(text), output, sizeof(output), 1, 2);
+    expected = "$02\xE4\xB8\x80$01";
+    TEST_CHECK(length == strlen(expected));
+    TEST_CHECK(memcmp(output, expected, length) == 0);
+    TEST_MSG("the loaded page must be reused");
+    TEST_CHECK(pages.loads == 1);
+    TEST_CHECK(fp.hits > 0);
+
+    TEST_CHECK(font_pages_rewrite(&fp, text, strlen(text), output, 4, 1, 2) == 0);
+}
+
+static void test_runs (void) {
+    cache_init();
+    font_pages_set_available(&fp, 0x30);
+    font_pages_set_available(&fp, 0x4E);
+
+    const char *text = "\xE3\x81\x82\xE4\xB8\x80x";
+    size_t length = strlen(text);
+    int slot;
+
+    font_pages_begin_text(&fp);
+    size_t run = font_pages_next_run(&fp, text, length, &slot);
+    TEST_CHECK(run == 3 && slot == 0);
+    run = font_pages_next_run(&fp, text + 3, length - 3, &slot);
+    TEST_CHECK(run == 3 && slot == 1);
+    run = font_pages_next_run(&fp, text + 6, length - 6, &slot);
+    TEST_CHECK(run == 1 && slot == FONT_PAGES_RESIDENT);
+    TEST_CHECK(font_pages_next_run(&fp, text + 7, 0, &slot) == 0);
+
+    TEST_MSG("a truncated sequence must be drawn with the resident font");
+    run = font_pages_next_run(&fp, "\xE4\xB8", 2, &slot);
+    TEST_CHECK(slot == FONT_PAGES_RESIDENT);
+}
+
+static void test_lru (void) {
+    cache_init();
+    for (uint32_t page = 0x40; page < (0x40 + FONT_PAGES_SLOTS + 1); page++) {
+        font_pages_set_available(&fp, page);
+    }
+
+    for (uint32_t page = 0x40; page < (0x40 + FONT_PAGES_SLOTS); page++) {
+        font_pages_begin_text(&fp);
+        TEST_CHECK(font_pages_get_slot(&fp, page << FONT_PAGES_SHIFT) >= 0);
+    }
+    TEST_CHECK(pages.loads == FONT_PAGES_SLOTS);
+
+    font_pages_begin_text(&fp);
+    int first = font_pages_get_slot(&fp, 0x40 << FONT_PAGES_SHIFT);
+
+    font_pages_begin_text(&fp);
+    int slot = font_pages_get_slot(&fp, (0x40 + FONT_PAGES_SLOTS) << FONT_PAGES_SHIFT);
+    TEST_MSG("the least recently used page must be evicted");
+    TEST_CHECK(slot >= 0 && slot != first);
+    TEST_CHECK(pages.fonts[slot] == (0x40 + FONT_PAGES_SLOTS));
+    TEST_CHECK(pages.unloads == 1);
+    TEST_CHECK(fp.evictions == 1);
+
+    font_pages_clear(&fp);
+    TEST_CHECK(pages.unloads == (FONT_PAGES_SLOTS + 1));
+}
+
+static void test_pinned (void) {
+    cache_init();
+    for (uint32_t page = 0x40; page < (0x40 + FONT_PAGES_SLOTS + 1); page++) {
+        font_pages_set_available(&fp, page);
+    }
+
+    font_pages_begin_text(&fp);
+    for (uint32_t page = 0x40; page < (0x40 + FONT_PAGES_SLOTS); page++) {
+        TEST_CHECK(font_pages_get_slot(&fp, page << FONT_PAGES_SHIFT) >= 0);
+    }
+
+    TEST_MSG("the pages used by the current text must not be evicted");
+    TEST_CHECK(font_pages_get_slot(&fp, (0x40 + FONT_PAGES_SLOTS) << FONT_PAGES_SHIFT) == FONT_PAGES_RESIDENT);
+    TEST_CHECK(pages.unloads == 0);
+}
+
+static void test_load_failure (void) {
+    cache_init();
+    font_pages_set_available(&fp, 0x4E);
+    pages.failing_page = 0x4E;
+
+    font_pages_begin_text(&fp);
+    TEST_CHECK(font_pages_get_slot(&fp, 0x4E00) == FONT_PAGES_RESIDENT);
+    TEST_MSG("a page that failed to load must not be retried");
+    TEST_CHECK(!font_pages_is_available(&fp, 0x4E));
+}
+
+static void bench_rewrite (void) {
+    cache_init();
+    font_pages_set_available(&fp, 0x4E);
+
+    char text[256];
+    size_t length = 0;
+    while ((length + 4) < sizeof(text)) {
+        memcpy(&text[length], (length % 8) ? "ab" : "\xE4\xB8", 2);
+        length += 2;
+        if (text[length - 2] == '\xE4') {
+            text[length++] = '\x80';
+        }
+    }
+
+    char output[512];
+    BENCH("Rewrite mixed text (256 bytes)", 10000, {
+        font_pages_begin_text(&fp);
+        font_pages_rewrite(&fp, text, length, output, sizeof(output), 1, 2);
+    });
+
+    const char *ascii = "The quick brown fox jumps over the lazy dog, the quick brown fox jumps over the lazy dog.";
+    BENCH("Rewrite ASCII text", 10000, {
+        font_pages_begin_text(&fp);
+        font_pages_rewrite(&fp, ascii, strlen(ascii), output, sizeof(output), 1, 2);
+    });
+}
+
+TEST_LIST = {
+    { "font_pages/resident", test_resident },
+    { "font_pages/rewrite", test_rewrite },
+    { "font_pages/runs", test_runs },
+    { "font_pages/lru", test_lru },
+    { "font_pages/pinned", test_pinned },
+    { "font_pages/load_failure", test_load_failure },
+    { "bench/font_pages_rewrite", bench_rewrite },
+    { NULL, NULL }
+};
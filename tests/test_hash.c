@@ -0,0 +1,50 @@
+#include <string.h>
+
+#include "acutest/acutest.h"
+#include "bench.h"
+#include "utils/hash.h"
+
+static void test_fnv1a32 (void) {
+    TEST_CHECK(fnv1a32_string("") == FNV1A32_INIT);
+    TEST_CHECK(fnv1a32_string("a") == 0xE40C292CUL);
+    TEST_CHECK(fnv1a32_string("foobar") == 0xBF9CF968UL);
+    TEST_CHECK(fnv1a32(FNV1A32_INIT, "foobar", 6) == 0xBF9CF968UL);
+}
+
+static void test_fnv1a64 (void) {
+    TEST_CHECK(fnv1a64_string("") == FNV1A64_INIT);
+    TEST_CHECK(fnv1a64_string("a") == 0xAF63DC4C8601EC8CULL);
+    TEST_CHECK(fnv1a64_string("foobar") == 0x85944171F73967E8ULL);
+    TEST_CHECK(fnv1a64(FNV1A64_INIT, "foobar", 6) == 0x85944171F73967E8ULL);
+}
+
+static void test_chained (void) {
+    // NOTE: Hashing in chunks must match hashing the whole buffer at once
+    TEST_CHECK(fnv1a32(fnv1a32(FNV1A32_INIT, "foo", 3), "bar", 3) == fnv1a32_string("foobar"));
+    TEST_CHECK(fnv1a64(fnv1a64(FNV1A64_INIT, "foo", 3), "bar", 3) == fnv1a64_string("foobar"));
+}
+
+static void test_slot_offset (void) {
+    TEST_CHECK(hash_slot_offset(0, 8, 64) == 0);
+    TEST_CHECK(hash_slot_offset(13, 8, 64) == (5 * 64));
+    TEST_CHECK(hash_slot_offset(0xFFFFFFFFFFFFFFFFULL, 1024, 32) == (1023 * 32));
+}
+
+static void bench_fnv1a32 (void) {
+    static uint8_t buffer[4096];
+    volatile uint32_t hash;
+
+    memset(buffer, 0x5A, sizeof(buffer));
+
+    BENCH("fnv1a32 4 KiB", 2000, hash = fnv1a32(FNV1A32_INIT, buffer, sizeof(buffer)));
+    (void) (hash);
+}
+
+TEST_LIST = {
+    { "hash/fnv1a32", test_fnv1a32 },
+    { "hash/fnv1a64", test_fnv1a64 },
+    { "hash/chained", test_chained },
+    { "hash/slot_offset", test_slot_offset },
+    { "bench/fnv1a32", bench_fnv1a32 },
+    { NULL, NULL }
+};
@@ -0,0 +1,73 @@
+#include <string.h>
+
+#include "acutest/acutest.h"
+#include "bench.h"
+#include "utils/lz4.h"
+
+// NOTE: "abcd", a match of 8 bytes at offset 4, then the final literals "efgh!"
+static const uint8_t block[] = {
+    0x44, 'a', 'b', 'c', 'd', 0x04, 0x00,
+    0x50, 'e', 'f', 'g', 'h', '!',
+};
+
+static const char expected[] = "abcdabcdabcdefgh!";
+
+static void test_decompress (void) {
+    uint8_t output[64];
+
+    int length = lz4_decompress_block(block, sizeof(block), output, sizeof(output));
+    TEST_CHECK(length == (int) (strlen(expected)));
+    TEST_CHECK(memcmp(output, expected, strlen(expected)) == 0);
+}
+
+static void test_output_too_small (void) {
+    uint8_t output[16];
+
+    TEST_CHECK(lz4_decompress_block(block, sizeof(block), output, sizeof(output)) == -1);
+}
+
+static void test_damaged (void) {
+    uint8_t output[64];
+    uint8_t damaged[sizeof(block)];
+
+    // NOTE: An offset pointing before the output start
+    memcpy(damaged, block, sizeof(block));
+    damaged[5] = 0x10;
+    TEST_CHECK(lz4_decompress_block(damaged, sizeof(damaged), output, sizeof(output)) == -1);
+
+    // NOTE: Truncated inside the match offset
+    TEST_CHECK(lz4_decompress_block(block, 6, output, sizeof(output)) == -1);
+
+    // NOTE: A literal run longer than the input
+    memcpy(damaged, block, sizeof(block));
+    damaged[7] = 0xF0;
+    TEST_CHECK(lz4_decompress_block(damaged, sizeof(damaged), output, sizeof(output)) == -1);
+}
+
+static void bench_decompress (void) {
+    static uint8_t input[512];
+    static uint8_t output[64 * 1024];
+
+    // NOTE: One literal run and a long overlapping match, the worst case of the byte copy loop
+    size_t i = 0;
+    input[i++] = 0x4F;
+    memcpy(&input[i], "abcd", 4); i += 4;
+    input[i++] = 0x01;
+    input[i++] = 0x00;
+    size_t match = sizeof(output) - 4 - 15 - 4;
+    while (match >= 255) { input[i++] = 255; match -= 255; }
+    input[i++] = (uint8_t) (match);
+
+    int length = lz4_decompress_block(input, i, output, sizeof(output));
+    TEST_ASSERT(length == (int) (sizeof(output)));
+
+    BENCH("lz4 64 KiB overlapping match", 2000, lz4_decompress_block(input, i, output, sizeof(output)));
+}
+
+TEST_LIST = {
+    { "lz4/decompress", test_decompress },
+    { "lz4/output_too_small", test_output_too_small },
+    { "lz4/damaged", test_damaged },
+    { "bench/lz4_decompress", bench_decompress },
+    { NULL, NULL }
+};
@@ -0,0 +1,132 @@
+#include <string.h>
+
+#include "acutest/acutest.h"
+#include "bench.h"
+#include "menu/path.h"
+
+static void test_init (void) {
+    path_t *path = path_init("sd:/", "menu/roms");
+    TEST_CHECK(strcmp(path_get(path), "sd:/menu/roms") == 0);
+    TEST_CHECK(!path_is_root(path));
+    path_free(path);
+
+    path = path_init("sd:", "");
+    TEST_CHECK(strcmp(path_get(path), "sd:/") == 0);
+    TEST_CHECK(path_is_root(path));
+    path_free(path);
+}
+
+static void test_push_pop (void) {
+    path_t *path = path_init("sd:/", "");
+
+    path_push(path, "/roms");
+    path_push(path, "game.z64");
+    TEST_CHECK(strcmp(path_get(path), "sd:/roms/game.z64") == 0);
+    TEST_CHECK(strcmp(path_last_get(path), "game.z64") == 0);
+
+    path_pop(path);
+    TEST_CHECK(strcmp(path_get(path), "sd:/roms") == 0);
+    path_pop(path);
+    TEST_CHECK(strcmp(path_get(path), "sd:/") == 0);
+    path_pop(path);
+    TEST_CHECK(strcmp(path_get(path), "sd:/") == 0);
+
+    path_free(path);
+}
+
+static void test_push_subdir (void) {
+    path_t *path = path_init("sd:/", "roms/game.z64");
+    path_push_subdir(path, "saves");
+    TEST_CHECK(strcmp(path_get(path), "sd:/roms/saves/game.z64") == 0);
+    path_free(path);
+}
+
+static void test_extension (void) {
+    path_t *path = path_init("sd:/", "dir.v2/game.z64");
+    TEST_CHECK(strcmp(path_ext_get(path), "z64") == 0);
+
+    path_ext_replace(path, "sav");
+    TEST_CHECK(strcmp(path_get(path), "sd:/dir.v2/game.sav") == 0);
+
+    path_ext_remove(path);
+    TEST_CHECK(path_ext_get(path) == NULL);
+    TEST_CHECK(strcmp(path_get(path), "sd:/dir.v2/game") == 0);
+
+    path_free(path);
+}
+
+static void test_clone_match (void) {
+    path_t *path = path_init("sd:/", "roms");
+    path_t *cloned = path_clone_push(path, "game.z64");
+    TEST_CHECK(strcmp(path_get(cloned), "sd:/roms/game.z64") == 0);
+    TEST_CHECK(!path_are_match(path, cloned));
+
+    path_pop(cloned);
+    TEST_CHECK(path_are_match(path, cloned));
+
+    // NOTE: The root must follow the buffer when the clone grows
+    for (int i = 0; i < 64; i++) {
+        path_push(cloned, "long_directory_name");
+    }
+    path_pop(cloned);
+    TEST_CHECK(!path_is_root(cloned));
+
+    path_free(cloned);
+    path_free(path);
+}
+
+static void test_scratch (void) {
+    path_scratch_begin();
+
+    path_t *path = path_init("sd:/", "roms");
+    TEST_CHECK(path->scratch);
+    TEST_CHECK(path->scratch_buffer);
+
+    // NOTE: Growing past the arena moves the buffer to the heap, the contents must survive
+    for (int i = 0; i < 1024; i++) {
+        path_push(path, "long_directory_name");
+    }
+    TEST_CHECK(strncmp(path_get(path), "sd:/roms/long_directory_name/", 29) == 0);
+
+    path_scratch_begin();
+    path_t *inner = path_clone(path);
+    path_free(inner);
+    path_scratch_end();
+
+    path_free(path);
+    path_scratch_end();
+
+    path = path_init("sd:/", "roms");
+    TEST_CHECK(!path->scratch);
+    path_free(path);
+}
+
+static void bench_push_pop (void) {
+    path_t *path = path_init("sd:/", "roms");
+    BENCH("path push/pop", 1000000, { path_push(path, "game.z64"); path_pop(path); });
+    path_free(path);
+}
+
+static void bench_init_free (void) {
+    BENCH("path init/free (heap)", 1000000, { path_free(path_init("sd:/", "roms/game.z64")); });
+
+    path_scratch_begin();
+    BENCH("path init/free (scratch)", 1000000, {
+        path_scratch_begin();
+        path_free(path_init("sd:/", "roms/game.z64"));
+        path_scratch_end();
+    });
+    path_scratch_end();
+}
+
+TEST_LIST = {
+    { "path/init", test_init },
+    { "path/push_pop", test_push_pop },
+    { "path/push_subdir", test_push_subdir },
+    { "path/extension", test_extension },
+    { "path/clone_match", test_clone_match },
+    { "path/scratch", test_scratch },
+    { "bench/path_push_pop", bench_push_pop },
+    { "bench/path_init_free", bench_init_free },
+    { NULL, NULL }
+};
@@ -0,0 +1,294 @@
+#include <string.h>
+
+#include "acutest/acutest.h"
+#include "bench.h"
+#include "menu/rom_patch.h"
+
+#define ROM_SPACE   (64 * 1024)
+
+typedef struct {
+    uint8_t rom[ROM_SPACE];
+    uint8_t patch[32 * 1024];
+    size_t patch_length;
+    int writes;
+} memory_t;
+
+static memory_t memory;
+
+static bool patch_read (void *arg, uint32_t offset, void *buffer, size_t length) {
+    memory_t *m = arg;
+    memcpy(buffer, &m->patch[offset], length);
+    return false;
+}
+
+static bool rom_read (void *arg, uint32_t offset, void *buffer, size_t length) {
+    memory_t *m = arg;
+    memcpy(buffer, &m->rom[offset], length);
+    return false;
+}
+
+static bool rom_write (void *arg, uint32_t offset, const void *buffer, size_t length) {
+    memory_t *m = arg;
+    memcpy(&m->rom[offset], buffer, length);
+    m->writes += 1;
+    return false;
+}
+
+static uint32_t crc32 (const uint8_t *data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    while (length--) {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+static void put (const void *data, size_t length) {
+    memcpy(&memory.patch[memory.patch_length], data, length);
+    memory.patch_length += length;
+}
+
+static void put_byte (uint8_t value) {
+    put(&value, 1);
+}
+
+static void put_number (uint64_t value) {
+    while (true) {
+        uint8_t byte = (value & 0x7F);
+        value >>= 7;
+        if (value == 0) {
+            put_byte(0x80 | byte);
+            break;
+        }
+        put_byte(byte);
+        value -= 1;
+    }
+}
+
+static void put_le32 (uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        put_byte(value >> (i * 8));
+    }
+}
+
+static void put_checksums (void) {
+    put_le32(0);
+    put_le32(0);
+    put_le32(crc32(memory.patch, memory.patch_length));
+}
+
+static void memory_init (uint32_t rom_size) {
+    memset(&memory, 0, sizeof(memory));
+    for (uint32_t i = 0; i < ROM_SPACE; i++) {
+        memory.rom[i] = (i < rom_size) ? (uint8_t) (i * 7) : 0xEE;
+    }
+}
+
+static rom_patch_err_t apply (uint32_t rom_size, uint32_t *patched_size) {
+    rom_patch_io_t io = {
+        .patch_read = patch_read,
+        .rom_read = rom_read,
+        .rom_write = rom_write,
+        .arg = &memory,
+        .patch_size = memory.patch_length,
+        .rom_size = rom_size,
+        .rom_space = ROM_SPACE,
+    };
+    return rom_patch_apply(&io, patched_size);
+}
+
+static void test_type (void) {
+    TEST_CHECK(rom_patch_get_type((const uint8_t *) "PATCH", 5) == ROM_PATCH_TYPE_IPS);
+    TEST_CHECK(rom_patch_get_type((const uint8_t *) "UPS1x", 5) == ROM_PATCH_TYPE_UPS);
+    TEST_CHECK(rom_patch_get_type((const uint8_t *) "BPS1x", 5) == ROM_PATCH_TYPE_BPS);
+    TEST_CHECK(rom_patch_get_type((const uint8_t *) "PATC", 4) == ROM_PATCH_TYPE_UNKNOWN);
+}
+
+static void test_ips (void) {
+    uint32_t size;
+
+    memory_init(1024);
+    put("PATCH", 5);
+    put("\x00\x00\x11\x00\x03" "ABC", 8);
+    put("\x00\x02\x00\x00\x00\x00\x10\x5A", 8);
+    put("\x00\x08\x00\x00\x02" "XY", 7);
+    put("EOF", 3);
+
+    TEST_CHECK(apply(1024, &size) == ROM_PATCH_OK);
+    TEST_CHECK(memcmp(&memory.rom[0x11], "ABC", 3) == 0);
+    TEST_CHECK(memory.rom[0x200] == 0x5A && memory.rom[0x20F] == 0x5A && memory.rom[0x210] == (uint8_t) (0x210 * 7));
+    TEST_CHECK(memory.rom[0x3FF] == (uint8_t) (0x3FF * 7));
+    TEST_CHECK(memory.rom[0x400] == 0x00 && memory.rom[0x7FF] == 0x00);
+    TEST_CHECK(memcmp(&memory.rom[0x800], "XY", 2) == 0);
+    TEST_CHECK(size == 0x802);
+
+    memory_init(1024);
+    put("PATCH", 5);
+    put("\x00\x00\x00\x00\x01" "Z", 6);
+    put("EOF", 3);
+    put("\x00\x01\x00", 3);
+    TEST_CHECK(apply(1024, &size) == ROM_PATCH_OK);
+    TEST_CHECK(memory.rom[0] == 'Z');
+    TEST_CHECK(size == 0x100);
+}
+
+static void test_ips_damaged (void) {
+    memory_init(1024);
+    put("PATCH", 5);
+    put("\x00\x00\x10\x00\x04" "ABCD", 9);
+    put("\x00\x00\x20\x00\x10" "AB", 7);
+
+    TEST_CHECK(apply(1024, NULL) == ROM_PATCH_ERR_FORMAT);
+    TEST_MSG("the ROM must be left untouched");
+    TEST_CHECK(memory.writes == 0);
+}
+
+static void test_ups (void) {
+    uint32_t size;
+
+    memory_init(256);
+    put("UPS1", 4);
+    put_number(256);
+    put_number(300);
+    put_number(4);
+    put("\x01\x02", 2);
+    put_byte(0);
+    put_number(291);
+    put("\x33\x44", 2);
+    put_byte(0);
+    put_checksums();
+
+    TEST_CHECK(apply(256, &size) == ROM_PATCH_OK);
+    TEST_CHECK(size == 300);
+    TEST_CHECK(memory.rom[4] == (uint8_t) ((4 * 7) ^ 0x01));
+    TEST_CHECK(memory.rom[5] == (uint8_t) ((5 * 7) ^ 0x02));
+    TEST_CHECK(memory.rom[6] == (uint8_t) (6 * 7));
+    TEST_CHECK(memory.rom[298] == 0x33 && memory.rom[299] == 0x44);
+    TEST_CHECK(memory.rom[256] == 0x00 && memory.rom[297] == 0x00);
+
+    memory.writes = 0;
+    TEST_CHECK(apply(128, NULL) == ROM_PATCH_ERR_SOURCE_MISMATCH);
+    TEST_CHECK(memory.writes == 0);
+}
+
+static void test_ups_checksum (void) {
+    memory_init(256);
+    put("UPS1", 4);
+    put_number(256);
+    put_number(256);
+    put_number(0);
+    put("\x01", 1);
+    put_byte(0);
+    put_checksums();
+    memory.patch[memory.patch_length - 1] ^= 0xFF;
+
+    TEST_CHECK(apply(256, NULL) == ROM_PATCH_ERR_CHECKSUM);
+    TEST_CHECK(memory.writes == 0);
+}
+
+static void test_bps (void) {
+    uint32_t size;
+
+    memory_init(64);
+    put("BPS1", 4);
+    put_number(64);
+    put_number(64);
+    put_number(3);
+    put("abc", 3);
+    put_number(((16 - 1) << 2) | 0);
+    put_number(((4 - 1) << 2) | 1);
+    put("WXYZ", 4);
+    put_number(((8 - 1) << 2) | 2);
+    put_number((40 - 0) << 1);
+    put_number(((12 - 1) << 2) | 3);
+    put_number((16 - 0) << 1);
+    put_number(((24 - 1) << 2) | 0);
+    put_checksums();
+
+    TEST_CHECK(apply(64, &size) == ROM_PATCH_OK);
+    TEST_CHECK(size == 64);
+    for (int i = 0; i < 16; i++) {
+        TEST_CHECK(memory.rom[i] == (uint8_t) (i * 7));
+    }
+    TEST_CHECK(memcmp(&memory.rom[16], "WXYZ", 4) == 0);
+    for (int i = 0; i < 8; i++) {
+        TEST_CHECK(memory.rom[20 + i] == (uint8_t) ((40 + i) * 7));
+    }
+    for (int i = 0; i < 12; i++) {
+        TEST_CHECK(memory.rom[28 + i] == memory.rom[16 + (i % 12)]);
+    }
+    for (int i = 40; i < 64; i++) {
+        TEST_CHECK(memory.rom[i] == (uint8_t) (i * 7));
+    }
+}
+
+static void test_bps_overlapping_copy (void) {
+    memory_init(64);
+    put("BPS1", 4);
+    put_number(64);
+    put_number(64);
+    put_number(0);
+    put_number(((32 - 1) << 2) | 2);
+    put_number(32 << 1);
+    put_number(((32 - 1) << 2) | 2);
+    put_number((64 << 1) | 1);
+    put_checksums();
+
+    TEST_CHECK(apply(64, NULL) == ROM_PATCH_OK);
+    TEST_MSG("the second half must be copied from the original source");
+    for (int i = 0; i < 32; i++) {
+        TEST_CHECK(memory.rom[i] == (uint8_t) ((i + 32) * 7));
+        TEST_CHECK(memory.rom[i + 32] == (uint8_t) (i * 7));
+    }
+}
+
+static void test_bps_target_copy_run (void) {
+    memory_init(16);
+    put("BPS1", 4);
+    put_number(16);
+    put_number(20);
+    put_number(0);
+    put_number(((2 - 1) << 2) | 1);
+    put("ab", 2);
+    put_number(((18 - 1) << 2) | 3);
+    put_number(0 << 1);
+    put_checksums();
+
+    TEST_CHECK(apply(16, NULL) == ROM_PATCH_OK);
+    for (int i = 0; i < 20; i++) {
+        TEST_CHECK(memory.rom[i] == ((i & 1) ? 'b' : 'a'));
+    }
+}
+
+static void bench_bps (void) {
+    memory_init(ROM_SPACE / 2);
+    put("BPS1", 4);
+    put_number(ROM_SPACE / 2);
+    put_number(ROM_SPACE / 2);
+    put_number(0);
+    for (int i = 0; i < 256; i++) {
+        put_number(((64 - 1) << 2) | 1);
+        for (int j = 0; j < 64; j++) {
+            put_byte(i + j);
+        }
+    }
+    put_number((((ROM_SPACE / 2) - (256 * 64) - 1) << 2) | 0);
+    put_checksums();
+
+    BENCH("BPS apply (16 KiB patch)", 1000, { apply(ROM_SPACE / 2, NULL); });
+}
+
+TEST_LIST = {
+    { "rom_patch/type", test_type },
+    { "rom_patch/ips", test_ips },
+    { "rom_patch/ips_damaged", test_ips_damaged },
+    { "rom_patch/ups", test_ups },
+    { "rom_patch/ups_checksum", test_ups_checksum },
+    { "rom_patch/bps", test_bps },
+    { "rom_patch/bps_overlapping_copy", test_bps_overlapping_copy },
+    { "rom_patch/bps_target_copy_run", test_bps_target_copy_run },
+    { "bench/rom_patch_bps", bench_bps },
+    { NULL, NULL }
+};
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Builds a chunked compressed ROM file (.z64c) loaded by the menu.
+
+The ROM is converted to the native byte order and split into fixed size chunks,
+each chunk is compressed into a raw LZ4 block and stored as is when it doesn't compress.
+
+Layout, all values big endian:
+
+    header:  magic "NCR1", ROM size, chunk size, chunk count (4 x uint32)
+    index:   file offset, length (2 x uint32) per chunk, bit 31 of the length marks a stored chunk
+    chunks:  chunk data, every chunk starts at a 512 byte boundary
+
+Uses the lz4 module when it's installed, a slower built-in compressor otherwise.
+
+Usage: build_compressed_rom.py <input.z64|.v64|.n64> <output.z64c>
+"""
+
+import struct
+import sys
+
+MAGIC = 0x4E435231  # "NCR1"
+
+# Must match src/menu/compressed_rom.c
+CHUNK_SIZE = 64 * 1024
+CHUNK_ALIGNMENT = 512
+CHUNK_STORED = 0x80000000
+
+MIN_MATCH = 4
+MAX_OFFSET = 65535
+LAST_LITERALS = 5
+MATCH_SEARCH_LIMIT = 12
+
+
+def to_native_byte_order(data):
+    if len(data) % 4 != 0:
+        data += bytes(4 - (len(data) % 4))
+    first = data[0:4]
+    if first == b'\x37\x80\x40\x12':
+        swapped = bytearray(data)
+        swapped[0::2], swapped[1::2] = data[1::2], data[0::2]
+        return bytes(swapped)
+    if first == b'\x40\x12\x37\x80':
+        swapped = bytearray(data)
+        swapped[0::4], swapped[1::4], swapped[2::4], swapped[3::4] = data[3::4], data[2::4], data[1::4], data[0::4]
+        return bytes(swapped)
+    return data
+
+
+def write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def write_sequence(out, literals, offset, match_length):
+    literal_length = len(literals)
+    token = min(literal_length, 15) << 4
+    if offset:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if literal_length >= 15:
+        write_length(out, literal_length - 15)
+    out += literals
+    if offset:
+        out += struct.pack('<H', offset)
+        if (match_length - MIN_MATCH) >= 15:
+            write_length(out, match_length - MIN_MATCH - 15)
+
+
+def compress_builtin(data):
+    out = bytearray()
+    table = {}
+    anchor = 0
+    position = 0
+    misses = 0
+    limit = len(data) - MATCH_SEARCH_LIMIT
+
+    while position < limit:
+        key = data[position:position + MIN_MATCH]
+        candidate = table.get(key, -1)
+        table[key] = position
+        if (candidate < 0) or ((position - candidate) > MAX_OFFSET):
+            misses += 1
+            position += 1 + (misses >> 6)
+            continue
+        misses = 0
+        length = MIN_MATCH
+        max_length = len(data) - LAST_LITERALS - position
+        while (length < max_length) and (data[candidate + length] == data[position + length]):
+            length += 1
+        write_sequence(out, data[anchor:position], position - candidate, length)
+        position += length
+        anchor = position
+
+    write_sequence(out, data[anchor:], 0, 0)
+
+    return bytes(out)
+
+
+try:
+    import lz4.block
+
+    def compress(data):
+        return lz4.block.compress(data, mode='high_compression', store_size=False)
+except ImportError:
+    compress = compress_builtin
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(f'Usage: {sys.argv[0]} <input.z64|.v64|.n64> <output.z64c>')
+
+    with open(sys.argv[1], 'rb') as f:
+        rom = to_native_byte_order(f.read())
+
+    chunks = [rom[offset:offset + CHUNK_SIZE] for offset in range(0, len(rom), CHUNK_SIZE)]
+
+    header_size = 16 + (len(chunks) * 8)
+    offset = (header_size + CHUNK_ALIGNMENT - 1) // CHUNK_ALIGNMENT * CHUNK_ALIGNMENT
+
+    index = b''
+    data = bytearray(offset - header_size)
+    stored = 0
+
+    for chunk in chunks:
+        packed = compress(chunk)
+        if len(packed) >= len(chunk):
+            packed = chunk
+            length = len(chunk) | CHUNK_STORED
+            stored += 1
+        else:
+            length = len(packed)
+        index += struct.pack('>II', offset, length)
+        padding = (-len(packed)) % CHUNK_ALIGNMENT
+        data += packed + bytes(padding)
+        offset += len(packed) + padding
+
+    header = struct.pack('>IIII', MAGIC, len(rom), CHUNK_SIZE, len(chunks))
+
+    with open(sys.argv[2], 'wb') as f:
+        f.write(header + index + data)
+
+    total = header_size + len(data)
+    print(f'Wrote {len(chunks)} chunks ({stored} stored) to {sys.argv[2]}, {total} of {len(rom)} bytes ({(100 * total) // max(len(rom), 1)}%)')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Builds the external ROM database file (rom_database.db) loaded by the menu.
+
+The input uses the same entry macros as the built-in database in src/menu/rom_info.c:
+
+    MATCH_ID("NXG", SAVE_TYPE_NONE, FEAT_CPAK),
+    MATCH_ID_REGION("NK4J", SAVE_TYPE_SRAM_256KBIT, FEAT_RPAK),
+    MATCH_ID_REGION_VERSION("NK4J", 1, SAVE_TYPE_SRAM_256KBIT, FEAT_RPAK),
+    MATCH_CHECK_CODE(0x000000004CBC3B56, SAVE_TYPE_SRAM_256KBIT, FEAT_EXP_PAK_REQUIRED),
+    MATCH_HOMEBREW_HEADER("ED"),
+
+Entries listed first take precedence, same as in the built-in database.
+Save type and feature values are read from the menu sources, so they always match the menu build.
+
+Usage: build_rom_database.py <input.txt> <output.db>
+"""
+
+import os
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = 0x4E444231  # "NDB1"
+
+# Must match match_type_t in src/menu/rom_info.c
+MATCH_TYPE_ID = 0
+MATCH_TYPE_ID_REGION = 1
+MATCH_TYPE_ID_REGION_VERSION = 2
+MATCH_TYPE_CHECK_CODE = 3
+MATCH_TYPE_HOMEBREW_HEADER = 4
+
+SOURCE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'src', 'menu')
+
+
+def load_constants():
+    constants = {}
+    with open(os.path.join(SOURCE_DIR, 'rom_info.h')) as f:
+        for name, value in re.findall(r'\b(SAVE_TYPE_\w+)\s*=\s*(-?\d+)', f.read()):
+            constants[name] = int(value)
+    with open(os.path.join(SOURCE_DIR, 'rom_info.c')) as f:
+        for name, value in re.findall(r'\b(FEAT_\w+)\s*=\s*\(1 << (\d+)\)', f.read()):
+            constants[name] = 1 << int(value)
+    constants['FEAT_NONE'] = 0
+    return constants
+
+
+def evaluate_flags(expression, constants):
+    value = 0
+    for flag in expression.split('|'):
+        flag = flag.strip()
+        if flag not in constants:
+            raise ValueError(f'Unknown value "{flag}"')
+        value |= constants[flag]
+    return value
+
+
+def make_id_key(id, length, version=0):
+    if len(id) < length:
+        raise ValueError(f'ID "{id}" is shorter than {length} characters')
+    key = 0
+    for c in id[:length].encode('ascii'):
+        key = (key << 8) | c
+    return (key << 8) | version
+
+
+ENTRY_PATTERNS = [
+    (re.compile(r'MATCH_ID_REGION_VERSION\(\s*"([^"]+)"\s*,\s*(\d+)\s*,\s*(\w+)\s*,\s*([\w\s|]+)\)'), MATCH_TYPE_ID_REGION_VERSION),
+    (re.compile(r'MATCH_ID_REGION\(\s*"([^"]+)"\s*,\s*(\w+)\s*,\s*([\w\s|]+)\)'), MATCH_TYPE_ID_REGION),
+    (re.compile(r'MATCH_ID\(\s*"([^"]+)"\s*,\s*(\w+)\s*,\s*([\w\s|]+)\)'), MATCH_TYPE_ID),
+    (re.compile(r'MATCH_CHECK_CODE\(\s*(0x[0-9A-Fa-f]+)\s*,\s*(\w+)\s*,\s*([\w\s|]+)\)'), MATCH_TYPE_CHECK_CODE),
+    (re.compile(r'MATCH_HOMEBREW_HEADER\(\s*"([^"]+)"\s*\)'), MATCH_TYPE_HOMEBREW_HEADER),
+]
+
+
+def parse_entries(path, constants):
+    entries = []
+    with open(path) as f:
+        for line_number, line in enumerate(f, 1):
+            line = line.split('//')[0].strip()
+            if not line:
+                continue
+            for pattern, match_type in ENTRY_PATTERNS:
+                match = pattern.search(line)
+                if not match:
+                    continue
+                groups = match.groups()
+                try:
+                    if match_type == MATCH_TYPE_ID_REGION_VERSION:
+                        key = make_id_key(groups[0], 4, int(groups[1]))
+                        save, feat = constants[groups[2]], evaluate_flags(groups[3], constants)
+                    elif match_type == MATCH_TYPE_ID_REGION:
+                        key = make_id_key(groups[0], 4)
+                        save, feat = constants[groups[1]], evaluate_flags(groups[2], constants)
+                    elif match_type == MATCH_TYPE_ID:
+                        key = make_id_key(groups[0], 3)
+                        save, feat = constants[groups[1]], evaluate_flags(groups[2], constants)
+                    elif match_type == MATCH_TYPE_CHECK_CODE:
+                        key = int(groups[0], 16)
+                        save, feat = constants[groups[1]], evaluate_flags(groups[2], constants)
+                    else:
+                        key = make_id_key(groups[0], 2)
+                        save, feat = constants['SAVE_TYPE_NONE'], 0
+                except (KeyError, ValueError) as e:
+                    raise SystemExit(f'{path}:{line_number}: {e}')
+                entries.append((match_type, key, len(entries), save, feat))
+                break
+            else:
+                raise SystemExit(f'{path}:{line_number}: Unrecognized entry "{line}"')
+    return entries
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(f'Usage: {sys.argv[0]} <input.txt> <output.db>')
+
+    entries = sorted(parse_entries(sys.argv[1], load_constants()))
+
+    index = b''.join(struct.pack('>IIQ', match_type, order, key) for (match_type, key, order, _, _) in entries)
+    records = b''.join(struct.pack('>iI', save, feat) for (_, _, _, save, feat) in entries)
+    header = struct.pack('>IIII', MAGIC, len(entries), zlib.crc32(index + records), 0)
+
+    with open(sys.argv[2], 'wb') as f:
+        f.write(header + index + records)
+
+    print(f'Wrote {len(entries)} entries to {sys.argv[2]}')
+
+
+if __name__ == '__main__':
+    main()
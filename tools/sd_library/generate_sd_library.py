@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+Generates a synthetic SD card library, for reproducing the slowdowns of big libraries.
+
+The tree contains ROM stubs with valid headers spread over nested directories,
+zip archives of ROMs, metadata images in the menu/metadata/<c>/<c>/<c>/<c> layout,
+and cheat and ini sidecars next to some of the ROMs.
+
+A scenario is written to menu/benchmark/scenario.txt, the benchmark view runs it
+instead of the default suite. It lists the directory loads, searches and boxart
+decodes to time. The same seed always generates the same tree and scenario, so
+the timings are comparable between runs, cards and menu builds.
+
+Scenario format, one benchmark per line, paths relative to the SD card root:
+
+    <benchmark name> <argument>
+
+Usage: generate_sd_library.py [--seed N] [--roms N] [--rom-size KiB] <output directory>
+"""
+
+import argparse
+import os
+import random
+import struct
+import zipfile
+import zlib
+
+ROM_MAGIC = 0x80371240
+ROM_CLOCK_RATE = 0x0000000F
+ROM_BOOT_ADDRESS = 0x80000400
+ROM_EXTENSIONS = ['z64', 'n64', 'v64']
+REGIONS = 'EJPDFIS'
+
+# Must match src/menu/metadata.c
+METADATA_DIRECTORY = 'menu/metadata'
+BOXART_SIZE = (158, 112)
+
+SCENARIO_FILE = 'menu/benchmark/scenario.txt'
+
+WORDS = [
+    'Super', 'Mega', 'Star', 'Racer', 'Quest', 'Legend', 'World', 'Kart', 'Golf', 'Tennis',
+    'Hero', 'Dragon', 'Castle', 'Island', 'Space', 'Ninja', 'Robot', 'Party', 'Soccer', 'Blast',
+]
+
+
+def make_rom(rng, title, game_code, size):
+    header = struct.pack('>IIII', ROM_MAGIC, ROM_CLOCK_RATE, ROM_BOOT_ADDRESS, 0x00001449)
+    header += struct.pack('>II', rng.getrandbits(32), rng.getrandbits(32))
+    header += bytes(8)
+    header += title.encode('ascii')[:20].ljust(20, b' ')
+    header += bytes(7)
+    header += game_code.encode('ascii')
+    header += bytes([0])
+    rom = bytearray(size)
+    rom[0:len(header)] = header
+    # NOTE: A fixed pattern keeps the generated files compressible inside the archives
+    for offset in range(0x1000, size, 0x1000):
+        rom[offset:offset + 4] = struct.pack('>I', offset)
+    return bytes(rom)
+
+
+def byte_swap(data, extension):
+    if extension == 'v64':
+        swapped = bytearray(data)
+        swapped[0::2], swapped[1::2] = data[1::2], data[0::2]
+        return bytes(swapped)
+    if extension == 'n64':
+        swapped = bytearray(data)
+        swapped[0::4], swapped[1::4], swapped[2::4], swapped[3::4] = data[3::4], data[2::4], data[1::4], data[0::4]
+        return bytes(swapped)
+    return data
+
+
+def make_png(width, height, color):
+    def chunk(kind, data):
+        return struct.pack('>I', len(data)) + kind + data + struct.pack('>I', zlib.crc32(kind + data) & 0xFFFFFFFF)
+
+    row = b'\x00' + bytes(color) * width
+    pixels = zlib.compress(row * height, 9)
+    return (
+        b'\x89PNG\r\n\x1a\n' +
+        chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 2, 0, 0, 0)) +
+        chunk(b'IDAT', pixels) +
+        chunk(b'IEND', b'')
+    )
+
+
+def make_cheats(rng):
+    lines = ['# Synthetic cheat file']
+    for i in range(rng.randint(2, 12)):
+        lines.append('{:08X} {:04X} Code {}'.format(0x80000000 | (rng.getrandbits(22) << 2), rng.getrandbits(16), i))
+    return '\n'.join(lines) + '\n'
+
+
+def make_rom_ini(rng):
+    return (
+        'cheats_enabled = {}\n'
+        '\n'
+        '[custom_boot]\n'
+        'save_type = {}\n'
+    ).format('true' if rng.random() < 0.5 else 'false', rng.randint(0, 6))
+
+
+def write_file(path, data):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'wb') as f:
+        f.write(data)
+
+
+def generate(output, seed, roms, rom_size):
+    rng = random.Random(seed)
+
+    library = []
+    game_codes = set()
+
+    while len(library) < roms:
+        game_code = 'N' + ''.join(rng.choice('ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789') for _ in range(2)) + rng.choice(REGIONS)
+        if game_code in game_codes:
+            continue
+        game_codes.add(game_code)
+        title = ' '.join(rng.sample(WORDS, rng.randint(1, 3)))
+        library.append((title, game_code))
+
+    directories = []
+
+    for index, (title, game_code) in enumerate(library):
+        # NOTE: A flat directory with a quarter of the library, the rest nested up to three levels
+        if index % 4 == 0:
+            directory = 'roms/all'
+        else:
+            letter = title[0].upper()
+            directory = 'roms/{}/{}'.format(letter, game_code[1]) if (index % 3) else 'roms/{}'.format(letter)
+        if directory not in directories:
+            directories.append(directory)
+
+        extension = ROM_EXTENSIONS[index % len(ROM_EXTENSIONS)]
+        name = '{} ({:04d})'.format(title, index)
+        rom_path = os.path.join(output, directory, '{}.{}'.format(name, extension))
+
+        rom = make_rom(rng, title, game_code, rom_size)
+        write_file(rom_path, byte_swap(rom, extension))
+
+        if rng.random() < 0.2:
+            write_file(os.path.join(output, directory, name + '.datel.txt'), make_cheats(rng).encode('ascii'))
+        if rng.random() < 0.2:
+            write_file(os.path.join(output, directory, name + '.ini'), make_rom_ini(rng).encode('ascii'))
+
+        if rng.random() < 0.6:
+            metadata = os.path.join(output, METADATA_DIRECTORY, *game_code)
+            color = (rng.randrange(256), rng.randrange(256), rng.randrange(256))
+            write_file(os.path.join(metadata, 'boxart_front.png'), make_png(BOXART_SIZE[0], BOXART_SIZE[1], color))
+
+    archives = []
+    for index in range(max(1, roms // 200)):
+        archive = 'roms/archives/collection_{:02d}.zip'.format(index)
+        os.makedirs(os.path.join(output, os.path.dirname(archive)), exist_ok=True)
+        with zipfile.ZipFile(os.path.join(output, archive), 'w', zipfile.ZIP_DEFLATED) as z:
+            for title, game_code in rng.sample(library, min(20, len(library))):
+                z.writestr('{} [{}].z64'.format(title, game_code), make_rom(rng, title, game_code, rom_size))
+        archives.append(archive)
+
+    scenario = ['# Generated with seed {} and {} ROMs'.format(seed, roms)]
+
+    for directory in ['roms/all'] + rng.sample(directories, min(5, len(directories))):
+        scenario.append('dir-enum /{}'.format(directory))
+
+    for title, _ in rng.sample(library, min(4, len(library))):
+        scenario.append('search {}'.format(title.split(' ')[0]))
+
+    boxart = [game_code for _, game_code in library if os.path.exists(os.path.join(output, METADATA_DIRECTORY, *game_code))]
+    for game_code in rng.sample(boxart, min(4, len(boxart))):
+        scenario.append('png-decode /{}/{}/boxart_front.png'.format(METADATA_DIRECTORY, '/'.join(game_code)))
+
+    for archive in archives[:1]:
+        scenario.append('sd-read /{}'.format(archive))
+
+    write_file(os.path.join(output, SCENARIO_FILE), ('\n'.join(scenario) + '\n').encode('ascii'))
+
+    print('Generated {} ROMs in {} directories, {} archives, {} boxart images'.format(len(library), len(directories), len(archives), len(boxart)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a synthetic SD card library and benchmark scenario.')
+    parser.add_argument('output', help='output directory, the SD card root')
+    parser.add_argument('--seed', type=int, default=64, help='random seed (default: 64)')
+    parser.add_argument('--roms', type=int, default=2000, help='number of ROMs (default: 2000)')
+    parser.add_argument('--rom-size', type=int, default=16, help='ROM stub size in KiB (default: 16)')
+    args = parser.parse_args()
+
+    generate(args.output, args.seed, args.roms, args.rom_size * 1024)
+
+
+if __name__ == '__main__':
+    main()